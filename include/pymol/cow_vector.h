@@ -0,0 +1,89 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace pymol
+{
+
+/**
+ * Copy-on-write vector. Copies share the elements until one of them gets
+ * modified through `mut()` (or resize/clear/assign).
+ *
+ * Element access is read-only, writing requires an explicit `mut()`, which
+ * detaches a shared buffer. Keep the returned reference only as long as no
+ * other copy is made.
+ */
+template <typename T> class cow_vector
+{
+  std::shared_ptr<std::vector<T>> m_data;
+
+  static const std::vector<T>& empty_vector()
+  {
+    static const std::vector<T> empty;
+    return empty;
+  }
+
+public:
+  using value_type = T;
+  using const_iterator = typename std::vector<T>::const_iterator;
+
+  cow_vector() = default;
+  cow_vector(std::vector<T> vec)
+      : m_data(std::make_shared<std::vector<T>>(std::move(vec)))
+  {
+  }
+
+  /// Read-only view
+  const std::vector<T>& get() const { return m_data ? *m_data : empty_vector(); }
+
+  /// Writable vector, detaches from other copies
+  std::vector<T>& mut()
+  {
+    if (!m_data) {
+      m_data = std::make_shared<std::vector<T>>();
+    } else if (m_data.use_count() > 1) {
+      m_data = std::make_shared<std::vector<T>>(*m_data);
+    }
+    return *m_data;
+  }
+
+  std::size_t size() const { return m_data ? m_data->size() : 0; }
+  bool empty() const { return !size(); }
+  const T* data() const { return get().data(); }
+  const T& operator[](std::size_t i) const
+  {
+    assert(i < size());
+    return (*m_data)[i];
+  }
+  const_iterator begin() const { return get().begin(); }
+  const_iterator end() const { return get().end(); }
+
+  void resize(std::size_t n)
+  {
+    if (n != size())
+      mut().resize(n);
+  }
+  void resize(std::size_t n, const T& value)
+  {
+    if (n != size())
+      mut().resize(n, value);
+  }
+  void reserve(std::size_t n) { mut().reserve(n); }
+  void clear() { m_data.reset(); }
+
+  /// True if both share the same elements (not just equal ones)
+  bool shares(const cow_vector& other) const { return m_data == other.m_data; }
+
+  /// Same elements, O(1) if shared
+  bool operator==(const cow_vector& other) const
+  {
+    return shares(other) || get() == other.get();
+  }
+  bool operator!=(const cow_vector& other) const { return !(*this == other); }
+};
+
+} // namespace pymol
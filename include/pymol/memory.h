@@ -114,6 +114,25 @@ cache_ptr<T> make_cache(Args &&... args) {
   return cache_ptr<T>(new T(std::forward<Args>(args)...));
 }
 
+/**
+ * Allocator which default-initializes (doesn't zero) trivial types, so
+ * resizing a vector doesn't touch the new memory.
+ */
+template <typename T> struct default_init_allocator : std::allocator<T> {
+  template <typename U> struct rebind {
+    using other = default_init_allocator<U>;
+  };
+
+  using std::allocator<T>::allocator;
+
+  template <typename U> void construct(U* p) { ::new (static_cast<void*>(p)) U; }
+
+  template <typename U, typename... Args> void construct(U* p, Args&&... args)
+  {
+    ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+  }
+};
+
 /**
  * Take ownership of a raw pointer with a custom delete function.
  *
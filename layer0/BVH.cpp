@@ -0,0 +1,600 @@
+/**
+ * @file Bounding volume hierarchy for ray casting
+ *
+ * (c) Schrodinger, Inc.
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64) ||                                     \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define BVH_SSE
+#endif
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define BVH_AVX
+#define BVH_AVX_TARGET
+#elif defined(BVH_SSE) && (defined(__GNUC__) || defined(__clang__)) &&       \
+    (defined(__x86_64__) || defined(__i386__))
+// AVX code path is compiled anyway, and selected if the CPU supports it
+#include <immintrin.h>
+#define BVH_AVX
+#define BVH_AVX_DISPATCH
+#define BVH_AVX_TARGET __attribute__((target("avx")))
+#endif
+
+#include "BVH.h"
+
+namespace pymol
+{
+
+namespace
+{
+constexpr int NumBins = 16;
+
+struct Box {
+  float lo[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+  float hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+
+  void grow(const float* lo_, const float* hi_)
+  {
+    for (int a = 0; a < 3; ++a) {
+      lo[a] = std::min(lo[a], lo_[a]);
+      hi[a] = std::max(hi[a], hi_[a]);
+    }
+  }
+
+  void grow(const Box& other) { grow(other.lo, other.hi); }
+
+  float area() const
+  {
+    float d0 = hi[0] - lo[0], d1 = hi[1] - lo[1], d2 = hi[2] - lo[2];
+    if (d0 < 0.f || d1 < 0.f || d2 < 0.f)
+      return 0.f;
+    return 2.f * (d0 * d1 + d1 * d2 + d2 * d0);
+  }
+};
+
+bool cpuHasAVX()
+{
+#if defined(BVH_AVX_DISPATCH)
+  static const bool avx = __builtin_cpu_supports("avx");
+  return avx;
+#elif defined(BVH_AVX)
+  return true;
+#else
+  return false;
+#endif
+}
+
+using PacketRows = const float (*)[BVHPacket::MaxSize];
+
+// Slab tests of one box against rays [i, n_padded). Directions may have mixed
+// signs, so take min/max of both slabs. All variants do the same operations,
+// so the results don't depend on the code path.
+
+#if defined(BVH_AVX)
+BVH_AVX_TARGET unsigned slabsAVX(const float* lo, const float* hi, int& i,
+    int n_padded, float t_min, PacketRows org, PacketRows inv_dir,
+    const float* t_max, float* t_enter)
+{
+  unsigned mask = 0;
+  for (; i < n_padded; i += 8) {
+    __m256 tn = _mm256_set1_ps(t_min);
+    __m256 tf = _mm256_load_ps(t_max + i);
+
+    for (int a = 0; a < 3; ++a) {
+      const __m256 o = _mm256_load_ps(org[a] + i);
+      const __m256 inv = _mm256_load_ps(inv_dir[a] + i);
+      const __m256 t0 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(lo[a]), o), inv);
+      const __m256 t1 = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(hi[a]), o), inv);
+      tn = _mm256_max_ps(tn, _mm256_min_ps(t0, t1));
+      tf = _mm256_min_ps(tf, _mm256_max_ps(t0, t1));
+    }
+
+    _mm256_store_ps(t_enter + i, tn);
+    mask |= unsigned(_mm256_movemask_ps(_mm256_cmp_ps(tn, tf, _CMP_LE_OQ))) << i;
+  }
+  return mask;
+}
+#endif
+
+#if defined(BVH_SSE)
+unsigned slabsSSE(const float* lo, const float* hi, int& i, int n_padded,
+    float t_min, PacketRows org, PacketRows inv_dir, const float* t_max,
+    float* t_enter)
+{
+  unsigned mask = 0;
+  for (; i < n_padded; i += 4) {
+    __m128 tn = _mm_set1_ps(t_min);
+    __m128 tf = _mm_load_ps(t_max + i);
+
+    for (int a = 0; a < 3; ++a) {
+      const __m128 o = _mm_load_ps(org[a] + i);
+      const __m128 inv = _mm_load_ps(inv_dir[a] + i);
+      const __m128 t0 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(lo[a]), o), inv);
+      const __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(hi[a]), o), inv);
+      tn = _mm_max_ps(tn, _mm_min_ps(t0, t1));
+      tf = _mm_min_ps(tf, _mm_max_ps(t0, t1));
+    }
+
+    _mm_store_ps(t_enter + i, tn);
+    mask |= unsigned(_mm_movemask_ps(_mm_cmple_ps(tn, tf))) << i;
+  }
+  return mask;
+}
+#endif
+
+unsigned slabsScalar(const float* lo, const float* hi, int i, int n_padded,
+    float t_min, PacketRows org, PacketRows inv_dir, const float* t_max,
+    float* t_enter)
+{
+  unsigned mask = 0;
+  for (; i < n_padded; ++i) {
+    float tn = t_min, tf = t_max[i];
+
+    for (int a = 0; a < 3; ++a) {
+      const float t0 = (lo[a] - org[a][i]) * inv_dir[a][i];
+      const float t1 = (hi[a] - org[a][i]) * inv_dir[a][i];
+      tn = std::max(tn, std::min(t0, t1));
+      tf = std::min(tf, std::max(t0, t1));
+    }
+
+    t_enter[i] = tn;
+    if (tn <= tf)
+      mask |= 1u << i;
+  }
+  return mask;
+}
+} // namespace
+
+/*========================================================================*/
+
+struct BVH::Builder {
+  BVH& bvh;
+  const float* bounds;
+  const int* ids;
+  std::vector<int> order;
+  std::vector<float> centroid;
+
+  Builder(BVH& bvh_, const float* bounds_, const int* ids_, std::size_t n)
+      : bvh(bvh_)
+      , bounds(bounds_)
+      , ids(ids_)
+      , order(n)
+      , centroid(n * 3)
+  {
+    for (std::size_t i = 0; i < n; ++i) {
+      order[i] = int(i);
+      for (int a = 0; a < 3; ++a) {
+        centroid[i * 3 + a] = 0.5f * (bounds[i * 6 + a] + bounds[i * 6 + 3 + a]);
+      }
+    }
+  }
+
+  Box rangeBox(int begin, int end) const
+  {
+    Box box;
+    for (int i = begin; i < end; ++i) {
+      const float* b = bounds + order[i] * 6;
+      box.grow(b, b + 3);
+    }
+    return box;
+  }
+
+  /**
+   * Splits [begin, end) in two along the binned SAH optimum.
+   * @return First index of the second half
+   */
+  int split(int begin, int end)
+  {
+    Box cbox;
+    for (int i = begin; i < end; ++i) {
+      const float* c = centroid.data() + order[i] * 3;
+      cbox.grow(c, c);
+    }
+
+    float best_cost = FLT_MAX;
+    int best_axis = -1, best_bin = 0;
+
+    for (int a = 0; a < 3; ++a) {
+      const float extent = cbox.hi[a] - cbox.lo[a];
+      if (!(extent > 0.f))
+        continue;
+
+      const float scale = NumBins / extent;
+      Box bin_box[NumBins];
+      int bin_count[NumBins] = {};
+
+      for (int i = begin; i < end; ++i) {
+        const int item = order[i];
+        int k = int((centroid[item * 3 + a] - cbox.lo[a]) * scale);
+        k = std::min(std::max(k, 0), NumBins - 1);
+        bin_box[k].grow(bounds + item * 6, bounds + item * 6 + 3);
+        ++bin_count[k];
+      }
+
+      // right-to-left sweep
+      float right_cost[NumBins];
+      Box acc;
+      int count = 0;
+      for (int k = NumBins - 1; k > 0; --k) {
+        acc.grow(bin_box[k]);
+        count += bin_count[k];
+        right_cost[k] = count ? acc.area() * count : FLT_MAX;
+      }
+
+      // left-to-right sweep, split before bin k
+      acc = Box();
+      count = 0;
+      for (int k = 1; k < NumBins; ++k) {
+        acc.grow(bin_box[k - 1]);
+        count += bin_count[k - 1];
+        if (!count || right_cost[k] == FLT_MAX)
+          continue;
+        const float cost = acc.area() * count + right_cost[k];
+        if (cost < best_cost) {
+          best_cost = cost;
+          best_axis = a;
+          best_bin = k;
+        }
+      }
+    }
+
+    const int half = begin + (end - begin) / 2;
+
+    if (best_axis < 0) {
+      // all centroids coincide
+      return half;
+    }
+
+    const int a = best_axis;
+    const float lo = cbox.lo[a];
+    const float scale = NumBins / (cbox.hi[a] - lo);
+    const float* c = centroid.data();
+
+    auto mid = std::partition(
+        order.begin() + begin, order.begin() + end, [&](int item) {
+          int k = int((c[item * 3 + a] - lo) * scale);
+          return std::min(std::max(k, 0), NumBins - 1) < best_bin;
+        });
+
+    const int m = int(mid - order.begin());
+    if (m != begin && m != end)
+      return m;
+
+    std::nth_element(order.begin() + begin, order.begin() + half,
+        order.begin() + end,
+        [&](int i, int j) { return c[i * 3 + a] < c[j * 3 + a]; });
+    return half;
+  }
+
+  int makeLeaf(int begin, int end)
+  {
+    const int ref = Empty - 1 - int(bvh.m_lists.size());
+    for (int i = begin; i < end; ++i) {
+      bvh.m_lists.push_back(ids[order[i]]);
+      const float* b = bounds + order[i] * 6;
+      bvh.m_item_bounds.insert(bvh.m_item_bounds.end(), b, b + 6);
+    }
+    bvh.m_lists.push_back(-1);
+    bvh.m_item_bounds.resize(bvh.m_lists.size() * 6, 0.f);
+    return ref;
+  }
+
+  int buildRef(int begin, int end, int depth)
+  {
+    if (end - begin <= LeafSize || depth >= MaxDepth)
+      return makeLeaf(begin, end);
+
+    int ranges[Width + 1];
+    int n_ranges = 0;
+
+    const int mid = split(begin, end);
+    for (auto& half : {std::make_pair(begin, mid), std::make_pair(mid, end)}) {
+      ranges[n_ranges++] = half.first;
+      if (half.second - half.first > LeafSize) {
+        ranges[n_ranges++] = split(half.first, half.second);
+      }
+    }
+    ranges[n_ranges] = end;
+
+    const int index = int(bvh.m_nodes.size());
+    bvh.m_nodes.emplace_back();
+
+    for (int k = 0; k < Width; ++k) {
+      Box box;
+      int ref = Empty;
+
+      if (k < n_ranges) {
+        box = rangeBox(ranges[k], ranges[k + 1]);
+        ref = buildRef(ranges[k], ranges[k + 1], depth + 1);
+      } else {
+        box.lo[0] = box.lo[1] = box.lo[2] = 0.f;
+        box.hi[0] = box.hi[1] = box.hi[2] = 0.f;
+      }
+
+      // may have been reallocated by the recursive call
+      auto& node = bvh.m_nodes[index];
+      node.child[k] = ref;
+      for (int a = 0; a < 3; ++a) {
+        node.bounds[a][k] = box.lo[a];
+        node.bounds[a + 3][k] = box.hi[a];
+      }
+    }
+
+    return index;
+  }
+};
+
+void BVH::build(const float* bounds, const int* ids, std::size_t n)
+{
+  m_nodes.clear();
+  m_lists.clear();
+  m_item_bounds.clear();
+  m_n_items = n;
+  m_root = Empty;
+
+  if (!n)
+    return;
+
+  m_nodes.reserve(n / (LeafSize * (Width - 1)) + 1);
+  m_lists.reserve(n + n / LeafSize * 2 + 1);
+  m_item_bounds.reserve(m_lists.capacity() * 6);
+
+  Builder builder(*this, bounds, ids, n);
+  m_root = builder.buildRef(0, int(n), 0);
+}
+
+/*========================================================================*/
+
+BVHRay::BVHRay(const BVH& bvh, const float* org, const float* dir, float t_min)
+    : m_bvh(bvh)
+    , m_t_min(t_min)
+{
+  for (int a = 0; a < 3; ++a) {
+    float d = dir[a];
+    if (std::fabs(d) < 1e-30f) {
+      // avoid inf * 0 = NaN for rays parallel to a slab
+      d = std::signbit(d) ? -1e-30f : 1e-30f;
+    }
+    m_org[a] = org[a];
+    m_inv_dir[a] = 1.f / d;
+    m_near[a] = (m_inv_dir[a] < 0.f) ? a + 3 : a;
+  }
+
+  if (!bvh.empty()) {
+    m_stack[m_size++] = {bvh.root(), t_min};
+  }
+}
+
+int BVHRay::intersect(const BVH::Node& node, float t_max, float* t_enter) const
+{
+#ifdef BVH_SSE
+  __m128 tn = _mm_set1_ps(m_t_min);
+  __m128 tf = _mm_set1_ps(t_max);
+
+  for (int a = 0; a < 3; ++a) {
+    const __m128 o = _mm_set1_ps(m_org[a]);
+    const __m128 inv = _mm_set1_ps(m_inv_dir[a]);
+    const __m128 lo = _mm_load_ps(node.bounds[m_near[a]]);
+    const __m128 hi = _mm_load_ps(node.bounds[(m_near[a] + 3) % 6]);
+    tn = _mm_max_ps(tn, _mm_mul_ps(_mm_sub_ps(lo, o), inv));
+    tf = _mm_min_ps(tf, _mm_mul_ps(_mm_sub_ps(hi, o), inv));
+  }
+
+  _mm_storeu_ps(t_enter, tn);
+  return _mm_movemask_ps(_mm_cmple_ps(tn, tf));
+#else
+  int mask = 0;
+
+  for (int k = 0; k < BVH::Width; ++k) {
+    float tn = m_t_min, tf = t_max;
+
+    for (int a = 0; a < 3; ++a) {
+      const float lo = node.bounds[m_near[a]][k];
+      const float hi = node.bounds[(m_near[a] + 3) % 6][k];
+      tn = std::max(tn, (lo - m_org[a]) * m_inv_dir[a]);
+      tf = std::min(tf, (hi - m_org[a]) * m_inv_dir[a]);
+    }
+
+    t_enter[k] = tn;
+    if (tn <= tf)
+      mask |= 1 << k;
+  }
+
+  return mask;
+#endif
+}
+
+const int* BVHRay::next(float t_max)
+{
+  while (m_size) {
+    const Entry entry = m_stack[--m_size];
+
+    if (entry.t > t_max)
+      continue;
+
+    if (BVH::isLeaf(entry.ref))
+      return m_bvh.leaf(entry.ref);
+
+    const BVH::Node& node = m_bvh.node(entry.ref);
+    float t_enter[BVH::Width];
+    const int mask = intersect(node, t_max, t_enter);
+
+    if (!mask)
+      continue;
+
+    // sort hits far to near, so that the nearest one ends up on top
+    Entry hits[BVH::Width];
+    int n_hits = 0;
+
+    for (int k = 0; k < BVH::Width; ++k) {
+      if (!(mask & (1 << k)) || node.child[k] == BVH::Empty)
+        continue;
+      int j = n_hits++;
+      for (; j > 0 && hits[j - 1].t < t_enter[k]; --j) {
+        hits[j] = hits[j - 1];
+      }
+      hits[j] = {node.child[k], t_enter[k]};
+    }
+
+    for (int j = 0; j < n_hits; ++j) {
+      m_stack[m_size++] = hits[j];
+    }
+  }
+
+  return nullptr;
+}
+
+/*========================================================================*/
+
+BVHPacket::BVHPacket(const BVH& bvh, int n, const float (*org)[3],
+    const float (*dir)[3], float t_min)
+    : m_bvh(bvh)
+    , m_n(std::min(n, MaxSize))
+    , m_t_min(t_min)
+    , m_avx(cpuHasAVX())
+{
+#if defined(BVH_SSE)
+  m_n_padded = m_avx ? (m_n + 7) & ~7 : (m_n + 3) & ~3;
+#else
+  m_n_padded = m_n;
+#endif
+
+  for (int i = 0; i < m_n_padded; ++i) {
+    // padding lanes repeat the last ray, they're never active
+    const int j = std::min(i, m_n - 1);
+    for (int a = 0; a < 3; ++a) {
+      float d = dir[j][a];
+      if (std::fabs(d) < 1e-30f) {
+        d = std::signbit(d) ? -1e-30f : 1e-30f;
+      }
+      m_org[a][i] = org[j][a];
+      m_inv_dir[a][i] = 1.f / d;
+    }
+  }
+
+  if (m_n > 0 && !bvh.empty()) {
+    Entry& entry = m_stack[m_size++];
+    entry.ref = bvh.root();
+    entry.mask = (1u << m_n) - 1;
+    std::fill_n(entry.t, MaxSize, t_min);
+  }
+}
+
+int BVHPacket::lanes()
+{
+  return cpuHasAVX() ? 8 : 4;
+}
+
+unsigned BVHPacket::intersect(const float* lo, const float* hi,
+    const float* t_max, float* t_enter) const
+{
+  unsigned mask = 0;
+  int i = 0;
+
+#if defined(BVH_AVX)
+  if (m_avx) {
+    mask |= slabsAVX(
+        lo, hi, i, m_n_padded, m_t_min, m_org, m_inv_dir, t_max, t_enter);
+  }
+#endif
+#if defined(BVH_SSE)
+  mask |= slabsSSE(
+      lo, hi, i, m_n_padded, m_t_min, m_org, m_inv_dir, t_max, t_enter);
+#endif
+
+  return mask | slabsScalar(lo, hi, i, m_n_padded, m_t_min, m_org, m_inv_dir,
+                    t_max, t_enter);
+}
+
+void BVHPacket::padded(const float* t_max, float* out) const
+{
+  // padding lanes are inactive
+  for (int i = 0; i < MaxSize; ++i) {
+    out[i] = (i < m_n) ? t_max[i] : -FLT_MAX;
+  }
+}
+
+void BVHPacket::intersectItems(const int* list, int n, const float* t_max_,
+    unsigned* item_mask) const
+{
+  alignas(32) float t_max[MaxSize];
+  alignas(32) float t_enter[MaxSize];
+  padded(t_max_, t_max);
+
+  for (int j = 0; j < n; ++j) {
+    const float* b = m_bvh.itemBounds(list + j);
+    item_mask[j] = intersect(b, b + 3, t_max, t_enter);
+  }
+}
+
+const int* BVHPacket::next(const float* t_max_, unsigned& mask)
+{
+  alignas(32) float t_max[MaxSize];
+  padded(t_max_, t_max);
+
+  while (m_size) {
+    const Entry& entry = m_stack[--m_size];
+
+    unsigned live = 0;
+    for (int i = 0; i < m_n; ++i) {
+      if ((entry.mask & (1u << i)) && entry.t[i] <= t_max[i])
+        live |= 1u << i;
+    }
+
+    if (!live)
+      continue;
+
+    if (BVH::isLeaf(entry.ref)) {
+      mask = live;
+      return m_bvh.leaf(entry.ref);
+    }
+
+    const BVH::Node& node = m_bvh.node(entry.ref);
+
+    // sort hits far to near, so that the nearest one ends up on top
+    Entry hits[BVH::Width];
+    float t_near[BVH::Width];
+    int n_hits = 0;
+
+    for (int k = 0; k < BVH::Width; ++k) {
+      if (node.child[k] == BVH::Empty)
+        continue;
+
+      Entry& hit = hits[n_hits];
+      const float lo[3] = {node.bounds[0][k], node.bounds[1][k], node.bounds[2][k]};
+      const float hi[3] = {node.bounds[3][k], node.bounds[4][k], node.bounds[5][k]};
+      hit.mask = intersect(lo, hi, t_max, hit.t) & live;
+      if (!hit.mask)
+        continue;
+      hit.ref = node.child[k];
+
+      float t = FLT_MAX;
+      for (int i = 0; i < m_n; ++i) {
+        if (hit.mask & (1u << i))
+          t = std::min(t, hit.t[i]);
+      }
+
+      int j = n_hits++;
+      for (; j > 0 && t_near[j - 1] < t; --j) {
+        std::swap(hits[j], hits[j - 1]);
+        t_near[j] = t_near[j - 1];
+      }
+      t_near[j] = t;
+    }
+
+    for (int j = 0; j < n_hits; ++j) {
+      m_stack[m_size++] = hits[j];
+    }
+  }
+
+  return nullptr;
+}
+
+} // namespace pymol
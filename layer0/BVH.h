@@ -0,0 +1,200 @@
+/**
+ * @file Bounding volume hierarchy for ray casting
+ *
+ * (c) Schrodinger, Inc.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace pymol
+{
+
+/**
+ * Four-wide bounding volume hierarchy over axis-aligned item boxes, built
+ * with the binned surface area heuristic (SAH).
+ *
+ * Unlike the voxel grid (MapType), every item is referenced by exactly one
+ * leaf, so no duplicate elimination is needed during traversal, and the
+ * memory footprint does not depend on the spatial distribution of the items
+ * (e.g. a large assembly with a few distant ligands).
+ *
+ * Leaves store -1 terminated item lists, same as MapType::EList.
+ */
+class BVH
+{
+public:
+  /// Children per node (matches the SSE register width)
+  static constexpr int Width = 4;
+  /// Maximum number of items in a leaf (unless MaxDepth is reached)
+  static constexpr int LeafSize = 4;
+  /// Maximum node depth, bounds the traversal stack
+  static constexpr int MaxDepth = 48;
+
+  /**
+   * Node with structure-of-arrays child boxes, so that all children can be
+   * tested against a ray at once.
+   */
+  struct alignas(16) Node {
+    float bounds[6][Width]; ///< min x, y, z, max x, y, z
+    int child[Width];       ///< node index, leaf reference or Empty
+  };
+
+  /// Child reference of an unused node slot
+  static constexpr int Empty = -1;
+
+  /**
+   * Builds the tree.
+   * @param bounds 6 floats per item: min x, y, z, max x, y, z
+   * @param ids Item identifiers which are stored in the leaf lists
+   * @param n Number of items
+   */
+  void build(const float* bounds, const int* ids, std::size_t n);
+
+  bool empty() const { return m_root == Empty; }
+  std::size_t nodeCount() const { return m_nodes.size(); }
+  std::size_t itemCount() const { return m_n_items; }
+
+  /// Root reference (node index, leaf reference or Empty)
+  int root() const { return m_root; }
+  const Node& node(int ref) const { return m_nodes[ref]; }
+
+  static bool isLeaf(int ref) { return ref < Empty; }
+
+  /// -1 terminated item list of leaf `ref`
+  const int* leaf(int ref) const { return m_lists.data() + (Empty - 1 - ref); }
+
+  /// Box (min x, y, z, max x, y, z) of a leaf list entry
+  const float* itemBounds(const int* item) const
+  {
+    return m_item_bounds.data() + (item - m_lists.data()) * 6;
+  }
+
+private:
+  struct Builder;
+
+  std::vector<Node> m_nodes;
+  std::vector<int> m_lists;
+  std::vector<float> m_item_bounds; ///< parallel to m_lists
+  std::size_t m_n_items = 0;
+  int m_root = Empty;
+};
+
+/**
+ * Front-to-back traversal of a BVH along a ray. Yields the item lists of all
+ * leaves whose box intersects the ray segment, nearest box entry first.
+ *
+ * Since the maximum distance is given on each step, the caller can narrow it
+ * down as soon as a hit is found, to prune the remaining part of the tree.
+ */
+class BVHRay
+{
+public:
+  /**
+   * @param bvh Tree to traverse
+   * @param org Ray origin
+   * @param dir Ray direction (distances are in units of its length)
+   * @param t_min Ignore boxes which end before this distance
+   */
+  BVHRay(const BVH& bvh, const float* org, const float* dir, float t_min);
+
+  /**
+   * @param t_max Ignore boxes which start beyond this distance
+   * @return Item list of the next leaf or NULL if there is none
+   */
+  const int* next(float t_max);
+
+private:
+  struct Entry {
+    int ref;
+    float t;
+  };
+
+  /// Tests all children of a node, returns bit mask of hits
+  int intersect(const BVH::Node& node, float t_max, float* t_enter) const;
+
+  const BVH& m_bvh;
+  float m_org[3];
+  float m_inv_dir[3];
+  int m_near[3]; ///< bounds row of the entry plane per axis
+  float m_t_min;
+  int m_size = 0;
+  Entry m_stack[BVH::MaxDepth * (BVH::Width - 1) + 2];
+};
+
+/**
+ * Traversal of a BVH with a packet of coherent rays (e.g. adjacent primary
+ * rays, or their shadow rays). Every node is fetched once for the whole
+ * packet, and each child box is tested against all rays at once, with 4 (SSE)
+ * or 8 (AVX, if the CPU supports it) rays per instruction.
+ *
+ * Yields the item lists of all leaves which intersect any of the active rays,
+ * nearest box entry (over all rays) first, together with the mask of rays
+ * which intersect the leaf box. Rays can be narrowed down or deactivated
+ * individually on each step.
+ */
+class BVHPacket
+{
+public:
+  /// Maximum number of rays
+  static constexpr int MaxSize = 8;
+
+  /// Preferred number of rays (SIMD register width of this CPU)
+  static int lanes();
+
+  /**
+   * @param bvh Tree to traverse
+   * @param n Number of rays, up to MaxSize
+   * @param org Ray origins
+   * @param dir Ray directions (distances are in units of their length)
+   * @param t_min Ignore boxes which end before this distance
+   */
+  BVHPacket(const BVH& bvh, int n, const float (*org)[3],
+      const float (*dir)[3], float t_min);
+
+  /**
+   * @param t_max Per ray: ignore boxes which start beyond this distance.
+   * A ray with `t_max < t_min` is inactive.
+   * @param[out] mask Bit mask of the rays which intersect the leaf box
+   * @return Item list of the next leaf or NULL if there is none
+   */
+  const int* next(const float* t_max, unsigned& mask);
+
+  /**
+   * Tests the boxes of the first `n` items of a leaf list against all rays,
+   * so that the exact primitive tests can be skipped for rays which miss.
+   * @param list Item list returned by next()
+   * @param t_max Same as for next()
+   * @param[out] item_mask Per item: bit mask of the rays which intersect its box
+   */
+  void intersectItems(const int* list, int n, const float* t_max,
+      unsigned* item_mask) const;
+
+private:
+  struct alignas(32) Entry {
+    float t[MaxSize]; ///< box entry distance per ray
+    int ref;
+    unsigned mask;
+  };
+
+  /// Tests a box against all rays, returns bit mask of hits
+  unsigned intersect(const float* lo, const float* hi, const float* t_max,
+      float* t_enter) const;
+
+  /// Copies t_max, with padding lanes inactive
+  void padded(const float* t_max, float* out) const;
+
+  const BVH& m_bvh;
+  int m_n;
+  int m_n_padded; ///< multiple of the SIMD width
+  float m_t_min;
+  bool m_avx;
+  alignas(32) float m_org[3][MaxSize];
+  alignas(32) float m_inv_dir[3][MaxSize];
+  int m_size = 0;
+  Entry m_stack[BVH::MaxDepth * (BVH::Width - 1) + 2];
+};
+
+} // namespace pymol
@@ -0,0 +1,274 @@
+/**
+ * @file Compressed bitmap for sets of non-negative integers
+ *
+ * (c) Schrodinger, Inc.
+ */
+
+#include "Bitmap.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace pymol
+{
+
+static int popcount64(std::uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_popcountll(x);
+#else
+  int n = 0;
+  for (; x; x &= x - 1)
+    ++n;
+  return n;
+#endif
+}
+
+/// Index of the lowest set bit, `x` must not be zero
+static int ctz64(std::uint64_t x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(x);
+#else
+  int n = 0;
+  for (; !(x & 1); x >>= 1)
+    ++n;
+  return n;
+#endif
+}
+
+bool Bitmap::Chunk::contains(std::uint16_t low) const
+{
+  if (isDense())
+    return (dense[low >> 6] >> (low & 63)) & 1;
+  return std::binary_search(sparse.begin(), sparse.end(), low);
+}
+
+std::size_t Bitmap::Chunk::count() const
+{
+  if (!isDense())
+    return sparse.size();
+  std::size_t n = 0;
+  for (auto word : dense)
+    n += popcount64(word);
+  return n;
+}
+
+void Bitmap::Chunk::add(std::uint16_t low)
+{
+  if (isDense()) {
+    dense[low >> 6] |= std::uint64_t(1) << (low & 63);
+    return;
+  }
+
+  if (sparse.empty() || sparse.back() < low) {
+    sparse.push_back(low);
+  } else {
+    auto it = std::lower_bound(sparse.begin(), sparse.end(), low);
+    if (*it == low)
+      return;
+    sparse.insert(it, low);
+  }
+
+  if (sparse.size() > MaxSparse)
+    toDense();
+}
+
+void Bitmap::Chunk::remove(std::uint16_t low)
+{
+  if (isDense()) {
+    dense[low >> 6] &= ~(std::uint64_t(1) << (low & 63));
+    return;
+  }
+
+  auto it = std::lower_bound(sparse.begin(), sparse.end(), low);
+  if (it != sparse.end() && *it == low)
+    sparse.erase(it);
+}
+
+void Bitmap::Chunk::toDense()
+{
+  dense.assign(DenseWords, 0);
+  for (auto low : sparse)
+    dense[low >> 6] |= std::uint64_t(1) << (low & 63);
+  sparse.clear();
+  sparse.shrink_to_fit();
+}
+
+void Bitmap::Chunk::toSparse()
+{
+  sparse.clear();
+  for (std::size_t w = 0; w < DenseWords; ++w) {
+    for (auto word = dense[w]; word; word &= word - 1)
+      sparse.push_back(std::uint16_t(w * 64 + ctz64(word)));
+  }
+  dense.clear();
+  dense.shrink_to_fit();
+}
+
+void Bitmap::Chunk::normalize()
+{
+  if (isDense()) {
+    if (count() <= MaxSparse)
+      toSparse();
+  } else if (sparse.size() > MaxSparse) {
+    toDense();
+  }
+}
+
+Bitmap::Bitmap(const Bitmap& other)
+{
+  *this = other;
+}
+
+Bitmap& Bitmap::operator=(const Bitmap& other)
+{
+  if (this != &other) {
+    m_chunks.clear();
+    m_chunks.resize(other.m_chunks.size());
+    for (std::size_t i = 0; i < m_chunks.size(); ++i) {
+      if (other.m_chunks[i])
+        m_chunks[i].reset(new Chunk(*other.m_chunks[i]));
+    }
+  }
+  return *this;
+}
+
+Bitmap::Chunk* Bitmap::chunk(std::uint32_t hi)
+{
+  if (hi >= m_chunks.size())
+    m_chunks.resize(hi + 1);
+  if (!m_chunks[hi])
+    m_chunks[hi].reset(new Chunk());
+  return m_chunks[hi].get();
+}
+
+void Bitmap::add(std::uint32_t key)
+{
+  chunk(key >> 16)->add(key & 0xFFFF);
+}
+
+void Bitmap::remove(std::uint32_t key)
+{
+  auto hi = key >> 16;
+  if (hi < m_chunks.size() && m_chunks[hi])
+    m_chunks[hi]->remove(key & 0xFFFF);
+}
+
+std::size_t Bitmap::count() const
+{
+  std::size_t n = 0;
+  for (auto& c : m_chunks) {
+    if (c)
+      n += c->count();
+  }
+  return n;
+}
+
+Bitmap& Bitmap::operator|=(const Bitmap& other)
+{
+  for (std::uint32_t hi = 0; hi < other.m_chunks.size(); ++hi) {
+    const Chunk* src = other.m_chunks[hi].get();
+    if (!src)
+      continue;
+    Chunk* dst = chunk(hi);
+    if (src->isDense() || dst->isDense()) {
+      if (!dst->isDense())
+        dst->toDense();
+      if (src->isDense()) {
+        for (std::size_t w = 0; w < Chunk::DenseWords; ++w)
+          dst->dense[w] |= src->dense[w];
+      } else {
+        for (auto low : src->sparse)
+          dst->add(low);
+      }
+    } else {
+      std::vector<std::uint16_t> merged;
+      merged.reserve(dst->sparse.size() + src->sparse.size());
+      std::set_union(dst->sparse.begin(), dst->sparse.end(),
+          src->sparse.begin(), src->sparse.end(), std::back_inserter(merged));
+      dst->sparse.swap(merged);
+    }
+    dst->normalize();
+  }
+  return *this;
+}
+
+Bitmap& Bitmap::operator&=(const Bitmap& other)
+{
+  for (std::uint32_t hi = 0; hi < m_chunks.size(); ++hi) {
+    Chunk* dst = m_chunks[hi].get();
+    if (!dst)
+      continue;
+    const Chunk* src =
+        hi < other.m_chunks.size() ? other.m_chunks[hi].get() : nullptr;
+    if (!src) {
+      m_chunks[hi].reset();
+      continue;
+    }
+    if (dst->isDense() && src->isDense()) {
+      for (std::size_t w = 0; w < Chunk::DenseWords; ++w)
+        dst->dense[w] &= src->dense[w];
+    } else if (dst->isDense()) {
+      std::vector<std::uint16_t> kept;
+      for (auto low : src->sparse)
+        if (dst->contains(low))
+          kept.push_back(low);
+      dst->dense.clear();
+      dst->sparse.swap(kept);
+    } else {
+      auto end = std::remove_if(dst->sparse.begin(), dst->sparse.end(),
+          [src](std::uint16_t low) { return !src->contains(low); });
+      dst->sparse.erase(end, dst->sparse.end());
+    }
+    dst->normalize();
+  }
+  return *this;
+}
+
+Bitmap& Bitmap::operator-=(const Bitmap& other)
+{
+  auto n = std::min(m_chunks.size(), other.m_chunks.size());
+  for (std::uint32_t hi = 0; hi < n; ++hi) {
+    Chunk* dst = m_chunks[hi].get();
+    const Chunk* src = other.m_chunks[hi].get();
+    if (!dst || !src)
+      continue;
+    if (dst->isDense() && src->isDense()) {
+      for (std::size_t w = 0; w < Chunk::DenseWords; ++w)
+        dst->dense[w] &= ~src->dense[w];
+    } else if (dst->isDense()) {
+      for (auto low : src->sparse)
+        dst->remove(low);
+    } else {
+      auto end = std::remove_if(dst->sparse.begin(), dst->sparse.end(),
+          [src](std::uint16_t low) { return src->contains(low); });
+      dst->sparse.erase(end, dst->sparse.end());
+    }
+    dst->normalize();
+  }
+  return *this;
+}
+
+std::vector<std::uint32_t> Bitmap::toVector() const
+{
+  std::vector<std::uint32_t> result;
+  result.reserve(count());
+  for (std::uint32_t hi = 0; hi < m_chunks.size(); ++hi) {
+    const Chunk* c = m_chunks[hi].get();
+    if (!c)
+      continue;
+    if (!c->isDense()) {
+      for (auto low : c->sparse)
+        result.push_back((hi << 16) | low);
+      continue;
+    }
+    for (std::uint32_t w = 0; w < Chunk::DenseWords; ++w) {
+      for (auto word = c->dense[w]; word; word &= word - 1)
+        result.push_back((hi << 16) | (w * 64 + ctz64(word)));
+    }
+  }
+  return result;
+}
+
+} // namespace pymol
@@ -0,0 +1,99 @@
+/**
+ * @file Compressed bitmap for sets of non-negative integers
+ *
+ * (c) Schrodinger, Inc.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace pymol
+{
+
+/**
+ * Roaring-style compressed bitmap. The key space is split into chunks of
+ * 2^16 values. A sparse chunk stores its members as a sorted array of the
+ * low 16 bits, a dense chunk (more than 4096 members) as a plain 8 KiB
+ * bitset. Membership tests are O(1) for dense and O(log n) for sparse
+ * chunks, set operations work a 64-bit word at a time on dense chunks.
+ */
+class Bitmap
+{
+public:
+  Bitmap() = default;
+  Bitmap(const Bitmap& other);
+  Bitmap& operator=(const Bitmap& other);
+  Bitmap(Bitmap&&) = default;
+  Bitmap& operator=(Bitmap&&) = default;
+
+  bool contains(std::uint32_t key) const
+  {
+    auto hi = key >> 16;
+    if (hi >= m_chunks.size() || !m_chunks[hi])
+      return false;
+    return m_chunks[hi]->contains(key & 0xFFFF);
+  }
+
+  /// Adds `key`, cheapest when keys are added in ascending order
+  void add(std::uint32_t key);
+
+  /// Removes `key` (no-op if not a member)
+  void remove(std::uint32_t key);
+
+  void set(std::uint32_t key, bool value)
+  {
+    if (value)
+      add(key);
+    else
+      remove(key);
+  }
+
+  /// Number of members
+  std::size_t count() const;
+
+  bool empty() const { return count() == 0; }
+
+  void clear() { m_chunks.clear(); }
+
+  /// Set union
+  Bitmap& operator|=(const Bitmap& other);
+
+  /// Set intersection
+  Bitmap& operator&=(const Bitmap& other);
+
+  /// Set difference
+  Bitmap& operator-=(const Bitmap& other);
+
+  /// Members in ascending order
+  std::vector<std::uint32_t> toVector() const;
+
+private:
+  struct Chunk {
+    static constexpr std::size_t DenseWords = 1024;
+    static constexpr std::size_t MaxSparse = 4096;
+
+    std::vector<std::uint16_t> sparse; ///< sorted, used if `dense` is empty
+    std::vector<std::uint64_t> dense;  ///< DenseWords words, or empty
+
+    bool isDense() const { return !dense.empty(); }
+
+    bool contains(std::uint16_t low) const;
+    std::size_t count() const;
+    void add(std::uint16_t low);
+    void remove(std::uint16_t low);
+    void toDense();
+    void toSparse();
+    /// Switches representation after a bulk operation
+    void normalize();
+  };
+
+  Chunk* chunk(std::uint32_t hi);
+
+  std::vector<std::unique_ptr<Chunk>> m_chunks;
+};
+
+} // namespace pymol
@@ -510,6 +510,8 @@ int ContourSurfVolume(PyMOLGlobals* G, Isofield* field, float level,
       SettingGet<int>(G, cSetting_isosurface_algorithm));
   int n_tri = 0;
 
+  IsofieldDecode(G, field, range);
+
   switch (type) {
   case cIsosurfaceAlgorithm::MARCHING_CUBES_VTKM:
 #ifdef _PYMOL_VTKM
@@ -323,7 +323,7 @@ int FieldSmooth3f(CField * I)
   int a, b, c;
   int na = I->dim[0], nb = I->dim[1], nc = I->dim[2];
   int n_pts = na * nb * nc;
-  std::vector<char> data_vec(n_pts * sizeof(float));
+  decltype(CField::data) data_vec(n_pts * sizeof(float));
   auto data = data_vec.data();
   int x, y, z;
   int da, db, dc;
@@ -403,8 +403,12 @@ void FieldZero(CField * I)
   std::fill_n(I->data.begin(), I->data.size(), 0);
 }
 
-CField::CField(
-    PyMOLGlobals* G, const int* const dim, int n_dim, unsigned int base_size, cField_t type)
+/**
+ * @param zero Zero the data. Without, the memory is left uncommitted until
+ * it is written (see Isofield::source).
+ */
+CField::CField(PyMOLGlobals* G, const int* const dim, int n_dim,
+    unsigned int base_size, cField_t type, bool zero)
     : type(type)
     , base_size(base_size)
 {
@@ -413,12 +417,14 @@ CField::CField(
   I->stride.resize(n_dim);
   I->dim.resize(n_dim);
 
-  auto local_stride = base_size;
+  size_t local_stride = base_size;
   for(int a = n_dim - 1; a >= 0; a--) {
     I->stride[a] = local_stride;
     I->dim[a] = dim[a];
     local_stride *= dim[a];
   }
   I->data.resize(local_stride);
+  if(zero)
+    std::fill(I->data.begin(), I->data.end(), 0);
 }
 
@@ -20,8 +20,10 @@ Z* -------------------------------------------------------------------
 
 #include"os_python.h"
 #include"PyMOLGlobals.h"
+#include"pymol/memory.h"
 
 #include <cassert>
+#include <vector>
 
 enum cField_t {
   cFieldFloat = 0,
@@ -34,13 +36,13 @@ enum cField_t {
  */
 struct CField {
   cField_t type;
-  std::vector<char> data;
+  std::vector<char, pymol::default_init_allocator<char>> data;
   std::vector<unsigned int> dim;
   std::vector<unsigned int> stride;
   unsigned int base_size;
   CField() = default;
-  CField(
-      PyMOLGlobals* G, const int* const dim, int n_dim, unsigned int base_size, cField_t type);
+  CField(PyMOLGlobals* G, const int* const dim, int n_dim,
+      unsigned int base_size, cField_t type, bool zero = true);
   int n_dim() const noexcept { return dim.size(); }
   unsigned int size() const noexcept { return data.size(); }
 
@@ -124,8 +126,8 @@ public:
  * Multi-dimensional data array with compile-time typing.
  */
 template <typename T> struct CFieldTyped : CField {
-  CFieldTyped(const int* const dim, int n_dim)
-      : CField(nullptr, dim, n_dim, sizeof(T), _get_type<T>())
+  CFieldTyped(const int* const dim, int n_dim, bool zero = true)
+      : CField(nullptr, dim, n_dim, sizeof(T), _get_type<T>(), zero)
   {
   }
 
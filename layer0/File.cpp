@@ -12,10 +12,19 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 #include "File.h"
 #include "FileStream.h"
 #include "MemoryDebug.h"
 
+#include <algorithm>
+#include <cerrno>
 #include <fstream>
 #include <string>
 
@@ -134,4 +143,133 @@ std::string file_get_contents(pymol::zstring_view filename)
   return istream_get_contents(file);
 }
 
+#ifndef _WIN32
+static long long stat_mtime_ns(const struct stat& st)
+{
+#ifdef __APPLE__
+  const auto& ts = st.st_mtimespec;
+#else
+  const auto& ts = st.st_mtim;
+#endif
+  return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+#endif
+
+MappedFile::MappedFile(zstring_view filename)
+{
+#ifdef _WIN32
+  HANDLE file = INVALID_HANDLE_VALUE;
+  try {
+    auto wfilename = utf8_to_utf16(filename);
+    file = CreateFileW(wfilename.c_str(), GENERIC_READ, FILE_SHARE_READ,
+        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  } catch (...) {
+  }
+
+  if (file != INVALID_HANDLE_VALUE) {
+    LARGE_INTEGER filesize;
+    if (GetFileSizeEx(file, &filesize) && filesize.QuadPart > 0) {
+      HANDLE mapping =
+          CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+      if (mapping) {
+        auto view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (view) {
+          m_data = static_cast<const char*>(view);
+          m_size = filesize.QuadPart;
+          m_mapped = true;
+          m_handle = mapping;
+        } else {
+          CloseHandle(mapping);
+        }
+      }
+    }
+    CloseHandle(file);
+  }
+#else
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd != -1) {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED) {
+        madvise(addr, st.st_size, MADV_SEQUENTIAL);
+        m_data = static_cast<const char*>(addr);
+        m_size = st.st_size;
+        m_mapped = true;
+        m_mtime_ns = stat_mtime_ns(st);
+      }
+    }
+    if (m_mapped) {
+      m_fd = fd;
+    } else {
+      close(fd);
+    }
+  }
+#endif
+
+  if (!m_mapped) {
+    // empty files, pipes, or no mapping support
+    try {
+      m_contents = file_get_contents(filename);
+      m_data = m_contents.data();
+      m_size = m_contents.size();
+    } catch (...) {
+    }
+  }
+}
+
+MappedFile::~MappedFile()
+{
+  if (!m_mapped)
+    return;
+#ifdef _WIN32
+  UnmapViewOfFile(m_data);
+  CloseHandle(m_handle);
+#else
+  munmap(const_cast<char*>(m_data), m_size);
+  close(m_fd);
+#endif
+}
+
+bool MappedFile::unchanged() const
+{
+#ifndef _WIN32
+  if (m_mapped) {
+    // the descriptor refers to the mapped inode, even if the path was
+    // replaced in the meantime (which doesn't affect the mapping)
+    struct stat st;
+    if (fstat(m_fd, &st) != 0)
+      return false;
+    return std::size_t(st.st_size) == m_size && stat_mtime_ns(st) == m_mtime_ns;
+  }
+#endif
+  return true;
+}
+
+bool MappedFile::read(std::size_t offset, std::size_t size, char* dst) const
+{
+  if (offset > m_size || size > m_size - offset)
+    return false;
+#ifndef _WIN32
+  if (m_mapped) {
+    // read through the descriptor, a truncated file gives a short read
+    // where the mapping would raise SIGBUS
+    while (size) {
+      auto n = pread(m_fd, dst, size, offset);
+      if (n < 0 && errno == EINTR)
+        continue;
+      if (n <= 0)
+        return false;
+      dst += n;
+      offset += n;
+      size -= n;
+    }
+    return true;
+  }
+#endif
+  // not mapped, or mapped on Windows, where a mapped file can't be truncated
+  std::copy_n(m_data + offset, size, dst);
+  return true;
+}
+
 } // namespace pymol
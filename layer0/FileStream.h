@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <cstddef>
 #include <fstream>
 #include <string>
 
@@ -20,6 +21,58 @@ namespace pymol
  */
 std::string file_get_contents(pymol::zstring_view filename);
 
+/**
+ * Read-only memory mapping of an entire file. Pages are read on first access
+ * and belong to the page cache, so even multi-GB files can be parsed without
+ * a heap copy. Falls back to reading the file into memory if mapping fails.
+ *
+ * Accessing pages of a mapped file after it was truncated raises SIGBUS, and
+ * pages which weren't read yet show later writes to the file. Long-lived
+ * users should copy ranges with `read()` instead of accessing `data()`, and
+ * check `unchanged()`.
+ */
+class MappedFile
+{
+public:
+  /**
+   * @param filename Path in native filesystem encoding or UTF-8
+   * @post data() is nullptr if the file could not be opened
+   */
+  explicit MappedFile(zstring_view filename);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* data() const { return m_data; }
+  std::size_t size() const { return m_size; }
+
+  /// False if the data was read into memory
+  bool mapped() const { return m_mapped; }
+
+  /// False if size or modification time of the mapped file have changed
+  bool unchanged() const;
+
+  /**
+   * Copies `size` bytes at `offset` to `dst`. Unlike reading from `data()`,
+   * this is safe if the file was truncated since it was mapped.
+   * @return False if the range is beyond the end of the file
+   */
+  bool read(std::size_t offset, std::size_t size, char* dst) const;
+
+private:
+  const char* m_data = nullptr;
+  std::size_t m_size = 0;
+  bool m_mapped = false;
+  std::string m_contents; //!< fallback storage
+#ifdef _WIN32
+  void* m_handle = nullptr;
+#else
+  int m_fd = -1;
+  long long m_mtime_ns = 0;
+#endif
+};
+
 #ifdef _WIN32
 /**
  * Convert UTF-8 to UTF-16
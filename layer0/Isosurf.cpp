@@ -16,7 +16,15 @@ I* Additional authors of this source file include:
 Z* -------------------------------------------------------------------
 */
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <climits>
+#include <limits>
+#include <mutex>
 #include <random>
+#include <thread>
+#include <vector>
 
 #include"os_python.h"
 #include"os_predef.h"
@@ -31,6 +39,7 @@ Z* -------------------------------------------------------------------
 #include"PConv.h"
 #include"P.h"
 #include"Util.h"
+#include"TaskPool.h"
 
 #define Trace_OFF
 
@@ -83,6 +92,10 @@ static int IsosurfDrawLines(CIsosurf * II);
 static void IsosurfCode(CIsosurf * II, const char *bits1, const char *bits2);
 static int IsosurfDrawPoints(CIsosurf * II);
 static int IsosurfPoints(CIsosurf * II);
+static int IsosurfTiles(PyMOLGlobals * G, CIsosurf * I,
+                        const IsofieldBricks * bricks, const int *range,
+                        const int *Steps, cIsomeshMode mode);
+static bool IsosurfClipTile(CIsosurf * I, const IsofieldBricks * bricks);
 static int IsosurfGradients(PyMOLGlobals * G, CSetting * set1, CSetting * set2,
                             CIsosurf * II, Isofield * field,
                             int *range, float min_level, float max_level);
@@ -106,6 +119,8 @@ PyObject *IsosurfAsPyList(PyMOLGlobals * G, Isofield * field)
 {
   PyObject *result = NULL;
 
+  IsofieldDecode(G, field);
+
   result = PyList_New(4);
 
   PyList_SetItem(result, 0, PConvIntArrayToPyList(field->dimensions, 3));
@@ -182,6 +197,8 @@ void IsofieldComputeGradients(PyMOLGlobals * G, Isofield * field)
   int a, b, c;
   CField *data = field->data.get();
 
+  IsofieldDecode(G, field);
+
   if(!field->gradients) {
 
     /* compute gradients relative to grid axis spacing */
@@ -334,6 +351,272 @@ void IsofieldComputeGradients(PyMOLGlobals * G, Isofield * field)
 }
 
 
+/*===========================================================================*/
+/* guards Isofield::bricks, which contouring tasks fill in lazily */
+static std::mutex IsofieldBricksMutex;
+
+/**
+ * Data range of brick (ba, bb, bc). Bricks which overlap blocks of a lazily
+ * decoded field which aren't decoded yet can't be skipped, they get an
+ * infinite data range.
+ */
+static void IsofieldBrickFromData(const Isofield * field, IsofieldBricks * bricks,
+    int ba, int bb, int bc)
+{
+  const CField *data = field->data.get();
+  const IsofieldBlocks *blocks = field->source ? field->blocks.get() : nullptr;
+  const int *dim = field->dimensions;
+  const float inf = std::numeric_limits<float>::infinity();
+
+  float mn = inf, mx = -inf;
+  const int brick_min[3] = {
+      ba * IsofieldBrickSize, bb * IsofieldBrickSize, bc * IsofieldBrickSize};
+  const int brick_max[3] = {
+      std::min(brick_min[0] + IsofieldBrickSize + 1, dim[0]),
+      std::min(brick_min[1] + IsofieldBrickSize + 1, dim[1]),
+      std::min(brick_min[2] + IsofieldBrickSize + 1, dim[2])};
+  if(blocks && !blocks->decoded(brick_min, brick_max)) {
+    mn = -inf;
+    mx = inf;
+  } else {
+    for(int a = brick_min[0]; a < brick_max[0]; a++) {
+      for(int b = brick_min[1]; b < brick_max[1]; b++) {
+        for(int c = brick_min[2]; c < brick_max[2]; c++) {
+          float v = data->get<float>(a, b, c);
+          if(v > mx)
+            mx = v;
+          if(v < mn)
+            mn = v;
+          else if(v != v)  /* NaN is never above the level */
+            mn = -inf;
+        }
+      }
+    }
+  }
+  const int i = (bc * bricks->dim[1] + bb) * bricks->dim[0] + ba;
+  bricks->min[i] = mn;
+  bricks->max[i] = mx;
+}
+
+static std::shared_ptr<IsofieldBricks> IsofieldBricksFromData(
+    PyMOLGlobals * G, const Isofield * field)
+{
+  const int *dim = field->dimensions;
+  auto bricks = std::make_shared<IsofieldBricks>();
+
+  for(int a = 0; a < 3; a++)
+    bricks->dim[a] = std::max(1, (dim[a] - 2) / IsofieldBrickSize + 1);
+
+  const auto bdim = bricks->dim;
+  bricks->min.resize(bdim[0] * bdim[1] * bdim[2]);
+  bricks->max.resize(bdim[0] * bdim[1] * bdim[2]);
+
+  pymol::parallel_for(G, bdim[0], 1,
+      [&](std::size_t begin, std::size_t end, unsigned) {
+        for(int ba = begin; ba != int(end); ba++)
+          for(int bb = 0; bb < bdim[1]; bb++)
+            for(int bc = 0; bc < bdim[2]; bc++)
+              IsofieldBrickFromData(field, bricks.get(), ba, bb, bc);
+      });
+
+  return bricks;
+}
+
+/**
+ * Recompute the bricks which overlap the newly decoded `decoded` blocks,
+ * instead of scanning the whole field again. The bricks are copied, running
+ * contouring tasks keep the ones they hold. If a concurrent call replaced
+ * the bricks in the meantime, start over from its result.
+ */
+static void IsofieldUpdateBricks(const Isofield * field,
+    const std::vector<std::array<int, 3>>& decoded)
+{
+  std::shared_ptr<const IsofieldBricks> current;
+  {
+    std::lock_guard<std::mutex> lock(IsofieldBricksMutex);
+    current = field->bricks;
+  }
+
+  while(current) {
+    auto bricks = std::make_shared<IsofieldBricks>(*current);
+
+    for(const auto& block : decoded) {
+      int bmin[3], bmax[3];
+      for(int a = 0; a < 3; a++) {
+        // brick n spans grid points [n * size, (n + 1) * size]
+        const int lo = block[a] * IsofieldBlockSize;
+        const int hi = std::min(lo + IsofieldBlockSize, field->dimensions[a]);
+        bmin[a] = std::max(lo - 1, 0) / IsofieldBrickSize;
+        bmax[a] = std::min((hi - 1) / IsofieldBrickSize, bricks->dim[a] - 1);
+      }
+      for(int ba = bmin[0]; ba <= bmax[0]; ba++)
+        for(int bb = bmin[1]; bb <= bmax[1]; bb++)
+          for(int bc = bmin[2]; bc <= bmax[2]; bc++)
+            IsofieldBrickFromData(field, bricks.get(), ba, bb, bc);
+    }
+
+    std::lock_guard<std::mutex> lock(IsofieldBricksMutex);
+    if(field->bricks == current) {
+      field->bricks = std::move(bricks);
+      return;
+    }
+    current = field->bricks;
+  }
+}
+
+void IsofieldComputeBricks(PyMOLGlobals * G, Isofield * field)
+{
+  if(field->data_exposed)
+    return;
+  auto bricks = IsofieldBricksFromData(G, field);
+  std::lock_guard<std::mutex> lock(IsofieldBricksMutex);
+  field->bricks = std::move(bricks);
+}
+
+/**
+ * Bricks of `field`, computed if missing. Safe to call from concurrent
+ * tasks contouring the same field. The computation runs unlocked (it uses
+ * the task pool, whose waits may run other contouring tasks), so it may
+ * happen twice, but the first result is kept. The caller shares ownership,
+ * so decoding more of the field (which resets the bricks) doesn't pull
+ * them out from under a running task.
+ * @return nullptr if the data is exposed for writing
+ */
+static std::shared_ptr<const IsofieldBricks> IsofieldGetBricks(
+    PyMOLGlobals * G, Isofield * field)
+{
+  if(field->data_exposed)
+    return nullptr;
+  {
+    std::lock_guard<std::mutex> lock(IsofieldBricksMutex);
+    if(field->bricks)
+      return field->bricks;
+  }
+  auto bricks = IsofieldBricksFromData(G, field);
+  std::lock_guard<std::mutex> lock(IsofieldBricksMutex);
+  if(!field->bricks)
+    field->bricks = std::move(bricks);
+  return field->bricks;
+}
+
+
+/*===========================================================================*/
+IsofieldBlocks::IsofieldBlocks(const int* field_dims)
+{
+  for(int a = 0; a < 3; a++)
+    dim[a] = (field_dims[a] + IsofieldBlockSize - 1) / IsofieldBlockSize;
+  const size_t n = size_t(dim[0]) * dim[1] * dim[2];
+  state.reset(new std::atomic<unsigned char>[n]);
+  for(size_t i = 0; i != n; ++i)
+    state[i] = Pending;
+}
+
+IsofieldBlocks::IsofieldBlocks(const IsofieldBlocks& other)
+{
+  std::copy_n(other.dim, 3, dim);
+  const size_t n = size_t(dim[0]) * dim[1] * dim[2];
+  state.reset(new std::atomic<unsigned char>[n]);
+  for(size_t i = 0; i != n; ++i)
+    state[i] = other.state[i] == Decoded ? Decoded : Pending;
+}
+
+/**
+ * True if all grid points in [min, max) are decoded
+ */
+bool IsofieldBlocks::decoded(const int* min, const int* max) const
+{
+  for(int a = min[0] / IsofieldBlockSize; a <= (max[0] - 1) / IsofieldBlockSize; a++)
+    for(int b = min[1] / IsofieldBlockSize; b <= (max[1] - 1) / IsofieldBlockSize; b++)
+      for(int c = min[2] / IsofieldBlockSize; c <= (max[2] - 1) / IsofieldBlockSize; c++)
+        if(at(a, b, c).load(std::memory_order_acquire) != Decoded)
+          return false;
+  return true;
+}
+
+/**
+ * Decode the grid points in `range` (min[3], exclusive max[3], or null for
+ * the whole field) of a lazily decoded field. No-op for other fields.
+ * Doesn't change the content of the field, so `field` may be const.
+ *
+ * Safe to call from concurrent tasks. Every block is claimed and decoded
+ * within one task, which never waits on the task pool while it holds the
+ * claim. Waiting for blocks claimed by another call therefore can't wait
+ * for a task suspended underneath the waiting one.
+ */
+void IsofieldDecode(PyMOLGlobals * G, const Isofield * field, const int * range)
+{
+  if(!field->source)
+    return;
+
+  auto& blocks = *field->blocks;
+  int bmin[3], bmax[3];
+  for(int a = 0; a < 3; a++) {
+    const int dim = field->dimensions[a];
+    const int lo = range ? std::max(range[a], 0) : 0;
+    const int hi = range ? std::min(range[a + 3], dim) : dim;
+    if(lo >= hi)
+      return;
+    bmin[a] = lo / IsofieldBlockSize;
+    bmax[a] = (hi - 1) / IsofieldBlockSize + 1;
+  }
+
+  std::vector<std::array<int, 3>> pending;
+  for(int a = bmin[0]; a < bmax[0]; a++)
+    for(int b = bmin[1]; b < bmax[1]; b++)
+      for(int c = bmin[2]; c < bmax[2]; c++)
+        if(blocks.at(a, b, c).load(std::memory_order_acquire) !=
+            IsofieldBlocks::Decoded)
+          pending.push_back({a, b, c});
+
+  if(pending.empty())
+    return;
+
+  if(!field->source->valid()) {
+    PRINTFB(G, FB_Isomesh, FB_Errors)
+      " Isofield-Error: map file changed since loading, please reload it.\n"
+      ENDFB(G);
+  }
+
+  // claimed by this call
+  std::vector<char> decoded(pending.size(), false);
+
+  pymol::parallel_for(G, pending.size(), 1,
+      [&](std::size_t begin, std::size_t end, unsigned) {
+        for(std::size_t i = begin; i != end; ++i) {
+          const auto& block = pending[i];
+          auto& state = blocks.at(block[0], block[1], block[2]);
+          unsigned char expected = IsofieldBlocks::Pending;
+          if(!state.compare_exchange_strong(expected, IsofieldBlocks::Decoding))
+            continue;
+
+          int min[3], max[3];
+          for(int a = 0; a < 3; a++) {
+            min[a] = block[a] * IsofieldBlockSize;
+            max[a] = std::min(min[a] + IsofieldBlockSize, field->dimensions[a]);
+          }
+          field->source->decode(field, min, max);
+          state.store(IsofieldBlocks::Decoded, std::memory_order_release);
+          decoded[i] = true;
+        }
+      });
+
+  // blocks claimed by concurrent calls
+  for(const auto& block : pending) {
+    while(blocks.at(block[0], block[1], block[2]).load(std::memory_order_acquire) !=
+        IsofieldBlocks::Decoded)
+      std::this_thread::yield();
+  }
+
+  std::vector<std::array<int, 3>> updated;
+  for(std::size_t i = 0; i != pending.size(); ++i)
+    if(decoded[i])
+      updated.push_back(pending[i]);
+
+  if(!updated.empty() && !field->data_exposed)
+    IsofieldUpdateBricks(field, updated);
+}
+
+
 /*===========================================================================*/
 Isofield::Isofield(PyMOLGlobals * G, const int * const dims)
 {
@@ -348,6 +631,34 @@ Isofield::Isofield(PyMOLGlobals * G, const int * const dims)
   std::copy_n(dims, 3, dimensions);
 }
 
+/**
+ * Lazily decoded field. The data isn't committed to memory until blocks of
+ * it are decoded. The corner points are decoded right away, since the range
+ * and extent functions read them.
+ */
+Isofield::Isofield(PyMOLGlobals * G, const int * const dims,
+    std::shared_ptr<const IsofieldSource> source_)
+{
+  int dim4[4];
+  std::copy_n(dims, 3, dim4);
+  dim4[3] = 3;
+
+  data.reset(new CFieldTyped<float>(dims, 3, false));
+  points.reset(new CFieldTyped<float>(dim4, 4, false));
+  std::copy_n(dims, 3, dimensions);
+  blocks.reset(new IsofieldBlocks(dims));
+  source = std::move(source_);
+
+  for(int i = 0; i < 8; i++) {
+    int range[6];
+    for(int a = 0; a < 3; a++) {
+      range[a] = ((i >> a) & 1) ? dims[a] - 1 : 0;
+      range[a + 3] = range[a] + 1;
+    }
+    IsofieldDecode(G, this, range);
+  }
+}
+
 /*===========================================================================*/
 static void IsosurfCode(CIsosurf * II, const char *bits1, const char *bits2)
 {
@@ -493,8 +804,8 @@ int IsosurfInit(PyMOLGlobals * G)
 
 
 /*===========================================================================*/
-int IsosurfExpand(Isofield * field1, Isofield * field2, CCrystal * cryst,
-                  CSymmetry * sym, int *range)
+int IsosurfExpand(PyMOLGlobals * G, Isofield * field1, Isofield * field2,
+                  CCrystal * cryst, CSymmetry * sym, int *range)
 {
   float rmn[3], rmx[3];
   float imn[3], imx[3];
@@ -503,6 +814,8 @@ int IsosurfExpand(Isofield * field1, Isofield * field2, CCrystal * cryst,
   int expanded = false;
   int missing = false;
 
+  IsofieldDecode(G, field1);
+
   field1max[0] = field1->dimensions[0] - 1;
   field1max[1] = field1->dimensions[1] - 1;
   field1max[2] = field1->dimensions[2] - 1;
@@ -792,17 +1105,17 @@ int IsosurfVolume(PyMOLGlobals* G, CSetting* set1, CSetting* set2,
     int* range, cIsomeshMode mode, int skip, float alt_level)
 {
   int ok = true;
-  CIsosurf *I;
-  if(PIsGlutThread()) {
-    I = G->Isosurf;
-  } else {
-    I = IsosurfNew(G);
-  }
+
+  /* the global instance only provides the (read-only) code table, all
+     mutable state lives in local copies, so this function is re-entrant */
+  CIsosurf *I = G->Isosurf;
   CHECKOK(ok, I);
-  {
+  if(ok) {
+    CIsosurf local = *I;
+    I = &local;
+
     int Steps[3];
-    int c, i, j, k;
-    int x, y, z;
+    int c;
     int range_store[6];
     I->Num = std::addressof(num);
     I->Line = std::addressof(vert);
@@ -827,8 +1140,9 @@ int IsosurfVolume(PyMOLGlobals* G, CSetting* set1, CSetting* set2,
     I->Coord = field->points.get();
     I->Data = field->data.get();
     I->Level = level;
-    if(ok)
-      ok = IsosurfAlloc(G, I);
+    I->VertexCodes = NULL;
+    I->ActiveEdges = NULL;
+    I->Point = NULL;
 
     I->NLine = 0;
     I->NSeg = 0;
@@ -838,54 +1152,14 @@ int IsosurfVolume(PyMOLGlobals* G, CSetting* set1, CSetting* set2,
     if(ok) {
       switch (mode) {
       case cIsomeshMode::gradient:
-        ok = IsosurfGradients(G, set1, set2, I, field, range, level, alt_level);
+        ok = IsosurfAlloc(G, I);
+        if(ok)
+          ok = IsosurfGradients(G, set1, set2, I, field, range, level, alt_level);
         IsosurfPurge(I);
         break;
       default:
-        for(i = 0; i < Steps[0]; i++) {
-          for(j = 0; j < Steps[1]; j++) {
-            for(k = 0; k < Steps[2]; k++) {
-              if(ok) {
-                I->CurOff[0] = IsosurfSubSize * i;
-                I->CurOff[1] = IsosurfSubSize * j;
-                I->CurOff[2] = IsosurfSubSize * k;
-                for(c = 0; c < 3; c++)
-                  I->CurOff[c] += range[c];
-                for(c = 0; c < 3; c++) {
-                  I->Max[c] = range[3 + c] - I->CurOff[c];
-                  if(I->Max[c] > (IsosurfSubSize + 1))
-                    I->Max[c] = (IsosurfSubSize + 1);
-                }
-                if(!(i || j || k)) {
-                  for(x = 0; x < I->Max[0]; x++)
-                    for(y = 0; y < I->Max[1]; y++)
-                      for(z = 0; z < I->Max[2]; z++)
-                        for(c = 0; c < 3; c++)
-                          EdgePt(I->Point, x, y, z, c).NLink = 0;
-                }
-#ifdef Trace
-                for(c = 0; c < 3; c++)
-                  printf(" IsosurfVolume: c: %i CurOff[c]: %i Max[c] %i\n", c,
-                         I->CurOff[c], I->Max[c]);
-#endif
-
-                if(ok)
-                  switch (mode) {
-                  case cIsomeshMode::isomesh:      /* standard mode - want lines */
-                    ok = IsosurfCurrent(I);
-                    break;
-                  case cIsomeshMode::isodot:      /* point mode - just want points on the isosurface */
-                    ok = IsosurfPoints(I);
-                    break;
-                  }
-                if(G->Interrupt) {
-                  ok = false;
-                }
-              }
-            }
-          }
-        }
-        IsosurfPurge(I);
+        IsofieldDecode(G, field, range);
+        ok = IsosurfTiles(G, I, IsofieldGetBricks(G, field).get(), range, Steps, mode);
         break;
       }
     }
@@ -907,12 +1181,178 @@ int IsosurfVolume(PyMOLGlobals* G, CSetting* set1, CSetting* set2,
     I->Line->resize(I->NLine * 3);
     I->Num->resize(I->NSeg + 1);
     (*I->Num)[I->NSeg] = 0;        /* important - must terminate the segment list */
+  }
+  return (ok);
+}
+
+
+/*===========================================================================*/
+/**
+ * Contours the sub-blocks (tiles) of `range` in parallel. Tiles don't share
+ * any state, every worker has its own scratch fields and every tile its own
+ * output arrays. The outputs are appended to I->Line and I->Num in tile
+ * order, so the result is the same for any number of threads.
+ *
+ * Tiles (or parts of them) without any brick which may contain the level
+ * are skipped.
+ */
+static int IsosurfTiles(PyMOLGlobals * G, CIsosurf * I,
+                        const IsofieldBricks * bricks, const int *range,
+                        const int *Steps, cIsomeshMode mode)
+{
+  const int n_tiles = Steps[0] * Steps[1] * Steps[2];
+
+  struct TileOutput {
+    pymol::vla<int> num;
+    pymol::vla<float> line;
+    int n_seg = 0;
+    int n_line = 0;
+  };
+
+  std::vector<TileOutput> tiles(n_tiles);
+  std::vector<CIsosurf> contexts(pymol::parallel_workers(G), *I);
+  std::atomic<bool> failed{false};
+
+  pymol::parallel_for(G, n_tiles, 1,
+      [&](std::size_t begin, std::size_t end, unsigned worker) {
+        CIsosurf *W = &contexts[worker];
+
+        if(!W->VertexCodes && !IsosurfAlloc(G, W)) {
+          failed = true;
+          return;
+        }
+
+        for(std::size_t t = begin; t != end && !failed; ++t) {
+          const int i = t / (Steps[1] * Steps[2]);
+          const int j = (t / Steps[2]) % Steps[1];
+          const int k = t % Steps[2];
+          int c;
+
+          W->CurOff[0] = IsosurfSubSize * i;
+          W->CurOff[1] = IsosurfSubSize * j;
+          W->CurOff[2] = IsosurfSubSize * k;
+          for(c = 0; c < 3; c++)
+            W->CurOff[c] += range[c];
+          for(c = 0; c < 3; c++) {
+            W->Max[c] = range[3 + c] - W->CurOff[c];
+            if(W->Max[c] > (IsosurfSubSize + 1))
+              W->Max[c] = (IsosurfSubSize + 1);
+          }
+#ifdef Trace
+          for(c = 0; c < 3; c++)
+            printf(" IsosurfVolume: c: %i CurOff[c]: %i Max[c] %i\n", c,
+                   W->CurOff[c], W->Max[c]);
+#endif
+
+          if(bricks && !IsosurfClipTile(W, bricks))
+            continue;
+
+          auto& tile = tiles[t];
+          tile.num = pymol::vla<int>(1);
+          tile.line = pymol::vla<float>(300);
+          W->Num = std::addressof(tile.num);
+          W->Line = std::addressof(tile.line);
+          W->NLine = 0;
+          W->NSeg = 0;
+
+          int ok = true;
+          switch (mode) {
+          case cIsomeshMode::isomesh:      /* standard mode - want lines */
+            ok = IsosurfCurrent(W);
+            break;
+          case cIsomeshMode::isodot:      /* point mode - just want points on the isosurface */
+            ok = IsosurfPoints(W);
+            break;
+          default:
+            break;
+          }
+          if(!ok || G->Interrupt) {
+            failed = true;
+          }
+
+          tile.n_seg = W->NSeg;
+          tile.n_line = W->NLine;
+        }
+      });
+
+  for(auto& W : contexts) {
+    IsosurfPurge(&W);
+  }
+
+  if(failed) {
+    return false;
+  }
+
+  /* concatenate in tile order */
+  for(auto& tile : tiles) {
+    if(!tile.n_seg)
+      continue;
+    I->Line->check((I->NLine + tile.n_line) * 3);
+    std::copy_n(tile.line.data(), tile.n_line * 3,
+        I->Line->data() + I->NLine * 3);
+    I->Num->check(I->NSeg + tile.n_seg);
+    std::copy_n(tile.num.data(), tile.n_seg, I->Num->data() + I->NSeg);
+    I->NLine += tile.n_line;
+    I->NSeg += tile.n_seg;
+  }
+  (*I->Num)[I->NSeg] = I->NLine;
+
+  return true;
+}
+
+
+/*===========================================================================*/
+/**
+ * Shrinks the current tile to the bricks which may contain the level. The
+ * relative order of the remaining points doesn't change, so neither does
+ * the output. With mesh skipping, the planes to draw depend on the tile
+ * offset, in that case the tile is only tested but not shrunk.
+ *
+ * @return false if no brick of the tile may contain the level
+ */
+static bool IsosurfClipTile(CIsosurf * I, const IsofieldBricks * bricks)
+{
+  int lo[3], hi[3], blo[3], bhi[3];
+  int amin[3] = {INT_MAX, INT_MAX, INT_MAX};
+  int amax[3] = {-1, -1, -1};
+  int c;
+
+  /* every cell of the tile is inside of one of these bricks */
+  for(c = 0; c < 3; c++) {
+    lo[c] = I->CurOff[c];
+    hi[c] = I->CurOff[c] + I->Max[c] - 1;
+    blo[c] = std::min(lo[c] / IsofieldBrickSize, bricks->dim[c] - 1);
+    bhi[c] = std::min(std::max(lo[c], hi[c] - 1) / IsofieldBrickSize,
+                      bricks->dim[c] - 1);
+  }
 
-    if(!PIsGlutThread()) {
-      _IsosurfFree(I);
+  for(int ba = blo[0]; ba <= bhi[0]; ba++) {
+    for(int bb = blo[1]; bb <= bhi[1]; bb++) {
+      for(int bc = blo[2]; bc <= bhi[2]; bc++) {
+        if(bricks->active(ba, bb, bc, I->Level)) {
+          int b[3] = {ba, bb, bc};
+          for(c = 0; c < 3; c++) {
+            amin[c] = std::min(amin[c], b[c]);
+            amax[c] = std::max(amax[c], b[c]);
+          }
+        }
+      }
     }
   }
-  return (ok);
+
+  if(amax[0] < 0)
+    return false;
+
+  if(!I->Skip) {
+    for(c = 0; c < 3; c++) {
+      int new_lo = std::max(lo[c], amin[c] * IsofieldBrickSize);
+      int new_hi = std::min(hi[c], (amax[c] + 1) * IsofieldBrickSize);
+      I->CurOff[c] = new_lo;
+      I->Max[c] = new_hi - new_lo + 1;
+    }
+  }
+
+  return true;
 }
 
 
@@ -27,14 +27,94 @@ Z* -------------------------------------------------------------------
 #include"PyMOLEnums.h"
 #include"Setting.h"
 
+#include <atomic>
+#include <memory>
+#include <vector>
+
+/**
+ * Data range of every brick of (IsofieldBrickSize + 1)^3 grid points.
+ * Neighboring bricks share their boundary points, so every cell lies
+ * completely inside of one brick, and a brick can only contain a contour
+ * at `level` if min <= level < max.
+ */
+struct IsofieldBricks {
+  int dim[3]{};
+  std::vector<float> min, max;
+
+  bool active(int a, int b, int c, float level) const
+  {
+    const int i = (c * dim[1] + b) * dim[0] + a;
+    return max[i] > level && !(min[i] > level);
+  }
+};
+
+#define IsofieldBrickSize 8
+
+struct Isofield;
+
+/**
+ * Backing store of a lazily decoded Isofield, e.g. a memory mapped map file.
+ */
+struct IsofieldSource {
+  virtual ~IsofieldSource() = default;
+
+  /**
+   * Fill `data` and `points` of `field` for the grid points in [min, max).
+   * Called concurrently for disjoint boxes. If the source is not `valid`,
+   * `data` is filled with NaN.
+   */
+  virtual void decode(const Isofield* field, const int* min, const int* max) const = 0;
+
+  /// False if the backing store changed since the field was loaded
+  virtual bool valid() const { return true; }
+};
+
+#define IsofieldBlockSize 32
+
+/**
+ * Decoding state of every block of IsofieldBlockSize^3 grid points of a
+ * lazily decoded Isofield.
+ */
+struct IsofieldBlocks {
+  enum : unsigned char { Pending, Decoding, Decoded };
+
+  int dim[3]{};
+  std::unique_ptr<std::atomic<unsigned char>[]> state;
+
+  IsofieldBlocks(const int* field_dims);
+  IsofieldBlocks(const IsofieldBlocks& other);
+
+  std::atomic<unsigned char>& at(int a, int b, int c) const
+  {
+    return state[(a * dim[1] + b) * dim[2] + c];
+  }
+
+  bool decoded(const int* min, const int* max) const;
+};
+
 struct Isofield {
   int dimensions[3]{};
   int save_points = true;
   pymol::copyable_ptr<CField> points;
   pymol::copyable_ptr<CField> data;
   pymol::cache_ptr<CField> gradients;
+  //! reset when `data` changes, shared with running contour tasks
+  mutable std::shared_ptr<const IsofieldBricks> bricks;
+  //! `data` may be written through a view (get_volume_field copy=0) at any
+  //! time, so `bricks` can't be trusted and isn't used
+  bool data_exposed = false;
+
+  /**
+   * If not null, `data` and `points` are only valid for the decoded
+   * `blocks`. Code which reads them must call IsofieldDecode first.
+   */
+  std::shared_ptr<const IsofieldSource> source;
+  pymol::copyable_ptr<IsofieldBlocks> blocks;
+
   Isofield() = default;
   Isofield(PyMOLGlobals * G, const int * const dims);
+  Isofield(PyMOLGlobals * G, const int * const dims,
+      std::shared_ptr<const IsofieldSource> source);
 };
 
 int IsosurfVolume(PyMOLGlobals* G, CSetting* set1, CSetting* set2,
@@ -43,7 +123,7 @@ int IsosurfVolume(PyMOLGlobals* G, CSetting* set1, CSetting* set2,
 
 int IsosurfGetRange(PyMOLGlobals * G, Isofield * field, CCrystal * cryst,
                     float *mn, float *mx, int *range, int clamp);
-int IsosurfExpand(Isofield * field1, Isofield * field2,
+int IsosurfExpand(PyMOLGlobals * G, Isofield * field1, Isofield * field2,
                   CCrystal * cryst, CSymmetry * sym, int *range);
 
 int IsosurfInit(PyMOLGlobals * G);
@@ -52,7 +132,9 @@ void IsosurfFree(PyMOLGlobals * G);
 
 /* isofield operations -- not part of Isosurf */
 
+void IsofieldDecode(PyMOLGlobals * G, const Isofield * field, const int * range = nullptr);
 void IsofieldComputeGradients(PyMOLGlobals * G, Isofield * field);
+void IsofieldComputeBricks(PyMOLGlobals * G, Isofield * field);
 PyObject *IsosurfAsPyList(PyMOLGlobals *G, Isofield * I);
 Isofield *IsosurfNewFromPyList(PyMOLGlobals * G, PyObject * list);
 
@@ -27,6 +27,10 @@ Z* ------------------------------------------------------------------- */
 #include"Base.h"
 
 #include "pymol/algorithm.h"
+#include "TaskPool.h"
+
+#include <algorithm>
+#include <vector>
 
 static MapType *_MapNew(PyMOLGlobals * G, float range, const float *vert, int nVert,
                         const float *extent, const int *flag, int group_id, int block_id);
@@ -362,16 +366,143 @@ int MapSetupExpressXYVert(MapType * I, float *vert, int n_vert, int negative_sta
   return ok;
 }
 
+/**
+ * Calls `fn(i)` for the points in the 27 cells around cell (a,b,c), in the
+ * same order as walking the Head/Link chains of the cells with d, e, f
+ * ascending. With a `spanner` array, points of the layers c-1 and c+1 are
+ * only included if they are voxel spanners.
+ */
+template <typename Func>
+static void MapForEachAround(const MapType* I, int a, int b, int c,
+    const int* spanner, Func&& fn)
+{
+  const int* start = I->CellStart.data();
+  const int* items = I->CellItems.data();
+  for(int d = a - 1; d <= a + 1; d++) {
+    for(int e = b - 1; e <= b + 1; e++) {
+      /* cells (d,e,c-1) to (d,e,c+1) */
+      const int* s = start + d * I->D1D2 + e * I->Dim[2] + c;
+      for(int f = -1; f <= 1; f++) {
+        for(int j = s[f]; j < s[f + 1]; j++) {
+          if(!spanner || !f || spanner[items[j]])
+            fn(items[j]);
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Number of points MapForEachAround would visit.
+ * @param[out] flag True if any of the 27 cells is occupied (even if no
+ * point passed the spanner test)
+ */
+static int MapCountAround(const MapType* I, int a, int b, int c,
+    const int* spanner, bool* flag)
+{
+  const int* start = I->CellStart.data();
+  const int* items = I->CellItems.data();
+  int count = 0;
+  *flag = false;
+  for(int d = a - 1; d <= a + 1; d++) {
+    for(int e = b - 1; e <= b + 1; e++) {
+      const int* s = start + d * I->D1D2 + e * I->Dim[2] + c;
+      if(s[-1] == s[2])
+        continue;
+      *flag = true;
+      if(!spanner) {
+        count += s[2] - s[-1];
+        continue;
+      }
+      count += s[1] - s[0];
+      for(int j = s[-1]; j < s[0]; j++)
+        count += (spanner[items[j]] != 0);
+      for(int j = s[1]; j < s[2]; j++)
+        count += (spanner[items[j]] != 0);
+    }
+  }
+  return count;
+}
+
+/**
+ * Builds EHead/EList from the cell-sorted lists, for all cells from `lo` to
+ * `hi` (inclusive). The express list of a cell holds the points of the 27
+ * surrounding cells. Rows of the grid are processed in parallel, in two
+ * passes (count, fill), so the result does not depend on the number of
+ * threads.
+ * @param negative_start Store negative EList start indices
+ * @param spanner Optional voxel spanner flags, see MapForEachAround
+ * @return Number of EList elements (including the unused first one), or 0
+ * on failure
+ */
+static int MapExpressFill(MapType* I, const int* lo, const int* hi,
+    int negative_start, const int* spanner)
+{
+  PyMOLGlobals* G = I->G;
+  const int n_b = hi[1] - lo[1] + 1;
+  const int n_rows = (hi[0] - lo[0] + 1) * n_b;
+  const int grain = 64;
+
+  /* first pass: list size per cell, plus the terminator */
+  pymol::parallel_for(G, n_rows, grain, [&](std::size_t begin, std::size_t end, unsigned) {
+    for(auto row = begin; row < end; ++row) {
+      const int a = lo[0] + row / n_b, b = lo[1] + row % n_b;
+      int* ptr = MapEStart(I, a, b, lo[2]);
+      for(int c = lo[2]; c <= hi[2]; c++, ptr++) {
+        bool flag;
+        const int count = MapCountAround(I, a, b, c, spanner, &flag);
+        *ptr = flag ? count + 1 : 0;
+      }
+    }
+  });
+
+  if(G->Interrupt)
+    return 0;
+
+  /* start indices, in grid order */
+  int n = 1;
+  for(int a = lo[0]; a <= hi[0]; a++) {
+    for(int b = lo[1]; b <= hi[1]; b++) {
+      int* ptr = MapEStart(I, a, b, lo[2]);
+      for(int c = lo[2]; c <= hi[2]; c++, ptr++) {
+        if(const int size = *ptr) {
+          *ptr = negative_start ? -n : n;
+          n += size;
+        }
+      }
+    }
+  }
+
+  I->EList = (int*) VLACacheMalloc(G, n, sizeof(int), ELIST_GROW_FACTOR, 0,
+      I->group_id, I->block_base + cCache_map_elist_offset);
+  if(!I->EList)
+    return 0;
+
+  /* second pass: fill */
+  int* elist = I->EList;
+  pymol::parallel_for(G, n_rows, grain, [&](std::size_t begin, std::size_t end, unsigned) {
+    for(auto row = begin; row < end; ++row) {
+      const int a = lo[0] + row / n_b, b = lo[1] + row % n_b;
+      for(int c = lo[2]; c <= hi[2]; c++) {
+        int k = abs(*(MapEStart(I, a, b, c)));
+        if(!k)
+          continue;
+        MapForEachAround(I, a, b, c, spanner, [&](int i) { elist[k++] = i; });
+        elist[k] = -1;
+      }
+    }
+  });
+
+  return n;
+}
+
 int MapSetupExpressPerp(MapType * I, const float *vert, float front, int nVertHint,
 			int negative_start, const int *spanner)
 {
   PyMOLGlobals *G = I->G;
   int n = 0;
-  int a, b, c, i;
 
   unsigned int mapSize;
-  int st;
-  int n_alloc = nVertHint * 15; /* emprical est. */
   int ok = true;
 
   int iMin0 = I->iMin[0];
@@ -383,7 +514,7 @@ int MapSetupExpressPerp(MapType * I, const float *vert, float front, int nVertHi
   float min1 = I->Min[1] * iDiv;
   float base0, base1;
   float perp_factor, premult;
-  int *emask, dim1, *link, *ptr1, *ptr2;
+  int d, e, *emask, dim1, *ptr1, *ptr2;
 
   PRINTFD(G, FB_Map)
     " MapSetupExpress-Debug: entered.\n" ENDFD;
@@ -392,10 +523,6 @@ int MapSetupExpressPerp(MapType * I, const float *vert, float front, int nVertHi
   I->EHead = CacheCalloc(G, int, mapSize,
                          I->group_id, I->block_base + cCache_map_ehead_offset);
   CHECKOK(ok, I->EHead);
-  if (ok)
-    I->EList = (int*) VLACacheMalloc(G, n_alloc, sizeof(int), ELIST_GROW_FACTOR, 0,
-			      I->group_id, I->block_base + cCache_map_elist_offset);
-  CHECKOK(ok, I->EList);
   if (ok)
     I->EMask = CacheCalloc(G, int, I->Dim[0] * I->Dim[1],
 			   I->group_id, I->block_base + cCache_map_emask_offset);
@@ -403,107 +530,58 @@ int MapSetupExpressPerp(MapType * I, const float *vert, float front, int nVertHi
 
   emask = I->EMask;
   dim1 = I->Dim[1];
-  link = I->Link;
   premult = -front * iDiv;
 
-  n = 1;
-  for(a = (iMin0 - 1); ok && a <= (iMax0 + 1); a++)
-    for(b = (iMin1 - 1); ok && b <= (iMax1 + 1); b++)
-      for(c = (I->iMin[2] - 1); ok && c <= (I->iMax[2] + 1); c++) {
-
-        int d, e, f;
+  /* compute a "shadow" mask for all vertices */
+  for(int j = 0, n_items = I->CellItems.size(); ok && j < n_items; j++) {
+    const float* v0 = vert + 3 * I->CellItems[j];
+    perp_factor = premult / v0[2];
+    base0 = v0[0] * perp_factor;
+    base1 = v0[1] * perp_factor;
 
-        /* compute a "shadow" mask for all vertices */
+    d = (int) (base0 - min0);
+    e = (int) (base1 - min1);
 
-        i = *MapFirst(I, a, b, c);
-        while(i >= 0) {
-          const float* v0 = vert + 3 * i;
-          perp_factor = premult / v0[2];
-          base0 = v0[0] * perp_factor;
-          base1 = v0[1] * perp_factor;
+    d += MapBorder;
+    e += MapBorder;
 
-          d = (int) (base0 - min0);
-          e = (int) (base1 - min1);
-
-          d += MapBorder;
-          e += MapBorder;
+    if(d < iMin0) {
+      d = iMin0;
+    } else if(d > iMax0) {
+      d = iMax0;
+    }
 
-          if(d < iMin0) {
-            d = iMin0;
-          } else if(d > iMax0) {
-            d = iMax0;
-          }
+    if(e < iMin1) {
+      e = iMin1;
+    } else if(e > iMax1) {
+      e = iMax1;
+    }
+    ptr2 = (ptr1 = emask + dim1 * (d - 1) + (e - 1));
+    *(ptr2++) = true;
+    *(ptr2++) = true;
+    *(ptr2++) = true;
+    ptr2 = (ptr1 += dim1);
+    *(ptr2++) = true;
+    *(ptr2++) = true;
+    *(ptr2++) = true;
+    ptr2 = (ptr1 += dim1);
+    *(ptr2++) = true;
+    *(ptr2++) = true;
+    *(ptr2++) = true;
+  }
 
-          if(e < iMin1) {
-            e = iMin1;
-          } else if(e > iMax1) {
-            e = iMax1;
-          }
-          i = link[i];
-          ptr2 = (ptr1 = emask + dim1 * (d - 1) + (e - 1));
-          *(ptr2++) = true;
-          *(ptr2++) = true;
-          *(ptr2++) = true;
-          ptr2 = (ptr1 += dim1);
-          *(ptr2++) = true;
-          *(ptr2++) = true;
-          *(ptr2++) = true;
-          ptr2 = (ptr1 += dim1);
-          *(ptr2++) = true;
-          *(ptr2++) = true;
-          *(ptr2++) = true;
-        }
+  if(ok) {
+    const int lo[3] = {iMin0 - 1, iMin1 - 1, I->iMin[2] - 1};
+    const int hi[3] = {iMax0 + 1, iMax1 + 1, I->iMax[2] + 1};
+    /* for non-voxel-spanners, only spread in the XY plane (memory use ~ 9X instead of 27X -- a big difference!) */
+    n = MapExpressFill(I, lo, hi, negative_start, spanner);
+    ok = (n != 0);
+  }
 
-        {
-          const int am1 = a - 1, ap1 = a + 1, bm1 = b - 1, bp1 = b + 1, cm1 = c - 1, cp1 =
-            c + 1;
-          const int dim2 = I->Dim[2];
-          int flag = false;
-          int *hPtr1 = I->Head + ((am1) * I->D1D2) + ((bm1) * dim2) + cm1;
-          st = n;
-          for(d = am1; ok && d <= ap1; d++) {
-            int *hPtr2 = hPtr1;
-            for(e = bm1; ok && e <= bp1; e++) {
-              int *hPtr3 = hPtr2;
-              for(f = cm1; ok && f <= cp1; f++) {
-                i = *(hPtr3++);
-                /*                i=*MapFirst(I,d,e,f); */
-                if(i >= 0) {
-                  flag = true;
-                  while(ok && i >= 0) {
-                    if((!spanner) || (f == c) || spanner[i]) {
-                      /* for non-voxel-spanners, only spread in the XY plane (memory use ~ 9X instead of 27X -- a big difference!) */
-                      VLACacheCheck(G, I->EList, int, n, I->group_id,
-                                    I->block_base + cCache_map_elist_offset);
-		      CHECKOK(ok, I->EList);
-                      I->EList[n] = i;
-                      n++;
-                    }
-                    i = link[i];
-                  }
-                }
-              }
-              hPtr2 += dim2;
-            }
-            hPtr1 += I->D1D2;
-          }
-          if(ok && flag) {
-            *(MapEStart(I, a, b, c)) = negative_start ? -st : st;
-            VLACacheCheck(G, I->EList, int, n, I->group_id,
-                          I->block_base + cCache_map_elist_offset);
-	    CHECKOK(ok, I->EList);
-            I->EList[n] = -1;
-            n++;
-          }
-        }
-      }
   PRINTFB(G, FB_Map, FB_Blather)
     " MapSetupExpressPerp: %d rows in express table \n", n ENDFB(G);
   if (ok){
     I->NEElem = n;
-    VLACacheSize(G, I->EList, int, I->NEElem, I->group_id,
-		 I->block_base + cCache_map_elist_offset);
-    CHECKOK(ok, I->EList);
   }
   PRINTFD(G, FB_Map)
     " MapSetupExpress-Debug: leaving...n=%d\n", n ENDFD;
@@ -514,13 +592,6 @@ int MapSetupExpress(MapType * I)
 {                               /* setup a list of neighbors for each square */
   PyMOLGlobals *G = I->G;
   int n = 0;
-  int c, d, e, f, i, cm1, cp2, D1D2 = I->D1D2, D2 = I->Dim[2];
-  int mx2 = I->iMax[2];
-  int *link = I->Link;
-  int st, flag;
-  int *i_ptr3, *i_ptr4, *i_ptr5;
-  int *e_list = NULL;
-  int mx0 = I->iMax[0], mx1 = I->iMax[1], a, am1, ap2, *i_ptr1, b, bm1, bp2, *i_ptr2;
   unsigned int mapSize;
   int ok = true;
 
@@ -529,69 +600,16 @@ int MapSetupExpress(MapType * I)
 
   mapSize = I->Dim[0] * I->Dim[1] * I->Dim[2];
   I->EHead =
-    CacheCalloc(G, int, mapSize, group_id, I->block_base + cCache_map_ehead_offset);
+    CacheCalloc(G, int, mapSize, I->group_id, I->block_base + cCache_map_ehead_offset);
   CHECKOK(ok, I->EHead);
-  if (ok)
-    e_list = (int*) VLACacheMalloc(G, 1000, sizeof(int), 5, 0, group_id, block_offset);
-  CHECKOK(ok, e_list);
 
-  n = 1;
-  for(a = (I->iMin[0] - 1); ok && a <= mx0; a++) {
-    am1 = a - 1;
-    ap2 = a + 2;
-    i_ptr1 = I->Head + am1 * D1D2;
-    for(b = (I->iMin[1] - 1); ok && b <= mx1; b++) {
-      bm1 = b - 1;
-      bp2 = b + 2;
-      i_ptr2 = i_ptr1 + bm1 * D2;
-      for(c = (I->iMin[2] - 1); ok && c <= mx2; c++) {
-        st = n;
-        cm1 = c - 1;
-        cp2 = c + 2;
-        flag = false;
-        i_ptr5 = (i_ptr4 = (i_ptr3 = i_ptr2 + cm1));
-
-        for(d = am1; ok && d < ap2; d++) {
-          for(e = bm1; ok && e < bp2; e++) {
-            for(f = cm1; ok && f < cp2; f++) {
-              /*i=*MapFirst(I,d,e,f); */
-              if((i = *(i_ptr5++)) >= 0) {
-                flag = true;
-                do {
-                  VLACacheCheck(G, e_list, int, n, group_id, block_offset);
-		  CHECKOK(ok, e_list);
-		  if (ok)
-		    e_list[n++] = i;
-                  /*i=MapNext(I,i); */
-                } while(ok && (i = link[i]) >= 0);
-              }
-	      ok &= !G->Interrupt;
-            }
-	    if (ok)
-	      i_ptr5 = (i_ptr4 += D2);
-          }
-	  if (ok)
-	    i_ptr5 = (i_ptr4 = (i_ptr3 += D1D2));
-        }
-	if (ok){
-	  if(flag) {
-	    *(MapEStart(I, a, b, c)) = st;
-	    VLACacheCheck(G, e_list, int, n, group_id, block_offset);
-	    CHECKOK(ok, e_list);
-	    e_list[n] = -1;
-	    n++;
-	  } else {
-	    *(MapEStart(I, a, b, c)) = 0;
-	  }
-	}
-      }
-    }
+  if (ok){
+    const int lo[3] = {I->iMin[0] - 1, I->iMin[1] - 1, I->iMin[2] - 1};
+    n = MapExpressFill(I, lo, I->iMax, false, nullptr);
+    ok = (n != 0);
   }
   if (ok){
-    I->EList = e_list;
     I->NEElem = n;
-    VLACacheSize(G, I->EList, int, I->NEElem, group_id, block_offset);
-    CHECKOK(ok, I->EList);
   }
   PRINTFD(G, FB_Map)
     " MapSetupExpress-Debug: leaving...n=%d\n", n ENDFD;
@@ -638,7 +656,7 @@ int *MapLocusEStart(MapType * I, const float *v)
  * @param[out] a,b,c Grid indices, but only if function returned true.
  * @return True if `v` is within grid boundaries
  */
-static bool MapExclLocus(MapType* I, const float* v, int* a, int* b, int* c)
+static bool MapExclLocus(const MapType* I, const float* v, int* a, int* b, int* c)
 {
   float invDiv = I->recipDiv;
 
@@ -759,13 +777,74 @@ MapType *MapNewFlagged(PyMOLGlobals * G, float range, const float *vert, int nVe
   return (_MapNew(G, range, vert, nVert, extent, flag, -1, 0));
 }
 
+/**
+ * Creates the 3-D hash of the vertices: the cell-sorted lists (CellStart,
+ * CellItems) and the equivalent Head/Link chains. The cell lookup and the
+ * chain setup run in parallel, the counting sort in between is serial, so
+ * the result does not depend on the number of threads.
+ * @param flag Optional inclusion flag per vertex
+ */
+static void MapHash(MapType* I, const float* vert, int nVert, const int* flag)
+{
+  PyMOLGlobals* G = I->G;
+  const int mapSize = I->Dim[0] * I->Dim[1] * I->Dim[2];
+  const std::size_t grain = 4096;
+  auto& start = I->CellStart;
+  auto& items = I->CellItems;
+
+  /* cell of each vertex, -1 if not included */
+  std::vector<int> cell(nVert);
+  pymol::parallel_for(G, nVert, grain, [&](std::size_t begin, std::size_t end, unsigned) {
+    int h, k, l;
+    for(auto a = begin; a < end; ++a) {
+      I->Link[a] = -1;
+      if((!flag || flag[a]) && MapExclLocus(I, vert + 3 * a, &h, &k, &l)) {
+        cell[a] = (h * I->D1D2) + (k * I->Dim[2]) + l;
+      } else {
+        cell[a] = -1;
+      }
+    }
+  });
+
+  /* counting sort by cell. Within a cell, vertices are in descending order,
+   * same as adding each one to the top of a linked list. */
+  start.assign(mapSize + 1, 0);
+  for(int a = 0; a < nVert; a++) {
+    if(cell[a] >= 0)
+      start[cell[a]]++;
+  }
+  int n = 0;
+  for(int c = 0; c < mapSize; c++) {
+    const int count = start[c];
+    start[c] = n;
+    n += count;
+  }
+  items.resize(n);
+  for(int a = nVert - 1; a >= 0; a--) {
+    if(cell[a] >= 0)
+      items[start[cell[a]]++] = a;
+  }
+  /* start[c] is now the end of cell c */
+  std::copy_backward(start.begin(), start.end() - 1, start.end());
+  start[0] = 0;
+
+  /* linked lists */
+  pymol::parallel_for(G, mapSize, grain, [&](std::size_t begin, std::size_t end, unsigned) {
+    for(auto c = begin; c < end; ++c) {
+      const int s = start[c], e = start[c + 1];
+      I->Head[c] = (s < e) ? items[s] : -1;
+      for(int j = s + 1; j < e; j++) {
+        I->Link[items[j - 1]] = items[j];
+      }
+    }
+  });
+}
+
 static MapType *_MapNew(PyMOLGlobals * G, float range, const float *vert, int nVert,
                         const float *extent, const int *flag, int group_id, int block_base)
 {
   int a, c;
   int mapSize;
-  int h, k, l;
-  int *list;
   const float *v;
   int firstFlag;
   Vector3f diagonal;
@@ -790,9 +869,6 @@ static MapType *_MapNew(PyMOLGlobals * G, float range, const float *vert, int nV
     MapFree(I);
     return NULL;
   }
-  for(a = 0; a < nVert; a++)
-    I->Link[a] = -1;
-
   /* map extents; set if valid, otherwise determine based on the flagged vertices */
   if(extent) {
     /* valid, so copy */
@@ -934,44 +1010,13 @@ static MapType *_MapNew(PyMOLGlobals * G, float range, const float *vert, int nV
     MapFree(I);
     return NULL;
   }
-  /* initialize */
-  /*  for(a=0;a<I->Dim[0];a++)
-     for(b=0;b<I->Dim[1];b++)
-     for(c=0;c<I->Dim[2];c++)
-     *(MapFirst(I,a,b,c))=-1; */
-
-  /* Trick for fast clearing to -1! */
-  memset(I->Head, 0xFF, mapSize * sizeof(int));
-
   I->NVert = nVert;
 
   PRINTFD(G, FB_Map)
     " MapNew-Debug: creating 3D hash...\n" ENDFD;
 
   /* create 3-D hash of the vertices */
-  if(flag) {
-    v = vert;
-    for(a = 0; a < nVert; a++) {
-      if(flag[a])
-        if(MapExclLocus(I, v, &h, &k, &l)) {
-          list = MapFirst(I, h, k, l);
-          I->Link[a] = *list;
-          *list = a;            /*add to top of list */
-        }
-      v += 3;
-    }
-  } else {
-    v = vert;
-    for(a = 0; a < nVert; a++) {
-      if(MapExclLocus(I, v, &h, &k, &l)) {
-        list = MapFirst(I, h, k, l);
-        /*        printf("LINK %d %d %d %d %5.2f %5.2f %5.2f\n",a,h,k,l,v[0],v[1],v[2]); */
-        I->Link[a] = *list;
-        *list = a;              /*add to top of list */
-      }
-      v += 3;
-    }
-  }
+  MapHash(I, vert, nVert, flag);
 
   PRINTFD(G, FB_Map)
     " MapNew-Debug: leaving...\n" ENDFD;
@@ -994,6 +1039,38 @@ MapEIter::MapEIter(MapType& map, const float* v, bool excl)
   }
 }
 
+/**
+ * Calls `fn(j)` for the map points in proximity to `v` (the same points as
+ * MapEIter, without the need for an express list), until `fn` returns true.
+ * @param excl If true, skip `v` if it's outside the grid
+ * @return True if `fn` returned true
+ */
+template <typename Func>
+static bool MapAnyAround(
+    const MapType& map, const float* v, bool excl, Func&& fn)
+{
+  int a, b, c;
+  if (excl) {
+    if (!MapExclLocus(&map, v, &a, &b, &c))
+      return false;
+  } else {
+    MapLocus(&map, v, &a, &b, &c);
+  }
+
+  const int* items = map.CellItems.data();
+  for (int d = a - 1; d <= a + 1; ++d) {
+    for (int e = b - 1; e <= b + 1; ++e) {
+      // cells (d,e,c-1) to (d,e,c+1) are one contiguous run
+      const int* s = map.CellStart.data() + d * map.D1D2 + e * map.Dim[2] + c;
+      for (int j = s[-1]; j < s[2]; ++j) {
+        if (fn(items[j]))
+          return true;
+      }
+    }
+  }
+  return false;
+}
+
 /**
  * True if `v_query` is within `cutoff` of any point in the map.
  *
@@ -1005,10 +1082,66 @@ MapEIter::MapEIter(MapType& map, const float* v, bool excl)
 bool MapAnyWithin(
     MapType& map, const float* v_map, const float* v_query, float cutoff)
 {
-  for (const auto j : MapEIter(map, v_query)) {
-    if (within3f(v_map + 3 * j, v_query, cutoff)) {
-      return true;
-    }
+  return MapAnyAround(map, v_query, true, [&](int j) {
+    return within3f(v_map + 3 * j, v_query, cutoff);
+  });
+}
+
+/**
+ * All points in the map within `cutoff` of each query point. Query points
+ * are processed in parallel chunks. The neighbors of a query point are in
+ * the same order as with MapEIter.
+ *
+ * @param map A hash map
+ * @param v_map The points used to build the map
+ * @param v_query Query points
+ * @param n_query Number of query points
+ * @param cutoff The distance cutoff (should not exceed the map range)
+ * @param[out] result Neighbor lists
+ * @param excl If true, query points outside the grid have no neighbors
+ */
+void MapNeighborsWithin(MapType& map, const float* v_map,
+    const float* v_query, int n_query, float cutoff, MapNeighborList& result,
+    bool excl)
+{
+  const std::size_t grain = 256;
+  const std::size_t n_chunks = (n_query + grain - 1) / grain;
+  std::vector<std::vector<int>> chunk_index(n_chunks);
+
+  result.start.resize(n_query + 1);
+
+  // neighbors per chunk, with chunk-relative start indices
+  pymol::parallel_for(map.G, n_query, grain,
+      [&](std::size_t begin, std::size_t end, unsigned) {
+        auto& index = chunk_index[begin / grain];
+        for (auto q = begin; q < end; ++q) {
+          const float* v = v_query + 3 * q;
+          result.start[q] = index.size();
+          MapAnyAround(map, v, excl, [&](int j) {
+            if (within3f(v_map + 3 * j, v, cutoff))
+              index.push_back(j);
+            return false;
+          });
+        }
+      });
+
+  // concatenate
+  std::vector<int> chunk_start(n_chunks + 1, 0);
+  for (std::size_t k = 0; k < n_chunks; ++k) {
+    chunk_start[k + 1] = chunk_start[k] + chunk_index[k].size();
   }
-  return false;
+  result.start[n_query] = chunk_start[n_chunks];
+  result.index.resize(chunk_start[n_chunks]);
+
+  pymol::parallel_for(map.G, n_chunks, 1,
+      [&](std::size_t begin, std::size_t end, unsigned) {
+        for (auto k = begin; k < end; ++k) {
+          const std::size_t q_end = std::min<std::size_t>((k + 1) * grain, n_query);
+          for (auto q = k * grain; q < q_end; ++q) {
+            result.start[q] += chunk_start[k];
+          }
+          std::copy(chunk_index[k].begin(), chunk_index[k].end(),
+              result.index.begin() + chunk_start[k]);
+        }
+      });
 }
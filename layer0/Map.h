@@ -24,6 +24,8 @@ Z* -------------------------------------------------------------------
 #include"Vector.h"
 #include"PyMOLGlobals.h"
 
+#include <vector>
+
 struct MapType {
   PyMOLGlobals *G;
   float Div;
@@ -42,6 +44,15 @@ struct MapType {
   int group_id;
   int block_base;
 
+  /**
+   * Compact cell-sorted (CSR) layout of the Head/Link lists: the points of
+   * cell `i` are CellItems[CellStart[i]] to CellItems[CellStart[i + 1] - 1],
+   * in the same order as the MapFirst/MapNext chain. Since the cells of a
+   * grid row are adjacent, a 3x3x3 neighborhood is 9 contiguous runs.
+   */
+  std::vector<int> CellStart;
+  std::vector<int> CellItems;
+
   ~MapType();
 };
 
@@ -132,4 +143,23 @@ public:
 bool MapAnyWithin(
     MapType& map, const float* v_map, const float* v_query, float cutoff);
 
+/**
+ * Neighbor lists for a batch of query points, in compressed sparse row
+ * layout: the neighbors of query point `q` are index[start[q]] to
+ * index[start[q + 1] - 1].
+ */
+struct MapNeighborList {
+  std::vector<int> start;
+  std::vector<int> index;
+
+  /// Number of query points
+  int size() const { return start.empty() ? 0 : int(start.size() - 1); }
+  const int* begin(int q) const { return index.data() + start[q]; }
+  const int* end(int q) const { return index.data() + start[q + 1]; }
+};
+
+void MapNeighborsWithin(MapType& map, const float* v_map,
+    const float* v_query, int n_query, float cutoff, MapNeighborList& result,
+    bool excl = true);
+
 #endif
@@ -22,6 +22,7 @@ namespace pymol
 {
 class cif_file;
 class cif_data;
+class TaskPool;
 }; // namespace pymol
 
 /* retina scale factor for ortho gui */
@@ -172,6 +173,7 @@ struct PyMOLGlobals {
   CShaderMgr* ShaderMgr;
   COpenVR* OpenVR;
   GFXManager* GFXMgr;
+  pymol::TaskPool* TaskPool;
 #ifndef _PYMOL_NOPY
   CP_inst *P_inst;
 #endif
@@ -0,0 +1,414 @@
+/**
+ * @file Native work-stealing task scheduler
+ *
+ * (c) Schrodinger, Inc.
+ */
+
+#include "TaskPool.h"
+#include "PyMOLGlobals.h"
+#include "Setting.h"
+
+#include <cassert>
+
+namespace pymol
+{
+
+namespace
+{
+struct WorkerId {
+  const TaskPool* pool;
+  int index;
+};
+
+thread_local WorkerId t_worker_id{nullptr, -1};
+
+inline std::uint64_t pack_range(std::uint32_t begin, std::uint32_t end)
+{
+  return (std::uint64_t(begin) << 32) | end;
+}
+
+inline std::uint32_t range_begin(std::uint64_t r)
+{
+  return std::uint32_t(r >> 32);
+}
+
+inline std::uint32_t range_end(std::uint64_t r)
+{
+  return std::uint32_t(r);
+}
+} // namespace
+
+/*========================================================================*/
+
+StealingRange::StealingRange(std::uint32_t n_items, unsigned n_workers)
+    : m_n_workers(n_workers ? n_workers : 1)
+    , m_size(n_items)
+{
+  m_slots.reset(new Slot[m_n_workers]);
+  for (unsigned i = 0; i < m_n_workers; ++i) {
+    auto begin = std::uint32_t(std::uint64_t(n_items) * i / m_n_workers);
+    auto end = std::uint32_t(std::uint64_t(n_items) * (i + 1) / m_n_workers);
+    m_slots[i].range.store(pack_range(begin, end), std::memory_order_relaxed);
+  }
+}
+
+bool StealingRange::next(unsigned worker, std::uint32_t& item)
+{
+  auto& slot = m_slots[worker % m_n_workers].range;
+  auto r = slot.load(std::memory_order_acquire);
+
+  while (range_begin(r) < range_end(r)) {
+    if (slot.compare_exchange_weak(
+            r, pack_range(range_begin(r) + 1, range_end(r)))) {
+      item = range_begin(r);
+      m_taken.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+
+  return steal(worker % m_n_workers, item);
+}
+
+/**
+ * Takes the back half of the largest remaining slice. The stolen items
+ * (except the returned one) become the new slice of `worker`, which is empty
+ * at this point and hence not a target for other thieves.
+ */
+bool StealingRange::steal(unsigned worker, std::uint32_t& item)
+{
+  for (;;) {
+    unsigned victim = 0;
+    std::uint32_t victim_n = 0;
+    std::uint64_t victim_r = 0;
+
+    for (unsigned i = 1; i < m_n_workers; ++i) {
+      unsigned w = (worker + i) % m_n_workers;
+      auto r = m_slots[w].range.load(std::memory_order_acquire);
+      if (range_begin(r) < range_end(r) &&
+          range_end(r) - range_begin(r) > victim_n) {
+        victim = w;
+        victim_n = range_end(r) - range_begin(r);
+        victim_r = r;
+      }
+    }
+
+    if (!victim_n)
+      return false;
+
+    auto begin = range_begin(victim_r);
+    auto end = range_end(victim_r);
+    auto mid = begin + victim_n / 2;
+
+    if (m_slots[victim].range.compare_exchange_strong(
+            victim_r, pack_range(begin, mid))) {
+      item = mid;
+      m_slots[worker].range.store(
+          pack_range(mid + 1, end), std::memory_order_release);
+      m_taken.fetch_add(1, std::memory_order_relaxed);
+      return true;
+    }
+  }
+}
+
+/*========================================================================*/
+
+TaskPool::TaskPool()
+{
+  m_queues[0].reset(new Queue);
+}
+
+TaskPool::~TaskPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_sleep_mutex);
+    m_stop = true;
+  }
+  m_sleep_cv.notify_all();
+
+  for (auto& thread : m_threads) {
+    thread.join();
+  }
+}
+
+int TaskPool::currentWorker() const
+{
+  return (t_worker_id.pool == this) ? t_worker_id.index : -1;
+}
+
+void TaskPool::reserveThreads(unsigned n_threads)
+{
+  if (n_threads > MaxWorkers)
+    n_threads = MaxWorkers;
+
+  if (m_n_threads.load() >= n_threads)
+    return;
+
+  std::lock_guard<std::mutex> lock(m_threads_mutex);
+
+  while (m_threads.size() < n_threads) {
+    unsigned index = m_threads.size();
+    m_queues[index + 1].reset(new Queue);
+    m_threads.emplace_back(&TaskPool::workerMain, this, index);
+    m_n_threads.store(m_threads.size());
+  }
+}
+
+void TaskPool::workerMain(unsigned index)
+{
+  t_worker_id = {this, int(index)};
+
+  for (;;) {
+    if (tryRunOne(index))
+      continue;
+
+    std::unique_lock<std::mutex> lock(m_sleep_mutex);
+    m_sleep_cv.wait(lock, [this] { return m_stop || m_queued.load() > 0; });
+
+    if (m_stop && !m_queued.load())
+      return;
+  }
+}
+
+void TaskPool::push(unsigned queue, std::function<void()> task)
+{
+  {
+    auto& q = *m_queues[queue];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    q.tasks.push_back(std::move(task));
+    m_queued.fetch_add(1);
+  }
+
+  std::lock_guard<std::mutex> lock(m_sleep_mutex);
+  m_sleep_cv.notify_one();
+}
+
+/**
+ * Pops a task from the back of our own queue, or steals one from the front
+ * of any other queue, and runs it.
+ * @param self Worker index or -1 for a foreign thread
+ * @return false if no task was found
+ */
+bool TaskPool::tryRunOne(int self)
+{
+  std::function<void()> task;
+  const unsigned n_queues = m_n_threads.load() + 1;
+  const unsigned own = self + 1;
+
+  if (self >= 0) {
+    auto& q = *m_queues[own];
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (!q.tasks.empty()) {
+      task = std::move(q.tasks.back());
+      q.tasks.pop_back();
+      m_queued.fetch_sub(1);
+    }
+  }
+
+  for (unsigned i = 1; !task && i <= n_queues; ++i) {
+    auto& q = *m_queues[(own + i) % n_queues];
+    if (!m_queued.load())
+      break;
+    std::lock_guard<std::mutex> lock(q.mutex);
+    if (!q.tasks.empty()) {
+      task = std::move(q.tasks.front());
+      q.tasks.pop_front();
+      m_queued.fetch_sub(1);
+    }
+  }
+
+  if (!task)
+    return false;
+
+  task();
+  return true;
+}
+
+void TaskPool::submit(TaskGroup& group, std::function<void()> task)
+{
+  group.m_pending.fetch_add(1);
+
+  auto wrapped = [this, &group, task = std::move(task)]() {
+    task();
+    if (group.m_pending.fetch_sub(1) == 1) {
+      // `group` may be gone once the waiter sees zero, don't touch it
+      std::lock_guard<std::mutex> lock(m_sleep_mutex);
+      m_sleep_cv.notify_all();
+    }
+  };
+
+  int self = currentWorker();
+  unsigned n_threads = m_n_threads.load();
+
+  if (self >= 0) {
+    push(self + 1, std::move(wrapped));
+  } else if (n_threads) {
+    push(1 + m_next_queue.fetch_add(1) % n_threads, std::move(wrapped));
+  } else {
+    push(0, std::move(wrapped));
+  }
+}
+
+void TaskPool::wait(TaskGroup& group)
+{
+  const int self = currentWorker();
+
+  while (!group.done()) {
+    if (tryRunOne(self))
+      continue;
+
+    std::unique_lock<std::mutex> lock(m_sleep_mutex);
+    m_sleep_cv.wait(
+        lock, [&] { return group.done() || m_queued.load() > 0; });
+  }
+}
+
+void TaskPool::run(unsigned n_workers, const std::function<void(unsigned)>& fn)
+{
+  if (n_workers > MaxWorkers)
+    n_workers = MaxWorkers;
+
+  if (n_workers < 2) {
+    fn(0);
+    return;
+  }
+
+  reserveThreads(n_workers - 1);
+
+  TaskGroup group;
+  for (unsigned worker = 1; worker < n_workers; ++worker) {
+    submit(group, [&fn, worker] { fn(worker); });
+  }
+
+  fn(0);
+  wait(group);
+}
+
+/*========================================================================*/
+
+TaskGraph::Node TaskGraph::add(
+    std::function<void()> fn, const std::vector<Node>& deps, bool main_thread)
+{
+  const Node node = m_tasks.size();
+  for (Node dep : deps) {
+    assert(dep < node);
+    m_tasks[dep].dependents.push_back(node);
+  }
+  m_tasks.emplace_back();
+  auto& task = m_tasks.back();
+  task.fn = std::move(fn);
+  task.n_deps = deps.size();
+  task.main_thread = main_thread;
+  return node;
+}
+
+void TaskGraph::run(TaskPool* pool, unsigned n_workers)
+{
+  if (!pool || n_workers < 2 || m_tasks.size() < 2) {
+    for (auto& task : m_tasks) {
+      task.fn();
+    }
+    return;
+  }
+
+  pool->reserveThreads(std::min(n_workers, TaskPool::MaxWorkers) - 1);
+
+  const std::size_t n_tasks = m_tasks.size();
+  std::unique_ptr<std::atomic<unsigned>[]> remaining(
+      new std::atomic<unsigned>[n_tasks]);
+  for (std::size_t i = 0; i != n_tasks; ++i) {
+    remaining[i].store(m_tasks[i].n_deps, std::memory_order_relaxed);
+  }
+
+  std::atomic<std::size_t> unfinished{n_tasks};
+  std::atomic<std::size_t> n_main_ready{0};
+  std::mutex main_mutex;
+  std::deque<Node> main_ready;
+  TaskGroup group;
+
+  // the calling thread sleeps on the pool's condition variable
+  auto wake = [pool] {
+    std::lock_guard<std::mutex> lock(pool->m_sleep_mutex);
+    pool->m_sleep_cv.notify_all();
+  };
+
+  std::function<void(Node)> execute;
+
+  auto release = [&](Node node) {
+    if (m_tasks[node].main_thread) {
+      {
+        std::lock_guard<std::mutex> lock(main_mutex);
+        main_ready.push_back(node);
+      }
+      n_main_ready.fetch_add(1);
+      wake();
+    } else {
+      pool->submit(group, [&execute, node] { execute(node); });
+    }
+  };
+
+  execute = [&](Node node) {
+    m_tasks[node].fn();
+    for (Node next : m_tasks[node].dependents) {
+      if (remaining[next].fetch_sub(1, std::memory_order_acq_rel) == 1)
+        release(next);
+    }
+    if (unfinished.fetch_sub(1) == 1)
+      wake();
+  };
+
+  for (Node node = 0; node != n_tasks; ++node) {
+    if (!m_tasks[node].n_deps)
+      release(node);
+  }
+
+  const int self = pool->currentWorker();
+
+  while (unfinished.load()) {
+    Node node = n_tasks;
+    if (n_main_ready.load()) {
+      std::lock_guard<std::mutex> lock(main_mutex);
+      if (!main_ready.empty()) {
+        node = main_ready.front();
+        main_ready.pop_front();
+        n_main_ready.fetch_sub(1);
+      }
+    }
+    if (node != n_tasks) {
+      execute(node);
+      continue;
+    }
+    if (pool->tryRunOne(self))
+      continue;
+
+    std::unique_lock<std::mutex> lock(pool->m_sleep_mutex);
+    pool->m_sleep_cv.wait(lock, [&] {
+      return !unfinished.load() || n_main_ready.load() ||
+             pool->m_queued.load() > 0;
+    });
+  }
+
+  // the last pool task may still be leaving `group`
+  pool->wait(group);
+}
+
+void TaskGraph::run(PyMOLGlobals* G)
+{
+  run(parallel_pool(G), parallel_workers(G));
+}
+
+/*========================================================================*/
+
+unsigned parallel_workers(PyMOLGlobals* G)
+{
+  if (!G->TaskPool)
+    return 1;
+  const int n = SettingGetGlobal_i(G, cSetting_max_threads);
+  return std::min<unsigned>(std::max(n, 1), TaskPool::MaxWorkers);
+}
+
+TaskPool* parallel_pool(PyMOLGlobals* G)
+{
+  return G->TaskPool;
+}
+
+} // namespace pymol
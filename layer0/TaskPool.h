@@ -0,0 +1,258 @@
+/**
+ * @file Native work-stealing task scheduler
+ *
+ * (c) Schrodinger, Inc.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct PyMOLGlobals;
+
+namespace pymol
+{
+
+/**
+ * Lock-free partition of the index range [0, n) over a fixed number of
+ * workers. Every worker starts with a contiguous slice and takes items from
+ * its front. A worker which runs dry steals the back half of the largest
+ * remaining slice, so unevenly expensive items (e.g. image tiles covering a
+ * dense part of the scene) still keep all workers busy.
+ */
+class StealingRange
+{
+public:
+  StealingRange(std::uint32_t n_items, unsigned n_workers);
+
+  /**
+   * Hands out the next item for `worker`.
+   * @param worker Worker index in [0, n_workers)
+   * @param[out] item Item index in [0, n_items)
+   * @return false once the whole range is exhausted
+   */
+  bool next(unsigned worker, std::uint32_t& item);
+
+  /// Total number of items
+  std::uint32_t size() const { return m_size; }
+
+  /// Number of items handed out so far (for progress reporting)
+  std::uint32_t taken() const { return m_taken.load(std::memory_order_relaxed); }
+
+private:
+  struct alignas(64) Slot {
+    std::atomic<std::uint64_t> range; ///< packed (begin << 32 | end)
+  };
+
+  bool steal(unsigned worker, std::uint32_t& item);
+
+  std::unique_ptr<Slot[]> m_slots;
+  unsigned m_n_workers;
+  std::uint32_t m_size;
+  std::atomic<std::uint32_t> m_taken{0};
+};
+
+/**
+ * Counter of outstanding tasks. Waiting on a group executes pending tasks on
+ * the waiting thread, so groups may be nested without deadlock.
+ */
+class TaskGroup
+{
+  friend class TaskPool;
+  std::atomic<std::size_t> m_pending{0};
+
+public:
+  bool done() const { return m_pending.load(std::memory_order_acquire) == 0; }
+};
+
+/**
+ * Pool of native worker threads with one task deque per worker. Workers pop
+ * from the back of their own deque and steal from the front of others.
+ *
+ * Threads are started lazily, up to the number of workers requested by the
+ * callers (usually the "max_threads" setting). None of the workers ever
+ * touches the Python interpreter, so the GIL is not needed.
+ */
+class TaskPool
+{
+  friend class TaskGraph;
+
+public:
+  /// Upper bound for the number of worker threads
+  static constexpr unsigned MaxWorkers = 1024;
+
+  TaskPool();
+  ~TaskPool();
+  TaskPool(const TaskPool&) = delete;
+  TaskPool& operator=(const TaskPool&) = delete;
+
+  /**
+   * Calls `fn(worker)` for every worker index in [0, n_workers) and blocks
+   * until all calls have returned. Index 0 always runs on the calling
+   * thread (which may be the GUI thread), the others are queued on the pool.
+   * The calls must not wait on each other.
+   */
+  void run(unsigned n_workers, const std::function<void(unsigned)>& fn);
+
+  /**
+   * Work-stealing parallel loop over [0, n_items) in chunks of `grain`.
+   * Calls `fn(begin, end, worker)` for every chunk.
+   */
+  template <typename Func>
+  void parallel_for(
+      std::size_t n_items, std::size_t grain, unsigned n_workers, Func&& fn)
+  {
+    if (!n_items)
+      return;
+    if (!grain)
+      grain = 1;
+    const std::size_t n_chunks = (n_items + grain - 1) / grain;
+    if (n_workers > n_chunks)
+      n_workers = n_chunks;
+    if (n_workers < 2) {
+      fn(std::size_t(0), n_items, 0u);
+      return;
+    }
+    StealingRange chunks(n_chunks, n_workers);
+    run(n_workers, [&](unsigned worker) {
+      std::uint32_t chunk;
+      while (chunks.next(worker, chunk)) {
+        const std::size_t begin = chunk * grain;
+        const std::size_t end = std::min(begin + grain, n_items);
+        fn(begin, end, worker);
+      }
+    });
+  }
+
+  /**
+   * Queues `task` as part of `group`. When called from a pool thread, the
+   * task goes to that thread's own deque.
+   */
+  void submit(TaskGroup& group, std::function<void()> task);
+
+  /**
+   * Blocks until all tasks of `group` are finished, executing queued tasks
+   * on the calling thread meanwhile.
+   */
+  void wait(TaskGroup& group);
+
+  /// Number of started worker threads (not counting the calling thread)
+  unsigned threads() const { return m_n_threads.load(); }
+
+  /// Index of the pool thread we're running on, or -1 for foreign threads
+  int currentWorker() const;
+
+private:
+  struct alignas(64) Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  void reserveThreads(unsigned n_threads);
+  void workerMain(unsigned index);
+  void push(unsigned queue, std::function<void()> task);
+  bool tryRunOne(int self);
+
+  /// [0] for foreign threads, [i + 1] for worker i. Allocated when the
+  /// worker starts, before it is published through m_n_threads.
+  std::unique_ptr<Queue> m_queues[MaxWorkers + 1];
+  std::vector<std::thread> m_threads;
+  std::mutex m_threads_mutex;
+  std::atomic<unsigned> m_n_threads{0};
+  std::atomic<unsigned> m_next_queue{0};
+
+  std::atomic<std::size_t> m_queued{0};
+  std::mutex m_sleep_mutex;
+  std::condition_variable m_sleep_cv;
+  bool m_stop = false;
+};
+
+/**
+ * Tasks with declared dependencies. A task is queued on the pool once all
+ * tasks it depends on have finished. Tasks can only depend on tasks which
+ * were added before them, so the graph is acyclic and the insertion order is
+ * a valid serial order.
+ */
+class TaskGraph
+{
+public:
+  using Node = std::size_t;
+
+  /**
+   * Adds a task.
+   * @param fn Task body
+   * @param deps Previously added tasks which must finish first
+   * @param main_thread Run on the thread which calls run(), for tasks which
+   * need the Python interpreter or other state which is not thread-safe.
+   * Such tasks never run concurrently with each other.
+   * @return Handle for the `deps` of later tasks
+   */
+  Node add(std::function<void()> fn, const std::vector<Node>& deps = {},
+      bool main_thread = false);
+
+  /// Number of tasks
+  std::size_t size() const { return m_tasks.size(); }
+
+  /**
+   * Runs all tasks and blocks until they are finished. With no pool or
+   * fewer than two workers, the tasks run in insertion order on the calling
+   * thread.
+   */
+  void run(TaskPool* pool, unsigned n_workers);
+
+  /// Runs on the task pool of `G` with parallel_workers(G) workers
+  void run(PyMOLGlobals* G);
+
+private:
+  struct Task {
+    std::function<void()> fn;
+    std::vector<Node> dependents;
+    unsigned n_deps = 0;
+    bool main_thread = false;
+  };
+
+  std::vector<Task> m_tasks;
+};
+
+/**
+ * Number of workers for the parallel loops of `G`: the "max_threads"
+ * setting, or 1 if there is no task pool.
+ */
+unsigned parallel_workers(PyMOLGlobals* G);
+
+/// Task pool of `G`, may be null
+TaskPool* parallel_pool(PyMOLGlobals* G);
+
+/**
+ * Parallel loop over [0, n_items) on the task pool of `G`, with up to
+ * parallel_workers(G) workers. Calls `fn(begin, end, worker)` for every
+ * chunk. Chunks always start at a multiple of `grain` and are at most
+ * `grain` items long, so per-chunk results can be merged in chunk order
+ * independent of the number of threads.
+ */
+template <typename Func>
+void parallel_for(
+    PyMOLGlobals* G, std::size_t n_items, std::size_t grain, Func&& fn)
+{
+  if (!grain)
+    grain = 1;
+  const unsigned n_workers = parallel_workers(G);
+  if (n_workers < 2 || n_items <= grain) {
+    for (std::size_t begin = 0; begin < n_items; begin += grain)
+      fn(begin, std::min(begin + grain, n_items), 0u);
+    return;
+  }
+  parallel_pool(G)->parallel_for(n_items, grain, n_workers, fn);
+}
+
+} // namespace pymol
@@ -122,7 +122,7 @@ static int *TriangleMakeStripVLA(TriangleSurfaceRec * II, float *v, float *vn, i
   int flag;
   float *v0, *v1, *v2, vt1[3], vt2[3], *tn0, *tn1, *tn2, tn[3], xtn[3];
 
-  strip = VLAlloc(int, I->nTri * 4);    /* strip VLA is count,vert,vert,...count,vert,vert...zero */
+  strip = VLAlloc(int, I->nTri * 4 + 1);    /* strip VLA is count,vert,vert,...count,vert,vert...zero */
   tFlag = pymol::malloc<int>(I->nTri);
   for(a = 0; a < I->nTri; a++)
     tFlag[a] = 0;
@@ -2277,6 +2277,15 @@ static int TriangleBruteForceClosure(TriangleSurfaceRec * II, float *v, float *v
   return ok;
 }
 
+/**
+ * Advancing front triangulation of surface points.
+ *
+ * Runs on one thread. Each triangle is picked from the current front and
+ * changes the edge and vertex state which the next pick depends on, so the
+ * mesh depends on the order of the whole pass. Triangulating spatial
+ * patches concurrently would need its own seam closing and would not
+ * reproduce this mesh.
+ */
 int *TrianglePointsToSurface(PyMOLGlobals * G, float *v, float *vn, int n,
                              float cutoff, int *nTriPtr, int **stripPtr,
                              float *extent, int cavity_mode)
@@ -80,6 +80,26 @@ inline SomeString PyBytes_AsSomeString(PyObject * o) {
   return SomeString(PyBytes_AsString(o), PyBytes_Size(o));
 }
 
+/**
+ * Binary dump arrays (pse_binary_dump) are bytes, or contiguous memoryviews
+ * when read straight from a memory mapped chunked session (pymol.psc).
+ */
+inline bool PyBinary_Check(PyObject * o) {
+  return PyBytes_Check(o) || (PyMemoryView_Check(o) &&
+      PyBuffer_IsContiguous(PyMemoryView_GET_BUFFER(o), 'C'));
+}
+
+/**
+ * Data of a PyBinary_Check object, valid as long as `o` is alive
+ */
+inline SomeString PyBinary_AsSomeString(PyObject * o) {
+  if (PyMemoryView_Check(o)) {
+    auto view = PyMemoryView_GET_BUFFER(o);
+    return SomeString(static_cast<const char*>(view->buf), view->len);
+  }
+  return PyBytes_AsSomeString(o);
+}
+
 namespace pymol {
 /**
  * Destruction policy for unique_ptr<PyObject, pymol::pyobject_delete>
@@ -26,6 +26,10 @@ Z* -------------------------------------------------------------------
 #include"Util.h"
 #include"MemoryCache.h"
 #include"Character.h"
+#include"BVH.h"
+
+#include <algorithm>
+#include <vector>
 
 static const float kR_SMALL4 = 0.0001F;
 static const float kR_SMALL5 = 0.0001F;
@@ -1496,41 +1500,116 @@ int n_sausages = 0;
 int n_skipped = 0;
 #endif
 
-int BasisHitPerspective(BasisCallRec * BC)
-{
-  CBasis *BI = BC->Basis;
-  MapType *map = BI->Map;
-  int iMin0 = map->iMin[0];
-  int iMin1 = map->iMin[1];
-  int iMin2 = map->iMin[2];
-  int iMax0 = map->iMax[0];
-  int iMax1 = map->iMax[1];
-  int iMax2 = map->iMax[2];
-  int a, b, c;
-
-  float iDiv = map->recipDiv;
-  float base0, base1, base2;
+/*========================================================================*/
+/* Spatial search along a ray: a walker yields the element lists (-1 terminated
+ * vertex indices) which may contain the nearest hit, in front-to-back order.
+ * It gets told whether a hit has been found so far and at which distance,
+ * which allows for early termination. The "unique" walkers never yield a
+ * primitive twice, so the MapCache can be skipped. */
 
-  float min0 = map->Min[0] * iDiv;
-  float min1 = map->Min[1] * iDiv;
-  float min2 = map->Min[2] * iDiv;
+namespace {
 
-  int new_ray = !BC->pass;
-  RayInfo *r = BC->rr;
+const int EmptyEList[] = { -1 };
+
+/* down a z column of the voxel grid (orthoscopic and shadow rays) */
+class ZGridWalker {
+public:
+  static constexpr bool unique = false;
+
+  ZGridWalker(CBasis * BI, const float *base, bool early_exit)
+    : m_map(BI->Map)
+    , m_base(base)
+    , m_early_exit(early_exit)
+  {
+    int a, b;
+    m_inside = MapInsideXY(m_map, base, &a, &b, &m_c);
+    if(m_inside)
+      m_head = m_map->EHead + (a * m_map->D1D2) + (b * m_map->Dim[2]) + m_c;
+  }
+
+  bool valid() const { return m_inside; }
+
+  const int *next(bool found, float r_dist)
+  {
+    if(m_started) {
+      /* we've processed all primitives associated with this voxel,
+         so if an intersection has been found which occurs in front of
+         the next voxel, then we can stop */
+      if(found && m_early_exit) {
+        float vt[3] = { m_base[0], m_base[1], m_base[2] - r_dist };
+        int aa, bb, cc;
+        MapLocus(m_map, vt, &aa, &bb, &cc);
+        if(cc > m_c)
+          return NULL;
+      }
+      m_c--;
+      m_head--;
+    }
+    m_started = true;
+
+    /* and of course stop when we hit the edge of the map */
+    if(m_c < MapBorder)
+      return NULL;
 
-  MapCache *cache = &BC->cache;
-  int *cache_cache = cache->Cache;
-  int *cache_CacheLink = cache->CacheLink;
+    int h = *m_head;
+    if((h > 0) && (h < m_map->NEElem))
+      return m_map->EList + h;
+    return EmptyEList;
+  }
+
+private:
+  MapType *m_map;
+  const float *m_base;
+  int *m_head = NULL;
+  int m_c = 0;
+  bool m_early_exit;
+  bool m_inside;
+  bool m_started = false;
+};
+
+/* through the (perspective) voxel grid along an arbitrary direction */
+class PerspectiveGridWalker {
+public:
+  static constexpr bool unique = false;
+
+  PerspectiveGridWalker(BasisCallRec * BC)
+    : m_map(BC->Basis->Map)
+    , m_r(BC->rr)
+    , m_new_ray(!BC->pass)
+  {
+    MapType *map = m_map;
+    iMin0 = map->iMin[0];
+    iMin1 = map->iMin[1];
+    iMin2 = map->iMin[2];
+    iMax0 = map->iMax[0];
+    iMax1 = map->iMax[1];
+    iMax2 = map->iMax[2];
+
+    iDiv = map->recipDiv;
+    min0 = map->Min[0] * iDiv;
+    min1 = map->Min[1] * iDiv;
+    min2 = map->Min[2] * iDiv;
 
-  CPrimitive *r_prim = NULL;
+    {                           /* take steps with a Z-size equil to the grid spacing */
+      float div = iDiv * (-MapGetDiv(map) / m_r->dir[2]);
+      step0 = m_r->dir[0] * div;
+      step1 = m_r->dir[1] * div;
+      step2 = m_r->dir[2] * div;
+    }
 
-  if(new_ray) {                 /* see if we can eliminate this ray right away using the mask */
+    base0 = (m_r->skip[0] * iDiv) - min0;
+    base1 = (m_r->skip[1] * iDiv) - min1;
+    base2 = (m_r->skip[2] * iDiv) - min2;
+  }
 
-    base0 = (r->base[0] * iDiv) - min0;
-    base1 = (r->base[1] * iDiv) - min1;
+  /* see if we can eliminate this ray right away using the mask */
+  bool valid() const
+  {
+    if(!m_new_ray)
+      return true;
 
-    a = (int) base0;
-    b = (int) base1;
+    int a = (int) ((m_r->base[0] * iDiv) - min0);
+    int b = (int) ((m_r->base[1] * iDiv) - min1);
     a += MapBorder;
     b += MapBorder;
     if(a < iMin0)
@@ -1542,77 +1621,30 @@ int BasisHitPerspective(BasisCallRec * BC)
     else if(b > iMax1)
       b = iMax1;
 
-    if(!*(map->EMask + a * map->Dim[1] + b))
-      return -1;
+    return *(m_map->EMask + a * m_map->Dim[1] + b) != 0;
   }
 
+  const int *next(bool found, float)
   {
-    int last_a = -1, last_b = -1, last_c = -1;
-    int allow_break;
-    int minIndex = -1;
-
-    float step0, step1, step2;
-    float back_dist = BC->back_dist;
-
-    const float _0 = 0.0F, _1 = 1.0F;
-    float r_tri1 = _0, r_tri2 = _0, r_dist, dist;       /* zero inits to suppress compiler warnings */
-    float r_sphere0 = _0, r_sphere1 = _0, r_sphere2 = _0;
-    int h, *ip;
-    int excl_trans_flag;
-    int *elist, local_iflag = false;
-    int terminal = -1;
-    int *ehead = map->EHead;
-    int d1d2 = map->D1D2;
-    int d2 = map->Dim[2];
-    const int *vert2prim = BC->vert2prim;
-    const float excl_trans = BC->excl_trans;
-    const float BasisFudge0 = BC->fudge0;
-    const float BasisFudge1 = BC->fudge1;
-    int v2p;
-    int i, ii;
-    int n_vert = BI->NVertex, n_eElem = map->NEElem;
-    int except1 = BC->except1;
-    int except2 = BC->except2;
-    int check_interior_flag = BC->check_interior && !BC->pass;
-    float sph[3], vt[3], tri1 = _0, tri2;
-    CPrimitive *BC_prim = BC->prim;
-    int *BI_Vert2Normal = BI->Vert2Normal;
-    float *BI_Vertex = BI->Vertex;
-    float *BI_Precomp = BI->Precomp;
-    float *BI_Normal = BI->Normal;
-    float *BI_Radius = BI->Radius;
-    float *BI_Radius2 = BI->Radius2;
-    copy3f(r->base, vt);
-
-    elist = map->EList;
-
-    r_dist = FLT_MAX;
-
-    excl_trans_flag = (excl_trans != _0);
-
-    if(except1 >= 0)
-      except1 = vert2prim[except1];
-    if(except2 >= 0)
-      except2 = vert2prim[except2];
-
-    MapCacheReset(cache);
-
-    {                           /* take steps with a Z-size equil to the grid spacing */
-      float div = iDiv * (-MapGetDiv(BI->Map) / r->dir[2]);
-      step0 = r->dir[0] * div;
-      step1 = r->dir[1] * div;
-      step2 = r->dir[2] * div;
-    }
-
-    base0 = (r->skip[0] * iDiv) - min0;
-    base1 = (r->skip[1] * iDiv) - min1;
-    base2 = (r->skip[2] * iDiv) - min2;
-
-    allow_break = false;
+#define EDGE_ALLOWANCE 1
     while(1) {
+      int a, b, c;
       int inside_code;
       int clamped;
 
+      if(m_started) {
+        if(found) {
+          if(terminal < 0)
+            terminal = EDGE_ALLOWANCE + 1;
+        }
+
+        base0 += step0;
+        base1 += step1;
+        base2 += step2;
+        /* advance through the map one block at a time -- note that this is a crappy way to walk through the map... */
+      }
+      m_started = true;
+
       a = ((int) base0);
       b = ((int) base1);
       c = ((int) base2);
@@ -1623,18 +1655,17 @@ int BasisHitPerspective(BasisCallRec * BC)
       a += MapBorder;
       b += MapBorder;
       c += MapBorder;
-#define EDGE_ALLOWANCE 1
 
       if(a < iMin0) {
         if(((iMin0 - a) > EDGE_ALLOWANCE) && allow_break)
-          break;
+          return NULL;
         else {
           a = iMin0;
           clamped = true;
         }
       } else if(a > iMax0) {
         if(((a - iMax0) > EDGE_ALLOWANCE) && allow_break)
-          break;
+          return NULL;
         else {
           a = iMax0;
           clamped = true;
@@ -1642,14 +1673,14 @@ int BasisHitPerspective(BasisCallRec * BC)
       }
       if(b < iMin1) {
         if(((iMin1 - b) > EDGE_ALLOWANCE) && allow_break)
-          break;
+          return NULL;
         else {
           b = iMin1;
           clamped = true;
         }
       } else if(b > iMax1) {
         if(((b - iMax1) > EDGE_ALLOWANCE) && allow_break)
-          break;
+          return NULL;
         else {
           b = iMax1;
           clamped = true;
@@ -1657,7 +1688,7 @@ int BasisHitPerspective(BasisCallRec * BC)
       }
       if(c < iMin2) {
         if((iMin2 - c) > EDGE_ALLOWANCE)
-          break;
+          return NULL;
         else {
           c = iMin2;
           clamped = true;
@@ -1671,359 +1702,523 @@ int BasisHitPerspective(BasisCallRec * BC)
         }
       }
       if(inside_code && (((a != last_a) || (b != last_b) || (c != last_c)))) {
-        int new_min_index;
-        h = *(ehead + (d1d2 * a) + (d2 * b) + c);
-
-        new_min_index = -1;
+        int h = *(m_map->EHead + (m_map->D1D2 * a) + (m_map->Dim[2] * b) + c);
 
         if(!clamped)            /* don't discard a ray until it has hit the objective at least once */
           allow_break = true;
 
         if((terminal > 0) && (last_c != c)) {
           if(!terminal--)
-            break;
+            return NULL;
         }
-        if((h > 0) && (h < n_eElem)) {
-          int do_loop;
-
-          ip = elist + h;
+        if((h > 0) && (h < m_map->NEElem)) {
           last_a = a;
-          i = *(ip++);
           last_b = b;
-          do_loop = ((i >= 0) && (i < n_vert));
           last_c = c;
+          return m_map->EList + h;
+        }
+      }
+    }
+#undef EDGE_ALLOWANCE
+  }
 
-          while(do_loop) {      /* n_vert checking is a bug workaround */
-            CPrimitive *prm;
-            v2p = vert2prim[i];
-            ii = *(ip++);
-            prm = BC_prim + v2p;
-            do_loop = ((ii >= 0) && (ii < n_vert));
-            /*            if((v2p != except1) && (v2p != except2) && (!MapCached(cache, v2p))) { */
-            if((v2p != except1) && (v2p != except2) && (!cache_cache[v2p])) {
-              int prm_type = prm->type;
-
-              /*MapCache(cache,v2p); */
-              cache_cache[v2p] = 1;
-              cache_CacheLink[v2p] = cache->CacheStart;
-              cache->CacheStart = v2p;
-
-              switch (prm_type) {
-              case cPrimTriangle:
-              case cPrimCharacter:
-                {
-                  float *dir = r->dir;
-                  float *d10 = BI_Precomp + BI_Vert2Normal[i] * 3;
-                  float *d20 = d10 + 3;
-                  float *v0;
-                  float det, inv_det;
-                  float pvec0, pvec1, pvec2;
-                  float dir0 = dir[0], dir1 = dir[1], dir2 = dir[2];
-                  float d20_0 = d20[0], d20_1 = d20[1], d20_2 = d20[2];
-                  float d10_0 = d10[0], d10_1 = d10[1], d10_2 = d10[2];
+private:
+  MapType *m_map;
+  const RayInfo *m_r;
+  int m_new_ray;
+  int iMin0, iMin1, iMin2;
+  int iMax0, iMax1, iMax2;
+  float iDiv, min0, min1, min2;
+  float base0, base1, base2;
+  float step0, step1, step2;
+  int last_a = -1, last_b = -1, last_c = -1;
+  int allow_break = false;
+  int terminal = -1;
+  bool m_started = false;
+};
+
+/* through the bounding volume hierarchy, nearest box first */
+class BVHWalker {
+public:
+  static constexpr bool unique = true;
+
+  BVHWalker(const pymol::BVH & bvh, const float *base, const float *dir,
+            float t_min, float t_max)
+    : m_ray(bvh, base, dir, t_min)
+    , m_t_max(t_max)
+  {
+  }
+
+  bool valid() const { return true; }
 
-                  /* cross_product3f(dir, d20, pvec); */
+  const int *next(bool, float r_dist)
+  {
+    return m_ray.next(std::min(r_dist, m_t_max));
+  }
 
-                  pvec0 = dir1 * d20_2 - dir2 * d20_1;
-                  pvec1 = dir2 * d20_0 - dir0 * d20_2;
-                  pvec2 = dir0 * d20_1 - dir1 * d20_0;
+private:
+  pymol::BVHRay m_ray;
+  float m_t_max;
+};
 
-                  /* det = dot_product3f(pvec, d10); */
+} // namespace
 
-                  det = pvec0 * d10_0 + pvec1 * d10_1 + pvec2 * d10_2;
+/*========================================================================*/
+/* The per-ray search state of the BasisHit* functions lives in objects with
+ * start() / visit(element list) / finish(), so that the same primitive tests
+ * serve both single rays (driven by a walker) and packets of rays (driven
+ * by a BVHPacket, one leaf at a time for all rays which intersect it). */
+
+/* nearest hit along a perspective ray */
+template <bool unique>
+class PerspectiveSearch {
+public:
+  void start(BasisCallRec * BC_)
+  {
+    BC = BC_;
+    BI = BC->Basis;
+    r = BC->rr;
+
+    cache = &BC->cache;
+    cache_cache = cache->Cache;
+    cache_CacheLink = cache->CacheLink;
+
+    r_prim = NULL;
+    minIndex = -1;
+    back_dist = BC->back_dist;
+    r_tri1 = r_tri2 = 0.0F;     /* zero inits to suppress compiler warnings */
+    r_sphere0 = r_sphere1 = r_sphere2 = 0.0F;
+    local_iflag = false;
+    vert2prim = BC->vert2prim;
+    excl_trans = BC->excl_trans;
+    BasisFudge0 = BC->fudge0;
+    BasisFudge1 = BC->fudge1;
+    n_vert = BI->NVertex;
+    except1 = BC->except1;
+    except2 = BC->except2;
+    check_interior_flag = BC->check_interior && !BC->pass;
+    BC_prim = BC->prim;
+    BI_Vert2Normal = BI->Vert2Normal;
+    BI_Vertex = BI->Vertex;
+    BI_Precomp = BI->Precomp;
+    BI_Normal = BI->Normal;
+    BI_Radius = BI->Radius;
+    BI_Radius2 = BI->Radius2;
+    copy3f(r->base, vt);
 
-                  v0 = BI_Vertex + prm->vert * 3;
-                  if((det >= EPSILON) || (det <= -EPSILON)) {
-                    float tvec0, tvec1, tvec2;
-                    float qvec0, qvec1, qvec2;
+    r_dist = FLT_MAX;
 
-                    inv_det = _1 / det;
+    excl_trans_flag = (excl_trans != 0.0F);
 
-                    /* subtract3f(vt,v0,tvec); */
+    if(except1 >= 0)
+      except1 = vert2prim[except1];
+    if(except2 >= 0)
+      except2 = vert2prim[except2];
 
-                    tvec0 = vt[0] - v0[0];
-                    tvec1 = vt[1] - v0[1];
-                    tvec2 = vt[2] - v0[2];
+    if(!unique)
+      MapCacheReset(cache);
+  }
 
-                    /* dot_product3f(tvec,pvec) * inv_det; */
-                    tri1 = (tvec0 * pvec0 + tvec1 * pvec1 + tvec2 * pvec2) * inv_det;
+  bool found() const { return minIndex > -1; }
+  float dist() const { return r_dist; }
 
-                    /* cross_product3f(tvec,d10,qvec); */
+  /* tests the primitives of an element list, returns false once the
+     search is complete */
+  bool visit(const int *ip)
+  {
+    const float _0 = 0.0F, _1 = 1.0F;
+    float dist, sph[3], tri1 = _0, tri2;
+    int v2p;
+    int i, ii;
 
-                    qvec0 = tvec1 * d10_2 - tvec2 * d10_1;
-                    qvec1 = tvec2 * d10_0 - tvec0 * d10_2;
+    int new_min_index = -1;
+    int do_loop;
 
-                    if((tri1 >= BasisFudge0) && (tri1 <= BasisFudge1)) {
-                      qvec2 = tvec0 * d10_1 - tvec1 * d10_0;
+    i = *(ip++);
+    do_loop = ((i >= 0) && (i < n_vert));
+
+    while(do_loop) {      /* n_vert checking is a bug workaround */
+      CPrimitive *prm;
+      v2p = vert2prim[i];
+      ii = *(ip++);
+      prm = BC_prim + v2p;
+      do_loop = ((ii >= 0) && (ii < n_vert));
+      /*            if((v2p != except1) && (v2p != except2) && (!MapCached(cache, v2p))) { */
+      if((v2p != except1) && (v2p != except2) && (unique || !cache_cache[v2p])) {
+        int prm_type = prm->type;
+
+        /*MapCache(cache,v2p); */
+        if(!unique) {
+          cache_cache[v2p] = 1;
+          cache_CacheLink[v2p] = cache->CacheStart;
+          cache->CacheStart = v2p;
+        }
 
-                      /* dot_product3f(dir, qvec) * inv_det; */
-                      tri2 = (dir0 * qvec0 + dir1 * qvec1 + dir2 * qvec2) * inv_det;
+        switch (prm_type) {
+        case cPrimTriangle:
+        case cPrimCharacter:
+          {
+            float *dir = r->dir;
+            float *d10 = BI_Precomp + BI_Vert2Normal[i] * 3;
+            float *d20 = d10 + 3;
+            float *v0;
+            float det, inv_det;
+            float pvec0, pvec1, pvec2;
+            float dir0 = dir[0], dir1 = dir[1], dir2 = dir[2];
+            float d20_0 = d20[0], d20_1 = d20[1], d20_2 = d20[2];
+            float d10_0 = d10[0], d10_1 = d10[1], d10_2 = d10[2];
 
-                      /* dot_product3f(d20, qvec) * inv_det; */
-                      dist = (d20_0 * qvec0 + d20_1 * qvec1 + d20_2 * qvec2) * inv_det;
+            /* cross_product3f(dir, d20, pvec); */
 
-                      if((tri2 >= BasisFudge0) && (tri2 <= BasisFudge1)
-                         && ((tri1 + tri2) <= BasisFudge1)) {
-                        if((dist < r_dist) && (dist >= _0) && (dist <= back_dist)
-                           && (prm->trans != _1)) {
-                          new_min_index = prm->vert;
-                          r_tri1 = tri1;
-                          r_tri2 = tri2;
-                          r_dist = dist;
-                        }
-                      }
-                    }
+            pvec0 = dir1 * d20_2 - dir2 * d20_1;
+            pvec1 = dir2 * d20_0 - dir0 * d20_2;
+            pvec2 = dir0 * d20_1 - dir1 * d20_0;
+
+            /* det = dot_product3f(pvec, d10); */
+
+            det = pvec0 * d10_0 + pvec1 * d10_1 + pvec2 * d10_2;
+
+            v0 = BI_Vertex + prm->vert * 3;
+            if((det >= EPSILON) || (det <= -EPSILON)) {
+              float tvec0, tvec1, tvec2;
+              float qvec0, qvec1, qvec2;
+
+              inv_det = _1 / det;
+
+              /* subtract3f(vt,v0,tvec); */
+
+              tvec0 = vt[0] - v0[0];
+              tvec1 = vt[1] - v0[1];
+              tvec2 = vt[2] - v0[2];
+
+              /* dot_product3f(tvec,pvec) * inv_det; */
+              tri1 = (tvec0 * pvec0 + tvec1 * pvec1 + tvec2 * pvec2) * inv_det;
+
+              /* cross_product3f(tvec,d10,qvec); */
+
+              qvec0 = tvec1 * d10_2 - tvec2 * d10_1;
+              qvec1 = tvec2 * d10_0 - tvec0 * d10_2;
+
+              if((tri1 >= BasisFudge0) && (tri1 <= BasisFudge1)) {
+                qvec2 = tvec0 * d10_1 - tvec1 * d10_0;
+
+                /* dot_product3f(dir, qvec) * inv_det; */
+                tri2 = (dir0 * qvec0 + dir1 * qvec1 + dir2 * qvec2) * inv_det;
+
+                /* dot_product3f(d20, qvec) * inv_det; */
+                dist = (d20_0 * qvec0 + d20_1 * qvec1 + d20_2 * qvec2) * inv_det;
+
+                if((tri2 >= BasisFudge0) && (tri2 <= BasisFudge1)
+                   && ((tri1 + tri2) <= BasisFudge1)) {
+                  if((dist < r_dist) && (dist >= _0) && (dist <= back_dist)
+                     && (prm->trans != _1)) {
+                    new_min_index = prm->vert;
+                    r_tri1 = tri1;
+                    r_tri2 = tri2;
+                    r_dist = dist;
                   }
                 }
-                break;
-              case cPrimSphere:
-                {
-                  if(LineClipPoint(r->base, r->dir,
-                                   BI_Vertex + i * 3, &dist,
-                                   BI_Radius[i], BI_Radius2[i])) {
-                    if((dist < r_dist) && (prm->trans != _1)) {
-                      if((dist >= _0) && (dist <= back_dist)) {
-                        new_min_index = prm->vert;
-                        r_dist = dist;
-                      } else if(check_interior_flag && (dist <= back_dist)) {
-                        if(diffsq3f(vt, BI_Vertex + i * 3) < BI_Radius2[i]) {
-
-                          local_iflag = true;
-                          r_prim = prm;
-                          r_dist = _0;
-                          new_min_index = prm->vert;
-                        }
-                      }
-                    }
+              }
+            }
+          }
+          break;
+        case cPrimSphere:
+          {
+            if(LineClipPoint(r->base, r->dir,
+                             BI_Vertex + i * 3, &dist,
+                             BI_Radius[i], BI_Radius2[i])) {
+              if((dist < r_dist) && (prm->trans != _1)) {
+                if((dist >= _0) && (dist <= back_dist)) {
+                  new_min_index = prm->vert;
+                  r_dist = dist;
+                } else if(check_interior_flag && (dist <= back_dist)) {
+                  if(diffsq3f(vt, BI_Vertex + i * 3) < BI_Radius2[i]) {
+
+                    local_iflag = true;
+                    r_prim = prm;
+                    r_dist = _0;
+                    new_min_index = prm->vert;
                   }
                 }
-                break;
-              case cPrimEllipsoid:
-                {
-                  if(LineClipPoint(r->base, r->dir,
-                                   BI_Vertex + i * 3, &dist,
-                                   BI_Radius[i], BI_Radius2[i])) {
-                    if((dist < r_dist) && (prm->trans != _1)) {
-                      float *n1 = BI_Normal + BI_Vert2Normal[i] * 3;
-                      if(LineClipEllipsoidPoint(r->base, r->dir,
-                                                BI_Vertex + i * 3, &dist,
-                                                BI_Radius[i], BI_Radius2[i],
-                                                prm->n0, n1, n1 + 3, n1 + 6)) {
-                        if(dist < r_dist) {
-                          if((dist >= _0) && (dist <= back_dist)) {
-                            new_min_index = prm->vert;
-                            r_dist = dist;
-                          }
-                        }
-                      }
+              }
+            }
+          }
+          break;
+        case cPrimEllipsoid:
+          {
+            if(LineClipPoint(r->base, r->dir,
+                             BI_Vertex + i * 3, &dist,
+                             BI_Radius[i], BI_Radius2[i])) {
+              if((dist < r_dist) && (prm->trans != _1)) {
+                float *n1 = BI_Normal + BI_Vert2Normal[i] * 3;
+                if(LineClipEllipsoidPoint(r->base, r->dir,
+                                          BI_Vertex + i * 3, &dist,
+                                          BI_Radius[i], BI_Radius2[i],
+                                          prm->n0, n1, n1 + 3, n1 + 6)) {
+                  if(dist < r_dist) {
+                    if((dist >= _0) && (dist <= back_dist)) {
+                      new_min_index = prm->vert;
+                      r_dist = dist;
                     }
                   }
                 }
-                break;
+              }
+            }
+          }
+          break;
 
-              case cPrimCylinder:
-                if(LineToSphereCapped(r->base, r->dir, BI_Vertex + i * 3,
+        case cPrimCylinder:
+          if(LineToSphereCapped(r->base, r->dir, BI_Vertex + i * 3,
+                                BI_Normal + BI_Vert2Normal[i] * 3,
+                                BI_Radius[i], prm->l1, sph, &tri1,
+                                prm->cap1, prm->cap2)) {
+            if(LineClipPoint
+               (r->base, r->dir, sph, &dist, BI_Radius[i], BI_Radius2[i])) {
+              if((dist < r_dist) && (prm->trans != _1)) {
+                if((dist >= _0) && (dist <= back_dist)) {
+                  if(prm->l1 > kR_SMALL4)
+                    r_tri1 = tri1 / prm->l1;
+
+                  r_sphere0 = sph[0];
+                  r_sphere1 = sph[1];
+                  r_sphere2 = sph[2];
+                  new_min_index = prm->vert;
+                  r_dist = dist;
+                } else if(check_interior_flag && (dist <= back_dist)) {
+                  if(FrontToInteriorSphereCapped(vt,
+                                                 BI_Vertex + i * 3,
+                                                 BI_Normal + BI_Vert2Normal[i] * 3,
+                                                 BI_Radius[i],
+                                                 BI_Radius2[i],
+                                                 prm->l1, prm->cap1, prm->cap2)) {
+                    local_iflag = true;
+                    r_prim = prm;
+                    r_dist = _0;
+
+                    new_min_index = prm->vert;
+                  }
+                }
+              }
+            }
+          }
+          break;
+        case cPrimCone:
+          {
+            float sph_rad, sph_rad_sq;
+            if(ConeLineToSphereCapped(r->base, r->dir, BI_Vertex + i * 3,
                                       BI_Normal + BI_Vert2Normal[i] * 3,
-                                      BI_Radius[i], prm->l1, sph, &tri1,
+                                      BI_Radius[i], prm->r2, prm->l1, sph, &tri1,
+                                      &sph_rad, &sph_rad_sq,
                                       prm->cap1, prm->cap2)) {
-                  if(LineClipPoint
-                     (r->base, r->dir, sph, &dist, BI_Radius[i], BI_Radius2[i])) {
-                    if((dist < r_dist) && (prm->trans != _1)) {
-                      if((dist >= _0) && (dist <= back_dist)) {
-                        if(prm->l1 > kR_SMALL4)
-                          r_tri1 = tri1 / prm->l1;
 
-                        r_sphere0 = sph[0];
-                        r_sphere1 = sph[1];
-                        r_sphere2 = sph[2];
-                        new_min_index = prm->vert;
-                        r_dist = dist;
-                      } else if(check_interior_flag && (dist <= back_dist)) {
-                        if(FrontToInteriorSphereCapped(vt,
-                                                       BI_Vertex + i * 3,
-                                                       BI_Normal + BI_Vert2Normal[i] * 3,
-                                                       BI_Radius[i],
-                                                       BI_Radius2[i],
-                                                       prm->l1, prm->cap1, prm->cap2)) {
-                          local_iflag = true;
-                          r_prim = prm;
-                          r_dist = _0;
-
-                          new_min_index = prm->vert;
-                        }
-                      }
+              if(LineClipPoint(r->base, r->dir, sph, &dist, sph_rad, sph_rad_sq)) {
+                if((dist < r_dist) && (prm->trans != _1)) {
+                  if((dist >= _0) && (dist <= back_dist)) {
+                    if(prm->l1 > kR_SMALL4)
+                      r_tri1 = tri1 / prm->l1;    /* color blending */
+                    r_sphere0 = sph[0];
+                    r_sphere1 = sph[1];
+                    r_sphere2 = sph[2];
+                    new_min_index = prm->vert;
+                    r_dist = dist;
+                  } else if(check_interior_flag && (dist <= back_dist)) {
+                    if(FrontToInteriorSphereCapped(vt,
+                                                   BI_Vertex + i * 3,
+                                                   BI_Normal +
+                                                   BI_Vert2Normal[i] * 3,
+                                                   BI_Radius[i], BI_Radius2[i],
+                                                   prm->l1, prm->cap1, prm->cap2)) {
+                      local_iflag = true;
+                      r_prim = prm;
+                      r_dist = _0;
+                      new_min_index = prm->vert;
                     }
                   }
                 }
-                break;
-              case cPrimCone:
-                {
-                  float sph_rad, sph_rad_sq;
-                  if(ConeLineToSphereCapped(r->base, r->dir, BI_Vertex + i * 3,
-                                            BI_Normal + BI_Vert2Normal[i] * 3,
-                                            BI_Radius[i], prm->r2, prm->l1, sph, &tri1,
-                                            &sph_rad, &sph_rad_sq,
-                                            prm->cap1, prm->cap2)) {
-
-                    if(LineClipPoint(r->base, r->dir, sph, &dist, sph_rad, sph_rad_sq)) {
-                      if((dist < r_dist) && (prm->trans != _1)) {
-                        if((dist >= _0) && (dist <= back_dist)) {
-                          if(prm->l1 > kR_SMALL4)
-                            r_tri1 = tri1 / prm->l1;    /* color blending */
-                          r_sphere0 = sph[0];
-                          r_sphere1 = sph[1];
-                          r_sphere2 = sph[2];
-                          new_min_index = prm->vert;
-                          r_dist = dist;
-                        } else if(check_interior_flag && (dist <= back_dist)) {
-                          if(FrontToInteriorSphereCapped(vt,
-                                                         BI_Vertex + i * 3,
-                                                         BI_Normal +
-                                                         BI_Vert2Normal[i] * 3,
-                                                         BI_Radius[i], BI_Radius2[i],
-                                                         prm->l1, prm->cap1, prm->cap2)) {
-                            local_iflag = true;
-                            r_prim = prm;
-                            r_dist = _0;
-                            new_min_index = prm->vert;
-                          }
-                        }
-                      }
-                    }
+              }
+            }
+          }
+          break;
+        case cPrimSausage:
+          if(LineToSphere(r->base, r->dir,
+                          BI_Vertex + i * 3, BI_Normal + BI_Vert2Normal[i] * 3,
+                          BI_Radius[i], prm->l1, sph, &tri1)) {
+
+            if(LineClipPoint
+               (r->base, r->dir, sph, &dist, BI_Radius[i], BI_Radius2[i])) {
+
+              int tmp_flag = false;
+              if((dist < r_dist) && (prm->trans != _1)) {
+                if((dist >= _0) && (dist <= back_dist)) {
+                  tmp_flag = true;
+                  if(excl_trans_flag) {
+                    if((prm->trans > _0) && (dist < excl_trans))
+                      tmp_flag = false;
                   }
-                }
-                break;
-              case cPrimSausage:
-                if(LineToSphere(r->base, r->dir,
-                                BI_Vertex + i * 3, BI_Normal + BI_Vert2Normal[i] * 3,
-                                BI_Radius[i], prm->l1, sph, &tri1)) {
-
-                  if(LineClipPoint
-                     (r->base, r->dir, sph, &dist, BI_Radius[i], BI_Radius2[i])) {
-
-                    int tmp_flag = false;
-                    if((dist < r_dist) && (prm->trans != _1)) {
-                      if((dist >= _0) && (dist <= back_dist)) {
-                        tmp_flag = true;
-                        if(excl_trans_flag) {
-                          if((prm->trans > _0) && (dist < excl_trans))
-                            tmp_flag = false;
-                        }
-                        if(tmp_flag) {
+                  if(tmp_flag) {
 
-                          if(prm->l1 > kR_SMALL4)
-                            r_tri1 = tri1 / prm->l1;
+                    if(prm->l1 > kR_SMALL4)
+                      r_tri1 = tri1 / prm->l1;
 
-                          r_sphere0 = sph[0];
-                          r_sphere1 = sph[1];
-                          r_sphere2 = sph[2];
-                          new_min_index = prm->vert;
-                          r_dist = dist;
+                    r_sphere0 = sph[0];
+                    r_sphere1 = sph[1];
+                    r_sphere2 = sph[2];
+                    new_min_index = prm->vert;
+                    r_dist = dist;
 
-                        }
-                      } else if(check_interior_flag && (dist <= back_dist)) {
-                        if(FrontToInteriorSphere(vt, BI_Vertex + i * 3,
-                                                 BI_Normal + BI_Vert2Normal[i] * 3,
-                                                 BI_Radius[i], BI_Radius2[i], prm->l1)) {
-                          local_iflag = true;
-                          r_prim = prm;
-                          r_dist = _0;
-                          new_min_index = prm->vert;
-                        }
-                      }
-                    }
+                  }
+                } else if(check_interior_flag && (dist <= back_dist)) {
+                  if(FrontToInteriorSphere(vt, BI_Vertex + i * 3,
+                                           BI_Normal + BI_Vert2Normal[i] * 3,
+                                           BI_Radius[i], BI_Radius2[i], prm->l1)) {
+                    local_iflag = true;
+                    r_prim = prm;
+                    r_dist = _0;
+                    new_min_index = prm->vert;
                   }
                 }
-                break;
-              }                 /* end of switch */
+              }
             }
-            /* end of if */
-            i = ii;
-
-          }                     /* end of while */
+          }
+          break;
+        }                 /* end of switch */
+      }
+      /* end of if */
+      i = ii;
 
-          if(local_iflag) {
-            r->prim = r_prim;
-            r->dist = r_dist;
+    }                     /* end of while */
 
-            break;
-          }
+    if(local_iflag) {
+      r->prim = r_prim;
+      r->dist = r_dist;
 
-          if(new_min_index > -1) {
+      return false;
+    }
 
-            minIndex = new_min_index;
+    if(new_min_index > -1) {
 
-            r_prim = BC_prim + vert2prim[minIndex];
+      minIndex = new_min_index;
 
-            if((r_prim->type == cPrimSphere) || (r_prim->type == cPrimEllipsoid)) {
-              const float *vv = BI->Vertex + minIndex * 3;
-              r_sphere0 = vv[0];
-              r_sphere1 = vv[1];
-              r_sphere2 = vv[2];
-            }
+      r_prim = BC_prim + vert2prim[minIndex];
 
-            BC->interior_flag = local_iflag;
-            r->tri1 = r_tri1;
-            r->tri2 = r_tri2;
-            r->prim = r_prim;
-            r->dist = r_dist;
-            r->sphere[0] = r_sphere0;
-            r->sphere[1] = r_sphere1;
-            r->sphere[2] = r_sphere2;
-          }
-        }                       /* if -- h valid */
-      }
-      /* end of if */
-      if(minIndex > -1) {
-        if(terminal < 0)
-          terminal = EDGE_ALLOWANCE + 1;
+      if((r_prim->type == cPrimSphere) || (r_prim->type == cPrimEllipsoid)) {
+        const float *vv = BI->Vertex + minIndex * 3;
+        r_sphere0 = vv[0];
+        r_sphere1 = vv[1];
+        r_sphere2 = vv[2];
       }
 
-      base0 += step0;
-      base1 += step1;
-      base2 += step2;
-      /* advance through the map one block at a time -- note that this is a crappy way to walk through the map... */
+      BC->interior_flag = local_iflag;
+      r->tri1 = r_tri1;
+      r->tri2 = r_tri2;
+      r->prim = r_prim;
+      r->dist = r_dist;
+      r->sphere[0] = r_sphere0;
+      r->sphere[1] = r_sphere1;
+      r->sphere[2] = r_sphere2;
     }
 
+    return true;
+  }
+
+  int finish()
+  {
     BC->interior_flag = local_iflag;
     return (minIndex);
   }
-}
 
-int BasisHitOrthoscopic(BasisCallRec * BC)
-{
-  const float _0 = 0.0F, _1 = 1.0F;
-  float oppSq, dist = _0, sph[3], vt[3], tri1, tri2;
-  int a, b, c, h, *ip;
+private:
+  BasisCallRec *BC;
+  CBasis *BI;
+  RayInfo *r;
+  MapCache *cache;
+  int *cache_cache;
+  int *cache_CacheLink;
+  CPrimitive *r_prim;
+  int minIndex;
+  float back_dist;
+  float r_tri1, r_tri2, r_dist;
+  float r_sphere0, r_sphere1, r_sphere2;
   int excl_trans_flag;
+  int local_iflag;
+  const int *vert2prim;
+  float excl_trans;
+  float BasisFudge0;
+  float BasisFudge1;
+  int n_vert;
+  int except1;
+  int except2;
   int check_interior_flag;
-  int *elist, local_iflag = false;
-  float minusZ[3] = { 0.0F, 0.0F, -1.0F };
+  float vt[3];
+  CPrimitive *BC_prim;
+  int *BI_Vert2Normal;
+  float *BI_Vertex;
+  float *BI_Precomp;
+  float *BI_Normal;
+  float *BI_Radius;
+  float *BI_Radius2;
+};
+
+template <typename Walker>
+static int BasisHitPerspectiveImpl(BasisCallRec * BC, Walker & walk)
+{
+  PerspectiveSearch<Walker::unique> search;
+  const int *ip;
+
+  if(!walk.valid())             /* see if we can eliminate this ray right away */
+    return -1;
+
+  search.start(BC);
+
+  while((ip = walk.next(search.found(), search.dist()))) {
+    if(!search.visit(ip))
+      break;
+  }
 
+  return search.finish();
+}
+
+int BasisHitPerspective(BasisCallRec * BC)
+{
   CBasis *BI = BC->Basis;
-  RayInfo *r = BC->rr;
 
-  if(MapInsideXY(BI->Map, r->base, &a, &b, &c)) {
-    int minIndex = -1;
-    int v2p;
-    int i, ii;
-    int *xxtmp;
-    int do_loop;
-    int except1 = BC->except1;
-    int except2 = BC->except2;
-    int n_vert = BI->NVertex, n_eElem = BI->Map->NEElem;
-    const int *vert2prim = BC->vert2prim;
-    const float front = BC->front;
-    const float back = BC->back;
-    const float excl_trans = BC->excl_trans;
-    const float BasisFudge0 = BC->fudge0;
-    const float BasisFudge1 = BC->fudge1;
-
-    MapCache *cache = &BC->cache;
-
-    float r_tri1 = _0, r_tri2 = _0, r_dist = _0;        /* zero inits to suppress compiler warnings */
-    float r_sphere0 = _0, r_sphere1 = _0, r_sphere2 = _0;
-    CPrimitive *r_prim = NULL;
+  if(BI->BVH) {
+    RayInfo *r = BC->rr;
+    BVHWalker walk(*BI->BVH, r->base, r->dir, -kR_SMALL4, BC->back_dist);
+    return BasisHitPerspectiveImpl(BC, walk);
+  }
+
+  PerspectiveGridWalker walk(BC);
+  return BasisHitPerspectiveImpl(BC, walk);
+}
+
+/* nearest hit along an orthoscopic ray */
+template <bool unique>
+class OrthoscopicSearch {
+public:
+  void start(BasisCallRec * BC_)
+  {
+    BC = BC_;
+    BI = BC->Basis;
+    r = BC->rr;
+
+    minIndex = -1;
+    except1 = BC->except1;
+    except2 = BC->except2;
+    n_vert = BI->NVertex;
+    vert2prim = BC->vert2prim;
+    front = BC->front;
+    back = BC->back;
+    excl_trans = BC->excl_trans;
+    BasisFudge0 = BC->fudge0;
+    BasisFudge1 = BC->fudge1;
+
+    cache = &BC->cache;
+
+    r_tri1 = r_tri2 = 0.0F;     /* zero inits to suppress compiler warnings */
+    r_sphere0 = r_sphere1 = r_sphere2 = 0.0F;
+    r_prim = NULL;
+    local_iflag = false;
 
     check_interior_flag = BC->check_interior && (!BC->pass);
 
@@ -2037,255 +2232,243 @@ int BasisHitOrthoscopic(BasisCallRec * BC)
     if(except2 >= 0)
       except2 = vert2prim[except2];
 
-    excl_trans_flag = (excl_trans != _0);
+    excl_trans_flag = (excl_trans != 0.0F);
 
     r_dist = FLT_MAX;
 
-    xxtmp = BI->Map->EHead + (a * BI->Map->D1D2) + (b * BI->Map->Dim[2]) + c;
+    if(!unique)
+      MapCacheReset(cache);
+  }
 
-    MapCacheReset(cache);
+  bool found() const { return minIndex > -1; }
+  float dist() const { return r_dist; }
 
-    elist = BI->Map->EList;
+  /* tests the primitives of an element list, returns false once the
+     search is complete */
+  bool visit(const int *ip)
+  {
+    const float _0 = 0.0F, _1 = 1.0F;
+    float minusZ[3] = { 0.0F, 0.0F, -1.0F };
+    float oppSq, dist = _0, sph[3], tri1, tri2;
+    int v2p;
+    int i, ii;
+    int do_loop;
 
-    while(c >= MapBorder) {
-      h = *xxtmp;
-      if((h > 0) && (h < n_eElem)) {
-        ip = elist + h;
-        i = *(ip++);
-        do_loop = ((i >= 0) && (i < n_vert));
-        while(do_loop) {
-          ii = *(ip++);
-          v2p = vert2prim[i];
-          do_loop = ((ii >= 0) && (ii < n_vert));
+    i = *(ip++);
+    do_loop = ((i >= 0) && (i < n_vert));
+    while(do_loop) {
+      ii = *(ip++);
+      v2p = vert2prim[i];
+      do_loop = ((ii >= 0) && (ii < n_vert));
 
-          if((v2p != except1) && (v2p != except2) && (!MapCached(cache, v2p))) {
-            CPrimitive *prm = BC->prim + v2p;
-            MapCache(cache, v2p);
+      if((v2p != except1) && (v2p != except2) && (unique || !MapCached(cache, v2p))) {
+        CPrimitive *prm = BC->prim + v2p;
+        if(!unique)
+          MapCache(cache, v2p);
 
-            switch (prm->type) {
-            case cPrimTriangle:
-            case cPrimCharacter:
-              if(!prm->cull) {
-                float *pre = BI->Precomp + BI->Vert2Normal[i] * 3;
+        switch (prm->type) {
+        case cPrimTriangle:
+        case cPrimCharacter:
+          if(!prm->cull) {
+            float *pre = BI->Precomp + BI->Vert2Normal[i] * 3;
 
-                if(pre[6]) {
-                  float *vert0 = BI->Vertex + prm->vert * 3;
+            if(pre[6]) {
+              float *vert0 = BI->Vertex + prm->vert * 3;
 
-                  float tvec0 = vt[0] - vert0[0];
-                  float tvec1 = vt[1] - vert0[1];
+              float tvec0 = vt[0] - vert0[0];
+              float tvec1 = vt[1] - vert0[1];
 
-                  tri1 = (tvec0 * pre[4] - tvec1 * pre[3]) * pre[7];
-                  tri2 = -(tvec0 * pre[1] - tvec1 * pre[0]) * pre[7];
+              tri1 = (tvec0 * pre[4] - tvec1 * pre[3]) * pre[7];
+              tri2 = -(tvec0 * pre[1] - tvec1 * pre[0]) * pre[7];
 
-                  if(!((tri1 < BasisFudge0) || (tri2 < BasisFudge0) ||
-                       (tri1 > BasisFudge1) || ((tri1 + tri2) > BasisFudge1))) {
-                    dist = (r->base[2] - (tri1 * pre[2]) - (tri2 * pre[5]) - vert0[2]);
+              if(!((tri1 < BasisFudge0) || (tri2 < BasisFudge0) ||
+                   (tri1 > BasisFudge1) || ((tri1 + tri2) > BasisFudge1))) {
+                dist = (r->base[2] - (tri1 * pre[2]) - (tri2 * pre[5]) - vert0[2]);
 
-                    if((dist < r_dist) && (dist >= front) &&
-                       (dist <= back) && (prm->trans != _1)) {
-                      minIndex = prm->vert;
-                      r_tri1 = tri1;
-                      r_tri2 = tri2;
-                      r_dist = dist;
-                    }
-                  }
+                if((dist < r_dist) && (dist >= front) &&
+                   (dist <= back) && (prm->trans != _1)) {
+                  minIndex = prm->vert;
+                  r_tri1 = tri1;
+                  r_tri2 = tri2;
+                  r_dist = dist;
                 }
               }
-              break;
-
-            case cPrimSphere:
-              oppSq = ZLineClipPoint(r->base, BI->Vertex + i * 3, &dist, BI->Radius[i]);
-              if(oppSq <= BI->Radius2[i]) {
-                dist = (float) (sqrt1f(dist) - sqrt1f((BI->Radius2[i] - oppSq)));
+            }
+          }
+          break;
 
-                if((dist < r_dist) && (prm->trans != _1)) {
-                  if((dist >= front) && (dist <= back)) {
-                    minIndex = prm->vert;
-                    r_dist = dist;
-                  } else if(check_interior_flag) {
-                    if(diffsq3f(vt, BI->Vertex + i * 3) < BI->Radius2[i]) {
-                      local_iflag = true;
-                      r_prim = prm;
-                      r_dist = front;
-                      minIndex = prm->vert;
-                    }
+        case cPrimSphere:
+          oppSq = ZLineClipPoint(r->base, BI->Vertex + i * 3, &dist, BI->Radius[i]);
+          if(oppSq <= BI->Radius2[i]) {
+            dist = (float) (sqrt1f(dist) - sqrt1f((BI->Radius2[i] - oppSq)));
+
+            if((dist < r_dist) && (prm->trans != _1)) {
+              if((dist >= front) && (dist <= back)) {
+                minIndex = prm->vert;
+                r_dist = dist;
+              } else if(check_interior_flag) {
+                if(diffsq3f(vt, BI->Vertex + i * 3) < BI->Radius2[i]) {
+                  local_iflag = true;
+                  r_prim = prm;
+                  r_dist = front;
+                  minIndex = prm->vert;
+                }
+              }
+            }
+          }
+          break;
+        case cPrimEllipsoid:
+          oppSq = ZLineClipPoint(r->base, BI->Vertex + i * 3, &dist, BI->Radius[i]);
+          if(oppSq <= BI->Radius2[i]) {
+
+            dist = (float) (sqrt1f(dist) - sqrt1f((BI->Radius2[i] - oppSq)));
+
+            if((dist < r_dist) && (prm->trans != _1)) {
+              float *n1 = BI->Normal + BI->Vert2Normal[i] * 3;
+              if(LineClipEllipsoidPoint(r->base, minusZ,
+                                        BI->Vertex + i * 3, &dist,
+                                        BI->Radius[i], BI->Radius2[i],
+                                        prm->n0, n1, n1 + 3, n1 + 6)) {
+                if(dist < r_dist) {
+                  if((dist >= _0) && (dist <= back)) {
+                    minIndex = prm->vert;
+                    r_dist = dist;
                   }
                 }
               }
-              break;
-            case cPrimEllipsoid:
-              oppSq = ZLineClipPoint(r->base, BI->Vertex + i * 3, &dist, BI->Radius[i]);
-              if(oppSq <= BI->Radius2[i]) {
-
-                dist = (float) (sqrt1f(dist) - sqrt1f((BI->Radius2[i] - oppSq)));
+            }
+          }
+          break;
 
-                if((dist < r_dist) && (prm->trans != _1)) {
-                  float *n1 = BI->Normal + BI->Vert2Normal[i] * 3;
-                  if(LineClipEllipsoidPoint(r->base, minusZ,
-                                            BI->Vertex + i * 3, &dist,
-                                            BI->Radius[i], BI->Radius2[i],
-                                            prm->n0, n1, n1 + 3, n1 + 6)) {
-                    if(dist < r_dist) {
-                      if((dist >= _0) && (dist <= back)) {
-                        minIndex = prm->vert;
-                        r_dist = dist;
-                      }
-                    }
+        case cPrimCylinder:
+          if(ZLineToSphereCapped(r->base, BI->Vertex + i * 3,
+                                 BI->Normal + BI->Vert2Normal[i] * 3,
+                                 BI->Radius[i], prm->l1, sph, &tri1, prm->cap1,
+                                 prm->cap2, BI->Precomp + BI->Vert2Normal[i] * 3)) {
+            oppSq = ZLineClipPoint(r->base, sph, &dist, BI->Radius[i]);
+            if(oppSq <= BI->Radius2[i]) {
+              dist = (float) (sqrt1f(dist) - sqrt1f((BI->Radius2[i] - oppSq)));
+
+              if((dist < r_dist) && (prm->trans != _1)) {
+                if((dist >= front) && (dist <= back)) {
+                  if(prm->l1 > kR_SMALL4)
+                    r_tri1 = tri1 / prm->l1;
+
+                  r_sphere0 = sph[0];
+                  r_sphere1 = sph[1];
+                  r_sphere2 = sph[2];
+                  minIndex = prm->vert;
+                  r_dist = dist;
+                } else if(check_interior_flag) {
+                  if(FrontToInteriorSphereCapped(vt,
+                                                 BI->Vertex + i * 3,
+                                                 BI->Normal + BI->Vert2Normal[i] * 3,
+                                                 BI->Radius[i],
+                                                 BI->Radius2[i],
+                                                 prm->l1, prm->cap1, prm->cap2)) {
+                    local_iflag = true;
+                    r_prim = prm;
+                    r_dist = front;
+                    minIndex = prm->vert;
                   }
                 }
               }
-              break;
+            }
+          }
+          break;
+        case cPrimCone:
+          {
+            float sph_rad, sph_rad_sq;
+            if(ConeLineToSphereCapped(r->base, minusZ, BI->Vertex + i * 3,
+                                      BI->Normal + BI->Vert2Normal[i] * 3,
+                                      BI->Radius[i], prm->r2, prm->l1, sph, &tri1,
+                                      &sph_rad, &sph_rad_sq, prm->cap1, prm->cap2)) {
 
-            case cPrimCylinder:
-              if(ZLineToSphereCapped(r->base, BI->Vertex + i * 3,
-                                     BI->Normal + BI->Vert2Normal[i] * 3,
-                                     BI->Radius[i], prm->l1, sph, &tri1, prm->cap1,
-                                     prm->cap2, BI->Precomp + BI->Vert2Normal[i] * 3)) {
-                oppSq = ZLineClipPoint(r->base, sph, &dist, BI->Radius[i]);
-                if(oppSq <= BI->Radius2[i]) {
-                  dist = (float) (sqrt1f(dist) - sqrt1f((BI->Radius2[i] - oppSq)));
-
-                  if((dist < r_dist) && (prm->trans != _1)) {
-                    if((dist >= front) && (dist <= back)) {
-                      if(prm->l1 > kR_SMALL4)
-                        r_tri1 = tri1 / prm->l1;
+              oppSq = ZLineClipPoint(r->base, sph, &dist, sph_rad);
+              if(oppSq <= sph_rad_sq) {
+                dist = (float) (sqrt1f(dist) - sqrt1f((sph_rad_sq - oppSq)));
 
-                      r_sphere0 = sph[0];
-                      r_sphere1 = sph[1];
-                      r_sphere2 = sph[2];
+                if((dist < r_dist) && (prm->trans != _1)) {
+                  if((dist >= front) && (dist <= back)) {
+                    if(prm->l1 > kR_SMALL4)
+                      r_tri1 = tri1 / prm->l1;
+
+                    r_sphere0 = sph[0];
+                    r_sphere1 = sph[1];
+                    r_sphere2 = sph[2];
+                    minIndex = prm->vert;
+                    r_dist = dist;
+                  } else if(check_interior_flag) {
+                    if(FrontToInteriorSphereCapped(vt,
+                                                   BI->Vertex + i * 3,
+                                                   BI->Normal +
+                                                   BI->Vert2Normal[i] * 3, sph_rad,
+                                                   sph_rad_sq, prm->l1, prm->cap1,
+                                                   prm->cap2)) {
+                      local_iflag = true;
+                      r_prim = prm;
+                      r_dist = front;
                       minIndex = prm->vert;
-                      r_dist = dist;
-                    } else if(check_interior_flag) {
-                      if(FrontToInteriorSphereCapped(vt,
-                                                     BI->Vertex + i * 3,
-                                                     BI->Normal + BI->Vert2Normal[i] * 3,
-                                                     BI->Radius[i],
-                                                     BI->Radius2[i],
-                                                     prm->l1, prm->cap1, prm->cap2)) {
-                        local_iflag = true;
-                        r_prim = prm;
-                        r_dist = front;
-                        minIndex = prm->vert;
-                      }
                     }
                   }
                 }
               }
-              break;
-            case cPrimCone:
-              {
-                float sph_rad, sph_rad_sq;
-                if(ConeLineToSphereCapped(r->base, minusZ, BI->Vertex + i * 3,
-                                          BI->Normal + BI->Vert2Normal[i] * 3,
-                                          BI->Radius[i], prm->r2, prm->l1, sph, &tri1,
-                                          &sph_rad, &sph_rad_sq, prm->cap1, prm->cap2)) {
-
-                  oppSq = ZLineClipPoint(r->base, sph, &dist, sph_rad);
-                  if(oppSq <= sph_rad_sq) {
-                    dist = (float) (sqrt1f(dist) - sqrt1f((sph_rad_sq - oppSq)));
-
-                    if((dist < r_dist) && (prm->trans != _1)) {
-                      if((dist >= front) && (dist <= back)) {
-                        if(prm->l1 > kR_SMALL4)
-                          r_tri1 = tri1 / prm->l1;
-
-                        r_sphere0 = sph[0];
-                        r_sphere1 = sph[1];
-                        r_sphere2 = sph[2];
-                        minIndex = prm->vert;
-                        r_dist = dist;
-                      } else if(check_interior_flag) {
-                        if(FrontToInteriorSphereCapped(vt,
-                                                       BI->Vertex + i * 3,
-                                                       BI->Normal +
-                                                       BI->Vert2Normal[i] * 3, sph_rad,
-                                                       sph_rad_sq, prm->l1, prm->cap1,
-                                                       prm->cap2)) {
-                          local_iflag = true;
-                          r_prim = prm;
-                          r_dist = front;
-                          minIndex = prm->vert;
-                        }
-                      }
-                    }
+            }
+          }
+          break;
+        case cPrimSausage:
+          if(ZLineToSphere
+             (r->base, BI->Vertex + i * 3, BI->Normal + BI->Vert2Normal[i] * 3,
+              BI->Radius[i], prm->l1, sph, &tri1,
+              BI->Precomp + BI->Vert2Normal[i] * 3)) {
+            oppSq = ZLineClipPoint(r->base, sph, &dist, BI->Radius[i]);
+            if(oppSq <= BI->Radius2[i]) {
+              int tmp_flag = false;
+
+              dist = (float) (sqrt1f(dist) - sqrt1f((BI->Radius2[i] - oppSq)));
+              if((dist < r_dist) && (prm->trans != _1)) {
+                if((dist >= front) && (dist <= back)) {
+                  tmp_flag = true;
+                  if(excl_trans_flag) {
+                    if((prm->trans > _0) && (dist < excl_trans))
+                      tmp_flag = false;
                   }
-                }
-              }
-              break;
-            case cPrimSausage:
-              if(ZLineToSphere
-                 (r->base, BI->Vertex + i * 3, BI->Normal + BI->Vert2Normal[i] * 3,
-                  BI->Radius[i], prm->l1, sph, &tri1,
-                  BI->Precomp + BI->Vert2Normal[i] * 3)) {
-                oppSq = ZLineClipPoint(r->base, sph, &dist, BI->Radius[i]);
-                if(oppSq <= BI->Radius2[i]) {
-                  int tmp_flag = false;
-
-                  dist = (float) (sqrt1f(dist) - sqrt1f((BI->Radius2[i] - oppSq)));
-                  if((dist < r_dist) && (prm->trans != _1)) {
-                    if((dist >= front) && (dist <= back)) {
-                      tmp_flag = true;
-                      if(excl_trans_flag) {
-                        if((prm->trans > _0) && (dist < excl_trans))
-                          tmp_flag = false;
-                      }
-                      if(tmp_flag) {
-                        if(prm->l1 > kR_SMALL4)
-                          r_tri1 = tri1 / prm->l1;
+                  if(tmp_flag) {
+                    if(prm->l1 > kR_SMALL4)
+                      r_tri1 = tri1 / prm->l1;
 
-                        r_sphere0 = sph[0];
-                        r_sphere1 = sph[1];
-                        r_sphere2 = sph[2];
-                        minIndex = prm->vert;
-                        r_dist = dist;
-                      }
-                    } else if(check_interior_flag) {
-                      if(FrontToInteriorSphere
-                         (vt, BI->Vertex + i * 3, BI->Normal + BI->Vert2Normal[i] * 3,
-                          BI->Radius[i], BI->Radius2[i], prm->l1)) {
-                        local_iflag = true;
-                        r_prim = prm;
-                        r_dist = front;
-                        minIndex = prm->vert;
-                      }
-                    }
+                    r_sphere0 = sph[0];
+                    r_sphere1 = sph[1];
+                    r_sphere2 = sph[2];
+                    minIndex = prm->vert;
+                    r_dist = dist;
+                  }
+                } else if(check_interior_flag) {
+                  if(FrontToInteriorSphere
+                     (vt, BI->Vertex + i * 3, BI->Normal + BI->Vert2Normal[i] * 3,
+                      BI->Radius[i], BI->Radius2[i], prm->l1)) {
+                    local_iflag = true;
+                    r_prim = prm;
+                    r_dist = front;
+                    minIndex = prm->vert;
                   }
                 }
               }
-              break;
-            }                   /* end of switch */
+            }
           }
-          /* end of if */
-          i = ii;
-
-        }                       /* end of while */
-      }
-
-      /* and of course stop when we hit the edge of the map */
-
-      if(local_iflag)
-        break;
-
-      /* we've processed all primitives associated with this voxel, 
-         so if an intersection has been found which occurs in front of
-         the next voxel, then we can stop */
-
-      if(minIndex > -1) {
-        int aa, bb, cc;
-
-        vt[2] = r->base[2] - r_dist;
-        MapLocus(BI->Map, vt, &aa, &bb, &cc);
-        if(cc > c)
           break;
-        else
-          vt[2] = r->base[2] - front;
+        }                   /* end of switch */
       }
+      /* end of if */
+      i = ii;
 
-      c--;
-      xxtmp--;
+    }                       /* end of while */
 
-    }                           /* end of while */
+    return !local_iflag;
+  }
 
+  int finish()
+  {
     if(minIndex > -1) {
       r_prim = BC->prim + vert2prim[minIndex];
 
@@ -2306,50 +2489,99 @@ int BasisHitOrthoscopic(BasisCallRec * BC)
     r->sphere[1] = r_sphere1;
     r->sphere[2] = r_sphere2;
     return (minIndex);
-  }                             /* end of if */
-  BC->interior_flag = local_iflag;
-  return (-1);
-}
+  }
 
-int BasisHitShadow(BasisCallRec * BC)
+private:
+  BasisCallRec *BC;
+  CBasis *BI;
+  RayInfo *r;
+  float vt[3];
+  int minIndex;
+  int except1;
+  int except2;
+  int n_vert;
+  const int *vert2prim;
+  float front;
+  float back;
+  float excl_trans;
+  float BasisFudge0;
+  float BasisFudge1;
+  MapCache *cache;
+  float r_tri1, r_tri2, r_dist;
+  float r_sphere0, r_sphere1, r_sphere2;
+  CPrimitive *r_prim;
+  int check_interior_flag;
+  int excl_trans_flag;
+  int local_iflag;
+};
+
+template <typename Walker>
+static int BasisHitOrthoscopicImpl(BasisCallRec * BC, Walker & walk)
 {
-  const float _0 = 0.0F;
-  const float _1 = 1.0F;
-  float oppSq, dist = _0, tri1, tri2;
-  float sph[3], vt[3];
-  int h, *ip;
-  int a, b, c;
-  int *elist, local_iflag = false;
-  float minusZ[3] = { 0.0F, 0.0F, -1.0F };
-  /* local copies (eliminate these extra copies later on) */
+  OrthoscopicSearch<Walker::unique> search;
+  const int *ip;
+
+  if(!walk.valid()) {
+    BC->interior_flag = false;
+    return (-1);
+  }
+
+  search.start(BC);
 
+  while((ip = walk.next(search.found(), search.dist()))) {
+    if(!search.visit(ip))
+      break;
+  }
+
+  return search.finish();
+}
+
+int BasisHitOrthoscopic(BasisCallRec * BC)
+{
   CBasis *BI = BC->Basis;
   RayInfo *r = BC->rr;
 
-  if(MapInsideXY(BI->Map, r->base, &a, &b, &c)) {
-    int minIndex = -1;
-    int v2p;
-    int i, ii;
-    int *xxtmp;
-
-    int n_vert = BI->NVertex, n_eElem = BI->Map->NEElem;
-    int except1 = BC->except1;
-    int except2 = BC->except2;
-    const int *vert2prim = BC->vert2prim;
-    const int trans_shadows = BC->trans_shadows;
-    const int nearest_shadow = BC->nearest_shadow;
-    const float BasisFudge0 = BC->fudge0;
-    const float BasisFudge1 = BC->fudge1;
-    const int label_shadow_mode = BC->label_shadow_mode;
-    MapCache *cache = &BC->cache;
-    int *cache_cache = cache->Cache;
-    int *cache_CacheLink = cache->CacheLink;
-    CPrimitive *BC_prim = BC->prim;
-
-    float r_tri1 = _0, r_tri2 = _0, r_dist;    /* zero inits to suppress compiler warnings */
-    float r_sphere0 = _0, r_sphere1 = _0, r_sphere2 = _0;
-    float r_trans = _0;
-    CPrimitive *r_prim = NULL;
+  if(BI->BVH) {
+    const float minusZ[3] = { 0.0F, 0.0F, -1.0F };
+    BVHWalker walk(*BI->BVH, r->base, minusZ,
+                   std::min(BC->front, 0.0F) - kR_SMALL4, BC->back);
+    return BasisHitOrthoscopicImpl(BC, walk);
+  }
+
+  ZGridWalker walk(BI, r->base, true);
+  return BasisHitOrthoscopicImpl(BC, walk);
+}
+
+/* occluding hit along a shadow ray */
+template <bool unique>
+class ShadowSearch {
+public:
+  void start(BasisCallRec * BC_)
+  {
+    BC = BC_;
+    BI = BC->Basis;
+    r = BC->rr;
+
+    minIndex = -1;
+    n_vert = BI->NVertex;
+    except1 = BC->except1;
+    except2 = BC->except2;
+    vert2prim = BC->vert2prim;
+    trans_shadows = BC->trans_shadows;
+    nearest_shadow = BC->nearest_shadow;
+    BasisFudge0 = BC->fudge0;
+    BasisFudge1 = BC->fudge1;
+    label_shadow_mode = BC->label_shadow_mode;
+    cache = &BC->cache;
+    cache_cache = cache->Cache;
+    cache_CacheLink = cache->CacheLink;
+    BC_prim = BC->prim;
+
+    r_tri1 = r_tri2 = 0.0F;     /* zero inits to suppress compiler warnings */
+    r_sphere0 = r_sphere1 = r_sphere2 = 0.0F;
+    r_prim = NULL;
+    local_iflag = false;
+    m_opaque = false;
 
     /* assumption: always heading in the negative Z direction with our vector... */
     vt[0] = r->base[0];
@@ -2360,178 +2592,236 @@ int BasisHitShadow(BasisCallRec * BC)
     if(except2 >= 0)
       except2 = vert2prim[except2];
 
-    r_trans = _1;
+    r_trans = 1.0F;
     r_dist = FLT_MAX;
 
-    xxtmp = BI->Map->EHead + (a * BI->Map->D1D2) + (b * BI->Map->Dim[2]) + c;
-
-    MapCacheReset(cache);
-
-    elist = BI->Map->EList;
-
-    while(c >= MapBorder) {
-      h = *xxtmp;
-      if((h > 0) && (h < n_eElem)) {
-        int do_loop;
-        ip = elist + h;
-        i = *(ip++);
-        do_loop = ((i >= 0) && (i < n_vert));
-        while(do_loop) {
-          ii = *(ip++);
-          v2p = vert2prim[i];
-          do_loop = ((ii >= 0) && (ii < n_vert));
-          if((v2p != except1) && (v2p != except2) && !MapCached(cache, v2p)) {
-            CPrimitive *prm = BC_prim + v2p;
-            int prm_type;
-
-            /*MapCache(cache,v2p); */
-            cache_cache[v2p] = 1;
-            prm_type = prm->type;
-            cache_CacheLink[v2p] = cache->CacheStart;
-            cache->CacheStart = v2p;
-
-            switch (prm_type) {
-            case cPrimCharacter:       /* will need special handling for character shadows */
-              if(label_shadow_mode & 0x2) {     /* if labels case shadows... */
-                float *pre = BI->Precomp + BI->Vert2Normal[i] * 3;
-
-                if(pre[6]) {
-                  float *vert0 = BI->Vertex + prm->vert * 3;
-
-                  float tvec0 = vt[0] - vert0[0];
-                  float tvec1 = vt[1] - vert0[1];
-
-                  tri1 = (tvec0 * pre[4] - tvec1 * pre[3]) * pre[7];
-                  tri2 = -(tvec0 * pre[1] - tvec1 * pre[0]) * pre[7];
-
-                  if(!((tri1 < BasisFudge0) ||
-                       (tri2 < BasisFudge0) ||
-                       (tri1 > BasisFudge1) || ((tri1 + tri2) > BasisFudge1))) {
-                    dist = (r->base[2] - (tri1 * pre[2]) - (tri2 * pre[5]) - vert0[2]);
-
-                    {
-                      float fc[3];
-                      float trans;
-
-                      r->tri1 = tri1;
-                      r->tri2 = tri2;
-                      r->dist = dist;
-                      r->prim = prm;
+    if(!unique)
+      MapCacheReset(cache);
+  }
 
-                      {
-                        float w2;
-                        w2 = _1 - (r->tri1 + r->tri2);
-
-                        fc[0] =
-                          (prm->c2[0] * r->tri1) + (prm->c3[0] * r->tri2) +
-                          (prm->c1[0] * w2);
-                        fc[1] =
-                          (prm->c2[1] * r->tri1) + (prm->c3[1] * r->tri2) +
-                          (prm->c1[1] * w2);
-                        fc[2] =
-                          (prm->c2[2] * r->tri1) + (prm->c3[2] * r->tri2) +
-                          (prm->c1[2] * w2);
-                      }
+  bool found() const { return minIndex > -1; }
 
-                      trans = CharacterInterpolate(BI->G, prm->char_id, fc);
-
-                      if(trans == _0) { /* opaque? return immed. */
-                        if(dist > -kR_SMALL4) {
-                          if(nearest_shadow) {
-                            if(dist < r_dist) {
-                              minIndex = prm->vert;
-                              r_tri1 = tri1;
-                              r_tri2 = tri2;
-                              r_dist = dist;
-                              r_trans = (r->trans = trans);
-                            }
-                          } else {
-                            r->prim = prm;
-                            r->trans = _0;
-                            r->dist = dist;
-                            return (1);
-                          }
-                        }
-                      } else if(trans_shadows) {
-                        if((dist > -kR_SMALL4) &&
-                           ((r_trans > trans) ||
-                            (nearest_shadow && (dist < r_dist) && (r_trans >= trans)))) {
+  /* transparent surfaces don't occlude, so the search can only be
+     narrowed down once an opaque hit was found */
+  float dist() const
+  {
+    return (nearest_shadow && (r_trans == 0.0F)) ? r_dist : FLT_MAX;
+  }
+
+  /* tests the primitives of an element list, returns false once the
+     search is complete */
+  bool visit(const int *ip)
+  {
+    const float _0 = 0.0F;
+    const float _1 = 1.0F;
+    float minusZ[3] = { 0.0F, 0.0F, -1.0F };
+    float oppSq, dist = _0, tri1, tri2;
+    float sph[3];
+    int v2p;
+    int i, ii;
+
+    int do_loop;
+    i = *(ip++);
+    do_loop = ((i >= 0) && (i < n_vert));
+    while(do_loop) {
+      ii = *(ip++);
+      v2p = vert2prim[i];
+      do_loop = ((ii >= 0) && (ii < n_vert));
+      if((v2p != except1) && (v2p != except2) && (unique || !MapCached(cache, v2p))) {
+        CPrimitive *prm = BC_prim + v2p;
+        int prm_type;
+
+        /*MapCache(cache,v2p); */
+        prm_type = prm->type;
+        if(!unique) {
+          cache_cache[v2p] = 1;
+          cache_CacheLink[v2p] = cache->CacheStart;
+          cache->CacheStart = v2p;
+        }
+
+        switch (prm_type) {
+        case cPrimCharacter:       /* will need special handling for character shadows */
+          if(label_shadow_mode & 0x2) {     /* if labels case shadows... */
+            float *pre = BI->Precomp + BI->Vert2Normal[i] * 3;
+
+            if(pre[6]) {
+              float *vert0 = BI->Vertex + prm->vert * 3;
+
+              float tvec0 = vt[0] - vert0[0];
+              float tvec1 = vt[1] - vert0[1];
+
+              tri1 = (tvec0 * pre[4] - tvec1 * pre[3]) * pre[7];
+              tri2 = -(tvec0 * pre[1] - tvec1 * pre[0]) * pre[7];
+
+              if(!((tri1 < BasisFudge0) ||
+                   (tri2 < BasisFudge0) ||
+                   (tri1 > BasisFudge1) || ((tri1 + tri2) > BasisFudge1))) {
+                dist = (r->base[2] - (tri1 * pre[2]) - (tri2 * pre[5]) - vert0[2]);
+
+                {
+                  float fc[3];
+                  float trans;
+
+                  r->tri1 = tri1;
+                  r->tri2 = tri2;
+                  r->dist = dist;
+                  r->prim = prm;
+
+                  {
+                    float w2;
+                    w2 = _1 - (r->tri1 + r->tri2);
+
+                    fc[0] =
+                      (prm->c2[0] * r->tri1) + (prm->c3[0] * r->tri2) +
+                      (prm->c1[0] * w2);
+                    fc[1] =
+                      (prm->c2[1] * r->tri1) + (prm->c3[1] * r->tri2) +
+                      (prm->c1[1] * w2);
+                    fc[2] =
+                      (prm->c2[2] * r->tri1) + (prm->c3[2] * r->tri2) +
+                      (prm->c1[2] * w2);
+                  }
+
+                  trans = CharacterInterpolate(BI->G, prm->char_id, fc);
+
+                  if(trans == _0) { /* opaque? return immed. */
+                    if(dist > -kR_SMALL4) {
+                      if(nearest_shadow) {
+                        if(dist < r_dist) {
                           minIndex = prm->vert;
                           r_tri1 = tri1;
                           r_tri2 = tri2;
                           r_dist = dist;
                           r_trans = (r->trans = trans);
                         }
+                      } else {
+                        r->prim = prm;
+                        r->trans = _0;
+                        r->dist = dist;
+                        return opaque();
                       }
                     }
+                  } else if(trans_shadows) {
+                    if((dist > -kR_SMALL4) &&
+                       ((r_trans > trans) ||
+                        (nearest_shadow && (dist < r_dist) && (r_trans >= trans)))) {
+                      minIndex = prm->vert;
+                      r_tri1 = tri1;
+                      r_tri2 = tri2;
+                      r_dist = dist;
+                      r_trans = (r->trans = trans);
+                    }
                   }
                 }
               }
-              break;
+            }
+          }
+          break;
 
-            case cPrimTriangle:
-              {
-                float *pre = BI->Precomp + BI->Vert2Normal[i] * 3;
+        case cPrimTriangle:
+          {
+            float *pre = BI->Precomp + BI->Vert2Normal[i] * 3;
 
-                if(pre[6]) {
-                  float *vert0 = BI->Vertex + prm->vert * 3;
+            if(pre[6]) {
+              float *vert0 = BI->Vertex + prm->vert * 3;
 
-                  float tvec0 = vt[0] - vert0[0];
-                  float tvec1 = vt[1] - vert0[1];
+              float tvec0 = vt[0] - vert0[0];
+              float tvec1 = vt[1] - vert0[1];
 
-                  tri1 = (tvec0 * pre[4] - tvec1 * pre[3]) * pre[7];
-                  tri2 = -(tvec0 * pre[1] - tvec1 * pre[0]) * pre[7];
-                  if(!((tri1 < BasisFudge0) ||
-                       (tri2 < BasisFudge0) ||
-                       (tri1 > BasisFudge1) || ((tri1 + tri2) > BasisFudge1))) {
-                    float *tr = prm->tr;
-                    float trans = _0;
+              tri1 = (tvec0 * pre[4] - tvec1 * pre[3]) * pre[7];
+              tri2 = -(tvec0 * pre[1] - tvec1 * pre[0]) * pre[7];
+              if(!((tri1 < BasisFudge0) ||
+                   (tri2 < BasisFudge0) ||
+                   (tri1 > BasisFudge1) || ((tri1 + tri2) > BasisFudge1))) {
+                float *tr = prm->tr;
+                float trans = _0;
 
-                    dist = (r->base[2] - (tri1 * pre[2]) - (tri2 * pre[5]) - vert0[2]);
+                dist = (r->base[2] - (tri1 * pre[2]) - (tri2 * pre[5]) - vert0[2]);
 
-                    if(prm->trans != _0) {
-                      trans =
-                        (tr[1] * tri1) + (tr[2] * tri2) + (tr[0] * (_1 - (tri1 + tri2)));
-                    }
+                if(prm->trans != _0) {
+                  trans =
+                    (tr[1] * tri1) + (tr[2] * tri2) + (tr[0] * (_1 - (tri1 + tri2)));
+                }
 
-                    if(trans == _0) {
-                      if(dist > -kR_SMALL4) {
-                        if(nearest_shadow) {    /* do we need the nearest shadow? */
-                          if(dist < r_dist) {
-                            minIndex = prm->vert;
-                            r_tri1 = tri1;
-                            r_tri2 = tri2;
-                            r_dist = dist;
-                            r_trans = (r->trans = trans);
-                          }
-                        } else {
-                          r->prim = prm;
-                          r->trans = _0;
-                          r->dist = dist;
-                          return (1);
-                        }
-                      }
-                    } else if(trans_shadows) {
-                      if((dist > -kR_SMALL4) &&
-                         ((r_trans > trans) ||
-                          (nearest_shadow && (dist < r_dist) && (r_trans >= trans)))) {
+                if(trans == _0) {
+                  if(dist > -kR_SMALL4) {
+                    if(nearest_shadow) {    /* do we need the nearest shadow? */
+                      if(dist < r_dist) {
                         minIndex = prm->vert;
                         r_tri1 = tri1;
                         r_tri2 = tri2;
                         r_dist = dist;
                         r_trans = (r->trans = trans);
                       }
+                    } else {
+                      r->prim = prm;
+                      r->trans = _0;
+                      r->dist = dist;
+                      return opaque();
                     }
                   }
+                } else if(trans_shadows) {
+                  if((dist > -kR_SMALL4) &&
+                     ((r_trans > trans) ||
+                      (nearest_shadow && (dist < r_dist) && (r_trans >= trans)))) {
+                    minIndex = prm->vert;
+                    r_tri1 = tri1;
+                    r_tri2 = tri2;
+                    r_dist = dist;
+                    r_trans = (r->trans = trans);
+                  }
                 }
               }
-              break;
+            }
+          }
+          break;
+
+        case cPrimSphere:
+
+          oppSq = ZLineClipPoint(r->base, BI->Vertex + i * 3, &dist, BI->Radius[i]);
+          if(oppSq <= BI->Radius2[i]) {
+            dist = (float) (sqrt1f(dist) - sqrt1f((BI->Radius2[i] - oppSq)));
+
+            if(prm->trans == _0) {
+              if(dist > -kR_SMALL4) {
+                if(nearest_shadow) {
+                  if(dist < r_dist) {
+                    minIndex = prm->vert;
+                    r_dist = dist;
+                    r_trans = (r->trans = prm->trans);
+                  }
+                } else {
+                  r->prim = prm;
+                  r->trans = prm->trans;
+                  r->dist = dist;
+                  return opaque();
+                }
+              }
+            } else if(trans_shadows) {
+              if((dist > -kR_SMALL4) &&
+                 ((r_trans > prm->trans) ||
+                  (nearest_shadow && (dist < r_dist) && (r_trans >= prm->trans)))) {
+                minIndex = prm->vert;
+                r_dist = dist;
+                r_trans = (r->trans = prm->trans);
+              }
+            }
+          }
+          break;
 
-            case cPrimSphere:
+        case cPrimEllipsoid:
+
+          oppSq =
+            ZLineClipPointNoZCheck(r->base, BI->Vertex + i * 3, &dist, BI->Radius[i]);
+          if(oppSq <= BI->Radius2[i]) {
+            dist = (float) (sqrt1f(dist) - sqrt1f((BI->Radius2[i] - oppSq)));
 
-              oppSq = ZLineClipPoint(r->base, BI->Vertex + i * 3, &dist, BI->Radius[i]);
-              if(oppSq <= BI->Radius2[i]) {
-                dist = (float) (sqrt1f(dist) - sqrt1f((BI->Radius2[i] - oppSq)));
+            if((dist < r_dist) || (trans_shadows && (r_trans != _0))) {
+              float *n1 = BI->Normal + BI->Vert2Normal[i] * 3;
+              if(LineClipEllipsoidPoint(r->base, minusZ,
+                                        BI->Vertex + i * 3, &dist,
+                                        BI->Radius[i], BI->Radius2[i],
+                                        prm->n0, n1, n1 + 3, n1 + 6)) {
 
                 if(prm->trans == _0) {
                   if(dist > -kR_SMALL4) {
@@ -2545,102 +2835,39 @@ int BasisHitShadow(BasisCallRec * BC)
                       r->prim = prm;
                       r->trans = prm->trans;
                       r->dist = dist;
-                      return (1);
+                      return opaque();
                     }
                   }
                 } else if(trans_shadows) {
                   if((dist > -kR_SMALL4) &&
                      ((r_trans > prm->trans) ||
-                      (nearest_shadow && (dist < r_dist) && (r_trans >= prm->trans)))) {
+                      (nearest_shadow && (dist < r_dist)
+                       && (r_trans >= prm->trans)))) {
                     minIndex = prm->vert;
                     r_dist = dist;
                     r_trans = (r->trans = prm->trans);
                   }
                 }
               }
-              break;
+            }
+          }
+          break;
+        case cPrimCone:
+          {
+            float sph_rad, sph_rad_sq;
+            if(ConeLineToSphereCapped(r->base, minusZ, BI->Vertex + i * 3,
+                                      BI->Normal + BI->Vert2Normal[i] * 3,
+                                      BI->Radius[i], prm->r2, prm->l1, sph, &tri1,
+                                      &sph_rad, &sph_rad_sq, cCylCap::Flat, cCylCap::Flat)) {
 
-            case cPrimEllipsoid:
-
-              oppSq =
-                ZLineClipPointNoZCheck(r->base, BI->Vertex + i * 3, &dist, BI->Radius[i]);
-              if(oppSq <= BI->Radius2[i]) {
-                dist = (float) (sqrt1f(dist) - sqrt1f((BI->Radius2[i] - oppSq)));
-
-                if((dist < r_dist) || (trans_shadows && (r_trans != _0))) {
-                  float *n1 = BI->Normal + BI->Vert2Normal[i] * 3;
-                  if(LineClipEllipsoidPoint(r->base, minusZ,
-                                            BI->Vertex + i * 3, &dist,
-                                            BI->Radius[i], BI->Radius2[i],
-                                            prm->n0, n1, n1 + 3, n1 + 6)) {
-
-                    if(prm->trans == _0) {
-                      if(dist > -kR_SMALL4) {
-                        if(nearest_shadow) {
-                          if(dist < r_dist) {
-                            minIndex = prm->vert;
-                            r_dist = dist;
-                            r_trans = (r->trans = prm->trans);
-                          }
-                        } else {
-                          r->prim = prm;
-                          r->trans = prm->trans;
-                          r->dist = dist;
-                          return (1);
-                        }
-                      }
-                    } else if(trans_shadows) {
-                      if((dist > -kR_SMALL4) &&
-                         ((r_trans > prm->trans) ||
-                          (nearest_shadow && (dist < r_dist)
-                           && (r_trans >= prm->trans)))) {
-                        minIndex = prm->vert;
-                        r_dist = dist;
-                        r_trans = (r->trans = prm->trans);
-                      }
-                    }
-                  }
-                }
-              }
-              break;
-            case cPrimCone:
-              {
-                float sph_rad, sph_rad_sq;
-                if(ConeLineToSphereCapped(r->base, minusZ, BI->Vertex + i * 3,
-                                          BI->Normal + BI->Vert2Normal[i] * 3,
-                                          BI->Radius[i], prm->r2, prm->l1, sph, &tri1,
-                                          &sph_rad, &sph_rad_sq, cCylCap::Flat, cCylCap::Flat)) {
-
-                  oppSq = ZLineClipPoint(r->base, sph, &dist, sph_rad);
-                  if(oppSq <= sph_rad_sq) {
-                    dist = (float) (sqrt1f(dist) - sqrt1f((sph_rad_sq - oppSq)));
-
-                    if(prm->trans == _0) {
-                      if(dist > -kR_SMALL4) {
-                        if(nearest_shadow) {
-                          if(dist < r_dist) {
-                            if(prm->l1 > kR_SMALL4)
-                              r_tri1 = tri1 / prm->l1;
-                            r_sphere0 = sph[0];
-                            r_sphere1 = sph[1];
-                            r_sphere2 = sph[2];
-                            minIndex = prm->vert;
-                            r->trans = prm->trans;
-                            r_dist = dist;
-                            r_trans = (r->trans = prm->trans);
-                          }
-                        } else {
-                          r->prim = prm;
-                          r->trans = prm->trans;
-                          r->dist = dist;
-                          return (1);
-                        }
-                      }
-                    } else if(trans_shadows) {
-                      if((dist > -kR_SMALL4) &&
-                         ((r_trans > prm->trans) ||
-                          (nearest_shadow && (dist < r_dist)
-                           && (r_trans >= prm->trans)))) {
+              oppSq = ZLineClipPoint(r->base, sph, &dist, sph_rad);
+              if(oppSq <= sph_rad_sq) {
+                dist = (float) (sqrt1f(dist) - sqrt1f((sph_rad_sq - oppSq)));
+
+                if(prm->trans == _0) {
+                  if(dist > -kR_SMALL4) {
+                    if(nearest_shadow) {
+                      if(dist < r_dist) {
                         if(prm->l1 > kR_SMALL4)
                           r_tri1 = tri1 / prm->l1;
                         r_sphere0 = sph[0];
@@ -2651,46 +2878,47 @@ int BasisHitShadow(BasisCallRec * BC)
                         r_dist = dist;
                         r_trans = (r->trans = prm->trans);
                       }
+                    } else {
+                      r->prim = prm;
+                      r->trans = prm->trans;
+                      r->dist = dist;
+                      return opaque();
                     }
                   }
+                } else if(trans_shadows) {
+                  if((dist > -kR_SMALL4) &&
+                     ((r_trans > prm->trans) ||
+                      (nearest_shadow && (dist < r_dist)
+                       && (r_trans >= prm->trans)))) {
+                    if(prm->l1 > kR_SMALL4)
+                      r_tri1 = tri1 / prm->l1;
+                    r_sphere0 = sph[0];
+                    r_sphere1 = sph[1];
+                    r_sphere2 = sph[2];
+                    minIndex = prm->vert;
+                    r->trans = prm->trans;
+                    r_dist = dist;
+                    r_trans = (r->trans = prm->trans);
+                  }
                 }
               }
-              break;
-            case cPrimCylinder:
-              if(ZLineToSphereCapped(r->base, BI->Vertex + i * 3,
-                                     BI->Normal + BI->Vert2Normal[i] * 3,
-                                     BI->Radius[i], prm->l1, sph, &tri1, prm->cap1,
-                                     prm->cap2, BI->Precomp + BI->Vert2Normal[i] * 3)) {
-
-                oppSq = ZLineClipPoint(r->base, sph, &dist, BI->Radius[i]);
-                if(oppSq <= BI->Radius2[i]) {
-                  dist = (float) (sqrt1f(dist) - sqrt1f((BI->Radius2[i] - oppSq)));
-
-                  if(prm->trans == _0) {
-                    if(dist > -kR_SMALL4) {
-                      if(nearest_shadow) {
-                        if(dist < r_dist) {
-                          if(prm->l1 > kR_SMALL4)
-                            r_tri1 = tri1 / prm->l1;
-                          r_sphere0 = sph[0];
-                          r_sphere1 = sph[1];
-                          r_sphere2 = sph[2];
-                          minIndex = prm->vert;
-                          r->trans = prm->trans;
-                          r_dist = dist;
-                          r_trans = (r->trans = prm->trans);
-                        }
-                      } else {
-                        r->prim = prm;
-                        r->trans = prm->trans;
-                        r->dist = dist;
-                        return (1);
-                      }
-                    }
-                  } else if(trans_shadows) {
-                    if((dist > -kR_SMALL4) &&
-                       ((r_trans > prm->trans) ||
-                        (nearest_shadow && (dist < r_dist) && (r_trans >= prm->trans)))) {
+            }
+          }
+          break;
+        case cPrimCylinder:
+          if(ZLineToSphereCapped(r->base, BI->Vertex + i * 3,
+                                 BI->Normal + BI->Vert2Normal[i] * 3,
+                                 BI->Radius[i], prm->l1, sph, &tri1, prm->cap1,
+                                 prm->cap2, BI->Precomp + BI->Vert2Normal[i] * 3)) {
+
+            oppSq = ZLineClipPoint(r->base, sph, &dist, BI->Radius[i]);
+            if(oppSq <= BI->Radius2[i]) {
+              dist = (float) (sqrt1f(dist) - sqrt1f((BI->Radius2[i] - oppSq)));
+
+              if(prm->trans == _0) {
+                if(dist > -kR_SMALL4) {
+                  if(nearest_shadow) {
+                    if(dist < r_dist) {
                       if(prm->l1 > kR_SMALL4)
                         r_tri1 = tri1 / prm->l1;
                       r_sphere0 = sph[0];
@@ -2701,47 +2929,47 @@ int BasisHitShadow(BasisCallRec * BC)
                       r_dist = dist;
                       r_trans = (r->trans = prm->trans);
                     }
+                  } else {
+                    r->prim = prm;
+                    r->trans = prm->trans;
+                    r->dist = dist;
+                    return opaque();
                   }
                 }
+              } else if(trans_shadows) {
+                if((dist > -kR_SMALL4) &&
+                   ((r_trans > prm->trans) ||
+                    (nearest_shadow && (dist < r_dist) && (r_trans >= prm->trans)))) {
+                  if(prm->l1 > kR_SMALL4)
+                    r_tri1 = tri1 / prm->l1;
+                  r_sphere0 = sph[0];
+                  r_sphere1 = sph[1];
+                  r_sphere2 = sph[2];
+                  minIndex = prm->vert;
+                  r->trans = prm->trans;
+                  r_dist = dist;
+                  r_trans = (r->trans = prm->trans);
+                }
               }
-              break;
-
-            case cPrimSausage:
-              if(ZLineToSphere
-                 (r->base, BI->Vertex + i * 3, BI->Normal + BI->Vert2Normal[i] * 3,
-                  BI->Radius[i], prm->l1, sph, &tri1,
-                  BI->Precomp + BI->Vert2Normal[i] * 3)) {
-                oppSq = ZLineClipPoint(r->base, sph, &dist, BI->Radius[i]);
-                if(oppSq <= BI->Radius2[i]) {
-                  dist = (float) (sqrt1f(dist) - sqrt1f((BI->Radius2[i] - oppSq)));
+            }
+          }
+          break;
 
-                  if(prm->trans == _0) {
-                    if(dist > -kR_SMALL4) {
-                      if(nearest_shadow) {
-                        if(dist < r_dist) {
-                          if(prm->l1 > kR_SMALL4)
-                            r_tri1 = tri1 / prm->l1;
-                          r_sphere0 = sph[0];
-                          r_sphere1 = sph[1];
-                          r_sphere2 = sph[2];
-                          minIndex = prm->vert;
-                          r_dist = dist;
-                          r_trans = (r->trans = prm->trans);
-                        }
-                      } else {
-                        r->prim = prm;
-                        r->trans = prm->trans;
-                        r->dist = dist;
-                        return (1);
-                      }
-                    }
-                  } else if(trans_shadows) {
-                    if((dist > -kR_SMALL4) &&
-                       ((r_trans > prm->trans) ||
-                        (nearest_shadow && (dist < r_dist) && (r_trans >= prm->trans)))) {
+        case cPrimSausage:
+          if(ZLineToSphere
+             (r->base, BI->Vertex + i * 3, BI->Normal + BI->Vert2Normal[i] * 3,
+              BI->Radius[i], prm->l1, sph, &tri1,
+              BI->Precomp + BI->Vert2Normal[i] * 3)) {
+            oppSq = ZLineClipPoint(r->base, sph, &dist, BI->Radius[i]);
+            if(oppSq <= BI->Radius2[i]) {
+              dist = (float) (sqrt1f(dist) - sqrt1f((BI->Radius2[i] - oppSq)));
+
+              if(prm->trans == _0) {
+                if(dist > -kR_SMALL4) {
+                  if(nearest_shadow) {
+                    if(dist < r_dist) {
                       if(prm->l1 > kR_SMALL4)
                         r_tri1 = tri1 / prm->l1;
-
                       r_sphere0 = sph[0];
                       r_sphere1 = sph[1];
                       r_sphere2 = sph[2];
@@ -2749,43 +2977,44 @@ int BasisHitShadow(BasisCallRec * BC)
                       r_dist = dist;
                       r_trans = (r->trans = prm->trans);
                     }
+                  } else {
+                    r->prim = prm;
+                    r->trans = prm->trans;
+                    r->dist = dist;
+                    return opaque();
                   }
                 }
+              } else if(trans_shadows) {
+                if((dist > -kR_SMALL4) &&
+                   ((r_trans > prm->trans) ||
+                    (nearest_shadow && (dist < r_dist) && (r_trans >= prm->trans)))) {
+                  if(prm->l1 > kR_SMALL4)
+                    r_tri1 = tri1 / prm->l1;
+
+                  r_sphere0 = sph[0];
+                  r_sphere1 = sph[1];
+                  r_sphere2 = sph[2];
+                  minIndex = prm->vert;
+                  r_dist = dist;
+                  r_trans = (r->trans = prm->trans);
+                }
               }
-              break;
-            }                   /* end of switch */
+            }
           }
-          /* end of if */
-          i = ii;
-        }                       /* end of while */
+          break;
+        }                   /* end of switch */
       }
+      /* end of if */
+      i = ii;
+    }                       /* end of while */
 
-      /* and of course stop when we hit the edge of the map */
-
-      if(local_iflag)
-        break;
-
-      /* we've processed all primitives associated with this voxel, 
-         so if an intersection has been found which occurs in front of
-         the next voxel, then we can stop */
-
-      /* this optimization invalid for transparent surfaces 
-
-         if( minIndex > -1 ) 
-         {
-         int   aa,bb,cc;
-
-         vt[2]   = r->base[2] - r_dist;
-         MapLocus(BI->Map,vt,&aa,&bb,&cc);
-         if(cc > c) 
-         break;
-         }
-       */
-
-      c--;
-      xxtmp--;
+    return !local_iflag;
+  }
 
-    }                           /* end of while */
+  int finish()
+  {
+    if(m_opaque)
+      return (1);
 
     if(minIndex > -1) {
       r_prim = BC->prim + vert2prim[minIndex];
@@ -2808,11 +3037,231 @@ int BasisHitShadow(BasisCallRec * BC)
     r->sphere[1] = r_sphere1;
     r->sphere[2] = r_sphere2;
     return (minIndex);
-  }                             /* end of if */
-  BC->interior_flag = local_iflag;
-  return (-1);
+  }
+
+private:
+  /* first opaque hit, which ends the search unless nearest_shadow is set */
+  bool opaque()
+  {
+    m_opaque = true;
+    return false;
+  }
+
+  BasisCallRec *BC;
+  CBasis *BI;
+  RayInfo *r;
+  float vt[3];
+  int minIndex;
+  int n_vert;
+  int except1;
+  int except2;
+  const int *vert2prim;
+  int trans_shadows;
+  int nearest_shadow;
+  float BasisFudge0;
+  float BasisFudge1;
+  int label_shadow_mode;
+  MapCache *cache;
+  int *cache_cache;
+  int *cache_CacheLink;
+  CPrimitive *BC_prim;
+  float r_tri1, r_tri2, r_dist;
+  float r_sphere0, r_sphere1, r_sphere2;
+  float r_trans;
+  CPrimitive *r_prim;
+  int local_iflag;
+  bool m_opaque;
+};
+
+template <typename Walker>
+static int BasisHitShadowImpl(BasisCallRec * BC, Walker & walk)
+{
+  ShadowSearch<Walker::unique> search;
+  const int *ip;
+
+  if(!walk.valid()) {
+    BC->interior_flag = false;
+    return (-1);
+  }
+
+  search.start(BC);
+
+  while((ip = walk.next(search.found(), search.dist()))) {
+    if(!search.visit(ip))
+      break;
+  }
+
+  return search.finish();
 }
 
+int BasisHitShadow(BasisCallRec * BC)
+{
+  CBasis *BI = BC->Basis;
+  RayInfo *r = BC->rr;
+
+  if(BI->BVH) {
+    const float minusZ[3] = { 0.0F, 0.0F, -1.0F };
+    BVHWalker walk(*BI->BVH, r->base, minusZ, -kR_SMALL4, FLT_MAX);
+    return BasisHitShadowImpl(BC, walk);
+  }
+
+  /* early exit after the first hit is invalid for transparent surfaces */
+  ZGridWalker walk(BI, r->base, false);
+  return BasisHitShadowImpl(BC, walk);
+}
+
+
+/*========================================================================*/
+/* Packets: all rays take the same path through the BVH, every leaf is
+ * tested once for all rays which intersect its box. The primitive boxes of
+ * a leaf are then tested against all rays at once (SIMD), and each ray only
+ * runs the exact tests for the primitives whose box it intersects. The
+ * exact tests are the same per-ray searches as above, so the results are
+ * identical to tracing the rays one by one (up to the order of equidistant
+ * hits). */
+
+/* larger leaves (only at the maximum BVH depth) skip the box tests */
+#define cBasisPacketLeafMax 16
+
+static_assert(cBasisPacketMax == pymol::BVHPacket::MaxSize,
+              "packet size mismatch");
+
+int BasisPacketSize(void)
+{
+  return pymol::BVHPacket::lanes();
+}
+
+template <template <bool> class Search>
+static void BasisHitPacketImpl(BasisCallRec * BC, BasisPacket * P,
+                               const float (*dir)[3], float t_min,
+                               const float *t_lim)
+{
+  BasisCallRec lane[cBasisPacketMax];
+  Search<true> search[cBasisPacketMax];
+  float base[cBasisPacketMax][3];
+  float t_max[cBasisPacketMax];
+  unsigned item_mask[cBasisPacketLeafMax];
+  int sub[cBasisPacketLeafMax + 1];
+  const int n = P->n;
+  const int *ip, *list;
+  unsigned mask;
+  int k, j, n_items, n_sub;
+
+  for(k = 0; k < n; k++) {
+    lane[k] = *BC;
+    lane[k].rr = P->rr + k;
+    lane[k].except1 = P->except1[k];
+    lane[k].back_dist = P->back_dist[k];
+    search[k].start(lane + k);
+    copy3f(P->rr[k].base, base[k]);
+    t_max[k] = std::min(search[k].dist(), t_lim[k]);
+  }
+
+  pymol::BVHPacket packet(*BC->Basis->BVH, n, base, dir, t_min);
+
+  while((ip = packet.next(t_max, mask))) {
+    for(n_items = 0; ip[n_items] >= 0; n_items++);
+
+    /* a single item has the same box as the leaf */
+    const bool cull = (n_items > 1) && (n_items <= cBasisPacketLeafMax);
+    if(cull)
+      packet.intersectItems(ip, n_items, t_max, item_mask);
+
+    for(k = 0; k < n; k++) {
+      if(mask & (1u << k)) {
+        list = ip;
+        if(cull) {
+          for(j = n_sub = 0; j < n_items; j++) {
+            if(item_mask[j] & (1u << k))
+              sub[n_sub++] = ip[j];
+          }
+          if(!n_sub)
+            continue;
+          sub[n_sub] = -1;
+          list = sub;
+        }
+        if(search[k].visit(list))
+          t_max[k] = std::min(search[k].dist(), t_lim[k]);
+        else
+          t_max[k] = -FLT_MAX;  /* done */
+      }
+    }
+  }
+
+  for(k = 0; k < n; k++) {
+    P->result[k] = search[k].finish();
+    P->interior_flag[k] = lane[k].interior_flag;
+  }
+}
+
+/* without a BVH, trace the rays one by one */
+static void BasisHitPacketSerial(BasisCallRec * BC, BasisPacket * P,
+                                 int (*hit)(BasisCallRec *))
+{
+  for(int k = 0; k < P->n; k++) {
+    BasisCallRec lane = *BC;
+    lane.rr = P->rr + k;
+    lane.except1 = P->except1[k];
+    lane.back_dist = P->back_dist[k];
+    P->result[k] = hit(&lane);
+    P->interior_flag[k] = lane.interior_flag;
+  }
+}
+
+void BasisHitPerspectivePacket(BasisCallRec * BC, BasisPacket * P)
+{
+  float dir[cBasisPacketMax][3];
+
+  if(!BC->Basis->BVH) {
+    BasisHitPacketSerial(BC, P, BasisHitPerspective);
+    return;
+  }
+
+  for(int k = 0; k < P->n; k++)
+    copy3f(P->rr[k].dir, dir[k]);
+
+  BasisHitPacketImpl<PerspectiveSearch>(BC, P, dir, -kR_SMALL4, P->back_dist);
+}
+
+void BasisHitOrthoscopicPacket(BasisCallRec * BC, BasisPacket * P)
+{
+  float dir[cBasisPacketMax][3];
+  float t_lim[cBasisPacketMax];
+
+  if(!BC->Basis->BVH) {
+    BasisHitPacketSerial(BC, P, BasisHitOrthoscopic);
+    return;
+  }
+
+  for(int k = 0; k < P->n; k++) {
+    set3f(dir[k], 0.0F, 0.0F, -1.0F);
+    t_lim[k] = BC->back;
+  }
+
+  BasisHitPacketImpl<OrthoscopicSearch>(BC, P, dir,
+                                        std::min(BC->front, 0.0F) - kR_SMALL4,
+                                        t_lim);
+}
+
+void BasisHitShadowPacket(BasisCallRec * BC, BasisPacket * P)
+{
+  float dir[cBasisPacketMax][3];
+  float t_lim[cBasisPacketMax];
+
+  if(!BC->Basis->BVH) {
+    BasisHitPacketSerial(BC, P, BasisHitShadow);
+    return;
+  }
+
+  for(int k = 0; k < P->n; k++) {
+    set3f(dir[k], 0.0F, 0.0F, -1.0F);
+    t_lim[k] = FLT_MAX;
+  }
+
+  BasisHitPacketImpl<ShadowSearch>(BC, P, dir, -kR_SMALL4, t_lim);
+}
+
+
 /*========================================================================*/
 int BasisMakeMap(CBasis * I, int *vert2prim, CPrimitive * prim, int n_prim,
 		 float *volume,
@@ -3562,6 +4011,77 @@ int BasisMakeMap(CBasis * I, int *vert2prim, CPrimitive * prim, int n_prim,
 }
 
 
+/*========================================================================*/
+/*
+ * Alternative to BasisMakeMap: bounding volume hierarchy with one box per
+ * primitive. Build time and memory only depend on the number of primitives,
+ * not on their spatial distribution or size.
+ */
+int BasisMakeBVH(CBasis * I, int *vert2prim, CPrimitive * prim)
+{
+  std::vector<float> bounds;
+  std::vector<int> elems;
+
+  bounds.reserve(I->NVertex * 6);
+  elems.reserve(I->NVertex);
+
+  for(int a = 0; a < I->NVertex; a++) {
+    const CPrimitive *prm = prim + vert2prim[a];
+    const float *v = I->Vertex + a * 3;
+    float lo[3], hi[3];
+
+    switch (prm->type) {
+    case cPrimTriangle:
+    case cPrimCharacter:
+      /* the three vertices share one element */
+      if(a != prm->vert)
+        continue;
+      for(int k = 0; k < 3; k++) {
+        lo[k] = std::min(std::min(v[k], v[k + 3]), v[k + 6]) - kR_SMALL4;
+        hi[k] = std::max(std::max(v[k], v[k + 3]), v[k + 6]) + kR_SMALL4;
+      }
+      break;
+    case cPrimCylinder:
+    case cPrimSausage:
+    case cPrimCone:
+      {
+        const float *n = I->Normal + I->Vert2Normal[a] * 3;
+        float radius = I->Radius[a];
+        if(prm->type == cPrimCone && prm->r2 > radius)
+          radius = prm->r2;
+        for(int k = 0; k < 3; k++) {
+          float v2 = v[k] + n[k] * prm->l1;
+          lo[k] = std::min(v[k], v2) - radius;
+          hi[k] = std::max(v[k], v2) + radius;
+        }
+      }
+      break;
+    default:                   /* spheres and ellipsoids */
+      for(int k = 0; k < 3; k++) {
+        lo[k] = v[k] - I->Radius[a];
+        hi[k] = v[k] + I->Radius[a];
+      }
+      break;
+    }
+
+    bounds.insert(bounds.end(), lo, lo + 3);
+    bounds.insert(bounds.end(), hi, hi + 3);
+    elems.push_back(a);
+  }
+
+  if(!I->BVH)
+    I->BVH = new pymol::BVH();
+  I->BVH->build(bounds.data(), elems.data(), elems.size());
+
+  PRINTFD(I->G, FB_Ray)
+    " BasisMakeBVH: %d elements, %d nodes\n", (int) elems.size(),
+    (int) I->BVH->nodeCount()
+    ENDFD;
+
+  return true;
+}
+
+
 /*========================================================================*/
 int BasisInit(PyMOLGlobals * G, CBasis * I, int group_id)
 {
@@ -3590,6 +4110,7 @@ int BasisInit(PyMOLGlobals * G, CBasis * I, int group_id)
     I->Precomp = VLACacheAlloc(I->G, float, 1, group_id, cCache_basis_precomp);
   CHECKOK(ok, I->Precomp);
   I->Map = NULL;
+  I->BVH = NULL;
   I->NVertex = 0;
   I->NNormal = 0;
   return ok;
@@ -3603,6 +4124,8 @@ void BasisFinish(CBasis * I, int group_id)
     MapFree(I->Map);
     I->Map = NULL;
   }
+  delete I->BVH;
+  I->BVH = NULL;
   VLACacheFreeP(I->G, I->Radius2, group_id, cCache_basis_radius2, false);
   VLACacheFreeP(I->G, I->Radius, group_id, cCache_basis_radius, false);
   VLACacheFreeP(I->G, I->Vertex, group_id, cCache_basis_vertex, false);
@@ -20,6 +20,11 @@ Z* -------------------------------------------------------------------
 #include"Map.h"
 #include"Vector.h"
 
+namespace pymol
+{
+class BVH;
+}
+
 #define cPrimSphere 1
 #define cPrimCylinder 2
 #define cPrimTriangle 3
@@ -84,6 +89,7 @@ typedef struct {
 typedef struct {
   PyMOLGlobals *G;
   MapType *Map;
+  pymol::BVH *BVH;              /* alternative to Map, see ray_trace_accel */
   float *Vertex, *Normal, *Precomp;
   float *Radius, *Radius2, MaxRadius, MinVoxel;
   int *Vert2Normal;
@@ -132,12 +138,29 @@ typedef struct {
   float back_dist;
 } BasisCallRec;
 
+/* A packet of coherent rays for the BasisHit*Packet functions, which trace
+ * all rays together through the BVH (one by one with a voxel map). Each ray
+ * takes its base (and dir for perspective) from rr[], except1[] and
+ * back_dist[] instead of the BasisCallRec. Results are stored in rr[],
+ * result[] and interior_flag[], same as with the single ray functions. */
+#define cBasisPacketMax 8
+
+typedef struct {
+  int n;
+  RayInfo rr[cBasisPacketMax];
+  int except1[cBasisPacketMax];
+  float back_dist[cBasisPacketMax];
+  int result[cBasisPacketMax];
+  int interior_flag[cBasisPacketMax];
+} BasisPacket;
+
 int BasisInit(PyMOLGlobals * G, CBasis * I, int group_id);
 void BasisFinish(CBasis * I, int group_id);
 int BasisMakeMap(CBasis * I, int *vert2prim, CPrimitive * prim, int n_prim,
 		 float *volume,
 		 int group_id, int block_base,
 		 int perspective, float front, float size_hint);
+int BasisMakeBVH(CBasis * I, int *vert2prim, CPrimitive * prim);
 
 void BasisSetupMatrix(CBasis * I);
 void BasisGetTriangleNormal(CBasis * I, RayInfo * r, int i, float *fc, int perspective);
@@ -149,6 +172,11 @@ int BasisHitPerspective(BasisCallRec * BC);
 int BasisHitOrthoscopic(BasisCallRec * BC);
 int BasisHitShadow(BasisCallRec * BC);
 
+int BasisPacketSize(void);      /* preferred number of rays per packet */
+void BasisHitPerspectivePacket(BasisCallRec * BC, BasisPacket * P);
+void BasisHitOrthoscopicPacket(BasisCallRec * BC, BasisPacket * P);
+void BasisHitShadowPacket(BasisCallRec * BC, BasisPacket * P);
+
 void BasisGetTriangleFlatDotgle(CBasis * I, RayInfo * r, int i);
 void BasisGetTriangleFlatDotglePerspective(CBasis * I, RayInfo * r, int i);
 
@@ -32,6 +32,9 @@ Z* -------------------------------------------------------------------
 #include"Scene.h"
 #include "Feedback.h"
 
+// ColorGet may be called from representation builds on worker threads
+thread_local float CColor::RGBColor[3];
+
 static int AutoColor[] = {
   26,                           /* carbon */
   5,                            /* cyan */
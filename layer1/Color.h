@@ -83,7 +83,7 @@ struct CColor {
   float Gamma = 1.0f;
   int BigEndian{};
   std::unordered_map<std::string, ColorIdx> Idx;
-  float RGBColor[3]{};            /* save global float for returning (float*) */
+  static thread_local float RGBColor[3]; /* per-thread float for returning (float*) */
   char RGBName[11]{}; // "0xTTRRGGBB"
   /* not stored */
   bool HaveOldSessionColors = false;
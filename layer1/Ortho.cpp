@@ -54,6 +54,7 @@ Z* -------------------------------------------------------------------
 #include "MyPNG.h"
 #include "File.h"
 #include "Feedback.h"
+#include "TaskPool.h"
 
 #ifdef _PYMOL_OPENVR
 #include "OpenVRMode.h"
@@ -537,9 +538,22 @@ void OrthoBusyMessage(PyMOLGlobals * G, const char *message)
 }
 
 
+/*========================================================================*/
+/**
+ * Progress can't be reported from task pool threads, they are not known to
+ * the Python interpreter.
+ */
+static bool OrthoBusyOnWorker(PyMOLGlobals * G)
+{
+  return G->TaskPool && G->TaskPool->currentWorker() >= 0;
+}
+
 /*========================================================================*/
 void OrthoBusySlow(PyMOLGlobals * G, int progress, int total)
 {
+  if(OrthoBusyOnWorker(G))
+    return;
+
   COrtho *I = G->Ortho;
   double time_yet = (-I->BusyLastUpdate) + UtilGetSeconds(G);
 
@@ -570,6 +584,9 @@ void OrthoBusySlow(PyMOLGlobals * G, int progress, int total)
 /*========================================================================*/
 void OrthoBusyFast(PyMOLGlobals * G, int progress, int total)
 {
+  if(OrthoBusyOnWorker(G))
+    return;
+
   COrtho *I = G->Ortho;
   double time_yet = (-I->BusyLastUpdate) + UtilGetSeconds(G);
   short finished = progress == total;
@@ -67,6 +67,7 @@ the initialization functions for these libraries on startup.
 #include"Property.h"
 #endif
 
+#include <climits>
 #include <memory>
 
 /**
@@ -879,16 +880,24 @@ int WrapperObjectAssignSubScript(PyObject *obj, PyObject *key, PyObject *val){
       changed = true;
     } break;
     case cPType_schar: {
-      int valint = PyInt_AsLong(val);
+      long valint = PyInt_AsLong(val);
       if (valint == -1 && PyErr_Occurred())
         return -1;
+      if (valint < SCHAR_MIN || valint > SCHAR_MAX) {
+        PyErr_Format(PyExc_OverflowError, "%s out of range", aprop);
+        return -1;
+      }
       *get_member_pointer<signed char>(wobj->atomInfo, ap->offset) = valint;
       changed = true;
     } break;
     case cPType_int: {
-      int valint = PyInt_AsLong(val);
+      long valint = PyInt_AsLong(val);
       if (valint == -1 && PyErr_Occurred())
         return -1;
+      if (valint < INT_MIN || valint > INT_MAX) {
+        PyErr_Format(PyExc_OverflowError, "%s out of range", aprop);
+        return -1;
+      }
       *get_member_pointer<int>(wobj->atomInfo, ap->offset) = valint;
       changed = true;
     } break;
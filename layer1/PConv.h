@@ -366,9 +366,10 @@ inline bool PConvFromPyObject(PyMOLGlobals *, PyObject * obj, float * out) {
 
 template <class T>
 bool PConvFromPyObject(PyMOLGlobals * G, PyObject * obj, std::vector<T> &out) {
-  if (PyBytes_Check(obj)) {
+  if (PyBinary_Check(obj)) {
     // binary_dump
-    size_t slen = PyBytes_Size(obj);
+    auto strval = PyBinary_AsSomeString(obj);
+    size_t slen = strval.length();
 
     if (slen % sizeof(T)) {
       return false;
@@ -376,7 +377,6 @@ bool PConvFromPyObject(PyMOLGlobals * G, PyObject * obj, std::vector<T> &out) {
 
     out.resize(slen / sizeof(T));
 
-    auto strval = PyBytes_AsSomeString(obj);
     std::copy_n(strval.data(), slen, reinterpret_cast<char*>(out.data()));
     return true;
   }
@@ -40,6 +40,7 @@ Z* -------------------------------------------------------------------
 #include"Selector.h"
 #include"vla.h"
 #include"pymol/type_traits.h"
+#include "TaskPool.h"
 
 void ObjectPurgeSettings(pymol::CObject * I)
 {
@@ -1140,6 +1141,12 @@ void pymol::CObject::setName(pymol::zstring_view name)
   ObjectSetName(this, name.data());
 }
 
+/*========================================================================*/
+void pymol::CObject::addUpdateTasks(pymol::TaskGraph& graph)
+{
+  graph.add([this] { update(); }, {}, true);
+}
+
 /*========================================================================*/
 pymol::CObject::~CObject()
 {
@@ -69,6 +69,8 @@ struct CObjectState {
 
 namespace pymol
 {
+class TaskGraph;
+
 struct CObject {
   PyMOLGlobals* G = nullptr;
   cObject_t type;
@@ -125,6 +127,13 @@ public:
   void setName(pymol::zstring_view name);
 
   virtual void update() {}
+
+  /**
+   * Adds the geometry update of this object to `graph`. The default is a
+   * single main thread task which calls update().
+   */
+  virtual void addUpdateTasks(TaskGraph& graph);
+
   virtual void render(RenderInfo* info);
   virtual void invalidate(cRep_t rep, cRepInv_t level, int state) {}
   virtual int getNFrame() const { return 1; }
@@ -184,8 +193,6 @@ int ObjectMotionModify(pymol::CObject *I,int action, int index, int count,int ta
 void ObjectMotionReinterpolate(pymol::CObject *I);
 int ObjectMotionGetLength(pymol::CObject *I);
 
-typedef struct _CObjectUpdateThreadInfo CObjectUpdateThreadInfo;
-
 #define cObjectTypeAll                    0
 #define cObjectTypeObjects                1
 #define cObjectTypeSelections             2
@@ -40,6 +40,8 @@ Z* -------------------------------------------------------------------
 #include"MyPNG.h"
 #include"CGO.h"
 #include "Feedback.h"
+#include "TaskPool.h"
+#include "BVH.h"
 
 #define SettingGetfv SettingGetGlobal_3fv
 
@@ -60,6 +62,10 @@ Z* -------------------------------------------------------------------
    number of lights */
 #define MAX_BASIS 12
 
+/* edge of the square image tiles handed out to the ray tracing workers,
+   a multiple of the packet size */
+#define RAY_TILE 32
+
 typedef float float3[3];
 typedef float float4[4];
 
@@ -74,7 +80,8 @@ struct _CRayThreadInfo {
   float ambient;
   unsigned int background;
   int border;
-  int phase, n_thread;
+  int phase;                    /* worker index */
+  pymol::StealingRange *tiles;  /* image tiles, shared by all workers */
   int x_start, x_stop;
   int y_start, y_stop;
   unsigned int *edging;
@@ -100,6 +107,7 @@ struct _CRayHashThreadInfo {
   float front;
   int phase;
   float size_hint;
+  int bvh;
   CRay *ray;
   float *bkrd_top, *bkrd_bottom;
   short bkrd_is_gradient; /* if not gradient, use bkrd_top as bkrd */
@@ -112,7 +120,8 @@ struct _CRayAntiThreadInfo {
   unsigned int *image_copy;
   unsigned int width, height;
   int mag;
-  int phase, n_thread;
+  int phase;                    /* worker index */
+  pymol::StealingRange *rows;   /* scan lines, shared by all workers */
   CRay *ray;
 };
 
@@ -2874,67 +2883,56 @@ void RayProjectTriangle(CRay * I, RayInfo * r, float *light, float *v0, float *n
   }
 }
 
-#ifndef _PYMOL_NOPY
+/*
+ * Fills the voxel maps of all bases, one task per basis.
+ */
 static void RayHashSpawn(CRayHashThreadInfo * Thread, int n_thread, int n_total)
 {
-  int blocked;
-  PyObject *info_list;
-  int a, c, n = 0;
   CRay *I = Thread->ray;
   PyMOLGlobals *G = I->G;
 
-  blocked = PAutoBlock(G);
-
   PRINTFB(I->G, FB_Ray, FB_Blather)
     " Ray: filling voxels with %d threads...\n", n_thread ENDFB(I->G);
-  while(n < n_total) {
-    c = n;
-    info_list = PyList_New(n_thread);
-    for(a = 0; a < n_thread; a++) {
-      if((c + a) < n_total) {
-        PyList_SetItem(
-            info_list, a, PyCapsule_New(Thread + c + a, nullptr, nullptr));
-      } else {
-        PyList_SetItem(info_list, a, PConvAutoNone(NULL));
-      }
-      n++;
-    }
-    PXDecRef(PYOBJECT_CALLMETHOD
-             (G->P_inst->cmd, "_ray_hash_spawn", "OO", info_list, G->P_inst->cmd));
-    Py_DECREF(info_list);
-  }
-  PAutoUnblock(G, blocked);
+
+  G->TaskPool->parallel_for(n_total, 1, n_thread,
+      [Thread](size_t begin, size_t end, unsigned) {
+        for(size_t a = begin; a < end; a++)
+          RayHashThread(Thread + a);
+      });
 }
-#endif
 
-#ifndef _PYMOL_NOPY
+/*
+ * Antialiasing pass. Scan lines are handed out to the workers with
+ * work stealing.
+ */
 static void RayAntiSpawn(CRayAntiThreadInfo * Thread, int n_thread)
 {
-  int blocked;
-  PyObject *info_list;
-  int a;
   CRay *I = Thread->ray;
   PyMOLGlobals *G = I->G;
+  int height = (Thread->height / Thread->mag) - 2;
+  pymol::StealingRange rows(std::max(height, 0), n_thread);
 
-  blocked = PAutoBlock(G);
+  if(n_thread > 1) {
+    PRINTFB(I->G, FB_Ray, FB_Blather)
+      " Ray: antialiasing with %d threads...\n", n_thread ENDFB(I->G);
+  }
 
-  PRINTFB(I->G, FB_Ray, FB_Blather)
-    " Ray: antialiasing with %d threads...\n", n_thread ENDFB(I->G);
-  info_list = PyList_New(n_thread);
-  for(a = 0; a < n_thread; a++) {
-    PyList_SetItem(info_list, a, PyCapsule_New(Thread + a, nullptr, nullptr));
-  }
-  PXDecRef(PYOBJECT_CALLMETHOD
-           (G->P_inst->cmd, "_ray_anti_spawn", "OO", info_list, G->P_inst->cmd));
-  Py_DECREF(info_list);
-  PAutoUnblock(G, blocked);
+  for(int a = 0; a < n_thread; a++) {
+    Thread[a].rows = &rows;
+  }
+
+  G->TaskPool->run(n_thread, [Thread](unsigned worker) {
+    RayAntiThread(Thread + worker);
+  });
 }
-#endif
 
 int RayHashThread(CRayHashThreadInfo * T)
 {
-  BasisMakeMap(T->basis, T->vert2prim, T->prim, T->n_prim, T->clipBox, T->phase,
-               cCache_ray_map, T->perspective, T->front, T->size_hint);
+  if(T->bvh)
+    BasisMakeBVH(T->basis, T->vert2prim, T->prim);
+  else
+    BasisMakeMap(T->basis, T->vert2prim, T->prim, T->n_prim, T->clipBox, T->phase,
+                 cCache_ray_map, T->perspective, T->front, T->size_hint);
 
   /* utilize a little extra wasted CPU time in thread 0 which computes the smaller map... */
   if(!T->phase) {
@@ -2950,30 +2948,34 @@ int RayHashThread(CRayHashThreadInfo * T)
   return 1;
 }
 
-#ifndef _PYMOL_NOPY
+/*
+ * Ray traces the image. RAY_TILE x RAY_TILE tiles are handed out to the
+ * workers with work stealing, so workers which finish early help out in the
+ * dense parts of the scene, also when these are in one half of a scan line.
+ * Worker 0 runs on the calling thread and updates the busy indicator.
+ */
 static void RayTraceSpawn(CRayThreadInfo * Thread, int n_thread)
 {
-  int blocked;
-  PyObject *info_list;
-  int a;
   CRay *I = Thread->ray;
   PyMOLGlobals *G = I->G;
+  int n_tile_x = (Thread->x_stop - Thread->x_start + RAY_TILE - 1) / RAY_TILE;
+  int n_tile_y = (Thread->y_stop - Thread->y_start + RAY_TILE - 1) / RAY_TILE;
+  pymol::StealingRange tiles(
+      (n_tile_x > 0 && n_tile_y > 0) ? n_tile_x * n_tile_y : 0, n_thread);
 
-  blocked = PAutoBlock(G);
+  if(n_thread > 1) {
+    PRINTFB(I->G, FB_Ray, FB_Blather)
+      " Ray: rendering with %d threads...\n", n_thread ENDFB(I->G);
+  }
 
-  PRINTFB(I->G, FB_Ray, FB_Blather)
-    " Ray: rendering with %d threads...\n", n_thread ENDFB(I->G);
-  info_list = PyList_New(n_thread);
-  for(a = 0; a < n_thread; a++) {
-    PyList_SetItem(info_list, a, PyCapsule_New(Thread + a, nullptr, nullptr));
+  for(int a = 0; a < n_thread; a++) {
+    Thread[a].tiles = &tiles;
   }
-  PXDecRef(PYOBJECT_CALLMETHOD
-           (G->P_inst->cmd, "_ray_spawn", "OO", info_list, G->P_inst->cmd));
-  Py_DECREF(info_list);
-  PAutoUnblock(G, blocked);
 
+  G->TaskPool->run(n_thread, [Thread](unsigned worker) {
+    RayTraceThread(Thread + worker);
+  });
 }
-#endif
 
 static int find_edge(unsigned int *ptr, float *depth, unsigned int width,
                      int threshold, int back)
@@ -3163,10 +3165,173 @@ static void RayPrimGetColorRamped(PyMOLGlobals * G, float *matrix, RayInfo * r,
   }
 }
 
+/*========================================================================*/
+/* Packets (ray_trace_accel=2): the pass-0 rays of a few adjacent pixels are
+ * traced together through the BVH ahead of the pixel loop, and so are their
+ * shadow rays. A pixel only takes a stored result if its ray is the very same
+ * as the traced one, which makes the image identical to tracing the rays one
+ * by one. Everything else (edge samples, transparency passes, shifted
+ * impacts) is traced as usual. */
+
+static int RaySameBase(const float *v1, const float *v2)
+{
+  return (v1[0] == v2[0]) && (v1[1] == v2[1]) && (v1[2] == v2[2]);
+}
+
+/* primary rays of n adjacent pixels, set up as in RayTraceThread */
+static void RayTracePrimaryPacket(CRay * I, CRayThreadInfo * T,
+                                  const BasisCallRec * BC, BasisPacket * P,
+                                  const float *base_x, float base_y, int n,
+                                  int perspective, const float *eye)
+{
+  BasisCallRec call = *BC;
+  int k;
+
+  call.except1 = -1;
+  call.except2 = -1;
+  call.front = T->front;
+  call.excl_trans = 0.0F;
+  call.interior_flag = false;
+  call.pass = 0;
+
+  P->n = n;
+  for(k = 0; k < n; k++) {
+    RayInfo *r = P->rr + k;
+    P->except1[k] = -1;
+    r->base[0] = base_x[k];
+    r->base[1] = base_y;
+    if(perspective) {
+      r->base[2] = -T->front;
+      r->dir[0] = (r->base[0] - eye[0]);
+      r->dir[1] = (r->base[1] - eye[1]);
+      r->dir[2] = (r->base[2] - eye[2]);
+      normalize3f(r->dir);
+      {
+        float scale = I->max_box[2] / r->base[2];
+
+        r->skip[0] = r->base[0] * scale;
+        r->skip[1] = r->base[1] * scale;
+        r->skip[2] = I->max_box[2];
+      }
+      P->back_dist[k] = -(T->back + r->base[2]) / r->dir[2];
+    } else {
+      r->base[2] = 0.0F;
+    }
+  }
+
+  if(perspective)
+    BasisHitPerspectivePacket(&call, P);
+  else
+    BasisHitOrthoscopicPacket(&call, P);
+}
+
+/* takes the pass-0 result for BC->rr from lane k of a primary packet */
+static int RayPacketPrimaryHit(const BasisPacket * P, int k, BasisCallRec * BC,
+                               int perspective, int *result)
+{
+  RayInfo *r = BC->rr;
+  const RayInfo *p;
+
+  if((k < 0) || (k >= P->n))
+    return false;
+  p = P->rr + k;
+  if(!RaySameBase(p->base, r->base) || (perspective && !RaySameBase(p->dir, r->dir)))
+    return false;
+
+  if(perspective) {
+    /* the perspective search leaves rr alone unless there is a hit,
+       and only partially fills it for interior hits */
+    if(P->interior_flag[k])
+      return false;
+    if(P->result[k] < 0) {
+      BC->interior_flag = false;
+      *result = -1;
+      return true;
+    }
+  }
+
+  r->prim = p->prim;
+  r->dist = p->dist;
+  r->tri1 = p->tri1;
+  r->tri2 = p->tri2;
+  copy3f(p->sphere, r->sphere);
+  BC->interior_flag = P->interior_flag[k];
+  *result = P->result[k];
+  return true;
+}
+
+/* shadow rays toward the light of BC for lanes [k0, n) of a primary
+ * packet, starting from the impacts which the hits will have unless
+ * shading adjusts them */
+static void RayTraceShadowPacket(const BasisCallRec * BC,
+                                 const BasisPacket * primary, int k0,
+                                 int perspective, float shadow_fudge,
+                                 int project_triangle, BasisPacket * P)
+{
+  BasisCallRec call = *BC;
+  int k;
+
+  P->n = 0;
+  for(k = k0; k < primary->n; k++) {
+    const RayInfo *p = primary->rr + k;
+    RayInfo *r = P->rr + P->n;
+    float impact[3];
+
+    if((primary->result[k] < 0) || primary->interior_flag[k])
+      continue;
+    if(project_triangle && (p->prim->type == cPrimTriangle))
+      continue;                 /* see RayProjectTriangle */
+
+    if(perspective) {
+      impact[0] = p->base[0] + p->dist * p->dir[0];
+      impact[1] = p->base[1] + p->dist * p->dir[1];
+      impact[2] = p->base[2] + p->dist * p->dir[2];
+    } else {
+      impact[0] = p->base[0];
+      impact[1] = p->base[1];
+      impact[2] = p->base[2] - p->dist;
+    }
+
+    matrix_transform33f3f(BC->Basis->Matrix, impact, r->base);
+    r->base[2] -= shadow_fudge;
+    P->except1[P->n] = primary->result[k];
+    P->n++;
+  }
+
+  if(P->n) {
+    call.except2 = -1;
+    BasisHitShadowPacket(&call, P);
+  }
+}
+
+/* takes the result for the shadow ray BC->rr from a shadow packet (only
+ * what RayTraceThread looks at) */
+static int RayPacketShadowHit(const BasisPacket * P, BasisCallRec * BC,
+                              int *result)
+{
+  RayInfo *r = BC->rr;
+  int k;
+
+  for(k = 0; k < P->n; k++) {
+    const RayInfo *p = P->rr + k;
+    if((P->except1[k] == BC->except1) && RaySameBase(p->base, r->base)) {
+      r->prim = p->prim;
+      r->dist = p->dist;
+      r->trans = p->trans;
+      *result = P->result[k];
+      return true;
+    }
+  }
+  return false;
+}
+
 int RayTraceThread(CRayThreadInfo * T)
 {
   CRay *I = T->ray;
-  int x, y, yy;
+  int x, y;
+  std::uint32_t tile;
+  int n_tile_x = (T->x_stop - T->x_start + RAY_TILE - 1) / RAY_TILE;
+  int tile_x_start = 0, tile_x_stop = 0, tile_y_stop = 0;
   float excess = 0.0F;
   float dotgle;
   float bright, direct_cmp, reflect_cmp, fc[4];
@@ -3214,9 +3379,10 @@ int RayTraceThread(CRayThreadInfo * T)
   float invWdthRange, vol0;
   float vol2;
   CBasis *bp1, *bp2;
-  int render_height;
-  int offset = 0;
   BasisCallRec BasisCall[MAX_BASIS];
+  BasisPacket packet, shadow_packet[MAX_BASIS];
+  int packet_size = 0, packet_x = 0, shadow_hit;
+  float packet_base_x[cBasisPacketMax];
   float border_offset;
   int edge_sampling = false;
   unsigned int edge_avg[4] = { 0, 0, 0, 0 };
@@ -3290,10 +3456,6 @@ int RayTraceThread(CRayThreadInfo * T)
   }
   /* SETUP */
 
-  /*  if(T->n_thread>1)
-     printf(" Ray: Thread %d: Spawned.\n",T->phase+1);
-   */
-
   interior_shadows = SettingGetGlobal_i(I->G, cSetting_ray_interior_shadows);
   interior_wobble = SettingGetGlobal_i(I->G, cSetting_ray_interior_texture);
   interior_color = SettingGetGlobal_i(I->G, cSetting_ray_interior_color);
@@ -3451,12 +3613,6 @@ int RayTraceThread(CRayThreadInfo * T)
   else
     bp2 = NULL;
 
-  render_height = T->y_stop - T->y_start;
-
-  if(render_height) {
-    offset = (T->phase * render_height / T->n_thread);
-    offset = offset - (offset % T->n_thread) + T->phase;
-  }
   if((interior_color != -1) || I->CheckInterior) {
 
     if(interior_color != -1)
@@ -3489,7 +3645,10 @@ int RayTraceThread(CRayThreadInfo * T)
   BasisCall[0].fudge0 = BasisFudge0;
   BasisCall[0].fudge1 = BasisFudge1;
 
-  MapCacheInit(&BasisCall[0].cache, I->Basis[1].Map, T->phase, cCache_map_scene_cache);
+  if(I->Basis[1].Map)
+    MapCacheInit(&BasisCall[0].cache, I->Basis[1].Map, T->phase, cCache_map_scene_cache);
+  else
+    UtilZeroMem(&BasisCall[0].cache, sizeof(MapCache));      /* not needed with BVH */
 
   if(shadows && (n_basis > 2)) {
     int bc;
@@ -3508,11 +3667,19 @@ int RayTraceThread(CRayThreadInfo * T)
       BasisCall[bc].fudge0 = BasisFudge0;
       BasisCall[bc].fudge1 = BasisFudge1;
       BasisCall[bc].label_shadow_mode = label_shadow_mode;
-      MapCacheInit(&BasisCall[bc].cache, I->Basis[bc].Map, T->phase,
-                   cCache_map_shadow_cache);
+      if(I->Basis[bc].Map)
+        MapCacheInit(&BasisCall[bc].cache, I->Basis[bc].Map, T->phase,
+                     cCache_map_shadow_cache);
+      else
+        UtilZeroMem(&BasisCall[bc].cache, sizeof(MapCache));
     }
   }
 
+  /* not for the edge antialiasing pass, which only traces a few pixels */
+  if((SettingGetGlobal_i(I->G, cSetting_ray_trace_accel) == 2) &&
+     I->Basis[1].BVH && !T->edging)
+    packet_size = BasisPacketSize();
+
   if(T->border) {
     border_offset = -1.50F + T->border / 2.0F;
   } else {
@@ -3528,7 +3695,7 @@ int RayTraceThread(CRayThreadInfo * T)
 	back_mask = 0xFF000000;
     }
   }
-  for(yy = T->y_start; (yy < T->y_stop); yy++) {
+  for(y = 0;; y++) {
     float perc, bkrd[4] = {0.f, 0.f, 0.f, 1.f};
     unsigned int bkrd_value = 0;
     short isOutsideInY = 0;
@@ -3536,7 +3703,28 @@ int RayTraceThread(CRayThreadInfo * T)
     if(I->G->Interrupt)
       break;
 
-    y = T->y_start + ((yy - T->y_start) + offset) % (render_height);    /* make sure threads write to different pages */
+    if(y >= tile_y_stop) {      /* on to the first scan line of the next tile */
+      if(!T->tiles->next(T->phase, tile))
+        break;
+      tile_x_start = T->x_start + RAY_TILE * (tile % n_tile_x);
+      tile_x_stop = std::min(tile_x_start + RAY_TILE, T->x_stop);
+      y = T->y_start + RAY_TILE * (tile / n_tile_x);
+      tile_y_stop = std::min(y + RAY_TILE, T->y_stop);
+
+      if(!T->phase) {           /* don't slow down rendering too much */
+        int y_done = T->y_start + (int) ((T->y_stop - T->y_start) *
+            (std::uint64_t) T->tiles->taken() / T->tiles->size());
+        if(T->edging_cutoff) {
+          if(T->edging) {
+            OrthoBusyFast(I->G, (int) (2.5F * T->height / 3 + 0.5F * y_done), 4 * T->height / 3);
+          } else {
+            OrthoBusyFast(I->G, (int) (T->height / 3 + 0.5F * y_done), 4 * T->height / 3);
+          }
+        } else {
+          OrthoBusyFast(I->G, T->height / 3 + y_done, 4 * T->height / 3);
+        }
+      }
+    }
     if (T->bkrd_data){
       switch (bg_image_mode){
       case 1: // isCentered
@@ -3585,23 +3773,12 @@ int RayTraceThread(CRayThreadInfo * T)
 	bkrd[3] = 0.f;
       }
     }
-    if((!T->phase) && !(yy & 0xF)) {    /* don't slow down rendering too much */
-      if(T->edging_cutoff) {
-        if(T->edging) {
-          OrthoBusyFast(I->G, (int) (2.5F * T->height / 3 + 0.5F * y), 4 * T->height / 3);
-        } else {
-          OrthoBusyFast(I->G, (int) (T->height / 3 + 0.5F * y), 4 * T->height / 3);
-        }
-      } else {
-        OrthoBusyFast(I->G, T->height / 3 + y, 4 * T->height / 3);
-      }
-    }
-    pixel = T->image + (T->width * y) + T->x_start;
+    pixel = T->image + (T->width * y) + tile_x_start;
 
-    if((y % T->n_thread) == T->phase) { /* this is my scan line */
+    {
       pixel_base[1] = ((y + 0.5F + border_offset) * invHgtRange) + vol2;
 
-      for(x = T->x_start; (x < T->x_stop); x++) {
+      for(x = tile_x_start; (x < tile_x_stop); x++) {
 	if (T->bkrd_data){
 	  // Need to compute background for every pixel if image-based
 	  unsigned char bkrd_uc[4];
@@ -3628,6 +3805,18 @@ int RayTraceThread(CRayThreadInfo * T)
 
         pixel_base[0] = (((x + 0.5F + border_offset)) * invWdthRange) + vol0;
 
+        if(packet_size && !((x - tile_x_start) % packet_size)) {
+          int n = std::min(packet_size, tile_x_stop - x);
+          int k;
+          for(k = 0; k < n; k++)
+            packet_base_x[k] = (((x + k + 0.5F + border_offset)) * invWdthRange) + vol0;
+          RayTracePrimaryPacket(I, T, BasisCall, &packet, packet_base_x,
+                                pixel_base[1], n, perspective, eye);
+          for(k = 2; k < n_basis; k++)
+            shadow_packet[k].n = -1;    /* traced on demand */
+          packet_x = x;
+        }
+
         while(1) {
           if(T->edging) {
             if(!edge_sampling) {
@@ -3771,9 +3960,13 @@ int RayTraceThread(CRayThreadInfo * T)
                 copy3f(r1.base, r1.skip);
               }
               BasisCall[0].back_dist = -(T->back + r1.base[2]) / r1.dir[2];
-              i = BasisHitPerspective(&BasisCall[0]);
+              if(!(packet_size && !pass &&
+                   RayPacketPrimaryHit(&packet, x - packet_x, &BasisCall[0], true, &i)))
+                i = BasisHitPerspective(&BasisCall[0]);
             } else {
-              i = BasisHitOrthoscopic(&BasisCall[0]);
+              if(!(packet_size && !pass &&
+                   RayPacketPrimaryHit(&packet, x - packet_x, &BasisCall[0], false, &i)))
+                i = BasisHitOrthoscopic(&BasisCall[0]);
             }
             interior_flag = BasisCall[0].interior_flag && (!pass);
 
@@ -4007,7 +4200,14 @@ int RayTraceThread(CRayThreadInfo * T)
                     r2.base[2] -= shadow_fudge;
                     BasisCall[bc].except2 = -1;
                     BasisCall[bc].except1 = i;  /* exclude current prim from shadow comp */
-                    if(BasisHitShadow(&BasisCall[bc]) > -1) {
+                    if(packet_size && (shadow_packet[bc].n < 0))
+                      RayTraceShadowPacket(&BasisCall[bc], &packet, x - packet_x,
+                                           perspective, shadow_fudge,
+                                           project_triangle != _0, shadow_packet + bc);
+                    if(!(packet_size &&
+                         RayPacketShadowHit(shadow_packet + bc, &BasisCall[bc], &shadow_hit)))
+                      shadow_hit = BasisHitShadow(&BasisCall[bc]);
+                    if(shadow_hit > -1) {
                       if((!clip_shadows) || (bp->LightNormal[2] >= _0) ||
                          ((T->front + r1.impact[2] - (r2.dist * bp->LightNormal[2])) <
                           _0)) {
@@ -4501,9 +4701,7 @@ int RayTraceThread(CRayThreadInfo * T)
 
     }
     /* end of if */
-  }                             /* end of for */
-  /*  if(T->n_thread>1) 
-     printf(" Ray: Thread %d: Complete.\n",T->phase+1); */
+  }                             /* end of while */
   MapCacheFree(&BasisCall[0].cache, T->phase, cCache_map_scene_cache);
 
   if(shadows && (I->NBasis > 2)) {
@@ -4624,25 +4822,21 @@ int RayAntiThread(CRayAntiThreadInfo * T)
   unsigned int *pDst;
   /*   unsigned int m00FF=0x00FF,mFF00=0xFF00,mFFFF=0xFFFF; */
   int width;
-  int height;
-  int x, y, yy;
+  int x, y;
+  std::uint32_t row;
   unsigned int *p;
-  int offset = 0;
   CRay *I = T->ray;
 
-  OrthoBusyFast(I->G, 9, 10);
+  if(!T->phase)
+    OrthoBusyFast(I->G, 9, 10);
   width = (T->width / T->mag) - 2;
-  height = (T->height / T->mag) - 2;
 
   src_row_pixels = T->width;
 
-  offset = (T->phase * height) / T->n_thread;
-  offset = offset - (offset % T->n_thread) + T->phase;
+  while(T->rows->next(T->phase, row)) {
+    y = row;
 
-  for(yy = 0; yy < height; yy++) {
-    y = (yy + offset) % height; /* make sure threads write to different pages */
-
-    if((y % T->n_thread) == T->phase) { /* this is my scan line */
+    {
       unsigned long c1, c2, c3, c4, a;
       unsigned char *c;
 
@@ -5543,6 +5737,7 @@ void RayRender(CRay * I, unsigned int *image, double timing,
   int oversample_cutoff;
   int perspective = SettingGetGlobal_i(I->G, cSetting_ray_orthoscopic);
   int n_light = SettingGetGlobal_i(I->G, cSetting_light_count);
+  int bvh = (SettingGetGlobal_i(I->G, cSetting_ray_trace_accel) >= 1);
   float ambient;
   float *depth = NULL;
   float front = I->Volume[4];
@@ -5578,8 +5773,8 @@ void RayRender(CRay * I, unsigned int *image, double timing,
   n_thread = SettingGetGlobal_i(I->G, cSetting_max_threads);
   if(n_thread < 1)
     n_thread = 1;
-  if(n_thread > PYMOL_MAX_THREADS)
-    n_thread = PYMOL_MAX_THREADS;
+  if(n_thread > int(pymol::TaskPool::MaxWorkers))
+    n_thread = int(pymol::TaskPool::MaxWorkers);
   opaque_back = SettingGetGlobal_i(I->G, cSetting_ray_opaque_background);
   if(opaque_back < 0)
     opaque_back = SettingGetGlobal_i(I->G, cSetting_opaque_background);
@@ -5872,7 +6067,6 @@ void RayRender(CRay * I, unsigned int *image, double timing,
     }
 
     OrthoBusyFast(I->G, 4, 20);
-#ifndef _PYMOL_NOPY
     if(shadows && (n_thread > 1)) {     /* parallel execution */
 
       CRayHashThreadInfo *thread_info = pymol::calloc<CRayHashThreadInfo>(I->NBasis);
@@ -5906,6 +6100,7 @@ void RayRender(CRay * I, unsigned int *image, double timing,
       thread_info[0].bytes = width * (unsigned int) height;
       thread_info[0].ray = I;   /* for compute box */
       thread_info[0].size_hint = I->PrimSize;
+      thread_info[0].bvh = bvh;
       /* shadow map */
 
       {
@@ -5923,6 +6118,7 @@ void RayRender(CRay * I, unsigned int *image, double timing,
           thread_info[bc - 1].front = _0;
           /* allowing these maps to be more fine helps performance */
           thread_info[bc - 1].size_hint = I->PrimSize * factor;
+          thread_info[bc - 1].bvh = bvh;
         }
       }
 
@@ -5932,20 +6128,26 @@ void RayRender(CRay * I, unsigned int *image, double timing,
 
       FreeP(thread_info);
     } else
-#endif
     if (ok){ 
-#ifdef _PYMOL_NOPY
-      n_thread = 1;          /* serial execution */
-#endif
       int* vert2prim_ptr = I->Vert2Prim.empty() ? nullptr : I->Vert2Prim.data();
-      ok &= BasisMakeMap(I->Basis + 1, vert2prim_ptr, I->Primitive, I->NPrimitive,
-			 I->Volume, 0, cCache_ray_map, perspective, front, I->PrimSize);
-      if(ok && shadows) {
-        int bc;
-        float factor = SettingGetGlobal_f(I->G, cSetting_ray_hint_shadow);
-        for(bc = 2; ok && bc < I->NBasis; bc++) {
-          ok &= BasisMakeMap(I->Basis + bc, vert2prim_ptr, I->Primitive, I->NPrimitive,
-			     NULL, bc - 1, cCache_ray_map, false, _0, I->PrimSize * factor);
+      if(bvh) {
+        ok &= BasisMakeBVH(I->Basis + 1, vert2prim_ptr, I->Primitive);
+        if(ok && shadows) {
+          int bc;
+          for(bc = 2; ok && bc < I->NBasis; bc++) {
+            ok &= BasisMakeBVH(I->Basis + bc, vert2prim_ptr, I->Primitive);
+          }
+        }
+      } else {
+        ok &= BasisMakeMap(I->Basis + 1, vert2prim_ptr, I->Primitive, I->NPrimitive,
+                           I->Volume, 0, cCache_ray_map, perspective, front, I->PrimSize);
+        if(ok && shadows) {
+          int bc;
+          float factor = SettingGetGlobal_f(I->G, cSetting_ray_hint_shadow);
+          for(bc = 2; ok && bc < I->NBasis; bc++) {
+            ok &= BasisMakeMap(I->Basis + bc, vert2prim_ptr, I->Primitive, I->NPrimitive,
+                               NULL, bc - 1, cCache_ray_map, false, _0, I->PrimSize * factor);
+          }
         }
       }
 
@@ -5967,6 +6169,11 @@ void RayRender(CRay * I, unsigned int *image, double timing,
     OrthoBusyFast(I->G, 5, 20);
     now = UtilGetSeconds(I->G) - timing;
 
+    if (ok && bvh) {
+      PRINTFB(I->G, FB_Ray, FB_Blather)
+        " Ray: BVH: %d nodes, %4.2f sec.\n",
+        (int) I->Basis[1].BVH->nodeCount(), now ENDFB(I->G);
+    } else
     if (ok){
       if(shadows) {
 	PRINTFB(I->G, FB_Ray, FB_Blather)
@@ -6096,7 +6303,6 @@ void RayRender(CRay * I, unsigned int *image, double timing,
         rt[a].ambient = ambient;
         rt[a].background = background;
         rt[a].phase = a;
-        rt[a].n_thread = n_thread;
         rt[a].edging = NULL;
         rt[a].edging_cutoff = oversample_cutoff;        /* info needed for busy indicator */
         rt[a].perspective = perspective;
@@ -6110,12 +6316,7 @@ void RayRender(CRay * I, unsigned int *image, double timing,
         rt[a].bkrd_data = I->bkgrd_data ? I->bkgrd_data->bits() : nullptr;
       }
 
-#ifndef _PYMOL_NOPY
-      if(n_thread > 1)
-        RayTraceSpawn(rt, n_thread);
-      else
-#endif
-        RayTraceThread(rt);
+      RayTraceSpawn(rt, n_thread);
 
       if(oversample_cutoff) {   /* perform edge oversampling, if requested */
         unsigned int *edging;
@@ -6128,12 +6329,7 @@ void RayRender(CRay * I, unsigned int *image, double timing,
           rt[a].edging = edging;
         }
 
-#ifndef _PYMOL_NOPY
-        if(n_thread > 1)
-          RayTraceSpawn(rt, n_thread);
-        else
-#endif
-          RayTraceThread(rt);
+        RayTraceSpawn(rt, n_thread);
 
         CacheFreeP(I->G, edging, 0, cCache_ray_edging_buffer, false);
       }
@@ -6514,16 +6710,10 @@ void RayRender(CRay * I, unsigned int *image, double timing,
       rt[a].image_copy = image_copy;
       rt[a].phase = a;
       rt[a].mag = mag;          /* fold magnification */
-      rt[a].n_thread = n_thread;
       rt[a].ray = I;
     }
 
-#ifndef _PYMOL_NOPY
-    if(n_thread > 1)
-      RayAntiSpawn(rt, n_thread);
-    else
-#endif
-      RayAntiThread(rt);
+    RayAntiSpawn(rt, n_thread);
     FreeP(rt);
     CacheFreeP(I->G, image, 0, cCache_ray_antialias_buffer, false);
     image = image_copy;
@@ -904,6 +904,12 @@ enum {
   REC_f( 794, halogen_bond_as_acceptor_max_acceptor_angle , global    , 170.0f ),
   REC_f( 795, salt_bridge_distance                        , global    , 5.0f ),
   REC_b( 796, use_tessellation_shaders                , global    , true ),
+  REC_i( 797, ray_trace_accel                         , global    , 0, 0, 2 ),
+  REC_b( 798, surface_incremental                     , ostate    , false ),
+  REC_i( 799, selection_cache_size                    , global    , 32 ),
+  REC_i( 800, traj_stream_cache                       , object    , 0 ),
+  REC_i( 801, traj_stream_read_ahead                  , object    , 4 ),
+  REC_i( 802, psc_compression                         , global    , 1, 0, 9 ),
 
 #ifdef SETTINGINFO_IMPLEMENTATION
 #undef SETTINGINFO_IMPLEMENTATION
@@ -0,0 +1,890 @@
+/*
+ * Native evaluation of simple alter/alter_state expressions
+ *
+ * (c) Schrodinger, Inc.
+ */
+
+#include "AlterExpr.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+#include "AtomInfo.h"
+#include "Lex.h"
+#include "P.h"
+#include "PyMOL.h"
+#include "PyMOLGlobals.h"
+
+namespace pymol
+{
+
+namespace
+{
+
+enum {
+  NConstInt,
+  NConstFloat,
+  NLoadInt,
+  NLoadSChar,
+  NLoadUInt32,
+  NLoadFloat,
+  NLoadCoord,
+  NLoadIndex,
+  NLoadState,
+  NToFloat,
+  NNeg,
+  NAdd,
+  NSub,
+  NMul,
+  NDiv,
+  NCond,
+  NCmp,
+  NTruth,
+  NNot,
+  NAnd,
+  NOr,
+  NStrField,
+  NStrConst,
+  NStrEqLex,
+  NStrEqChars,
+};
+
+enum { SFloat, SInt, SSChar, SCoord };
+
+enum { CmpLT, CmpLE, CmpGT, CmpGE, CmpEQ, CmpNE };
+
+enum class Tok { End, Name, Int, Float, String, Op };
+
+using Type = AlterExpr::Type;
+using Node = AlterExpr::Node;
+
+/**
+ * Recursive descent parser for the supported subset of Python statements.
+ * All methods return a node index, or -1 if the input is outside the subset.
+ */
+class AlterExprParser
+{
+  PyMOLGlobals* m_G;
+  const char* m_p;
+  bool m_with_coords;
+  AlterExpr& m_out;
+
+  Tok m_tok = Tok::End;
+  std::string m_text;
+  std::int64_t m_int = 0;
+  double m_float = 0.0;
+
+public:
+  AlterExprParser(
+      PyMOLGlobals* G, const char* expr, bool with_coords, AlterExpr& out)
+      : m_G(G)
+      , m_p(expr)
+      , m_with_coords(with_coords)
+      , m_out(out)
+  {
+  }
+
+  bool parse()
+  {
+    // leading whitespace is an IndentationError in Python
+    if (*m_p == ' ' || *m_p == '\t' || !next())
+      return false;
+
+    while (m_tok != Tok::End) {
+      if (!statement())
+        return false;
+      if (isOp(";")) {
+        if (!next())
+          return false;
+      } else if (m_tok != Tok::End) {
+        return false;
+      }
+    }
+
+    return !m_out.stmts.empty();
+  }
+
+private:
+  bool isOp(const char* op) const { return m_tok == Tok::Op && m_text == op; }
+  bool isKeyword(const char* kw) const
+  {
+    return m_tok == Tok::Name && m_text == kw;
+  }
+
+  /// Reads the next token, false on characters outside the subset
+  bool next()
+  {
+    while (*m_p == ' ' || *m_p == '\t')
+      ++m_p;
+
+    const char* start = m_p;
+    const unsigned char c = *m_p;
+
+    if (!c) {
+      m_tok = Tok::End;
+      return true;
+    }
+
+    if (isalpha(c) || c == '_') {
+      while (isalnum((unsigned char) *m_p) || *m_p == '_')
+        ++m_p;
+      m_tok = Tok::Name;
+      m_text.assign(start, m_p);
+      return true;
+    }
+
+    if (isdigit(c) || (c == '.' && isdigit((unsigned char) m_p[1]))) {
+      bool is_float = false;
+      while (isdigit((unsigned char) *m_p))
+        ++m_p;
+      if (*m_p == '.') {
+        is_float = true;
+        for (++m_p; isdigit((unsigned char) *m_p);)
+          ++m_p;
+      }
+      if (*m_p == 'e' || *m_p == 'E') {
+        is_float = true;
+        ++m_p;
+        if (*m_p == '+' || *m_p == '-')
+          ++m_p;
+        if (!isdigit((unsigned char) *m_p))
+          return false;
+        while (isdigit((unsigned char) *m_p))
+          ++m_p;
+      }
+      // complex, hex, underscores, ...
+      if (isalnum((unsigned char) *m_p) || *m_p == '_' || *m_p == '.')
+        return false;
+
+      std::string text(start, m_p);
+      if (is_float) {
+        m_tok = Tok::Float;
+        m_float = strtod(text.c_str(), nullptr);
+        return true;
+      }
+
+      // "01" is a SyntaxError in Python
+      if (text.size() > 1 && text[0] == '0' &&
+          text.find_first_not_of('0') != std::string::npos)
+        return false;
+
+      errno = 0;
+      m_tok = Tok::Int;
+      m_int = strtoll(text.c_str(), nullptr, 10);
+      return errno == 0;
+    }
+
+    if (c == '"' || c == '\'') {
+      for (++m_p; *m_p != c; ++m_p) {
+        if (!*m_p || *m_p == '\\' || *m_p == '\n')
+          return false;
+      }
+      m_tok = Tok::String;
+      m_text.assign(start + 1, m_p++);
+      return true;
+    }
+
+    static const char* const ops2[] = {
+        "+=", "-=", "*=", "/=", "==", "!=", "<=", ">="};
+    for (auto op : ops2) {
+      if (c == op[0] && m_p[1] == op[1]) {
+        m_p += 2;
+        m_tok = Tok::Op;
+        m_text.assign(op);
+        return true;
+      }
+    }
+
+    if (strchr("=+-*/<>();", c)) {
+      ++m_p;
+      m_tok = Tok::Op;
+      m_text.assign(1, c);
+      return true;
+    }
+
+    return false;
+  }
+
+  int add(Node node)
+  {
+    m_out.nodes.push_back(std::move(node));
+    return int(m_out.nodes.size()) - 1;
+  }
+
+  int add(int kind, Type type, int c0 = -1, int c1 = -1, int c2 = -1)
+  {
+    Node node;
+    node.kind = kind;
+    node.type = type;
+    node.child[0] = c0;
+    node.child[1] = c1;
+    node.child[2] = c2;
+    return add(std::move(node));
+  }
+
+  Type type(int n) const { return m_out.nodes[n].type; }
+  bool isNumeric(int n) const
+  {
+    return n >= 0 && (type(n) == Type::Int || type(n) == Type::Float);
+  }
+
+  int toFloat(int n)
+  {
+    if (type(n) == Type::Float)
+      return n;
+    auto& node = m_out.nodes[n];
+    if (node.kind == NConstInt) {
+      node.kind = NConstFloat;
+      node.type = Type::Float;
+      node.f = double(node.i);
+      return n;
+    }
+    return add(NToFloat, Type::Float, n);
+  }
+
+  int toBool(int n)
+  {
+    if (n < 0 || type(n) == Type::String)
+      return -1;
+    if (type(n) == Type::Bool)
+      return n;
+    return add(NTruth, Type::Bool, n);
+  }
+
+  /// Binary arithmetic with Python's int/float promotion
+  int arith(int kind, int a, int b)
+  {
+    if (!isNumeric(a) || !isNumeric(b))
+      return -1;
+
+    if (kind == NDiv) {
+      // only division by a non-zero constant can't raise ZeroDivisionError
+      const auto& divisor = m_out.nodes[b];
+      double f = (divisor.kind == NConstInt)     ? double(divisor.i)
+                 : (divisor.kind == NConstFloat) ? divisor.f
+                                                 : 0.0;
+      if (f == 0.0)
+        return -1;
+      int n = add(NDiv, Type::Float, toFloat(a));
+      m_out.nodes[n].f = f;
+      return n;
+    }
+
+    if (type(a) == Type::Float || type(b) == Type::Float) {
+      a = toFloat(a);
+      b = toFloat(b);
+      return add(kind, Type::Float, a, b);
+    }
+
+    return add(kind, Type::Int, a, b);
+  }
+
+  /// Loads an atom property, -1 if it's unknown or not supported
+  int field(const std::string& name)
+  {
+    auto ap = PyMOL_GetAtomPropertyInfo(m_G->PyMOL, name.c_str());
+    if (!ap)
+      return -1;
+
+    int n = -1;
+    switch (ap->Ptype) {
+    case cPType_float:
+      n = add(NLoadFloat, Type::Float);
+      break;
+    case cPType_int:
+      n = add(NLoadInt, Type::Int);
+      break;
+    case cPType_schar:
+      n = add(NLoadSChar, Type::Int);
+      break;
+    case cPType_uint32:
+      n = add(NLoadUInt32, Type::Int);
+      break;
+    case cPType_xyz_float:
+      if (!m_with_coords)
+        return -1;
+      n = add(NLoadCoord, Type::Float);
+      break;
+    case cPType_index:
+      return add(NLoadIndex, Type::Int);
+    case cPType_state:
+      return add(NLoadState, Type::Int);
+    case cPType_int_as_string:
+    case cPType_string:
+      n = add(NStrField, Type::String);
+      m_out.nodes[n].op = ap->Ptype;
+      break;
+    default:
+      return -1;
+    }
+
+    m_out.nodes[n].offset = ap->offset;
+    return n;
+  }
+
+  int atom()
+  {
+    int n = -1;
+    switch (m_tok) {
+    case Tok::Int:
+      n = add(NConstInt, Type::Int);
+      m_out.nodes[n].i = m_int;
+      break;
+    case Tok::Float:
+      n = add(NConstFloat, Type::Float);
+      m_out.nodes[n].f = m_float;
+      break;
+    case Tok::String:
+      n = add(NStrConst, Type::String);
+      m_out.nodes[n].str = m_text;
+      break;
+    case Tok::Name:
+      n = field(m_text);
+      break;
+    case Tok::Op:
+      if (m_text == "(") {
+        if (!next())
+          return -1;
+        n = test();
+        if (n < 0 || !isOp(")"))
+          return -1;
+      }
+      break;
+    default:
+      break;
+    }
+
+    if (n < 0 || !next())
+      return -1;
+    return n;
+  }
+
+  int factor()
+  {
+    if (isOp("-") || isOp("+")) {
+      bool neg = isOp("-");
+      if (!next())
+        return -1;
+      int n = factor();
+      if (!isNumeric(n))
+        return -1;
+      if (!neg)
+        return n;
+      auto& node = m_out.nodes[n];
+      if (node.kind == NConstInt) {
+        node.i = -node.i;
+        return n;
+      }
+      if (node.kind == NConstFloat) {
+        node.f = -node.f;
+        return n;
+      }
+      return add(NNeg, node.type, n);
+    }
+    return atom();
+  }
+
+  int term()
+  {
+    int a = factor();
+    while (a >= 0 && (isOp("*") || isOp("/"))) {
+      int kind = isOp("*") ? NMul : NDiv;
+      if (!next())
+        return -1;
+      a = arith(kind, a, factor());
+    }
+    return a;
+  }
+
+  int sum()
+  {
+    int a = term();
+    while (a >= 0 && (isOp("+") || isOp("-"))) {
+      int kind = isOp("+") ? NAdd : NSub;
+      if (!next())
+        return -1;
+      a = arith(kind, a, term());
+    }
+    return a;
+  }
+
+  int compareOp() const
+  {
+    if (m_tok != Tok::Op)
+      return -1;
+    if (m_text == "<")
+      return CmpLT;
+    if (m_text == "<=")
+      return CmpLE;
+    if (m_text == ">")
+      return CmpGT;
+    if (m_text == ">=")
+      return CmpGE;
+    if (m_text == "==")
+      return CmpEQ;
+    if (m_text == "!=")
+      return CmpNE;
+    return -1;
+  }
+
+  /// String property compared with a string literal
+  int stringCompare(int a, int b, int cmp)
+  {
+    if (cmp != CmpEQ && cmp != CmpNE)
+      return -1;
+    if (m_out.nodes[a].kind == NStrConst)
+      std::swap(a, b);
+    const auto& fld = m_out.nodes[a];
+    const auto& lit = m_out.nodes[b];
+    if (fld.kind != NStrField || lit.kind != NStrConst)
+      return -1;
+
+    Node node;
+    node.type = Type::Bool;
+    node.op = (cmp == CmpNE);
+    node.offset = fld.offset;
+    if (fld.op == cPType_int_as_string) {
+      node.kind = NStrEqLex;
+      // strings which are not in the lexicon don't match any atom
+      node.i = lit.str.empty() ? 0 : LexBorrow(m_G, lit.str.c_str());
+    } else {
+      node.kind = NStrEqChars;
+      node.str = lit.str;
+    }
+    return add(std::move(node));
+  }
+
+  int comparison()
+  {
+    int a = sum();
+    int cmp = compareOp();
+    if (a < 0 || cmp < 0)
+      return a;
+
+    // a < b < c  ->  a < b and b < c
+    int result = -1;
+    while (cmp >= 0) {
+      if (!next())
+        return -1;
+      int b = sum();
+      if (b < 0)
+        return -1;
+
+      int n = -1;
+      if (type(a) == Type::String || type(b) == Type::String) {
+        if (result >= 0 || compareOp() >= 0)
+          return -1;
+        return stringCompare(a, b, cmp);
+      } else if (isNumeric(a) && isNumeric(b)) {
+        int ca = a, cb = b;
+        if (type(a) == Type::Float || type(b) == Type::Float) {
+          // don't convert `b` in place, it may be the next left operand
+          ca = (type(a) == Type::Float) ? a : add(NToFloat, Type::Float, a);
+          cb = (type(b) == Type::Float) ? b : add(NToFloat, Type::Float, b);
+        }
+        n = add(NCmp, Type::Bool, ca, cb);
+        m_out.nodes[n].op = cmp;
+      } else {
+        return -1;
+      }
+
+      result = (result < 0) ? n : add(NAnd, Type::Bool, result, n);
+      a = b;
+      cmp = compareOp();
+    }
+    return result;
+  }
+
+  int notTest()
+  {
+    if (isKeyword("not")) {
+      if (!next())
+        return -1;
+      int n = toBool(notTest());
+      return (n < 0) ? -1 : add(NNot, Type::Bool, n);
+    }
+    return comparison();
+  }
+
+  int andTest()
+  {
+    int a = notTest();
+    while (a >= 0 && isKeyword("and")) {
+      if (!next())
+        return -1;
+      int b = toBool(notTest());
+      a = toBool(a);
+      if (a < 0 || b < 0)
+        return -1;
+      a = add(NAnd, Type::Bool, a, b);
+    }
+    return a;
+  }
+
+  int orTest()
+  {
+    int a = andTest();
+    while (a >= 0 && isKeyword("or")) {
+      if (!next())
+        return -1;
+      int b = toBool(andTest());
+      a = toBool(a);
+      if (a < 0 || b < 0)
+        return -1;
+      a = add(NOr, Type::Bool, a, b);
+    }
+    return a;
+  }
+
+  /// Conditional expression: A if C else B
+  int test()
+  {
+    int a = orTest();
+    if (a < 0 || !isKeyword("if"))
+      return a;
+    if (!next())
+      return -1;
+    int c = toBool(orTest());
+    if (c < 0 || !isKeyword("else") || !next())
+      return -1;
+    int b = test();
+    if (!isNumeric(a) || !isNumeric(b))
+      return -1;
+    if (type(a) != type(b)) {
+      a = toFloat(a);
+      b = toFloat(b);
+    }
+    return add(NCond, type(a), c, a, b);
+  }
+
+  bool statement()
+  {
+    if (m_tok != Tok::Name)
+      return false;
+
+    auto ap = PyMOL_GetAtomPropertyInfo(m_G->PyMOL, m_text.c_str());
+    if (!ap)
+      return false;
+
+    AlterExpr::Stmt stmt;
+    stmt.prop = ap->id;
+    stmt.offset = ap->offset;
+
+    switch (ap->Ptype) {
+    case cPType_float:
+      stmt.kind = SFloat;
+      break;
+    case cPType_int:
+      stmt.kind = SInt;
+      break;
+    case cPType_schar:
+      stmt.kind = SSChar;
+      break;
+    case cPType_xyz_float:
+      if (!m_with_coords)
+        return false;
+      stmt.kind = SCoord;
+      break;
+    default:
+      return false;
+    }
+
+    std::string target = m_text;
+    if (!next() || m_tok != Tok::Op)
+      return false;
+
+    int kind = -1;
+    if (m_text == "+=")
+      kind = NAdd;
+    else if (m_text == "-=")
+      kind = NSub;
+    else if (m_text == "*=")
+      kind = NMul;
+    else if (m_text == "/=")
+      kind = NDiv;
+    else if (m_text != "=")
+      return false;
+
+    if (!next())
+      return false;
+
+    int value = test();
+    if (kind != -1)
+      value = arith(kind, field(target), value);
+    if (!isNumeric(value))
+      return false;
+
+    if (stmt.kind == SFloat || stmt.kind == SCoord) {
+      value = toFloat(value);
+    } else if (type(value) != Type::Int) {
+      // Python raises TypeError for float -> int
+      return false;
+    }
+
+    stmt.value = value;
+    m_out.stmts.push_back(stmt);
+    return true;
+  }
+};
+
+template <typename T>
+inline T& member(AtomInfoType* ai, std::size_t offset)
+{
+  return *reinterpret_cast<T*>(reinterpret_cast<char*>(ai) + offset);
+}
+
+/// True if the value of node `n` always fits the target of `stmt`
+bool fitsStmt(const AlterExpr& expr, const AlterExpr::Stmt& stmt, int n)
+{
+  const Node& node = expr.nodes[n];
+  switch (stmt.kind) {
+  case SInt:
+    return node.kind == NLoadInt || node.kind == NLoadSChar ||
+           node.kind == NLoadIndex || node.kind == NLoadState ||
+           (node.kind == NConstInt && INT_MIN <= node.i && node.i <= INT_MAX);
+  case SSChar:
+    return node.kind == NLoadSChar ||
+           (node.kind == NConstInt && SCHAR_MIN <= node.i &&
+               node.i <= SCHAR_MAX);
+  }
+  return true;
+}
+
+/// 64 bit integer arithmetic, sets `overflow` where Python would promote
+std::int64_t checkedArith(
+    int kind, std::int64_t a, std::int64_t b, bool& overflow)
+{
+  switch (kind) {
+  case NAdd:
+    if (b > 0 ? a > INT64_MAX - b : a < INT64_MIN - b)
+      break;
+    return a + b;
+  case NSub:
+    if (b < 0 ? a > INT64_MAX + b : a < INT64_MIN + b)
+      break;
+    return a - b;
+  case NMul:
+    if (a != 0 && b != 0) {
+      if ((a == -1 && b == INT64_MIN) || (b == -1 && a == INT64_MIN))
+        break;
+      if (a != -1 && b != -1) {
+        auto p = std::int64_t(std::uint64_t(a) * std::uint64_t(b));
+        if (p / b != a)
+          break;
+      }
+    }
+    return a * b;
+  }
+  overflow = true;
+  return 0;
+}
+
+} // namespace
+
+struct AlterExpr::Ctx {
+  AtomInfoType* ai;
+  int atm;
+  int state;
+  const float* xyz;
+  mutable bool overflow;
+};
+
+std::unique_ptr<AlterExpr> AlterExpr::compile(
+    PyMOLGlobals* G, const char* expr, bool with_coords)
+{
+  if (!expr || !G->PyMOL)
+    return nullptr;
+
+  std::unique_ptr<AlterExpr> result(new AlterExpr());
+  if (!AlterExprParser(G, expr, with_coords, *result).parse())
+    return nullptr;
+
+  for (const auto& node : result->nodes) {
+    if (node.type == Type::Int &&
+        (node.kind == NNeg || node.kind == NAdd || node.kind == NSub ||
+            node.kind == NMul)) {
+      result->m_needs_check = true;
+    }
+  }
+
+  for (const auto& stmt : result->stmts) {
+    if (!fitsStmt(*result, stmt, stmt.value)) {
+      result->m_needs_check = true;
+    }
+  }
+
+  return result;
+}
+
+std::int64_t AlterExpr::evalInt(int n, const Ctx& ctx) const
+{
+  const Node& node = nodes[n];
+  switch (node.kind) {
+  case NConstInt:
+    return node.i;
+  case NLoadInt:
+    return member<int>(ctx.ai, node.offset);
+  case NLoadSChar:
+    return member<signed char>(ctx.ai, node.offset);
+  case NLoadUInt32:
+    return member<std::uint32_t>(ctx.ai, node.offset);
+  case NLoadIndex:
+    return ctx.atm + 1;
+  case NLoadState:
+    return ctx.state;
+  case NNeg:
+    return checkedArith(NSub, 0, evalInt(node.child[0], ctx), ctx.overflow);
+  case NAdd:
+  case NSub:
+  case NMul:
+    return checkedArith(node.kind, evalInt(node.child[0], ctx),
+        evalInt(node.child[1], ctx), ctx.overflow);
+  case NCond:
+    return evalBool(node.child[0], ctx) ? evalInt(node.child[1], ctx)
+                                        : evalInt(node.child[2], ctx);
+  }
+  return 0;
+}
+
+double AlterExpr::evalFloat(int n, const Ctx& ctx) const
+{
+  const Node& node = nodes[n];
+  switch (node.kind) {
+  case NConstFloat:
+    return node.f;
+  case NLoadFloat:
+    return member<float>(ctx.ai, node.offset);
+  case NLoadCoord:
+    return ctx.xyz[node.offset];
+  case NToFloat:
+    return double(evalInt(node.child[0], ctx));
+  case NNeg:
+    return -evalFloat(node.child[0], ctx);
+  case NAdd:
+    return evalFloat(node.child[0], ctx) + evalFloat(node.child[1], ctx);
+  case NSub:
+    return evalFloat(node.child[0], ctx) - evalFloat(node.child[1], ctx);
+  case NMul:
+    return evalFloat(node.child[0], ctx) * evalFloat(node.child[1], ctx);
+  case NDiv:
+    return evalFloat(node.child[0], ctx) / node.f;
+  case NCond:
+    return evalBool(node.child[0], ctx) ? evalFloat(node.child[1], ctx)
+                                        : evalFloat(node.child[2], ctx);
+  }
+  return 0.0;
+}
+
+template <typename T> static bool compare(int op, T a, T b)
+{
+  switch (op) {
+  case CmpLT:
+    return a < b;
+  case CmpLE:
+    return a <= b;
+  case CmpGT:
+    return a > b;
+  case CmpGE:
+    return a >= b;
+  case CmpEQ:
+    return a == b;
+  }
+  return a != b;
+}
+
+bool AlterExpr::evalBool(int n, const Ctx& ctx) const
+{
+  const Node& node = nodes[n];
+  switch (node.kind) {
+  case NCmp:
+    if (nodes[node.child[0]].type == Type::Float)
+      return compare(node.op, evalFloat(node.child[0], ctx),
+          evalFloat(node.child[1], ctx));
+    return compare(
+        node.op, evalInt(node.child[0], ctx), evalInt(node.child[1], ctx));
+  case NTruth:
+    if (nodes[node.child[0]].type == Type::Float)
+      return evalFloat(node.child[0], ctx) != 0.0;
+    return evalInt(node.child[0], ctx) != 0;
+  case NNot:
+    return !evalBool(node.child[0], ctx);
+  case NAnd:
+    return evalBool(node.child[0], ctx) && evalBool(node.child[1], ctx);
+  case NOr:
+    return evalBool(node.child[0], ctx) || evalBool(node.child[1], ctx);
+  case NStrEqLex:
+    return (member<lexidx_t>(ctx.ai, node.offset) == node.i) != bool(node.op);
+  case NStrEqChars:
+    return (node.str == &member<char>(ctx.ai, node.offset)) != bool(node.op);
+  }
+  return false;
+}
+
+void AlterExpr::apply(AtomInfoType* ai, int atm, int state, float* xyz) const
+{
+  eval(ai, atm, state, xyz);
+}
+
+bool AlterExpr::check(
+    const AtomInfoType* ai, int atm, int state, const float* xyz) const
+{
+  // statements may read what previous ones wrote, so run them on a copy
+  AtomInfoType tmp = *ai;
+  float tmp_xyz[3];
+  if (xyz)
+    std::copy_n(xyz, 3, tmp_xyz);
+  return eval(&tmp, atm, state, xyz ? tmp_xyz : nullptr);
+}
+
+/**
+ * @return false if an integer result overflowed or doesn't fit its property,
+ * the atom is then partially modified
+ */
+bool AlterExpr::eval(AtomInfoType* ai, int atm, int state, float* xyz) const
+{
+  const Ctx ctx{ai, atm, state, xyz, false};
+
+  for (const auto& stmt : stmts) {
+    switch (stmt.kind) {
+    case SFloat:
+      member<float>(ai, stmt.offset) = float(evalFloat(stmt.value, ctx));
+      break;
+    case SCoord:
+      xyz[stmt.offset] = float(evalFloat(stmt.value, ctx));
+      break;
+    case SInt: {
+      auto value = evalInt(stmt.value, ctx);
+      if (value < INT_MIN || value > INT_MAX)
+        return false;
+      member<int>(ai, stmt.offset) = int(value);
+    } break;
+    case SSChar: {
+      auto value = evalInt(stmt.value, ctx);
+      if (value < SCHAR_MIN || value > SCHAR_MAX)
+        return false;
+      member<signed char>(ai, stmt.offset) = (signed char) value;
+    } break;
+    }
+
+    if (ctx.overflow)
+      return false;
+
+    // same side effects as WrapperObjectAssignSubScript
+    switch (stmt.prop) {
+    case ATOM_PROP_RESV:
+      ai->inscode = '\0';
+      break;
+    case ATOM_PROP_FORMAL_CHARGE:
+      ai->chemFlag = false;
+      break;
+    }
+  }
+
+  return true;
+}
+
+} // namespace pymol
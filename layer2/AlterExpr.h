@@ -0,0 +1,104 @@
+/*
+ * Native evaluation of simple alter/alter_state expressions
+ *
+ * (c) Schrodinger, Inc.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+struct AtomInfoType;
+struct PyMOLGlobals;
+
+namespace pymol
+{
+
+/**
+ * Compiled `alter` / `alter_state` expression from the subset which does not
+ * need the Python interpreter:
+ *
+ * - `;` separated assignments (`=`, `+=`, `-=`, `*=`, `/=`) to numeric atom
+ *   properties (`b`, `q`, `vdw`, `resv`, `color`, ...; `x`, `y`, `z` in
+ *   alter_state)
+ * - numeric literals, numeric atom properties, `index`, `state`, unary and
+ *   binary `+ - *`, division by a non-zero constant
+ * - `A if C else B` where `C` may use comparisons (also chained), `and`,
+ *   `or`, `not`, and `==`/`!=` between a string property (`name`, `resn`,
+ *   `chain`, `elem`, ...) and a string literal
+ *
+ * The result is the same as evaluating the expression with Python. Anything
+ * else, including names from the `space` dictionary and operations which
+ * would raise in Python, fails to compile and the caller falls back to
+ * `PAlterAtomState`.
+ *
+ * Integer arithmetic is exact in Python. If an intermediate value overflows
+ * 64 bit or an assigned value does not fit the property, `check` fails and
+ * the caller must use the Python evaluator, which raises OverflowError.
+ */
+class AlterExpr
+{
+public:
+  enum class Type { Int, Float, Bool, String };
+
+  struct Node {
+    int kind;
+    Type type;
+    int child[3] = {-1, -1, -1};
+    int op = 0;
+    std::size_t offset = 0;
+    std::int64_t i = 0;
+    double f = 0.0;
+    std::string str;
+  };
+
+  struct Stmt {
+    int kind;
+    int prop;
+    std::size_t offset;
+    int value;
+  };
+
+  /**
+   * @param expr Python statement(s)
+   * @param with_coords Allow `x`, `y` and `z` (alter_state)
+   * @return nullptr if `expr` is not in the natively supported subset
+   */
+  static std::unique_ptr<AlterExpr> compile(
+      PyMOLGlobals* G, const char* expr, bool with_coords);
+
+  /**
+   * Evaluates the expression for one atom.
+   * @param atm Atom index (for `index`)
+   * @param state 1-based state (for `state`)
+   * @param xyz Atom coordinates, only needed for `with_coords`
+   */
+  void apply(AtomInfoType* ai, int atm, int state, float* xyz) const;
+
+  /**
+   * True if `apply` will not overflow for this atom. Does not modify the
+   * atom.
+   */
+  bool check(const AtomInfoType* ai, int atm, int state, const float* xyz) const;
+
+  /// If false, `check` always succeeds and doesn't need to be called
+  bool needsCheck() const { return m_needs_check; }
+
+  std::vector<Node> nodes;
+  std::vector<Stmt> stmts;
+
+private:
+  bool m_needs_check = false;
+
+  struct Ctx;
+  bool eval(AtomInfoType* ai, int atm, int state, float* xyz) const;
+  std::int64_t evalInt(int n, const Ctx& ctx) const;
+  double evalFloat(int n, const Ctx& ctx) const;
+  bool evalBool(int n, const Ctx& ctx) const;
+};
+
+} // namespace pymol
@@ -31,8 +31,10 @@ CoordSet * CoordSetCopyFilterChains(
   cset->setNIndex(idxmap.size());
   cset->Obj = other->Obj;
 
+  auto& idx_to_atm = cset->IdxToAtm.mut();
+
   for (int idx = 0; idx < cset->NIndex; ++idx) {
-    cset->IdxToAtm[idx] = other->IdxToAtm[idxmap[idx]];
+    idx_to_atm[idx] = other->IdxToAtm[idxmap[idx]];
     copy3f(other->coordPtr(idxmap[idx]), cset->coordPtr(idx));
   }
 
@@ -10,14 +10,21 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <climits>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <string>
+#include <type_traits>
 #include <vector>
 
 #include "CifFile.h"
 #include "File.h"
 #include "MemoryDebug.h"
+#include "TaskPool.h"
 #include "strcasecmp.h"
 
 namespace pymol {
@@ -102,27 +109,165 @@ static void tolowerinplace(char *p) {
 
 static const cif_array EMPTY_ARRAY(nullptr);
 
+/*
+ * Decoded BinaryCIF column. Numeric values are stored in the typed columns
+ * of the loop.
+ */
+struct cif_column {
+  enum { STRING, INT, FLOAT } type = STRING;
+
+  // 0: present, 1: '.' (inapplicable), 2: '?' (unknown), empty if no value
+  // is missing
+  std::vector<unsigned char> mask;
+
+  // string values, numeric columns get formatted on first access
+  std::vector<const char*> strings;
+  std::vector<char> storage;
+
+  // printf format and precision for formatting float values
+  const char* format = "%.*g";
+  int precision = 15;
+};
+
 /*
  * Class to store CIF loops. Only for parsing, do not use in any higher level
  * reading functions.
  */
 class cif_loop {
 public:
-  int ncols;
-  int nrows;
-  const char **values;
+  int ncols = 0;
+  int nrows = 0;
+
+  // raw values (row-major), NULL for BinaryCIF loops
+  const char **values = nullptr;
+
+  // task pool for the column conversion (may be NULL)
+  PyMOLGlobals* G = nullptr;
+
+  // typed columns, converted on first access
+  mutable std::vector<std::vector<int>> typed_i;
+  mutable std::vector<std::vector<double>> typed_d;
+
+  // BinaryCIF columns (only if `values` is NULL)
+  mutable std::vector<cif_column> columns;
 
   // methods
   const char * get_value_raw(int row, int col) const;
+  bool is_missing(int row, int col) const;
+
+  template <typename T>
+  const std::vector<T>& get_typed(
+      std::vector<std::vector<T>>& cache, int col) const;
+
+private:
+  void format_column(int col) const;
 };
 
 // get table value, return NULL if indices out of bounds
 const char * cif_loop::get_value_raw(int row, int col) const {
   if (row >= nrows)
     return nullptr;
+
+  if (!values) {
+    auto& column = columns[col];
+    if (!column.mask.empty() && column.mask[row])
+      return nullptr;
+    if (column.strings.empty())
+      format_column(col);
+    return column.strings[row];
+  }
+
   return values[row * ncols + col];
 }
 
+// true if value in ['.', '?'] or indices out of bounds
+bool cif_loop::is_missing(int row, int col) const {
+  if (row >= nrows)
+    return true;
+
+  if (!values) {
+    auto& mask = columns[col].mask;
+    return (!mask.empty() && mask[row]) || (columns[col].type ==
+        cif_column::STRING && !columns[col].strings[row]);
+  }
+
+  return !values[row * ncols + col];
+}
+
+/**
+ * Format all values of a numeric BinaryCIF column as strings
+ */
+void cif_loop::format_column(int col) const {
+  auto& column = columns[col];
+  std::vector<std::size_t> offsets(nrows);
+  char buf[64];
+
+  for (int row = 0; row < nrows; ++row) {
+    int n = (column.type == cif_column::INT)
+                ? snprintf(buf, sizeof(buf), "%d", typed_i[col][row])
+                : snprintf(buf, sizeof(buf), column.format, column.precision,
+                      typed_d[col][row]);
+    offsets[row] = column.storage.size();
+    column.storage.insert(column.storage.end(), buf, buf + n + 1);
+  }
+
+  column.strings.resize(nrows);
+  for (int row = 0; row < nrows; ++row) {
+    column.strings[row] = column.storage.data() + offsets[row];
+  }
+}
+
+/**
+ * Get a loop column converted to type T. All values get converted on first
+ * access. Missing values are T().
+ */
+template <typename T>
+const std::vector<T>& cif_loop::get_typed(
+    std::vector<std::vector<T>>& cache, int col) const
+{
+  if (cache.empty())
+    cache.resize(ncols);
+
+  auto& column = cache[col];
+
+  if (column.empty() && nrows > 0 && !values) {
+    // BinaryCIF: copy from the decoded column
+    switch (columns[col].type) {
+    case cif_column::INT:
+      column.assign(typed_i[col].begin(), typed_i[col].end());
+      break;
+    case cif_column::FLOAT:
+      column.resize(nrows);
+      std::transform(typed_d[col].begin(), typed_d[col].end(), column.begin(),
+          [](double v) { return static_cast<T>(v); });
+      break;
+    default:
+      column.resize(nrows);
+      for (int row = 0; row < nrows; ++row) {
+        const char* s = get_value_raw(row, col);
+        column[row] = s ? _cif_detail::raw_to_typed<T>(s) : T();
+      }
+    }
+  } else if (column.empty() && nrows > 0) {
+    column.resize(nrows);
+
+    auto convert = [&](std::size_t begin, std::size_t end, unsigned) {
+      for (auto row = begin; row != end; ++row) {
+        const char* s = values[row * ncols + col];
+        column[row] = s ? _cif_detail::raw_to_typed<T>(s) : T();
+      }
+    };
+
+    if (G) {
+      pymol::parallel_for(G, nrows, 4096, convert);
+    } else {
+      convert(0, nrows, 0);
+    }
+  }
+
+  return column;
+}
+
 // get the number of elements in this array
 unsigned cif_array::size() const {
   return (col == NOT_IN_LOOP) ? 1 : pointer.loop->nrows;
@@ -136,6 +281,27 @@ const char* cif_array::get_value_raw(unsigned pos) const
   return pointer.loop->get_value_raw(pos, col);
 }
 
+bool cif_array::is_missing(unsigned pos) const
+{
+  if (col == NOT_IN_LOOP)
+    return !get_value_raw(pos);
+  return pointer.loop->is_missing(pos, col);
+}
+
+int cif_array::as_i(unsigned pos, int d) const
+{
+  if (col == NOT_IN_LOOP || is_missing(pos))
+    return as(pos, d);
+  return pointer.loop->get_typed(pointer.loop->typed_i, col)[pos];
+}
+
+double cif_array::as_d(unsigned pos, double d) const
+{
+  if (col == NOT_IN_LOOP || is_missing(pos))
+    return as(pos, d);
+  return pointer.loop->get_typed(pointer.loop->typed_d, col)[pos];
+}
+
 // true if all values in ['.', '?']
 bool cif_array::is_missing_all() const {
   for (unsigned i = 0, n = size(); i != n; ++i) {
@@ -195,7 +361,7 @@ const cif_data* cif_data::get_saveframe(const char* code) const {
   return nullptr;
 }
 
-bool cif_file::parse_file(const char* filename) {
+bool cif_file::parse_file(const char* filename, PyMOLGlobals* G) {
   char* contents = FileGetContents(filename, nullptr);
 
   if (!contents) {
@@ -203,11 +369,11 @@ bool cif_file::parse_file(const char* filename) {
     return false;
   }
 
-  return parse(std::move(contents));
+  return parse(std::move(contents), G);
 }
 
-bool cif_file::parse_string(const char* contents) {
-  return parse(std::move(mstrdup(contents)));
+bool cif_file::parse_string(const char* contents, PyMOLGlobals* G) {
+  return parse(std::move(mstrdup(contents)), G);
 }
 
 void cif_file::error(const char* msg) {
@@ -233,40 +399,55 @@ cif_file& cif_file::operator=(cif_file&&) = default;
 // destructor
 cif_file::~cif_file() = default;
 
-bool cif_file::parse(char*&& p) {
-  m_datablocks.clear();
-  m_tokens.clear();
-  m_contents.reset(p);
+namespace {
 
-  if (!p) {
-    error("parse(nullptr)");
-    return false;
-  }
+/**
+ * Tokens of a part of the CIF string. Null-terminating the tokens is
+ * deferred (`nuls`), so parts can be tokenized concurrently and a failed
+ * attempt leaves the string untouched.
+ */
+struct cif_tokens {
+  std::vector<char*> tokens;
+  std::vector<char> keypossible;
+  std::vector<char*> nuls;
+  unsigned n_textfields = 0;
+};
 
-  auto& tokens = m_tokens;
-  char quote;
-  char prev = '\0';
+} // namespace
 
-  std::vector<bool> keypossible;
+/**
+ * Tokenize the part [p, end) of a CIF string. `*end` must be readable, it
+ * is either the null terminator or the first character of the next part.
+ *
+ * @param prev Character before `p` ('\0' at the start of the string)
+ * @return false if a token doesn't end before `end` (only possible if
+ * `end` is not the end of the string)
+ */
+static bool cif_tokenize(char* p, const char* end, char prev, cif_tokens& out)
+{
+  auto& tokens = out.tokens;
+  auto& keypossible = out.keypossible;
+  char quote;
 
-  // tokenize
   while (true) {
-    while (iswhitespace(*p))
+    while (p < end && iswhitespace(*p))
       prev = *(p++);
 
-    if (!*p)
+    if (p >= end || !*p)
       break;
 
     if (*p == '#') {
-      while (!(islinefeed0(*++p)));
+      while (++p < end && !islinefeed0(*p));
       prev = *p;
     } else if (isquote(*p)) { // will NULL the closing quote
       quote = *p;
       keypossible.push_back(false);
       tokens.push_back(p + 1);
-      while (*++p && !(*p == quote && iswhitespace0(p[1])));
+      while (++p < end && *p && !(*p == quote && iswhitespace0(p[1])));
+      if (p >= end && *end)
+        return false;
       if (*p)
-        *(p++) = 0;
+        out.nuls.push_back(p++);
       prev = *p;
     } else if (*p == ';' && islinefeed(prev)) {
       // multi-line tokens start with ";" and end with "\n;"
@@ -274,20 +455,25 @@ bool cif_file::parse(char*&& p) {
       keypossible.push_back(false);
       tokens.push_back(p + 1);
       // advance until `\n;`
-      while (*++p && !(islinefeed(*p) && p[1] == ';'));
+      while (++p < end && *p && !(islinefeed(*p) && p[1] == ';'));
+      if (p + 1 >= end && *end)
+        return false;
       // step to next line and null the line feed
       if (*p) {
-        *p = 0;
+        out.nuls.push_back(p);
         // \r\n on Windows)
         if (p - 1 > tokens.back() && *(p - 1) == '\r') {
-          *(p - 1) = 0;
+          out.nuls.push_back(p - 1);
         }
         p += 2;
+        ++out.n_textfields;
       }
       prev = ';';
     } else { // will null the whitespace
       char * q = p++;
-      while (!iswhitespace0(*p)) ++p;
+      while (p < end && !iswhitespace0(*p)) ++p;
+      if (p >= end && *end)
+        return false;
       prev = *p;
       if (p - q == 1 && (*q == '?' || *q == '.')) {
         // store values '.' (inapplicable) and '?' (unknown) as null-pointers
@@ -295,13 +481,163 @@ bool cif_file::parse(char*&& p) {
         keypossible.push_back(false);
       } else {
         if (*p)
-          *(p++) = 0;
+          out.nuls.push_back(p++);
         keypossible.push_back(true);
       }
       tokens.push_back(q);
     }
   }
 
+  return true;
+}
+
+/**
+ * Tokenize a large CIF string in parallel. The string is split at line
+ * starts outside of multi-line values. Those can be told apart by counting
+ * the semicolons at line starts (they open and close multi-line values),
+ * unless a quoted value spans several lines. Then the token count check
+ * fails and the caller falls back to the serial tokenizer.
+ *
+ * @return false if not done (string too small, or no consistent split)
+ */
+static bool cif_tokenize_parallel(
+    PyMOLGlobals* G, char* begin, char* end, cif_tokens& out)
+{
+  const std::size_t min_part_size = 1 << 20;
+  const std::size_t size = end - begin;
+  const unsigned n_workers = G ? pymol::parallel_workers(G) : 1;
+
+  if (n_workers < 2 || size < 2 * min_part_size) {
+    return false;
+  }
+
+  const std::size_t n_sections =
+      std::min<std::size_t>(size / min_part_size, n_workers * 4);
+
+  // semicolons at line starts
+  std::vector<std::vector<char*>> section_semis(n_sections);
+  pymol::parallel_for(G, n_sections, 1,
+      [&](std::size_t s_begin, std::size_t s_end, unsigned) {
+        for (auto s = s_begin; s != s_end; ++s) {
+          char* q = std::max(begin + size * s / n_sections, begin + 1);
+          char* q_end = begin + size * (s + 1) / n_sections;
+          while (q < q_end &&
+                 (q = (char*) memchr(q, ';', q_end - q)) != nullptr) {
+            if (islinefeed(q[-1]))
+              section_semis[s].push_back(q);
+            ++q;
+          }
+        }
+      });
+
+  std::vector<char*> semis;
+  for (auto& v : section_semis)
+    semis.insert(semis.end(), v.begin(), v.end());
+
+  auto count_semis = [&](const char* lo, const char* hi) {
+    return std::lower_bound(semis.begin(), semis.end(), hi) -
+           std::lower_bound(semis.begin(), semis.end(), lo);
+  };
+
+  auto next_line_start = [&](char* q) {
+    while (q < end && !islinefeed(*q))
+      ++q;
+    while (q < end && islinefeed(*q))
+      ++q;
+    return q;
+  };
+
+  // split points
+  std::vector<char*> bounds{begin};
+  for (std::size_t s = 1; s < n_sections; ++s) {
+    char* b = next_line_start(begin + size * s / n_sections - 1);
+
+    // inside of a multi-line value, move behind its end
+    auto n_before = std::lower_bound(semis.begin(), semis.end(), b) - semis.begin();
+    if (n_before % 2) {
+      if (std::size_t(n_before) == semis.size())
+        break; // unterminated
+      b = next_line_start(semis[n_before]);
+    }
+
+    if (b < end && b > bounds.back()) {
+      bounds.push_back(b);
+    }
+  }
+  bounds.push_back(end);
+
+  const std::size_t n_parts = bounds.size() - 1;
+  std::vector<cif_tokens> parts(n_parts);
+  std::atomic<bool> ok{true};
+
+  pymol::parallel_for(G, n_parts, 1,
+      [&](std::size_t k_begin, std::size_t k_end, unsigned) {
+        for (auto k = k_begin; k != k_end && ok; ++k) {
+          char prev = k ? bounds[k][-1] : '\0';
+          if (!cif_tokenize(bounds[k], bounds[k + 1], prev, parts[k]) ||
+              count_semis(bounds[k], bounds[k + 1]) !=
+                  2 * parts[k].n_textfields) {
+            ok = false;
+          }
+        }
+      });
+
+  if (!ok) {
+    return false;
+  }
+
+  // concatenate
+  std::vector<std::size_t> offsets(n_parts + 1, 0);
+  for (std::size_t k = 0; k != n_parts; ++k) {
+    offsets[k + 1] = offsets[k] + parts[k].tokens.size();
+  }
+
+  out.tokens.resize(offsets[n_parts]);
+  out.keypossible.resize(offsets[n_parts]);
+
+  pymol::parallel_for(G, n_parts, 1,
+      [&](std::size_t k_begin, std::size_t k_end, unsigned) {
+        for (auto k = k_begin; k != k_end; ++k) {
+          auto& part = parts[k];
+          std::copy(part.tokens.begin(), part.tokens.end(),
+              out.tokens.begin() + offsets[k]);
+          std::copy(part.keypossible.begin(), part.keypossible.end(),
+              out.keypossible.begin() + offsets[k]);
+          for (char* q : part.nuls) {
+            *q = 0;
+          }
+        }
+      });
+
+  return true;
+}
+
+bool cif_file::parse(char*&& p, PyMOLGlobals* G) {
+  m_datablocks.clear();
+  m_tokens.clear();
+  m_contents.reset(p);
+
+  if (!p) {
+    error("parse(nullptr)");
+    return false;
+  }
+
+  cif_tokens parsed;
+
+  // tokenize
+  char* end = p + strlen(p);
+  if (!cif_tokenize_parallel(G, p, end, parsed)) {
+    parsed = cif_tokens();
+    cif_tokenize(p, end, '\0', parsed);
+    for (char* q : parsed.nuls) {
+      *q = 0;
+    }
+  }
+
+  auto& tokens = m_tokens;
+  tokens = std::move(parsed.tokens);
+  const auto& keypossible = parsed.keypossible;
+
   cif_data* current_frame = nullptr;
   std::vector<cif_data*> frame_stack;
   std::unique_ptr<cif_data> global_block;
@@ -339,6 +675,7 @@ bool cif_file::parse(char*&& p) {
 
       // loop data
       loop = new cif_loop;
+      loop->G = G;
       current_frame->m_loops.emplace_back(loop);
 
       // columns
@@ -419,6 +756,610 @@ bool cif_file::parse(char*&& p) {
   return true;
 }
 
+// BinaryCIF
+
+namespace {
+
+/**
+ * MessagePack value. Strings and binary data point into the parsed buffer.
+ */
+struct msgpack_value {
+  enum { NIL, BOOL, INT, FLOAT, STR, BIN, ARRAY, MAP } kind = NIL;
+  std::int64_t i = 0;
+  double f = 0.;
+  const char* data = nullptr;
+  std::size_t size = 0;
+
+  // array elements, or map keys and values in alternating order
+  std::vector<msgpack_value> items;
+
+  double number() const { return (kind == FLOAT) ? f : double(i); }
+
+  std::string str() const {
+    return (kind == STR) ? std::string(data, size) : std::string();
+  }
+
+  bool is(const char* s) const {
+    return kind == STR && size == strlen(s) && memcmp(data, s, size) == 0;
+  }
+
+  /// Map value for `key`, or NULL if not found
+  const msgpack_value* get(const char* key) const {
+    if (kind == MAP) {
+      for (std::size_t k = 0; k + 1 < items.size(); k += 2) {
+        if (items[k].is(key))
+          return &items[k + 1];
+      }
+    }
+    return nullptr;
+  }
+};
+
+/**
+ * Minimal MessagePack reader, ignores extension types
+ */
+class msgpack_reader {
+  const unsigned char* m_p;
+  const unsigned char* m_end;
+
+  bool read_uint(unsigned nbytes, std::uint64_t& out) {
+    if (std::size_t(m_end - m_p) < nbytes)
+      return false;
+    for (out = 0; nbytes; --nbytes)
+      out = (out << 8) | *(m_p++);
+    return true;
+  }
+
+  bool read_bytes(std::size_t n, msgpack_value& v) {
+    if (std::size_t(m_end - m_p) < n)
+      return false;
+    v.data = reinterpret_cast<const char*>(m_p);
+    v.size = n;
+    m_p += n;
+    return true;
+  }
+
+  bool read_items(std::size_t n, msgpack_value& v, int depth) {
+    // every item takes at least one byte
+    if (std::size_t(m_end - m_p) < n)
+      return false;
+    v.items.resize(n);
+    for (auto& item : v.items) {
+      if (!read(item, depth + 1))
+        return false;
+    }
+    return true;
+  }
+
+public:
+  msgpack_reader(const char* p, std::size_t size)
+      : m_p(reinterpret_cast<const unsigned char*>(p)), m_end(m_p + size)
+  {
+  }
+
+  bool read(msgpack_value& v, int depth = 0) {
+    std::uint64_t u = 0;
+
+    if (m_p == m_end || depth > 32)
+      return false;
+
+    unsigned c = *(m_p++);
+
+    if (c <= 0x7f || c >= 0xe0) {
+      v.kind = msgpack_value::INT;
+      v.i = static_cast<signed char>(c);
+      if (c <= 0x7f)
+        v.i = c;
+      return true;
+    }
+
+    switch (c >> 4) {
+    case 0x8:
+      v.kind = msgpack_value::MAP;
+      return read_items((c & 0xf) * 2, v, depth);
+    case 0x9:
+      v.kind = msgpack_value::ARRAY;
+      return read_items(c & 0xf, v, depth);
+    case 0xa:
+    case 0xb:
+      v.kind = msgpack_value::STR;
+      return read_bytes(c & 0x1f, v);
+    }
+
+    switch (c) {
+    case 0xc0:
+      v.kind = msgpack_value::NIL;
+      return true;
+    case 0xc2:
+    case 0xc3:
+      v.kind = msgpack_value::BOOL;
+      v.i = c & 1;
+      return true;
+    case 0xc4:
+    case 0xc5:
+    case 0xc6:
+      v.kind = msgpack_value::BIN;
+      return read_uint(1 << (c - 0xc4), u) && read_bytes(u, v);
+    case 0xc7:
+    case 0xc8:
+    case 0xc9:
+      v.kind = msgpack_value::NIL;
+      return read_uint(1 << (c - 0xc7), u) && read_bytes(u + 1, v);
+    case 0xca: {
+      float f;
+      std::uint32_t bits;
+      if (!read_uint(4, u))
+        return false;
+      bits = u;
+      memcpy(&f, &bits, 4);
+      v.kind = msgpack_value::FLOAT;
+      v.f = f;
+      return true;
+    }
+    case 0xcb:
+      if (!read_uint(8, u))
+        return false;
+      v.kind = msgpack_value::FLOAT;
+      memcpy(&v.f, &u, 8);
+      return true;
+    case 0xcc:
+    case 0xcd:
+    case 0xce:
+    case 0xcf:
+      v.kind = msgpack_value::INT;
+      if (!read_uint(1 << (c - 0xcc), u))
+        return false;
+      v.i = u;
+      return true;
+    case 0xd0:
+    case 0xd1:
+    case 0xd2:
+    case 0xd3: {
+      unsigned nbytes = 1 << (c - 0xd0);
+      if (!read_uint(nbytes, u))
+        return false;
+      // sign extend
+      unsigned shift = 64 - 8 * nbytes;
+      v.kind = msgpack_value::INT;
+      v.i = static_cast<std::int64_t>(u << shift) >> shift;
+      return true;
+    }
+    case 0xd4:
+    case 0xd5:
+    case 0xd6:
+    case 0xd7:
+    case 0xd8:
+      v.kind = msgpack_value::NIL;
+      return read_bytes((1 << (c - 0xd4)) + 1, v);
+    case 0xd9:
+    case 0xda:
+    case 0xdb:
+      v.kind = msgpack_value::STR;
+      return read_uint(1 << (c - 0xd9), u) && read_bytes(u, v);
+    case 0xdc:
+    case 0xdd:
+      v.kind = msgpack_value::ARRAY;
+      return read_uint(2 << (c - 0xdc), u) && read_items(u, v, depth);
+    case 0xde:
+    case 0xdf:
+      v.kind = msgpack_value::MAP;
+      return read_uint(2 << (c - 0xde), u) && u <= SIZE_MAX / 2 &&
+             read_items(u * 2, v, depth);
+    }
+
+    return false;
+  }
+};
+
+/**
+ * Read a little-endian value
+ */
+template <typename T> T bcif_read_le(const unsigned char* p)
+{
+  typename std::conditional<sizeof(T) == 8, std::uint64_t,
+      std::uint32_t>::type u = 0;
+  for (unsigned k = sizeof(T); k--;) {
+    u = (u << 8) | p[k];
+  }
+  if (std::is_floating_point<T>::value) {
+    T v;
+    memcpy(&v, &u, sizeof(T));
+    return v;
+  }
+  return static_cast<T>(u);
+}
+
+/**
+ * BinaryCIF numeric data during decoding
+ */
+struct bcif_numbers {
+  bool is_float = false;
+  std::vector<int> ints;
+  std::vector<double> floats;
+  const char* format = "%.*g";
+  int precision = 15;
+};
+
+template <typename T, typename U>
+void bcif_byte_array(const msgpack_value& data, std::vector<U>& out)
+{
+  auto p = reinterpret_cast<const unsigned char*>(data.data);
+  out.resize(data.size / sizeof(T));
+  for (std::size_t k = 0; k != out.size(); ++k) {
+    out[k] = bcif_read_le<T>(p + k * sizeof(T));
+  }
+}
+
+/**
+ * Decode BinaryCIF encoded numeric data
+ * @param data Encoded data (binary)
+ * @param encoding Encodings, in the order they were applied
+ * @return error message, or NULL on success
+ */
+const char* bcif_decode(const msgpack_value& data,
+    const msgpack_value& encoding, bcif_numbers& out)
+{
+  if (encoding.kind != msgpack_value::ARRAY)
+    return "invalid encoding";
+
+  auto& ints = out.ints;
+  auto& floats = out.floats;
+  bool decoded = false;
+
+  for (auto it = encoding.items.rbegin(); it != encoding.items.rend(); ++it) {
+    auto kind = it->get("kind");
+    if (!kind)
+      return "invalid encoding";
+
+    if (kind->is("ByteArray")) {
+      auto type = it->get("type");
+      if (decoded || data.kind != msgpack_value::BIN || !type)
+        return "invalid ByteArray encoding";
+
+      out.is_float = false;
+      switch (type->i) {
+      case 1: bcif_byte_array<std::int8_t>(data, ints); break;
+      case 2: bcif_byte_array<std::int16_t>(data, ints); break;
+      case 3: bcif_byte_array<std::int32_t>(data, ints); break;
+      case 4: bcif_byte_array<std::uint8_t>(data, ints); break;
+      case 5: bcif_byte_array<std::uint16_t>(data, ints); break;
+      case 6: bcif_byte_array<std::uint32_t>(data, ints); break;
+      case 32:
+        bcif_byte_array<float>(data, floats);
+        out.is_float = true;
+        out.precision = 7;
+        break;
+      case 33:
+        bcif_byte_array<double>(data, floats);
+        out.is_float = true;
+        break;
+      default:
+        return "unknown ByteArray type";
+      }
+      decoded = true;
+      continue;
+    }
+
+    if (!decoded || out.is_float)
+      return "invalid encoding order";
+
+    if (kind->is("FixedPoint") || kind->is("IntervalQuantization")) {
+      double offset = 0., scale = 1.;
+
+      if (kind->is("FixedPoint")) {
+        auto factor = it->get("factor");
+        if (!factor || factor->number() == 0.)
+          return "invalid FixedPoint encoding";
+        scale = 1. / factor->number();
+
+        // decimal places for formatting
+        int decimals = std::lround(std::log10(factor->number()));
+        if (decimals >= 0 && std::pow(10., decimals) == factor->number()) {
+          out.format = "%.*f";
+          out.precision = decimals;
+        }
+      } else {
+        auto min = it->get("min"), max = it->get("max");
+        auto steps = it->get("numSteps");
+        if (!min || !max || !steps || steps->i < 2)
+          return "invalid IntervalQuantization encoding";
+        offset = min->number();
+        scale = (max->number() - offset) / (steps->i - 1);
+      }
+
+      floats.resize(ints.size());
+      for (std::size_t k = 0; k != ints.size(); ++k) {
+        floats[k] = offset + scale * ints[k];
+      }
+
+      ints.clear();
+      out.is_float = true;
+    } else if (kind->is("RunLength")) {
+      auto src_size = it->get("srcSize");
+      if (!src_size || src_size->i < 0 || ints.size() % 2)
+        return "invalid RunLength encoding";
+
+      std::int64_t total = 0;
+      for (std::size_t k = 1; k < ints.size(); k += 2) {
+        if (ints[k] < 0)
+          return "invalid RunLength encoding";
+        total += ints[k];
+      }
+
+      if (total != src_size->i)
+        return "invalid RunLength encoding";
+
+      std::vector<int> runs;
+      runs.reserve(total);
+      for (std::size_t k = 0; k != ints.size(); k += 2) {
+        runs.insert(runs.end(), ints[k + 1], ints[k]);
+      }
+      ints = std::move(runs);
+    } else if (kind->is("Delta")) {
+      auto origin = it->get("origin");
+      int value = origin ? origin->i : 0;
+      for (auto& v : ints) {
+        v = value += v;
+      }
+    } else if (kind->is("IntegerPacking")) {
+      auto byte_count = it->get("byteCount");
+      auto is_unsigned = it->get("isUnsigned");
+      if (!byte_count || !is_unsigned)
+        return "invalid IntegerPacking encoding";
+
+      const int upper = is_unsigned->i ? (byte_count->i == 1 ? 0xFF : 0xFFFF)
+                                       : (byte_count->i == 1 ? 0x7F : 0x7FFF);
+      const int lower = is_unsigned->i ? upper
+                                       : (byte_count->i == 1 ? -0x80 : -0x8000);
+
+      std::vector<int> unpacked;
+      unpacked.reserve(ints.size());
+      for (std::size_t k = 0; k != ints.size(); ++k) {
+        int value = 0;
+        while (ints[k] == upper || ints[k] == lower) {
+          value += ints[k];
+          if (++k == ints.size())
+            return "truncated IntegerPacking data";
+        }
+        unpacked.push_back(value + ints[k]);
+      }
+      ints = std::move(unpacked);
+    } else {
+      return "unsupported encoding";
+    }
+  }
+
+  return decoded ? nullptr : "missing ByteArray encoding";
+}
+
+/**
+ * Decode a StringArray encoded column
+ */
+const char* bcif_decode_strings(const msgpack_value& data,
+    const msgpack_value& encoding, cif_column& out)
+{
+  auto string_data = encoding.get("stringData");
+  auto offsets_data = encoding.get("offsets");
+  auto offset_encoding = encoding.get("offsetEncoding");
+  auto data_encoding = encoding.get("dataEncoding");
+
+  if (!string_data || !offsets_data || !offset_encoding || !data_encoding ||
+      string_data->kind != msgpack_value::STR)
+    return "invalid StringArray encoding";
+
+  bcif_numbers offsets, indices;
+  const char* err;
+
+  if ((err = bcif_decode(*offsets_data, *offset_encoding, offsets)) ||
+      (err = bcif_decode(data, *data_encoding, indices)))
+    return err;
+
+  if (offsets.is_float || indices.is_float || offsets.ints.empty())
+    return "invalid StringArray encoding";
+
+  // null-terminated copy of each distinct string
+  const auto n_strings = offsets.ints.size() - 1;
+  std::vector<std::size_t> starts(n_strings);
+  for (std::size_t k = 0; k != n_strings; ++k) {
+    int begin = offsets.ints[k], end = offsets.ints[k + 1];
+    if (begin < 0 || begin > end || std::size_t(end) > string_data->size)
+      return "invalid StringArray offsets";
+    starts[k] = out.storage.size();
+    out.storage.insert(out.storage.end(), string_data->data + begin,
+        string_data->data + end);
+    out.storage.push_back('\0');
+  }
+
+  out.strings.resize(indices.ints.size());
+  for (std::size_t k = 0; k != out.strings.size(); ++k) {
+    int index = indices.ints[k];
+    if (index >= int(n_strings))
+      return "invalid StringArray index";
+    out.strings[k] = (index < 0) ? nullptr : out.storage.data() + starts[index];
+  }
+
+  out.type = cif_column::STRING;
+  return nullptr;
+}
+
+/**
+ * Decode a BinaryCIF column (data and mask) into `loop->columns[col]` and
+ * the typed columns
+ * @return error message, or NULL on success
+ */
+const char* bcif_decode_column(
+    const msgpack_value& column, const cif_loop* loop, int col)
+{
+  auto data = column.get("data");
+  auto encoded = data ? data->get("data") : nullptr;
+  auto encoding = data ? data->get("encoding") : nullptr;
+
+  if (!encoded || !encoding || encoding->kind != msgpack_value::ARRAY)
+    return "invalid column";
+
+  auto& out = loop->columns[col];
+  std::size_t size = 0;
+  const char* err;
+
+  if (encoding->items.size() == 1 && encoding->items[0].get("kind") &&
+      encoding->items[0].get("kind")->is("StringArray")) {
+    if ((err = bcif_decode_strings(*encoded, encoding->items[0], out)))
+      return err;
+    size = out.strings.size();
+  } else {
+    bcif_numbers numbers;
+    if ((err = bcif_decode(*encoded, *encoding, numbers)))
+      return err;
+    if (numbers.is_float) {
+      out.type = cif_column::FLOAT;
+      out.format = numbers.format;
+      out.precision = numbers.precision;
+      size = numbers.floats.size();
+      loop->typed_d[col] = std::move(numbers.floats);
+    } else {
+      out.type = cif_column::INT;
+      size = numbers.ints.size();
+      loop->typed_i[col] = std::move(numbers.ints);
+    }
+  }
+
+  if (size != std::size_t(loop->nrows))
+    return "column size mismatch";
+
+  auto mask = column.get("mask");
+  if (mask && mask->kind == msgpack_value::MAP) {
+    bcif_numbers numbers;
+    auto mask_data = mask->get("data");
+    auto mask_encoding = mask->get("encoding");
+    if (!mask_data || !mask_encoding)
+      return "invalid mask";
+    if ((err = bcif_decode(*mask_data, *mask_encoding, numbers)))
+      return err;
+    if (numbers.is_float || numbers.ints.size() != size)
+      return "invalid mask";
+    if (std::any_of(numbers.ints.begin(), numbers.ints.end(),
+            [](int v) { return v != 0; })) {
+      out.mask.assign(numbers.ints.begin(), numbers.ints.end());
+    }
+  }
+
+  return nullptr;
+}
+
+} // namespace
+
+bool cif_file::parse_bcif(const char* bytes, std::size_t size, PyMOLGlobals* G)
+{
+  m_datablocks.clear();
+  m_tokens.clear();
+  m_contents.reset();
+  m_strings.clear();
+
+  msgpack_value root;
+  if (!bytes || !msgpack_reader(bytes, size).read(root)) {
+    error("BinaryCIF: invalid MessagePack data");
+    return false;
+  }
+
+  auto blocks = root.get("dataBlocks");
+  if (!blocks || blocks->kind != msgpack_value::ARRAY) {
+    error("BinaryCIF: missing dataBlocks");
+    return false;
+  }
+
+  struct column_job {
+    const msgpack_value* column;
+    const cif_loop* loop;
+    int col;
+    const char* key;
+    const char* err = nullptr;
+  };
+
+  std::vector<column_job> jobs;
+  decltype(m_datablocks) datablocksnew;
+
+  for (auto& block : blocks->items) {
+    auto header = block.get("header");
+    auto categories = block.get("categories");
+    if (!categories || categories->kind != msgpack_value::ARRAY) {
+      error("BinaryCIF: missing categories");
+      return false;
+    }
+
+    datablocksnew.emplace_back();
+    auto& data = datablocksnew.back();
+    m_strings.push_back(header ? header->str() : std::string());
+    data.m_code = m_strings.back().c_str();
+
+    for (auto& category : categories->items) {
+      auto name = category.get("name");
+      auto row_count = category.get("rowCount");
+      auto columns = category.get("columns");
+
+      if (!name || !row_count || !columns || row_count->i < 0 ||
+          row_count->i > INT_MAX || columns->kind != msgpack_value::ARRAY ||
+          columns->items.size() > SHRT_MAX) {
+        error("BinaryCIF: invalid category");
+        return false;
+      }
+
+      auto loop = new cif_loop;
+      data.m_loops.emplace_back(loop);
+      loop->G = G;
+      loop->ncols = columns->items.size();
+      loop->nrows = row_count->i;
+      loop->columns.resize(loop->ncols);
+      loop->typed_i.resize(loop->ncols);
+      loop->typed_d.resize(loop->ncols);
+
+      for (int col = 0; col != loop->ncols; ++col) {
+        auto& column = columns->items[col];
+        auto column_name = column.get("name");
+
+        // "_category.column", name may lack the leading underscore
+        std::string key = name->str();
+        if (key.empty() || key[0] != '_')
+          key.insert(0, 1, '_');
+        key.append(1, '.').append(column_name ? column_name->str() : "");
+        m_strings.push_back(std::move(key));
+        tolowerinplace(&m_strings.back()[0]);
+
+        data.m_dict[m_strings.back().c_str()].set_loop(loop, col);
+        jobs.push_back({&column, loop, col, m_strings.back().c_str()});
+      }
+    }
+  }
+
+  // decode columns
+  auto decode = [&](std::size_t begin, std::size_t end, unsigned) {
+    for (auto k = begin; k != end; ++k) {
+      jobs[k].err = bcif_decode_column(*jobs[k].column, jobs[k].loop, jobs[k].col);
+    }
+  };
+
+  if (G) {
+    pymol::parallel_for(G, jobs.size(), 1, decode);
+  } else {
+    decode(0, jobs.size(), 0);
+  }
+
+  for (auto& job : jobs) {
+    if (job.err) {
+      error(std::string("BinaryCIF: ")
+                .append(job.err)
+                .append(" (")
+                .append(job.key)
+                .append(")")
+                .c_str());
+      return false;
+    }
+  }
+
+  m_datablocks = std::move(datablocksnew);
+
+  return true;
+}
+
 } // namespace pymol
 
 // vi:sw=2:ts=2
@@ -9,13 +9,17 @@
 
 #include <cstddef>
 #include <cstring>
+#include <deque>
 #include <map>
 #include <memory>
+#include <string>
 #include <vector>
 
 // for pymol::default_free
 #include "MemoryDebug.h"
 
+struct PyMOLGlobals;
+
 namespace pymol {
 namespace _cif_detail {
 
@@ -55,6 +59,9 @@ class cif_array;
  * Read CIF string:
  * @verbatim auto cf = cif_file(nullptr, cifstring); @endverbatim
  *
+ * Read BinaryCIF buffer:
+ * @verbatim cif_file cf; cf.parse_bcif(bytes, size); @endverbatim
+ *
  * Iterate over data blocks:
  * @verbatim
    for (auto& block : cf.datablocks()) {
@@ -84,19 +91,30 @@ class cif_file {
   std::vector<cif_data> m_datablocks;
   std::unique_ptr<char, pymol::default_free> m_contents;
 
+  // BinaryCIF data names and block codes
+  std::deque<std::string> m_strings;
+
   /**
    * Parse CIF string
    * @param p CIF string (takes ownership)
+   * @param G Task pool for tokenizing and converting loop columns, optional
    * @post datablocks() is valid
    */
-  bool parse(char*&&);
+  bool parse(char*&&, PyMOLGlobals* G);
 
 public:
-  /// Parse CIF file
-  bool parse_file(const char*);
+  /// Parse CIF file, in parallel if `G` is given
+  bool parse_file(const char*, PyMOLGlobals* G = nullptr);
+
+  /// Parse CIF string, in parallel if `G` is given
+  bool parse_string(const char*, PyMOLGlobals* G = nullptr);
 
-  /// Parse CIF string
-  bool parse_string(const char*);
+  /**
+   * Parse BinaryCIF (MessagePack) buffer. Columns get decoded into typed
+   * buffers, in parallel if `G` is given. The buffer is not referenced
+   * after this call.
+   */
+  bool parse_bcif(const char* bytes, std::size_t size, PyMOLGlobals* G = nullptr);
 
 protected:
   /// Report a parsing error
@@ -161,7 +179,7 @@ public:
   unsigned size() const;
 
   /// True if value in ['.', '?']
-  bool is_missing(unsigned pos = 0) const { return !get_value_raw(pos); }
+  bool is_missing(unsigned pos = 0) const;
 
   /// True if all values in ['.', '?']
   bool is_missing_all() const;
@@ -187,11 +205,14 @@ public:
     return as(pos, d);
   }
 
-  /// Alias for as<int>()
-  int as_i(unsigned pos = 0, int d = 0) const { return as(pos, d); }
+  /**
+   * Like as<int>(), but converts all values of a loop column at once on
+   * first access. Not thread-safe.
+   */
+  int as_i(unsigned pos = 0, int d = 0) const;
 
-  /// Alias for as<double>()
-  double as_d(unsigned pos = 0, double d = 0.) const { return as(pos, d); }
+  /// Like as<double>(), with bulk conversion like as_i()
+  double as_d(unsigned pos = 0, double d = 0.) const;
 
   /**
    * Get a copy of the array.
@@ -1193,7 +1193,7 @@ static CoordSet** read_atom_site(PyMOLGlobals* G, const cif_data* data,
       if (mod_num != first_model_num) {
         int atm = name_dict[key] - 1;
         if (atm >= 0) {
-          cset->IdxToAtm[idx] = atm;
+          cset->IdxToAtm.mut()[idx] = atm;
           continue;
         }
       }
@@ -1201,7 +1201,7 @@ static CoordSet** read_atom_site(PyMOLGlobals* G, const cif_data* data,
       name_dict[key] = atomCount + 1;
     }
 
-    cset->IdxToAtm[idx] = atomCount;
+    cset->IdxToAtm.mut()[idx] = atomCount;
 
     VLACheck(*atInfoPtr, AtomInfoType, atomCount);
     ai = *atInfoPtr + atomCount;
@@ -2240,30 +2240,12 @@ static ObjectMolecule *ObjectMoleculeReadCifData(PyMOLGlobals * G,
 }
 
 /**
- * Read one or multiple object-molecules from a CIF file. If there is only one
- * or multiplex=0, then return the object-molecule. Otherwise, create each
- * object - named by its data block name - and return NULL.
+ * Create object-molecules from a parsed CIF or BinaryCIF file
  */
-pymol::Result<ObjectMolecule*> ObjectMoleculeReadCifStr(PyMOLGlobals * G, ObjectMolecule * I,
-                                      const char *st, int frame,
-                                      int discrete, int quiet, int multiplex,
-                                      int zoom)
+static pymol::Result<ObjectMolecule*> ObjectMoleculeReadCifFile(
+    PyMOLGlobals* G, std::shared_ptr<cif_file_with_error_capture> cif,
+    int discrete, int quiet, int multiplex, int zoom)
 {
-  if (I) {
-    return pymol::Error("loading mmCIF into existing object not supported, "
-                        "please use 'create' to append to an existing object.");
-  }
-
-  if (multiplex > 0) {
-    return pymol::Error("loading mmCIF with multiplex=1 not supported, please "
-                        "use 'split_states' after loading the object.");
-  }
-
-  auto cif = std::make_shared<cif_file_with_error_capture>();
-  if (!cif->parse_string(st)) {
-    return pymol::make_error("Parsing CIF file failed: ", cif->m_error_msg);
-  }
-
   for (const auto& datablock : cif->datablocks()) {
     ObjectMolecule * obj = ObjectMoleculeReadCifData(G, &datablock, discrete, quiet);
 
@@ -2293,6 +2275,63 @@ pymol::Result<ObjectMolecule*> ObjectMoleculeReadCifStr(PyMOLGlobals * G, Object
   return nullptr;
 }
 
+/**
+ * Loading into an existing object and multiplex=1 are not supported
+ */
+static pymol::Result<> ObjectMoleculeReadCifCheck(
+    ObjectMolecule* I, int multiplex)
+{
+  if (I) {
+    return pymol::Error("loading mmCIF into existing object not supported, "
+                        "please use 'create' to append to an existing object.");
+  }
+
+  if (multiplex > 0) {
+    return pymol::Error("loading mmCIF with multiplex=1 not supported, please "
+                        "use 'split_states' after loading the object.");
+  }
+
+  return {};
+}
+
+/**
+ * Read one or multiple object-molecules from a CIF file. If there is only one
+ * or multiplex=0, then return the object-molecule. Otherwise, create each
+ * object - named by its data block name - and return NULL.
+ */
+pymol::Result<ObjectMolecule*> ObjectMoleculeReadCifStr(PyMOLGlobals * G, ObjectMolecule * I,
+                                      const char *st, int frame,
+                                      int discrete, int quiet, int multiplex,
+                                      int zoom)
+{
+  p_return_if_error(ObjectMoleculeReadCifCheck(I, multiplex));
+
+  auto cif = std::make_shared<cif_file_with_error_capture>();
+  if (!cif->parse_string(st, G)) {
+    return pymol::make_error("Parsing CIF file failed: ", cif->m_error_msg);
+  }
+
+  return ObjectMoleculeReadCifFile(G, cif, discrete, quiet, multiplex, zoom);
+}
+
+/**
+ * Like ObjectMoleculeReadCifStr, but for a BinaryCIF buffer
+ */
+pymol::Result<ObjectMolecule*> ObjectMoleculeReadBCifStr(PyMOLGlobals * G, ObjectMolecule * I,
+                                      const char *st, int st_len, int frame,
+                                      int discrete, int quiet, int multiplex,
+                                      int zoom)
+{
+  p_return_if_error(ObjectMoleculeReadCifCheck(I, multiplex));
+
+  auto cif = std::make_shared<cif_file_with_error_capture>();
+  if (!cif->parse_bcif(st, st_len, G)) {
+    return pymol::make_error("Parsing BinaryCIF file failed: ", cif->m_error_msg);
+  }
+
+  return ObjectMoleculeReadCifFile(G, cif, discrete, quiet, multiplex, zoom);
+}
+
 /**
  * Bond dictionary getter, with on-demand download of residue dictionaries
  */
@@ -137,12 +137,12 @@ int CoordSet::atmToIdx(int atm) const {
 void CoordSet::updateNonDiscreteAtmToIdx(unsigned natom)
 {
   assert(!Obj || natom == Obj->NAtom);
-  AtmToIdx.resize(natom);
-  std::fill_n(AtmToIdx.data(), natom, -1);
+  AtmToIdx = std::vector<int>(natom, -1);
+  auto& atm_to_idx = AtmToIdx.mut();
   for (unsigned idx = 0, idx_end = getNIndex(); idx != idx_end; ++idx) {
     auto const atm = IdxToAtm[idx];
     assert(atm < natom);
-    AtmToIdx[atm] = idx;
+    atm_to_idx[atm] = idx;
   }
 }
 
@@ -238,7 +238,7 @@ int CoordSetFromPyList(PyMOLGlobals * G, PyObject * list, CoordSet ** cs)
     if(ok)
       ok = PConvPyListToFloatVLA(PyList_GetItem(list, 2), &I->Coord);
     if(ok){
-      PConvFromPyListItem(G, list, 3, I->IdxToAtm);
+      PConvFromPyListItem(G, list, 3, I->IdxToAtm.mut());
     }
     if(ok && (ll > 5))
       ok = CPythonVal_PConvPyStrToStr_From_List(G, list, 5, I->Name, sizeof(WordType));
@@ -415,6 +415,61 @@ PyObject *CoordSetAsPyList(CoordSet * I)
   return (PConvAutoNone(result));
 }
 
+/**
+ * Applies an atom index mapping to IdxToAtm of several coordinate sets.
+ * Index maps which are shared between coordinate sets are only remapped once
+ * and stay shared.
+ *
+ * @param csets Coordinate sets (may contain null)
+ * @param lookup atm_old to atm_new index mapping
+ */
+void CoordSetRemapIdxToAtm(CoordSet* const* csets, int n, const int* lookup)
+{
+  pymol::cow_vector<int> prev_old, prev_new;
+  int prev_nindex = -1;
+
+  for (int i = 0; i < n; ++i) {
+    auto cs = csets[i];
+    if (!cs)
+      continue;
+
+    if (cs->NIndex == prev_nindex && cs->IdxToAtm.shares(prev_old)) {
+      cs->IdxToAtm = prev_new;
+      continue;
+    }
+
+    prev_old = cs->IdxToAtm;
+    prev_nindex = cs->NIndex;
+
+    auto& idx_to_atm = cs->IdxToAtm.mut();
+    for (int idx = 0; idx < cs->NIndex; ++idx) {
+      idx_to_atm[idx] = lookup[idx_to_atm[idx]];
+    }
+
+    prev_new = cs->IdxToAtm;
+  }
+}
+
+/**
+ * Shares the index maps of `other` if they are equal to the ones of `I`
+ * (e.g. trajectory frames), to save memory.
+ *
+ * @pre `other` is up to date (AtmToIdx)
+ * @return true if `I` now shares the maps of `other` (and its AtmToIdx is
+ * up to date)
+ */
+bool CoordSetShareIndices(CoordSet* I, const CoordSet* other)
+{
+  if (I->Obj != other->Obj || I->Obj->DiscreteFlag ||
+      I->NIndex != other->NIndex || I->IdxToAtm != other->IdxToAtm) {
+    return false;
+  }
+
+  I->IdxToAtm = other->IdxToAtm;
+  I->AtmToIdx = other->AtmToIdx;
+  return true;
+}
+
 /**
  * Updates IdxToAtm and adjusts all NIndex sized arrays.
  *
@@ -427,13 +482,14 @@ void CoordSetAdjustAtmIdx(CoordSet* I, const int* lookup)
 {
   auto G = I->G;
   int offset = 0;
+  auto& idx_to_atm = I->IdxToAtm.mut();
 
   for (int idx = 0; idx < I->getNIndex(); ++idx) {
     auto const idx_new = idx + offset;
-    auto const atm_new = lookup[I->IdxToAtm[idx]];
+    auto const atm_new = lookup[idx_to_atm[idx]];
 
-    assert(I->IdxToAtm[idx] >= atm_new);
-    I->IdxToAtm[idx_new] = atm_new;
+    assert(idx_to_atm[idx] >= atm_new);
+    idx_to_atm[idx_new] = atm_new;
 
     if (atm_new == -1) {
       --offset;
@@ -489,12 +545,12 @@ int CoordSetMerge(ObjectMolecule *OM, CoordSet * I, const CoordSet * cs)
   for (int idx_src = 0; idx_src < cs->getNIndex(); ++idx_src) {
     int const idx = idx_src + nIndexOld;
     int const atm = cs->IdxToAtm[idx_src];
-    I->IdxToAtm[idx] = cs->IdxToAtm[idx_src];
+    I->IdxToAtm.mut()[idx] = atm;
     if (OM->DiscreteFlag) {
       OM->DiscreteAtmToIdx[atm] = idx;
       OM->DiscreteCSet[atm] = I;
     } else {
-      I->AtmToIdx[atm] = idx;
+      I->AtmToIdx.mut()[atm] = idx;
     }
     copy3f(cs->coordPtr(idx_src), I->coordPtr(idx));
   }
@@ -1237,45 +1293,87 @@ void CoordSet::invalidateRep(cRep_t type, cRepInv_t level)
 
 /*========================================================================*/
 
-#define RepUpdateMacro(rep, new_fn, state)                                     \
-  {                                                                            \
-    if (Active[rep] && !G->Interrupt) {                                        \
-      if (Rep[rep]) {                                                          \
-        assert(Rep[rep]->cs == this);                                          \
-        assert(Rep[rep]->getState() == state);                                 \
-        Rep[rep] = Rep[rep]->update();                                         \
-      } else {                                                                 \
-        Rep[rep] = new_fn(this, state);                                        \
-        if (Rep[rep]) {                                                        \
-          Rep[rep]->fNew = new_fn;                                             \
-          SceneInvalidatePicking(G);                                           \
-        } else {                                                               \
-          Active[rep] = false;                                                 \
-        }                                                                      \
-      }                                                                        \
-    }                                                                          \
-    OrthoBusyFast(G, rep, cRepCnt);                                            \
+const cRep_t CoordSetUpdateReps[CoordSetUpdateRepCnt] = {
+    cRepLine,
+    cRepCyl,
+    cRepDot,
+    cRepMesh,
+    cRepSphere,
+    cRepRibbon,
+    cRepCartoon,
+    cRepSurface,
+    cRepLabel,
+    cRepNonbonded,
+    cRepNonbondedSphere,
+    cRepEllipsoid,
+};
+
+using RepNewFn = Rep* (*)(CoordSet*, int);
+
+static RepNewFn CoordSetRepNewFn(cRep_t rep)
+{
+  switch (rep) {
+  case cRepLine: return RepWireBondNew;
+  case cRepCyl: return RepCylBondNew;
+  case cRepDot: return RepDotNew;
+  case cRepMesh: return RepMeshNew;
+  case cRepSphere: return RepSphereNew;
+  case cRepRibbon: return RepRibbonNew;
+  case cRepCartoon: return RepCartoonNew;
+  case cRepSurface: return RepSurfaceNew;
+  case cRepLabel: return RepLabelNew;
+  case cRepNonbonded: return RepNonbondedNew;
+  case cRepNonbondedSphere: return RepNonbondedSphereNew;
+  case cRepEllipsoid: return RepEllipsoidNew;
+  default: return nullptr;
+  }
+}
+
+/*========================================================================*/
+bool CoordSet::updateRep(cRep_t rep, int state)
+{
+  auto const new_fn = CoordSetRepNewFn(rep);
+  assert(new_fn);
+
+  if (!Active[rep] || G->Interrupt)
+    return false;
+
+  if (Rep[rep]) {
+    assert(Rep[rep]->cs == this);
+    assert(Rep[rep]->getState() == state);
+    Rep[rep] = Rep[rep]->update();
+    return false;
+  }
+
+  Rep[rep] = new_fn(this, state);
+  if (!Rep[rep]) {
+    Active[rep] = false;
+    return false;
   }
 
+  Rep[rep]->fNew = new_fn;
+  return true;
+}
+
 /*========================================================================*/
 void CoordSet::update(int state)
 {
   assert(G == Obj->G);
 
   OrthoBusyFast(G, 0, cRepCnt);
-  RepUpdateMacro(cRepLine, RepWireBondNew, state);
-  RepUpdateMacro(cRepCyl, RepCylBondNew, state);
-  RepUpdateMacro(cRepDot, RepDotNew, state);
-  RepUpdateMacro(cRepMesh, RepMeshNew, state);
-  RepUpdateMacro(cRepSphere, RepSphereNew, state);
-  RepUpdateMacro(cRepRibbon, RepRibbonNew, state);
-  RepUpdateMacro(cRepCartoon, RepCartoonNew, state);
-  RepUpdateMacro(cRepSurface, RepSurfaceNew, state);
-  RepUpdateMacro(cRepLabel, RepLabelNew, state);
-  RepUpdateMacro(cRepNonbonded, RepNonbondedNew, state);
-  RepUpdateMacro(cRepNonbondedSphere, RepNonbondedSphereNew, state);
-  RepUpdateMacro(cRepEllipsoid, RepEllipsoidNew, state);
+  for (auto rep : CoordSetUpdateReps) {
+    if (updateRep(rep, state))
+      SceneInvalidatePicking(G);
+    OrthoBusyFast(G, rep, cRepCnt);
+  }
+
+  updateFinish();
+  OrthoBusyFast(G, 1, 1);
+}
 
+/*========================================================================*/
+void CoordSet::updateFinish()
+{
   for (int a = 0; a < cRepCnt; ++a) {
     if (!Rep[a])
       Active[a] = false;
@@ -1299,7 +1397,6 @@ void CoordSet::update(int state)
   }
 
   SceneInvalidate(G);
-  OrthoBusyFast(G, 1, 1);
 }
 
 
@@ -1590,11 +1687,7 @@ int CoordSet::extendIndices(int nAtom)
     const auto NAtIndex = AtmToIdx.size();
     assert(NAtIndex <= nAtom);
     if (NAtIndex < nAtom) {
-      AtmToIdx.resize(nAtom);
-      if (ok && nAtom) {
-        for (int a = NAtIndex; a < nAtom; a++)
-          AtmToIdx[a] = -1;
-      }
+      AtmToIdx.resize(nAtom, -1);
     }
   }
   return ok;
@@ -1606,14 +1699,12 @@ int CoordSet::extendIndices(int nAtom)
  */
 void CoordSet::enumIndices()
 {
-  AtmToIdx.resize(NIndex);
-  IdxToAtm.resize(NIndex);
-  if (NIndex) {
-    for (int a = 0; a < NIndex; ++a) {
-      AtmToIdx[a] = a;
-      IdxToAtm[a] = a;
-    }
+  std::vector<int> identity(NIndex);
+  for (int a = 0; a < NIndex; ++a) {
+    identity[a] = a;
   }
+  AtmToIdx = identity;
+  IdxToAtm = std::move(identity);
 }
 
 /*========================================================================*/
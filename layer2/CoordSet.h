@@ -26,6 +26,7 @@ Z* -------------------------------------------------------------------
 #include"vla.h"
 
 #include "pymol/math_defines.h"
+#include "pymol/cow_vector.h"
 #include "pymol/memory.h"
 #include "pymol/zstring_view.h"
 
@@ -48,6 +49,19 @@ struct CoordSet : CObjectState {
 
   // methods
   void update(int state);
+
+  /**
+   * Builds or updates one representation, the building block of update().
+   * Does not report progress, so it may run on a task pool thread (see
+   * ObjectMolecule::addUpdateTasks).
+   * @param rep One of CoordSetUpdateReps
+   * @return true if a new representation was created (picking is invalid)
+   */
+  bool updateRep(cRep_t rep, int state);
+
+  /// Unit cell and cleanup after the updateRep() calls of an update
+  void updateFinish();
+
   void render(RenderInfo * info);
   void enumIndices();
   int extendIndices(int nAtom);
@@ -101,8 +115,10 @@ struct CoordSet : CObjectState {
 
   ObjectMolecule *Obj = nullptr;
   pymol::vla<float> Coord;
-  std::vector<int> IdxToAtm;
-  std::vector<int> AtmToIdx;
+  /* coordinate index <-> atom index maps, shared between the states
+     of a trajectory until one of them changes */
+  pymol::cow_vector<int> IdxToAtm;
+  pymol::cow_vector<int> AtmToIdx;
   int NIndex = 0;
   ::Rep *Rep[cRepCnt] = {0};            /* an array of pointers to representations */
   int Active[cRepCnt] = {0};          /* active flags */
@@ -216,6 +232,8 @@ int CoordSetTransformAtomR44f(CoordSet * I, int at, const float *matrix);
 int CoordSetValidateRefPos(CoordSet * I);
 
 void CoordSetAdjustAtmIdx(CoordSet*, const int*);
+void CoordSetRemapIdxToAtm(CoordSet* const* csets, int n, const int* lookup);
+bool CoordSetShareIndices(CoordSet* I, const CoordSet* other);
 int CoordSetMerge(ObjectMolecule *OM, CoordSet * I, const CoordSet * cs);        /* must be non-overlapping */
 void CoordSetRecordTxfApplied(CoordSet * I, const float *TTT, int homogenous);
 void CoordSetUpdateCoord2IdxMap(CoordSet * I, float cutoff);
@@ -223,9 +241,9 @@ void CoordSetUpdateCoord2IdxMap(CoordSet * I, float cutoff);
 bool CoordSetFindOpenValenceVector(const CoordSet*, int atm, float* out,
     const float* seek = nullptr, int ignore_atm = -1);
 
-typedef struct _CCoordSetUpdateThreadInfo CCoordSetUpdateThreadInfo;
-
-void CoordSetUpdateThread(CCoordSetUpdateThreadInfo * T);
+/// Representations built by CoordSet::update(), in build order
+constexpr int CoordSetUpdateRepCnt = 12;
+extern const cRep_t CoordSetUpdateReps[CoordSetUpdateRepCnt];
 
 void LabPosTypeCopy(const LabPosType * src, LabPosType * dst);
 void RefPosTypeCopy(const RefPosType * src, RefPosType * dst);
@@ -28,13 +28,13 @@ void AppendAtomVertex(CoordSet* cs, unsigned atm, const float* v)
   int const idx = cs->NIndex;
   cs->setNIndex(idx + 1);
 
-  cs->IdxToAtm[idx] = atm;
+  cs->IdxToAtm.mut()[idx] = atm;
 
   if (cs->Obj->DiscreteFlag) {
     cs->Obj->DiscreteAtmToIdx[atm] = idx;
     cs->Obj->DiscreteCSet[atm] = cs;
   } else {
-    cs->AtmToIdx[atm] = idx;
+    cs->AtmToIdx.mut()[atm] = idx;
   }
 
   copy3f(v, cs->coordPtr(idx));
@@ -345,7 +345,7 @@ int ObjectMoleculeAddSeleHydrogensRefactored(ObjectMolecule* I, int sele, int st
 
   // fill coordinates
   for (StateIterator iter(I, state); iter.next();) {
-    CoordSet* cs = I->CSet[iter.state];
+    CoordSet* cs = I->pinCoordSet(iter.state);
     if (!cs)
       continue;
 
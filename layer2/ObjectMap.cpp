@@ -17,6 +17,9 @@ Z* -------------------------------------------------------------------
 
 #include <stdint.h>
 #include <algorithm>
+#include <atomic>
+#include <climits>
+#include <limits>
 
 #include"os_python.h"
 #include"os_numpy.h"
@@ -43,6 +46,8 @@ Z* -------------------------------------------------------------------
 #include"ShaderMgr.h"
 #include"CGO.h"
 #include"File.h"
+#include"FileStream.h"
+#include"TaskPool.h"
 #include"Executive.h"
 #include"Field.h"
 #include "Feedback.h"
@@ -181,6 +186,7 @@ int ObjectMapStateGetExcludedStats(PyMOLGlobals * G, ObjectMapState * ms, float
     int beyond_flag;
 
     const Isofield *field = ms->Field.get();
+    IsofieldDecode(G, field);
     if(list_size)
       MapSetupExpress(voxelmap);
 
@@ -252,6 +258,7 @@ int ObjectMapStateGetDataRange(PyMOLGlobals * G, ObjectMapState * ms, float *min
                                float *max)
 {
 float max_val = 0.0F, min_val = 0.0F;
+  IsofieldDecode(G, ms->Field.get());
   CField *data = ms->Field->data.get();
   int cnt = data->dim[0] * data->dim[1] * data->dim[2];
   float *raw_data = (float *) data->data.data();
@@ -295,6 +302,7 @@ int ObjectMapStateGetHistogram(PyMOLGlobals * G, ObjectMapState * ms,
   float sum = 0.0f, sumsq = 0.0f;
   float min_his, max_his, irange, mean, stdev;
   int pos;
+  IsofieldDecode(G, ms->Field.get());
   CField *data = ms->Field->data.get();
   int cnt = data->dim[0] * data->dim[1] * data->dim[2];
   float *raw_data = (float *) data->data.data();
@@ -416,6 +424,8 @@ static void ObjectMapStateTrim(PyMOLGlobals * G, ObjectMapState * ms,
   float orig_size = 1.0F;
   float new_size = 1.0F;
 
+  IsofieldDecode(G, ms->Field.get());
+
   if(ObjectMapStateValidXtal(ms)) {
     float tst[3], frac_tst[3];
     float frac_mn[3];
@@ -653,6 +663,8 @@ static void ObjectMapStateDouble(PyMOLGlobals * G, ObjectMapState * ms)
 
   Isofield *field;
 
+  IsofieldDecode(G, ms->Field.get());
+
   if(ObjectMapStateValidXtal(ms)) {
     for(a = 0; a < 3; a++) {
       div[a] = ms->Div[a] * 2;
@@ -751,6 +763,8 @@ static void ObjectMapStateHalve(PyMOLGlobals * G, ObjectMapState * ms, int smoot
 
   Isofield *field;
 
+  IsofieldDecode(G, ms->Field.get());
+
   if(ObjectMapStateValidXtal(ms)) {
     int *old_div, *old_min, *old_max;
     int a_2, b_2, c_2;
@@ -1012,6 +1026,41 @@ int ObjectMapStateContainsPoint(ObjectMapState * ms, float *point)
  * indicating if points were within map bounds (optional, can be NULL)
  * @return False if any coordinate was out of bounds
  */
+/**
+ * Decode the grid points around the `n` points of `array` of a lazily
+ * decoded map (see ObjectMapStateInterpolate).
+ */
+static void ObjectMapStateDecodeAround(ObjectMapState * ms, const float *array, int n)
+{
+  const Isofield *field = ms->Field.get();
+  if(!field->source || n < 1)
+    return;
+
+  const bool xtal = ObjectMapStateValidXtal(ms);
+  int range[6] = {INT_MAX, INT_MAX, INT_MAX, INT_MIN, INT_MIN, INT_MIN};
+  float frac[3], grid[3];
+
+  for(; n--; array += 3) {
+    if(xtal) {
+      transform33f3f(ms->Symmetry->Crystal.realToFrac(), array, frac);
+      for(int d = 0; d < 3; d++)
+        grid[d] = ms->Div[d] * frac[d];
+    } else {
+      for(int d = 0; d < 3; d++)
+        grid[d] = (array[d] - ms->Origin[d]) / ms->Grid[d];
+    }
+    for(int d = 0; d < 3; d++) {
+      // points outside of the map are clamped to its border
+      int i = (int) floor(grid[d] + R_SMALL8) - ms->Min[d];
+      i = pymol::clamp(i, 0, field->dimensions[d] - 1);
+      range[d] = std::min(range[d], i);
+      range[d + 3] = std::max(range[d + 3], i + 2);
+    }
+  }
+
+  IsofieldDecode(ms->G, field, range);
+}
+
 int ObjectMapStateInterpolate(ObjectMapState * ms, const float *array, float *result, int *flag,
                               int n)
 {
@@ -1021,6 +1070,8 @@ int ObjectMapStateInterpolate(ObjectMapState * ms, const float *array, float *re
   float x, y, z;
   inp = array;
 
+  ObjectMapStateDecodeAround(ms, array, n);
+
   if(ObjectMapStateValidXtal(ms)) {
     float frac[3];
 
@@ -1197,6 +1248,9 @@ void ObjectMapStateRegeneratePoints(ObjectMapState * ms)
   int a, b, c, e;
   float v[3], vr[3];
 
+  // decoding later would overwrite the new points
+  IsofieldDecode(ms->G, ms->Field.get());
+
   if(ObjectMapStateValidXtal(ms)) {
     for(c = 0; c < ms->FDim[2]; c++) {
       v[2] = (c + ms->Min[2]) / ((float) ms->Div[2]);
@@ -1600,6 +1654,9 @@ void ObjectMapStateClamp(ObjectMapState * I, float clamp_floor, float clamp_ceil
   int a, b, c;
   float *fp;
 
+  IsofieldDecode(I->G, I->Field.get());
+  I->Field->bricks = nullptr;
+
   for(a = 0; a < I->FDim[0]; a++)
     for(b = 0; b < I->FDim[1]; b++)
       for(c = 0; c < I->FDim[2]; c++) {
@@ -1616,6 +1673,9 @@ int ObjectMapStateSetBorder(ObjectMapState * I, float level)
   int result = true;
   int a, b, c;
 
+  IsofieldDecode(I->G, I->Field.get());
+  I->Field->bricks = nullptr;
+
   c = I->FDim[2] - 1;
   for(a = 0; a < I->FDim[0]; a++)
     for(b = 0; b < I->FDim[1]; b++) {
@@ -1662,6 +1722,14 @@ void ObjectMap::update()
     if(I->ExtentFlag)
       SceneInvalidate(I->G);
   }
+
+  /* min/max index for contouring, so changing the level doesn't need to
+     scan the whole map */
+  for(auto& ms : I->State) {
+    if(ms.Active && ms.Field && !ms.Field->bricks) {
+      IsofieldComputeBricks(I->G, ms.Field.get());
+    }
+  }
 }
 
 void ObjectMap::invalidate(cRep_t rep, cRepInv_t level, int state)
@@ -1848,6 +1916,7 @@ void ObjectMap::render(RenderInfo * info)
       }
 
       if((I->visRep & cRepDotBit)) {
+        IsofieldDecode(G, ms->Field.get());
         if(!ms->have_range) {
           double sum = 0.0, sumsq = 0.0;
           CField *data = ms->Field->data.get();
@@ -2212,18 +2281,32 @@ ObjectMapState *ObjectMapNewStateFromDesc(PyMOLGlobals * G, ObjectMap * I,
 
 
 /*========================================================================*/
-static float ccp4_next_value(char ** pp, int mode) {
-  char * p = *pp;
+/**
+ * Decodes the voxel value at `p` without modifying the (possibly memory
+ * mapped) input, swapping bytes on the fly for reverse endian maps.
+ */
+static float ccp4_value(const char * p, int mode, bool swap) {
+  char buf[4];
+  int width = (mode == 0) ? 1 : (mode == 1) ? 2 : 4;
+  if(swap) {
+    for(int k = 0; k < width; k++)
+      buf[k] = p[width - 1 - k];
+  } else {
+    memcpy(buf, p, width);
+  }
   switch(mode) {
     case 0:
-      *pp += 1;
-      return (float) *((int8_t *) p);
-    case 1:
-      *pp += 2;
-      return (float) *((int16_t *) p);
-    case 2:
-      *pp += 4;
-      return *((float *) p);
+      return (float) *((int8_t *) buf);
+    case 1: {
+      int16_t value;
+      memcpy(&value, buf, sizeof(value));
+      return (float) value;
+    }
+    case 2: {
+      float value;
+      memcpy(&value, buf, sizeof(value));
+      return value;
+    }
   }
   printf("ERROR unsupported mode\n");
   return 0.f;
@@ -2260,16 +2343,100 @@ static bool validateCCP4LoadType(int& format)
   }
 }
 
-static int ObjectMapCCP4StrToMap(ObjectMap * I, char *CCP4Str, int bytes, int state,
-                                 int quiet, int format)
+/**
+ * Voxels of a CCP4/MRC map, decoded into the field on demand (see
+ * IsofieldDecode). Keeps the memory mapped file alive, and copies the rows
+ * of each block from it with MappedFile::read, so a truncated file gives
+ * NaN voxels instead of SIGBUS.
+ */
+struct CCP4MapSource : IsofieldSource {
+  std::shared_ptr<const pymol::MappedFile> file;
+  const char *voxels = nullptr; //!< without `file`, only valid while loading
+  size_t voxels_offset = 0;     //!< with `file`
+  int mode = 2;
+  size_t bytes_per_pt = 4;
+  bool swap = false;
+  int axis[3]{}; //!< field axis of the columns, rows and sections
+  int n_cols = 0, n_rows = 0;
+  bool normalize = false;
+  float mean = 0.f, stdev = 1.f;
+  int min[3]{}, div[3]{};
+  float fracToReal[9]{};
+
+  bool valid() const override { return !file || file->unchanged(); }
+
+  /**
+   * Voxels of the rows [row_begin, row_end) of section `s`
+   * @param buf Storage for rows copied from `file`
+   * @return nullptr if the file is too short (truncated)
+   */
+  const char* rows(size_t s, int row_begin, int row_end, std::vector<char>& buf) const
+  {
+    size_t begin = (s * n_rows + row_begin) * n_cols * bytes_per_pt;
+    size_t size = size_t(row_end - row_begin) * n_cols * bytes_per_pt;
+    if(!file)
+      return voxels + begin;
+    buf.resize(size);
+    return file->read(voxels_offset + begin, size, buf.data()) ? buf.data() : nullptr;
+  }
+
+  void decode(const Isofield* field, const int* box_min, const int* box_max) const override
+  {
+    const int mapc = axis[0], mapr = axis[1], maps = axis[2];
+    int cc[3];
+    float v[3], vr[3];
+    std::vector<char> buf;
+
+    // a modified file gives NaN rather than a mix of old and new voxels
+    const bool ok = valid();
+
+    for(cc[maps] = box_min[maps]; cc[maps] < box_max[maps]; cc[maps]++) {
+      v[maps] = (cc[maps] + min[maps]) / ((float) div[maps]);
+
+      const char *section =
+          ok ? rows(cc[maps], box_min[mapr], box_max[mapr], buf) : nullptr;
+
+      for(cc[mapr] = box_min[mapr]; cc[mapr] < box_max[mapr]; cc[mapr]++) {
+        v[mapr] = (cc[mapr] + min[mapr]) / ((float) div[mapr]);
+
+        const char *qs = section +
+          (size_t(cc[mapr] - box_min[mapr]) * n_cols + box_min[mapc]) * bytes_per_pt;
+
+        for(cc[mapc] = box_min[mapc]; cc[mapc] < box_max[mapc]; cc[mapc]++) {
+          v[mapc] = (cc[mapc] + min[mapc]) / ((float) div[mapc]);
+
+          float dens = section ? ccp4_value(qs, mode, swap)
+                               : std::numeric_limits<float>::quiet_NaN();
+          qs += bytes_per_pt;
+
+          if(normalize)
+            dens = (dens - mean) / stdev;
+          F3(field->data, cc[0], cc[1], cc[2]) = dens;
+          transform33f3f(fracToReal, v, vr);
+          for(int e = 0; e < 3; e++)
+            F4(field->points, cc[0], cc[1], cc[2], e) = vr[e];
+        }
+      }
+    }
+  }
+};
+
+/**
+ * @param file If not null, `CCP4Str` is the data of this file, which the map
+ * state keeps open to decode the voxels on demand. Otherwise they are
+ * decoded right away.
+ */
+static int ObjectMapCCP4StrToMap(ObjectMap * I, const char *CCP4Str, size_t bytes, int state,
+                                 int quiet, int format,
+                                 std::shared_ptr<const pymol::MappedFile> file = nullptr)
 {
   auto G = I->G;
-  char *p;
+  const char *p;
+  int header[256];
   int *i;
   size_t bytes_per_pt;
-  char *q;
-  float dens;
-  int a, b, c, d, e;
+  const char *q;
+  int a, b, c, d;
   float v[3], vr[3], maxd, mind;
   int ok = true;
   int little_endian = 1, map_endian;
@@ -2282,13 +2449,12 @@ static int ObjectMapCCP4StrToMap(ObjectMap * I, char *CCP4Str, int bytes, int st
   int ispg; // space group number
   int sym_skip;
   int mapc, mapr, maps;
-  int cc[3];
-  int n_pts;
+  size_t n_pts;
   double sum, sumsq;
   float mean, stdev;
   int normalize;
   ObjectMapState *ms;
-  int expectation;
+  size_t expectation;
 
   if (!validateCCP4LoadType(format)) {
     ErrMessage(G, __func__, "wrong format");
@@ -2316,15 +2482,18 @@ static int ObjectMapCCP4StrToMap(ObjectMap * I, char *CCP4Str, int bytes, int st
   little_endian = *((char *) &little_endian);
   map_endian = (*p || *(p + 1)); // NOTE: this assumes 0x0 < NC < 0x10000
 
+  // work on a copy, the input may be a read-only file mapping
+  memcpy(header, p, sizeof(header));
+
   if(little_endian != map_endian) {
     if(!quiet) {
       PRINTFB(I->G, FB_ObjectMap, FB_Blather)
         " ObjectMapCCP4: Map appears to be reverse endian, swapping...\n" ENDFB(I->G);
     }
-    swap_endian(p, 256, sizeof(int));
+    swap_endian((char *) header, 256, sizeof(int));
   }
 
-  i = (int *) p;
+  i = header;
   nc = *(i++);                  /* columns */
   nr = *(i++);                  /* rows */
   ns = *(i++);                  /* sections */
@@ -2480,7 +2649,7 @@ static int ObjectMapCCP4StrToMap(ObjectMap * I, char *CCP4Str, int bytes, int st
       " ObjectMapCCP4: AMIN %f AMAX %f AMEAN %f ARMS %f\n", mind, maxd, mean, stdev ENDFB(I->G);
   }
 
-  n_pts = nc * ns * nr;
+  n_pts = size_t(nc) * ns * nr;
 
   /* at least one EM map encountered lacks NZ, so we'll try to guess it */
 
@@ -2498,7 +2667,7 @@ static int ObjectMapCCP4StrToMap(ObjectMap * I, char *CCP4Str, int bytes, int st
 
   if(!quiet) {
     PRINTFB(I->G, FB_ObjectMap, FB_Blather)
-      " ObjectMapCCP4: sym_skip %d bytes %d expectation %d\n",
+      " ObjectMapCCP4: sym_skip %d bytes %zu expectation %zu\n",
       sym_skip, bytes, expectation ENDFB(I->G);
   }
 
@@ -2521,29 +2690,83 @@ static int ObjectMapCCP4StrToMap(ObjectMap * I, char *CCP4Str, int bytes, int st
     }
   }
 
+  if(mapc < 1 || mapc > 3 || mapr < 1 || mapr > 3 || maps < 1 || maps > 3 ||
+     mapc == mapr || mapc == maps || mapr == maps) {
+    PRINTFB(I->G, FB_ObjectMap, FB_Errors)
+      " ObjectMapCCP4: Invalid axis order -- aborting.\n" ENDFB(I->G);
+    return (0);
+  }
+
   q = p + (sizeof(int) * 256) + sym_skip;
 
-  if(little_endian != map_endian && bytes_per_pt > 1) {
-    swap_endian(q, n_pts, bytes_per_pt);
-  }
+  // sections are contiguous in the file and independent of each other
+  const bool swap = little_endian != map_endian && bytes_per_pt > 1;
+  const size_t section_pts = size_t(nc) * nr;
+
+  auto source = std::make_shared<CCP4MapSource>();
+  source->file = std::move(file);
+  if(source->file)
+    source->voxels_offset = q - CCP4Str;
+  else
+    source->voxels = q;
+  source->mode = map_mode;
+  source->bytes_per_pt = bytes_per_pt;
+  source->swap = swap;
+  source->n_cols = nc;
+  source->n_rows = nr;
 
   // with normalize == 2, use mean and stdev from file header
+  bool have_range = false;
   if(normalize == 1 && n_pts > 1) {
-    c = n_pts;
+    std::vector<double> section_sum(ns), section_sumsq(ns);
+    std::vector<float> section_min(ns), section_max(ns);
+    std::atomic<bool> truncated(false);
+    pymol::parallel_for(G, ns, 1,
+        [&](size_t begin, size_t end, unsigned) {
+          std::vector<char> buf;
+          for(size_t s = begin; s != end; ++s) {
+            const char *qs = source->rows(s, 0, nr, buf);
+            if(!qs) {
+              truncated = true;
+              break;
+            }
+            double ssum = 0.0, ssumsq = 0.0;
+            float smax = -FLT_MAX, smin = FLT_MAX;
+            for(size_t k = 0; k != section_pts; ++k, qs += bytes_per_pt) {
+              float dens = ccp4_value(qs, map_mode, swap);
+              ssumsq += dens * dens;
+              ssum += dens;
+              if(smax < dens)
+                smax = dens;
+              if(smin > dens)
+                smin = dens;
+            }
+            section_sum[s] = ssum;
+            section_sumsq[s] = ssumsq;
+            section_min[s] = smin;
+            section_max[s] = smax;
+          }
+        });
+    if(truncated) {
+      PRINTFB(I->G, FB_ObjectMap, FB_Errors)
+        " ObjectMapCCP4: Map appears to be truncated -- aborting.\n" ENDFB(I->G);
+      return (0);
+    }
     sum = 0.0;
     sumsq = 0.0;
-    while(c--) {
-      dens = ccp4_next_value(&q, map_mode);
-      sumsq += dens * dens;
-      sum += dens;
+    for(c = 0; c < ns; c++) {
+      sum += section_sum[c];
+      sumsq += section_sumsq[c];
     }
     mean = (float) (sum / n_pts);
     stdev = (float) sqrt1d((sumsq - (sum * sum / n_pts)) / (n_pts - 1));
     if(stdev < 0.000001)
       stdev = 1.0;
+    mind = *std::min_element(section_min.begin(), section_min.end());
+    maxd = *std::max_element(section_max.begin(), section_max.end());
+    have_range = true;
   }
 
-  q = p + (sizeof(int) * 256) + sym_skip;
   mapc--;                       /* convert to C indexing... */
   mapr--;
   maps--;
@@ -2591,36 +2814,40 @@ static int ObjectMapCCP4StrToMap(ObjectMap * I, char *CCP4Str, int bytes, int st
   if(!(ms->FDim[0] && ms->FDim[1] && ms->FDim[2]))
     ok = false;
   else {
-    ms->Field.reset(new Isofield(I->G, ms->FDim));
+    source->axis[0] = mapc;
+    source->axis[1] = mapr;
+    source->axis[2] = maps;
+    source->normalize = normalize;
+    source->mean = mean;
+    source->stdev = stdev;
+    copy3(ms->Min, source->min);
+    copy3(ms->Div, source->div);
+    std::copy_n(ms->Symmetry->Crystal.fracToReal(), 9, source->fracToReal);
+
+    const bool lazy = source->file != nullptr;
+    ms->Field.reset(new Isofield(I->G, ms->FDim, std::move(source)));
     ms->MapSource = cMapSourceCCP4;
     ms->Field->save_points = false;
 
-    maxd = -FLT_MAX;
-    mind = FLT_MAX;
-
-    for(cc[maps] = 0; cc[maps] < ms->FDim[maps]; cc[maps]++) {
-      v[maps] = (cc[maps] + ms->Min[maps]) / ((float) ms->Div[maps]);
-
-      for(cc[mapr] = 0; cc[mapr] < ms->FDim[mapr]; cc[mapr]++) {
-        v[mapr] = (cc[mapr] + ms->Min[mapr]) / ((float) ms->Div[mapr]);
-
-        for(cc[mapc] = 0; cc[mapc] < ms->FDim[mapc]; cc[mapc]++) {
-          v[mapc] = (cc[mapc] + ms->Min[mapc]) / ((float) ms->Div[mapc]);
+    auto field = ms->Field.get();
 
-          dens = ccp4_next_value(&q, map_mode);
+    if(!lazy) {
+      // the input buffer is only valid during this call
+      IsofieldDecode(G, field);
+      field->source = nullptr;
+      field->blocks = nullptr;
+    }
 
-          if(normalize)
-            dens = (dens - mean) / stdev;
-          F3(ms->Field->data, cc[0], cc[1], cc[2]) = dens;
-          if(maxd < dens)
-            maxd = dens;
-          if(mind > dens)
-            mind = dens;
-          transform33f3f(ms->Symmetry->Crystal.fracToReal(), v, vr);
-          for(e = 0; e < 3; e++)
-            F4(ms->Field->points, cc[0], cc[1], cc[2], e) = vr[e];
-        }
-      }
+    if(!lazy && !have_range) {
+      const float *first = field->data->ptr<float>(0, 0, 0);
+      const auto minmax = std::minmax_element(first, first + n_pts);
+      mind = *minmax.first;
+      maxd = *minmax.second;
+    } else if(normalize) {
+      // raw range, from the header (AMIN, AMAX) unless computed above, so a
+      // lazily decoded map isn't read just to report its range
+      mind = (mind - mean) / stdev;
+      maxd = (maxd - mean) / stdev;
     }
   }
   if(ok) {
@@ -2726,6 +2953,7 @@ std::vector<char> ObjectMapStateToCCP4Str(const ObjectMapState * ms, int quiet,
     return buffer; // empty
 
   auto G = ms->G;
+  IsofieldDecode(G, ms->Field.get());
   auto field = ms->Field->data;
 
   if (field->type != cFieldFloat ||
@@ -4634,9 +4862,10 @@ static ObjectMap *ObjectMapReadXPLORStr(PyMOLGlobals * G, ObjectMap * I, char *X
 
 
 /*========================================================================*/
-static ObjectMap *ObjectMapReadCCP4Str(PyMOLGlobals * G, ObjectMap * I, char *XPLORStr,
-                                       int bytes, int state, int quiet,
-                                       int format)
+static ObjectMap *ObjectMapReadCCP4Str(PyMOLGlobals * G, ObjectMap * I, const char *XPLORStr,
+                                       size_t bytes, int state, int quiet,
+                                       int format,
+                                       std::shared_ptr<const pymol::MappedFile> file = nullptr)
 {
   int ok = true;
   int isNew = true;
@@ -4652,7 +4881,7 @@ static ObjectMap *ObjectMapReadCCP4Str(PyMOLGlobals * G, ObjectMap * I, char *XP
     } else {
       isNew = false;
     }
-    ObjectMapCCP4StrToMap(I, XPLORStr, bytes, state, quiet, format);
+    ObjectMapCCP4StrToMap(I, XPLORStr, bytes, state, quiet, format, std::move(file));
     SceneChanged(G);
     SceneCountFrames(G);
   }
@@ -4666,28 +4895,36 @@ ObjectMap *ObjectMapLoadCCP4(PyMOLGlobals * G, ObjectMap * obj, const char *fnam
                              int format)
 {
   ObjectMap *I = NULL;
-  char *buffer;
-  long size;
+  const char *buffer;
+  size_t size;
+  std::shared_ptr<const pymol::MappedFile> mapped;
 
   if(!is_string) {
     if (!quiet)
       PRINTFB(G, FB_ObjectMap, FB_Actions)
         " ObjectMapLoadCCP4File: Loading from '%s'.\n", fname ENDFB(G);
 
-    buffer = FileGetContents(fname, &size);
+    // map the file instead of reading it, the map state keeps it open and
+    // decodes the voxels into the field when they are needed
+    mapped = std::make_shared<pymol::MappedFile>(fname);
+    buffer = mapped->data();
+    size = mapped->size();
 
     if(!buffer)
       ErrMessage(G, "ObjectMapLoadCCP4File", "Unable to open file!");
   } else {
-    buffer = (char*) fname;
-    size = (long) bytes;
+    buffer = fname;
+    size = (size_t) bytes;
   }
 
   if (buffer) {
-    I = ObjectMapReadCCP4Str(G, obj, buffer, size, state, quiet, format);
+    // a file which was read into memory is decoded right away
+    std::shared_ptr<const pymol::MappedFile> lazy_file;
+    if (mapped && mapped->mapped())
+      lazy_file = mapped;
 
-    if(!is_string)
-      mfree(buffer);
+    I = ObjectMapReadCCP4Str(G, obj, buffer, size, state, quiet, format,
+        std::move(lazy_file));
 
     if(!quiet) {
       if(state < 0)
@@ -5949,6 +6186,7 @@ void ObjectMapDump(const ObjectMap* om, const char* fname, int state, int quiet)
   }
 
   auto* field = oms->Field.get();
+  IsofieldDecode(om->G, field);
 
   for (int xi = 0; xi < field->dimensions[0]; xi++) {
     for (int yi = 0; yi < field->dimensions[1]; yi++) {
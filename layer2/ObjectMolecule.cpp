@@ -46,6 +46,8 @@ Z* -------------------------------------------------------------------
 #include "Lex.h"
 #include "MolV3000.h"
 #include "HydrogenAdder.h"
+#include "AlterExpr.h"
+#include "TaskPool.h"
 #include "Feedback.h"
 
 #ifdef _WEBGL
@@ -59,8 +61,10 @@ Z* -------------------------------------------------------------------
 #define nskip ParseNSkip
 
 #include <algorithm>
+#include <atomic>
 #include <array>
 #include <cassert>
+#include <memory>
 #include <set>
 #include <unordered_map>
 #include <vector>
@@ -190,16 +194,7 @@ bool ObjectMoleculeSetNotDiscrete(PyMOLGlobals * G, ObjectMolecule * I) {
   }
 
   // point coordsets to merged atoms
-  for (int state = 0; state < I->NCSet; ++state) {
-    auto cs = I->CSet[state];
-    if (!cs)
-      continue;
-
-    for (int idx = 0; idx < cs->NIndex; ++idx) {
-      int atm = cs->IdxToAtm[idx];
-      cs->IdxToAtm[idx] = outdex[atm];
-    }
-  }
+  CoordSetRemapIdxToAtm(I->CSet.data(), I->NCSet, outdex);
 
   // point bonds to merged atoms
   for (int i = 0; i < I->NBond; ++i) {
@@ -218,6 +213,18 @@ bool ObjectMoleculeSetNotDiscrete(PyMOLGlobals * G, ObjectMolecule * I) {
   return true;
 }
 
+/**
+ * Decodes all streamed trajectory states and stops streaming, for
+ * operations which rewrite the set of coordinate sets.
+ */
+static void ObjectMoleculeStopStreaming(ObjectMolecule* I)
+{
+  if (I->TrajStream) {
+    I->TrajStream->fetchAll(I, true);
+    I->TrajStream.reset();
+  }
+}
+
 /**
  * Make a non-discrete object discrete, or vice versa.
  */
@@ -240,6 +247,8 @@ int ObjectMoleculeSetDiscrete(PyMOLGlobals * G, ObjectMolecule * I, int discrete
   if (I->DiscreteFlag)
     return true;
 
+  ObjectMoleculeStopStreaming(I);
+
   // upper bound for number of discrete atoms
   maxnatom = I->NAtom * I->NCSet;
 
@@ -263,9 +272,11 @@ int ObjectMoleculeSetDiscrete(PyMOLGlobals * G, ObjectMolecule * I, int discrete
     for (ao = 0; ao < I->NAtom; ao++)
       aostate2an[ao] = -1;
 
+    auto& idx_to_atm = cs->IdxToAtm.mut();
+
     // for all atoms in coordinate set
     for (idx = 0; idx < cs->NIndex; idx++) {
-      ao = an = cs->IdxToAtm[idx];
+      ao = an = idx_to_atm[idx];
 
       if (I->DiscreteCSet[ao]) {
         // seen before, have to copy
@@ -277,7 +288,7 @@ int ObjectMoleculeSetDiscrete(PyMOLGlobals * G, ObjectMolecule * I, int discrete
         AtomInfoCopy(G,
             I->AtomInfo + ao,
             I->AtomInfo + an);
-        cs->IdxToAtm[idx] = an;
+        idx_to_atm[idx] = an;
       }
 
       I->AtomInfo[an].discrete_state = state + 1; // 1-based :-(
@@ -355,7 +366,7 @@ int ObjectMoleculeCheckFullStateSelection(ObjectMolecule * I, int sele, int stat
   int result = false;
   if((state >= 0) && (state < I->NCSet)) {
     const AtomInfoType *ai = I->AtomInfo.data();
-    CoordSet *cs = I->CSet[state];
+    CoordSet *cs = I->getCoordSet(state);
     if(cs) {
       int a;
       int at;
@@ -432,7 +443,7 @@ char *ObjectMolecule::getCaption(char * ch, int len) const
   /* if the state is valid, setup the label */
   if(state >= 0) {
     if (state < I->NCSet) {
-      const CoordSet *cs = I->CSet[state];
+      const CoordSet *cs = I->getCoordSet(state);
       if(cs) {
 	if(show_state) {
 	  if (show_as_fraction) {
@@ -762,16 +773,16 @@ void ObjectMoleculeTransformState44f(ObjectMolecule * I, int state, const float
 
     if(state < 0) {             /* all states */
       for(a = 0; a < I->NCSet; a++) {
-        cs = I->CSet[a];
+        cs = I->pinCoordSet(a);
         if(cs)
           ObjectStateLeftCombineMatrixR44d(cs, dbl_matrix);
       }
     } else if(state < I->NCSet) {       /* single state */
-      cs = I->CSet[state];
+      cs = I->pinCoordSet(state);
       if(cs)
         ObjectStateLeftCombineMatrixR44d(cs, dbl_matrix);
     } else if(I->NCSet == 1) {  /* static singleton state */
-      cs = I->CSet[0];
+      cs = I->pinCoordSet(0);
       if(cs && SettingGet_b(I->G, I->Setting.get(), NULL, cSetting_static_singletons)) {
         ObjectStateLeftCombineMatrixR44d(cs, dbl_matrix);
       }
@@ -807,7 +818,7 @@ static int ObjectMoleculeFixSeleHydrogens(ObjectMolecule * I, int sele, int stat
           if(SelectorIsMember(I->G, ai0->selEntry, sele)) {
             for(StateIterator iter(I->G, I->Setting.get(), state, I->NCSet);
                 iter.next();) {
-              auto cs = I->CSet[iter.state];
+              auto cs = I->pinCoordSet(iter.state);
               if (!cs)
                 continue;
 
@@ -922,16 +933,18 @@ std::unique_ptr<int[]> LoadTrajSeleHelper(
   auto xref = std::unique_ptr<int[]>(new int[cs->NIndex]);
 
   int idx_new = 0;
+  auto& idx_to_atm = cs->IdxToAtm.mut();
+  auto& atm_to_idx = cs->AtmToIdx.mut();
 
   for (int idx = 0; idx < cs->NIndex; ++idx) {
-    auto atm = cs->IdxToAtm[idx];
+    auto atm = idx_to_atm[idx];
     if (SelectorIsMember(G, obj->AtomInfo[atm].selEntry, sele0)) {
-      cs->IdxToAtm[idx_new] = atm;
-      cs->AtmToIdx[atm] = idx_new;
+      idx_to_atm[idx_new] = atm;
+      atm_to_idx[atm] = idx_new;
       xref[idx] = idx_new;
       ++idx_new;
     } else {
-      cs->AtmToIdx[atm] = -1;
+      atm_to_idx[atm] = -1;
       xref[idx] = -1;
     }
   }
@@ -2626,6 +2639,9 @@ void ObjectGotoState(pymol::CObject* I, int state)
 /*========================================================================*/
 CObjectState* ObjectMolecule::_getObjectState(int state)
 {
+  if (TrajStream) {
+    return TrajStream->fetch(this, state);
+  }
   return CSet[state];
 }
 
@@ -2642,8 +2658,8 @@ pymol::copyable_ptr<CSetting>* ObjectMolecule::getSettingHandle(int state)
   if(state < 0) {
     return (&I->Setting);
   } else if(state < I->NCSet) {
-    if(I->CSet[state]) {
-      return (&I->CSet[state]->Setting);
+    if(auto cs = I->pinCoordSet(state)) {
+      return (&cs->Setting);
     } else {
       return (NULL);
     }
@@ -2677,7 +2693,7 @@ bool ObjectMolecule::setSymmetry(CSymmetry const& symmetry, int state)
   }
 
   for (StateIterator iter(G, Setting.get(), state, NCSet); iter.next();) {
-    auto cs = CSet[iter.state];
+    auto cs = pinCoordSet(iter.state);
     if (cs) {
       cs->Symmetry.reset(all_states ? nullptr : new CSymmetry(symmetry));
       cs->invalidateRep(cRepCell, cRepInvRep);
@@ -2741,7 +2757,7 @@ void ObjectMoleculeRenderSele(ObjectMolecule * I, int curState, int sele, int vi
 
     for(StateIterator iter(G, I->Setting.get(), curState, I->NCSet);
         iter.next();) {
-      if((cs = I->CSet[iter.state])) {
+      if((cs = I->getCoordSet(iter.state))) {
 	    const auto* idx2atm = cs->IdxToAtm.data();
 	    nIndex = cs->NIndex;
 	    coord = cs->Coord;
@@ -3370,7 +3386,7 @@ pymol::Result<> ObjectMoleculeFuse(ObjectMolecule* I, int const index0,
 
     for (StateIterator iter(G, nullptr, state0, I->NCSet); iter.next();) {
       float* vec = target_vectors[iter.state].data();
-      if (GetTargetValenceVector(I->CSet[iter.state], at0, index0, vec)) {
+      if (GetTargetValenceVector(I->getCoordSet(iter.state), at0, index0, vec)) {
         found_any_target_vector = true;
       } else {
         zero3(vec);
@@ -3400,7 +3416,7 @@ pymol::Result<> ObjectMoleculeFuse(ObjectMolecule* I, int const index0,
   for (StateIterator iter(G, nullptr, state0, I->NCSet); iter.next();) {
     const float* const vec =
         move_flag ? target_vectors[iter.state].data() : nullptr;
-    ok = AddCoordinateIntoCoordSet(I->CSet[iter.state], cs.get(),
+    ok = AddCoordinateIntoCoordSet(I->pinCoordSet(iter.state), cs.get(),
         coord_orig.data(), at0, mat1_inv, vec);
     p_return_val_if_fail(ok, pymol::Error::MEMORY);
   }
@@ -3446,7 +3462,7 @@ int ObjectMoleculeVerifyChemistry(ObjectMolecule * I, int state)
   if(state < 0) {
     /* use the first defined state */
     for(a = 0; a < I->NCSet; a++) {
-      if(I->CSet[a]) {
+      if(I->getCoordSet(a)) {
         state = a;
         break;
       }
@@ -3461,7 +3477,7 @@ int ObjectMoleculeVerifyChemistry(ObjectMolecule * I, int state)
     ai++;
   }
   if((!flag) && (state >= 0) && (state < I->NCSet)) {
-    if(I->CSet[state]) {
+    if(I->getCoordSet(state)) {
       ObjectMoleculeInferChemFromBonds(I, state);
       ObjectMoleculeInferChemFromNeighGeom(I, state);
       ObjectMoleculeInferHBondFromChem(I);
@@ -3515,12 +3531,12 @@ int ObjectMoleculeAttach(ObjectMolecule * I, int index,
   ok_assert(1, ObjectMoleculeExtendIndices(I, -1));
 
   for(a = 0; a < I->NCSet; a++) {       /* add atom to each coordinate set */
-    if (const auto* cs_a = I->CSet[a]) {
+    if (auto* cs_a = I->pinCoordSet(a)) {
       CoordSetGetAtomVertex(cs_a, index, v0);
       CoordSetFindOpenValenceVector(cs_a, index, v);
       scale3f(v, d, v);
       add3f(v0, v, cs->Coord.data());
-      ok_assert(1, CoordSetMerge(I, I->CSet[a], cs));
+      ok_assert(1, CoordSetMerge(I, cs_a, cs));
     }
   }
 
@@ -3591,7 +3607,7 @@ int ObjectMoleculeFillOpenValences(ObjectMolecule * I, int index)
       if (ok)
 	ok &= ObjectMoleculeExtendIndices(I, -1);
       for(a = 0; ok &&  a < I->NCSet; a++) {   /* add atom to each coordinate set */
-        if (auto* cs_a = I->CSet[a]) {
+        if (auto* cs_a = I->pinCoordSet(a)) {
           CoordSetGetAtomVertex(cs_a, index, v0);
           CoordSetFindOpenValenceVector(cs_a, index, v);
           scale3f(v, d, v);
@@ -3873,6 +3889,8 @@ void ObjectMoleculeCreateSpheroid(ObjectMolecule * I, int average)
   int n_state = 0;
   sp = GetSpheroidSphereRec(I->G);
 
+  ObjectMoleculeStopStreaming(I);
+
   nRow = I->NAtom * sp->nDot;
 
   center = pymol::malloc<float>(I->NAtom * 3);
@@ -4173,7 +4191,7 @@ int ObjectMoleculePreposReplAtom(ObjectMolecule * I, int index, AtomInfoType * a
   int ok = true;
   if (ok){
     for(a = 0; a < I->NCSet; a++) {
-      if(I->CSet[a]) {
+      if(I->getCoordSet(a)) {
 	if(ObjectMoleculeGetAtomVertex(I, a, index, v0)) {
 	  copy3f(v0, v);          /* default is direct superposition */
 	  ncycle = -1;
@@ -4228,7 +4246,7 @@ void ObjectMoleculeSaveUndo(ObjectMolecule * I, int state, int log)
   if(I->NCSet == 1)
     state = 0;
   state = state % I->NCSet;
-  cs = I->CSet[state];
+  cs = I->getCoordSet(state);
   if(cs) {
     I->UndoCoord[I->UndoIter] = pymol::malloc<float>(cs->NIndex * 3);
     memcpy(I->UndoCoord[I->UndoIter], cs->Coord, sizeof(float) * cs->NIndex * 3);
@@ -4262,7 +4280,7 @@ void ObjectMoleculeUndo(ObjectMolecule * I, int dir)
   if(I->NCSet == 1)
     state = 0;
   state = state % I->NCSet;
-  cs = I->CSet[state];
+  cs = I->pinCoordSet(state);
   if(cs) {
     I->UndoCoord[I->UndoIter] = pymol::malloc<float>(cs->NIndex * 3);
     memcpy(I->UndoCoord[I->UndoIter], cs->Coord, sizeof(float) * cs->NIndex * 3);
@@ -4282,7 +4300,7 @@ void ObjectMoleculeUndo(ObjectMolecule * I, int dir)
     if(I->NCSet == 1)
       state = 0;
     state = state % I->NCSet;
-    cs = I->CSet[state];
+    cs = I->pinCoordSet(state);
     if(cs) {
       if(cs->NIndex == I->UndoNIndex[I->UndoIter]) {
         memcpy(cs->Coord.data(), I->UndoCoord[I->UndoIter], sizeof(float) * cs->NIndex * 3);
@@ -4558,6 +4576,9 @@ void ObjectMoleculePurge(ObjectMolecule * I)
   if(offset) {
     I->NAtom += offset;
     I->AtomInfo.resize(I->NAtom);
+    if (I->TrajStream) {
+      I->TrajStream->adjustAtmIdx(I, oldToNew.data());
+    }
     for (int a = 0; a < I->NCSet; ++a) {
       if (auto cs = I->CSet[a])
         CoordSetAdjustAtmIdx(cs, oldToNew.data());
@@ -4828,7 +4849,7 @@ void ObjectMoleculeGuessValences(ObjectMolecule * I, int state, int *flag1, int
 /* end WORKAROUND */
 
   if((state >= 0) && (state < I->NCSet)) {
-    cs = I->CSet[state];
+    cs = I->getCoordSet(state);
   }
   if(cs) {
     obs_atom = pymol::calloc<ObservedInfo>(I->NAtom);
@@ -6261,7 +6282,7 @@ int ObjectMoleculeTransformSelection(ObjectMolecule * I, int state,
         break;
     }
     if(state < I->NCSet) {
-      cs = I->CSet[state];
+      cs = I->pinCoordSet(state);
       if(cs) {
         int use_matrices = SettingGet_i(G, I->Setting.get(),
                                         NULL, cSetting_matrix_mode);
@@ -7390,7 +7411,7 @@ ObjectMolecule *ObjectMoleculeLoadCoords(PyMOLGlobals * G, ObjectMolecule * I,
   if(frame < 0) {
     frame = I->NCSet;
   } else if (frame < I->NCSet) {
-    cset = I->CSet[frame];
+    cset = I->pinCoordSet(frame);
   }
 
   if (!cset) {
@@ -7481,7 +7502,7 @@ ObjectMolecule *ObjectMoleculeLoadCoords(PyMOLGlobals * G, ObjectMolecule * I,
   if(frame < 0) {
     frame = I->NCSet;
   } else if (frame < I->NCSet) {
-    cset = I->CSet[frame];
+    cset = I->pinCoordSet(frame);
   }
 
   if (!cset) {
@@ -7562,9 +7583,13 @@ int ObjectMoleculeExtendIndices(ObjectMolecule * I, int state)
       ok_assert(1, (!cs) || cs->extendIndices(I->NAtom));
     }
   } else {                      /* do all states */
+    const CoordSet* prev = nullptr;
     for(a = -1; a < I->NCSet; a++) {
       cs = (a < 0) ? I->CSTmpl : I->CSet[a];
-      ok_assert(1, (!cs) || cs->extendIndices(I->NAtom));
+      if(!cs || (prev && CoordSetShareIndices(cs, prev)))
+        continue;
+      ok_assert(1, cs->extendIndices(I->NAtom));
+      prev = cs;
     }
   }
   return true;
@@ -8824,10 +8849,11 @@ int ObjectMoleculeMerge(ObjectMolecule * I, pymol::vla<AtomInfoType>&& ai,
   }
 
   if (ok){
+    auto& idx_to_atm = cs->IdxToAtm.mut();
     for(a = 0; a < n_index; a++) {     /* a is in original file space */
-      a1 = outdex[cs->IdxToAtm[a]];    /* a1 is in sorted atom info space */
+      a1 = outdex[idx_to_atm[a]];    /* a1 is in sorted atom info space */
       a2 = index[a1];
-      cs->IdxToAtm[a] = a2;       /* a2 is in object space */
+      idx_to_atm[a] = a2;       /* a2 is in object space */
       if(a2 < oldNAtom)
         AtomInfoCombine(G, I->AtomInfo + a2, std::move(ai[a1]), aic_mask);
       else
@@ -8949,6 +8975,23 @@ const CoordSet* ObjectMolecule::getCoordSet(int state) const
   return static_cast<const CoordSet*>(getObjectState(state));
 }
 
+/**
+ * Like getCoordSet, for a state which is about to be modified. A streamed
+ * trajectory state gets decoded and is never dropped again.
+ * @param state Object state (0-indexed)
+ * @return NULL if there is no CoordSet for the given state
+ */
+CoordSet* ObjectMolecule::pinCoordSet(int state)
+{
+  if (state < 0 || state >= NCSet) {
+    return nullptr;
+  }
+  if (TrajStream) {
+    return TrajStream->fetch(this, state, true);
+  }
+  return CSet[state];
+}
+
 
 /*========================================================================*/
 void ObjectMoleculeTransformTTTf(ObjectMolecule * I, float *ttt, int frame)
@@ -8968,6 +9011,134 @@ void ObjectMoleculeTransformTTTf(ObjectMolecule * I, float *ttt, int frame)
 }
 
 
+/*========================================================================*/
+/**
+ * Operations which may modify atoms don't necessarily invalidate the
+ * object, so advance its change counters for everything but the known
+ * read-only operations.
+ */
+static void ObjectMoleculeSeleOpBumpVersion(ObjectMolecule * I, const ObjectMoleculeOpRec * op)
+{
+  switch (op->code) {
+  case OMOP_AVRT:
+  case OMOP_SFIT:
+  case OMOP_SUMC:
+  case OMOP_VERT:
+  case OMOP_SVRT:
+  case OMOP_MOME:
+  case OMOP_MNMX:
+  case OMOP_SaveUndo:
+  case OMOP_CountAtoms:
+  case OMOP_Index:
+  case OMOP_PhiPsi:
+  case OMOP_SingleStateVertices:
+  case OMOP_IdentifyObjects:
+  case OMOP_CSetSumVertices:
+  case OMOP_CSetMoment:
+  case OMOP_CSetMinMax:
+  case OMOP_CSetIdxGetAndFlag:
+  case OMOP_GetObjects:
+  case OMOP_CSetMaxDistToPt:
+  case OMOP_MaxDistToPt:
+  case OMOP_CameraMinMax:
+  case OMOP_CSetCameraMinMax:
+  case OMOP_GetChains:
+  case OMOP_StateVRT:
+  case OMOP_CheckVis:
+  case OMOP_CSetSumSqDistToPt:
+  case OMOP_ReferenceValidate:
+    break;
+  case OMOP_ALTR:
+    if(!op->i2)                 /* not iterate */
+      I->bumpVersion(cRepInvProp);
+    break;
+  case OMOP_AlterState:
+    if(!op->i3) {               /* not iterate_state */
+      I->bumpVersion(cRepInvProp);
+      I->bumpVersion(cRepInvCoord);
+    }
+    break;
+  default:
+    I->bumpVersion(cRepInvProp);
+    I->bumpVersion(cRepInvCoord);
+    break;
+  }
+}
+
+/**
+ * OMOP_ALTR and OMOP_AlterState with a natively compiled expression. Atoms
+ * are independent, so the selected atoms are processed in parallel.
+ * @param[out] hit_flag true if any atom was modified
+ * @return false if a value would overflow, nothing is modified then and the
+ * caller must evaluate the expression with Python
+ */
+static bool ObjectMoleculeSeleOpAlterNative(ObjectMolecule* I, int sele,
+    ObjectMoleculeOpRec* op, const pymol::AlterExpr& expr, int& hit_flag)
+{
+  PyMOLGlobals* G = I->G;
+  CoordSet* cs = nullptr;
+
+  if (op->code == OMOP_AlterState) {
+    if (op->i2 >= I->NCSet || !(cs = I->CSet[op->i2]))
+      return true;
+  }
+
+  // SelectorIsMember may build the member bitmap, so test membership
+  // serially before the parallel part
+  std::vector<char> member(I->NAtom);
+  for (int a = 0; a < I->NAtom; ++a)
+    member[a] = SelectorIsMember(G, I->AtomInfo[a].selEntry, sele);
+
+  // visits the selected atoms, stops early if `fn` returns false
+  auto for_each_atom = [&](auto&& fn) {
+    std::atomic<int> count{0};
+    std::atomic<bool> ok{true};
+
+    pymol::parallel_for(G, I->NAtom, 4096,
+        [&](std::size_t begin, std::size_t end, unsigned) {
+          int n = 0;
+          for (std::size_t a = begin; a < end && ok; ++a) {
+            if (!member[a])
+              continue;
+            auto ai = I->AtomInfo.data() + a;
+            bool atom_ok;
+            if (cs) {
+              int idx = cs->atmToIdx(a);
+              if (idx < 0)
+                continue;
+              atom_ok = fn(ai, a, op->i2 + 1, cs->coordPtr(idx));
+            } else {
+              int state = I->DiscreteFlag ? ai->discrete_state : 0;
+              atom_ok = fn(ai, a, state, nullptr);
+            }
+            if (!atom_ok)
+              ok = false;
+            ++n;
+          }
+          count += n;
+        });
+
+    return ok ? int(count) : -1;
+  };
+
+  if (expr.needsCheck() &&
+      for_each_atom([&](AtomInfoType* ai, int a, int state, float* xyz) {
+        return expr.check(ai, a, state, xyz);
+      }) < 0) {
+    return false;
+  }
+
+  int count = for_each_atom(
+      [&](AtomInfoType* ai, int a, int state, float* xyz) {
+        expr.apply(ai, a, state, xyz);
+        return true;
+      });
+
+  op->i1 += count;
+  hit_flag = op->code == OMOP_AlterState && count > 0;
+  return true;
+}
+
 /*========================================================================*/
 bool ObjectMoleculeSeleOp(ObjectMolecule * I, int sele, ObjectMoleculeOpRec * op)
 {
@@ -8992,12 +9163,77 @@ bool ObjectMoleculeSeleOp(ObjectMolecule * I, int sele, ObjectMoleculeOpRec * op
   PyObject* expr_co = nullptr;
   int compileType = Py_single_input;
 #endif
+  std::unique_ptr<pymol::AlterExpr> alter_expr;
 #ifdef _WEBGL
 #endif
   PRINTFD(G, FB_ObjectMolecule)
     " %s-DEBUG: sele %d op->code %d\n", __func__, sele, op->code ENDFD;
   if(sele >= 0) {
     const char *errstr = "Alter";
+    ObjectMoleculeSeleOpBumpVersion(I, op);
+    SelectorUpdateMemberBitmap(G, sele);
+    /* streamed trajectory states are decoded on demand, and kept if
+       modified */
+    if (I->TrajStream) {
+      switch (op->code) {
+      case OMOP_AlterState:
+        I->TrajStream->trim(I);
+        I->TrajStream->fetch(I, op->i2, !op->i3);
+        break;
+      case OMOP_SVRT:
+        I->TrajStream->trim(I);
+        I->TrajStream->fetch(I, op->i1);
+        break;
+      case OMOP_StateVRT:
+        I->TrajStream->trim(I);
+        I->TrajStream->fetch(I, op->i1);
+        break;
+      case OMOP_SingleStateVertices:
+      case OMOP_CSetMinMax:
+      case OMOP_CSetCameraMinMax:
+      case OMOP_CSetMaxDistToPt:
+      case OMOP_CSetSumSqDistToPt:
+      case OMOP_CSetSumVertices:
+      case OMOP_CSetMoment:
+        I->TrajStream->trim(I);
+        I->TrajStream->fetch(I, op->cs1);
+        break;
+      case OMOP_VERT:
+      case OMOP_AVRT:
+      case OMOP_SUMC:
+      case OMOP_MNMX:
+      case OMOP_CameraMinMax:
+      case OMOP_MaxDistToPt:
+      case OMOP_MOME:
+        /* atoms are visited once, with all of their states */
+        I->TrajStream->trim(I);
+        I->TrajStream->fetchAll(I);
+        break;
+      case OMOP_ReferenceStore:
+      case OMOP_ReferenceRecall:
+      case OMOP_ReferenceValidate:
+      case OMOP_ReferenceSwap:
+        I->TrajStream->trim(I);
+        if (op->i1 < 0) {
+          I->TrajStream->fetchAll(I, true);
+        } else {
+          I->TrajStream->fetch(I, op->i1, true);
+        }
+        break;
+      case OMOP_CSetIdxGetAndFlag:
+      case OMOP_CSetIdxSetFlagged:
+        /* smooth reads, then writes the whole range of states */
+        I->TrajStream->trim(I);
+        for (b = op->cs1; b <= op->cs2; ++b) {
+          I->TrajStream->fetch(I, b, op->code == OMOP_CSetIdxSetFlagged);
+        }
+        break;
+      case OMOP_INVA:
+        /* states get decoded into new coordinate sets without
+           representations, so only resident states need invalidation */
+        break;
+      }
+    }
     /* always run on entry */
     switch (op->code) {
     case OMOP_LABL:
@@ -9012,6 +9248,18 @@ bool ObjectMoleculeSeleOp(ObjectMolecule * I, int sele, ObjectMoleculeOpRec * op
     case OMOP_AlterState:
       // assume blocked interpreter
 
+      // modifying expressions from the native subset skip the interpreter
+      if (op->code == OMOP_ALTR && !op->i2) {
+        alter_expr = pymol::AlterExpr::compile(G, op->s1, false);
+      } else if (op->code == OMOP_AlterState && !op->i3) {
+        alter_expr = pymol::AlterExpr::compile(G, op->s1, true);
+      }
+
+      // Python is also needed if a native value may overflow
+      if (alter_expr && !alter_expr->needsCheck()) {
+        break;
+      }
+
       if (op->s1 && op->s1[0]){
 #ifndef _PYMOL_NOPY
 	expr_co = Py_CompileString(op->s1, "", compileType);
@@ -9262,6 +9510,11 @@ bool ObjectMoleculeSeleOp(ObjectMolecule * I, int sele, ObjectMoleculeOpRec * op
       if(cnt) {                 /* only perform action for selected object */
 
         for(b = 0; b < I->NCSet; b++) {
+          if(I->TrajStream && b != op->i2) {
+            /* keep the state if it gets transformed */
+            I->TrajStream->trim(I);
+            I->TrajStream->fetch(I, b, op->i1 == 2);
+          }
           rms = -1.0;
           vt1 = vt;             /* reset target vertex pointers */
           vt2 = op->vv2;
@@ -9785,6 +10038,10 @@ bool ObjectMoleculeSeleOp(ObjectMolecule * I, int sele, ObjectMoleculeOpRec * op
       }
       break;
     default:
+      if (alter_expr &&
+          ObjectMoleculeSeleOpAlterNative(I, sele, op, *alter_expr, hit_flag)) {
+        break;
+      }
       {
         int inv_flag;
 #ifdef _PYMOL_IP_EXTRAS
@@ -10329,6 +10586,8 @@ bool ObjectMoleculeSeleOp(ObjectMolecule * I, int sele, ObjectMoleculeOpRec * op
         ExecutiveUpdateColorDepends(I->G, I);
         break;
       case OMOP_TTTF:
+        if(I->TrajStream)
+          I->TrajStream->fetchAll(I, true);
         ObjectMoleculeTransformTTTf(I, op->ttt, -1);
         break;
       case OMOP_LABL:
@@ -10505,52 +10764,16 @@ int ObjectMolecule::getNFrame() const
   return NCSet;
 }
 
-struct _CCoordSetUpdateThreadInfo {
-  CoordSet *cs;
-  int a;
-};
-
-void CoordSetUpdateThread(CCoordSetUpdateThreadInfo * T)
-{
-  if(T->cs) {
-    T->cs->update(T->a);
-  }
-}
-
-#ifndef _PYMOL_NOPY
-static void ObjMolCoordSetUpdateSpawn(PyMOLGlobals * G,
-                                      CCoordSetUpdateThreadInfo * Thread, int n_thread,
-                                      int n_total)
-{
-  if(n_total == 1) {
-    CoordSetUpdateThread(Thread);
-  } else if(n_total) {
-    int blocked;
-    PyObject *info_list;
-    int a, n = 0;
-    blocked = PAutoBlock(G);
-
-    PRINTFB(G, FB_Scene, FB_Blather)
-      " Scene: updating coordinate sets with %d threads...\n", n_thread ENDFB(G);
-    info_list = PyList_New(n_total);
-    for(a = 0; a < n_total; a++) {
-      PyList_SetItem(info_list, a, PyCapsule_New(Thread + a, nullptr, nullptr));
-      n++;
-    }
-    PXDecRef(PYOBJECT_CALLMETHOD
-             (G->P_inst->cmd, "_coordset_update_spawn", "Oi", info_list, n_thread));
-    Py_DECREF(info_list);
-    PAutoUnblock(G, blocked);
-  }
-}
-#endif
-
-
 /*========================================================================*/
-void ObjectMolecule::update()
+/**
+ * Refreshes the caches which the representation builds depend on, and
+ * determines the range of states to update.
+ * @param[out] start First state to update
+ * @param[out] stop One past the last state to update
+ */
+static void ObjectMoleculeUpdatePrepare(ObjectMolecule* I, int* start, int* stop)
 {
-  auto I = this;
-  int a; /*, ok; */
+  PyMOLGlobals* G = I->G;
 
   OrthoBusyPrime(G);
   /* if the cached representation is invalid, reset state */
@@ -10560,7 +10783,7 @@ void ObjectMolecule::update()
     if(I->NCSet > 1) {
       const AtomInfoType *ai = I->AtomInfo.data();
       I->RepVisCache = 0;
-      for(a = 0; a < I->NAtom; a++) {
+      for(int a = 0; a < I->NAtom; a++) {
         I->RepVisCache |= ai->visRep;
         ai++;
       }
@@ -10571,74 +10794,181 @@ void ObjectMolecule::update()
     }
     I->RepVisCacheValid = true;
   }
-  {
-    /* determine the start/stop states */
-    int start = 0;
-    int stop = I->NCSet;
-    /* set start and stop given an object */
-    ObjectAdjustStateRebuildRange(I, &start, &stop);
-    if((I->NCSet == 1)
-       && (SettingGet_b(G, I->Setting.get(), NULL, cSetting_static_singletons))) {
-      start = 0;
-      stop = 1;
+  if (I->TrajStream) {
+    /* decode the displayed states of a streamed trajectory, and drop the
+       least recently displayed ones */
+    int n_fetch = std::max(1, SettingGet<int>(G, I->Setting.get(), nullptr,
+                                  cSetting_traj_stream_cache));
+    for (StateIterator iter(I, ObjectGetCurrentState(I, false));
+         iter.next() && n_fetch; --n_fetch) {
+      I->TrajStream->fetch(I, iter.state);
     }
-    if(stop > I->NCSet)
-      stop = I->NCSet;
+    I->TrajStream->trim(I);
+  }
 
-    /* single and multithreaded coord set updates */
-    {
+  /* determine the start/stop states */
+  *start = 0;
+  *stop = I->NCSet;
+  /* set start and stop given an object */
+  ObjectAdjustStateRebuildRange(I, start, stop);
+  if((I->NCSet == 1)
+     && (SettingGet_b(G, I->Setting.get(), NULL, cSetting_static_singletons))) {
+    *start = 0;
+    *stop = 1;
+  }
+  if(*stop > I->NCSet)
+    *stop = I->NCSet;
+}
+
+/**
+ * True if building `rep` of `cs` must run on the main thread: the surface
+ * cache lives in the Python interpreter, and carve and clear selections are
+ * evaluated by the selector.
+ */
+static bool RepUpdateNeedsMainThread(
+    const ObjectMolecule* I, const CoordSet* cs, cRep_t rep)
+{
+  PyMOLGlobals* G = I->G;
+  int carve = 0, clear = 0;
+
+  switch (rep) {
+  case cRepSurface:
 #ifndef _PYMOL_NOPY
-      int n_thread = SettingGetGlobal_i(G, cSetting_max_threads);
-      int multithread = SettingGetGlobal_i(G, cSetting_async_builds);
+    if (SettingGet_i(G, cs->Setting.get(), I->Setting.get(), cSetting_cache_mode) > 0)
+      return true;
+#endif
+    carve = cSetting_surface_carve_selection;
+    clear = cSetting_surface_clear_selection;
+    break;
+  case cRepMesh:
+    carve = cSetting_mesh_carve_selection;
+    clear = cSetting_mesh_clear_selection;
+    break;
+  default:
+    return false;
+  }
 
-      if(multithread && (n_thread) && (stop - start) > 1) {
-        int cnt = 0;
+  for (int index : {carve, clear}) {
+    auto sele = SettingGet_s(G, cs->Setting.get(), I->Setting.get(), index);
+    if (sele && sele[0])
+      return true;
+  }
 
-        /* must precalculate to avoid race-condition since this isn't
-           mutexed yet and neighbors are needed by cartoons */
-        this->getNeighborArray();
+  return false;
+}
 
-        for(a = start; a < stop; a++)
-          if((a<I->NCSet) && I->CSet[a])
-            cnt++;
-        {
-          CCoordSetUpdateThreadInfo *thread_info = pymol::malloc<CCoordSetUpdateThreadInfo>(cnt);
-          if(thread_info) {
-            cnt = 0;
-            for(a = start; a < stop; a++) {
-              if((a<I->NCSet) && I->CSet[a]) {
-                thread_info[cnt].cs = I->CSet[a];
-                thread_info[cnt].a = a;
-                cnt++;
-              }
-            }
-            ObjMolCoordSetUpdateSpawn(G, thread_info, n_thread, cnt);
-            FreeP(thread_info);
-          }
+/*========================================================================*/
+void ObjectMolecule::addUpdateTasks(pymol::TaskGraph& graph)
+{
+  using Node = pymol::TaskGraph::Node;
 
-        }
+  int start, stop;
+  ObjectMoleculeUpdatePrepare(this, &start, &stop);
 
-      } else
-#endif
-      {                         /* single thread */
-        for(a = start; a < stop; a++) {
-          if((a<I->NCSet) && I->CSet[a] && (!G->Interrupt)) {
-	    /* status bar */
-            OrthoBusySlow(G, a, I->NCSet);
-            PRINTFB(G, FB_ObjectMolecule, FB_Blather)
-              " ObjectMolecule-DEBUG: updating representations for state %d of \"%s\".\n",
-              a + 1, I->Name ENDFB(G);
-            I->CSet[a]->update(a);
-          }
-        }
+  /* lazily computed and needed by the builds (e.g. cartoons), must not
+     be computed concurrently */
+  getNeighborArray();
+
+  bool prev_surface_queued = false;
+  Node prev_surface = 0;
+
+  for (int a = start; a < stop; a++) {
+    CoordSet* cs = CSet[a];
+    if (!cs) {
+      prev_surface_queued = false;
+      continue;
+    }
+
+    auto new_rep = std::make_shared<std::atomic<bool>>(false);
+    std::vector<Node> builds;
+    bool surface_queued = false;
+
+    for (auto rep : CoordSetUpdateReps) {
+      if (!cs->Active[rep])
+        continue;
+
+      /* incremental surfaces start from the surface of the previous state */
+      std::vector<Node> deps;
+      if (rep == cRepSurface && prev_surface_queued &&
+          SettingGet_b(G, cs->Setting.get(), Setting.get(),
+              cSetting_surface_incremental))
+        deps.push_back(prev_surface);
+
+      builds.push_back(graph.add(
+          [cs, rep, a, new_rep] {
+            if (cs->updateRep(rep, a))
+              *new_rep = true;
+          },
+          deps, RepUpdateNeedsMainThread(this, cs, rep)));
+
+      if (rep == cRepSurface) {
+        surface_queued = true;
+        prev_surface = builds.back();
+      }
+    }
+
+    graph.add(
+        [G = G, cs, new_rep] {
+          if (*new_rep)
+            SceneInvalidatePicking(G);
+          cs->updateFinish();
+        },
+        builds, true);
+
+    prev_surface_queued = surface_queued;
+  }
+}
+
+/*========================================================================*/
+void ObjectMolecule::update()
+{
+  auto I = this;
+
+  if(SettingGetGlobal_b(G, cSetting_async_builds) &&
+      pymol::parallel_workers(G) > 1) {
+    /* one task per state and representation */
+    pymol::TaskGraph graph;
+    addUpdateTasks(graph);
+    graph.run(G);
+  } else {                      /* single thread */
+    int start, stop;
+    ObjectMoleculeUpdatePrepare(I, &start, &stop);
+    for(int a = start; a < stop; a++) {
+      if((a<I->NCSet) && I->CSet[a] && (!G->Interrupt)) {
+        /* status bar */
+        OrthoBusySlow(G, a, I->NCSet);
+        PRINTFB(G, FB_ObjectMolecule, FB_Blather)
+          " ObjectMolecule-DEBUG: updating representations for state %d of \"%s\".\n",
+          a + 1, I->Name ENDFB(G);
+        I->CSet[a]->update(a);
       }
     }
-  } /* end block */
+  }
 
   PRINTFD(G, FB_ObjectMolecule)
     " ObjectMolecule: updates complete for object %s.\n", I->Name ENDFD;
 }
 
+/*========================================================================*/
+/**
+ * Advance the change counters affected by an invalidation of `level`
+ * (without the purge bit).
+ */
+void ObjectMolecule::bumpVersion(cRepInv_t level)
+{
+  static std::atomic<unsigned> s_version{0};
+  auto const version = ++s_version;
+
+  /* levels are cumulative, and writers of atom properties invalidate at
+     any level (dss at cRepInvRep, mask at cRepInvPick) */
+  if(level >= cRepInvBonds)
+    StateVersion = version;
+  if(level >= cRepInvCoord)
+    CoordVersion = version;
+  if(level > cRepInvNone)
+    AtomVersion = version;
+}
+
 /*========================================================================*/
 void ObjectMolecule::invalidate(cRep_t rep, cRepInv_t level, int state)
 {
@@ -10652,6 +10982,8 @@ void ObjectMolecule::invalidate(cRep_t rep, cRepInv_t level, int state)
   // Remove the "purge" bit
   level = static_cast<decltype(level)>(level & ~cRepInvPurgeMask);
 
+  bumpVersion(level);
+
   if(level >= cRepInvVisib) {
     I->RepVisCacheValid = false;
   }
@@ -10709,7 +11041,7 @@ void ObjectMoleculeInvalidateAtomType(ObjectMolecule *I, int state){
   CoordSet *cset = 0;
   int ai, atm;
   AtomInfoType *at;
-  cset = I->CSet[state];
+  cset = I->getCoordSet(state);
   if (state < 0){
     for (ai=0; ai < I->NAtom; ai++){
       at = &I->AtomInfo[ai];
@@ -10739,11 +11071,13 @@ int ObjectMoleculeMoveAtom(ObjectMolecule * I, int state, int index, const float
     if(I->NCSet == 1)
       state = 0;
     state = state % I->NCSet;
-    if((!I->CSet[state]) && (SettingGet_b(G, I->Setting.get(), NULL, cSetting_all_states)))
+    cs = I->pinCoordSet(state);
+    if((!cs) && (SettingGet_b(G, I->Setting.get(), NULL, cSetting_all_states))) {
       state = 0;
-    cs = I->CSet[state];
+      cs = I->pinCoordSet(state);
+    }
     if(cs) {
-      result = CoordSetMoveAtom(I->CSet[state], index, v, mode);
+      result = CoordSetMoveAtom(cs, index, v, mode);
       cs->invalidateRep(cRepAll, cRepInvCoord);
       ExecutiveUpdateCoordDepends(G, I);
     }
@@ -10772,12 +11106,14 @@ int ObjectMoleculeMoveAtomLabel(ObjectMolecule * I, int state, int index, float
     if(I->NCSet == 1)
       state = 0;
     state = state % I->NCSet;
-    if((!I->CSet[state])
-       && (SettingGet_b(I->G, I->Setting.get(), NULL, cSetting_all_states)))
+    cs = I->pinCoordSet(state);
+    if((!cs)
+       && (SettingGet_b(I->G, I->Setting.get(), NULL, cSetting_all_states))) {
       state = 0;
-    cs = I->CSet[state];
+      cs = I->pinCoordSet(state);
+    }
     if(cs) {
-      result = CoordSetMoveAtomLabel(I->CSet[state], index, v, diff);
+      result = CoordSetMoveAtomLabel(cs, index, v, diff);
       cs->invalidateRep(cRepLabel, cRepInvCoord);
     }
   }
@@ -10970,11 +11306,12 @@ int ObjectMoleculeGetAtomVertex(const ObjectMolecule * I, int state, int index,
   if(I->NCSet == 1)
     state = 0;                  /* static singletons always active here it seems */
   state = state % I->NCSet;
-  if((!I->CSet[state])
+  const CoordSet* cs = I->getCoordSet(state);
+  if((!cs)
      && (SettingGet_b(I->G, I->Setting.get(), NULL, cSetting_all_states)))
-    state = 0;
-  if(I->CSet[state])
-    result = CoordSetGetAtomVertex(I->CSet[state], index, v);
+    cs = I->getCoordSet(0);
+  if(cs)
+    result = CoordSetGetAtomVertex(cs, index, v);
 
   return (result);
 }
@@ -10998,10 +11335,10 @@ int ObjectMoleculeGetAtomTxfVertex(const ObjectMolecule * I, int state, int inde
   state = state % I->NCSet;
   {
     if (!cs)
-      cs = I->CSet[state];
+      cs = I->getCoordSet(state);
     if((!cs) && (SettingGet_b(I->G, I->Setting.get(), NULL, cSetting_all_states))) {
       state = 0;
-      cs = I->CSet[state];
+      cs = I->getCoordSet(state);
     }
     if(cs) {
       result = CoordSetGetAtomTxfVertex(cs, index, v);
@@ -11021,11 +11358,12 @@ int ObjectMoleculeSetAtomVertex(ObjectMolecule * I, int state, int index, float
   if(I->NCSet == 1)
     state = 0;
   state = state % I->NCSet;
-  if((!I->CSet[state])
+  CoordSet* cs = I->pinCoordSet(state);
+  if((!cs)
      && (SettingGet_b(I->G, I->Setting.get(), NULL, cSetting_all_states)))
-    state = 0;
-  if(I->CSet[state])
-    result = CoordSetSetAtomVertex(I->CSet[state], index, v);
+    cs = I->pinCoordSet(0);
+  if(cs)
+    result = CoordSetSetAtomVertex(cs, index, v);
   return (result);
 }
 
@@ -11098,6 +11436,8 @@ ObjectMolecule::ObjectMolecule(PyMOLGlobals * G, int discreteFlag) : pymol::CObj
 {
   auto I = this;
   int a;
+  static std::atomic<unsigned> s_serial{0};
+  I->Serial = ++s_serial;
   I->type = cObjectMolecule;
   I->CSet = pymol::vla<CoordSet*>(10); /* auto-zero */
   I->DiscreteFlag = discreteFlag;
@@ -11114,6 +11454,7 @@ ObjectMolecule::ObjectMolecule(PyMOLGlobals * G, int discreteFlag) : pymol::CObj
     I->UndoState[a] = -1;
   }
   I->UndoIter = 0;
+  I->bumpVersion(cRepInvAll);
 }
 
 
@@ -11125,8 +11466,11 @@ void ObjectMoleculeCopyNoAlloc(const ObjectMolecule* obj, ObjectMolecule* I)
   int a;
   BondType *i0;
   const BondType *i1;
+  auto const serial = I->Serial;
   (*I) = (*obj);
+  I->Serial = serial;
   I->Sculpt = NULL;
+  I->bumpVersion(cRepInvAll);
   I->Setting.reset(SettingCopyAll(G, obj->Setting.get(), nullptr));
 
   I->ViewElem = NULL;
@@ -11141,6 +11485,9 @@ void ObjectMoleculeCopyNoAlloc(const ObjectMolecule* obj, ObjectMolecule* I)
       I->CSet[a]->Obj = I;
   }
 
+  if (I->TrajStream)
+    I->TrajStream->rebind(obj, I);
+
   if(obj->CSTmpl)
     I->CSTmpl = CoordSetCopy(obj->CSTmpl);
 
@@ -11201,6 +11548,9 @@ int ObjectMoleculeSetStateOrder(ObjectMolecule * I, int * order, int len) {
   VLAFreeP(I->CSet);
   I->CSet = pymol::vla_take_ownership(csets);
 
+  if (I->TrajStream)
+    I->TrajStream->reorder(order, len);
+
   return true;
 ok_except1:
   ErrMessage(I->G, "ObjectMoleculeSetStateOrder", "failed");
@@ -11706,6 +12056,8 @@ bool ObjectMolecule::setNDiscrete(int natom) {
  * IdxToAtm arrays
  */
 bool ObjectMolecule::updateAtmToIdx() {
+  const CoordSet* prev = nullptr;
+
   if (DiscreteFlag) {
     ok_assert(1, setNDiscrete(NAtom));
   }
@@ -11717,7 +12069,11 @@ bool ObjectMolecule::updateAtmToIdx() {
       continue;
 
     if (!DiscreteFlag) {
-      cset->updateNonDiscreteAtmToIdx(NAtom);
+      // states with the same atoms (trajectories) share their index maps
+      if (!prev || !CoordSetShareIndices(cset, prev)) {
+        cset->updateNonDiscreteAtmToIdx(NAtom);
+        prev = cset;
+      }
     } else {
       for (int idx = 0; idx < cset->NIndex; ++idx) {
         int atm = cset->IdxToAtm[idx];
@@ -23,6 +23,7 @@ Z* -------------------------------------------------------------------
 
 #include"PyMOLObject.h"
 #include"AtomInfo.h"
+#include "TrajectoryStream.h"
 #include"Vector.h"
 #include"Color.h"
 #include"Symmetry.h"
@@ -72,6 +73,9 @@ struct ObjectMolecule : public pymol::CObject {
   int DiscreteFlag = 0;
   pymol::vla<int> DiscreteAtmToIdx;
   pymol::vla<CoordSet*> DiscreteCSet;
+  /* states which are decoded from trajectory files on demand, see
+     "traj_stream_cache" */
+  pymol::copyable_ptr<pymol::TrajectoryStream> TrajStream;
   /* proposed, for storing uniform trajectory data more efficiently:
      int *UniformAtmToIdx, *UniformIdxToAtm;  */
   int SeleBase = 0;                 /* for internal usage by  selector & only valid during selection process */
@@ -103,6 +107,16 @@ public:
   // hetatm and ignore-flag by non-polymer classification
   bool need_hetatm_classification = false;
 
+  /* change counters for the selection result cache, drawn from one global
+     sequence so that a new object never repeats an old object's values */
+  unsigned AtomVersion = 0;  //!< atom properties and selection flags
+  unsigned CoordVersion = 0; //!< coordinates
+  unsigned StateVersion = 0; //!< atom and bond structure, coordinate sets
+  void bumpVersion(cRepInv_t level);
+
+  /// Never reused, unlike the address of a deleted object. Not copied.
+  unsigned Serial = 0;
+
   // methods
   ObjectMolecule(PyMOLGlobals* G, int discreteFlag);
   ~ObjectMolecule();
@@ -113,9 +127,11 @@ public:
   /// Typed version of getObjectState
   CoordSet* getCoordSet(int state);
   const CoordSet* getCoordSet(int state) const;
+  CoordSet* pinCoordSet(int state);
 
   // virtual methods
   void update() override;
+  void addUpdateTasks(pymol::TaskGraph& graph) override;
   void render(RenderInfo* info) override;
   void invalidate(cRep_t rep, cRepInv_t level, int state) override;
   int getNFrame() const override;
@@ -172,6 +188,8 @@ enum {
   PDB_VARIANT_VDB,      /* VIPERdb */
 };
 
+struct PDBAtomRecords;
+
 struct PDBInfoRec{
   int variant;
   int pqr_workarounds;
@@ -179,6 +197,7 @@ struct PDBInfoRec{
   int ignore_header_names;
   int multi_object_status;      /* 0 = unknown, 1 = is multi_object, -1 is not multi_object */
   int multiplex;
+  const PDBAtomRecords* atom_records; /* pre-parsed ATOM/HETATM records (may be NULL) */
 
   inline bool is_pqr_file() const {
     return variant == PDB_VARIANT_PQR;
@@ -486,6 +505,8 @@ void ObjectMoleculeTransformState44f(ObjectMolecule * I, int state, const float
 
 /* internal to ObjectMolecule */
 
+std::shared_ptr<PDBAtomRecords> ObjectMoleculePDBParseAtomRecords(
+    PyMOLGlobals* G, const char* buffer, int variant);
 struct CoordSet *ObjectMoleculePDBStr2CoordSet(PyMOLGlobals * G,
                                                const char *buffer,
                                                AtomInfoType ** atInfoPtr,
@@ -518,6 +539,8 @@ ObjectMolecule *ObjectMoleculeReadMmtfStr(PyMOLGlobals * G, ObjectMolecule * I,
     const char *st, int st_len, int frame, int discrete, int quiet, int multiplex, int zoom);
 pymol::Result<ObjectMolecule*> ObjectMoleculeReadCifStr(PyMOLGlobals * G, ObjectMolecule * I,
     const char *st, int frame, int discrete, int quiet, int multiplex, int zoom);
+pymol::Result<ObjectMolecule*> ObjectMoleculeReadBCifStr(PyMOLGlobals * G, ObjectMolecule * I,
+    const char *st, int st_len, int frame, int discrete, int quiet, int multiplex, int zoom);
 
 std::unique_ptr<int[]> LoadTrajSeleHelper(
     const ObjectMolecule* obj, CoordSet* cs, const char* selection);
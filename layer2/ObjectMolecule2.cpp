@@ -45,6 +45,7 @@
 #include"ObjectCGO.h"
 #include"Scene.h"
 #include "Lex.h"
+#include "TaskPool.h"
 
 #include"AtomInfoHistory.h"
 #include"BondTypeHistory.h"
@@ -55,6 +56,7 @@
 
 #include "pymol/zstring_view.h"
 
+#include <algorithm>
 #include <functional>
 #include <iostream>
 #include <map>
@@ -348,7 +350,7 @@ int ObjectMoleculeAddPseudoatom(ObjectMolecule * I, int sele_index, const char *
   for(state = start_state; state < stop_state; state++) {
 
 
-    if((extant_only && (state < I->NCSet) && I->CSet[state]) || !extant_only) {
+    if((extant_only && (state < I->NCSet) && I->getCoordSet(state)) || !extant_only) {
 
       if(sele_index >= 0) {
         ObjectMoleculeOpRec op;
@@ -414,7 +416,7 @@ int ObjectMoleculeAddPseudoatom(ObjectMolecule * I, int sele_index, const char *
           VLACheck(I->CSet, CoordSet *, state);
           I->NCSet = state + 1;
         }
-        if(!I->CSet[state]) {
+        if(!I->pinCoordSet(state)) {
           /* new coordinate set */
           I->CSet[state] = CoordSetCopy(cset);
         } else {
@@ -1861,6 +1863,225 @@ static bool parse_pqr_atom_line(PyMOLGlobals * G,
   return false;
 }
 
+/**
+ * Text fields of an ATOM/HETATM record. Extracting them doesn't touch the
+ * lexicon or any other shared state, so records can be parsed concurrently.
+ */
+struct PDBAtomRecord {
+  const char* line = nullptr; // start of the record
+  int id = 0;
+  AtomName literal_name = "";
+  AtomName name = "";         // trimmed, unless pdb_literal_names
+  char alt = 0;
+  char resn[5] = "";
+  char chain[2] = "";
+  int resv = 0;
+  char inscode = 0;
+  float coord[3] = {0.f, 0.f, 0.f};
+  float q = 1.f;
+  float b = 0.f;
+  float partialCharge = 0.f;
+  char segi[5] = "";
+  bool segi_overflow = false; // segi "...1" and "0000" in the element column
+  ElemName elem = "";         // from the element column, may be empty
+  bool has_formal_charge = false;
+  signed char formalCharge = 0;
+};
+
+/**
+ * ATOM/HETATM records of a whole PDB file, in file order
+ */
+struct PDBAtomRecords {
+  std::vector<PDBAtomRecord> records;
+
+  /// Record which starts at `line`, or NULL
+  const PDBAtomRecord* find(const char* line) const {
+    auto it = std::lower_bound(records.begin(), records.end(), line,
+        [](const PDBAtomRecord& rec, const char* p) { return rec.line < p; });
+    return (it != records.end() && it->line == line) ? &*it : nullptr;
+  }
+};
+
+/**
+ * Settings which affect the ATOM/HETATM field extraction
+ */
+struct PDBAtomRecordOptions {
+  bool literal_names;
+  bool truncate_resn;
+  int variant;
+};
+
+/**
+ * Extract the fields of an ATOM/HETATM record
+ * @param line Start of the record
+ * @param is_pqr Stop after the coordinates
+ * @return pointer to the first unparsed character
+ */
+static const char* parse_pdb_atom_record(const char* line,
+    PDBAtomRecord& rec, const PDBAtomRecordOptions& options, bool is_pqr)
+{
+  char cc[MAXLINELEN];
+  const char* p = nskip(line, 6);
+
+  rec.line = line;
+
+  p = ncopy(cc, p, 5);
+  if(!sscanf(cc, "%d", &rec.id))
+    rec.id = 0;
+
+  p = nskip(p, 1);              /* to 12 */
+  p = ncopy(rec.literal_name, p, 4);
+  if(options.literal_names) {
+    strcpy(rec.name, rec.literal_name);
+  } else {
+    ParseNTrim(rec.name, rec.literal_name, 4);
+  }
+
+  p = ncopy(cc, p, 1);
+  rec.alt = *cc;
+
+  p = ntrim(rec.resn, p, 4); /* now allowing for 4-letter residues */
+  if (options.truncate_resn)    /* unless specifically disabled */
+    rec.resn[3] = 0;
+
+  p = ncopy(rec.chain, p, 1);
+
+  p = ncopy(cc, p, 4);
+  if(!sscanf(cc, "%d", &rec.resv))
+    rec.resv = 0;
+  rec.inscode = *p;
+  p = nskip(p, 1);
+
+  p = nskip(p, 3);
+  for (int i = 0; i < 3; ++i) {
+    p = ncopy(cc, p, 8);
+    sscanf(cc, "%f", rec.coord + i);
+  }
+
+  if(is_pqr)
+    return p;
+
+  p = ncopy(cc, p, 6);
+  if(!sscanf(cc, "%f", &rec.q))
+    rec.q = 1.0;
+
+  p = ncopy(cc, p, 6);
+  if(!sscanf(cc, "%f", &rec.b))
+    rec.b = 0.0;
+
+  if (options.variant == PDB_VARIANT_PDBQT) {
+    p = nskip(p, 4);
+    p = ncopy(cc, p, 6);
+    if(!sscanf(cc, "%f", &rec.partialCharge))
+      rec.partialCharge = 0.0;
+
+    // type is 78-79 in pdbqt, 77-78 in pdb
+    p = nskip(p, 1);
+  } else {
+    p = nskip(p, 6);
+    p = ncopy(cc, p, 4);
+    /* atom ID overflow? (nonstandard use...)... */
+    rec.segi_overflow = (cc[3] == '1' && strncmp(p, "0000", 4) == 0);
+    UtilCleanStr(cc);
+    strcpy(rec.segi, cc);
+  }
+
+  p = ncopy(cc, p, 2);
+  if(!sscanf(cc, "%s", rec.elem))
+    rec.elem[0] = 0;
+  else if(!((((rec.elem[0] >= 'a') && (rec.elem[0] <= 'z')) ||    /* don't get confused by PDB misuse */
+             ((rec.elem[0] >= 'A') && (rec.elem[0] <= 'Z'))) &&
+            (((rec.elem[1] == 0) ||
+              ((rec.elem[1] >= 'a') && (rec.elem[1] <= 'z')) ||
+              ((rec.elem[1] >= 'A') && (rec.elem[1] <= 'Z'))))))
+    rec.elem[0] = 0;
+  else if (options.variant == PDB_VARIANT_PDBQT) {
+    if (strcmp(rec.elem, "A") == 0) {
+      // aromatic carbon
+      rec.elem[0] = 'C';
+    } else if (isupper(rec.elem[1])) {
+      // h-bond donor or acceptor
+      rec.elem[1] = 0;
+    }
+  }
+
+  p = ncopy(cc, p, 2);
+  if((cc[1] == '-') || (cc[1] == '+')) {
+    /* only read formal charge when sign is present */
+    char ctmp = cc[0];
+    cc[0] = cc[1];
+    cc[1] = ctmp;
+    rec.has_formal_charge = true;
+    if(!sscanf(cc, "%hhi", &rec.formalCharge))
+      rec.formalCharge = 0;
+  }
+
+  return p;
+}
+
+/**
+ * Extract the ATOM/HETATM records of a whole PDB file (all models and all
+ * concatenated objects) in parallel. The file is split into sections at line
+ * starts and each section is parsed by one worker.
+ *
+ * @return NULL if not worth it (small file, single thread, PQR format)
+ */
+std::shared_ptr<PDBAtomRecords> ObjectMoleculePDBParseAtomRecords(
+    PyMOLGlobals* G, const char* buffer, int variant)
+{
+  const std::size_t min_section_size = 1 << 16;
+  const std::size_t size = strlen(buffer);
+  const unsigned n_workers = pymol::parallel_workers(G);
+
+  if (variant == PDB_VARIANT_PQR || n_workers < 2 ||
+      size < 4 * min_section_size) {
+    return nullptr;
+  }
+
+  const PDBAtomRecordOptions options = {
+      SettingGetGlobal_b(G, cSetting_pdb_literal_names),
+      SettingGetGlobal_b(G, cSetting_pdb_truncate_residue_name),
+      variant,
+  };
+
+  const std::size_t n_sections =
+      std::min<std::size_t>(size / min_section_size, n_workers * 4);
+
+  // first line start at or after the nominal section boundary
+  auto section_begin = [&](std::size_t s) {
+    if (s == 0)
+      return buffer;
+    const char* end = buffer + size;
+    const char* q = buffer + size * s / n_sections;
+    q = (const char*) memchr(q, '\n', end - q);
+    return q ? q + 1 : end;
+  };
+
+  std::vector<std::vector<PDBAtomRecord>> sections(n_sections);
+
+  pymol::parallel_for(G, n_sections, 1,
+      [&](std::size_t s_begin, std::size_t s_end, unsigned) {
+        for (auto s = s_begin; s != s_end; ++s) {
+          const char* end = section_begin(s + 1);
+          for (const char* p = section_begin(s); p < end && *p;
+               p = nextline(p)) {
+            if (strstartswith(p, "ATOM ") || strstartswith(p, "HETATM")) {
+              sections[s].emplace_back();
+              parse_pdb_atom_record(p, sections[s].back(), options, false);
+            }
+          }
+        }
+      });
+
+  auto result = std::make_shared<PDBAtomRecords>();
+  for (auto& section : sections) {
+    result->records.insert(
+        result->records.end(), section.begin(), section.end());
+  }
+
+  return result;
+}
+
 CoordSet *ObjectMoleculePDBStr2CoordSet(PyMOLGlobals * G,
                                         const char *buffer,
                                         AtomInfoType ** atInfoPtr,
@@ -1910,6 +2131,9 @@ CoordSet *ObjectMoleculePDBStr2CoordSet(PyMOLGlobals * G,
   AtomName literal_name = "";
   int ok = true;
   lexidx_t segi_override_idx = LexIdx(G, segi_override);
+  const PDBAtomRecordOptions record_options = {
+      bool(literal_names), bool(truncate_resn),
+      info ? info->variant : PDB_VARIANT_DEFAULT};
 
   if(tags_in && (!quiet) && (!*restart_model)) {
     char *p = tags;
@@ -2318,42 +2542,44 @@ CoordSet *ObjectMoleculePDBStr2CoordSet(PyMOLGlobals * G,
 
     if(ok && AFlag && (!*restart_model)) {
       ai = atInfo + atomCount;
-      p = nskip(p, 6);
 
       ai->rank = atomCount;
 
+      PDBAtomRecord rec_parsed;
+      const PDBAtomRecord* rec = nullptr;
+
       if(info && info->is_pqr_file()) {
-        if (parse_pqr_atom_line(G, p, ai, coord + a)) {
+        const char* pp = nskip(p, 6);
+        if (parse_pqr_atom_line(G, pp, ai, coord + a)) {
+          p = pp;
           goto pqr_done;
         }
       }
 
-      p = ncopy(cc, p, 5);
-      if(!sscanf(cc, "%d", &ai->id))
-        ai->id = 0;
+      // pre-parsed in parallel, see ObjectMoleculePDBParseAtomRecords
+      if(info && info->atom_records)
+        rec = info->atom_records->find(p);
 
-      p = nskip(p, 1);          /* to 12 */
-      p = ncopy(literal_name, p, 4);
-      if(literal_names) {
-        LexAssign(G, ai->name, literal_name);
+      if(rec) {
+        p = nskip(p, 6);
       } else {
-        ParseNTrim(cc, literal_name, 4);
-        LexAssign(G, ai->name, cc);
+        p = parse_pdb_atom_record(p, rec_parsed, record_options,
+            info && info->is_pqr_file());
+        rec = &rec_parsed;
       }
 
-      p = ncopy(cc, p, 1);
-      if(*cc == 32)
+      ai->id = rec->id;
+      strcpy(literal_name, rec->literal_name);
+      LexAssign(G, ai->name, rec->name);
+
+      if(rec->alt == 32)
         ai->alt[0] = 0;
       else {
-        ai->alt[0] = *cc;
+        ai->alt[0] = rec->alt;
         ai->alt[1] = 0;
       }
 
-      p = ntrim(cc, p, 4); /* now allowing for 4-letter residues */
-      if (truncate_resn)        /* unless specifically disabled */
-        cc[3] = 0;
-
-      LexAssign(G, ai->resn, cc);
+      LexAssign(G, ai->resn, rec->resn);
 
       if(ai->name) {
         const char * ai_name = LexStr(G, ai->name);
@@ -2418,23 +2644,19 @@ CoordSet *ObjectMoleculePDBStr2CoordSet(PyMOLGlobals * G,
         }
       }
 
-      p = ncopy(cc, p, 1);
       if (ai->chain){
         LexDec(G, ai->chain);
       }
-      if(*cc == ' ') {
+      if(rec->chain[0] == ' ') {
         ss_chain1 = 0;
         ai->chain = 0;
       } else {
-        ss_chain1 = *cc;
-        ai->chain = LexIdx(G, cc);
+        ss_chain1 = rec->chain[0];
+        ai->chain = LexIdx(G, rec->chain);
       }
 
-      p = ncopy(cc, p, 4);
-      if(!sscanf(cc, "%d", &ai->resv))
-        ai->resv = 0;
-      ai->setInscode(*p);
-      p = nskip(p, 1);
+      ai->resv = rec->resv;
+      ai->setInscode(rec->inscode);
 
       if(ssFlag) {              /* get secondary structure information (if avail) */
         sshash_lookup(ss_hash, ai, ss_chain1);
@@ -2442,48 +2664,25 @@ CoordSet *ObjectMoleculePDBStr2CoordSet(PyMOLGlobals * G,
         ai->cartoon = cCartoon_tube;
       }
 
-      {
-        p = nskip(p, 3);
-        p = ncopy(cc, p, 8);
-        sscanf(cc, "%f", coord + a);
-        p = ncopy(cc, p, 8);
-        sscanf(cc, "%f", coord + (a + 1));
-        p = ncopy(cc, p, 8);
-        sscanf(cc, "%f", coord + (a + 2));
-      }
+      copy3f(rec->coord, coord + a);
 
       if((!info) || (!info->is_pqr_file())) {     /* standard PDB file */
-        p = ncopy(cc, p, 6);
-        if(!sscanf(cc, "%f", &ai->q))
-          ai->q = 1.0;
-
-        p = ncopy(cc, p, 6);
-        if(!sscanf(cc, "%f", &ai->b))
-          ai->b = 0.0;
+        ai->q = rec->q;
+        ai->b = rec->b;
 
         if (info->variant == PDB_VARIANT_PDBQT) {
           ignore_pdb_segi = true;
-          p = nskip(p, 4);
-          p = ncopy(cc, p, 6);
-          if(!sscanf(cc, "%f", &ai->partialCharge))
-            ai->partialCharge = 0.0;
-
-          // type is 78-79 in pdbqt, 77-78 in pdb
-          p = nskip(p, 1);
-        } else {
-          p = nskip(p, 6);
-          p = ncopy(cc, p, 4);
+          ai->partialCharge = rec->partialCharge;
         }
 
         if(!ignore_pdb_segi) {
           if(!segi_override_idx) {
-            if(cc[3] == '1' && atomCount && strncmp(p, "0000", 4) == 0) {
+            if(rec->segi_overflow && atomCount) {
               /* atom ID overflow? (nonstandard use...)... */
               LexAssign(G, segi_override_idx, (ai - 1)->segi);
               LexAssign(G, ai->segi,          (ai - 1)->segi);
             } else {
-              UtilCleanStr(cc);
-              LexAssign(G, ai->segi, cc);
+              LexAssign(G, ai->segi, rec->segi);
             }
           } else {
             LexAssign(G, ai->segi, segi_override_idx);
@@ -2492,24 +2691,7 @@ CoordSet *ObjectMoleculePDBStr2CoordSet(PyMOLGlobals * G,
           LexAssign(G, ai->segi, 0);
         }
 
-        p = ncopy(cc, p, 2);
-        if(!sscanf(cc, "%s", ai->elem))
-          ai->elem[0] = 0;
-        else if(!((((ai->elem[0] >= 'a') && (ai->elem[0] <= 'z')) ||    /* don't get confused by PDB misuse */
-                   ((ai->elem[0] >= 'A') && (ai->elem[0] <= 'Z'))) &&
-                  (((ai->elem[1] == 0) ||
-                    ((ai->elem[1] >= 'a') && (ai->elem[1] <= 'z')) ||
-                    ((ai->elem[1] >= 'A') && (ai->elem[1] <= 'Z'))))))
-          ai->elem[0] = 0;
-        else if (info->variant == PDB_VARIANT_PDBQT) {
-          if (strcmp(ai->elem, "A") == 0) {
-            // aromatic carbon
-            ai->elem[0] = 'C';
-          } else if (isupper(ai->elem[1])) {
-            // h-bond donor or acceptor
-            ai->elem[1] = 0;
-          }
-        }
+        strcpy(ai->elem, rec->elem);
 
         if(!ai->elem[0]) {
           if(((literal_name[0] == ' ') || ((literal_name[0] >= '0') && (literal_name[0] <= '9'))) && (literal_name[1] >= 'A') && (literal_name[1] <= 'Z')) {    /* infer element from name column */
@@ -2534,15 +2716,8 @@ CoordSet *ObjectMoleculePDBStr2CoordSet(PyMOLGlobals * G,
           }
         }
 
-        p = ncopy(cc, p, 2);
-        if((cc[1] == '-') || (cc[1] == '+')) {
-          /* only read formal charge when sign is present */
-          char ctmp = cc[0];
-          cc[0] = cc[1];
-          cc[1] = ctmp;
-          if(!sscanf(cc, "%hhi", &ai->formalCharge))
-            ai->formalCharge = 0;
-        }
+        if(rec->has_formal_charge)
+          ai->formalCharge = rec->formalCharge;
 
         /* end normal PDB */
       } else if(info && info->is_pqr_file()) {
@@ -2848,7 +3023,7 @@ static int ObjectMoleculeFindBestDonorH(ObjectMolecule * I,
   float cand[3], cand_dir[3];
   float best_dot = 0.0F, cand_dot;
 
-  if((state >= 0) && (state < I->NCSet) && (cs = I->CSet[state]) && (atom < I->NAtom)) {
+  if((state >= 0) && (state < I->NCSet) && (cs = I->getCoordSet(state)) && (atom < I->NAtom)) {
 
     auto idx = cs->atmToIdx(atom);
 
@@ -2929,10 +3104,10 @@ int ObjectMoleculeGetCheckHBond(AtomInfoType **h_real,
 
   if((don_state >= 0) &&
      (don_state < don_obj->NCSet) &&
-     (csD = don_obj->CSet[don_state]) &&
+     (csD = don_obj->getCoordSet(don_state)) &&
      (acc_state >= 0) &&
      (acc_state < acc_obj->NCSet) &&
-     (csA = acc_obj->CSet[acc_state]) &&
+     (csA = acc_obj->getCoordSet(acc_state)) &&
      (don_atom < don_obj->NAtom) && (acc_atom < acc_obj->NAtom)) {
 
     /* now check for coordinates of these actual atoms */
@@ -2997,6 +3172,11 @@ static PyObject *ObjectMoleculeCSetAsPyList(ObjectMolecule * I)
   int a;
   result = PyList_New(I->NCSet);
   for(a = 0; a < I->NCSet; a++) {
+    if(I->TrajStream) {
+      /* sessions don't refer to the trajectory files, store all states */
+      I->TrajStream->trim(I);
+      I->TrajStream->fetch(I, a);
+    }
     if(I->CSet[a]) {
       PyList_SetItem(result, a, CoordSetAsPyList(I->CSet[a]));
     } else {
@@ -3107,7 +3287,7 @@ static int ObjectMoleculeBondFromPyList(ObjectMolecule * I, PyObject * list)
     // checking if from pse_binary_dump
     // pse_binary_dump saves 2 values: bondInfo_version, BondType binary
     CPythonVal *val1 = CPythonVal_PyList_GetItem(G, list, 1);
-    pse_binary_dump = PyBytes_Check(val1);
+    pse_binary_dump = PyBinary_Check(val1);
     CPythonVal_Free(val1);
   }
   if (pse_binary_dump){
@@ -3116,7 +3296,7 @@ static int ObjectMoleculeBondFromPyList(ObjectMolecule * I, PyObject * list)
     ok = PConvPyIntToInt(verobj, &bondInfo_version);
 
     CPythonVal *strobj = CPythonVal_PyList_GetItem(G, list, 1);
-    auto strval = PyBytes_AsSomeString(strobj);
+    auto strval = PyBinary_AsSomeString(strobj);
 
     if(ok)
       ok = bool((I->Bond = pymol::vla<BondType>(I->NBond)));
@@ -3361,7 +3541,7 @@ static int ObjectMoleculeAtomFromPyList(ObjectMolecule * I, PyObject * list)
     // pse_binary_dump saves 3 values: atomInfo_version, AtomInfo binary, and strings array
     CPythonVal *val1 = CPythonVal_PyList_GetItem(G, list, 1);
     CPythonVal *val2 = CPythonVal_PyList_GetItem(G, list, 2);
-    pse_binary_dump = PyBytes_Check(val1) && PyBytes_Check(val2);
+    pse_binary_dump = PyBinary_Check(val1) && PyBinary_Check(val2);
     CPythonVal_Free(val1);
     CPythonVal_Free(val2);
   }
@@ -3371,7 +3551,7 @@ static int ObjectMoleculeAtomFromPyList(ObjectMolecule * I, PyObject * list)
     ok = PConvPyIntToInt(verobj, &atomInfo_version);
 
     CPythonVal *strlookupobj = CPythonVal_PyList_GetItem(G, list, 2);
-    auto strval_1 = PyBytes_AsSomeString(strlookupobj);
+    auto strval_1 = PyBinary_AsSomeString(strlookupobj);
     int *strval = (int*)strval_1.data();
 
     AtomInfoTypeConverter converter(G, I->NAtom);
@@ -3392,7 +3572,7 @@ static int ObjectMoleculeAtomFromPyList(ObjectMolecule * I, PyObject * list)
     }
 
     CPythonVal *strobj = CPythonVal_PyList_GetItem(G, list, 1);
-    auto strval_2 = PyBytes_AsSomeString(strobj);
+    auto strval_2 = PyBinary_AsSomeString(strobj);
 
     VLACheck(I->AtomInfo, AtomInfoType, I->NAtom + 1);
     converter.copy(I->AtomInfo.data(), strval_2.data(), atomInfo_version);
@@ -4042,7 +4222,7 @@ int ObjectMoleculeSort(ObjectMolecule * I)
 {                               /* sorts atoms and bonds */
   int *index;
   int *outdex = NULL;
-  int a, b;
+  int a;
   int ok = true;
   if(!I->DiscreteFlag) {        /* currently, discrete objects are never sorted */
     int already_in_order = true;
@@ -4064,16 +4244,9 @@ int ObjectMoleculeSort(ObjectMolecule * I)
         I->Bond[a].index[1] = outdex[I->Bond[a].index[1]];
       }
 
-      for(a = -1; a < I->NCSet; a++) {  /* coordinate set mapping */
-        auto* cs = (a < 0) ? I->CSTmpl : I->CSet[a];
-
-        if(cs) {
-          int cs_NIndex = cs->NIndex;
-          int *cs_IdxToAtm = cs->IdxToAtm.data();
-          for(b = 0; b < cs_NIndex; b++)
-            cs_IdxToAtm[b] = outdex[cs_IdxToAtm[b]];
-        }
-      }
+      /* coordinate set mapping */
+      CoordSetRemapIdxToAtm(&I->CSTmpl, 1, outdex);
+      CoordSetRemapIdxToAtm(I->CSet.data(), I->NCSet, outdex);
 
       I->updateAtmToIdx();
 
@@ -92,7 +92,7 @@ void ObjectMoleculePBCUnwrap(ObjectMolecule& objmol, bool const bymol)
 
   for (StateIndex_t state = 0; state != objmol.NCSet;
        ++state, cs_prev = cs_curr) {
-    cs_curr = objmol.CSet[state];
+    cs_curr = objmol.pinCoordSet(state);
     if (!cs_curr)
       continue;
 
@@ -166,7 +166,7 @@ void ObjectMoleculePBCUnwrap(ObjectMolecule& objmol, bool const bymol)
   }
 
   for (StateIndex_t state = 0; state != objmol.NCSet; ++state) {
-    cs_curr = objmol.CSet[state];
+    cs_curr = objmol.pinCoordSet(state);
     if (!cs_curr)
       continue;
 
@@ -192,7 +192,7 @@ void ObjectMoleculePBCWrap(ObjectMolecule& objmol, float const* center)
   auto const molecules = ObjectMoleculeGetMolMappingMap(objmol);
 
   for (StateIndex_t state = 0; state != objmol.NCSet; ++state) {
-    auto* cs = objmol.CSet[state];
+    auto* cs = objmol.pinCoordSet(state);
     if (!cs)
       continue;
 
@@ -372,7 +372,9 @@ static CField * ObjectVolumeStateGetField(ObjectVolumeState * vs) {
     return NULL;
   if(vs->Field)
     return vs->Field->data.get();
-  return ObjectVolumeStateGetMapState(vs)->Field->data.get();
+  auto field = ObjectVolumeStateGetMapState(vs)->Field.get();
+  IsofieldDecode(vs->G, field);
+  return field->data.get();
 }
 
 CField * ObjectVolumeGetField(ObjectVolume * I) {
@@ -1186,7 +1188,7 @@ ObjectVolume *ObjectVolumeFromXtalSym(PyMOLGlobals * G, ObjectVolume * obj, Obje
           vs->Field = pymol::make_copyable<Isofield>(I->G, fdim);
 
           expand_result =
-            IsosurfExpand(oms->Field.get(), vs->Field.get(), &oms->Symmetry->Crystal, sym, eff_range);
+            IsosurfExpand(G, oms->Field.get(), vs->Field.get(), &oms->Symmetry->Crystal, sym, eff_range);
 
           if(expand_result == 0) {
             if(!quiet) {
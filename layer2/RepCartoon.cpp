@@ -16,7 +16,10 @@ I* Additional authors of this source file include:
 Z* -------------------------------------------------------------------
 */
 
+#include <climits>
+#include <memory>
 #include <set>
+#include <vector>
 
 #include"os_predef.h"
 #include"os_std.h"
@@ -34,6 +37,7 @@ Z* -------------------------------------------------------------------
 #include"ShaderMgr.h"
 #include "Lex.h"
 #include "CoordSet.h"
+#include "TaskPool.h"
 
 #include "AtomIterators.h"
 
@@ -2407,6 +2411,137 @@ static int GetCartoonQuality(CoordSet * cs, int setting, int v1, int v2, int v3,
   return quality;
 }
 
+/* minimum number of atoms per chunk of segments in GenerateRepCartoonCGO,
+   with more than one worker */
+#define CARTOON_CHUNK_ATOMS 128
+
+/**
+ * Atoms [a_begin, a_end) of the cartoon path, covering whole segments.
+ * contigFlag is the value it has at a_begin in a serial walk of the path.
+ */
+struct CartoonChunk {
+  int a_begin, a_end;
+  int contigFlag;
+};
+
+/**
+ * Splits the cartoon path into chunks which can be extruded independently.
+ * Replays the control flow of the extrusion walk in GenerateRepCartoonCGO
+ * (without any geometry) and starts a new chunk at a segment start where
+ * the walk carries no points over from the previous segment. Points are
+ * carried over within skipped stretches, which is why not every segment
+ * start qualifies.
+ * @param min_atoms Minimum number of atoms per chunk
+ */
+static std::vector<CartoonChunk> CartoonSplitChunks(
+    int nAt, const int* seg, const CCInOut* car, int min_atoms)
+{
+  std::vector<CartoonChunk> chunks;
+  CartoonChunk chunk{0, 0, false};
+  int cur_car = cCartoon_skip;
+  int contigFlag = false;
+  bool extrudeFlag = false;
+  bool has_points = false;
+
+  for (int a = 0; a < nAt;) {
+    if (!has_points && a - chunk.a_begin >= min_atoms &&
+        seg[a] != seg[a - 1]) {
+      chunk.a_end = a;
+      chunks.push_back(chunk);
+      chunk = {a, a, contigFlag};
+    }
+
+    /* see CheckExtrudeContigFlags */
+    const bool same_seg = a < (nAt - 1) && seg[a] == seg[a + 1];
+    const int next_car = same_seg
+                             ? prioritize(car[a].getCCOut(), car[a + 1].getCCIn())
+                             : int(cCartoon_skip);
+
+    if (cur_car != next_car) {
+      if (has_points) {
+        extrudeFlag = true;
+      } else {
+        cur_car = next_car;
+      }
+    }
+
+    if (!extrudeFlag && same_seg) {
+      has_points = true;
+    }
+
+    if (extrudeFlag) {
+      /* extrude and revisit this atom */
+      contigFlag = !(a > 0 && seg[a - 1] != seg[a]);
+      extrudeFlag = false;
+      has_points = false;
+    } else {
+      ++a;
+    }
+  }
+
+  chunk.a_end = nAt;
+  chunks.push_back(chunk);
+  return chunks;
+}
+
+/**
+ * Clears the current pick color of a new chunk CGO, so that its first
+ * CGOPickColor is always written (see CartoonAppendChunk)
+ */
+static void CartoonResetPickColor(CGO* cgo)
+{
+  cgo->current_pick_color_index = (unsigned int) -2;
+  cgo->current_pick_color_bond = cPickableNoPick;
+}
+
+/**
+ * Appends a chunk CGO to the cartoon CGO. The result is identical to
+ * extruding the chunk directly into `cgo`: a leading pick color which
+ * `cgo` already has is dropped, like CGOPickColor would have done, and
+ * the current color, normal, alpha and pick color are carried over.
+ */
+static void CartoonAppendChunk(CGO* cgo, const CGO* chunk)
+{
+  bool first_pick = true;
+
+  for (auto it = chunk->begin(); !it.is_stop(); ++it) {
+    const auto pc = it.data();
+    const int op = it.op_code();
+
+    switch (op) {
+    case CGO_PICK_COLOR:
+      if (first_pick) {
+        first_pick = false;
+        if (CGO_get_uint(pc) == cgo->current_pick_color_index &&
+            CGO_get_int(pc + 1) == cgo->current_pick_color_bond)
+          continue;
+      }
+      break;
+    case CGO_COLOR:
+      copy3f(pc, cgo->color);
+      break;
+    case CGO_NORMAL:
+      copy3f(pc, cgo->normal);
+      break;
+    case CGO_ALPHA:
+      cgo->alpha = *pc;
+      break;
+    }
+
+    cgo->add_to_cgo(op, pc);
+  }
+
+  if (!first_pick) {
+    cgo->current_pick_color_index = chunk->current_pick_color_index;
+    cgo->current_pick_color_bond = chunk->current_pick_color_bond;
+  }
+
+  cgo->has_begin_end |= chunk->has_begin_end;
+  cgo->has_draw_buffers |= chunk->has_draw_buffers;
+  cgo->has_draw_cylinder_buffers |= chunk->has_draw_cylinder_buffers;
+  cgo->has_draw_sphere_buffers |= chunk->has_draw_sphere_buffers;
+}
+
 static
 CGO *GenerateRepCartoonCGO(CoordSet *cs, ObjectMolecule *obj, nuc_acid_data *ndata, short use_cylinders_for_strands,
                            float *pv, int nAt, float *tv, float *pvo,
@@ -2417,22 +2552,8 @@ CGO *GenerateRepCartoonCGO(CoordSet *cs, ObjectMolecule *obj, nuc_acid_data *nda
   PyMOLGlobals *G = cs->G;
   int ok = true;
   CGO *cgo;
-  int contigFlag, contFlag, extrudeFlag, n_p;
   CExtrude *ex = NULL;
-  float dev;
-  unsigned int *vi;
-  int atom_index1, atom_index2;
-  float *v, *v1, *v2, *vo;
-  float *d, *vc = NULL, *vn;
-  float *valpha = nullptr;
-  int *atp;
-  int c1, c2;
-  int a;
   int sampling;
-  float *sampling_tmp;
-  int *segptr;
-  const CCInOut *cc;
-  int cur_car;
   float loop_radius;
   int nucleic_color = 0;
   float throw_;
@@ -2448,16 +2569,6 @@ CGO *GenerateRepCartoonCGO(CoordSet *cs, ObjectMolecule *obj, nuc_acid_data *nda
   float dumbbell_radius, dumbbell_width, dumbbell_length;
   float ring_width;
 
-  auto EXTRUDE_TRUNCATE = [&ex, &n_p, &v, &vc, &valpha, &vn, &vi]() {
-    ExtrudeTruncate(ex, 0);
-    n_p = 0;
-    v = ex->p;
-    vc = ex->c;
-    valpha = ex->alpha;
-    vn = ex->n;
-    vi = ex->i;
-  };
-
   cartoon_color =
     SettingGet_color(G, cs->Setting.get(), obj->Setting.get(), cSetting_cartoon_color);
   ring_width =
@@ -2529,7 +2640,6 @@ CGO *GenerateRepCartoonCGO(CoordSet *cs, ObjectMolecule *obj, nuc_acid_data *nda
     SettingGet_i(G, cs->Setting.get(), obj->Setting.get(), cSetting_cartoon_cylindrical_helices);
   int const sampling_cylindrical_helices = sampling / 8 + 1;
 
-  sampling_tmp = pymol::malloc<float>(sampling * 3);
   cartoon_debug = SettingGet_i(G, cs->Setting.get(), obj->Setting.get(), cSetting_cartoon_debug);
 
   cgo = CGONew(G);
@@ -2543,7 +2653,7 @@ CGO *GenerateRepCartoonCGO(CoordSet *cs, ObjectMolecule *obj, nuc_acid_data *nda
     " RepCartoon-Debug: creating 3D scaffold...\n" ENDFD;
 
   /* okay, we now have enough info to generate smooth interpolations */
-  if(nAt > 1) {
+  if((nAt > 1) && cylindrical_helices == CARTOON_CYLINDRICAL_HELICES_STRAIGHT) {
     ex = ExtrudeNew(G);
     CHECKOK(ok, ex);
     if (ok)
@@ -2555,136 +2665,199 @@ CGO *GenerateRepCartoonCGO(CoordSet *cs, ObjectMolecule *obj, nuc_acid_data *nda
                                                      pvo, car, at, dl, cartoon_color, discrete_colors, loop_radius, alpha);
   }
   if(ok && nAt > 1) {
-    EXTRUDE_TRUNCATE();
-    v1 = pv;                    /* points */
-    v2 = tv;                    /* tangents */
-    vo = pvo;
-    d = dl;
-    segptr = seg;
-    cc = car;
-    atp = at;                   /* cs index pointer */
-    a = 0;
-    contFlag = true;
-    cur_car = cCartoon_skip;
-    extrudeFlag = false;
-    contigFlag = false;
-
     const auto helix_radius = SettingGet<float>(
         G, cs->Setting.get(), obj->Setting.get(), cSetting_cartoon_helix_radius);
 
-    while(contFlag) {
-      if (CheckExtrudeContigFlags(nAt, n_p, a, &cur_car, cc, segptr, &contigFlag, &extrudeFlag)){
-        EXTRUDE_TRUNCATE();
-      }
+    /* extrudes the atoms [a_begin, a_end), which must be whole segments.
+       contigFlag is the state the serial walk would have at a_begin. */
+    auto extrude_chunk = [&](CGO *cgo, CExtrude *ex, float *sampling_tmp,
+                             int a_begin, int a_end, int contigFlag) -> int {
+      int ok = true;
+      int contFlag, extrudeFlag, n_p;
+      float dev;
+      unsigned int *vi;
+      int atom_index1, atom_index2;
+      float *v, *v1, *v2, *vo;
+      float *d, *vc, *vn;
+      float *valpha;
+      int *atp;
+      int c1, c2;
+      int a;
+      int *segptr;
+      const CCInOut *cc;
+      int cur_car;
+      const int n_chunk = a_end - a_begin;
+
+      auto EXTRUDE_TRUNCATE = [&ex, &n_p, &v, &vc, &valpha, &vn, &vi]() {
+        ExtrudeTruncate(ex, 0);
+        n_p = 0;
+        v = ex->p;
+        vc = ex->c;
+        valpha = ex->alpha;
+        vn = ex->n;
+        vi = ex->i;
+      };
+
+      EXTRUDE_TRUNCATE();
+      v1 = pv + 3 * a_begin;    /* points */
+      v2 = tv + 3 * a_begin;    /* tangents */
+      vo = pvo + 3 * a_begin;
+      d = dl + a_begin;
+      segptr = seg + a_begin;
+      cc = car + a_begin;
+      atp = at + a_begin;       /* cs index pointer */
+      a = 0;
+      contFlag = true;
+      cur_car = cCartoon_skip;
+      extrudeFlag = false;
 
-      if(ok && !extrudeFlag) {
-        if((a < (nAt - 1)) && (*segptr == *(segptr + 1))) {       /* working in the same segment... */
-          AtomInfoType *ai1, *ai2;
-          atom_index1 = cs->IdxToAtm[*atp];
-          atom_index2 = cs->IdxToAtm[*(atp + 1)];
-          ai1 = obj->AtomInfo + atom_index1;
-          ai2 = obj->AtomInfo + atom_index2;
+      while(contFlag) {
+        if (CheckExtrudeContigFlags(n_chunk, n_p, a, &cur_car, cc, segptr, &contigFlag, &extrudeFlag)){
+          EXTRUDE_TRUNCATE();
+        }
 
-          float alpha1 = alpha;
-          float alpha2 = alpha;
+        if(ok && !extrudeFlag) {
+          if((a < (n_chunk - 1)) && (*segptr == *(segptr + 1))) {       /* working in the same segment... */
+            AtomInfoType *ai1, *ai2;
+            atom_index1 = cs->IdxToAtm[*atp];
+            atom_index2 = cs->IdxToAtm[*(atp + 1)];
+            ai1 = obj->AtomInfo + atom_index1;
+            ai2 = obj->AtomInfo + atom_index2;
 
-          ComputeCartoonAtomColors(G, obj, cs, nuc_flag, atom_index1, atom_index2, &c1, &c2, atp, cc, cur_car, cartoon_color, alpha1, alpha2, nucleic_color, discrete_colors, n_p, contigFlag);
-          dev = throw_ * (*d);
+            float alpha1 = alpha;
+            float alpha2 = alpha;
 
-          auto const cur_sampling = (cur_car == cCartoon_cylinder)
-                                        ? sampling_cylindrical_helices
-                                        : sampling;
+            ComputeCartoonAtomColors(G, obj, cs, nuc_flag, atom_index1, atom_index2, &c1, &c2, atp, cc, cur_car, cartoon_color, alpha1, alpha2, nucleic_color, discrete_colors, n_p, contigFlag);
+            dev = throw_ * (*d);
 
-          CartoonGenerateSample(G, cur_sampling, &n_p, dev, vo, v1, v2, c1, c2,
-              alpha1, alpha2, ai1->masked ? -1 : atom_index1,
-              ai2->masked ? -1 : atom_index2, power_a, power_b, &vc, &valpha,
-              &vi, &v, &vn);
+            auto const cur_sampling = (cur_car == cCartoon_cylinder)
+                                          ? sampling_cylindrical_helices
+                                          : sampling;
 
-          /* now do a smoothing pass along orientation 
-             vector to smooth helices, etc... */
-          CartoonGenerateRefine(refine, cur_sampling, v, vn, vo, sampling_tmp);
-        }
-        v1 += 3;
-        v2 += 3;
-        vo += 3;
-        d++;
-        atp += 1;
-        segptr++;
-        cc++;
-      }
+            CartoonGenerateSample(G, cur_sampling, &n_p, dev, vo, v1, v2, c1, c2,
+                alpha1, alpha2, ai1->masked ? -1 : atom_index1,
+                ai2->masked ? -1 : atom_index2, power_a, power_b, &vc, &valpha,
+                &vi, &v, &vn);
 
-      a++;
-      if(a == nAt) {  // if at end, don't continue and extrude if needed
-        contFlag = false;
-        if(n_p)
-          extrudeFlag = true;
-      }
-      if(ok && extrudeFlag) {
-        contigFlag = true;
-        if((a < nAt) && extrudeFlag) {
-          if(*(segptr - 1) != *(segptr))
-            contigFlag = false;
+            /* now do a smoothing pass along orientation 
+               vector to smooth helices, etc... */
+            CartoonGenerateRefine(refine, cur_sampling, v, vn, vo, sampling_tmp);
+          }
+          v1 += 3;
+          v2 += 3;
+          vo += 3;
+          d++;
+          atp += 1;
+          segptr++;
+          cc++;
         }
 
-        if(ok && (cur_car != cCartoon_skip) && (cur_car != cCartoon_skip_helix)) {
-          if((cartoon_debug > 0.5) && (cartoon_debug < 2.5)) {
-            ok = GenerateRepCartoonDrawDebugNormals(cgo, ex, n_p);
+        a++;
+        if(a == n_chunk) {  // if at end, don't continue and extrude if needed
+          contFlag = false;
+          if(n_p)
+            extrudeFlag = true;
+        }
+        if(ok && extrudeFlag) {
+          contigFlag = true;
+          if((a < n_chunk) && extrudeFlag) {
+            if(*(segptr - 1) != *(segptr))
+              contigFlag = false;
           }
 
-          if (ok){
-            ExtrudeTruncate(ex, n_p);
-            ok &= ExtrudeComputeTangents(ex);
-          }
-          if (ok){
-          /* set up shape */
-          switch (cur_car) {
-          case cCartoon_tube:
-            ok = CartoonExtrudeTube(use_cylinders_for_strands, ex, cgo, tube_radius, tube_quality, tube_cap);
-            break;
-          case cCartoon_putty:
-            ok = CartoonExtrudePutty(G, obj, cs, cgo, ex, putty_quality, putty_radius, putty_vals, sampling);
+          if(ok && (cur_car != cCartoon_skip) && (cur_car != cCartoon_skip_helix)) {
+            if((cartoon_debug > 0.5) && (cartoon_debug < 2.5)) {
+              ok = GenerateRepCartoonDrawDebugNormals(cgo, ex, n_p);
+            }
+
+            if (ok){
+              ExtrudeTruncate(ex, n_p);
+              ok &= ExtrudeComputeTangents(ex);
+            }
+            if (ok){
+            /* set up shape */
+            switch (cur_car) {
+            case cCartoon_tube:
+              ok = CartoonExtrudeTube(use_cylinders_for_strands, ex, cgo, tube_radius, tube_quality, tube_cap);
+              break;
+            case cCartoon_putty:
+              ok = CartoonExtrudePutty(G, obj, cs, cgo, ex, putty_quality, putty_radius, putty_vals, sampling);
+              if (!ok)
+                contFlag = false;
+              break;
+            case cCartoon_loop:
+              ok = CartoonExtrudeCircle(ex, cgo, use_cylinders_for_strands, loop_quality, loop_radius, loop_cap);
+              break;
+            case cCartoon_dash:
+              ok = CartoonExtrudeCircle(ex, cgo, use_cylinders_for_strands, loop_quality, loop_radius, loop_cap, 2);
+              break;
+            case cCartoon_rect:
+              ok = CartoonExtrudeRect(G, ex, cgo, width, length, highlight_color);
+              break;
+            case cCartoon_oval:
+              ok = CartoonExtrudeOval(G, ex, cgo, use_cylinders_for_strands, oval_quality, oval_width, oval_length, highlight_color);
+              break;
+            case cCartoon_arrow:
+              ok = CartoonExtrudeArrow(G, ex, cgo, sampling, width, length, highlight_color);
+              break;
+            case cCartoon_dumbbell:
+              ok = CartoonExtrudeDumbbell(G, ex, cgo, sampling, dumbbell_width, dumbbell_length, highlight_color, loop_quality, dumbbell_radius, use_cylinders_for_strands);
+              break;
+            case cCartoon_cylinder:
+              CartoonExtrudeCurvedCylindricalHelix(ex, cgo, loop_quality * 2,
+                  helix_radius, sampling_cylindrical_helices);
+              break;
+            }
             if (!ok)
               contFlag = false;
-            break;
-          case cCartoon_loop:
-            ok = CartoonExtrudeCircle(ex, cgo, use_cylinders_for_strands, loop_quality, loop_radius, loop_cap);
-            break;
-          case cCartoon_dash:
-            ok = CartoonExtrudeCircle(ex, cgo, use_cylinders_for_strands, loop_quality, loop_radius, loop_cap, 2);
-            break;
-          case cCartoon_rect:
-            ok = CartoonExtrudeRect(G, ex, cgo, width, length, highlight_color);
-            break;
-          case cCartoon_oval:
-            ok = CartoonExtrudeOval(G, ex, cgo, use_cylinders_for_strands, oval_quality, oval_width, oval_length, highlight_color);
-            break;
-          case cCartoon_arrow:
-            ok = CartoonExtrudeArrow(G, ex, cgo, sampling, width, length, highlight_color);
-            break;
-          case cCartoon_dumbbell:
-            ok = CartoonExtrudeDumbbell(G, ex, cgo, sampling, dumbbell_width, dumbbell_length, highlight_color, loop_quality, dumbbell_radius, use_cylinders_for_strands);
-            break;
-          case cCartoon_cylinder:
-            CartoonExtrudeCurvedCylindricalHelix(ex, cgo, loop_quality * 2,
-                helix_radius, sampling_cylindrical_helices);
-            break;
+            }
           }
-          if (!ok)
-            contFlag = false;
+          a--;                    /* undo above... */
+          extrudeFlag = false;
+          if (ok){
+            EXTRUDE_TRUNCATE();  // doesn't include vi = ex->i, not used?
           }
         }
-        a--;                    /* undo above... */
-        extrudeFlag = false;
-        if (ok){
-          EXTRUDE_TRUNCATE();  // doesn't include vi = ex->i, not used?
-        }
-        /*
-          ExtrudeTruncate(ex, 0);
-        n_p = 0;
-        v = ex->p;
-        vc = ex->c;
-        vn = ex->n;*/
       }
+      return ok;
+    };
+
+    /* a single worker walks the whole path in one chunk */
+    const auto chunks = CartoonSplitChunks(nAt, seg, car,
+        pymol::parallel_workers(G) > 1 ? CARTOON_CHUNK_ATOMS : INT_MAX);
+
+    /* extrude the chunks into separate CGOs (in parallel), then append
+       them in segment order */
+    std::vector<std::unique_ptr<CGO>> chunk_cgos(chunks.size());
+    std::vector<int> chunk_ok(chunks.size(), false);
+
+    pymol::parallel_for(G, chunks.size(), 1,
+        [&](std::size_t begin, std::size_t end, unsigned) {
+          std::vector<float> sampling_tmp(sampling * 3);
+          for (auto i = begin; i < end; ++i) {
+            const auto& chunk = chunks[i];
+            CExtrude *chunk_ex = ExtrudeNew(G);
+            if (!chunk_ex ||
+                !ExtrudeAllocPointsNormalsColors(chunk_ex,
+                    (chunk.a_end - chunk.a_begin) * (3 * sampling + 3))) {
+              if (chunk_ex)
+                ExtrudeFree(chunk_ex);
+              continue;
+            }
+            chunk_cgos[i].reset(CGONew(G));
+            CartoonResetPickColor(chunk_cgos[i].get());
+            chunk_ok[i] = extrude_chunk(chunk_cgos[i].get(), chunk_ex,
+                sampling_tmp.data(), chunk.a_begin, chunk.a_end,
+                chunk.contigFlag);
+            CGOStop(chunk_cgos[i].get());
+            ExtrudeFree(chunk_ex);
+          }
+        });
+
+    for (std::size_t i = 0; ok && i < chunks.size(); ++i) {
+      ok = chunk_ok[i];
+      if (ok)
+        CartoonAppendChunk(cgo, chunk_cgos[i].get());
     }
   }
 
@@ -2703,8 +2876,6 @@ CGO *GenerateRepCartoonCGO(CoordSet *cs, ObjectMolecule *obj, nuc_acid_data *nda
   if (ok)
     CGOStop(cgo);
 
-  FreeP(sampling_tmp);
-
   if (!ok){
     CGOFree(cgo);
   }
@@ -41,11 +41,21 @@ Z* -------------------------------------------------------------------
 #include"ShaderMgr.h"
 #include"Rep.h"
 #include"CoordSet.h"
+#include"TaskPool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
 
 #ifdef NT
 #undef NT
 #endif
 
+struct SurfacePointCache;
+
 struct RepSurface : Rep {
   using Rep::Rep;
 
@@ -88,6 +98,10 @@ struct RepSurface : Rep {
   bool dot_as_spheres = false;
 
   int surface_mode = cRepSurface_by_flags;
+
+  /// Surface points by solvent dot, for incremental updates
+  /// (surface_incremental). Never modified, so states can share it.
+  std::shared_ptr<const SurfacePointCache> pointCache;
 };
 
 static
@@ -136,6 +150,14 @@ struct SolventDot {
   int* dotCode{};
 };
 
+/**
+ * Dots (and normals) generated by one chunk of a parallel loop.
+ */
+struct SolventDotChunk {
+  std::vector<float> dot;
+  std::vector<float> normal;
+};
+
 typedef struct {
   float vdw;
   int flags;
@@ -3080,11 +3102,37 @@ static int SurfaceJobEliminateCloseDotsType3orMore(PyMOLGlobals * G,
     float *v = I->V;
     float *vn = I->VN;
     float min_dot = 0.1F;
+    std::vector<char> has_close(I->N);
     CHECKOK(ok, map);
     if (ok)
       ok &= MapSetupExpress(map);
+    if (ok && pymol::parallel_workers(G) < 2) {
+      std::fill(has_close.begin(), has_close.end(), true);
+    } else if (ok) {
+      /* a dot only merges with dots j > a, which are not yet moved before
+         its turn, so dots without any candidate can be skipped below */
+      pymol::parallel_for(G, I->N, 1024,
+          [&](std::size_t begin, std::size_t end, unsigned) {
+            float diff[3], dist;
+            for(int a = begin; a < int(end) && !G->Interrupt; a++) {
+              const float *va = I->V + 3 * a;
+              int i = *(MapLocusEStart(map, va));
+              if(i && map->EList) {
+                for(int j = map->EList[i++]; j >= 0; j = map->EList[i++]) {
+                  if(j > a &&
+                     dot_product3f(I->VN + (3 * j), I->VN + (3 * a)) > min_dot &&
+                     within3fret(I->V + (3 * j), va, point_sep, min_sep2, diff, &dist)) {
+                    has_close[a] = true;
+                    break;
+                  }
+                }
+              }
+            }
+          });
+      ok &= !G->Interrupt;
+    }
     for(a = 0; ok && a < I->N; a++) {
-      if(dot_flag[a]) {
+      if(dot_flag[a] && has_close[a]) {
 	int i = *(MapLocusEStart(map, v));
 	if(i && map->EList) {
 	  int j = map->EList[i++];
@@ -3139,17 +3187,43 @@ static int SurfaceJobEliminateCloseDotsTypeLessThan3(PyMOLGlobals * G,
   float *v = I->V;
   float *vn = I->VN;
 
+  std::vector<char> has_close(I->N);
+
   CHECKOK(ok, map);
   if (ok){
     for(a = 0; a < I->N; a++)
       dot_flag[a] = 1;
     ok &= MapSetupExpress(map);
   }
+  if (ok && pymol::parallel_workers(G) < 2) {
+    std::fill(has_close.begin(), has_close.end(), true);
+  } else if (ok) {
+    /* dots with no other dot in reach stay untouched, unless a dot of
+       their neighborhood moves (flagged below) */
+    pymol::parallel_for(G, I->N, 1024,
+        [&](std::size_t begin, std::size_t end, unsigned) {
+          for(int a = begin; a < int(end) && !G->Interrupt; a++) {
+            const float *va = I->V + 3 * a;
+            int i = *(MapLocusEStart(map, va));
+            if(i && map->EList) {
+              for(int j = map->EList[i++]; j >= 0; j = map->EList[i++]) {
+                if(j != a && within3f(I->V + (3 * j), va, point_sep)) {
+                  has_close[a] = true;
+                  break;
+                }
+              }
+            }
+          }
+        });
+    ok &= !G->Interrupt;
+  }
   for(a = 0; ok && a < I->N; a++) {
-    if(dot_flag[a]) {
-      int i = *(MapLocusEStart(map, v));
-      if(i && map->EList) {
+    if(dot_flag[a] && has_close[a]) {
+      int i0 = *(MapLocusEStart(map, v));
+      if(i0 && map->EList) {
+	int i = i0;
 	int j = map->EList[i++];
+	bool moved = false;
 	while(j >= 0) {
 	  if(j != a) {
 	    if(dot_flag[j]) {
@@ -3158,11 +3232,19 @@ static int SurfaceJobEliminateCloseDotsTypeLessThan3(PyMOLGlobals * G,
 		add3f(vn, I->VN + (3 * j), vn);
 		average3f(I->V + (3 * j), v, v);
 		*repeat_flag = true;
+		moved = true;
 	      }
 	    }
 	  }
 	  j = map->EList[i++];
 	}
+	if(moved) {
+	  /* the dots which find this one in their map cells must look again */
+	  for(i = i0, j = map->EList[i++]; j >= 0; j = map->EList[i++]) {
+	    if(j > a)
+	      has_close[j] = true;
+	  }
+	}
       }
     }
     v += 3;
@@ -3228,47 +3310,73 @@ static int SurfaceJobEliminateCloseDots(PyMOLGlobals * G, SurfaceJob * I){
 /* For each vertex, lookup all vertices within the neighborhood, and sum the dot_product of the normals.  
    If the average of the dot_products of the normals is less than the trim_cutoff,
    then the middle vertex is eliminated. */
+static bool SurfaceJobIsTroublesomeVertex(SurfaceJob * I, MapType *map,
+    const int *dot_flag, int a, float neighborhood, float trim_cutoff)
+{
+  const float *v = I->V + 3 * a;
+  const float *vn = I->VN + 3 * a;
+  int i = *(MapLocusEStart(map, v));
+  if(i && map->EList) {
+    int j = map->EList[i++];
+    int n_nbr = 0;
+    float dot_sum = 0.0F;
+    while(j >= 0) {
+      if(j != a) {
+        if(dot_flag[j]) {
+          float *v0 = I->V + 3 * j;
+          if(within3f(v0, v, neighborhood)) {
+            float *n0 = I->VN + 3 * j;
+            dot_sum += dot_product3f(n0, vn);
+            n_nbr++;
+          }
+        }
+      }
+      j = map->EList[i++];
+    }
+    if(n_nbr) {
+      dot_sum /= n_nbr;
+      if(dot_sum < trim_cutoff)
+        return true;
+    }
+  }
+  return false;
+}
+
+/* Vertices are eliminated in order, each one changes the neighborhood of
+   the later ones. All vertices are first tested in parallel with their full
+   neighborhood (dot_flag is all set on entry), and only the neighbors of
+   eliminated vertices are tested again. */
 static int SurfaceJobEliminateTroublesomeVerticesMark(PyMOLGlobals * G,
     SurfaceJob * I, int *repeat_flag, MapType *map, int *dot_flag,
     float neighborhood, float trim_cutoff)
 {
   int ok = true;
-  int a;
-  float *v = I->V;
-  float *vn = I->VN;
-  for(a = 0; ok && a < I->N; a++) {
-    if(dot_flag[a]) {
+  std::vector<char> trim(I->N), retest(I->N);
+  pymol::parallel_for(G, I->N, 1024,
+      [&](std::size_t begin, std::size_t end, unsigned) {
+        for(int a = begin; a < int(end) && !G->Interrupt; a++)
+          trim[a] = SurfaceJobIsTroublesomeVertex(
+              I, map, dot_flag, a, neighborhood, trim_cutoff);
+      });
+  ok &= !G->Interrupt;
+  for(int a = 0; ok && a < I->N; a++) {
+    if(retest[a])
+      trim[a] = SurfaceJobIsTroublesomeVertex(
+          I, map, dot_flag, a, neighborhood, trim_cutoff);
+    if(trim[a]) {
+      const float *v = I->V + 3 * a;
+      dot_flag[a] = false;
+      *repeat_flag = true;
       int i = *(MapLocusEStart(map, v));
       if(i && map->EList) {
-	int j = map->EList[i++];
-	int n_nbr = 0;
-	float dot_sum = 0.0F;
-	while(j >= 0) {
-	  if(j != a) {
-	    if(dot_flag[j]) {
-	      float *v0 = I->V + 3 * j;
-	      if(within3f(v0, v, neighborhood)) {
-		float *n0 = I->VN + 3 * j;
-		dot_sum += dot_product3f(n0, vn);
-		n_nbr++;
-	      }
-	    }
-	  }
-	  j = map->EList[i++];
-	}
-	if(n_nbr) {
-	  dot_sum /= n_nbr;
-	  if(dot_sum < trim_cutoff) {
-	    dot_flag[a] = false;
-	    *repeat_flag = true;
-	  }
-	}
+        for(int j = map->EList[i++]; j >= 0; j = map->EList[i++]) {
+          if(j > a && within3f(I->V + 3 * j, v, neighborhood))
+            retest[j] = true;
+        }
       }
     }
-    v += 3;
-    vn += 3;
-    ok &= !G->Interrupt;
   }
+  ok &= !G->Interrupt;
   return ok;
 }
 
@@ -3320,37 +3428,39 @@ static int SurfaceJobAtomProximityCleanupPass(PyMOLGlobals * G, SurfaceJob * I,
   MapType *map =
     MapNewFlagged(G, I->maxVdw + probe_radius, I_coord, n_index, NULL,
 		  present_vla);
-  int a;
-  float *v;
   CHECKOK(ok, map);
   if (ok)
     ok &= MapSetupExpress(map);
-  v = I->V;
-  for(a = 0; ok && a < I->N; a++) {
-    int i = *(MapLocusEStart(map, v));
-    if(i && map->EList) {
-      int j = map->EList[i++];
-      while(j >= 0) {
-	SurfaceJobAtomInfo *atom_info = I_atom_info + j;
-	if((!present_vla) || present_vla[j]) {
-	  if(within3f(I_coord + 3 * j, v, atom_info->vdw + cutoff)) {
-	    dot_flag[a] = true;
-	  }
-	}
-	j = map->EList[i++];
-      }
-    }
-    v += 3;
+  if (ok) {
+    pymol::parallel_for(G, I->N, 1024,
+        [&](std::size_t begin, std::size_t end, unsigned) {
+          for(int a = begin; a < int(end) && !G->Interrupt; a++) {
+            float *v = I->V + 3 * a;
+            int i = *(MapLocusEStart(map, v));
+            if(i && map->EList) {
+              int j = map->EList[i++];
+              while(j >= 0) {
+                SurfaceJobAtomInfo *atom_info = I_atom_info + j;
+                if((!present_vla) || present_vla[j]) {
+                  if(within3f(I_coord + 3 * j, v, atom_info->vdw + cutoff)) {
+                    dot_flag[a] = true;
+                  }
+                }
+                j = map->EList[i++];
+              }
+            }
+          }
+        });
     ok &= !G->Interrupt;
   }
   MapFree(map);
   return ok;
 }
 
-static int SurfaceJobRefineCopyNewPoints(SurfaceJob * I, float *new_dot, int n_new){
+static int SurfaceJobRefineCopyNewPoints(SurfaceJob * I, const float *new_dot, int n_new){
   int ok = true;
-  float *n1 = new_dot + 3;
-  float *v1 = new_dot;
+  const float *n1 = new_dot + 3;
+  const float *v1 = new_dot;
   float *v, *vn;
   VLASize(I->V, float, 3 * (I->N + n_new));
   CHECKOK(ok, I->V);
@@ -3372,103 +3482,104 @@ static int SurfaceJobRefineCopyNewPoints(SurfaceJob * I, float *new_dot, int n_n
   }
   return ok;
 }
-static int SurfaceJobRefineAddNewVerticesCheckPoint(SurfaceJob * I, MapType *map,
-    int *n_new, float **new_dot, int j, float *v, float *vn, float map_cutoff,
+static void SurfaceJobRefineAddNewVerticesCheckPoint(SurfaceJob * I, MapType *map,
+    std::vector<float> &new_dot, int j, float *v, float *vn, float map_cutoff,
     float neighborhood, float insert_cutoff)
 {
-  int ok = true;
   float *v0 = I->V + 3 * j;
   if(within3f(v0, v, map_cutoff)) {
     int add_new = false;
     float *n0 = I->VN + 3 * j;
-    VLACheck(*new_dot, float, (*n_new) * 6 + 5);
-    CHECKOK(ok, *new_dot);
-    if (ok){
-      float *v1 = (*new_dot) + (*n_new) * 6;
-      average3f(v, v0, v1);
-      if((dot_product3f(n0, vn) < 0.666 /* dot_cutoff, was hardcoded as a variable */ )
-	 && (within3f(v0, v, neighborhood))){
-	// if the normals are further than dot_cutoff apart
-	// and the related points are close to each other, than add new
-	add_new = true;
-      } else {
-	/* if points are too far apart, insert a new one, i.e., 
-	   search for any point within insert_cutoff, if not, add */
-	int ii = *(MapLocusEStart(map, v1));
-	if(ii) {
-	  int found = false;
-	  int jj = map->EList[ii++];
-	  while(jj >= 0) {
-	    if(jj != j) {
-	      float *vv0 = I->V + 3 * jj;
-	      if(within3f(vv0, v1, insert_cutoff)) {
-		found = true;
-		break;
-	      }
-	    }
-	    jj = map->EList[ii++];
-	  }
-	  if(!found)
-	    add_new = true;
-	}
-      }
-      if(add_new) {
-	/* highly divergent, add dot in-between v and v0
-	   (averaged, v1 set above, compute the normal (averaged below))
-	   and n_new incremented */
-	float *n1 = v1 + 3;
-	(*n_new)++;
-	average3f(vn, n0, n1);
-	normalize3f(n1);
+    float v1[6];
+    average3f(v, v0, v1);
+    if((dot_product3f(n0, vn) < 0.666 /* dot_cutoff, was hardcoded as a variable */ )
+       && (within3f(v0, v, neighborhood))){
+      // if the normals are further than dot_cutoff apart
+      // and the related points are close to each other, than add new
+      add_new = true;
+    } else {
+      /* if points are too far apart, insert a new one, i.e., 
+         search for any point within insert_cutoff, if not, add */
+      int ii = *(MapLocusEStart(map, v1));
+      if(ii) {
+        int found = false;
+        int jj = map->EList[ii++];
+        while(jj >= 0) {
+          if(jj != j) {
+            float *vv0 = I->V + 3 * jj;
+            if(within3f(vv0, v1, insert_cutoff)) {
+              found = true;
+              break;
+            }
+          }
+          jj = map->EList[ii++];
+        }
+        if(!found)
+          add_new = true;
       }
     }
+    if(add_new) {
+      /* highly divergent, add dot in-between v and v0
+         (averaged, v1 set above, compute the normal (averaged below)) */
+      float *n1 = v1 + 3;
+      average3f(vn, n0, n1);
+      normalize3f(n1);
+      new_dot.insert(new_dot.end(), v1, v1 + 6);
+    }
   }
-  return ok;
 }
 
+/**
+ * New vertices are collected per chunk of existing vertices, in parallel,
+ * and appended in vertex order.
+ */
 static int SurfaceJobRefineAddNewVertices(PyMOLGlobals * G, SurfaceJob * I){
   int ok = true;
   float point_sep = I->pointSep;
-  int n_new = 0;
   float neighborhood = 2.6 * point_sep; /* these constants need more tuning... */
   float insert_cutoff = 1.1 * point_sep;
   float map_cutoff = neighborhood;
-  float *new_dot = VLAlloc(float, 1000);
-  float *v, *vn;
+  const std::size_t grain = 1024;
+  std::vector<std::vector<float>> new_dot((I->N + grain - 1) / grain);
   if(map_cutoff < (2.9 * point_sep)) {  /* these constants need more tuning... */
     map_cutoff = 2.9 * point_sep;
   }
   {
     MapType *map = NULL;
-    int a;
     map = MapNew(G, map_cutoff, I->V, I->N, NULL);
     CHECKOK(ok, map);
     if (ok)
       ok &= MapSetupExpress(map);
-    v = I->V;
-    vn = I->VN;
-    for(a = 0; ok && a < I->N; a++) {
-      int i = *(MapLocusEStart(map, v));
-      if(i && map->EList) {
-	int j = map->EList[i++];
-	while(ok && j >= 0) {
-	  if(j > a) {
-	    SurfaceJobRefineAddNewVerticesCheckPoint(I, map, &n_new, &new_dot, j, v, vn, map_cutoff, neighborhood, insert_cutoff);
-	  }
-	  j = map->EList[i++];
-	  ok &= !G->Interrupt;
-	}
-      }
-      v += 3;
-      vn += 3;
+    if (ok) {
+      pymol::parallel_for(G, I->N, grain,
+          [&](std::size_t begin, std::size_t end, unsigned) {
+            auto &chunk_dot = new_dot[begin / grain];
+            for(int a = begin; a < int(end) && !G->Interrupt; a++) {
+              float *v = I->V + 3 * a;
+              float *vn = I->VN + 3 * a;
+              int i = *(MapLocusEStart(map, v));
+              if(i && map->EList) {
+                int j = map->EList[i++];
+                while(j >= 0) {
+                  if(j > a) {
+                    SurfaceJobRefineAddNewVerticesCheckPoint(I, map, chunk_dot, j, v, vn, map_cutoff, neighborhood, insert_cutoff);
+                  }
+                  j = map->EList[i++];
+                }
+              }
+            }
+          });
       ok &= !G->Interrupt;
     }
     MapFree(map);
   }
-  if(ok && n_new) {
-    ok = SurfaceJobRefineCopyNewPoints(I, new_dot, n_new);
+  if(ok) {
+    std::vector<float> all_new;
+    for(auto &chunk_dot : new_dot)
+      all_new.insert(all_new.end(), chunk_dot.begin(), chunk_dot.end());
+    if(!all_new.empty())
+      ok = SurfaceJobRefineCopyNewPoints(I, all_new.data(), all_new.size() / 6);
   }
-  VLAFreeP(new_dot);
   return ok;
 }
 
@@ -3566,7 +3677,236 @@ static void SurfaceJobSetProbeRadius(int surface_type, float point_sep,
   *probe_rad_less2 = (*probe_rad_less) * (*probe_rad_less);
 }
 
-static int SurfaceJobRun(PyMOLGlobals * G, SurfaceJob * I)
+/**
+ * Solvent dot position and code, for looking up the dots of a cached
+ * surface job (see SurfacePointCache). Positions are compared bitwise.
+ */
+struct SolventDotKey {
+  std::uint32_t bits[4];
+
+  SolventDotKey(const float *v, int code)
+  {
+    memcpy(bits, v, 3 * sizeof(float));
+    bits[3] = code;
+  }
+
+  bool operator==(const SolventDotKey & other) const
+  {
+    return std::equal(bits, bits + 4, other.bits);
+  }
+
+  struct Hash {
+    std::size_t operator()(const SolventDotKey & key) const
+    {
+      std::size_t h = 0;
+      for(auto b : key.bits)
+        h = h * 0x9E3779B1u + b;
+      return h;
+    }
+  };
+};
+
+/**
+ * Unrefined surface points (SurfaceJobGeneratePoints) of the last surface
+ * job with surface_incremental, by solvent dot.
+ *
+ * The points of a solvent dot only depend on its position, on the atoms in
+ * range and on the other solvent dots in range (SurfaceJobPointRanges). If
+ * none of these changed, the points are taken from the cache, which gives
+ * the same points as generating them again.
+ */
+struct SurfacePointCache {
+  /// Input which affects the points, other than coordinates
+  std::vector<float> settings;
+  std::vector<float> coord;
+  std::vector<float> vdw;
+  std::vector<int> flags;
+  std::vector<int> present;
+
+  /// Solvent dots, and the range of points of each in V (offset has one
+  /// more entry than dotCode)
+  std::vector<float> dot;
+  std::vector<int> dotCode;
+  std::vector<int> offset;
+
+  std::vector<float> V;
+  std::vector<float> VN;
+
+  /// Index of each solvent dot, -1 for dots which are not unique
+  std::unordered_map<SolventDotKey, int, SolventDotKey::Hash> index;
+};
+
+/**
+ * Ranges of the dependencies of the surface points of a solvent dot (see
+ * SurfaceJobGeneratePoints): a point is one probe radius away from its dot,
+ * and is removed by atoms within (vdw + probe_rad_more) and by other dots
+ * within probe_rad_less of it.
+ */
+static void SurfaceJobPointRanges(const SurfaceJob * I, float *atom_range,
+    float *dot_range)
+{
+  float probe_radius = I->probeRadius;
+  float probe_rad_more, probe_rad_less, probe_rad_less2;
+  SurfaceJobSetProbeRadius(I->surfaceType, I->pointSep, &probe_radius,
+      &probe_rad_more, &probe_rad_less, &probe_rad_less2);
+  *atom_range = probe_radius + I->maxVdw + probe_rad_more + I->pointSep;
+  *dot_range = probe_radius + probe_rad_less + I->pointSep;
+}
+
+static std::vector<float> SurfaceJobPointSettings(const SurfaceJob * I)
+{
+  return {float(I->surfaceType), float(I->circumscribe), I->probeRadius,
+          I->pointSep, float(I->sphereIndex), float(I->solventSphereIndex),
+          I->maxVdw, float(I->surfaceMode), float(I->surfaceSolvent),
+          float(I->cavityCull), float(I->cavityMode), I->cavityRadius,
+          I->cavityCutoff, float(I->allVisibleFlag), float(I->nPresent)};
+}
+
+/**
+ * True if the cache was made for the same atoms (apart from their
+ * coordinates) and settings as surface job `I`.
+ */
+static bool SurfacePointCacheMatches(const SurfacePointCache & cache,
+    const SurfaceJob * I, int n_atom)
+{
+  if(cache.settings != SurfaceJobPointSettings(I) ||
+     cache.coord.size() != 3 * std::size_t(n_atom))
+    return false;
+  for(int a = 0; a < n_atom; a++) {
+    if(cache.vdw[a] != I->atomInfo[a].vdw ||
+       cache.flags[a] != I->atomInfo[a].flags ||
+       cache.present[a] != (I->presentVla ? I->presentVla[a] : 1))
+      return false;
+  }
+  return true;
+}
+
+/**
+ * Stores the atoms and settings of `I` in the cache.
+ */
+static void SurfacePointCacheStoreAtoms(SurfacePointCache & cache,
+    const SurfaceJob * I, int n_atom)
+{
+  cache.settings = SurfaceJobPointSettings(I);
+  cache.coord.assign(I->coord, I->coord + 3 * n_atom);
+  cache.vdw.resize(n_atom);
+  cache.flags.resize(n_atom);
+  cache.present.resize(n_atom);
+  for(int a = 0; a < n_atom; a++) {
+    cache.vdw[a] = I->atomInfo[a].vdw;
+    cache.flags[a] = I->atomInfo[a].flags;
+    cache.present[a] = I->presentVla ? I->presentVla[a] : 1;
+  }
+}
+
+/**
+ * True if one of `pts` (indexed by `map`) is within `range` of `v`
+ */
+static bool SurfacePointsWithin(MapType * map, const float *pts,
+    const float *v, float range)
+{
+  if(!map)
+    return false;
+  int i = *(MapLocusEStart(map, v));
+  if(i && map->EList) {
+    int j = map->EList[i++];
+    while(j >= 0) {
+      if(within3f(pts + 3 * j, v, range))
+        return true;
+      j = map->EList[i++];
+    }
+  }
+  return false;
+}
+
+/**
+ * For each solvent dot of `I`, the index of the cached dot whose points can
+ * be reused, or -1 if the points need to be generated.
+ * @param cache Cache made for the same atoms and settings
+ * (SurfacePointCacheMatches)
+ */
+static std::vector<int> SurfacePointCacheReuse(PyMOLGlobals * G,
+    const SurfacePointCache & cache, const SurfaceJob * I,
+    const SolventDot * sol_dot)
+{
+  int n_atom = cache.coord.size() / 3;
+  int n_old = cache.dotCode.size();
+  float atom_range, dot_range;
+  SurfaceJobPointRanges(I, &atom_range, &dot_range);
+
+  /* moved atoms, at the old and the new position */
+  std::vector<float> moved;
+  for(int a = 0; a < n_atom; a++) {
+    const float *v_old = cache.coord.data() + 3 * a;
+    const float *v_new = I->coord + 3 * a;
+    if(!std::equal(v_old, v_old + 3, v_new)) {
+      moved.insert(moved.end(), v_old, v_old + 3);
+      moved.insert(moved.end(), v_new, v_new + 3);
+    }
+  }
+
+  /* solvent dots which are only in the cache or only in the new job */
+  std::vector<int> reuse(sol_dot->nDot, -1);
+  std::vector<bool> old_found(n_old, false);
+  std::vector<float> changed;
+  for(int a = 0; a < sol_dot->nDot; a++) {
+    const float *v = sol_dot->dot + 3 * a;
+    auto it = cache.index.find(SolventDotKey(v, sol_dot->dotCode[a]));
+    if(it != cache.index.end() && it->second >= 0 && !old_found[it->second]) {
+      reuse[a] = it->second;
+      old_found[it->second] = true;
+    } else {
+      changed.insert(changed.end(), v, v + 3);
+    }
+  }
+  for(int j = 0; j < n_old; j++) {
+    if(!old_found[j]) {
+      const float *v = cache.dot.data() + 3 * j;
+      changed.insert(changed.end(), v, v + 3);
+    }
+  }
+
+  MapType *moved_map = NULL, *changed_map = NULL;
+  if(!moved.empty()) {
+    moved_map = MapNew(G, atom_range, moved.data(), moved.size() / 3, NULL);
+    if(moved_map)
+      MapSetupExpress(moved_map);
+  }
+  if(!changed.empty()) {
+    changed_map = MapNew(G, dot_range, changed.data(), changed.size() / 3, NULL);
+    if(changed_map)
+      MapSetupExpress(changed_map);
+  }
+  if((!moved.empty() && !moved_map) || (!changed.empty() && !changed_map)) {
+    std::fill(reuse.begin(), reuse.end(), -1);
+  } else {
+    for(int a = 0; a < sol_dot->nDot; a++) {
+      const float *v = sol_dot->dot + 3 * a;
+      if(reuse[a] >= 0 &&
+         (SurfacePointsWithin(moved_map, moved.data(), v, atom_range) ||
+          SurfacePointsWithin(changed_map, changed.data(), v, dot_range)))
+        reuse[a] = -1;
+    }
+  }
+  MapFree(moved_map);
+  MapFree(changed_map);
+
+  PRINTFB(G, FB_RepSurface, FB_Blather)
+    " RepSurface: reusing the points of %d of %d solvent dots.\n",
+    (int) std::count_if(reuse.begin(), reuse.end(), [](int j) { return j >= 0; }),
+    sol_dot->nDot ENDFB(G);
+  return reuse;
+}
+
+/**
+ * First part of the surface job: the (unrefined) surface points I->V, I->VN
+ * from the solvent dots of the atoms.
+ * @param cache If not NULL, take the points of unaffected solvent dots from
+ * this cache (must match the atoms and settings of `I`)
+ * @param store If not NULL, store the solvent dots and points in this cache
+ */
+static int SurfaceJobGeneratePoints(PyMOLGlobals * G, SurfaceJob * I,
+    const SurfacePointCache * cache, SurfacePointCache * store)
 {
   int ok = true;
   int MaxN;
@@ -3608,7 +3948,6 @@ static int SurfaceJobRun(PyMOLGlobals * G, SurfaceJob * I)
     SolventDot *sol_dot = NULL;
     float *v = I->V;
     float *vn = I->VN;
-    MapType *carve_map = NULL;
     float probe_radius = I->probeRadius;
     int circumscribe = I->circumscribe;
     int surface_type = I->surfaceType;
@@ -3664,7 +4003,6 @@ static int SurfaceJobRun(PyMOLGlobals * G, SurfaceJob * I)
 	    ok &= map->EList && solv_map->EList;
             if(sol_dot->nDot && ok) {
               Vector3f *dot = pymol::malloc<Vector3f>(sp->nDot);
-              float *v0, *n0;
 	      CHECKOK(ok, dot);
               if (ok){
                 int b;
@@ -3672,46 +4010,92 @@ static int SurfaceJobRun(PyMOLGlobals * G, SurfaceJob * I)
                   scale3f(sp->dot[b], probe_radius, dot[b]);
                 }
               }
-              v0 = sol_dot->dot;
-              n0 = sol_dot->dotNormal;
               if (ok) {
-                int a, b;
+                /* solvent dots are processed in parallel chunks, the
+                   resulting points are appended in solvent dot order */
+                const std::size_t grain = 256;
+                std::vector<SolventDotChunk> chunks((sol_dot->nDot + grain - 1) / grain);
+                std::vector<int> reuse, n_point(store ? sol_dot->nDot : 0);
                 int sp_nDot = sp->nDot;
-                for(a = 0; ok && a < sol_dot->nDot; a++) {
-                  if(sol_dot->dotCode[a] || (surface_type < 6)) {     /* surface type 6 is completely scribed */
-                    OrthoBusyFast(G, a + sol_dot->nDot * 2, sol_dot->nDot * 5); /* 2/5 to 3/5 */
-                    for(b = 0; ok && b < sp_nDot; b++) {
-                      float *dot_b = dot[b];
-                      v[0] = v0[0] + dot_b[0];
-                      v[1] = v0[1] + dot_b[1];
-                      v[2] = v0[2] + dot_b[2];
-                      {
-                        int flag = true;
-			SurfaceJobCheckInteriorSolventSurface(solv_map, v, sol_dot, probe_rad_less, probe_rad_less2, a, &flag);
-                        /* at this point, we have points on the interior of the solvent surface,
-                           so now we need to further trim that surface to cover atoms that are present */
-                        if(flag) {
-			  SurfaceJobCheckPresentAndWithin(map, I, present_vla, v, probe_rad_more, &flag);
-                          if(!flag) {   /* compute the normals */
-                            vn[0] = -sp->dot[b][0];
-                            vn[1] = -sp->dot[b][1];
-                            vn[2] = -sp->dot[b][2];
-                              I->N++;
-			    VLACheck(I->V, float, 3 * (I->N + 1));
-			    VLACheck(I->VN, float, 3 * (I->N + 1));
-			      CHECKOK(ok, I->V);
-			      CHECKOK(ok, I->VN);
-			    v = I->V + I->N * 3;
-			    vn = I->VN + I->N * 3;
+                if(cache)
+                  reuse = SurfacePointCacheReuse(G, *cache, I, sol_dot);
+                pymol::parallel_for(G, sol_dot->nDot, grain,
+                    [&](std::size_t begin, std::size_t end, unsigned worker) {
+                      auto &chunk = chunks[begin / grain];
+                      for(int a = begin; a < int(end) && !G->Interrupt; a++) {
+                        float *v0 = sol_dot->dot + 3 * a;
+                        std::size_t chunk_n = chunk.dot.size();
+                        if(cache && reuse[a] >= 0) {
+                          int j = reuse[a];
+                          chunk.dot.insert(chunk.dot.end(),
+                              cache->V.begin() + 3 * cache->offset[j],
+                              cache->V.begin() + 3 * cache->offset[j + 1]);
+                          chunk.normal.insert(chunk.normal.end(),
+                              cache->VN.begin() + 3 * cache->offset[j],
+                              cache->VN.begin() + 3 * cache->offset[j + 1]);
+                        } else if(sol_dot->dotCode[a] || (surface_type < 6)) {     /* surface type 6 is completely scribed */
+                          if(!worker)
+                            OrthoBusyFast(G, a + sol_dot->nDot * 2, sol_dot->nDot * 5); /* 2/5 to 3/5 */
+                          for(int b = 0; b < sp_nDot; b++) {
+                            float *dot_b = dot[b];
+                            float pt[3];
+                            pt[0] = v0[0] + dot_b[0];
+                            pt[1] = v0[1] + dot_b[1];
+                            pt[2] = v0[2] + dot_b[2];
+                            {
+                              int flag = true;
+                              SurfaceJobCheckInteriorSolventSurface(solv_map, pt, sol_dot, probe_rad_less, probe_rad_less2, a, &flag);
+                              /* at this point, we have points on the interior of the solvent surface,
+                                 so now we need to further trim that surface to cover atoms that are present */
+                              if(flag) {
+                                SurfaceJobCheckPresentAndWithin(map, I, present_vla, pt, probe_rad_more, &flag);
+                                if(!flag) {   /* compute the normals */
+                                  chunk.dot.insert(chunk.dot.end(), pt, pt + 3);
+                                  chunk.normal.push_back(-sp->dot[b][0]);
+                                  chunk.normal.push_back(-sp->dot[b][1]);
+                                  chunk.normal.push_back(-sp->dot[b][2]);
+                                }
+                              }
+                            }
                           }
                         }
+                        if(store)
+                          n_point[a] = (chunk.dot.size() - chunk_n) / 3;
                       }
-		      ok &= !G->Interrupt;
-                    }
+                    });
+                ok &= !G->Interrupt;
+
+                if (ok) {
+                  std::size_t n_new = 0;
+                  for(auto &chunk : chunks)
+                    n_new += chunk.dot.size() / 3;
+                  VLACheck(I->V, float, 3 * (I->N + n_new + 1));
+                  VLACheck(I->VN, float, 3 * (I->N + n_new + 1));
+                  CHECKOK(ok, I->V);
+                  CHECKOK(ok, I->VN);
+                }
+                int n_first = I->N;
+                for(std::size_t k = 0; ok && k < chunks.size(); k++) {
+                  auto &chunk = chunks[k];
+                  std::copy(chunk.dot.begin(), chunk.dot.end(), I->V + 3 * I->N);
+                  std::copy(chunk.normal.begin(), chunk.normal.end(), I->VN + 3 * I->N);
+                  I->N += chunk.dot.size() / 3;
+                  chunk = SolventDotChunk();
+                }
+
+                if(ok && store) {
+                  store->dot.assign(sol_dot->dot, sol_dot->dot + 3 * sol_dot->nDot);
+                  store->dotCode.assign(sol_dot->dotCode, sol_dot->dotCode + sol_dot->nDot);
+                  store->offset.assign(1, 0);
+                  for(int a = 0; a < sol_dot->nDot; a++) {
+                    store->offset.push_back(store->offset.back() + n_point[a]);
+                    auto inserted = store->index.emplace(
+                        SolventDotKey(sol_dot->dot + 3 * a, sol_dot->dotCode[a]), a);
+                    if(!inserted.second)
+                      inserted.first->second = -1;
                   }
-                  v0 += 3;
-                  n0 += 3;
-		  ok &= !G->Interrupt;
+                  store->V.assign(I->V + 3 * n_first, I->V + 3 * I->N);
+                  store->VN.assign(I->VN + 3 * n_first, I->VN + 3 * I->N);
                 }
               }
               FreeP(dot);
@@ -3745,6 +4129,29 @@ static int SurfaceJobRun(PyMOLGlobals * G, SurfaceJob * I)
     SolventDotFree(sol_dot);
     sol_dot = NULL;
     ok &= !G->Interrupt;
+  }
+  return ok;
+}
+
+/**
+ * Second part of the surface job: refinement and cleanup of the surface
+ * points, and triangulation.
+ */
+static int SurfaceJobRefinePoints(PyMOLGlobals * G, SurfaceJob * I)
+{
+  int ok = !G->Interrupt;
+  {
+    float probe_radius = I->probeRadius;
+    int circumscribe = I->surfaceSolvent ? 0 : I->circumscribe;
+    int surface_type = I->surfaceType;
+    float point_sep = I->pointSep;
+    int *present_vla = I->presentVla;
+
+    if(!I->surfaceSolvent) {
+      float probe_rad_more, probe_rad_less, probe_rad_less2;
+      SurfaceJobSetProbeRadius(surface_type, point_sep, &probe_radius, &probe_rad_more, &probe_rad_less, &probe_rad_less2);
+    }
+
     if(ok) {
       int refine, ref_count = 1;
 
@@ -3797,6 +4204,7 @@ static int SurfaceJobRun(PyMOLGlobals * G, SurfaceJob * I)
         float cutoff = point_sep * 5.0F;
         if((cutoff > probe_radius) && (!I->surfaceSolvent))
           cutoff = probe_radius;
+        /* triangulation stays serial, see TrianglePointsToSurface */
         I->T = TrianglePointsToSurface(G, I->V, I->VN, I->N, cutoff, &I->NT, &I->S, NULL, 
                                        I->cavityMode);
 	CHECKOK(ok, I->T);
@@ -3811,12 +4219,46 @@ static int SurfaceJobRun(PyMOLGlobals * G, SurfaceJob * I)
 	VLASizeForSure(I->VN, float, 1);
       CHECKOK(ok, I->VN);
     }
-    if(carve_map)
-      MapFree(carve_map);
   }
   return ok;
 }
 
+
+static int SurfaceJobRun(PyMOLGlobals * G, SurfaceJob * I)
+{
+  int ok = SurfaceJobGeneratePoints(G, I, NULL, NULL);
+  if(ok)
+    ok = SurfaceJobRefinePoints(G, I);
+  return ok;
+}
+
+/**
+ * Like SurfaceJobRun, but takes the surface points which are not affected
+ * by changes since the job that made `cache` from the cache (see
+ * SurfacePointCache). Gives the same surface as SurfaceJobRun.
+ * @param[in,out] cache Cache of the previous job (may be NULL), replaced
+ * by the cache of this job
+ */
+static int SurfaceJobRunIncremental(PyMOLGlobals * G, SurfaceJob * I,
+    std::shared_ptr<const SurfacePointCache> & cache)
+{
+  int n_atom = VLAGetSize(I->atomInfo);
+  const SurfacePointCache *prev = cache.get();
+  if(prev && !SurfacePointCacheMatches(*prev, I, n_atom))
+    prev = NULL;
+
+  auto store = std::make_shared<SurfacePointCache>();
+  SurfacePointCacheStoreAtoms(*store, I, n_atom);
+
+  int ok = SurfaceJobGeneratePoints(G, I, prev, store.get());
+  if(ok)
+    ok = SurfaceJobRefinePoints(G, I);
+  if(ok)
+    cache = std::move(store);
+  else
+    cache.reset();
+  return ok;
+}
 static void RepSurfaceSetSettings(PyMOLGlobals * G, CoordSet * cs,
     ObjectMolecule *obj, int surface_quality, int surface_type, float *point_sep,
     int *sphere_idx, int *solv_sph_idx, int *circumscribe)
@@ -4154,6 +4596,7 @@ Rep *RepSurfaceNew(CoordSet * cs, int state)
       float *carve_vla = NULL;
       MapType *carve_map = NULL;
       bool smooth_edges = SettingGet_b(G, cs->Setting.get(), obj->Setting.get(), cSetting_surface_smooth_edges);
+      bool incremental = SettingGet_b(G, cs->Setting.get(), obj->Setting.get(), cSetting_surface_incremental);
 
       I->Type = surface_type;
 
@@ -4278,7 +4721,19 @@ Rep *RepSurfaceNew(CoordSet * cs, int state)
 
           ok &= !G->Interrupt;
 
-          if(ok) {
+          if(ok && incremental) {
+            /* start from the points of the surface we are replacing, or of
+               the previous state (trajectory playback) */
+            auto old_rep = static_cast<RepSurface*>(cs->Rep[cRepSurface]);
+            if(old_rep && old_rep->pointCache) {
+              I->pointCache = old_rep->pointCache;
+            } else if(state > 0 && state <= obj->NCSet && obj->CSet[state - 1]) {
+              auto prev_rep = static_cast<RepSurface*>(obj->CSet[state - 1]->Rep[cRepSurface]);
+              if(prev_rep)
+                I->pointCache = prev_rep->pointCache;
+            }
+            ok &= SurfaceJobRunIncremental(G, surf_job, I->pointCache);
+          } else if(ok) {
             int found = false;
 #ifndef _PYMOL_NOPY
             PyObject *entry = NULL;
@@ -4490,27 +4945,63 @@ static int SolventDotFilterOutSameXYZ(PyMOLGlobals * G, MapType *map,
   return ok;
 }
 
-static int SolventDotGetDotsAroundVertexInSphere(PyMOLGlobals * G, SolventDot *I,
+/**
+ * Calls `fn(a, chunk)` for all atoms in parallel chunks, where `fn` appends
+ * the dots of atom `a` to `chunk`. Then appends the chunks in atom order to
+ * `dotPtr` (and `dotNormal`, `dotCode`), up to `stopDot` dots counted by
+ * `dotCnt`. The result is the same as with a serial loop over the atoms.
+ * @param busy Report progress
+ */
+template <typename Func>
+static int SolventDotCollect(PyMOLGlobals * G, int n_coord, bool busy,
+    Func && fn, int *dotCnt, int stopDot, float *dotPtr, float *dotNormal,
+    int *dotCode, int code, int *nDot)
+{
+  const std::size_t grain = 64;
+  std::vector<SolventDotChunk> chunks((n_coord + grain - 1) / grain);
+
+  pymol::parallel_for(G, n_coord, grain,
+      [&](std::size_t begin, std::size_t end, unsigned worker) {
+        auto& chunk = chunks[begin / grain];
+        for(int a = begin; a < int(end) && !G->Interrupt; a++) {
+          if(busy && !worker)
+            OrthoBusyFast(G, a, n_coord * 5);
+          fn(a, chunk);
+        }
+      });
+
+  if(G->Interrupt)
+    return false;
+
+  for(auto& chunk : chunks) {
+    int n = std::min<int>(chunk.dot.size() / 3, stopDot - *dotCnt);
+    if(n <= 0)
+      break;
+    std::copy_n(chunk.dot.data(), 3 * n, dotPtr + 3 * (*nDot));
+    if(dotNormal)
+      std::copy_n(chunk.normal.data(), 3 * n, dotNormal + 3 * (*nDot));
+    if(dotCode)
+      std::fill_n(dotCode + (*nDot), n, code);
+    (*dotCnt) += n;
+    (*nDot) += n;
+  }
+  return true;
+}
+
+static int SolventDotGetDotsAroundVertexInSphere(PyMOLGlobals * G,
     MapType *map, SurfaceJobAtomInfo * atom_info, SurfaceJobAtomInfo *a_atom_info,
-    float *coord, int a, int *present, SphereRec * sp, float radius, int *dotCnt,
-    int stopDot, float *dotPtr, float *dotNormal, int *nDot)
+    float *coord, int a, int *present, SphereRec * sp, float radius,
+    SolventDotChunk &out, bool normals)
 {
   float vdw = a_atom_info->vdw + radius;
   float *v0 = coord + 3 * a;
   int b, ok = true;
-  float *v = dotPtr + (*nDot) * 3;
-  float *n = NULL;
+  float v[3];
   Vector3f *sp_dot = sp->dot;
-  if (dotNormal){
-    n = dotNormal + (*nDot) * 3;
-  }
   for(b = 0; ok && b < sp->nDot; b++) {
     float *sp_dot_b = (float*)(sp_dot + b);
     int i;
     int flag = true;
-    if (n){
-      n[0] = sp_dot_b[0]; n[1] = sp_dot_b[1]; n[2] = sp_dot_b[2];
-    }
     v[0] = v0[0] + vdw * sp_dot_b[0];
     v[1] = v0[1] + vdw * sp_dot_b[1];
     v[2] = v0[2] + vdw * sp_dot_b[2];
@@ -4539,22 +5030,20 @@ static int SolventDotGetDotsAroundVertexInSphere(PyMOLGlobals * G, SolventDot *I
 	ok &= !G->Interrupt;
       }
     }
-    if(ok && flag && (*dotCnt < stopDot)) {
-      (*dotCnt)++;
-      v += 3;
-      if (n)
-	n += 3;
-      (*nDot)++;
+    if(ok && flag) {
+      out.dot.insert(out.dot.end(), v, v + 3);
+      if (normals)
+	out.normal.insert(out.normal.end(), sp_dot_b, sp_dot_b + 3);
     }
   }
   return ok;
 }
 
-static int SolventDotCircumscribeAroundVertex(PyMOLGlobals * G, SolventDot *I,
+static int SolventDotCircumscribeAroundVertex(PyMOLGlobals * G,
     MapType *map, float *vdw, float dist, float *v0, float *v2, int circumscribe,
     SurfaceJobAtomInfo * atom_info, SurfaceJobAtomInfo *a_atom_info,
     SurfaceJobAtomInfo *jj_atom_info, int *present, int a, int jj, float *coord,
-    float probe_radius, int *dotCnt, int stopDot)
+    float probe_radius, SolventDotChunk &out)
 {
   int ok = true;
   float vz[3], vx[3], vy[3], vp[3];
@@ -4565,8 +5054,7 @@ static int SolventDotCircumscribeAroundVertex(PyMOLGlobals * G, SolventDot *I,
   float radius = (2 * area) / dist;
   float adj = (float) sqrt1f(vdw[1] - radius * radius);
   int b;
-  float *v = I->dot + I->nDot * 3;
-  float *n = I->dotNormal + I->nDot * 3;
+  float v[3], n[3];
 
   subtract3f(v2, v0, vz);
   get_system1f3f(vz, vx, vy);
@@ -4613,7 +5101,7 @@ static int SolventDotCircumscribeAroundVertex(PyMOLGlobals * G, SolventDot *I,
 	ok &= !G->Interrupt;
       }
     }
-    if(ok && flag && (*dotCnt < stopDot)) {
+    if(ok && flag) {
       float vt0[3], vt2[3];
       subtract3f(v0, v, vt0);
       subtract3f(v2, v, vt2);
@@ -4627,11 +5115,8 @@ static int SolventDotCircumscribeAroundVertex(PyMOLGlobals * G, SolventDot *I,
 	n[1] = vx[1] * xcos + vy[1] * ysin;
 	n[2] = vx[2] * xcos + vy[2] * ysin;
       */
-      I->dotCode[I->nDot] = 1;  /* mark as exempt */
-      (*dotCnt)++;
-      v += 3;
-      n += 3;
-      I->nDot++;
+      out.dot.insert(out.dot.end(), v, v + 3);
+      out.normal.insert(out.normal.end(), n, n + 3);
     }
   }
   return ok;
@@ -4639,28 +5124,24 @@ static int SolventDotCircumscribeAroundVertex(PyMOLGlobals * G, SolventDot *I,
 
 static int SolventDotMarkDotsWithinCutoff(PyMOLGlobals * G, SolventDot *I,
     MapType *map, float *I_dot, int nDot, float *cavityDot, int *dot_flag, float cutoff){
-  int ok = true, *p = dot_flag;
-  float *v = I->dot;
-  int a;
-  for(a = 0; ok && a < I->nDot; a++) {
-    int i = *(MapLocusEStart(map, v));
-    if(i && map->EList) {
-      int j = map->EList[i++];
-      while(j >= 0) {
-	if(within3f(cavityDot + (3 * j), v, cutoff)) {
-	  *p = true;
-	  break;
-	}
-	j = map->EList[i++];
-      }
-    }
-    v += 3;
-    p++;
-    if(G->Interrupt) {
-      ok = false;
-    }
-  }
-  return ok;
+  pymol::parallel_for(G, I->nDot, 1024,
+      [&](std::size_t begin, std::size_t end, unsigned) {
+        for(int a = begin; a < int(end) && !G->Interrupt; a++) {
+          float *v = I->dot + 3 * a;
+          int i = *(MapLocusEStart(map, v));
+          if(i && map->EList) {
+            int j = map->EList[i++];
+            while(j >= 0) {
+              if(within3f(cavityDot + (3 * j), v, cutoff)) {
+                dot_flag[a] = true;
+                break;
+              }
+              j = map->EList[i++];
+            }
+          }
+        }
+      });
+  return !G->Interrupt;
 }
 
 
@@ -4734,6 +5215,35 @@ static int SolventDotMarkDotsWithinProbeRadius(PyMOLGlobals * G, SolventDot *I,
   return ok;
 }
 
+/*
+ * Marks the dots with more than cavity_cull dots within probe_radius_plus.
+ * The marking passes above end with these and all dots connected to them,
+ * independent of the order, so they can be found in parallel up front and
+ * the passes only need to extend them.
+ */
+static int SolventDotMarkCrowdedDots(PyMOLGlobals * G, SolventDot *I,
+    MapType *map, int cavity_cull, float probe_radius_plus, int *dot_flag){
+  pymol::parallel_for(G, I->nDot, 1024,
+      [&](std::size_t begin, std::size_t end, unsigned) {
+        for(int a = begin; a < int(end) && !G->Interrupt; a++) {
+          const float *v = I->dot + 3 * a;
+          int i = *(MapLocusEStart(map, v));
+          int cnt = 0;
+          if(i && map->EList) {
+            for(int j = map->EList[i++]; j >= 0; j = map->EList[i++]) {
+              if(j != a && within3f(I->dot + (3 * j), v, probe_radius_plus)) {
+                if(++cnt > cavity_cull) {
+                  dot_flag[a] = true;
+                  break;
+                }
+              }
+            }
+          }
+        }
+      });
+  return !G->Interrupt;
+}
+
 static SolventDot *SolventDotNew(PyMOLGlobals * G,
                                  float *coord,
                                  SurfaceJobAtomInfo * atom_info,
@@ -4782,20 +5292,16 @@ static SolventDot *SolventDotNew(PyMOLGlobals * G,
     if(map && ok) {
       ok &= MapSetupExpress(map);
       if (ok) {
-        int a;
-        int skip_flag;
-        SurfaceJobAtomInfo *a_atom_info = atom_info;
-        for(a = 0; ok && a < n_coord; a++) {
-          OrthoBusyFast(G, a, n_coord * 5);
-          if((!present) || (present[a])) {
-            skip_flag = false;
-	    ok = SolventDotFilterOutSameXYZ(G, map, atom_info, a_atom_info, coord, a, present, &skip_flag);
-            if(ok && !skip_flag) {
-	      ok = SolventDotGetDotsAroundVertexInSphere(G, I, map, atom_info, a_atom_info, coord, a, present, sp, probe_radius, &dotCnt, stopDot, I->dot, I->dotNormal, &I->nDot);
-            }
-          }
-          a_atom_info++;
-        }
+        ok = SolventDotCollect(G, n_coord, true,
+            [&](int a, SolventDotChunk &chunk) {
+              SurfaceJobAtomInfo *a_atom_info = atom_info + a;
+              if((!present) || (present[a])) {
+                int skip_flag = false;
+                if(SolventDotFilterOutSameXYZ(G, map, atom_info, a_atom_info, coord, a, present, &skip_flag) && !skip_flag) {
+                  SolventDotGetDotsAroundVertexInSphere(G, map, atom_info, a_atom_info, coord, a, present, sp, probe_radius, chunk, true);
+                }
+              }
+            }, &dotCnt, stopDot, I->dot, I->dotNormal, NULL, 0, &I->nDot);
       }
 
       /* for each pair of proximal atoms, circumscribe a circle for their intersection */
@@ -4807,46 +5313,43 @@ static SolventDot *SolventDotNew(PyMOLGlobals * G,
 	}
 	ok &= !G->Interrupt;
         if(ok && map2) {
-          int a;
-          int skip_flag;
-
-          SurfaceJobAtomInfo *a_atom_info = atom_info;
           ok &= MapSetupExpress(map2);
-          for(a = 0; ok && a < n_coord; a++) {
-            if((!present) || present[a]) {
-              float *v0 = coord + 3 * a;
-              skip_flag = false;
-
-	      ok = SolventDotFilterOutSameXYZ(G, map2, atom_info, a_atom_info, coord, a, present, &skip_flag);
-              if(ok && !skip_flag) {
-                int ii = *(MapLocusEStart(map2, v0));
-                if(ii) {
-                  int jj = map2->EList[ii++];
-		  float vdw[3];
-		  vdw[0] = a_atom_info->vdw + probe_radius;
-		  vdw[1] = vdw[0] * vdw[0];
-                  while(ok && jj >= 0) {
-                    SurfaceJobAtomInfo *jj_atom_info = atom_info + jj;
-                    float dist;
-                    if(jj > a)  /* only check if this is atom trails */
-                      if((!present) || present[jj]) {
-                        float *v2 = coord + 3 * jj;
-			vdw[2] = jj_atom_info->vdw + probe_radius;
-                        dist = (float) diff3f(v0, v2);
-			if((dist > R_SMALL4) && (dist < (vdw[0] + vdw[2]))) {
-			  ok = SolventDotCircumscribeAroundVertex(G, I, map, vdw, dist, v0, v2, circumscribe, 
-								  atom_info, a_atom_info, jj_atom_info, 
-								  present, a, jj, coord, probe_radius, &dotCnt, stopDot);
-                        }
+        }
+        if(ok && map2) {
+          ok = SolventDotCollect(G, n_coord, false,
+              [&](int a, SolventDotChunk &chunk) {
+                SurfaceJobAtomInfo *a_atom_info = atom_info + a;
+                if((!present) || present[a]) {
+                  float *v0 = coord + 3 * a;
+                  int skip_flag = false;
+
+                  if(SolventDotFilterOutSameXYZ(G, map2, atom_info, a_atom_info, coord, a, present, &skip_flag) && !skip_flag) {
+                    int ii = *(MapLocusEStart(map2, v0));
+                    if(ii) {
+                      int jj = map2->EList[ii++];
+                      float vdw[3];
+                      vdw[0] = a_atom_info->vdw + probe_radius;
+                      vdw[1] = vdw[0] * vdw[0];
+                      while(jj >= 0 && !G->Interrupt) {
+                        SurfaceJobAtomInfo *jj_atom_info = atom_info + jj;
+                        float dist;
+                        if(jj > a)  /* only check if this is atom trails */
+                          if((!present) || present[jj]) {
+                            float *v2 = coord + 3 * jj;
+                            vdw[2] = jj_atom_info->vdw + probe_radius;
+                            dist = (float) diff3f(v0, v2);
+                            if((dist > R_SMALL4) && (dist < (vdw[0] + vdw[2]))) {
+                              SolventDotCircumscribeAroundVertex(G, map, vdw, dist, v0, v2, circumscribe,
+                                                                 atom_info, a_atom_info, jj_atom_info,
+                                                                 present, a, jj, coord, probe_radius, chunk);
+                            }
+                          }
+                        jj = map2->EList[ii++];
                       }
-                    jj = map2->EList[ii++];
+                    }
                   }
                 }
-              }
-            }
-            a_atom_info++;
-	    ok &= !G->Interrupt;
-          }
+              }, &dotCnt, stopDot, I->dot, I->dotNormal, I->dotCode, 1 /* mark as exempt */, &I->nDot);
         }
         MapFree(map2);
       }
@@ -4873,19 +5376,16 @@ static SolventDot *SolventDotNew(PyMOLGlobals * G,
       if(ok && map) {
         ok &= MapSetupExpress(map);
         if (ok) {
-          int a;
-          int skip_flag;
-          SurfaceJobAtomInfo *a_atom_info = atom_info;
-          for(a = 0; a < n_coord; a++) {
-            if((!present) || (present[a])) {
-              skip_flag = false;
-	      ok = SolventDotFilterOutSameXYZ(G, map, atom_info, a_atom_info, coord, a, present, &skip_flag);
-              if(ok && !skip_flag) {
-		ok = SolventDotGetDotsAroundVertexInSphere(G, I, map, atom_info, a_atom_info, coord, a, present, sp, cavity_radius, &dotCnt, stopDot, cavityDot, NULL, &nCavityDot);
-              }
-            }
-            a_atom_info++;
-          }
+          ok = SolventDotCollect(G, n_coord, false,
+              [&](int a, SolventDotChunk &chunk) {
+                SurfaceJobAtomInfo *a_atom_info = atom_info + a;
+                if((!present) || (present[a])) {
+                  int skip_flag = false;
+                  if(SolventDotFilterOutSameXYZ(G, map, atom_info, a_atom_info, coord, a, present, &skip_flag) && !skip_flag) {
+                    SolventDotGetDotsAroundVertexInSphere(G, map, atom_info, a_atom_info, coord, a, present, sp, cavity_radius, chunk, false);
+                  }
+                }
+              }, &dotCnt, stopDot, cavityDot, NULL, NULL, 0, &nCavityDot);
         }
       }
       MapFree(map);
@@ -4914,12 +5414,13 @@ static SolventDot *SolventDotNew(PyMOLGlobals * G,
     probe_radius_plus = probe_radius * 1.5F;
 
     ErrChkPtr(G, dot_flag);
-
     {
       MapType *map = MapNew(G, probe_radius_plus, I->dot, I->nDot, NULL);
       if(map) {
         int flag = true;
         MapSetupExpress(map);
+        if(pymol::parallel_workers(G) > 1)
+          ok = SolventDotMarkCrowdedDots(G, I, map, cavity_cull, probe_radius_plus, dot_flag);
         while(ok && flag) {
           flag = false;
 	  ok = SolventDotMarkDotsWithinProbeRadius(G, I, map, cavity_cull, probe_radius_plus, dot_flag, &flag);
@@ -30,9 +30,13 @@ Z* -------------------------------------------------------------------
 #include "Lex.h"
 #include "ObjectMolecule.h"
 #include "CoordSet.h"
+#include "TaskPool.h"
 
 #include"CGO.h"
 
+#include <algorithm>
+#include <vector>
+
 #ifndef R_SMALL8
 #define R_SMALL8 0.00000001
 #endif
@@ -59,7 +63,6 @@ Z* -------------------------------------------------------------------
  ((((e)+(int)*(v+1))<< 4)&0x00FC0)|\
  ((((f)+(int)*(v+2))<<10)&0x3F000))
 
-
 /* below are empirically optimized */
 
 #define ex_hash_i0(a) \
@@ -409,7 +412,7 @@ void SculptMeasureObject(CSculpt * I, ObjectMolecule * obj, int state, int match
   UtilZeroMem(I->NBHash.data(), NB_HASH_SIZE * sizeof(int));
   UtilZeroMem(I->EXHash.data(), EX_HASH_SIZE * sizeof(int));
 
-  if((state >= 0) && (state < obj->NCSet) && (obj->CSet[state])) {
+  if((state >= 0) && (state < obj->NCSet) && obj->pinCoordSet(state)) {
     obj_atomInfo = obj->AtomInfo.data();
 
     VLACheck(I->Don, int, obj->NAtom);
@@ -424,7 +427,7 @@ void SculptMeasureObject(CSculpt * I, ObjectMolecule * obj, int state, int match
 
     ObjectMoleculeVerifyChemistry(obj, state);
 
-    cs = obj->CSet[state];
+    cs = obj->pinCoordSet(state);
 
     use_cache = SettingGet_i(G, cs->Setting.get(), obj->Setting.get(), cSetting_sculpt_memory);
     if(obj->NBond) {
@@ -677,7 +680,7 @@ void SculptMeasureObject(CSculpt * I, ObjectMolecule * obj, int state, int match
 
       /* if we have a match state, establish minimum distances */
       if((match_state >= 0) && (match_state < obj->NCSet) && (!obj->DiscreteFlag)) {
-        CoordSet *cs2 = obj->CSet[match_state];
+        CoordSet *cs2 = obj->getCoordSet(match_state);
         int n_site = 0;
         if(cs2) {
           float minim_min =
@@ -1605,28 +1608,46 @@ static int SculptDoAvoid(float avoid, float range, float actual, float *d,
   return 0;
 }
 
+namespace {
+/**
+ * Displacements from one restraint, computed in parallel and applied to
+ * the per-atom sums afterwards
+ */
+struct SculptTermResult {
+  int n_atom = 0;               /* 0 = restraint not applicable */
+  int atom[4];
+  float disp[4][3] = {};
+  float strain = 0.0F;
+  bool counted = false;         /* contributes to cnt and total_count */
+  bool deferred = false;        /* must be evaluated in order, see below */
+};
+
+/**
+ * Nonbonded pair with a bump (or avoid) displacement and/or a bump to
+ * visualize
+ */
+struct SculptPairResult {
+  int b0, b1;
+  float disp[2][3] = {};
+  float strain = 0.0F;
+  float cutoff = 0.0F;
+  bool bump = false;
+  bool draw = false;
+};
+} // namespace
+
 float SculptIterateObject(CSculpt * I, ObjectMolecule * obj,
                           int state, int const n_cycle_arg, float *center)
 {
   PyMOLGlobals *G = I->G;
   CShaker *shk;
-  int a0, a1, a2, a3, b0, b3;
+  int a1;
   int aa;
   float *disp = NULL;
-  float *v, *v0, *v1, *v2, *v3;
-  float diff[3], len;
+  float *v, *v1, *v2;
   int *atm2idx = NULL;
   int *cnt = NULL;
-  int *i;
-  int hash;
-  int nb_next;
-  int h, k, l;
-  int offset;
-  float cutoff, vdw_cutoff;
-  int ex;
-  int eval_flag;
   int mask;
-  float wt;
   float vdw;
   float vdw14;
   float vdw_wt;
@@ -1642,11 +1663,11 @@ float SculptIterateObject(CSculpt * I, ObjectMolecule * obj,
   float hb_overlap, hb_overlap_base;
   int *active, n_active;
   int *exclude;
-  const AtomInfoType *ai0, *ai1;
+  const AtomInfoType *ai0;
   double task_time;
   float vdw_magnify, vdw_magnified = 1.0F;
   int nb_skip, nb_skip_count;
-  float total_strain = 0.0F, strain;
+  float total_strain = 0.0F;
   int total_count = 1;
   CGO *cgo = NULL;
   float good_color[3] = { 0.2, 1.0, 0.2 };
@@ -1796,264 +1817,271 @@ float SculptIterateObject(CSculpt * I, ObjectMolecule * obj,
         }
       }
 
-      while(n_cycle--) {
-
-        total_strain = 0.0F;
-        total_count = 0;
-        /* initialize displacements to zero */
-
-        v = disp;
-        i = cnt;
-        for(aa = 0; aa < n_active; aa++) {
-          int a = active[aa];
-          v = disp + a * 3;
-          cnt[a] = 0;
-          *(v) = 0.0F;
-          *(v + 1) = 0.0F;
-          *(v + 2) = 0.0F;
+      /* restraints are evaluated in parallel, then applied in restraint
+         order, so results don't depend on the number of threads. Terms
+         which add to an atom's displacement more than once (pyramids,
+         planes) or need random numbers (coincident atoms) are deferred
+         and evaluated during the ordered pass, to round exactly like a
+         serial loop. */
+
+      const int n_dist = shk->NDistCon;
+      const int n_line = (cSculptLine & mask) ? shk->NLineCon : 0;
+      const int n_pyra = (cSculptPyra & mask) ? shk->NPyraCon : 0;
+      const int n_plan = (cSculptPlan & mask) ? shk->NPlanCon : 0;
+      const int n_tors = (cSculptTors & mask) ? shk->NTorsCon : 0;
+      std::vector<SculptTermResult> terms(
+          n_dist + n_line + n_pyra + n_plan + n_tors);
+
+      auto use_atoms = [&](SculptTermResult& r, std::initializer_list<int> atoms) {
+        for(int b : atoms) {
+          if(exclude[b] || atm2idx[b] < 0)
+            return false;
         }
+        for(int b : atoms) {
+          r.atom[r.n_atom++] = b;
+        }
+        return true;
+      };
+
+      auto eval_term = [&](int t, SculptTermResult& r, float *direct) {
+        auto coord = [&](int k) { return cs_coord + 3 * atm2idx[r.atom[k]]; };
+        auto out = [&](int k) { return direct ? direct + 3 * r.atom[k] : r.disp[k]; };
+
+        if(t < n_dist) {
+          const ShakerDistCon *sdc = shk->DistCon.data() + t;
+          int eval_flag;
+          float wt;
+          switch (sdc->type) {
+          case cShakerDistBond:
+            eval_flag = cSculptBond & mask;
+            wt = bond_wt;
+            break;
+          case cShakerDistAngle:
+            eval_flag = cSculptAngl & mask;
+            wt = angl_wt;
+            break;
+          case cShakerDistLimit:
+            eval_flag = cSculptTri & mask;
+            wt = tri_wt;
+            break;
+          case cShakerDistMinim:
+            eval_flag = cSculptMin & mask;
+            wt = min_wt * sdc->weight;
+            break;
+          case cShakerDistMaxim:
+            eval_flag = cSculptMax & mask;
+            wt = max_wt * sdc->weight;
+            break;
+          default:
+            eval_flag = false;
+            wt = 0.0F;
+            break;
+          }
 
-        /* apply distance constraints */
+          if(!eval_flag || !use_atoms(r, {sdc->at0, sdc->at1}))
+            return;
 
-        {
-          const ShakerDistCon *sdc = shk->DistCon.data();
-          int a,ndc = shk->NDistCon;
-          for(a = 0; a < ndc; a++) {
-            int sdc_type = sdc->type;
-            int b1 = sdc->at0;
-            int b2 = sdc->at1;
-
-            switch (sdc_type) {
-            case cShakerDistBond:
-              eval_flag = cSculptBond & mask;
-              wt = bond_wt;
-              break;
-            case cShakerDistAngle:
-              eval_flag = cSculptAngl & mask;
-              wt = angl_wt;
-              break;
-            case cShakerDistLimit:
-              eval_flag = cSculptTri & mask;
-              wt = tri_wt;
-              break;
-            case cShakerDistMinim:
-              eval_flag = cSculptMin & mask;
-              wt = min_wt * sdc->weight;
-              break;
-            case cShakerDistMaxim:
-              eval_flag = cSculptMax & mask;
-              wt = max_wt * sdc->weight;
-              break;
-            default:
-              eval_flag = false;
-              wt = 0.0F;
-              break;
+          float *v1 = coord(0), *v2 = coord(1);
+          switch (sdc->type) {
+          case cShakerDistLimit:
+            r.strain = ShakerDoDistLimit(sdc->targ * tri_sc, v1, v2,
+                out(0), out(1), wt);
+            r.counted = (r.strain > 0.0F);
+            break;
+          case cShakerDistMaxim:
+            r.strain = ShakerDoDistLimit(sdc->targ * max_sc, v1, v2,
+                out(0), out(1), wt);
+            r.counted = (r.strain > 0.0F);
+            break;
+          case cShakerDistMinim:
+            r.strain = ShakerDoDistMinim(sdc->targ * min_sc, v1, v2,
+                out(0), out(1), wt);
+            r.counted = (r.strain > 0.0F);
+            break;
+          default:
+            float d[3];
+            subtract3f(v1, v2, d);
+            if(!direct && length3f(d) <= R_SMALL8) {
+              r.deferred = true;
+              return;
             }
+            r.counted = true;
+            r.strain = ShakerDoDist(sdc->targ, v1, v2, out(0), out(1), wt);
+          }
+          return;
+        }
+        t -= n_dist;
+
+        if(t < n_line) {
+          const ShakerLineCon *slc = shk->LineCon.data() + t;
+          if(use_atoms(r, {slc->at0, slc->at1, slc->at2})) {
+            r.strain = ShakerDoLine(coord(0), coord(1), coord(2),
+                out(0), out(1), out(2), line_wt);
+            r.counted = true;
+          }
+          return;
+        }
+        t -= n_line;
+
+        if(t < n_pyra) {
+          const ShakerPyraCon *spc = shk->PyraCon.data() + t;
+          if(use_atoms(r, {spc->at0, spc->at1, spc->at2, spc->at3})) {
+            if(!direct) {
+              r.deferred = true;
+              return;
+            }
+            r.strain = ShakerDoPyra(spc->targ1, spc->targ2,
+                coord(0), coord(1), coord(2), coord(3),
+                out(0), out(1), out(2), out(3), pyra_wt, pyra_inv_wt);
+            r.counted = true;
+          }
+          return;
+        }
+        t -= n_pyra;
+
+        if(t < n_plan) {
+          const ShakerPlanCon *snc = shk->PlanCon.data() + t;
+          if(use_atoms(r, {snc->at0, snc->at1, snc->at2, snc->at3})) {
+            if(!direct) {
+              r.deferred = true;
+              return;
+            }
+            r.strain = ShakerDoPlan(coord(0), coord(1), coord(2), coord(3),
+                out(0), out(1), out(2), out(3),
+                snc->target, snc->fixed, plan_wt);
+            r.counted = true;
+          }
+          return;
+        }
+        t -= n_plan;
 
-            if(eval_flag && !(exclude[b1] || exclude[b2])) {
-              a1 = atm2idx[b1]; /* coordinate set indices */
-              a2 = atm2idx[b2];
-              if((a1 >= 0) && (a2 >= 0)) {
-                v1 = cs_coord + 3 * a1;
-                v2 = cs_coord + 3 * a2;
-                switch (sdc_type) {
-                case cShakerDistLimit:
-                  strain =
-                    ShakerDoDistLimit(sdc->targ * tri_sc, v1, v2, disp + b1 * 3,
-                                      disp + b2 * 3, wt);
-                  if(strain > 0.0F) {
-                    cnt[b1]++;
-                    cnt[b2]++;
-                    total_strain += strain;
-                    total_count++;
-                  }
-                  break;
-                case cShakerDistMaxim:
-                  strain =
-                    ShakerDoDistLimit(sdc->targ * max_sc, v1, v2, disp + b1 * 3,
-                                      disp + b2 * 3, wt);
-                  if(strain > 0.0F) {
-                    cnt[b1]++;
-                    cnt[b2]++;
-                    total_strain += strain;
-                    total_count++;
-                  }
-                  break;
-                case cShakerDistMinim:
-                  strain =
-                    ShakerDoDistMinim(sdc->targ * min_sc, v1, v2, disp + b1 * 3,
-                                      disp + b2 * 3, wt);
-                  if(strain > 0.0F) {
-                    cnt[b1]++;
-                    cnt[b2]++;
-                    total_strain += strain;
-                    total_count++;
-                  }
-                  break;
-                default:
-                  total_strain +=
-                    ShakerDoDist(sdc->targ, v1, v2, disp + b1 * 3, disp + b2 * 3, wt);
-                  cnt[b1]++;
-                  cnt[b2]++;
-                  total_count++;
-                }
+        {
+          const ShakerTorsCon *stc = shk->TorsCon.data() + t;
+          if(use_atoms(r, {stc->at0, stc->at1, stc->at2, stc->at3})) {
+            r.strain = ShakerDoTors(stc->type, coord(0), coord(1), coord(2), coord(3),
+                out(0), out(1), out(2), out(3), tors_tole, tors_wt);
+            r.counted = true;
+          }
+        }
+      };
+
+      /* nonbonded pairs come from the coordinate hash, walked in parallel
+         over chunks of active atoms and applied in the order of a serial
+         walk */
+
+      const std::size_t pair_grain = 64;
+      std::vector<std::vector<SculptPairResult>> pairs(
+          (n_active + pair_grain - 1) / pair_grain);
+
+      auto for_each_hashed = [&](int b0, const float *v0, int reach, auto&& fn) {
+        const int *nb_list = I->NBList.data();
+        int v0i = (int) (*v0);
+        int v1i = (int) (*(v0 + 1));
+        int v2i = (int) (*(v0 + 2));
+        for(int h = -reach; h <= reach; h += 4) {
+          int nb_off0 = nb_hash_off_i0(v0i, h);
+          for(int k = -reach; k <= reach; k += 4) {
+            int nb_off1 = nb_off0 | nb_hash_off_i1(v1i, k);
+            for(int l = -reach; l <= reach; l += 4) {
+              int offset = I->NBHash[nb_off1 | nb_hash_off_i2(v2i, l)];
+              while(offset) {
+                const int *i = nb_list + offset;
+                if(*(i + 2) > b0)
+                  fn(*(i + 2));
+                offset = (*i);
               }
             }
-            sdc++;
           }
         }
-        /* apply line constraints */
-
-        if(cSculptLine & mask) {
-          const ShakerLineCon *slc = shk->LineCon.data();
-          int nlc = shk->NLineCon;
-          int a,b1,b2;
-          for(a = 0; a < nlc; a++) {
-            b0 = slc->at0;
-            b1 = slc->at1;
-            b2 = slc->at2;
-            a0 = atm2idx[b0];   /* coordinate set indices */
-            a1 = atm2idx[b1];
-            a2 = atm2idx[b2];
-
-            if((a0 >= 0) && (a1 >= 0) && (a2 >= 0)
-               && !(exclude[b0] || exclude[b1] || exclude[b2])) {
-              cnt[b0]++;
-              cnt[b1]++;
-              cnt[b2]++;
-              v0 = cs_coord + 3 * a0;
-              v1 = cs_coord + 3 * a1;
-              v2 = cs_coord + 3 * a2;
-              total_strain +=
-                ShakerDoLine(v0, v1, v2, disp + b0 * 3, disp + b1 * 3, disp + b2 * 3,
-                             line_wt);
+      };
+
+      auto apply_pairs = [&]() {
+        for(auto& chunk : pairs) {
+          for(auto& p : chunk) {
+            if(p.draw) {
+              const AtomInfoType *pai0 = obj->AtomInfo + p.b0;
+              const AtomInfoType *pai1 = obj->AtomInfo + p.b1;
+              SculptCGOBump(cs_coord + 3 * atm2idx[p.b0],
+                            cs_coord + 3 * atm2idx[p.b1], pai0->vdw, pai1->vdw,
+                            p.cutoff, vdw_vis_min, vdw_vis_mid, vdw_vis_max,
+                            good_color, bad_color, vdw_vis_mode, cgo);
+            }
+            if(p.bump) {
+              add3f(p.disp[0], disp + p.b0 * 3, disp + p.b0 * 3);
+              add3f(p.disp[1], disp + p.b1 * 3, disp + p.b1 * 3);
+              total_strain += p.strain;
+              cnt[p.b0]++;
+              cnt[p.b1]++;
               total_count++;
             }
-            slc++;
           }
+          chunk.clear();
         }
-
-        /* apply pyramid constraints */
-
-        if(cSculptPyra & mask) {
-          const ShakerPyraCon *spc = shk->PyraCon.data();
-          int npc = shk->NPyraCon;
-          int a,b1,b2;
-          for(a = 0; a < npc; a++) {
-
-            b0 = spc->at0;
-            b1 = spc->at1;
-            b2 = spc->at2;
-            b3 = spc->at3;
-            a0 = atm2idx[b0];
-            a1 = atm2idx[b1];
-            a2 = atm2idx[b2];
-            a3 = atm2idx[b3];
-
-            if((a0 >= 0) && (a1 >= 0) && (a2 >= 0) && (a3 >= 0)
-               && !(exclude[b0] || exclude[b1] || exclude[b2] || exclude[b3])) {
-              v0 = cs_coord + 3 * a0;
-              v1 = cs_coord + 3 * a1;
-              v2 = cs_coord + 3 * a2;
-              v3 = cs_coord + 3 * a3;
-              total_strain += ShakerDoPyra(spc->targ1,
-                                           spc->targ2,
-                                           v0, v1, v2, v3,
-                                           disp + b0 * 3,
-                                           disp + b1 * 3,
-                                           disp + b2 * 3,
-                                           disp + b3 * 3, pyra_wt, pyra_inv_wt);
-              total_count++;
-
-              cnt[b0]++;
-              cnt[b1]++;
-              cnt[b2]++;
-              cnt[b3]++;
+      };
+
+      auto get_ex = [&](int b0, int b1) {
+        /* determine exclusion (if any) */
+        const int *I_EXList = I->EXList.data();
+        const int *j;
+        int ex = 10;
+        int xoffset = I->EXHash[ex_hash_i0(b0) | ex_hash_i1(b1)];
+        while(xoffset) {
+          xoffset = (*(j = I_EXList + xoffset));
+          if((*(j + 1) == b0) && (*(j + 2) == b1)) {
+            if(*(j + 3) < ex) {
+              ex = *(j + 3);
             }
-            spc++;
           }
         }
+        return ex;
+      };
 
-        if(cSculptPlan & mask) {
-          const ShakerPlanCon *snc = shk->PlanCon.data();
-          int npc = shk->NPlanCon;
-          int a,b1,b2;
-          /* apply planarity constraints */
-
-          for(a = 0; a < npc; a++) {
-
-            b0 = snc->at0;
-            b1 = snc->at1;
-            b2 = snc->at2;
-            b3 = snc->at3;
-            a0 = atm2idx[b0];
-            a1 = atm2idx[b1];
-            a2 = atm2idx[b2];
-            a3 = atm2idx[b3];
-
-            if((a0 >= 0) && (a1 >= 0) && (a2 >= 0) && (a3 >= 0)
-               && !(exclude[b0] || exclude[b1] || exclude[b2] || exclude[b3])) {
-              v0 = cs_coord + 3 * a0;
-              v1 = cs_coord + 3 * a1;
-              v2 = cs_coord + 3 * a2;
-              v3 = cs_coord + 3 * a3;
-              total_strain += ShakerDoPlan(v0, v1, v2, v3,
-                                           disp + b0 * 3,
-                                           disp + b1 * 3,
-                                           disp + b2 * 3,
-                                           disp + b3 * 3,
-                                           snc->target, snc->fixed, plan_wt);
-              total_count++;
-              cnt[b0]++;
-              cnt[b1]++;
-              cnt[b2]++;
-              cnt[b3]++;
-            }
+      while(n_cycle--) {
 
-            snc++;
-          }
+        total_strain = 0.0F;
+        total_count = 0;
+        /* initialize displacements to zero */
+
+        for(aa = 0; aa < n_active; aa++) {
+          int a = active[aa];
+          v = disp + a * 3;
+          cnt[a] = 0;
+          *(v) = 0.0F;
+          *(v + 1) = 0.0F;
+          *(v + 2) = 0.0F;
         }
 
-        /* apply torsion constraints */
-
-        if(cSculptTors & mask) {
-          const ShakerTorsCon *stc = shk->TorsCon.data();
-          int ntc = shk->NTorsCon;
-          int a,b1,b2;
-          /* apply planarity constraints */
-
-          for(a = 0; a < ntc; a++) {
-
-            b0 = stc->at0;
-            b1 = stc->at1;
-            b2 = stc->at2;
-            b3 = stc->at3;
-            a0 = atm2idx[b0];
-            a1 = atm2idx[b1];
-            a2 = atm2idx[b2];
-            a3 = atm2idx[b3];
-
-            if((a0 >= 0) && (a1 >= 0) && (a2 >= 0) && (a3 >= 0)
-               && !(exclude[b0] || exclude[b1] || exclude[b2] || exclude[b3])) {
-              v0 = cs_coord + 3 * a0;
-              v1 = cs_coord + 3 * a1;
-              v2 = cs_coord + 3 * a2;
-              v3 = cs_coord + 3 * a3;
-              total_strain += ShakerDoTors(stc->type,
-                                           v0, v1, v2, v3,
-                                           disp + b0 * 3,
-                                           disp + b1 * 3,
-                                           disp + b2 * 3,
-                                           disp + b3 * 3, tors_tole, tors_wt);
-              total_count++;
-              cnt[b0]++;
-              cnt[b1]++;
-              cnt[b2]++;
-              cnt[b3]++;
+        /* apply distance, line, pyramid, planarity and torsion constraints */
+
+        pymol::parallel_for(G, terms.size(), 1024,
+            [&](std::size_t begin, std::size_t end, unsigned) {
+              for(auto t = begin; t < end; ++t) {
+                terms[t] = SculptTermResult();
+                eval_term(int(t), terms[t], nullptr);
+              }
+            });
+
+        for(std::size_t t = 0; t < terms.size(); ++t) {
+          auto& r = terms[t];
+          if(!r.n_atom)
+            continue;
+          if(r.deferred) {
+            r = SculptTermResult();
+            eval_term(int(t), r, disp);
+          } else if(r.counted) {
+            for(int k = 0; k < r.n_atom; ++k) {
+              add3f(r.disp[k], disp + r.atom[k] * 3, disp + r.atom[k] * 3);
             }
-            stc++;
+          }
+          if(r.counted) {
+            for(int k = 0; k < r.n_atom; ++k) {
+              cnt[r.atom[k]]++;
+            }
+            total_strain += r.strain;
+            total_count++;
           }
         }
+
         /* apply nonbonded interactions */
 
         if((n_cycle > 0) && (nb_skip_count > 0)) {
@@ -2061,12 +2089,6 @@ float SculptIterateObject(CSculpt * I, ObjectMolecule * obj,
           nb_skip_count--;
           vdw_magnify += 1.0F;
         } else {
-          int nb_off0, nb_off1;
-          int v0i, v1i, v2i;
-          int x0i;
-          int don_b0;
-          int acc_b0;
-          int b1;
           vdw_magnified = vdw_magnify;
           vdw_magnify = 1.0F;
 
@@ -2074,16 +2096,18 @@ float SculptIterateObject(CSculpt * I, ObjectMolecule * obj,
           if((cSculptVDW | cSculptVDW14 | cSculptAvoid) & mask) {
             /* compute non-bonded interations */
 
+            const bool vdw_pass = (cSculptVDW | cSculptVDW14) & mask;
+            const bool avd_pass = cSculptAvoid & mask;
+            const bool draw = vdw_vis_mode && cgo && (n_cycle < 1);
+
             /* construct nonbonded hash */
 
-            nb_next = 1;
+            int nb_next = 1;
             for(aa = 0; aa < n_active; aa++) {
-              b0 = active[aa];
-              a0 = atm2idx[b0];
+              int b0 = active[aa];
               VLACheck(I->NBList, int, nb_next + 2);
-              v0 = cs_coord + 3 * a0;
-              hash = nb_hash(v0);
-              i = I->NBList + nb_next;
+              int hash = nb_hash(cs_coord + 3 * atm2idx[b0]);
+              int *i = I->NBList + nb_next;
               *(i++) = I->NBHash[hash];
               *(i++) = hash;
               *(i++) = b0;
@@ -2092,194 +2116,119 @@ float SculptIterateObject(CSculpt * I, ObjectMolecule * obj,
             }
 
             /* find neighbors for each atom */
-            if((cSculptVDW | cSculptVDW14) & mask) {
-              for(aa = 0; aa < n_active; aa++) {
-                b0 = active[aa];
-                a0 = atm2idx[b0];
-                ai0 = obj->AtomInfo + b0;
-                v0 = cs_coord + 3 * a0;
-                don_b0 = I->Don[b0];
-                acc_b0 = I->Acc[b0];
-                v0i = (int) (*v0);
-                v1i = (int) (*(v0 + 1));
-                v2i = (int) (*(v0 + 2));
-                x0i = ex_hash_i0(b0);
-                for(h = -4; h < 5; h += 4) {
-                  nb_off0 = nb_hash_off_i0(v0i, h);
-                  for(k = -4; k < 5; k += 4) {
-                    nb_off1 = nb_off0 | nb_hash_off_i1(v1i, k);
-                    for(l = -4; l < 5; l += 4) {
-                      /*  offset = *(I->NBHash+nb_hash_off(v0,h,k,l)); */
-                      offset = I->NBHash[nb_off1 | nb_hash_off_i2(v2i, l)];
-                      while(offset) {
-                        i = I->NBList + offset;
-                        b1 = *(i + 2);
-                        if(b1 > b0) {
-                          /* determine exclusion (if any) */
-                          {
-                            int xoffset;
-                            const int *I_EXList = I->EXList.data();
-                            int ex1;
-                            const int *j;
-                            xoffset = I->EXHash[x0i | ex_hash_i1(b1)];
-                            ex = 10;
-                            while(xoffset) {
-                              xoffset = (*(j = I_EXList + xoffset));
-                              if((*(j + 1) == b0) && (*(j + 2) == b1)) {
-                                ex1 = *(j + 3);
-                                if(ex1 < ex) {
-                                  ex = ex1;
-                                }
-                              }
-                            }
-                          }
-                          if(ex > 3) {
-                            ai1 = obj->AtomInfo + b1;
-                            cutoff = ai0->vdw + ai1->vdw;
-
-                            if(ex == 10) {      /* standard interaction -- no exclusion */
-                              if(don_b0 && I->Acc[b1]) {        /* h-bond */
-                                if(ai0->protons == cAN_H) {
-                                  cutoff -= hb_overlap;
-                                } else {
-                                  cutoff -= hb_overlap_base;
-                                }
-                              } else if(acc_b0 && I->Don[b1]) { /* h-bond */
-                                if(ai1->protons == cAN_H) {
-                                  cutoff -= hb_overlap;
-                                } else {
-                                  cutoff -= hb_overlap_base;
-                                }
-                              }
-                              if(cSculptVDW & mask) {
-                                vdw_cutoff = cutoff * vdw;
-                                wt = vdw_wt * vdw_magnified;
-                                a1 = atm2idx[b1];
-                                v1 = cs_coord + 3 * a1;
-                                if(vdw_vis_mode && cgo && (n_cycle < 1)
-                                   && ((!((ai0->protekted != cAtomProtected_off &&
-                                           ai1->protekted != cAtomProtected_off)
-                                          || (ai0->flags & ai1->flags & cAtomFlag_fix))
-                                       ) || (ai0->flags & cAtomFlag_study)
-                                       || (ai1->flags & cAtomFlag_study))) {
-                                  SculptCGOBump(v0, v1, ai0->vdw, ai1->vdw, cutoff,
-                                                vdw_vis_min, vdw_vis_mid, vdw_vis_max,
-                                                good_color, bad_color, vdw_vis_mode, cgo);
-                                }
-                                if(SculptCheckBump(v0, v1, diff, &len, vdw_cutoff))
-                                  if(SculptDoBump(vdw_cutoff, len, diff,
-                                                  disp + b0 * 3, disp + b1 * 3, wt,
-                                                  &total_strain)) {
-                                    cnt[b0]++;
-                                    cnt[b1]++;
-                                    total_count++;
-                                  }
-                              }
-                            } else if(ex == 4) {        /* 1-4 interation */
-                              cutoff *= vdw14;
-                              wt = vdw_wt14 * vdw_magnified;
-
-                              if(cSculptVDW14 & mask) {
-                                a1 = atm2idx[b1];
-                                v1 = cs_coord + 3 * a1;
-                                if(SculptCheckBump(v0, v1, diff, &len, cutoff)) {
-                                  if(SculptDoBump(cutoff, len, diff,
-                                                  disp + b0 * 3, disp + b1 * 3, wt,
-                                                  &total_strain)) {
-                                    cnt[b0]++;
-                                    cnt[b1]++;
-                                    total_count++;
-                                  }
-                                }
-                              }
-                            } else if(ex == 5) {
-                              /* do nothing */
-                            }
-                          }
+            if(vdw_pass) {
+              pymol::parallel_for(G, n_active, pair_grain,
+                  [&](std::size_t begin, std::size_t end, unsigned) {
+                auto& chunk = pairs[begin / pair_grain];
+                for(auto q = begin; q < end; ++q) {
+                  int b0 = active[q];
+                  const AtomInfoType *ai0 = obj->AtomInfo + b0;
+                  float *v0 = cs_coord + 3 * atm2idx[b0];
+                  int don_b0 = I->Don[b0];
+                  int acc_b0 = I->Acc[b0];
+                  for_each_hashed(b0, v0, 4, [&](int b1) {
+                    int ex = get_ex(b0, b1);
+                    if(ex <= 3 || ex == 5)
+                      return;
+
+                    const AtomInfoType *ai1 = obj->AtomInfo + b1;
+                    float *v1 = cs_coord + 3 * atm2idx[b1];
+                    float cutoff = ai0->vdw + ai1->vdw;
+                    float diff[3], len;
+                    SculptPairResult p;
+                    p.b0 = b0;
+                    p.b1 = b1;
+
+                    if(ex == 10) {      /* standard interaction -- no exclusion */
+                      if(!(cSculptVDW & mask))
+                        return;
+                      if(don_b0 && I->Acc[b1]) {        /* h-bond */
+                        if(ai0->protons == cAN_H) {
+                          cutoff -= hb_overlap;
+                        } else {
+                          cutoff -= hb_overlap_base;
+                        }
+                      } else if(acc_b0 && I->Don[b1]) { /* h-bond */
+                        if(ai1->protons == cAN_H) {
+                          cutoff -= hb_overlap;
+                        } else {
+                          cutoff -= hb_overlap_base;
                         }
-                        offset = (*i);
                       }
+                      float vdw_cutoff = cutoff * vdw;
+                      p.draw = draw
+                        && ((!((ai0->protekted != cAtomProtected_off &&
+                                ai1->protekted != cAtomProtected_off)
+                               || (ai0->flags & ai1->flags & cAtomFlag_fix))
+                            ) || (ai0->flags & cAtomFlag_study)
+                            || (ai1->flags & cAtomFlag_study));
+                      p.cutoff = cutoff;
+                      if(SculptCheckBump(v0, v1, diff, &len, vdw_cutoff))
+                        p.bump = SculptDoBump(vdw_cutoff, len, diff,
+                                              p.disp[0], p.disp[1],
+                                              vdw_wt * vdw_magnified, &p.strain);
+                    } else if(ex == 4) {        /* 1-4 interation */
+                      if(!(cSculptVDW14 & mask))
+                        return;
+                      cutoff *= vdw14;
+                      if(SculptCheckBump(v0, v1, diff, &len, cutoff))
+                        p.bump = SculptDoBump(cutoff, len, diff,
+                                              p.disp[0], p.disp[1],
+                                              vdw_wt14 * vdw_magnified, &p.strain);
                     }
-                  }
+
+                    if(p.bump || p.draw)
+                      chunk.push_back(p);
+                  });
                 }
-              }
+              });
+
+              apply_pairs();
             }
 
-            if(cSculptAvoid & mask) {
-              float target;
-              float range = solvent_radius * 0.75;
+            if(avd_pass) {
               /* tweak nb distances to avoid
                  sitting in the surface
                  rendition danger zone for too
                  long (vdw1+vdw2+0.75*solvent) */
-              for(aa = 0; aa < n_active; aa++) {
-                b0 = active[aa];
-                a0 = atm2idx[b0];
-                ai0 = obj->AtomInfo + b0;
-                v0 = cs_coord + 3 * a0;
-                don_b0 = I->Don[b0];
-                acc_b0 = I->Acc[b0];
-                v0i = (int) (*v0);
-                v1i = (int) (*(v0 + 1));
-                v2i = (int) (*(v0 + 2));
-                x0i = ex_hash_i0(b0);
-                for(h = -8; h < 9; h += 4) {
-                  nb_off0 = nb_hash_off_i0(v0i, h);
-                  for(k = -8; k < 9; k += 4) {
-                    nb_off1 = nb_off0 | nb_hash_off_i1(v1i, k);
-                    for(l = -8; l < 9; l += 4) {
-                      /*  offset = *(I->NBHash+nb_hash_off(v0,h,k,l)); */
-                      offset = I->NBHash[nb_off1 | nb_hash_off_i2(v2i, l)];
-                      while(offset) {
-                        i = I->NBList + offset;
-                        b1 = *(i + 2);
-                        if(b1 > b0) {
-                          /* determine exclusion (if any) */
-                          {
-                            int xoffset;
-                            const int *I_EXList = I->EXList.data();
-                            int ex1;
-                            const int *j;
-                            xoffset = I->EXHash[x0i | ex_hash_i1(b1)];
-                            ex = 10;
-                            while(xoffset) {
-                              xoffset = (*(j = I_EXList + xoffset));
-                              if((*(j + 1) == b0) && (*(j + 2) == b1)) {
-                                ex1 = *(j + 3);
-                                if(ex1 < ex) {
-                                  ex = ex1;
-                                }
-                              }
-                            }
-                          }
-                          if(ex > avd_ex) {     /* either non-covalent or extended chain */
-                            ai1 = obj->AtomInfo + b1;
-                            target = ai0->vdw + ai1->vdw + avd_gp;
-                            a1 = atm2idx[b1];
-                            v1 = cs_coord + 3 * a1;
-
-                            if(SculptCheckAvoid(v0, v1, diff, &len, target, avd_rg)) {
-                              if(SculptDoAvoid(target, range, len, diff,
-                                               disp + b0 * 3, disp + b1 * 3, avd_wt,
-                                               &total_strain)) {
-                                cnt[b0]++;
-                                cnt[b1]++;
-                                total_count++;
-                              }
-                            }
-                          }
-                        }
-                        offset = (*i);
-                      }
+              float range = solvent_radius * 0.75;
+
+              pymol::parallel_for(G, n_active, pair_grain,
+                  [&](std::size_t begin, std::size_t end, unsigned) {
+                auto& chunk = pairs[begin / pair_grain];
+                for(auto q = begin; q < end; ++q) {
+                  int b0 = active[q];
+                  const AtomInfoType *ai0 = obj->AtomInfo + b0;
+                  float *v0 = cs_coord + 3 * atm2idx[b0];
+                  for_each_hashed(b0, v0, 8, [&](int b1) {
+                    if(get_ex(b0, b1) <= avd_ex) /* either non-covalent or extended chain */
+                      return;
+
+                    const AtomInfoType *ai1 = obj->AtomInfo + b1;
+                    float *v1 = cs_coord + 3 * atm2idx[b1];
+                    float target = ai0->vdw + ai1->vdw + avd_gp;
+                    float diff[3], len;
+                    SculptPairResult p;
+                    p.b0 = b0;
+                    p.b1 = b1;
+
+                    if(SculptCheckAvoid(v0, v1, diff, &len, target, avd_rg)) {
+                      p.bump = SculptDoAvoid(target, range, len, diff,
+                                             p.disp[0], p.disp[1], avd_wt,
+                                             &p.strain);
+                      if(p.bump)
+                        chunk.push_back(p);
                     }
-                  }
+                  });
                 }
-              }
+              });
+
+              apply_pairs();
             }
 
             /* clean up nonbonded hash */
 
-            i = I->NBList + 2;
+            int *i = I->NBList + 2;
             while(nb_next > 1) {
               I->NBHash[*i] = 0;
               i += 3;
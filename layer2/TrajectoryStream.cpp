@@ -0,0 +1,419 @@
+/*
+ * On-demand loading of trajectory states
+ *
+ * (c) Schrodinger, Inc.
+ */
+
+#include "TrajectoryStream.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "CoordSet.h"
+#include "Feedback.h"
+#include "ObjectMolecule.h"
+#include "PyMOLGlobals.h"
+#include "Setting.h"
+#include "Vector.h"
+
+namespace pymol
+{
+
+TrajectoryStream::TrajectoryStream(PyMOLGlobals* G)
+    : m_G(G)
+    , m_prefetch(std::make_shared<Prefetch>())
+{
+}
+
+// The copy shares the (serialized) readers, but not the decoded frames
+TrajectoryStream::TrajectoryStream(const TrajectoryStream& other)
+    : m_G(other.m_G)
+    , m_prefetch(std::make_shared<Prefetch>())
+{
+  std::lock_guard<std::mutex> lock(other.m_mutex);
+  m_sources = other.m_sources;
+  m_states = other.m_states;
+  m_lru = other.m_lru;
+}
+
+void TrajectoryStream::addSource(ObjectMolecule* obj,
+    std::unique_ptr<TrajectoryReader> reader, const CoordSet* cs,
+    int first_state, std::vector<int> frames, std::vector<int> xref)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const int source = m_sources.size();
+
+  m_sources.emplace_back();
+  m_sources.back().reader = std::make_shared<Reader>();
+  m_sources.back().reader->impl = std::move(reader);
+  m_sources.back().xref = std::move(xref);
+
+  const int stop = first_state + frames.size();
+  if (m_states.size() < std::size_t(stop)) {
+    m_states.resize(stop);
+  }
+
+  for (int state = first_state; state < stop; ++state) {
+    m_states[state].source = source;
+    m_states[state].frame = frames[state - first_state];
+  }
+
+  // drop entries of states which we've just replaced
+  m_lru.remove_if([&](const Resident& entry) {
+    return entry.state >= first_state && entry.state < stop;
+  });
+
+  // close files which don't back any state anymore
+  std::vector<bool> used(m_sources.size());
+  for (auto& ref : m_states) {
+    if (ref.source >= 0)
+      used[ref.source] = true;
+  }
+  for (int i = 0; i != source; ++i) {
+    if (!used[i])
+      m_sources[i].reader.reset();
+  }
+
+  assert(obj->CSet[first_state] == cs);
+  m_lru.push_front({first_state, cs, source, false});
+}
+
+bool TrajectoryStream::isStreamed(int state) const
+{
+  return state >= 0 && std::size_t(state) < m_states.size() &&
+         m_states[state].source >= 0;
+}
+
+void TrajectoryStream::release(int state)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if (isStreamed(state)) {
+    m_states[state] = StateRef();
+  }
+  m_lru.remove_if([&](const Resident& entry) { return entry.state == state; });
+}
+
+/**
+ * False if the state was dropped or replaced by a coordinate set which
+ * didn't come from us.
+ */
+bool TrajectoryStream::isResident(
+    const ObjectMolecule* obj, const Resident& entry) const
+{
+  return entry.state < obj->NCSet && obj->CSet[entry.state] == entry.cs;
+}
+
+/**
+ * Any resident state of `source`. All of them have the same atoms as the
+ * frames which still need to be decoded.
+ */
+const CoordSet* TrajectoryStream::findTemplate(
+    const ObjectMolecule* obj, int source) const
+{
+  for (auto& entry : m_lru) {
+    if (entry.source == source && isResident(obj, entry)) {
+      return entry.cs;
+    }
+  }
+  return nullptr;
+}
+
+bool TrajectoryStream::readFrame(const StateRef& ref, TrajectoryFrame& out)
+{
+  auto& reader = *m_sources[ref.source].reader;
+  const FrameKey key(ref.source, ref.frame);
+
+  // a read-ahead task may be decoding this frame right now
+  std::lock_guard<std::mutex> reader_lock(reader.mutex);
+
+  {
+    std::lock_guard<std::mutex> lock(m_prefetch->mutex);
+    auto it = m_prefetch->frames.find(key);
+    if (it != m_prefetch->frames.end()) {
+      out = std::move(it->second);
+      m_prefetch->frames.erase(it);
+      return true;
+    }
+  }
+
+  return reader.impl->read(ref.frame, out);
+}
+
+CoordSet* TrajectoryStream::fetch(ObjectMolecule* obj, int state, bool pin)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return fetchImpl(obj, state, pin);
+}
+
+void TrajectoryStream::fetchAll(ObjectMolecule* obj, bool pin)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (int state = 0; state < obj->NCSet; ++state) {
+    fetchImpl(obj, state, pin);
+  }
+}
+
+CoordSet* TrajectoryStream::fetchImpl(ObjectMolecule* obj, int state, bool pin)
+{
+  if (state < 0 || state >= obj->NCSet) {
+    return nullptr;
+  }
+
+  auto cs = obj->CSet[state];
+
+  if (!isStreamed(state)) {
+    return cs;
+  }
+
+  if (cs) {
+    auto it = std::find_if(m_lru.begin(), m_lru.end(),
+        [&](const Resident& entry) { return entry.cs == cs; });
+    if (it != m_lru.end()) {
+      it->pinned |= pin;
+      m_lru.splice(m_lru.begin(), m_lru, it);
+    }
+    return cs;
+  }
+
+  const auto& ref = m_states[state];
+  const auto* tmpl = findTemplate(obj, ref.source);
+
+  if (!tmpl) {
+    PRINTFB(m_G, FB_ObjectMolecule, FB_Errors)
+      " ObjectMolecule-Error: no template to restore streamed state %d\n",
+      state + 1 ENDFB(m_G);
+    return nullptr;
+  }
+
+  TrajectoryFrame frame;
+  if (!readFrame(ref, frame)) {
+    PRINTFB(m_G, FB_ObjectMolecule, FB_Errors)
+      " ObjectMolecule-Error: failed to read frame %d for state %d\n",
+      ref.frame + 1, state + 1 ENDFB(m_G);
+    return nullptr;
+  }
+
+  cs = CoordSetCopy(tmpl);
+  cs->Obj = obj;
+
+  const auto& xref = m_sources[ref.source].xref;
+  const int natoms = frame.coords.size() / 3;
+
+  for (int i = 0; i < natoms; ++i) {
+    int idx = xref.empty() ? i : xref[i];
+    if (idx >= 0 && idx < cs->NIndex) {
+      copy3f(frame.coords.data() + 3 * i, cs->coordPtr(idx));
+    }
+  }
+
+  cs->Symmetry = std::move(frame.symmetry);
+  cs->invalidateRep(cRepAll, cRepInvRep);
+
+  obj->CSet[state] = cs;
+  m_lru.push_front({state, cs, ref.source, pin});
+  stateChanged(obj);
+
+  readAhead(obj, state);
+
+  return cs;
+}
+
+void TrajectoryStream::trim(ObjectMolecule* obj)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const int capacity = std::max(
+      1, SettingGet<int>(m_G, obj->Setting.get(), nullptr,
+             cSetting_traj_stream_cache));
+
+  std::vector<int> n_per_source(m_sources.size());
+  int n_unpinned = 0;
+
+  for (auto it = m_lru.begin(); it != m_lru.end();) {
+    if (!isResident(obj, *it)) {
+      it = m_lru.erase(it);
+      continue;
+    }
+    ++n_per_source[it->source];
+    if (!it->pinned)
+      ++n_unpinned;
+    ++it;
+  }
+
+  bool changed = false;
+
+  for (auto it = m_lru.end(); n_unpinned > capacity && it != m_lru.begin();) {
+    --it;
+
+    // keep one state of every file as the template for the others
+    if (it->pinned || n_per_source[it->source] < 2)
+      continue;
+
+    --n_per_source[it->source];
+    --n_unpinned;
+
+    delete obj->CSet[it->state];
+    obj->CSet[it->state] = nullptr;
+    it = m_lru.erase(it);
+    changed = true;
+  }
+
+  if (changed) {
+    stateChanged(obj);
+  }
+}
+
+/**
+ * Decodes the frames of the states following `state` on the task pool.
+ */
+void TrajectoryStream::readAhead(const ObjectMolecule* obj, int state)
+{
+  auto pool = parallel_pool(m_G);
+  const int n_ahead = SettingGet<int>(
+      m_G, obj->Setting.get(), nullptr, cSetting_traj_stream_read_ahead);
+
+  // without started pool threads, tasks would only run inside of other waits
+  if (!pool || !pool->threads() || n_ahead < 1) {
+    return;
+  }
+
+  std::vector<FrameKey> wanted;
+  for (int s = state + 1; s <= state + n_ahead && s < obj->NCSet; ++s) {
+    if (isStreamed(s) && !obj->CSet[s]) {
+      wanted.emplace_back(m_states[s].source, m_states[s].frame);
+    }
+  }
+
+  std::vector<FrameKey> todo;
+  {
+    std::lock_guard<std::mutex> lock(m_prefetch->mutex);
+    auto& frames = m_prefetch->frames;
+
+    // forget frames which are not ahead of us anymore (e.g. after seeking)
+    for (auto it = frames.begin(); it != frames.end();) {
+      if (std::find(wanted.begin(), wanted.end(), it->first) == wanted.end()) {
+        it = frames.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    for (auto& key : wanted) {
+      if (!frames.count(key) && m_prefetch->pending.insert(key).second) {
+        todo.push_back(key);
+      }
+    }
+  }
+
+  if (todo.empty()) {
+    return;
+  }
+
+  std::vector<std::shared_ptr<Reader>> readers;
+  for (auto& key : todo) {
+    readers.push_back(m_sources[key.first].reader);
+  }
+
+  auto prefetch = m_prefetch;
+  auto& group = prefetch->group;
+  pool->submit(group, [prefetch, readers = std::move(readers),
+                          todo = std::move(todo)]() {
+    for (std::size_t i = 0; i != todo.size(); ++i) {
+      TrajectoryFrame frame;
+      bool ok;
+      {
+        std::lock_guard<std::mutex> reader_lock(readers[i]->mutex);
+        ok = readers[i]->impl->read(todo[i].second, frame);
+      }
+      std::lock_guard<std::mutex> lock(prefetch->mutex);
+      prefetch->pending.erase(todo[i]);
+      if (ok) {
+        prefetch->frames[todo[i]] = std::move(frame);
+      }
+    }
+  });
+}
+
+/**
+ * The set of present states affects selections with state dependent
+ * keywords, so both the coordinate and the state change counters move.
+ */
+void TrajectoryStream::stateChanged(ObjectMolecule* obj) const
+{
+  obj->bumpVersion(cRepInvCoord);
+  obj->StateVersion = obj->CoordVersion;
+}
+
+void TrajectoryStream::rebind(
+    const ObjectMolecule* obj, const ObjectMolecule* copy)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (auto it = m_lru.begin(); it != m_lru.end();) {
+    if (isResident(obj, *it) && it->state < copy->NCSet &&
+        copy->CSet[it->state]) {
+      it->cs = copy->CSet[it->state];
+      ++it;
+    } else {
+      it = m_lru.erase(it);
+    }
+  }
+}
+
+void TrajectoryStream::adjustAtmIdx(const ObjectMolecule* obj, const int* lookup)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (int source = 0; source != int(m_sources.size()); ++source) {
+    const auto* tmpl = findTemplate(obj, source);
+    if (!tmpl)
+      continue;
+
+    // old to new coordinate index, like CoordSetAdjustAtmIdx
+    std::vector<int> idx_new(tmpl->NIndex, -1);
+    for (int idx = 0, n = 0; idx < tmpl->NIndex; ++idx) {
+      if (lookup[tmpl->IdxToAtm[idx]] != -1) {
+        idx_new[idx] = n++;
+      }
+    }
+
+    auto& xref = m_sources[source].xref;
+    if (!m_sources[source].reader)
+      continue;
+    const int natoms = m_sources[source].reader->impl->natoms();
+
+    if (xref.empty()) {
+      xref.resize(natoms);
+      for (int i = 0; i < natoms; ++i) {
+        xref[i] = i;
+      }
+    }
+
+    for (auto& idx : xref) {
+      if (idx >= 0) {
+        idx = idx < tmpl->NIndex ? idx_new[idx] : -1;
+      }
+    }
+  }
+}
+
+void TrajectoryStream::reorder(const int* order, int len)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<StateRef> states(len);
+  std::vector<int> new_state(len, -1);
+
+  for (int a = 0; a < len; ++a) {
+    if (std::size_t(order[a]) < m_states.size()) {
+      states[a] = m_states[order[a]];
+    }
+    new_state[order[a]] = a;
+  }
+
+  m_states = std::move(states);
+
+  for (auto& entry : m_lru) {
+    if (entry.state < len) {
+      entry.state = new_state[entry.state];
+    }
+  }
+}
+
+} // namespace pymol
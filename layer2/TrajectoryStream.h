@@ -0,0 +1,176 @@
+/*
+ * On-demand loading of trajectory states
+ *
+ * (c) Schrodinger, Inc.
+ */
+
+#pragma once
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "PyMOLGlobals.h"
+#include "Symmetry.h"
+#include "TaskPool.h"
+
+struct CoordSet;
+struct ObjectMolecule;
+
+namespace pymol
+{
+
+/// One decoded trajectory frame
+struct TrajectoryFrame {
+  std::vector<float> coords;
+  std::unique_ptr<CSymmetry> symmetry;
+};
+
+/**
+ * Trajectory file with random access to its frames. Implementations don't
+ * need to be thread-safe, `TrajectoryStream` serializes all calls.
+ */
+class TrajectoryReader
+{
+public:
+  virtual ~TrajectoryReader() = default;
+
+  /// Number of atoms per frame
+  virtual int natoms() const = 0;
+
+  /**
+   * Decodes a frame. Sequential access should be cheap, going backwards may
+   * reopen the file.
+   * @param frame 0-based frame index in the file
+   */
+  virtual bool read(int frame, TrajectoryFrame& out) = 0;
+};
+
+/**
+ * Backs states of an `ObjectMolecule` by trajectory files instead of keeping
+ * all coordinate sets in memory.
+ *
+ * Streamed states which are not resident have a null `CSet` entry, so state
+ * consumers must go through `ObjectMolecule::getCoordSet`, and code which
+ * modifies a state through `ObjectMolecule::pinCoordSet`. States are
+ * decoded on access (`fetch`) into a new coordinate set, which is a copy of
+ * another resident state of the same file with the frame's coordinates. The
+ * least recently used states are dropped again by `trim`, which must only be
+ * called where nobody holds on to `CoordSet` pointers of the object.
+ *
+ * After a state was fetched, the following states are decoded on the task
+ * pool ("traj_stream_read_ahead"), so that movie playback doesn't wait for
+ * the file.
+ *
+ * States which got modified (`alter_state`, fitting, transformations) are
+ * pinned and never dropped.
+ *
+ * The public methods may be called concurrently (e.g. `fetch` through
+ * `ObjectMolecule::getCoordSet` from representation tasks).
+ */
+class TrajectoryStream
+{
+public:
+  explicit TrajectoryStream(PyMOLGlobals* G);
+  TrajectoryStream(const TrajectoryStream& other);
+  TrajectoryStream& operator=(const TrajectoryStream&) = delete;
+
+  /**
+   * Streams `frames.size()` states starting at `first_state` from `reader`.
+   * @param cs Resident coordinate set for `first_state`, must already be
+   * stored in `obj->CSet`
+   * @param frames 0-based file frame for each state
+   * @param xref File atom to coordinate index mapping (-1 to skip), or empty
+   * for identity
+   */
+  void addSource(ObjectMolecule* obj, std::unique_ptr<TrajectoryReader> reader,
+      const CoordSet* cs, int first_state, std::vector<int> frames,
+      std::vector<int> xref);
+
+  /// Stops streaming `state`, e.g. because it gets replaced
+  void release(int state);
+
+  /**
+   * Makes `state` resident. May exceed the cache size until the next `trim`.
+   * @param pin Never drop this state again (it got modified)
+   * @return The coordinate set or null
+   */
+  CoordSet* fetch(ObjectMolecule* obj, int state, bool pin = false);
+
+  /**
+   * Makes all states resident, for operations which need every state at
+   * once. Exceeds the cache size until the next `trim`.
+   * @param pin Never drop these states again (they get modified)
+   */
+  void fetchAll(ObjectMolecule* obj, bool pin = false);
+
+  /// Drops the least recently used states beyond "traj_stream_cache"
+  void trim(ObjectMolecule* obj);
+
+  /// Takes over the resident states of `obj` into its copy `copy`
+  void rebind(const ObjectMolecule* obj, const ObjectMolecule* copy);
+
+  /**
+   * Follows the removal of atoms, must be called before the coordinate sets
+   * get adjusted (see `CoordSetAdjustAtmIdx`).
+   * @param lookup Old to new atom index, -1 for removed atoms
+   */
+  void adjustAtmIdx(const ObjectMolecule* obj, const int* lookup);
+
+  /// Follows `ObjectMoleculeSetStateOrder`
+  void reorder(const int* order, int len);
+
+private:
+  struct Reader {
+    std::mutex mutex;
+    std::unique_ptr<TrajectoryReader> impl;
+  };
+
+  struct Source {
+    std::shared_ptr<Reader> reader;
+    std::vector<int> xref;
+  };
+
+  struct StateRef {
+    int source = -1;
+    int frame = -1;
+  };
+
+  struct Resident {
+    int state;
+    const CoordSet* cs;
+    int source;
+    bool pinned;
+  };
+
+  using FrameKey = std::pair<int, int>; ///< (source, frame)
+
+  struct Prefetch {
+    std::mutex mutex;
+    std::map<FrameKey, TrajectoryFrame> frames;
+    std::set<FrameKey> pending;
+    TaskGroup group;
+  };
+
+  /// True if `state` is backed by a trajectory file
+  bool isStreamed(int state) const;
+  bool isResident(const ObjectMolecule* obj, const Resident& entry) const;
+  const CoordSet* findTemplate(const ObjectMolecule* obj, int source) const;
+  CoordSet* fetchImpl(ObjectMolecule* obj, int state, bool pin);
+  bool readFrame(const StateRef& ref, TrajectoryFrame& out);
+  void readAhead(const ObjectMolecule* obj, int state);
+  void stateChanged(ObjectMolecule* obj) const;
+
+  PyMOLGlobals* m_G;
+  mutable std::mutex m_mutex; ///< guards the members below
+  std::vector<Source> m_sources;
+  std::vector<StateRef> m_states;
+  std::list<Resident> m_lru; ///< most recently used first
+  std::shared_ptr<Prefetch> m_prefetch;
+};
+
+} // namespace pymol
@@ -153,7 +153,13 @@ bool SeleCoordIterator::next() {
       prev_obj = obj;
     }
 
-    if(state >= obj->NCSet || !(cs = obj->CSet[state]))
+    if(state >= obj->NCSet)
+      continue;
+
+    // decodes streamed trajectory states on demand
+    cs = obj->getCoordSet(state);
+
+    if (!cs)
       continue;
 
     atm = I->Table[a].atom;
@@ -24,6 +24,7 @@
 #include <cassert>
 #include <clocale>
 #include <vector>
+#include <limits>
 
 #include "pymol/type_traits.h"
 
@@ -1715,6 +1716,15 @@ static int get_op_cnt(PyMOLGlobals * G)
   return result;
 }
 
+static std::string ExecutiveFoldName(const char* name, size_t len)
+{
+  std::string folded(name, len);
+  for (auto& c : folded) {
+    c = tolower((unsigned char) c);
+  }
+  return folded;
+}
+
 static int ExecutiveAddKey(CExecutive * I, SpecRec * rec)
 {
   int ok = false;
@@ -1723,6 +1733,7 @@ static int ExecutiveAddKey(CExecutive * I, SpecRec * rec)
     I->Key[result.word] = rec->cand_id;
     ok = true;
   }
+  I->NameIndex.emplace(ExecutiveFoldName(rec->name, strlen(rec->name)), rec);
   return ok;
 }
 
@@ -1739,48 +1750,125 @@ static int ExecutiveDelKey(CExecutive * I, SpecRec * rec)
       }
     }
   }
+  auto range = I->NameIndex.equal_range(
+      ExecutiveFoldName(rec->name, strlen(rec->name)));
+  for (auto it = range.first; it != range.second; ++it) {
+    if (it->second == rec) {
+      I->NameIndex.erase(it);
+      break;
+    }
+  }
   return ok;
 }
 
+/**
+ * Records whose name equals (`exact`) or starts with the first `len`
+ * characters of `name`, in no particular order.
+ *
+ * @param max_count Stop after this many records
+ */
+static std::vector<SpecRec*> ExecutiveNameIndexFind(CExecutive* I,
+    const char* name, size_t len, bool exact, bool ignore_case,
+    size_t max_count = std::numeric_limits<size_t>::max())
+{
+  std::vector<SpecRec*> found;
+  auto const key = ExecutiveFoldName(name, len);
+  auto it = I->NameIndex.lower_bound(key);
+  for (; it != I->NameIndex.end() && found.size() < max_count; ++it) {
+    if (it->first.compare(0, len, key) != 0 ||
+        (exact && it->first.size() != len)) {
+      break;
+    }
+    if (ignore_case || strncmp(it->second->name, name, len) == 0) {
+      found.push_back(it->second);
+    }
+  }
+  return found;
+}
+
+/**
+ * First of `recs` in object menu panel order
+ */
+static SpecRec* ExecutiveFirstInSpecOrder(
+    CExecutive* I, const std::vector<SpecRec*>& recs)
+{
+  if (recs.size() < 2) {
+    return recs.empty() ? nullptr : recs.front();
+  }
+  SpecRec* rec = nullptr;
+  while (ListIterate(I->Spec, rec, next)) {
+    if (std::find(recs.begin(), recs.end(), rec) != recs.end()) {
+      return rec;
+    }
+  }
+  return nullptr;
+}
+
+/**
+ * Resolves a name pattern which is a list of names and prefixes with a
+ * trailing wildcard (e.g. "pose1 pose2 lig*") with the name index, in the
+ * order of all_names_list (which is cand_id order).
+ *
+ * @return false if the pattern needs the generic word matcher
+ */
+static bool ExecutiveNameIndexFindPattern(CExecutive* I, const char* pattern,
+    char wildcard, bool ignore_case, std::vector<SpecRec*>& found)
+{
+  if (wildcard == ' ')
+    wildcard = 0;
+
+  for (const char* p = pattern; *p;) {
+    if (*p == ' ' || *p == ',') {
+      ++p;
+      continue;
+    }
+    size_t len = strcspn(p, " ,");
+    bool prefix = wildcard && p[len - 1] == wildcard;
+    size_t literal_len = prefix ? len - 1 : len;
+    for (size_t i = 0; i != literal_len; ++i) {
+      if (p[i] == '\\' || p[i] == ':' || p[i] == wildcard)
+        return false;
+    }
+    auto words = ExecutiveNameIndexFind(I, p, literal_len, !prefix, ignore_case);
+    found.insert(found.end(), words.begin(), words.end());
+    p += len;
+  }
+
+  std::sort(found.begin(), found.end(),
+      [](const SpecRec* a, const SpecRec* b) { return a->cand_id < b->cand_id; });
+  found.erase(std::unique(found.begin(), found.end()), found.end());
+  return true;
+}
+
 static SpecRec *ExecutiveUnambiguousNameMatch(PyMOLGlobals * G, const char *name)
 {
   CExecutive *I = G->Executive;
-  SpecRec *result = NULL;
-  SpecRec *rec = NULL;
-  int best = 0;
-  int wm;
   int ignore_case = SettingGetGlobal_b(G, cSetting_ignore_case);
 
-  while(ListIterate(I->Spec, rec, next)) {
-    wm = WordMatch(G, name, rec->name, ignore_case);
-    if(wm < 0) {                /* exact match, so this is valid */
-      result = rec;
-      best = wm;
-      break;
-    } else if((wm > 0) && (best < wm)) {
-      result = rec;
-      best = wm;
-    } else if((wm > 0) && (best == wm)) {       /* ambiguous match... no good */
-      result = NULL;
-    }
+  // same rules as WordMatch: with a wildcard, everything before it must
+  // match. Otherwise an exact match, or the only name which starts with
+  // "name".
+  size_t len = strcspn(name, "*");
+  if (name[len]) {
+    return ExecutiveFirstInSpecOrder(
+        I, ExecutiveNameIndexFind(I, name, len, false, ignore_case));
   }
-  return (result);
+
+  auto found = ExecutiveNameIndexFind(I, name, len, true, ignore_case);
+  if (found.empty()) {
+    found = ExecutiveNameIndexFind(I, name, len, false, ignore_case, 2);
+    if (found.size() != 1)
+      return nullptr;
+  }
+  return ExecutiveFirstInSpecOrder(I, found);
 }
 
 static SpecRec *ExecutiveAnyCaseNameMatch(PyMOLGlobals * G, const char *name)
 {
   CExecutive *I = G->Executive;
-  SpecRec *result = NULL;
-  SpecRec *rec = NULL;
-
   int ignore_case = SettingGetGlobal_b(G, cSetting_ignore_case);
-  while(ListIterate(I->Spec, rec, next)) {
-    if(WordMatchExact(G, name, rec->name, ignore_case)) {
-      result = rec;
-      break;
-    }
-  }
-  return (result);
+  return ExecutiveFirstInSpecOrder(I,
+      ExecutiveNameIndexFind(I, name, strlen(name), true, ignore_case));
 }
 
 /**
@@ -2041,7 +2129,22 @@ int ExecutiveGetNamesListFromPattern(PyMOLGlobals * G, const char *name,
   WordMatchOptionsConfigNameList(&options,
                                  *wildcard, SettingGetGlobal_b(G, cSetting_ignore_case));
   matcher = WordMatcherNew(G, name, &options, /* force= */ match_not);
-  if(matcher || match_enabled) {
+  std::vector<SpecRec*> indexed;
+  if(matcher && !match_enabled && !match_not &&
+      ExecutiveNameIndexFindPattern(I, name, *wildcard,
+        SettingGetGlobal_b(G, cSetting_ignore_case), indexed)) {
+    for (auto rec : indexed) {
+      if(rec->type == cExecAll)
+        continue;
+      if((rec->type == cExecObject) && (rec->obj->type == cObjectGroup))
+        group_found = true;
+      if(!result)
+        result = TrackerNewList(I_Tracker, NULL);
+      if(result) {
+        TrackerLink(I_Tracker, rec->cand_id, result, 1);
+      }
+    }
+  } else if(matcher || match_enabled) {
     if(iter_id) {
       while((cand_id = TrackerIterNextCandInList(I_Tracker, iter_id,
                                                  (TrackerRef **) (void *) &rec))) {
@@ -2123,6 +2226,10 @@ int ExecutiveGroup(PyMOLGlobals * G, pymol::zstring_view nameView,
 {
   auto name = nameView.c_str();
   auto members = membersView.c_str();
+
+  // group names can be used in selection expressions
+  SelectorCacheClear(G);
+
   if (action == cExecutiveGroupUngroup) {
     // Up to PyMOL 2.3 the member argument was ignored and 'name' used for ungrouping
     if (name[0]) {
@@ -3515,6 +3622,8 @@ pymol::Result<std::vector<DiscardedRec>> ExecutiveSetName(
   auto old_name = old_name_view.c_str();
   auto new_name = new_name_view.c_str();
 
+  SelectorCacheClear(G);
+
   ObjectNameType name;
   UtilNCopy(name, new_name, sizeof(ObjectNameType));
 
@@ -3680,6 +3789,7 @@ ExecutiveLoadPrepareArgs(PyMOLGlobals * G,
   case cLoadTypePDBStr:
   case cLoadTypeVDBStr:
   case cLoadTypeCIFStr:
+  case cLoadTypeBCIFStr:
   case cLoadTypeMMTFStr:
   case cLoadTypeMAEStr:
   case cLoadTypeXPLORStr:
@@ -3702,12 +3812,10 @@ ExecutiveLoadPrepareArgs(PyMOLGlobals * G,
   case cLoadTypePDBQT:
   case cLoadTypePDB:
   case cLoadTypeCIF:
+  case cLoadTypeBCIF:
   case cLoadTypeMMTF:
   case cLoadTypeMAE:
   case cLoadTypeXPLORMap:
-  case cLoadTypeCCP4Map:
-  case cLoadTypeCCP4Unspecified:
-  case cLoadTypeMRC:
   case cLoadTypePHIMap:
   case cLoadTypeMMD:
   case cLoadTypeMOL:
@@ -3735,6 +3843,15 @@ ExecutiveLoadPrepareArgs(PyMOLGlobals * G,
 
     break;
 
+  // memory mapped by ObjectMapLoadCCP4
+  case cLoadTypeCCP4Map:
+  case cLoadTypeCCP4Unspecified:
+  case cLoadTypeMRC:
+    if (content) {
+      fname_null_ok = true;
+    }
+    break;
+
   // molfile_plugin based formats
   case cLoadTypeCUBEMap:
     args.plugin = "cube";
@@ -3883,6 +4000,14 @@ pymol::Result<> ExecutiveLoad(PyMOLGlobals* G, ExecutiveLoadArgs const& args)
     p_return_if_error(res);
     obj = res.result();
   } break;
+  case cLoadTypeBCIF:
+  case cLoadTypeBCIFStr: {
+    auto res =
+        ObjectMoleculeReadBCifStr(G, static_cast<ObjectMolecule*>(origObj),
+            content, size, state, discrete, quiet, multiplex, zoom);
+    p_return_if_error(res);
+    obj = res.result();
+  } break;
   case cLoadTypeMMTF:
   case cLoadTypeMMTFStr:
     obj = ObjectMoleculeReadMmtfStr(G, (ObjectMolecule *) origObj,
@@ -3969,8 +4094,16 @@ pymol::Result<> ExecutiveLoad(PyMOLGlobals* G, ExecutiveLoadArgs const& args)
   case cLoadTypeCCP4UnspecifiedStr:
   case cLoadTypeMRC:
   case cLoadTypeMRCStr:
-    obj = ObjectMapLoadCCP4(G, (ObjectMap *) origObj, content,
-        state, true, size, quiet, content_format);
+    if (args.content.empty() && !args.fname.empty()) {
+      obj = ObjectMapLoadCCP4(G, (ObjectMap *) origObj, fname,
+          state, false, 0, quiet, content_format);
+      if (!obj) {
+        return pymol::make_error("Unable to open file '", fname, "'");
+      }
+    } else {
+      obj = ObjectMapLoadCCP4(G, (ObjectMap *) origObj, content,
+          state, true, size, quiet, content_format);
+    }
     break;
   case cLoadTypeCGO:
     obj = ObjectCGOFromFloatArray(G, (ObjectCGO *) origObj,
@@ -4083,6 +4216,8 @@ pymol::CObject* ExecutiveGetExistingCompatible(PyMOLGlobals * G, const char* ona
     case cLoadTypeVDBStr:
     case cLoadTypeCIF:
     case cLoadTypeCIFStr:
+    case cLoadTypeBCIF:
+    case cLoadTypeBCIFStr:
     case cLoadTypeMMTF:
     case cLoadTypeMMTFStr:
     case cLoadTypeXYZ:
@@ -4165,6 +4300,10 @@ int ExecutiveProcessPDBFile(PyMOLGlobals * G, pymol::CObject * origObj,
   pdb_info->multiplex = multiplex;
   pdb_info->variant = variant;
 
+  // ATOM/HETATM records of all models and objects, parsed in parallel
+  auto atom_records = ObjectMoleculePDBParseAtomRecords(G, buffer, variant);
+  pdb_info->atom_records = atom_records.get();
+
   while(repeat_flag && ok) {
     const char *start_at = buffer;
     int is_repeat_pass = false;
@@ -4525,8 +4664,10 @@ int ExecutiveSetVisFromPyDict(PyMOLGlobals * G, PyObject * dict)
 
 /**
  * returns a pointer to the data in a volume or map object
+ * @param writable The caller may modify the data, now or later (no-copy
+ * NumPy view)
  */
-CField * ExecutiveGetVolumeField(PyMOLGlobals * G, const char * objName, int state) {
+CField * ExecutiveGetVolumeField(PyMOLGlobals * G, const char * objName, int state, bool writable) {
   ObjectMapState *oms;
   pymol::CObject *obj;
 
@@ -4539,6 +4680,12 @@ CField * ExecutiveGetVolumeField(PyMOLGlobals * G, const char * objName, int sta
   case cObjectMap:
     oms = ObjectMapGetState((ObjectMap *) obj, state);
     ok_assert(1, oms && oms->Field);
+    IsofieldDecode(G, oms->Field.get());
+    if (writable) {
+      // the bricks index would go stale with every write
+      oms->Field->data_exposed = true;
+      oms->Field->bricks = nullptr;
+    }
     return oms->Field->data.get();
   }
 
@@ -4967,28 +5114,38 @@ pymol::Result<> ExecutiveRampNew(PyMOLGlobals* G, const char* name,
   return {};
 }
 
+/**
+ * @param names Iterable of named entries, a list or e.g. a generator which
+ * decodes the entries one at a time (pymol.psc)
+ * @param[out] selections Selection entries are appended to this list, to be
+ * restored with ExecutiveSetSelectionsFromPyList once all objects exist
+ */
 static int ExecutiveSetNamedEntries(PyMOLGlobals * G, PyObject * names, int version,
-                                    int part_rest, int part_sess)
+                                    int part_rest, int part_sess, PyObject * selections)
 {
   CExecutive *I = G->Executive;
   int ok = true;
   int skip = false;
-  int a = 0, l = 0, ll = 0;
+  int ll = 0;
   PyObject *cur, *el;
   SpecRec *rec = NULL;
   int extra_int;
   int incomplete = false;
   ObjectNameType new_name;
+  unique_PyObject_ptr iter;
 
   if(ok)
     ok = (names != NULL);
-  if(ok)
-    ok = PyList_Check(names);
-  if(ok)
-    l = PyList_Size(names);
+  if(ok) {
+    iter.reset(PyObject_GetIter(names));
+    ok = (iter != nullptr);
+  }
 
-  while(ok && (a < l)) {
-    cur = PyList_GetItem(names, a);
+  while(ok) {
+    unique_PyObject_ptr item(PyIter_Next(iter.get()));
+    if(!item)
+      break;
+    cur = item.get();
     if(cur != Py_None) {        /* skip over None w/o aborting */
       skip = false;
       rec = NULL;
@@ -5086,6 +5243,8 @@ static int ExecutiveSetNamedEntries(PyMOLGlobals * G, PyObject * names, int vers
         rec->sele_color = extra_int;
         if(part_rest || part_sess) {    // don't attempt to restore selections with partial sessions
           skip = true;
+        } else {
+          PyList_Append(selections, cur);
         }
         break;
       }
@@ -5143,7 +5302,6 @@ static int ExecutiveSetNamedEntries(PyMOLGlobals * G, PyObject * names, int vers
         ListElemFree(rec);
       }
     }
-    a++;
     if(!ok) {
       incomplete = true;
       ok = true;
@@ -5293,7 +5451,12 @@ static PyObject *ExecutiveGetExecSeleAsPyList(PyMOLGlobals * G, SpecRec * rec)
   return (PConvAutoNone(result));
 }
 
-static PyObject *ExecutiveGetNamedEntries(PyMOLGlobals * G, int list_id, int partial)
+/**
+ * @param sink If not NULL, pass each entry to this callable instead of
+ * collecting them, and return an empty list
+ */
+static PyObject *ExecutiveGetNamedEntries(PyMOLGlobals * G, int list_id, int partial,
+                                          PyObject * sink)
 {
   CExecutive *I = G->Executive;
   CTracker *I_Tracker = I->Tracker;
@@ -5310,7 +5473,7 @@ static PyObject *ExecutiveGetNamedEntries(PyMOLGlobals * G, int list_id, int par
   } else {
     total_count = ExecutiveCountNames(G);
   }
-  result = PyList_New(total_count);
+  result = PyList_New(sink ? 0 : total_count);
 
   /* critical reliance on short-circuit behavior */
 
@@ -5322,30 +5485,33 @@ static PyObject *ExecutiveGetNamedEntries(PyMOLGlobals * G, int list_id, int par
       rec = list_rec;
     if(count >= total_count)
       break;
+    PyObject *entry = NULL;
     if(rec) {
       switch (rec->type) {
       case cExecObject:
-        PyList_SetItem(result, count, ExecutiveGetExecObjectAsPyList(G, rec));
+        entry = ExecutiveGetExecObjectAsPyList(G, rec);
         break;
       case cExecSelection:
         if(!partial) {
-          PyList_SetItem(result, count, ExecutiveGetExecSeleAsPyList(G, rec));
-        } else {
-          /* cannot currently save selections in partial sessions */
-          PyList_SetItem(result, count, PConvAutoNone(NULL));
+          entry = ExecutiveGetExecSeleAsPyList(G, rec);
         }
-        break;
-      default:
-        PyList_SetItem(result, count, PConvAutoNone(NULL));
+        /* cannot currently save selections in partial sessions */
         break;
       }
-    } else {
-      PyList_SetItem(result, count, PConvAutoNone(NULL));
+    }
+    if(!sink) {
+      PyList_SetItem(result, count, PConvAutoNone(entry));
+    } else if(entry) {
+      PyObject *ret = PyObject_CallFunctionObjArgs(sink, entry, NULL);
+      Py_DECREF(entry);
+      if(!ret)
+        break;
+      Py_DECREF(ret);
     }
     count++;
   }
 
-  while(count < total_count) {  /* insure that all members of outgoing list are defined */
+  while(!sink && count < total_count) {  /* insure that all members of outgoing list are defined */
     PyList_SetItem(result, count, PConvAutoNone(NULL));
     count++;
   }
@@ -5360,8 +5526,12 @@ static PyObject *ExecutiveGetNamedEntries(PyMOLGlobals * G, int list_id, int par
 #include "ExecutiveEvalMessage.h"
 #endif
 
+/**
+ * @param sink Optional callable which receives the named entries one at a
+ * time, "names" is then an empty list (see ExecutiveGetNamedEntries)
+ */
 int ExecutiveGetSession(PyMOLGlobals * G, PyObject * dict, const char *names, int partial,
-                        int quiet)
+                        int quiet, PyObject * sink)
 {
   assert(PyGILState_Check());
 
@@ -5381,10 +5551,14 @@ int ExecutiveGetSession(PyMOLGlobals * G, PyObject * dict, const char *names, in
   PyDict_SetItemString(dict, "version", tmp);
   Py_XDECREF(tmp);
 
-  tmp = ExecutiveGetNamedEntries(G, list_id, partial);
+  tmp = ExecutiveGetNamedEntries(G, list_id, partial, sink);
   PyDict_SetItemString(dict, "names", tmp);
   Py_XDECREF(tmp);
 
+  if(PyErr_Occurred()) {        /* raised by sink */
+    return false;
+  }
+
   tmp = ColorAsPyList(G);
   PyDict_SetItemString(dict, "colors", tmp);
   Py_XDECREF(tmp);
@@ -5702,11 +5876,13 @@ int ExecutiveSetSession(PyMOLGlobals * G, PyObject * session,
   if(ok) {
     tmp = PyDict_GetItemString(session, "names");
     if(tmp) {
+      unique_PyObject_ptr selections(PyList_New(0));
       if(ok)
-        ok = ExecutiveSetNamedEntries(G, tmp, version, partial_restore, partial_session);
+        ok = ExecutiveSetNamedEntries(G, tmp, version, partial_restore,
+            partial_session, selections.get());
       if(!(partial_restore || partial_session)) {
         if(ok)
-          ok = ExecutiveSetSelectionsFromPyList(G, tmp);
+          ok = ExecutiveSetSelectionsFromPyList(G, selections.get());
         if(ok)
           have_active = ExecutiveGetActiveSeleName(G, active, false, false);
       }
@@ -6516,6 +6692,7 @@ pymol::Result<> ExecutiveMapSet(PyMOLGlobals* G, const char* name,
 
     ms = &target->State[target_state];
     if(ms->Active) {
+      IsofieldDecode(G, ms->Field.get());
       int iter_id = TrackerNewIter(I_Tracker, 0, list_id);
       int n_pnt = (ms->Field->points->size() / ms->Field->points->base_size) / 3;
       float *pnt = (float *) ms->Field->points->data.data();
@@ -6686,6 +6863,7 @@ pymol::Result<> ExecutiveMapSet(PyMOLGlobals* G, const char* name,
       /* copy after calculation so that operand can include target */
 
       memcpy(ms->Field->data->data.data(), l_value, n_pnt * sizeof(float));
+      ms->Field->bricks = nullptr;
 
       FreeP(present);
       FreeP(l_value);
@@ -10094,7 +10272,7 @@ pymol::Result<int> ExecutiveIterateList(PyMOLGlobals* G, const char* str1,
 	  if(obj->DiscreteFlag && obj->DiscreteCSet) {
 	    cs = obj->DiscreteCSet[index - 1];
 	  } else if (obj->NCSet == 1){
-	    cs = obj->CSet[0];
+	    cs = obj->getCoordSet(0);
 	  }
           auto expr_co =
               unique_PyObject_ptr(Py_CompileString(expr, "", Py_single_input));
@@ -13962,7 +14140,7 @@ void ExecutiveSymExp(PyMOLGlobals * G, const char *name,
   // Get symmetry from first coordset
   const CSymmetry* sym = nullptr;
   for (int b = 0; b < obj->NCSet && !sym; ++b) {
-    if (auto const* cs = obj->CSet[b]) {
+    if (auto const* cs = obj->getCoordSet(b)) {
       sym = cs->getSymmetry();
     }
   }
@@ -14019,7 +14197,7 @@ void ExecutiveSymExp(PyMOLGlobals * G, const char *name,
 
   std::vector<glm::vec3> cs_centers(obj->NCSet);
   for (int b = 0; b < obj->NCSet; ++b) {
-    if (auto const* cs = obj->CSet[b]) {
+    if (auto const* cs = obj->getCoordSet(b)) {
       CoordSetGetAverage(cs, glm::value_ptr(cs_centers[b]));
     }
   }
@@ -14034,7 +14212,7 @@ void ExecutiveSymExp(PyMOLGlobals * G, const char *name,
           bool keepFlag = false;
 
           for (int b = 0; b < new_obj->NCSet; ++b) {
-            auto* cs = new_obj->CSet[b];
+            auto* cs = new_obj->pinCoordSet(b);
             if (!cs) {
               continue;
             }
@@ -14144,6 +14322,7 @@ void ExecutivePurgeSpec(PyMOLGlobals * G, SpecRec * rec, bool save)
   ExecutiveInvalidatePanelList(G);
   switch (rec->type) {
   case cExecObject:
+    SelectorCacheClear(G);
     if(I->LastEdited == rec->obj)
       I->LastEdited = NULL;
     if(rec->obj->type == cObjectMolecule)
@@ -127,6 +127,9 @@ enum cLoadType_t : int {
 
   cLoadTypeCCP4UnspecifiedStr = 76,
   cLoadTypeMRCStr = 77,
+
+  cLoadTypeBCIF = 78,
+  cLoadTypeBCIFStr = 79,
 };
 
 /* NOTE: if you add new content/object type above, then be sure to add
@@ -605,7 +608,7 @@ pymol::Result<> ExecutiveSymmetryCopy(PyMOLGlobals * G,
 			  const char *source_name, const char *target_name,
 			  int source_state, int target_state, int quiet);
 int ExecutiveGetSession(PyMOLGlobals * G, PyObject * dict, const char *names, int partial,
-                        int quiet);
+                        int quiet, PyObject * sink = nullptr);
 int ExecutiveSetSession(PyMOLGlobals * G, PyObject * session, int partial_restore,
                         int quiet);
 int ExecutiveSetSessionNoMLock(PyMOLGlobals* G, PyObject* session);
@@ -648,7 +651,7 @@ pymol::Result<> ExecutiveReinitialize(PyMOLGlobals * G, int what, pymol::zstring
 const char *ExecutiveFindBestNameMatch(PyMOLGlobals * G, const char *name);
 int ExecutiveSetVisFromPyDict(PyMOLGlobals * G, PyObject * dict);
 PyObject *ExecutiveGetVisAsPyDict(PyMOLGlobals * G);
-CField   *ExecutiveGetVolumeField(PyMOLGlobals * G, const char * objName, int state);
+CField   *ExecutiveGetVolumeField(PyMOLGlobals * G, const char * objName, int state, bool writable = true);
 pymol::Result<> ExecutiveSetVolumeRamp(PyMOLGlobals* G, const char* objName, std::vector<float> ramp_list, int state);
 PyObject* ExecutiveGetVolumeRamp(PyMOLGlobals* G, const char* objName, int state);
 
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <map>
+#include <string>
 #include <unordered_map>
 
 #include "Ortho.h"
@@ -69,6 +71,9 @@ struct CExecutive : public Block {
   int all_names_list_id {}, all_obj_list_id {}, all_sel_list_id {};
   OVLexicon *Lex {};
   std::unordered_map<ov_word, int> Key;
+  // case folded name -> record, sorted for partial name and wildcard
+  // lookups. Maintained together with Key.
+  std::multimap<std::string, SpecRec*> NameIndex;
   bool ValidGroups { false };
   bool ValidSceneMembers { false };
   int ValidGridSlots {};
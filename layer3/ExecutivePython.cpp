@@ -7,6 +7,18 @@
 #include "ObjectMap.h"
 #include "P.h"
 #include "Feedback.h"
+#include "AtomInfo.h"
+#include "AtomIterators.h"
+#include "ObjectMolecule.h"
+#include "PConv.h"
+#include "PyMOL.h"
+#include "Scene.h"
+#include "Selector.h"
+#include "TaskPool.h"
+#include "os_numpy.h"
+
+#include <algorithm>
+#include <vector>
 
 pymol::Result<> ExecutiveLoadObject(PyMOLGlobals* G,
     const char* oname, PyObject* model, int frame, int type, int finish,
@@ -318,4 +330,233 @@ pymol::Result<PyObject*> ExecutiveGetRawAlignment(PyMOLGlobals* G,
   return pymol::make_error("No such alignment: ", name);
 }
 
+#ifdef _PYMOL_NUMPY
+/**
+ * Atoms of a selection, in selection order
+ */
+struct AtomColumnTarget {
+  std::vector<AtomInfoType*> atoms;
+  std::vector<ObjectMolecule*> objects;
+};
+
+static pymol::Result<AtomColumnTarget> AtomColumnTargetFromSele(
+    PyMOLGlobals* G, const char* s1)
+{
+  auto tmpsele = SelectorTmp::make(G, s1);
+  p_return_if_error(tmpsele);
+
+  SelectorUpdateTable(G, cSelectorUpdateTableAllStates, -1);
+
+  AtomColumnTarget target;
+  SeleAtomIterator iter(G, tmpsele->getIndex());
+  while (iter.next()) {
+    if (target.objects.empty() || target.objects.back() != iter.obj) {
+      target.objects.push_back(iter.obj);
+    }
+    target.atoms.push_back(iter.getAtomInfo());
+  }
+  return target;
+}
+
+/**
+ * Lookup atom properties which map to a NumPy dtype
+ */
+static pymol::Result<std::vector<const AtomPropertyInfo*>> AtomColumnProperties(
+    PyMOLGlobals* G, PyObject* names)
+{
+  std::vector<std::string> names_vec;
+  if (!PConvFromPyObject(G, names, names_vec)) {
+    return pymol::make_error("property names must be a list of strings");
+  }
+
+  std::vector<const AtomPropertyInfo*> props;
+  for (auto& name : names_vec) {
+    auto ap = PyMOL_GetAtomPropertyInfo(G->PyMOL, name.c_str());
+    if (!ap) {
+      return pymol::make_error("unknown atom property: ", name);
+    }
+    switch (ap->Ptype) {
+    case cPType_float:
+    case cPType_int:
+    case cPType_schar:
+    case cPType_uint32:
+      break;
+    default:
+      return pymol::make_error("not a numeric atom property: ", name);
+    }
+    props.push_back(ap);
+  }
+  return props;
+}
+
+static int AtomColumnTypenum(const AtomPropertyInfo* ap)
+{
+  switch (ap->Ptype) {
+  case cPType_float:
+    return NPY_FLOAT32;
+  case cPType_schar:
+    return NPY_INT8;
+  case cPType_uint32:
+    return NPY_UINT32;
+  }
+  return NPY_INT32;
+}
+
+template <typename T>
+static void AtomColumnCopy(PyMOLGlobals* G,
+    const std::vector<AtomInfoType*>& atoms, std::size_t offset, void* data,
+    bool to_atoms)
+{
+  auto column = static_cast<T*>(data);
+  pymol::parallel_for(G, atoms.size(), 65536,
+      [&](std::size_t begin, std::size_t end, unsigned) {
+        for (std::size_t i = begin; i != end; ++i) {
+          auto field = reinterpret_cast<T*>(
+              reinterpret_cast<char*>(atoms[i]) + offset);
+          if (to_atoms) {
+            *field = column[i];
+          } else {
+            column[i] = *field;
+          }
+        }
+      });
+}
+
+static void AtomColumnCopy(PyMOLGlobals* G,
+    const std::vector<AtomInfoType*>& atoms, const AtomPropertyInfo* ap,
+    void* data, bool to_atoms)
+{
+  switch (ap->Ptype) {
+  case cPType_float:
+    AtomColumnCopy<float>(G, atoms, ap->offset, data, to_atoms);
+    break;
+  case cPType_schar:
+    AtomColumnCopy<signed char>(G, atoms, ap->offset, data, to_atoms);
+    break;
+  case cPType_uint32:
+    AtomColumnCopy<uint32_t>(G, atoms, ap->offset, data, to_atoms);
+    break;
+  default:
+    AtomColumnCopy<int>(G, atoms, ap->offset, data, to_atoms);
+  }
+}
+#endif
+
+pymol::Result<PyObject*> ExecutiveGetAtomColumns(
+    PyMOLGlobals* G, const char* s1, PyObject* names)
+{
+#ifndef _PYMOL_NUMPY
+  return pymol::make_error("No numpy support");
+#else
+  import_array1(pymol::make_error("numpy import failed"));
+
+  auto props = AtomColumnProperties(G, names);
+  p_return_if_error(props);
+
+  auto target = AtomColumnTargetFromSele(G, s1);
+  p_return_if_error(target);
+
+  const auto& atoms = target->atoms;
+  npy_intp dims[1] = {npy_intp(atoms.size())};
+
+  PyObject* result = PyList_New(props->size());
+  for (std::size_t i = 0; i != props->size(); ++i) {
+    auto ap = props->at(i);
+    auto array = PyArray_SimpleNew(1, dims, AtomColumnTypenum(ap));
+    if (!array) {
+      Py_DECREF(result);
+      return pymol::make_error("array allocation failed");
+    }
+    AtomColumnCopy(G, atoms, ap,
+        PyArray_DATA(reinterpret_cast<PyArrayObject*>(array)), false);
+    PyList_SET_ITEM(result, i, array);
+  }
+  return result;
+#endif
+}
+
+pymol::Result<int> ExecutiveSetAtomColumns(
+    PyMOLGlobals* G, const char* s1, PyObject* names, PyObject* columns)
+{
+#ifndef _PYMOL_NUMPY
+  return pymol::make_error("No numpy support");
+#else
+  import_array1(pymol::make_error("numpy import failed"));
+
+  auto props = AtomColumnProperties(G, names);
+  p_return_if_error(props);
+
+  if (!PySequence_Check(columns) ||
+      PySequence_Size(columns) != Py_ssize_t(props->size())) {
+    return pymol::make_error("need one column per property");
+  }
+
+  auto target = AtomColumnTargetFromSele(G, s1);
+  p_return_if_error(target);
+
+  const auto& atoms = target->atoms;
+
+  // convert and validate all columns before modifying anything
+  std::vector<unique_PyObject_ptr> arrays;
+  for (std::size_t i = 0; i != props->size(); ++i) {
+    auto ap = props->at(i);
+    unique_PyObject_ptr item(PySequence_GetItem(columns, i));
+    unique_PyObject_ptr array(PyArray_FROM_OTF(item.get(),
+        AtomColumnTypenum(ap), NPY_ARRAY_IN_ARRAY | NPY_ARRAY_FORCECAST));
+    if (!array) {
+      PyErr_Clear();
+      return pymol::make_error("column ", i + 1, " is not a numeric array");
+    }
+    auto pyarray = reinterpret_cast<PyArrayObject*>(array.get());
+    if (PyArray_NDIM(pyarray) != 1 ||
+        PyArray_DIM(pyarray, 0) != npy_intp(atoms.size())) {
+      return pymol::make_error("column ", i + 1, " has ",
+          PyArray_SIZE(pyarray), " values, selection has ", atoms.size(),
+          " atoms");
+    }
+    arrays.push_back(std::move(array));
+  }
+
+  auto level = cRepInvNone;
+
+  for (std::size_t i = 0; i != props->size(); ++i) {
+    auto ap = props->at(i);
+    AtomColumnCopy(G, atoms, ap,
+        PyArray_DATA(reinterpret_cast<PyArrayObject*>(arrays[i].get())), true);
+
+    // same side effects as assignment in alter
+    switch (ap->id) {
+    case ATOM_PROP_RESV:
+      for (auto ai : atoms)
+        ai->inscode = '\0';
+      break;
+    case ATOM_PROP_FORMAL_CHARGE:
+      for (auto ai : atoms)
+        ai->chemFlag = false;
+      break;
+    }
+
+    switch (ap->id) {
+    case ATOM_PROP_COLOR:
+      level = std::max(level, cRepInvColor);
+      break;
+    case ATOM_PROP_REPS:
+      level = std::max(level, cRepInvVisib);
+      break;
+    default:
+      level = std::max(level, cRepInvRep);
+    }
+  }
+
+  if (level != cRepInvNone) {
+    for (auto obj : target->objects) {
+      obj->invalidate(cRepAll, level, -1);
+    }
+    SceneChanged(G);
+  }
+
+  return int(atoms.size());
+#endif
+}
+
 #endif
@@ -29,4 +29,23 @@ pymol::Result<float> ExecutiveFitPairs(
 pymol::Result<PyObject*> ExecutiveGetRawAlignment(PyMOLGlobals* G,
     pymol::null_safe_zstring_view name, bool active_only, int state);
 
+/**
+ * Get numeric atom properties of the selected atoms as contiguous 1d NumPy
+ * arrays (float32, int32, int8 or uint32, depending on the property).
+ * @param names sequence of property names, as in iterate (b, q, resv, ...)
+ * @return list of arrays, in the order of `names`
+ */
+pymol::Result<PyObject*> ExecutiveGetAtomColumns(
+    PyMOLGlobals* G, const char* s1, PyObject* names);
+
+/**
+ * Set numeric atom properties of the selected atoms from 1d arrays, the
+ * inverse of ExecutiveGetAtomColumns.
+ * @param names sequence of property names
+ * @param columns sequence of arrays (or sequences), one per name
+ * @return number of atoms modified
+ */
+pymol::Result<int> ExecutiveSetAtomColumns(
+    PyMOLGlobals* G, const char* s1, PyObject* names, PyObject* columns);
+
 #endif //_PYMOL_NO_PY
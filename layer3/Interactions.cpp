@@ -503,11 +503,11 @@ static bool CheckHalogenBondAsDonor(ObjectMolecule* don_obj, int don_atom,
 
   // first, check for existence of coordinate sets
   if (don_state >= 0 && don_state < don_obj->NCSet) {
-    csD = don_obj->CSet[don_state];
+    csD = don_obj->getCoordSet(don_state);
   }
 
   if (acc_state >= 0 && acc_state < acc_obj->NCSet) {
-    csA = acc_obj->CSet[acc_state];
+    csA = acc_obj->getCoordSet(acc_state);
   }
 
   if (csD == nullptr) {
@@ -591,11 +591,11 @@ static bool CheckHalogenBondAsAcceptor(ObjectMolecule* don_obj, int don_atom,
 
   // first, check for existence of coordinate sets
   if (don_state >= 0 && don_state < don_obj->NCSet) {
-    csD = don_obj->CSet[don_state];
+    csD = don_obj->getCoordSet(don_state);
   }
 
   if (acc_state >= 0 && acc_state < acc_obj->NCSet) {
-    csA = acc_obj->CSet[acc_state];
+    csA = acc_obj->getCoordSet(acc_state);
   }
 
   if (csD == nullptr) {
@@ -872,8 +872,8 @@ DistSet* FindHalogenBondInteractions(PyMOLGlobals* G, DistSet* ds, int sele1,
       // the states are valid for these two atoms
       if (state1 < obj1->NCSet && state2 < obj2->NCSet) {
         // get the coordinate sets for both atoms
-        CoordSet* cs1 = obj1->CSet[state1];
-        CoordSet* cs2 = obj2->CSet[state2];
+        CoordSet* cs1 = obj1->getCoordSet(state1);
+        CoordSet* cs2 = obj2->getCoordSet(state2);
         if (cs1 != nullptr && cs2 != nullptr) {
           // for bonding
           float* don_vv = nullptr;
@@ -1025,8 +1025,8 @@ DistSet* FindSaltBridgeInteractions(PyMOLGlobals* G, DistSet* ds, int sele1,
       // the states are valid for these two atoms
       if (state1 < obj1->NCSet && state2 < obj2->NCSet) {
         // get the coordinate sets for both atoms
-        CoordSet* cs1 = obj1->CSet[state1];
-        CoordSet* cs2 = obj2->CSet[state2];
+        CoordSet* cs1 = obj1->getCoordSet(state1);
+        CoordSet* cs2 = obj2->getCoordSet(state2);
         if (cs1 != nullptr && cs2 != nullptr) {
           // for bonding
           float* anion_vv = nullptr;
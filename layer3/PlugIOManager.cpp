@@ -16,6 +16,7 @@ Z* -------------------------------------------------------------------
 */
 
 #include <algorithm>
+#include <string>
 #include <vector>
 
 #include"os_python.h"
@@ -36,6 +37,7 @@ Z* -------------------------------------------------------------------
 #include "PyMOLGlobals.h"
 #include "ObjectMolecule.h"
 #include "ObjectMap.h"
+#include "TrajectoryStream.h"
 
 #ifndef _PYMOL_VMD_PLUGINS
 int PlugIOManagerInit(PyMOLGlobals * G)
@@ -150,6 +152,167 @@ static molfile_plugin_t* find_plugin(
 static CSymmetry* SymmetryNewFromTimestep(
     PyMOLGlobals* G, molfile_timestep_t* ts);
 
+/**
+ * Random access to the frames of a molfile trajectory plugin. The plugins
+ * only read forward, so going backwards reopens the file.
+ */
+class MolfileTrajectoryReader : public pymol::TrajectoryReader
+{
+  PyMOLGlobals* m_G;
+  molfile_plugin_t* m_plugin;
+  std::string m_fname;
+  std::string m_type;
+  void* m_handle = nullptr;
+  int m_natoms;
+  int m_next = 0; //!< file frame which the next read_next_timestep returns
+
+  bool reopen()
+  {
+    close();
+    int natoms = m_natoms;
+    m_handle = m_plugin->open_file_read(m_fname.c_str(), m_type.c_str(), &natoms);
+    m_next = 0;
+    return m_handle && (natoms == -1 || natoms == m_natoms);
+  }
+
+  void close()
+  {
+    if (m_handle) {
+      m_plugin->close_file_read(m_handle);
+      m_handle = nullptr;
+    }
+  }
+
+public:
+  MolfileTrajectoryReader(PyMOLGlobals* G, molfile_plugin_t* plugin,
+      const char* fname, const char* plugin_type, int natoms)
+      : m_G(G)
+      , m_plugin(plugin)
+      , m_fname(fname)
+      , m_type(plugin_type)
+      , m_natoms(natoms)
+  {
+  }
+
+  ~MolfileTrajectoryReader() override { close(); }
+
+  int natoms() const override { return m_natoms; }
+
+  /// Skips over the next frame, false at the end of the file
+  bool skip()
+  {
+    if (!m_handle && !reopen())
+      return false;
+    if (m_plugin->read_next_timestep(m_handle, m_natoms, nullptr) != MOLFILE_SUCCESS)
+      return false;
+    ++m_next;
+    return true;
+  }
+
+  bool read(int frame, pymol::TrajectoryFrame& out) override
+  {
+    if ((!m_handle || frame < m_next) && !reopen())
+      return false;
+
+    while (m_next < frame) {
+      if (!skip())
+        return false;
+    }
+
+    molfile_timestep_t timestep{};
+    out.coords.resize(3 * m_natoms);
+    timestep.coords = out.coords.data();
+
+    if (m_plugin->read_next_timestep(m_handle, m_natoms, &timestep) != MOLFILE_SUCCESS)
+      return false;
+
+    ++m_next;
+    out.symmetry.reset(SymmetryNewFromTimestep(m_G, &timestep));
+    return true;
+  }
+};
+
+/**
+ * load_traj with "traj_stream_cache": Only finds the frames which make up the
+ * new states and decodes the first one. The others are decoded on demand,
+ * see pymol::TrajectoryStream.
+ *
+ * @param cs Template coordinate set for the new states (takes ownership)
+ * @param xref File atom to coordinate index mapping, or null for identity
+ * @return Number of new states
+ */
+static int PlugIOManagerStreamTraj(PyMOLGlobals* G, ObjectMolecule* obj,
+    molfile_plugin_t* plugin, const char* fname, const char* plugin_type,
+    int natoms, CoordSet* cs, const int* xref, int frame, int interval,
+    int start, int stop, int max)
+{
+  std::unique_ptr<CoordSet> cs_owner(cs);
+  auto reader = pymol::make_unique<MolfileTrajectoryReader>(
+      G, plugin, fname, plugin_type, natoms);
+
+  // same frame selection as the eager reader (without averaging)
+  std::vector<int> frames;
+  for (int cnt = 1, icnt = interval; reader->skip(); ++cnt) {
+    if (cnt < start || --icnt > 0)
+      continue;
+    icnt = interval;
+    frames.push_back(cnt - 1);
+    if ((stop > 0 && cnt >= stop) || (max > 0 && int(frames.size()) >= max))
+      break;
+  }
+
+  if (frames.empty()) {
+    return 0;
+  }
+
+  pymol::TrajectoryFrame first;
+  if (!reader->read(frames[0], first)) {
+    PRINTFB(G, FB_ObjectMolecule, FB_Errors)
+      " ObjectMolecule: plugin '%s' failed to read '%s'.\n", plugin_type, fname
+      ENDFB(G);
+    return 0;
+  }
+
+  for (int i = 0; i < natoms; ++i) {
+    int idx = xref ? xref[i] : i;
+    if (idx >= 0) {
+      assert(idx < cs->NIndex);
+      copy3(first.coords.data() + 3 * i, cs->coordPtr(idx));
+    }
+  }
+
+  cs->invalidateRep(cRepAll, cRepInvRep);
+  cs->Symmetry = std::move(first.symmetry);
+
+  if (frame < 0)
+    frame = obj->NCSet;
+
+  const int n_states = frames.size();
+  VLACheck(obj->CSet, CoordSet*, frame + n_states - 1);
+  if (obj->NCSet < frame + n_states)
+    obj->NCSet = frame + n_states;
+
+  for (int state = frame; state < frame + n_states; ++state) {
+    delete obj->CSet[state];
+    obj->CSet[state] = nullptr;
+  }
+
+  obj->CSet[frame] = cs_owner.release();
+
+  if (!obj->TrajStream)
+    obj->TrajStream.reset(new pymol::TrajectoryStream(G));
+
+  obj->TrajStream->addSource(obj, std::move(reader), cs, frame,
+      std::move(frames),
+      xref ? std::vector<int>(xref, xref + natoms) : std::vector<int>());
+
+  PRINTFB(G, FB_ObjectMolecule, FB_Details)
+    " ObjectMolecule: streaming %d states from '%s' into states %d-%d\n",
+    n_states, fname, frame + 1, frame + n_states ENDFB(G);
+
+  return n_states;
+}
+
 int PlugIOManagerLoadTraj(PyMOLGlobals * G, ObjectMolecule * obj,
                           const char *fname, int frame,
                           int interval, int average, int start,
@@ -225,10 +388,20 @@ int PlugIOManagerLoadTraj(PyMOLGlobals * G, ObjectMolecule * obj,
 
       auto xref = LoadTrajSeleHelper(obj, cs, sele);
 
+      if (average < 2 &&
+          SettingGet<int>(G, obj->Setting.get(), nullptr, cSetting_traj_stream_cache) > 0) {
+        plugin->close_file_read(file_handle);
+        if(!obj->NCSet) zoom_flag = true;
+        PlugIOManagerStreamTraj(G, obj, plugin, fname, plugin_type,
+            natoms, cs, xref.get(), frame, interval, start, stop, max);
+        cs = NULL;
+        file_handle = NULL;
+      }
+
       auto coordbuf = std::vector<float>(natoms * 3);
       timestep.coords = coordbuf.data();
 
-      {
+      if (file_handle) {
 	  /* read_next_timestep fills in &timestep for each iteration; we need
 	   * to copy that out to a new CoordSet, each time. */
           while(!plugin->read_next_timestep(file_handle, natoms, &timestep)) {
@@ -279,6 +452,7 @@ int PlugIOManagerLoadTraj(PyMOLGlobals * G, ObjectMolecule * obj,
 		  /* bump the object's state count */
                   if(obj->NCSet <= frame) obj->NCSet = frame + 1;
 		  /* if there's data in this state's coordset, emtpy it */
+                  if (obj->TrajStream) obj->TrajStream->release(frame);
                   delete obj->CSet[frame];
 		  /* set this state's coordset to cs */
                   obj->CSet[frame] = cs;
@@ -314,8 +488,8 @@ int PlugIOManagerLoadTraj(PyMOLGlobals * G, ObjectMolecule * obj,
                 " ObjectMolecule: skipping set %d...\n", cnt ENDFB(G);
             }
           } /* end while */
+          plugin->close_file_read(file_handle);
         }
-        plugin->close_file_read(file_handle);
         delete cs;
         SceneChanged(G);
         SceneCountFrames(G);
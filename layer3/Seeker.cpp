@@ -1454,7 +1454,7 @@ void SeekerUpdate(PyMOLGlobals * G)
               last_state = 1;
               first_atom_in_label = true;
               for(b = 0; b < obj->NCSet; b++) {
-                cs = obj->CSet[b];
+                cs = obj->getCoordSet(b);
                 if(cs) {
                   default_color = SettingGet_i(G, cs->Setting.get(), obj->Setting.get(),
                                                cSetting_seq_view_color);
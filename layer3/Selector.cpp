@@ -16,7 +16,9 @@ Z* -------------------------------------------------------------------
 
 #include <algorithm>
 #include <cctype>
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -55,6 +57,7 @@ Z* -------------------------------------------------------------------
 #include"Parse.h"
 
 #include"ListMacros.h"
+#include "TaskPool.h"
 
 #ifdef _PYMOL_IP_PROPERTIES
 #endif
@@ -79,6 +82,15 @@ using SelectorInfoIter_t = decltype(CSelectorManager::Info)::iterator;
 #define cDummyOrigin 0
 #define cDummyCenter 1
 
+/* with more selections than this, member lists get long and
+   SelectorUpdateMemberBitmap builds bitmaps for SelectorIsMember */
+#define cSelectorBitmapMinSelections 16
+
+/* what a selection result depends on, besides atoms, bonds and selections */
+#define cSeleDepCoord   0x1     /* coordinates */
+#define cSeleDepState   0x2     /* current state */
+#define cSeleDepNoCache 0x4     /* anything else, result can't be cached */
+
 
 /* special selections, unknown to executive */
 #define cSelectorSecretsPrefix "_!"
@@ -120,12 +132,15 @@ inline void sele_array_calloc(sele_array_t& sele, size_t count)
   sele.reset(new int[count]());
 }
 
+struct SeleNode;
+
 struct EvalElem {
   int level, imp_op_level;
   int type;                     /* 0 = value 1 = operation 2 = pre-operation */
   unsigned int code;
   std::string m_text;
   sele_array_t sele;
+  std::shared_ptr<SeleNode> node; //!< deferred operation of a STYP_LIST
 
   // Helpers for refactoring `sele` type
   int* sele_data() { return sele.get(); }
@@ -140,6 +155,18 @@ struct EvalElem {
   const char* text() const { return m_text.c_str(); }
 };
 
+/**
+ * Operation of a compiled selection expression. `base` holds the stack
+ * entries the operation was reduced from, in the layout which the
+ * SelectorSelect/Logic/Modulate/Operator routines expect. Operand lists
+ * carry their own (not yet evaluated) nodes.
+ */
+struct SeleNode {
+  int type;                     /* STYP_ of the operator */
+  int cost;                     /* rough evaluation cost, for AND ordering */
+  std::vector<EvalElem> base;
+};
+
 typedef struct {
   int depth1;
   int depth2;
@@ -205,9 +232,116 @@ static void SelectorManagerInsertMember(
   self.Member[m].selection = sele;
   self.Member[m].tag = tag;
   self.Member[m].next = ai.selEntry;
+
+  // log the insert for the bitmaps, which catch up when used next.
+  // Replaying a long log costs about as much as rebuilding, so drop them
+  // instead.
+  if (!self.MemberBitmap.empty()) {
+    if (self.MemberLog.size() < std::max<size_t>(self.Member.size(), 4096)) {
+      self.MemberLog.push_back({SelectorMemberOffset_t(m), self.Member[m]});
+    } else {
+      self.MemberBitmap.clear();
+      self.MemberLog.clear();
+    }
+  }
+
   ai.selEntry = m;
 }
 
+/**
+ * Forget the membership bitmap of `sele`, e.g. after its members were
+ * relabeled or removed.
+ */
+static void SelectorManagerDropBitmap(CSelectorManager& self, SelectorID_t sele)
+{
+  self.MemberBitmap.erase(sele);
+  if (self.MemberBitmap.empty())
+    self.MemberLog.clear();
+}
+
+/**
+ * Get the membership bitmap of `sele` if it is up to date, without
+ * modifying anything.
+ * @return nullptr if there is none or inserts are pending
+ */
+static const SelectionBitmapRec* SelectorManagerFindBitmap(
+    const CSelectorManager& self, SelectorID_t sele)
+{
+  if (self.MemberBitmap.empty())
+    return nullptr;
+  auto it = self.MemberBitmap.find(sele);
+  if (it == self.MemberBitmap.end() ||
+      it->second.n_log != self.MemberLog.size())
+    return nullptr;
+  return &it->second;
+}
+
+/**
+ * Get the membership bitmap of `sele`, build it or apply pending inserts if
+ * necessary. Every member offset is resolved once: walk its list until the
+ * selection or an already resolved offset is found, then resolve the whole
+ * path.
+ */
+static const SelectionBitmapRec& SelectorManagerGetBitmap(
+    CSelectorManager& self, SelectorID_t sele)
+{
+  auto it = self.MemberBitmap.find(sele);
+  if (it != self.MemberBitmap.end()) {
+    auto& rec = it->second;
+    // the new list head contains what the old head contains, plus its own
+    // selection
+    for (; rec.n_log < self.MemberLog.size(); ++rec.n_log) {
+      const auto& ins = self.MemberLog[rec.n_log];
+      if (ins.member.selection == sele) {
+        rec.bits.add(ins.offset);
+        rec.tagged |= (ins.member.tag != 1);
+      } else {
+        rec.bits.set(ins.offset,
+            ins.member.next && rec.bits.contains(ins.member.next));
+      }
+    }
+    return rec;
+  }
+
+  auto& rec = self.MemberBitmap[sele];
+  rec.n_log = self.MemberLog.size();
+
+  const SelectorMemberOffset_t n_member = self.Member.size();
+  const MemberType* member = self.Member.data();
+
+  enum : signed char { Unknown = 0, No, Yes };
+  std::vector<signed char> state(n_member, Unknown);
+  std::vector<SelectorMemberOffset_t> path;
+
+  for (SelectorMemberOffset_t m = 1; m < n_member; ++m) {
+    if (state[m] != Unknown)
+      continue;
+    signed char result = No;
+    path.clear();
+    for (auto s = m; s; s = member[s].next) {
+      if (state[s] != Unknown) {
+        result = state[s];
+        break;
+      }
+      path.push_back(s);
+      if (member[s].selection == sele) {
+        result = Yes;
+        rec.tagged |= (member[s].tag != 1);
+        break;
+      }
+    }
+    for (auto s : path)
+      state[s] = result;
+  }
+
+  for (SelectorMemberOffset_t m = 1; m < n_member; ++m) {
+    if (state[m] == Yes)
+      rec.bits.add(m);
+  }
+
+  return rec;
+}
+
 /*========================================================================*/
 static void SelectorGetUniqueTmpName(PyMOLGlobals* G, char* out)
 {
@@ -799,7 +933,7 @@ int SelectorResidueVLAsTo3DMatchScores(PyMOLGlobals * G, CMatch * match,
         }
 
         if(state < obj->NCSet)
-          cs = obj->CSet[state];
+          cs = obj->getCoordSet(state);
         else
           cs = NULL;
         if(cs && neighbor && atomInfo) {
@@ -1344,6 +1478,13 @@ int SelectorClassifyAtoms(PyMOLGlobals * G, int sele, int preserve,
     }
     a++;
   }
+
+  /* flags and visRep were written without an invalidation, keep cached
+     selection results (e.g. polymer) from going stale */
+  for(auto obj_classified : I->Obj) {
+    if(obj_classified)
+      obj_classified->bumpVersion(cRepInvProp);
+  }
   return true;
 }
 
@@ -1385,7 +1526,7 @@ MapType *SelectorGetSpacialMapFromSeleCoord(PyMOLGlobals * G, int sele, int stat
 
               sta = st;
               if(sta < obj->NCSet)
-                cs = obj->CSet[sta];
+                cs = obj->getCoordSet(sta);
               else
                 cs = NULL;
               if(cs) {
@@ -1504,6 +1645,8 @@ typedef struct {
 
 static void SelectorDeleteSeleAtIter(PyMOLGlobals* G, SelectorInfoIter_t it)
 {
+  if (!SelectorIsTmp(it->name))
+    SelectorCacheClear(G);
   SelectorPurgeMembers(G, it->ID);
   G->SelectorMgr->Info.erase(it);
 }
@@ -1812,7 +1955,7 @@ int SelectorAssignSS(PyMOLGlobals * G, int target, int present,
         if(res[a].present) {
           obj = res[a].obj;
           if(state < obj->NCSet)
-            cs = obj->CSet[state];
+            cs = obj->getCoordSet(state);
           else
             cs = NULL;
           for(b = 0; b < 4; b++) {
@@ -2695,6 +2838,7 @@ PyObject *SelectorColorectionGet(PyMOLGlobals * G, const char *prefix)
       n_used++;
     }
   }
+  SelectorCacheClear(G);
   for(a = 0; a < n_used; a++) {
     /* create selections */
 
@@ -3023,6 +3167,7 @@ int SelectorFromPyList(PyMOLGlobals * G, const char *name, PyObject * list)
 
   /* get rid of existing selection */
   SelectorDelete(G, name);
+  SelectorCacheClear(G);
 
   int sele = I->NSelection++;
   I->Info.emplace_back(SelectionInfoRec(sele, name));
@@ -3140,8 +3285,8 @@ int SelectorVdwFit(PyMOLGlobals * G, int sele1, int state1, int sele2, int state
       obj2 = I->Obj[I->Table[a2].model];
 
       if((state1 < obj1->NCSet) && (state2 < obj2->NCSet)) {
-        cs1 = obj1->CSet[state1];
-        cs2 = obj2->CSet[state2];
+        cs1 = obj1->getCoordSet(state1);
+        cs2 = obj2->getCoordSet(state2);
         if(cs1 && cs2) {        /* should always be true */
 
           ai1 = obj1->AtomInfo + at1;
@@ -3177,8 +3322,8 @@ int SelectorVdwFit(PyMOLGlobals * G, int sele1, int state1, int sele2, int state
       obj2 = I->Obj[I->Table[a2].model];
 
       if((state1 < obj1->NCSet) && (state2 < obj2->NCSet)) {
-        cs1 = obj1->CSet[state1];
-        cs2 = obj2->CSet[state2];
+        cs1 = obj1->getCoordSet(state1);
+        cs2 = obj2->getCoordSet(state2);
         if(cs1 && cs2) {        /* should always be true */
 
           ai1 = obj1->AtomInfo + at1;
@@ -3256,8 +3401,8 @@ int SelectorGetPairIndices(PyMOLGlobals * G, int sele1, int state1, int sele2, i
       obj2 = I->Obj[I->Table[a2].model];
 
       if(state1 < obj1->NCSet && state2 < obj2->NCSet) {
-        cs1 = obj1->CSet[state1];
-        cs2 = obj2->CSet[state2];
+        cs1 = obj1->getCoordSet(state1);
+        cs2 = obj2->getCoordSet(state2);
         if(cs1 && cs2) {
           idx1 = cs1->atmToIdx(at1);
           idx2 = cs2->atmToIdx(at2);
@@ -3614,6 +3759,7 @@ void SelectorUpdateObjectSele(PyMOLGlobals * G, ObjectMolecule * obj)
           }
         }
         obj->need_hetatm_classification = false;
+        obj->bumpVersion(cRepInvProp);
       }
     }
   }
@@ -3703,10 +3849,35 @@ void SelectorLogSele(PyMOLGlobals * G, const char *name)
  * @param s    AtomInfoType.selEntry
  * @param sele selection index or 0 for "all"
  */
+/**
+ * Build or update the membership bitmap of `sele`, if member lists are long
+ * enough for SelectorIsMember to benefit from it. Call before testing many
+ * atoms, not from worker threads.
+ */
+void SelectorUpdateMemberBitmap(PyMOLGlobals * G, SelectorID_t sele)
+{
+  auto I = G->SelectorMgr;
+  if(sele > 1 && I->Info.size() > cSelectorBitmapMinSelections)
+    SelectorManagerGetBitmap(*I, sele);
+}
+
+/**
+ * Does not modify the selector, safe to call from worker threads.
+ */
 int SelectorIsMember(PyMOLGlobals * G, SelectorMemberOffset_t s, SelectorID_t sele)
 {
   if(sele > 1) {
-    const MemberType *mem, *member = G->SelectorMgr->Member.data();
+    const auto I = G->SelectorMgr;
+    if(!s)
+      return false;
+    /* member lists get long, answer from the bitmap if up to date */
+    if(auto rec = SelectorManagerFindBitmap(*I, sele)) {
+      if(!rec->bits.contains(s))
+        return false;
+      if(!rec->tagged)
+        return true;
+    }
+    const MemberType *mem, *member = I->Member.data();
     for (; s; s = mem->next) {
       mem = member + s;
       if (mem->selection == sele)
@@ -3730,6 +3901,11 @@ bool SelectorMoveMember(PyMOLGlobals * G, SelectorMemberOffset_t s, SelectorID_t
     }
     s = I->Member[s].next;
   }
+  if(result) {
+    SelectorManagerDropBitmap(*I, sele_old);
+    SelectorManagerDropBitmap(*I, sele_new);
+    SelectorCacheClear(G);
+  }
   return result;
 }
 
@@ -4554,7 +4730,9 @@ int SelectorGetSeleNCSet(PyMOLGlobals * G, SelectorID_t sele)
     int idx;
 
     while(a--) {
-      cs = obj->CSet[a];
+      cs = obj->getCoordSet(a);
+      if(!cs)
+        continue;
       idx = cs->atmToIdx(at);
       if(idx >= 0) {
         result = a + 1;
@@ -4650,8 +4828,8 @@ float SelectorSumVDWOverlap(PyMOLGlobals * G, int sele1, int state1, int sele2,
     obj2 = I->Obj[I->Table[a2].model];
 
     if((state1 < obj1->NCSet) && (state2 < obj2->NCSet)) {
-      cs1 = obj1->CSet[state1];
-      cs2 = obj2->CSet[state2];
+      cs1 = obj1->getCoordSet(state1);
+      cs2 = obj2->getCoordSet(state2);
       if(cs1 && cs2) {          /* should always be true */
 
         ai1 = obj1->AtomInfo + at1;
@@ -4760,7 +4938,7 @@ int SelectorMapMaskVDW(PyMOLGlobals * G, int sele1, ObjectMapState * oMap, float
         else
           state1 = state;
         if(state1 < obj->NCSet)
-          cs = obj->CSet[state1];
+          cs = obj->getCoordSet(state1);
         else
           cs = NULL;
         if(cs) {
@@ -5120,7 +5298,7 @@ int SelectorMapGaussian(PyMOLGlobals * G, int sele1, ObjectMapState * oMap,
         else
           state2 = state;
         if(state2 < obj->NCSet)
-          cs = obj->CSet[state2];
+          cs = obj->getCoordSet(state2);
         else
           cs = NULL;
         if(cs) {
@@ -5165,7 +5343,7 @@ int SelectorMapGaussian(PyMOLGlobals * G, int sele1, ObjectMapState * oMap,
         else
           state2 = state;
         if(state2 < obj->NCSet)
-          cs = obj->CSet[state2];
+          cs = obj->getCoordSet(state2);
         else
           cs = NULL;
         if(cs) {
@@ -5375,7 +5553,7 @@ int SelectorMapCoulomb(PyMOLGlobals * G, int sele1, ObjectMapState * oMap,
         else
           state1 = state;
         if(state1 < obj->NCSet)
-          cs = obj->CSet[state1];
+          cs = obj->getCoordSet(state1);
         else
           cs = NULL;
         if(cs) {
@@ -5399,7 +5577,7 @@ int SelectorMapCoulomb(PyMOLGlobals * G, int sele1, ObjectMapState * oMap,
           else
             state1 = state;
           if(state1 < obj->NCSet)
-            cs = obj->CSet[state1];
+            cs = obj->getCoordSet(state1);
           else
             cs = NULL;
           if(cs) {
@@ -5988,8 +6166,8 @@ pymol::Result<> SelectorUpdateCmd(PyMOLGlobals* G, //
         StateIterator iter1(G, obj1->Setting.get(), sta1, obj1->NCSet);
 
         while (iter0.next() && iter1.next()) {
-          cs0 = obj0->CSet[iter0.state];
-          cs1 = obj1->CSet[iter1.state];
+          cs0 = obj0->getCoordSet(iter0.state);
+          cs1 = obj1->getCoordSet(iter1.state);
           if (cs1 && cs0) {
             int idx0 = cs0->atmToIdx(at0);
             int idx1 = cs1->atmToIdx(at1);
@@ -6215,9 +6393,9 @@ int SelectorCreateObjectMolecule(PyMOLGlobals * G, SelectorID_t sele, const char
           obj = I->Obj[I->Table[a].model];
           cs1 = NULL;
           if(d < obj->NCSet) {
-            cs1 = obj->CSet[d];
+            cs1 = obj->getCoordSet(d);
           } else if(singletons && (obj->NCSet == 1)) {
-            cs1 = obj->CSet[0];
+            cs1 = obj->getCoordSet(0);
           }
           if(cs1) {
             if((!cs2->Name[0]) && (cs1->Name[0]))       /* copy the molecule name (if any) */
@@ -6225,12 +6403,19 @@ int SelectorCreateObjectMolecule(PyMOLGlobals * G, SelectorID_t sele, const char
 
             if(CoordSetGetAtomVertex(cs1, at, cs2->coordPtr(c))) {
               a2 = cs->IdxToAtm[I->Table[a].index];     /* actual merged atom index */
-              cs2->IdxToAtm[c] = a2;
+              cs2->IdxToAtm.mut()[c] = a2;
               c++;
             }
           }
         }
       cs2->setNIndex(c);
+
+      /* don't keep all states of streamed trajectories resident */
+      for(auto* obj_src : I->Obj) {
+        if(obj_src->TrajStream)
+          obj_src->TrajStream->trim(obj_src);
+      }
+
       if(target >= 0) {
         ts = target++;
       } else {
@@ -6279,6 +6464,7 @@ int SelectorSetName(PyMOLGlobals * G, const char *new_name, const char *old_name
   auto it = SelectGetInfoIter(G, old_name, 1, ignore_case);
   if (it != I->Info.end()) {
     it->name = new_name;
+    SelectorCacheClear(G);
     return true;
   } else {
     return false;
@@ -6358,6 +6544,7 @@ static void SelectorPurgeMembers(PyMOLGlobals * G, SelectorID_t sele)
       }
     }
   }
+  SelectorManagerDropBitmap(*I, sele);
   if (changed){
     // not sure if this is needed since its in SelectorClean()
     ExecutiveInvalidateSelectionIndicatorsCGO(G);
@@ -6423,6 +6610,233 @@ void SelectorDelete(PyMOLGlobals * G, const char *sele)
 }
 
 
+/*========================================================================*/
+/*
+ * Selection result cache. SelectorGetTmp remembers which atoms an expression
+ * selected. An entry is validated against the serials and change counters of
+ * all molecular objects and dropped on any change to named selections, so a
+ * hit only has to replay the stored members into a new temporary selection,
+ * without updating the table or evaluating the expression. A hit therefore
+ * costs O(selected atoms) for the member inserts, a miss additionally the
+ * full evaluation.
+ */
+
+static std::string SelectorCacheSettings(PyMOLGlobals* G)
+{
+  std::string settings;
+  settings += SettingGetGlobal_b(G, cSetting_ignore_case) ? '1' : '0';
+  settings += SettingGetGlobal_b(G, cSetting_ignore_case_chain) ? '1' : '0';
+  settings += SettingGetGlobal_s(G, cSetting_wildcard);
+  settings += '\n';
+  settings += SettingGetGlobal_s(G, cSetting_atom_name_wildcard);
+  return settings;
+}
+
+/**
+ * Per-object matching setting (see name matching in SelectorSelect1)
+ */
+static char SelectorCacheAtomNameWildcard(PyMOLGlobals* G, ObjectMolecule* obj)
+{
+  return SettingGet_s(G, obj->Setting.get(), NULL,
+      cSetting_atom_name_wildcard)[0];
+}
+
+static SelectionCacheObjectRec SelectorCacheObject(
+    PyMOLGlobals* G, ObjectMolecule* obj)
+{
+  return {obj, obj->Serial, obj->NAtom, obj->NCSet, obj->getCurrentState(),
+      obj->AtomVersion, obj->CoordVersion, obj->StateVersion,
+      SelectorCacheAtomNameWildcard(G, obj)};
+}
+
+static bool SelectorCacheValid(
+    PyMOLGlobals* G, const SelectionCacheEntry& entry)
+{
+  if (entry.settings != SelectorCacheSettings(G))
+    return false;
+
+  ObjectMolecule* obj = nullptr;
+  void* iterator = nullptr;
+  size_t n = 0;
+  while (ExecutiveIterateObjectMolecule(G, &obj, &iterator)) {
+    if (n == entry.objects.size())
+      return false;
+    const auto& rec = entry.objects[n++];
+    // a new object may have the address of a deleted one
+    if (rec.Serial != obj->Serial || rec.NAtom != obj->NAtom ||
+        rec.NCSet != obj->NCSet ||
+        rec.AtomVersion != obj->AtomVersion ||
+        rec.StateVersion != obj->StateVersion ||
+        rec.AtomNameWildcard != SelectorCacheAtomNameWildcard(G, obj))
+      return false;
+    if ((entry.deps & cSeleDepCoord) && rec.CoordVersion != obj->CoordVersion)
+      return false;
+    if ((entry.deps & cSeleDepState) && rec.state != obj->getCurrentState())
+      return false;
+  }
+  return n == entry.objects.size();
+}
+
+/**
+ * Create a temporary selection from a cached result. Inserts every member,
+ * so this is linear in the number of selected atoms.
+ * @return number of selected atoms
+ */
+static int SelectorCacheEmbed(
+    PyMOLGlobals* G, const SelectionCacheEntry& entry, char* store)
+{
+  auto IM = G->SelectorMgr;
+
+  SelectorGetUniqueTmpName(G, store);
+  SelectorID_t sele = IM->NSelection++;
+  IM->Info.emplace_back(SelectionInfoRec(sele, store));
+
+  if (entry.theOneObject >= 0) {
+    auto& info = IM->Info.back();
+    info.theOneObject = entry.objects[entry.theOneObject].obj;
+    info.theOneAtom = entry.theOneAtom;
+  }
+
+  for (const auto& m : entry.members) {
+    auto obj = entry.objects[m.obj].obj;
+    SelectorManagerInsertMember(*IM, obj->AtomInfo[m.atom], sele, m.tag);
+  }
+
+  ExecutiveManageSelection(G, store);
+  return entry.members.size();
+}
+
+static bool SelectorCacheEnabled(PyMOLGlobals* G, const char* input)
+{
+  if (SettingGetGlobal_i(G, cSetting_selection_cache_size) <= 0) {
+    SelectorCacheClear(G);
+    return false;
+  }
+  // temporary selections don't invalidate the cache
+  return !strstr(input, cSelectorTmpPrefix);
+}
+
+/**
+ * On a cache hit, create the temporary selection and return its atom count.
+ * @return -1 on a miss
+ */
+static int SelectorCacheLookup(PyMOLGlobals* G, const char* input, char* store)
+{
+  auto IM = G->SelectorMgr;
+  auto found = IM->CacheIndex.find(input);
+  if (found != IM->CacheIndex.end()) {
+    auto it = found->second;
+    if (SelectorCacheValid(G, *it)) {
+      ++IM->CacheHits;
+      IM->Cache.splice(IM->Cache.begin(), IM->Cache, it);
+      return SelectorCacheEmbed(G, *it, store);
+    }
+    IM->CacheIndex.erase(found);
+    IM->Cache.erase(it);
+  }
+  ++IM->CacheMisses;
+  return -1;
+}
+
+/**
+ * Remember the result of `input` (the temporary selection `name`)
+ */
+static void SelectorCacheStore(
+    PyMOLGlobals* G, const char* input, const char* name)
+{
+  auto IM = G->SelectorMgr;
+  const int deps = G->Selector->EvalDeps;
+  if (deps & cSeleDepNoCache)
+    return;
+
+  auto info = std::find_if(IM->Info.rbegin(), IM->Info.rend(),
+      [name](const SelectionInfoRec& rec) { return rec.name == name; });
+  if (info == IM->Info.rend())
+    return;
+  const SelectorID_t sele = info->ID;
+
+  SelectionCacheEntry entry;
+  entry.input = input;
+  entry.deps = deps;
+  entry.settings = SelectorCacheSettings(G);
+
+  ObjectMolecule* obj = nullptr;
+  void* iterator = nullptr;
+  while (ExecutiveIterateObjectMolecule(G, &obj, &iterator)) {
+    const int o = entry.objects.size();
+    entry.objects.push_back(SelectorCacheObject(G, obj));
+    if (obj == info->theOneObject) {
+      entry.theOneObject = o;
+      entry.theOneAtom = info->theOneAtom;
+    }
+    for (int a = 0; a < obj->NAtom; ++a) {
+      for (auto s = obj->AtomInfo[a].selEntry; s; s = IM->Member[s].next) {
+        if (IM->Member[s].selection == sele) {
+          entry.members.push_back({o, a, IM->Member[s].tag});
+          break;
+        }
+      }
+    }
+  }
+
+  auto found = IM->CacheIndex.find(entry.input);
+  if (found != IM->CacheIndex.end()) {
+    IM->Cache.erase(found->second);
+    IM->CacheIndex.erase(found);
+  }
+  IM->Cache.push_front(std::move(entry));
+  IM->CacheIndex[IM->Cache.front().input] = IM->Cache.begin();
+
+  const size_t max_size = SettingGetGlobal_i(G, cSetting_selection_cache_size);
+  while (IM->Cache.size() > max_size) {
+    IM->CacheIndex.erase(IM->Cache.back().input);
+    IM->Cache.pop_back();
+  }
+}
+
+void SelectorCacheClear(PyMOLGlobals* G)
+{
+  auto IM = G->SelectorMgr;
+  IM->Cache.clear();
+  IM->CacheIndex.clear();
+}
+
+void SelectorCacheGetStats(
+    PyMOLGlobals* G, size_t* hits, size_t* misses, size_t* size)
+{
+  auto IM = G->SelectorMgr;
+  *hits = IM->CacheHits;
+  *misses = IM->CacheMisses;
+  *size = IM->Cache.size();
+}
+
+/**
+ * Create a temporary selection from a selection expression, use the cache
+ * if enabled.
+ */
+static pymol::Result<int> SelectorCreateTmp(
+    PyMOLGlobals* G, const char* input, char* store, bool quiet)
+{
+  const bool use_cache = SelectorCacheEnabled(G, input);
+  if (use_cache) {
+    auto count = SelectorCacheLookup(G, input, store);
+    if (count >= 0)
+      return count;
+    G->Selector->EvalDeps = 0;
+  }
+
+  SelectorGetUniqueTmpName(G, store);
+  auto res = SelectorCreate(G, store, input, NULL, quiet, NULL);
+
+  if (!res) {
+    store[0] = 0;
+  } else if (use_cache) {
+    SelectorCacheStore(G, input, store);
+  }
+
+  return res;
+}
+
 /*========================================================================*/
 /**
  * If `input` is already a name of an object or a valid position keyword
@@ -6523,12 +6937,7 @@ SelectorGetTmp2Result(PyMOLGlobals * G, const char *input, char *store, bool qui
     }
     if(is_selection) {          /* incur the computational expense of 
                                    parsing the input as an atom selection */
-      SelectorGetUniqueTmpName(G, store);
-      auto res = SelectorCreate(G, store, input, NULL, quiet, NULL);
-      if (!res) {
-        store[0] = 0;
-      }
-      return res;
+      return SelectorCreateTmp(G, input, store, quiet);
     } else {                    /* otherwise, just parse the input as a space-separated list of names */
       /* not a selection */
       strcpy(store, input);
@@ -6571,14 +6980,7 @@ SelectorGetTmpResult(PyMOLGlobals * G, const char *input, char *store, bool quie
   }
 
   // evaluate expression and create a temp selection
-  SelectorGetUniqueTmpName(G, store);
-  auto res = SelectorCreate(G, store, input, NULL, quiet, NULL);
-
-  if(!res) {
-    store[0] = 0;
-  }
-
-  return res;
+  return SelectorCreateTmp(G, input, store, quiet);
 }
 
 
@@ -6633,6 +7035,9 @@ static int SelectorEmbedSelection(PyMOLGlobals * G, const int *atom, pymol::zstr
     newFlag = false;
   }
 
+  if (!SelectorIsTmp(name))
+    SelectorCacheClear(G);
+
   sele = IM->NSelection++;
   IM->Info.emplace_back(SelectionInfoRec(sele, name.c_str()));
 
@@ -6969,7 +7374,7 @@ static void SelectorUpdateTableSingleObject(
       c++;
     }
   } else if(state < obj->NCSet) {
-    const CoordSet* cs = obj->CSet[state];
+    const CoordSet* cs = obj->getCoordSet(state);
     if(cs) {
       for (int atm = 0; atm < obj->NAtom; ++atm) {
         if (cs->atmToIdx(atm) >= 0) {
@@ -7104,6 +7509,9 @@ int SelectorUpdateTableImpl(PyMOLGlobals * G, CSelector *I, int req_state, Selec
     modelCnt++;
   }
 
+  if(domain >= 0)
+    SelectorUpdateMemberBitmap(G, domain);
+
   while(ExecutiveIterateObjectMolecule(G, &obj, &iterator)) {
     int skip_flag = false;
     if(req_state < 0) {
@@ -7122,13 +7530,17 @@ int SelectorUpdateTableImpl(PyMOLGlobals * G, CSelector *I, int req_state, Selec
         state = -1;
         break;
       }
-    } else {
-      if(state >= obj->NCSet)
-        skip_flag = true;
-      else if(!obj->CSet[state])
-        skip_flag = true;
     }
 
+    /* streamed trajectory states are decoded on demand */
+    CoordSet* state_cs = nullptr;
+    if(state >= 0 && state < obj->NCSet) {
+      state_cs = obj->getCoordSet(state);
+    }
+
+    if(req_state >= 0 && !state_cs)
+      skip_flag = true;
+
     if(!skip_flag) {
       /* fill in the table */
       I->Obj[modelCnt] = obj;
@@ -7163,15 +7575,11 @@ int SelectorUpdateTableImpl(PyMOLGlobals * G, CSelector *I, int req_state, Selec
                                                    base offsets are invalid */
           }
         } else {                /* specific states */
-          CoordSet *cs;
+          CoordSet *cs = state_cs;
           int idx;
           if(domain < 0) {
             for(a = 0; a < n_atom; a++) {
               /* does coordinate exist for this atom in the requested state? */
-              if(state < obj->NCSet)
-                cs = obj->CSet[state];
-              else
-                cs = NULL;
               if(cs) {
                 idx = cs->atmToIdx(a);
                 if(idx >= 0) {
@@ -7185,10 +7593,6 @@ int SelectorUpdateTableImpl(PyMOLGlobals * G, CSelector *I, int req_state, Selec
             const AtomInfoType *ai = obj->AtomInfo.data();
             for(a = 0; a < n_atom; a++) {
               /* does coordinate exist for this atom in the requested state? */
-              if(state < obj->NCSet)
-                cs = obj->CSet[state];
-              else
-                cs = NULL;
               if(cs) {
                 idx = cs->atmToIdx(a);
                 if(idx >= 0) {
@@ -7282,7 +7686,7 @@ static int SelectorModulate1(PyMOLGlobals * G, EvalElem * base, int state)
             at = I->Table[a].atom;
             obj = I->Obj[I->Table[a].model];
             if(d < obj->NCSet)
-              cs = obj->CSet[d];
+              cs = obj->getCoordSet(d);
             else
               cs = NULL;
             if(cs) {
@@ -7306,7 +7710,7 @@ static int SelectorModulate1(PyMOLGlobals * G, EvalElem * base, int state)
                       at = I->Table[a].atom;
                       obj = I->Obj[I->Table[a].model];
                       if(e < obj->NCSet)
-                        cs = obj->CSet[e];
+                        cs = obj->getCoordSet(e);
                       else
                         cs = NULL;
                       if(cs) {
@@ -7382,7 +7786,7 @@ static int SelectorModulate1(PyMOLGlobals * G, EvalElem * base, int state)
             obj = I->Obj[I->Table[a].model];
             at = I->Table[a].atom;
             if(d < obj->NCSet)
-              cs = obj->CSet[d];
+              cs = obj->getCoordSet(d);
             else
               cs = NULL;
             if(cs) {
@@ -7406,7 +7810,7 @@ static int SelectorModulate1(PyMOLGlobals * G, EvalElem * base, int state)
                       at = I->Table[a].atom;
                       obj = I->Obj[I->Table[a].model];
                       if(e < obj->NCSet)
-                        cs = obj->CSet[e];
+                        cs = obj->getCoordSet(e);
                       else
                         cs = NULL;
                       if(cs) {
@@ -7452,11 +7856,41 @@ static int SelectorModulate1(PyMOLGlobals * G, EvalElem * base, int state)
 }
 
 
+/*========================================================================*/
+/**
+ * Evaluate a per-atom predicate for all (non-dummy) atoms of the selector
+ * table, in parallel chunks.
+ * @param pred Called as `pred(ai, table_rec)`, returns the selection tag
+ * @return number of selected atoms
+ */
+template <typename Pred>
+static int SelectorTableFill(PyMOLGlobals* G, int* sele, Pred pred)
+{
+  CSelector* I = G->Selector;
+  const size_t n_atom = I->Table.size();
+  if(n_atom <= cNDummyAtoms)
+    return 0;
+
+  std::atomic<int> count{0};
+  pymol::parallel_for(G, n_atom - cNDummyAtoms, 4096,
+      [&](size_t begin, size_t end, unsigned) {
+        int c = 0;
+        for(size_t a = begin + cNDummyAtoms; a < end + cNDummyAtoms; a++) {
+          const auto& table_a = I->Table[a];
+          int tag = pred(I->Obj[table_a.model]->AtomInfo[table_a.atom], table_a);
+          sele[a] = tag;
+          c += (tag != 0);
+        }
+        count += c;
+      });
+  return count;
+}
+
 /*========================================================================*/
 static int SelectorSelect0(PyMOLGlobals * G, EvalElem * passed_base)
 {
   CSelector *I = G->Selector;
-  int a, b, flag;
+  int a, flag;
   EvalElem *base = passed_base;
   int c = 0;
   ObjectMolecule *obj, *cur_obj = NULL;
@@ -7466,6 +7900,8 @@ static int SelectorSelect0(PyMOLGlobals * G, EvalElem * passed_base)
   base->sele_calloc(I->Table.size());
   base->sele_err_chk_ptr(G);
 
+  int* sele = base[0].sele_data();
+
   switch (base->code) {
   case SELE_HBAs:
   case SELE_HBDs:
@@ -7486,111 +7922,93 @@ static int SelectorSelect0(PyMOLGlobals * G, EvalElem * passed_base)
     switch (base->code) {
     case SELE_HBAs:
     case SELE_ACCz:
-      for(a = cNDummyAtoms; a < I->Table.size(); a++)
-        base[0].sele[a] = I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].hb_acceptor;
+      c = SelectorTableFill(G, sele, [](const AtomInfoType& ai, const TableRec&) {
+        return int(ai.hb_acceptor);
+      });
       break;
     case SELE_HBDs:
     case SELE_DONz:
-      for(a = cNDummyAtoms; a < I->Table.size(); a++)
-        base[0].sele[a] = I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].hb_donor;
+      c = SelectorTableFill(G, sele, [](const AtomInfoType& ai, const TableRec&) {
+        return int(ai.hb_donor);
+      });
       break;
 
     }
     break;
   case SELE_NONz:
-    for(a = cNDummyAtoms; a < I->Table.size(); a++)
-      base[0].sele[a] = false;
     break;
   case SELE_BNDz:
-    for(a = cNDummyAtoms; a < I->Table.size(); a++)
-      base[0].sele[a] = I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].bonded;
+    c = SelectorTableFill(G, sele, [](const AtomInfoType& ai, const TableRec&) {
+      return int(ai.bonded);
+    });
     break;
   case SELE_HETz:
-    for(a = cNDummyAtoms; a < I->Table.size(); a++)
-      base[0].sele[a] = I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].hetatm;
+    c = SelectorTableFill(G, sele, [](const AtomInfoType& ai, const TableRec&) {
+      return int(ai.hetatm);
+    });
     break;
   case SELE_HYDz:
-    for(a = cNDummyAtoms; a < I->Table.size(); a++)
-      base[0].sele[a] = I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].isHydrogen();
+    c = SelectorTableFill(G, sele, [](const AtomInfoType& ai, const TableRec&) {
+      return int(ai.isHydrogen());
+    });
     break;
   case SELE_METz:
-    for(a = cNDummyAtoms; a < I->Table.size(); a++) {
-      base[0].sele[a] = I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].isMetal();
-    }
+    c = SelectorTableFill(G, sele, [](const AtomInfoType& ai, const TableRec&) {
+      return int(ai.isMetal());
+    });
     break;
   case SELE_BB_z:
   case SELE_SC_z:
-    {
-      AtomInfoType *ai;
-      flag = (base->code == SELE_BB_z);
-      for(a = cNDummyAtoms; a < I->Table.size(); a++) {
-        ai = I->Obj[I->Table[a].model]->AtomInfo + I->Table[a].atom;
-        if(!(ai->flags & cAtomFlag_polymer)) {
-          base[0].sele[a] = 0;
-          continue;
-        }
-        base[0].sele[a] = !flag;
-        for(b = 0; backbone_names[b][0]; b++) {
-          if(!(strcmp(LexStr(G, ai->name), backbone_names[b]))) {
-            base[0].sele[a] = flag;
-            break;
-          }
-        }
+    flag = (base->code == SELE_BB_z);
+    c = SelectorTableFill(G, sele, [G, flag](const AtomInfoType& ai, const TableRec&) {
+      if(!(ai.flags & cAtomFlag_polymer))
+        return 0;
+      for(int b = 0; backbone_names[b][0]; b++) {
+        if(!(strcmp(LexStr(G, ai.name), backbone_names[b])))
+          return flag;
       }
-    }
+      return int(!flag);
+    });
     break;
   case SELE_FXDz:
-    for(a = cNDummyAtoms; a < I->Table.size(); a++)
-      base[0].sele[a] =
-        I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].flags & cAtomFlag_fix;
-    break;
   case SELE_RSTz:
-    for(a = cNDummyAtoms; a < I->Table.size(); a++)
-      base[0].sele[a] =
-        I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].flags & cAtomFlag_restrain;
-    break;
   case SELE_POLz:
-    for(a = cNDummyAtoms; a < I->Table.size(); a++)
-      base[0].sele[a] =
-        I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].flags & cAtomFlag_polymer;
-    break;
   case SELE_PROz:
-    for(a = cNDummyAtoms; a < I->Table.size(); a++)
-      base[0].sele[a] =
-        I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].flags & cAtomFlag_protein;
-    break;
   case SELE_NUCz:
-    for(a = cNDummyAtoms; a < I->Table.size(); a++)
-      base[0].sele[a] =
-        I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].flags & cAtomFlag_nucleic;
-    break;
   case SELE_SOLz:
-    for(a = cNDummyAtoms; a < I->Table.size(); a++)
-      base[0].sele[a] =
-        I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].flags & cAtomFlag_solvent;
+  case SELE_ORGz:
+  case SELE_INOz:
+    {
+      int mask = 0;
+      switch (base->code) {
+      case SELE_FXDz: mask = cAtomFlag_fix; break;
+      case SELE_RSTz: mask = cAtomFlag_restrain; break;
+      case SELE_POLz: mask = cAtomFlag_polymer; break;
+      case SELE_PROz: mask = cAtomFlag_protein; break;
+      case SELE_NUCz: mask = cAtomFlag_nucleic; break;
+      case SELE_SOLz: mask = cAtomFlag_solvent; break;
+      case SELE_ORGz: mask = cAtomFlag_organic; break;
+      case SELE_INOz: mask = cAtomFlag_inorganic; break;
+      }
+      c = SelectorTableFill(G, sele, [mask](const AtomInfoType& ai, const TableRec&) {
+        return int(ai.flags & mask);
+      });
+    }
     break;
   case SELE_PTDz:
-    for(a = cNDummyAtoms; a < I->Table.size(); a++)
-      base[0].sele[a] = I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].protekted != cAtomProtected_off;
+    c = SelectorTableFill(G, sele, [](const AtomInfoType& ai, const TableRec&) {
+      return int(ai.protekted != cAtomProtected_off);
+    });
     break;
   case SELE_MSKz:
-    for(a = cNDummyAtoms; a < I->Table.size(); a++)
-      base[0].sele[a] = I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].masked;
-    break;
-  case SELE_ORGz:
-    for(a = cNDummyAtoms; a < I->Table.size(); a++)
-      base[0].sele[a] =
-        I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].flags & cAtomFlag_organic;
-    break;
-  case SELE_INOz:
-    for(a = cNDummyAtoms; a < I->Table.size(); a++)
-      base[0].sele[a] =
-        I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].flags & cAtomFlag_inorganic;
+    c = SelectorTableFill(G, sele, [](const AtomInfoType& ai, const TableRec&) {
+      return int(ai.masked);
+    });
     break;
   case SELE_GIDz:
-    for(a = cNDummyAtoms; a < I->Table.size(); a++)
-      base[0].sele[a] =
-        bool(I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].flags & cAtomFlag_guide);
+    c = SelectorTableFill(G, sele, [](const AtomInfoType& ai, const TableRec&) {
+      return int(bool(ai.flags & cAtomFlag_guide));
+    });
     break;
 
   case SELE_PREz:
@@ -7761,14 +8179,10 @@ static pymol::Result<> SelectorSelect1(PyMOLGlobals * G, EvalElem * base, int qu
       WordMatchOptionsConfigInteger(&options);
 
       if((matcher = WordMatcherNew(G, base[1].text(), &options, true))) {
-        base_0_sele_a = &base[0].sele[cNDummyAtoms];
-
-        for(a = cNDummyAtoms; a < I_NAtom; a++) {
-          auto& table_a = I->Table[a];
-          if((*base_0_sele_a = WordMatcherMatchInteger(matcher, table_a.atom + 1)))
-            c++;
-          base_0_sele_a++;
-        }
+        c = SelectorTableFill(G, base[0].sele_data(),
+            [matcher](const AtomInfoType&, const TableRec& table_a) {
+              return WordMatcherMatchInteger(matcher, table_a.atom + 1);
+            });
         WordMatcherFree(matcher);
       }
 
@@ -7781,16 +8195,10 @@ static pymol::Result<> SelectorSelect1(PyMOLGlobals * G, EvalElem * base, int qu
       WordMatchOptionsConfigInteger(&options);
 
       if((matcher = WordMatcherNew(G, base[1].text(), &options, true))) {
-        base_0_sele_a = &base[0].sele[cNDummyAtoms];
-
-        for(a = cNDummyAtoms; a < I_NAtom; a++) {
-          auto& table_a = I->Table[a];
-          if((*base_0_sele_a =
-              WordMatcherMatchInteger(matcher,
-                                      I->Obj[table_a.model]->AtomInfo[table_a.atom].id)))
-            c++;
-          base_0_sele_a++;
-        }
+        c = SelectorTableFill(G, base[0].sele_data(),
+            [matcher](const AtomInfoType& ai, const TableRec&) {
+              return WordMatcherMatchInteger(matcher, ai.id);
+            });
         WordMatcherFree(matcher);
       }
     }
@@ -7801,20 +8209,11 @@ static pymol::Result<> SelectorSelect1(PyMOLGlobals * G, EvalElem * base, int qu
 
       WordMatchOptionsConfigInteger(&options);
 
-      base_0_sele_a = &base[0].sele[cNDummyAtoms];
-
       if((matcher = WordMatcherNew(G, base[1].text(), &options, true))) {
-        base_0_sele_a = &base[0].sele[cNDummyAtoms];
-
-        for(a = cNDummyAtoms; a < I_NAtom; a++) {
-          auto& table_a = I->Table[a];
-          if((*base_0_sele_a =
-              WordMatcherMatchInteger(matcher,
-                                      I->Obj[table_a.model]->AtomInfo[table_a.atom].
-                                      rank)))
-            c++;
-          base_0_sele_a++;
-        }
+        c = SelectorTableFill(G, base[0].sele_data(),
+            [matcher](const AtomInfoType& ai, const TableRec&) {
+              return WordMatcherMatchInteger(matcher, ai.rank);
+            });
         WordMatcherFree(matcher);
       }
     }
@@ -7908,19 +8307,11 @@ static pymol::Result<> SelectorSelect1(PyMOLGlobals * G, EvalElem * base, int qu
 
       WordMatchOptionsConfigAlphaList(&options, wildcard[0], ignore_case);
 
-      base_0_sele_a = &base[0].sele[cNDummyAtoms];
-
       if((matcher = WordMatcherNew(G, base[1].text(), &options, true))) {
-        base_0_sele_a = &base[0].sele[cNDummyAtoms];
-
-        for(a = cNDummyAtoms; a < I_NAtom; a++) {
-          auto& table_a = I->Table[a];
-          if((*base_0_sele_a =
-              WordMatcherMatchAlpha(matcher,
-                                    I->Obj[table_a.model]->AtomInfo[table_a.atom].elem)))
-            c++;
-          base_0_sele_a++;
-        }
+        c = SelectorTableFill(G, base[0].sele_data(),
+            [matcher](const AtomInfoType& ai, const TableRec&) {
+              return WordMatcherMatchAlpha(matcher, ai.elem);
+            });
         WordMatcherFree(matcher);
       }
     }
@@ -8006,8 +8397,6 @@ static pymol::Result<> SelectorSelect1(PyMOLGlobals * G, EvalElem * base, int qu
 
       WordMatchOptionsConfigAlphaList(&options, wildcard[0], ignore_case_chain);
 
-      base_0_sele_a = &base[0].sele[cNDummyAtoms];
-
       int offset = 0;
       switch (base->code) {
         case SELE_CHNs:
@@ -8027,18 +8416,12 @@ static pymol::Result<> SelectorSelect1(PyMOLGlobals * G, EvalElem * base, int qu
       }
 
       if((matcher = WordMatcherNew(G, base[1].text(), &options, true))) {
-        base_0_sele_a = &base[0].sele[cNDummyAtoms];
-
-        for(a = cNDummyAtoms; a < I_NAtom; a++) {
-          auto& table_a = I->Table[a];
-          if((*base_0_sele_a =
-              WordMatcherMatchAlpha(matcher, LexStr(G,
-                  *reinterpret_cast<decltype(AtomInfoType::chain)*>
-                  (((char*)(I->Obj[table_a.model]->AtomInfo + table_a.atom)) + offset)
-                  ))))
-            c++;
-          base_0_sele_a++;
-        }
+        c = SelectorTableFill(G, base[0].sele_data(),
+            [G, matcher, offset](const AtomInfoType& ai, const TableRec&) {
+              return WordMatcherMatchAlpha(matcher, LexStr(G,
+                  *reinterpret_cast<const decltype(AtomInfoType::chain)*>
+                  (((const char*)(&ai)) + offset)));
+            });
         WordMatcherFree(matcher);
       }
     }
@@ -8049,20 +8432,11 @@ static pymol::Result<> SelectorSelect1(PyMOLGlobals * G, EvalElem * base, int qu
 
       WordMatchOptionsConfigAlphaList(&options, wildcard[0], ignore_case);
 
-      base_0_sele_a = &base[0].sele[cNDummyAtoms];
-
       if((matcher = WordMatcherNew(G, base[1].text(), &options, true))) {
-        base_0_sele_a = &base[0].sele[cNDummyAtoms];
-
-        for(a = cNDummyAtoms; a < I_NAtom; a++) {
-          auto& table_a = I->Table[a];
-          if((*base_0_sele_a =
-              WordMatcherMatchAlpha(matcher,
-                                    I->Obj[table_a.model]->AtomInfo[table_a.atom].
-                                    ssType)))
-            c++;
-          base_0_sele_a++;
-        }
+        c = SelectorTableFill(G, base[0].sele_data(),
+            [matcher](const AtomInfoType& ai, const TableRec&) {
+              return WordMatcherMatchAlpha(matcher, ai.ssType);
+            });
         WordMatcherFree(matcher);
       }
     }
@@ -8098,19 +8472,11 @@ static pymol::Result<> SelectorSelect1(PyMOLGlobals * G, EvalElem * base, int qu
 
       WordMatchOptionsConfigAlphaList(&options, wildcard[0], ignore_case);
 
-      base_0_sele_a = &base[0].sele[cNDummyAtoms];
-
       if((matcher = WordMatcherNew(G, base[1].text(), &options, true))) {
-        base_0_sele_a = &base[0].sele[cNDummyAtoms];
-
-        for(a = cNDummyAtoms; a < I_NAtom; a++) {
-          auto& table_a = I->Table[a];
-          if((*base_0_sele_a =
-              WordMatcherMatchAlpha(matcher,
-                                    I->Obj[table_a.model]->AtomInfo[table_a.atom].alt)))
-            c++;
-          base_0_sele_a++;
-        }
+        c = SelectorTableFill(G, base[0].sele_data(),
+            [matcher](const AtomInfoType& ai, const TableRec&) {
+              return WordMatcherMatchAlpha(matcher, ai.alt);
+            });
         WordMatcherFree(matcher);
       }
     }
@@ -8151,24 +8517,16 @@ static pymol::Result<> SelectorSelect1(PyMOLGlobals * G, EvalElem * base, int qu
   case SELE_RSIs:
     {
       CWordMatchOptions options;
-      AtomInfoType *ai;
 
       WordMatchOptionsConfigMixed(&options, wildcard[0], ignore_case);
 
-      base_0_sele_a = &base[0].sele[cNDummyAtoms];
-
       if((matcher = WordMatcherNew(G, base[1].text(), &options, true))) {
-        base_0_sele_a = &base[0].sele[cNDummyAtoms];
-
-        for(a = cNDummyAtoms; a < I_NAtom; a++) {
-          auto& table_a = I->Table[a];
-          ai = I->Obj[table_a.model]->AtomInfo + table_a.atom;
-          char resi[8];
-          AtomResiFromResv(resi, sizeof(resi), ai);
-          if((*base_0_sele_a = WordMatcherMatchMixed(matcher, resi, ai->resv)))
-            c++;
-          base_0_sele_a++;
-        }
+        c = SelectorTableFill(G, base[0].sele_data(),
+            [matcher](const AtomInfoType& ai, const TableRec&) {
+              char resi[8];
+              AtomResiFromResv(resi, sizeof(resi), &ai);
+              return WordMatcherMatchMixed(matcher, resi, ai.resv);
+            });
         WordMatcherFree(matcher);
       }
     }
@@ -8179,19 +8537,11 @@ static pymol::Result<> SelectorSelect1(PyMOLGlobals * G, EvalElem * base, int qu
 
       WordMatchOptionsConfigAlphaList(&options, wildcard[0], ignore_case);
 
-      base_0_sele_a = &base[0].sele[cNDummyAtoms];
-
       if((matcher = WordMatcherNew(G, base[1].text(), &options, true))) {
-        base_0_sele_a = &base[0].sele[cNDummyAtoms];
-
-        for(a = cNDummyAtoms; a < I_NAtom; a++) {
-          auto& table_a = I->Table[a];
-          auto& resn = I->Obj[table_a.model]->AtomInfo[table_a.atom].resn;
-          if((*base_0_sele_a =
-              WordMatcherMatchAlpha(matcher, LexStr(G, resn))))
-            c++;
-          base_0_sele_a++;
-        }
+        c = SelectorTableFill(G, base[0].sele_data(),
+            [G, matcher](const AtomInfoType& ai, const TableRec&) {
+              return WordMatcherMatchAlpha(matcher, LexStr(G, ai.resn));
+            });
         WordMatcherFree(matcher);
       }
     }
@@ -8218,6 +8568,24 @@ static pymol::Result<> SelectorSelect1(PyMOLGlobals * G, EvalElem * base, int qu
         for(a = 0; a < I_NAtom; a++)    /* zero out first before iterating through selections */
           base[0].sele[a] = false;
 
+        /* members of consecutive untagged selections are collected with
+           bitmap unions, and tested once per atom */
+        pymol::Bitmap untagged;
+        bool untagged_pending = false;
+        auto flush_untagged = [&]() {
+          if (!untagged_pending)
+            return;
+          for(a = cNDummyAtoms; a < I_NAtom; a++) {
+            if(!base[0].sele[a]) {
+              s = I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].selEntry;
+              if((base[0].sele[a] = untagged.contains(s)))
+                c++;
+            }
+          }
+          untagged.clear();
+          untagged_pending = false;
+        };
+
         for (const auto& rec : I->mgr->Info) {
           if (rec.name.empty()) {
             // TODO Can this happen? Why?
@@ -8227,22 +8595,28 @@ static pymol::Result<> SelectorSelect1(PyMOLGlobals * G, EvalElem * base, int qu
             break;
           }
           if (WordMatcherMatchAlpha(matcher, rec.name.c_str())) {
-            if (!enabled_only || activeselename == rec.name) {
+            /* "all" and "none" have no members */
+            if (rec.ID > cSelectionNone &&
+                (!enabled_only || activeselename == rec.name)) {
+              SelectorUpdateMemberBitmap(G, rec.ID);
+              auto bitmap = SelectorManagerFindBitmap(*IM, rec.ID);
+              if (bitmap && !bitmap->tagged) {
+                untagged |= bitmap->bits;
+                untagged_pending = true;
+                continue;
+              }
+              flush_untagged();
               for(a = cNDummyAtoms; a < I_NAtom; a++) {
-                s = I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].selEntry;
-                while(s) {
-                  if (I->mgr->Member[s].selection == rec.ID) {
-                    if(!base[0].sele[a]) {
-                      base[0].sele[a] = I->mgr->Member[s].tag;
-                      c++;
-                    }
-                  }
-                  s = IM->Member[s].next;
+                if(!base[0].sele[a]) {
+                  s = I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].selEntry;
+                  if((base[0].sele[a] = SelectorIsMember(G, s, rec.ID)))
+                    c++;
                 }
               }
             }
           }
         }
+        flush_untagged();
         WordMatcherFree(matcher);
 
         /* must also allow for group name pattern matches */
@@ -8272,16 +8646,13 @@ static pymol::Result<> SelectorSelect1(PyMOLGlobals * G, EvalElem * base, int qu
                  WordMatchExact(G, activeselename, word, ignore_case)) {
         auto it = SelectGetInfoIter(G, word, 1, ignore_case);
         if (it != IM->Info.end()) {
+          SelectorUpdateMemberBitmap(G, it->ID);
           for(a = cNDummyAtoms; a < I_NAtom; a++) {
-            base[0].sele[a] = false;
             s = I->Obj[I->Table[a].model]->AtomInfo[I->Table[a].atom].selEntry;
-            while(s) {
-              if (IM->Member[s].selection == it->ID) {
-                base[0].sele[a] = IM->Member[s].tag;
-                c++;
-              }
-              s = IM->Member[s].next;
-            }
+            if((base[0].sele[a] = (it->ID > cSelectionNone)
+                                      ? SelectorIsMember(G, s, it->ID)
+                                      : false))
+              c++;
           }
         } else {
           int group_list_id;
@@ -8468,7 +8839,9 @@ static int SelectorSelect2(PyMOLGlobals * G, EvalElem * base, int state)
             continue;
 
           at = I->Table[a].atom;
-          cs = obj->CSet[s];
+          cs = obj->getCoordSet(s);
+          if(!cs)
+            continue;
           idx = cs->atmToIdx(at);
           if(idx < 0)
             continue;
@@ -9117,7 +9490,7 @@ static int SelectorLogic1(PyMOLGlobals * G, EvalElem * inp_base, int state)
             at = I->Table[a].atom;
             obj = I->Obj[I->Table[a].model];
             if(d < obj->NCSet)
-              cs = obj->CSet[d];
+              cs = obj->getCoordSet(d);
             else
               cs = NULL;
             if(cs) {
@@ -9147,7 +9520,7 @@ static int SelectorLogic1(PyMOLGlobals * G, EvalElem * inp_base, int state)
                       at = I->Table[a].atom;
                       obj = I->Obj[I->Table[a].model];
                       if(e < obj->NCSet)
-                        cs = obj->CSet[e];
+                        cs = obj->getCoordSet(e);
                       else
                         cs = NULL;
                       if(cs) {
@@ -9236,40 +9609,29 @@ static int SelectorLogic2(PyMOLGlobals * G, EvalElem * base)
 
   switch (base[1].code) {
 
+  /* branch free, so that the compiler can vectorize these loops */
   case SELE_OR_2:
   case SELE_IOR2:
-    {
-      base_0_sele_a = base[0].sele_data();
-      base_2_sele_a = base[2].sele_data();
+    base_0_sele_a = base[0].sele_data();
+    base_2_sele_a = base[2].sele_data();
 
-      for(a = 0; a < n_atom; a++) {
-        if(((*base_0_sele_a) =
-            (((*base_0_sele_a) >
-              (*base_2_sele_a)) ? (*base_0_sele_a) : (*base_2_sele_a)))) {
-          /* use higher tag */
-          c++;
-        }
-        base_0_sele_a++;
-        base_2_sele_a++;
-      }
+    for(a = 0; a < n_atom; a++) {
+      /* use higher tag */
+      int tag0 = base_0_sele_a[a], tag2 = base_2_sele_a[a];
+      base_0_sele_a[a] = (tag0 > tag2) ? tag0 : tag2;
+      c += (base_0_sele_a[a] != 0);
     }
     break;
   case SELE_AND2:
-
     base_0_sele_a = base[0].sele_data();
     base_2_sele_a = base[2].sele_data();
 
     for(a = 0; a < n_atom; a++) {
-      if((*base_0_sele_a) && (*base_2_sele_a)) {
-        (*base_0_sele_a) =
-          (((*base_0_sele_a) > (*base_2_sele_a)) ? (*base_0_sele_a) : (*base_2_sele_a));
-        /* use higher tag */
-        c++;
-      } else {
-        (*base_0_sele_a) = 0;
-      }
-      base_0_sele_a++;
-      base_2_sele_a++;
+      /* use higher tag */
+      int tag0 = base_0_sele_a[a], tag2 = base_2_sele_a[a];
+      int both = (tag0 != 0) & (tag2 != 0);
+      base_0_sele_a[a] = both ? ((tag0 > tag2) ? tag0 : tag2) : 0;
+      c += both;
     }
     break;
   case SELE_ANT2:
@@ -9277,13 +9639,10 @@ static int SelectorLogic2(PyMOLGlobals * G, EvalElem * base)
     base_2_sele_a = base[2].sele_data();
 
     for(a = 0; a < n_atom; a++) {
-      if((*base_0_sele_a) && !(*base_2_sele_a)) {
-        c++;
-      } else {
-        (*base_0_sele_a) = 0;
-      }
-      base_0_sele_a++;
-      base_2_sele_a++;
+      int tag0 = base_0_sele_a[a];
+      int keep = (tag0 != 0) & (base_2_sele_a[a] == 0);
+      base_0_sele_a[a] = keep ? tag0 : 0;
+      c += keep;
     }
     break;
   case SELE_IN_2:
@@ -9405,7 +9764,7 @@ int SelectorOperator22(PyMOLGlobals * G, EvalElem * base, int state)
             at = I->Table[a].atom;
             obj = I->Obj[I->Table[a].model];
             if(d < obj->NCSet)
-              cs = obj->CSet[d];
+              cs = obj->getCoordSet(d);
             else
               cs = NULL;
             if(cs) {
@@ -9428,7 +9787,7 @@ int SelectorOperator22(PyMOLGlobals * G, EvalElem * base, int state)
                       at = I->Table[a].atom;
                       obj = I->Obj[I->Table[a].model];
                       if(e < obj->NCSet)
-                        cs = obj->CSet[e];
+                        cs = obj->getCoordSet(e);
                       else
                         cs = NULL;
                       if(cs) {
@@ -9585,6 +9944,484 @@ static std::string indicate_last_token(
     }                                                                          \
   }
 
+/*========================================================================*/
+/**
+ * Replace the `count` stack entries starting at `first` by a list entry
+ * which records the operation, instead of evaluating it right away. The
+ * whole expression gets evaluated by SelectorEvaluateNode once parsed.
+ */
+static void SelectorDeferOperation(
+    std::vector<EvalElem>& Stack, int first, int count)
+{
+  auto node = std::make_shared<SeleNode>();
+  node->base.reserve(count);
+  for(int a = 0; a < count; a++)
+    node->base.push_back(std::move(Stack[first + a]));
+
+  /* operator is first, unless the first operand is a list */
+  const auto& head = node->base[0];
+  node->type = (head.type == STYP_LIST) ? node->base[1].type : head.type;
+
+  int cost = 0;
+  for(const auto& e : node->base)
+    if(e.node)
+      cost += e.node->cost;
+
+  const auto op_code = node->base[(head.type == STYP_LIST) ? 1 : 0].code;
+  switch (node->type) {
+  case STYP_SEL0:
+    cost = (op_code == SELE_NONz) ? 0 : 1;
+    break;
+  case STYP_SEL1:
+    cost = (op_code == SELE_SELs) ? 1 : 2;
+    break;
+  case STYP_SEL2:
+  case STYP_SEL3:
+    cost = 2;
+    break;
+  case STYP_OPR1:
+    cost += (op_code == SELE_NOT1) ? 1 : 8;
+    break;
+  case STYP_OPR2:
+    cost += (op_code == SELE_IN_2 || op_code == SELE_LIK2) ? 32 : 1;
+    break;
+  default:                     /* around, within, ... */
+    cost += 16;
+    break;
+  }
+  node->cost = cost;
+
+  auto& e = Stack[first];
+  e.level = head.level;
+  e.imp_op_level = head.imp_op_level;
+  e.code = head.code;
+  e.type = STYP_LIST;
+  e.m_text.clear();
+  e.sele_free();
+  e.node = std::move(node);
+}
+
+/**
+ * cSeleDep* flags of an operation code
+ */
+static int SelectorCodeDeps(int code)
+{
+  switch (code) {
+  case SELE_VISz:
+  case SELE_ENAz:
+  case SELE_ORIz:
+  case SELE_CENz:
+  case SELE_CCLs:
+  case SELE_RCLs:
+  case SELE_STRO:
+  case SELE_TTYs:
+  case SELE_PROP:
+    return cSeleDepNoCache;
+  case SELE_XVLx:
+  case SELE_YVLx:
+  case SELE_ZVLx:
+    return cSeleDepCoord | cSeleDepState;
+  case SELE_STAs:
+  case SELE_PREz:
+    return cSeleDepState;
+  }
+  switch (code & 0xF) {
+  case STYP_PRP1:
+  case STYP_OP22:
+    return cSeleDepCoord | cSeleDepState;
+  }
+  return 0;
+}
+
+static bool SeleNodeIsNone(const EvalElem& e)
+{
+  return e.node && e.node->type == STYP_SEL0 &&
+         e.node->base[0].code == SELE_NONz;
+}
+
+/**
+ * Flatten nested AND (or OR) operations into a list of operands
+ */
+static void SeleNodeCollect(EvalElem& e, unsigned code1, unsigned code2,
+    std::vector<EvalElem*>& operands)
+{
+  if(e.node && e.node->type == STYP_OPR2 &&
+     (e.node->base[1].code == code1 || e.node->base[1].code == code2)) {
+    SeleNodeCollect(e.node->base[0], code1, code2, operands);
+    SeleNodeCollect(e.node->base[2], code1, code2, operands);
+  } else {
+    operands.push_back(&e);
+  }
+}
+
+/**
+ * Selection referenced by a list entry which is a plain (no wildcards, not
+ * "?name") named selection lookup
+ * @return cSelectionInvalid if not such an entry
+ */
+static SelectorID_t SeleNodeNamedSelection(PyMOLGlobals* G, const EvalElem& e)
+{
+  if(!e.node || e.node->type != STYP_SEL1 ||
+     e.node->base[0].code != SELE_SELs)
+    return cSelectionInvalid;
+
+  const char* word = e.node->base[1].text();
+  if(word[0] == '?')
+    return cSelectionInvalid;
+
+  int ignore_case = SettingGetGlobal_b(G, cSetting_ignore_case);
+  CWordMatchOptions options;
+  WordMatchOptionsConfigAlpha(
+      &options, SettingGetGlobal_s(G, cSetting_wildcard)[0], ignore_case);
+  if(auto matcher = WordMatcherNew(G, word, &options, false)) {
+    WordMatcherFree(matcher);
+    return cSelectionInvalid;
+  }
+
+  auto it = SelectGetInfoIter(G, word, 1, ignore_case);
+  if(it == G->SelectorMgr->Info.end() || it->ID <= cSelectionNone)
+    return cSelectionInvalid;
+  return it->ID;
+}
+
+/**
+ * Combine the named selection operands of an AND (or OR) chain with bitmap
+ * set operations, and replace them by one evaluated operand. Operands with
+ * tags other than 1 are left alone, since the result keeps the higher tag.
+ */
+static void SelectorCombineNamedOperands(
+    PyMOLGlobals* G, std::vector<EvalElem*>& operands, bool is_and)
+{
+  auto IM = G->SelectorMgr;
+  if(IM->Info.size() <= cSelectorBitmapMinSelections)
+    return;
+
+  pymol::Bitmap combined;
+  EvalElem* first = nullptr;
+  int n_named = 0;
+
+  for(auto it = operands.begin(); it != operands.end();) {
+    auto sele = SeleNodeNamedSelection(G, **it);
+    if(sele == cSelectionInvalid) {
+      ++it;
+      continue;
+    }
+    SelectorUpdateMemberBitmap(G, sele);
+    auto rec = SelectorManagerFindBitmap(*IM, sele);
+    if(!rec || rec->tagged) {
+      ++it;
+      continue;
+    }
+    if(!n_named++) {
+      combined = rec->bits;
+      first = *it;
+      ++it;
+    } else {
+      if(is_and)
+        combined &= rec->bits;
+      else
+        combined |= rec->bits;
+      it = operands.erase(it);
+    }
+  }
+
+  if(n_named < 2)
+    return;
+
+  CSelector* I = G->Selector;
+  first->sele_calloc(I->Table.size());
+  first->sele_err_chk_ptr(G);
+  int* sele = first->sele_data();
+  for(size_t a = cNDummyAtoms; a < I->Table.size(); a++) {
+    const auto& table_a = I->Table[a];
+    sele[a] = combined.contains(
+        I->Obj[table_a.model]->AtomInfo[table_a.atom].selEntry);
+  }
+  first->node.reset();
+}
+
+static bool SelectorAnySelected(PyMOLGlobals* G, const int* sele)
+{
+  const int n_atom = G->Selector->Table.size();
+  return std::any_of(sele, sele + n_atom, [](int tag) { return tag != 0; });
+}
+
+/**
+ * Check the arguments of every operation in a compiled selection
+ * expression, with the same checks as the evaluation. Evaluation may skip
+ * operands (see SelectorEvaluateNode), and a malformed operand must be
+ * reported no matter whether its result is needed.
+ *
+ * @param word, c Tokens and parse position, for error messages
+ */
+static pymol::Result<> SelectorValidateNode(PyMOLGlobals* G,
+    const EvalElem& elem, const std::vector<std::string>& word, int c)
+{
+  if(!elem.node)
+    return {};
+
+  const auto& base = elem.node->base;
+  for(const auto& e : base) {
+    p_return_if_error(SelectorValidateNode(G, e, word, c));
+  }
+
+  int ignore_case = SettingGetGlobal_b(G, cSetting_ignore_case);
+  int exact, oper, ival;
+  float fval;
+  bool ok = true;
+
+  switch (elem.node->type) {
+  case STYP_SEL1:
+    switch (base[0].code) {
+    case SELE_SELs:
+      {
+        const char* name = base[1].text();
+        if(name[0] == '?')      /* undefined ?sele allowed */
+          break;
+        CWordMatchOptions options;
+        WordMatchOptionsConfigAlpha(&options,
+            SettingGetGlobal_s(G, cSetting_wildcard)[0], ignore_case);
+        if(auto matcher = WordMatcherNew(G, name, &options, false)) {
+          WordMatcherFree(matcher);
+          break;
+        }
+        if(SelectGetInfoIter(G, name, 1, ignore_case) !=
+           G->SelectorMgr->Info.end())
+          break;
+        if(int group_list_id = ExecutiveGetExpandedGroupList(G, name)) {
+          ExecutiveFreeGroupList(G, group_list_id);
+          break;
+        }
+        return_error_with_tokens(
+            pymol::join_to_string("Invalid selection name \"", name, "\"."));
+      }
+    case SELE_MODs:
+      {
+        auto name = base[1].m_text.substr(0, base[1].m_text.find('`'));
+        CWordMatchOptions options;
+        WordMatchOptionsConfigAlpha(&options,
+            SettingGetGlobal_s(G, cSetting_wildcard)[0], ignore_case);
+        if(auto matcher = WordMatcherNew(G, name.c_str(), &options, false)) {
+          WordMatcherFree(matcher);
+          break;
+        }
+        const auto& objs = G->Selector->Obj;
+        auto obj = ExecutiveFindObjectByName(G, name.c_str());
+        if(obj && std::find(objs.begin() + cNDummyModels, objs.end(), obj) !=
+                      objs.end())
+          break;
+        if(sscanf(name.c_str(), "%i", &ival) == 1 && ival > 0 &&
+           ival < int(objs.size()) && objs[ival])
+          break;
+        return_error_with_tokens(
+            pymol::join_to_string("invalid model \"", name, "\""));
+      }
+    case SELE_STAs:
+      ival = 0;
+      sscanf(base[1].text(), "%d", &ival);
+      if(ival - 1 < 0 && ival - 1 != cSelectorUpdateTableCurrentState) {
+        return_error_with_tokens(pymol::join_to_string(
+            "state ", ival, " unsupported (must be -1 (current) or >=1)"));
+      }
+      break;
+    }
+    break;
+  case STYP_SEL2:
+    switch (base[0].code) {
+    case SELE_XVLx:
+    case SELE_YVLx:
+    case SELE_ZVLx:
+    case SELE_PCHx:
+    case SELE_FCHx:
+    case SELE_BVLx:
+    case SELE_QVLx:
+      oper = WordKey(G, AtOper, base[1].text(), 4, ignore_case, &exact);
+      switch (oper) {
+      case SCMP_GTHN:
+      case SCMP_LTHN:
+      case SCMP_EQAL:
+        if(sscanf(base[2].text(), "%f", &fval) != 1)
+          ok = ErrMessage(G, "Selector", "Invalid Number");
+        break;
+      case 0:
+        ok = ErrMessage(G, "Selector", "Invalid Operator.");
+        break;
+      default:
+        switch (base[0].code) {
+        case SELE_XVLx:
+        case SELE_YVLx:
+        case SELE_ZVLx:
+          ok = ErrMessage(G, "Selector", "Invalid Operator.");
+        }
+      }
+      break;
+    }
+    break;
+  case STYP_SEL3:
+#ifndef _PYMOL_IP_PROPERTIES
+    if(base[0].code == SELE_PROP) {
+      return pymol::Error::make<pymol::Error::INCENTIVE_ONLY>(
+          "properties (p.) not supported in Open-Source PyMOL");
+    }
+#endif
+    break;
+  case STYP_PRP1:
+    switch (base[1].code) {
+    case SELE_ARD_:
+    case SELE_EXP_:
+    case SELE_GAP_:
+      if(!sscanf(base[2].text(), "%f", &fval))
+        ok = ErrMessage(G, "Selector", "Invalid distance.");
+      break;
+    case SELE_EXT_:
+      if(sscanf(base[2].text(), "%d", &ival) != 1)
+        ok = ErrMessage(G, "Selector", "Invalid bond count.");
+      break;
+    }
+    break;
+  case STYP_OP22:
+    switch (base[1].code) {
+    case SELE_WIT_:
+    case SELE_BEY_:
+    case SELE_NTO_:
+      if(!sscanf(base[2].text(), "%f", &fval))
+        ok = ErrMessage(G, "Selector", "Invalid distance.");
+      break;
+    }
+    break;
+  }
+
+  if(!ok) {
+    return pymol::Error(indicate_last_token(word, c));
+  }
+  return {};
+}
+
+/**
+ * Evaluate the compiled selection expression of a list entry and store
+ * the result in `elem.sele`.
+ *
+ * AND and OR chains are flattened. AND operands are evaluated cheapest
+ * first and evaluation stops as soon as nothing is left selected, "none"
+ * operands of OR are skipped.
+ *
+ * @param word, c Tokens and parse position, for error messages
+ */
+static pymol::Result<> SelectorEvaluateNode(PyMOLGlobals* G, EvalElem& elem,
+    int state, int quiet, const std::vector<std::string>& word, int c)
+{
+  if(!elem.node)
+    return {};
+
+  /* keep the node alive, `elem.node` gets reset below */
+  auto node = elem.node;
+  auto& base = node->base;
+  int ok = true;
+
+  if(node->type == STYP_OPR2 &&
+     (base[1].code == SELE_AND2 || base[1].code == SELE_OR_2 ||
+      base[1].code == SELE_IOR2)) {
+    const unsigned code = base[1].code;
+    const bool is_and = (code == SELE_AND2);
+    std::vector<EvalElem*> operands;
+
+    if(is_and) {
+      SeleNodeCollect(elem, SELE_AND2, SELE_AND2, operands);
+      SelectorCombineNamedOperands(G, operands, true);
+      std::stable_sort(operands.begin(), operands.end(),
+          [](const EvalElem* a, const EvalElem* b) {
+            return (a->node ? a->node->cost : 0) < (b->node ? b->node->cost : 0);
+          });
+    } else {
+      SeleNodeCollect(elem, SELE_OR_2, SELE_IOR2, operands);
+      auto end = std::remove_if(operands.begin() + 1, operands.end(),
+          [](const EvalElem* e) { return SeleNodeIsNone(*e); });
+      operands.erase(end, operands.end());
+      if(operands.size() > 1 && SeleNodeIsNone(*operands[0]))
+        operands.erase(operands.begin());
+      SelectorCombineNamedOperands(G, operands, false);
+    }
+
+    auto acc = operands[0];
+    p_return_if_error(
+        SelectorEvaluateNode(G, *acc, state, quiet, word, c));
+
+    for(size_t i = 1; i < operands.size(); i++) {
+      if(is_and && !SelectorAnySelected(G, acc->sele_data()))
+        break;
+      p_return_if_error(
+          SelectorEvaluateNode(G, *operands[i], state, quiet, word, c));
+
+      EvalElem tmp[3];
+      tmp[0].sele = std::move(acc->sele);
+      tmp[1].type = STYP_OPR2;
+      tmp[1].code = code;
+      tmp[2].sele = std::move(operands[i]->sele);
+      SelectorLogic2(G, tmp);
+      acc->sele = std::move(tmp[0].sele);
+    }
+
+    elem.sele = std::move(acc->sele);
+    elem.node.reset();
+    return {};
+  }
+
+  if(node->type == STYP_OPR2 && base[1].code == SELE_ANT2) {
+    /* nothing to subtract from */
+    p_return_if_error(
+        SelectorEvaluateNode(G, base[0], state, quiet, word, c));
+    if(!SelectorAnySelected(G, base[0].sele_data())) {
+      elem.sele = std::move(base[0].sele);
+      elem.node.reset();
+      return {};
+    }
+  }
+
+  for(auto& e : base) {
+    if(e.type == STYP_LIST) {
+      p_return_if_error(
+          SelectorEvaluateNode(G, e, state, quiet, word, c));
+    } else if(e.type != STYP_VALU) {
+      G->Selector->EvalDeps |= SelectorCodeDeps(e.code);
+    }
+  }
+
+  switch (node->type) {
+  case STYP_SEL0:
+    ok = SelectorSelect0(G, &base[0]);
+    break;
+  case STYP_SEL1:
+    return_on_error_with_tokens(SelectorSelect1(G, &base[0], quiet));
+    break;
+  case STYP_SEL2:
+    ok = SelectorSelect2(G, &base[0], state);
+    break;
+  case STYP_SEL3:
+    p_return_if_error(SelectorSelect3(G, &base[0], state));
+    break;
+  case STYP_OPR1:
+    ok = SelectorLogic1(G, &base[0], state);
+    break;
+  case STYP_OPR2:
+    ok = SelectorLogic2(G, &base[0]);
+    break;
+  case STYP_PRP1:
+    ok = SelectorModulate1(G, &base[0], state);
+    break;
+  case STYP_OP22:
+    ok = SelectorOperator22(G, &base[0], state);
+    break;
+  }
+
+  if(!ok) {
+    return pymol::Error(indicate_last_token(word, c));
+  }
+
+  elem.sele = std::move(base[0].sele);
+  elem.node.reset();
+  return {};
+}
+
 /*========================================================================*/
 pymol::Result<sele_array_t> SelectorEvaluate(PyMOLGlobals* G,
     std::vector<std::string>& word,
@@ -9825,7 +10662,7 @@ pymol::Result<sele_array_t> SelectorEvaluate(PyMOLGlobals* G,
             if(depth > 0)
               if((!opFlag) && (Stack[depth].type == STYP_SEL0)) {
                 opFlag = true;
-                ok = SelectorSelect0(G, &Stack[depth]);
+                SelectorDeferOperation(Stack, depth, 1);
               }
           if(ok)
             if(depth > 1)
@@ -9834,8 +10671,7 @@ pymol::Result<sele_array_t> SelectorEvaluate(PyMOLGlobals* G,
                    && (Stack[depth].type == STYP_VALU)) {
                   /* 1 argument selection operator */
                   opFlag = true;
-                  return_on_error_with_tokens(
-                      SelectorSelect1(G, &Stack[depth - 1], quiet));
+                  SelectorDeferOperation(Stack, depth - 1, 2);
                   for(a = depth + 1; a <= totDepth; a++)
                     Stack[a - 1] = std::move(Stack[a]);
                   totDepth--;
@@ -9843,7 +10679,7 @@ pymol::Result<sele_array_t> SelectorEvaluate(PyMOLGlobals* G,
                           && (Stack[depth].type == STYP_LIST)) {
                   /* 1 argument logical operator */
                   opFlag = true;
-                  ok = SelectorLogic1(G, &Stack[depth - 1], state);
+                  SelectorDeferOperation(Stack, depth - 1, 2);
                   for(a = depth + 1; a <= totDepth; a++)
                     Stack[a - 1] = std::move(Stack[a]);
                   totDepth--;
@@ -9876,7 +10712,7 @@ pymol::Result<sele_array_t> SelectorEvaluate(PyMOLGlobals* G,
                    && (Stack[depth].type == STYP_LIST)
                    && (Stack[depth - 2].type == STYP_LIST)) {
                   /* 2 argument logical operator */
-                  ok = SelectorLogic2(G, &Stack[depth - 2]);
+                  SelectorDeferOperation(Stack, depth - 2, 3);
                   opFlag = true;
                   for(a = depth + 1; a <= totDepth; a++)
                     Stack[a - 2] = std::move(Stack[a]);
@@ -9885,7 +10721,7 @@ pymol::Result<sele_array_t> SelectorEvaluate(PyMOLGlobals* G,
                           && (Stack[depth].type == STYP_PVAL)
                           && (Stack[depth - 2].type == STYP_LIST)) {
                   /* 2 argument logical operator */
-                  ok = SelectorModulate1(G, &Stack[depth - 2], state);
+                  SelectorDeferOperation(Stack, depth - 2, 3);
                   opFlag = true;
                   for(a = depth + 1; a <= totDepth; a++)
                     Stack[a - 2] = std::move(Stack[a]);
@@ -9901,7 +10737,7 @@ pymol::Result<sele_array_t> SelectorEvaluate(PyMOLGlobals* G,
                    && (Stack[depth - 1].type == STYP_VALU)
                    && (Stack[depth].type == STYP_VALU)) {
                   /* 2 argument value operator */
-                  ok = SelectorSelect2(G, &Stack[depth - 2], state);
+                  SelectorDeferOperation(Stack, depth - 2, 3);
                   opFlag = true;
                   for(a = depth + 1; a <= totDepth; a++)
                     Stack[a - 2] = std::move(Stack[a]);
@@ -9919,8 +10755,7 @@ pymol::Result<sele_array_t> SelectorEvaluate(PyMOLGlobals* G,
                    && (Stack[depth - 1].type == STYP_VALU)
                    && (Stack[depth - 2].type == STYP_VALU)) {
                   /* 2 argument logical operator */
-                  p_return_if_error(
-                      SelectorSelect3(G, &Stack[depth - 3], state));
+                  SelectorDeferOperation(Stack, depth - 3, 4);
                   opFlag = true;
                   for(a = depth + 1; a <= totDepth; a++)
                     Stack[a - 3] = std::move(Stack[a]);
@@ -9940,7 +10775,7 @@ pymol::Result<sele_array_t> SelectorEvaluate(PyMOLGlobals* G,
                    && (Stack[depth].type == STYP_LIST)
                    && (Stack[depth - 4].type == STYP_LIST)) {
 
-                  ok = SelectorOperator22(G, &Stack[depth - 4], state);
+                  SelectorDeferOperation(Stack, depth - 4, 5);
                   opFlag = true;
                   for(a = depth + 1; a <= totDepth; a++)
                     Stack[a - 4] = std::move(Stack[a]);
@@ -9977,6 +10812,11 @@ pymol::Result<sele_array_t> SelectorEvaluate(PyMOLGlobals* G,
     return pymol::Error("Invalid selection.");
   }
 
+  /* evaluate the compiled expression, operands may get skipped */
+  p_return_if_error(SelectorValidateNode(G, Stack[totDepth], word, c));
+  p_return_if_error(
+      SelectorEvaluateNode(G, Stack[totDepth], state, quiet, word, c));
+
   return std::move(Stack[totDepth].sele); /* return the selection list */
 }
 
@@ -10312,8 +11152,8 @@ DistSet *SelectorGetDistSet(PyMOLGlobals * G, DistSet * ds,
       /* the states are valid for these two atoms */
       if((state1 < obj1->NCSet) && (state2 < obj2->NCSet)) {
 	/* get the coordinate sets for both atoms */
-        cs1 = obj1->CSet[state1];
-        cs2 = obj2->CSet[state2];
+        cs1 = obj1->getCoordSet(state1);
+        cs2 = obj2->getCoordSet(state2);
         if(cs1 && cs2) {
 	  /* for bonding */
           float *don_vv = NULL;
@@ -10544,7 +11384,7 @@ DistSet *SelectorGetAngleSet(PyMOLGlobals * G, DistSet * ds,
           obj1 = I->Obj[I->Table[a1].model];
 
           if(state1 < obj1->NCSet) {
-            cs1 = obj1->CSet[state1];
+            cs1 = obj1->getCoordSet(state1);
 
             if(cs1) {
               idx1 = cs1->atmToIdx(at1);
@@ -10558,7 +11398,7 @@ DistSet *SelectorGetAngleSet(PyMOLGlobals * G, DistSet * ds,
 
                   if(state2 < obj2->NCSet) {
 
-                    cs2 = obj2->CSet[state2];
+                    cs2 = obj2->getCoordSet(state2);
 
                     if(cs2) {
                       idx2 = cs2->atmToIdx(at2);
@@ -10582,7 +11422,7 @@ DistSet *SelectorGetAngleSet(PyMOLGlobals * G, DistSet * ds,
 
                               if(state3 < obj3->NCSet) {
 
-                                cs3 = obj3->CSet[state3];
+                                cs3 = obj3->getCoordSet(state3);
 
                                 if(cs3) {
                                   idx3 = cs3->atmToIdx(at3);
@@ -10829,7 +11669,7 @@ DistSet *SelectorGetDihedralSet(PyMOLGlobals * G, DistSet * ds,
           at1 = I->Table[a1].atom;
           obj1 = I->Obj[I->Table[a1].model];
           if(state1 < obj1->NCSet) {
-            cs1 = obj1->CSet[state1];
+            cs1 = obj1->getCoordSet(state1);
 
             if(cs1) {
               idx1 = cs1->atmToIdx(at1);
@@ -10843,7 +11683,7 @@ DistSet *SelectorGetDihedralSet(PyMOLGlobals * G, DistSet * ds,
 
                   if(state2 < obj2->NCSet) {
 
-                    cs2 = obj2->CSet[state2];
+                    cs2 = obj2->getCoordSet(state2);
 
                     if(cs2) {
                       idx2 = cs2->atmToIdx(at2);
@@ -10860,7 +11700,7 @@ DistSet *SelectorGetDihedralSet(PyMOLGlobals * G, DistSet * ds,
 
                             if(state3 < obj3->NCSet) {
 
-                              cs3 = obj3->CSet[state3];
+                              cs3 = obj3->getCoordSet(state3);
 
                               if(cs3) {
                                 idx3 = cs3->atmToIdx(at3);
@@ -10887,7 +11727,7 @@ DistSet *SelectorGetDihedralSet(PyMOLGlobals * G, DistSet * ds,
 
                                           if(state4 < obj4->NCSet) {
 
-                                            cs4 = obj4->CSet[state4];
+                                            cs4 = obj4->getCoordSet(state4);
 
                                             if(cs4) {
                                               idx4 = cs3->atmToIdx(at4);
@@ -75,6 +75,9 @@ void SelectorFree(PyMOLGlobals * G);
 void SelectorFreeImpl(PyMOLGlobals * G, CSelector *I, short init2);
 void SelectorDelete(PyMOLGlobals * G, const char *sele);
 void SelectorFreeTmp(PyMOLGlobals * G, const char *name);
+void SelectorCacheClear(PyMOLGlobals * G);
+void SelectorCacheGetStats(PyMOLGlobals * G, size_t * hits, size_t * misses,
+                           size_t * size);
 int SelectorGetTmp2(PyMOLGlobals * G, const char *input, char *store, bool quiet=false);
 int SelectorGetTmp(PyMOLGlobals * G, const char *input, char *store, bool quiet=false);
 
@@ -204,6 +207,7 @@ int SelectorAssignAtomTypes(PyMOLGlobals * G, int sele, int state, int quiet, in
 #define SELECTOR_BASE_TAG 0x10
 
 int SelectorIsMember(PyMOLGlobals * G, SelectorMemberOffset_t, SelectorID_t);
+void SelectorUpdateMemberBitmap(PyMOLGlobals * G, SelectorID_t sele);
 
 /**
  * Wrapper around SelectorGetTmp/SelectorFreeTmp/SelectorIndexByName.
@@ -10,6 +10,8 @@
 #include "pymol/memory.h"
 
 #include "AtomIterators.h"
+#include "Bitmap.h"
+#include <list>
 #include <string>
 #include <unordered_map>
 
@@ -50,13 +52,74 @@ struct MemberType {
   SelectorMemberOffset_t next;
 };
 
+/**
+ * Membership of one selection, indexed by member offset: bit `s` is set if
+ * the member list starting at `s` (an `AtomInfoType::selEntry`) contains the
+ * selection. Lets `SelectorIsMember` answer without walking the list.
+ */
+struct SelectionBitmapRec {
+  pymol::Bitmap bits;
+  bool tagged = false; //!< some member has a tag other than 1
+  size_t n_log = 0;    //!< inserts from `CSelectorManager::MemberLog` applied
+};
+
+/**
+ * Inserted member `offset`, with the values it had at insertion time
+ */
+struct MemberInsertRec {
+  SelectorMemberOffset_t offset;
+  MemberType member;
+};
+
+/**
+ * Result of a selection expression, as cached by `SelectorGetTmp`. Valid as
+ * long as the molecular objects, their change counters and the named
+ * selections are the same as when it was stored.
+ */
+struct SelectionCacheObjectRec {
+  ObjectMolecule* obj; //!< only dereferenced if `Serial` matches
+  unsigned Serial;
+  int NAtom;
+  int NCSet;
+  int state; //!< current state, only checked for state dependent results
+  unsigned AtomVersion;
+  unsigned CoordVersion;
+  unsigned StateVersion;
+  char AtomNameWildcard; //!< first char of the object's atom_name_wildcard
+};
+
+struct SelectionCacheMemberRec {
+  int obj; //!< index into `SelectionCacheEntry::objects`
+  int atom;
+  int tag;
+};
+
+struct SelectionCacheEntry {
+  std::string input;
+  int deps = 0;     //!< cSeleDep* flags
+  std::string settings; //!< values of the matching related settings
+  int theOneObject = -1;
+  int theOneAtom = -1;
+  std::vector<SelectionCacheObjectRec> objects;
+  std::vector<SelectionCacheMemberRec> members;
+};
+
 struct CSelectorManager
 {
   std::vector<MemberType> Member;
   SelectorMemberOffset_t FreeMember = 0;
+  // lazily built, dropped on relabel/purge. Inserts are logged and applied
+  // to a bitmap when it is updated next.
+  std::unordered_map<SelectorID_t, SelectionBitmapRec> MemberBitmap;
+  std::vector<MemberInsertRec> MemberLog;
   std::vector<SelectionInfoRec> Info;
   SelectorID_t NSelection = 0;
   std::unordered_map<std::string, int> Key;
+  // selection result cache, most recently used first
+  std::list<SelectionCacheEntry> Cache;
+  std::unordered_map<std::string, std::list<SelectionCacheEntry>::iterator> CacheIndex;
+  size_t CacheHits = 0;
+  size_t CacheMisses = 0;
   CSelectorManager();
 };
 
@@ -69,6 +132,7 @@ struct CSelector {
   pymol::cache_ptr<ObjectMolecule> Center;
   int NCSet = 0; // Seems to hold the largest NCSet in Obj
   bool SeleBaseOffsetsValid = false;
+  int EvalDeps = 0; // cSeleDep* flags, accumulated by evaluation
   CSelector(PyMOLGlobals* G, CSelectorManager* mgr);
   CSelector(const CSelector&) = default;
   CSelector& operator=(const CSelector&) = default;
@@ -445,91 +445,6 @@ static PyObject *CmdFixChemistry(PyObject * self, PyObject * args)
   return APIResult(G, result);
 }
 
-static PyObject *CmdRayAntiThread(PyObject * self, PyObject * args)
-{
-  PyMOLGlobals *G = NULL;
-  PyObject *py_thread_info;
-  API_SETUP_ARGS(G, self, args, "OO", &self, &py_thread_info);
-
-  auto thread_info = reinterpret_cast<CRayAntiThreadInfo*>(
-      PyCapsule_GetPointer(py_thread_info, nullptr));
-  API_ASSERT(thread_info);
-
-  PUnblock(G);
-  RayAntiThread(thread_info);
-  PBlock(G);
-
-  return APISuccess();
-}
-
-static PyObject *CmdRayHashThread(PyObject * self, PyObject * args)
-{
-  PyMOLGlobals *G = NULL;
-  PyObject *py_thread_info;
-  API_SETUP_ARGS(G, self, args, "OO", &self, &py_thread_info);
-
-  auto thread_info = reinterpret_cast<CRayHashThreadInfo*>(
-      PyCapsule_GetPointer(py_thread_info, nullptr));
-  API_ASSERT(thread_info);
-
-  PUnblock(G);
-  RayHashThread(thread_info);
-  PBlock(G);
-
-  return APISuccess();
-}
-
-static PyObject *CmdRayTraceThread(PyObject * self, PyObject * args)
-{
-  PyMOLGlobals *G = NULL;
-  PyObject *py_thread_info;
-  API_SETUP_ARGS(G, self, args, "OO", &self, &py_thread_info);
-
-  auto thread_info = reinterpret_cast<CRayThreadInfo*>(
-      PyCapsule_GetPointer(py_thread_info, nullptr));
-  API_ASSERT(thread_info);
-
-  PUnblock(G);
-  RayTraceThread(thread_info);
-  PBlock(G);
-
-  return APISuccess();
-}
-
-static PyObject *CmdCoordSetUpdateThread(PyObject * self, PyObject * args)
-{
-  PyMOLGlobals *G = NULL;
-  PyObject *py_thread_info;
-  API_SETUP_ARGS(G, self, args, "OO", &self, &py_thread_info);
-
-  auto thread_info = reinterpret_cast<CCoordSetUpdateThreadInfo*>(
-      PyCapsule_GetPointer(py_thread_info, nullptr));
-  API_ASSERT(thread_info);
-
-  PUnblock(G);
-  CoordSetUpdateThread(thread_info);
-  PBlock(G);
-
-  return APISuccess();
-}
-
-static PyObject *CmdObjectUpdateThread(PyObject * self, PyObject * args)
-{
-  PyMOLGlobals *G = NULL;
-  PyObject *py_thread_info;
-  API_SETUP_ARGS(G, self, args, "OO", &self, &py_thread_info);
-
-  auto thread_info = reinterpret_cast<CObjectUpdateThreadInfo*>(
-      PyCapsule_GetPointer(py_thread_info, nullptr));
-  API_ASSERT(thread_info);
-
-  PUnblock(G);
-  SceneObjectUpdateThread(thread_info);
-  PBlock(G);
-
-  return APISuccess();
-}
-
 static PyObject *CmdGetMovieLocked(PyObject * self, PyObject * args)
 {
   PyMOLGlobals *G = NULL;
@@ -722,7 +637,7 @@ static PyObject * CmdGetVolumeField(PyObject * self, PyObject * args)
     API_HANDLE_ERROR;
   }
   if(ok && (ok = APIEnterBlockedNotModal(G))) {
-    CField * field = ExecutiveGetVolumeField(G, objName, state);
+    CField * field = ExecutiveGetVolumeField(G, objName, state, !copy);
     if (field) {
       result = FieldAsNumPyArray(field, copy);
     }
@@ -979,9 +894,10 @@ static PyObject *CmdGetSession(PyObject * self, PyObject * args)
   const char* names;
   int binary = -1;
   float version = -1.f;
+  PyObject* sink = Py_None;
 
-  API_SETUP_ARGS(G, self, args, "OOsii|if", &self, &dict, &names, &partial,
-      &quiet, &binary, &version);
+  API_SETUP_ARGS(G, self, args, "OOsii|ifO", &self, &dict, &names, &partial,
+      &quiet, &binary, &version, &sink);
   API_ASSERT(-1 <= binary && binary <= 1);
 
   APIEnterBlocked(G);
@@ -994,7 +910,8 @@ static PyObject *CmdGetSession(PyObject * self, PyObject * args)
   if (version >= 0.f)
     SettingSet(G, cSetting_pse_export_version, version);
 
-  ExecutiveGetSession(G, dict, names, partial, quiet);
+  ExecutiveGetSession(G, dict, names, partial, quiet,
+      sink != Py_None ? sink : nullptr);
 
   SettingSet(G, cSetting_pse_binary_dump, binary_orig);
   SettingSet(G, cSetting_pse_export_version, version_orig);
@@ -2002,6 +1919,18 @@ ok_except2:
   return (APIAutoNone(result));
 }
 
+static PyObject *CmdGetAtomColumns(PyObject * self, PyObject * args)
+{
+  PyMOLGlobals *G = NULL;
+  const char *str1;
+  PyObject *names;
+  API_SETUP_ARGS(G, self, args, "OsO", &self, &str1, &names);
+  APIEnterBlocked(G);
+  auto result = ExecutiveGetAtomColumns(G, str1, names);
+  APIExitBlocked(G);
+  return APIResult(G, result);
+}
+
 static PyObject *CmdGetSettingUpdates(PyObject * self, PyObject * args)
 {
   PyMOLGlobals *G = NULL;
@@ -3693,6 +3622,18 @@ static PyObject *CmdGetMovieLength(PyObject * self, PyObject * args)
   return (APIResultCode(result));
 }
 
+static PyObject *CmdGetSelectionCacheStats(PyObject * self, PyObject * args)
+{
+  PyMOLGlobals *G = NULL;
+  size_t hits = 0, misses = 0, size = 0;
+  API_SETUP_ARGS(G, self, args, "O", &self);
+  APIEnter(G);
+  SelectorCacheGetStats(G, &hits, &misses, &size);
+  APIExit(G);
+  return Py_BuildValue("(nnn)", (Py_ssize_t) hits, (Py_ssize_t) misses,
+                       (Py_ssize_t) size);
+}
+
 static PyObject *CmdIdentify(PyObject * self, PyObject * args)
 {
   PyMOLGlobals *G = NULL;
@@ -5446,6 +5387,18 @@ static PyObject *CmdLoadCoords(PyObject * self, PyObject * args)
   return APIResult(G, result);
 }
 
+static PyObject *CmdSetAtomColumns(PyObject * self, PyObject * args)
+{
+  PyMOLGlobals *G = NULL;
+  const char *str1;
+  PyObject *names, *columns;
+  API_SETUP_ARGS(G, self, args, "OsOO", &self, &str1, &names, &columns);
+  API_ASSERT(APIEnterBlockedNotModal(G));
+  auto result = ExecutiveSetAtomColumns(G, str1, names, columns);
+  APIExitBlocked(G);
+  return APIResult(G, result);
+}
+
 static PyObject *CmdLoadCoordSet(PyObject * self, PyObject * args)
 {
   PyMOLGlobals *G = NULL;
@@ -6262,7 +6215,6 @@ static PyMethodDef Cmd_methods[] = {
   {"color", CmdColor, METH_VARARGS},
   {"colordef", CmdColorDef, METH_VARARGS},
   {"combine_object_ttt", CmdCombineObjectTTT, METH_VARARGS},
-  {"coordset_update_thread", CmdCoordSetUpdateThread, METH_VARARGS},
   {"copy", CmdCopy, METH_VARARGS},
   {"create", CmdCreate, METH_VARARGS},
   {"count_states", CmdCountStates, METH_VARARGS},
@@ -6310,6 +6262,7 @@ static PyMethodDef Cmd_methods[] = {
   {"get_collada", CmdGetCOLLADA, METH_VARARGS},
   {"get_color", CmdGetColor, METH_VARARGS},
   {"get_colorection", CmdGetColorection, METH_VARARGS},
+  {"get_atom_columns", CmdGetAtomColumns, METH_VARARGS},
   {"get_coords", CmdGetCoordsAsNumPy, METH_VARARGS},
   {"get_coordset", CmdGetCoordSetAsNumPy, METH_VARARGS},
   {"get_distance", CmdGetDistance, METH_VARARGS},
@@ -6339,6 +6292,7 @@ static PyMethodDef Cmd_methods[] = {
   {"get_origin", CmdGetOrigin, METH_VARARGS},
   {"get_position", CmdGetPosition, METH_VARARGS},
   {"get_povray", CmdGetPovRay, METH_VARARGS},
+  {"get_selection_cache_stats", CmdGetSelectionCacheStats, METH_VARARGS},
   {"get_progress", CmdGetProgress, METH_VARARGS},
   {"get_phipsi", CmdGetPhiPsi, METH_VARARGS},
   {"get_renderer", CmdGetRenderer, METH_VARARGS},
@@ -6416,7 +6370,6 @@ static PyMethodDef Cmd_methods[] = {
   {"mmatrix", CmdMMatrix, METH_VARARGS},
   {"move_on_curve", CmdMoveOnCurve, METH_VARARGS},
   {"mview", CmdMView, METH_VARARGS},
-  {"object_update_thread", CmdObjectUpdateThread, METH_VARARGS},
   {"origin", CmdOrigin, METH_VARARGS},
   {"orient", CmdOrient, METH_VARARGS},
   {"onoff", CmdOnOff, METH_VARARGS},
@@ -6435,9 +6388,6 @@ static PyMethodDef Cmd_methods[] = {
   {"pbc_unwrap", CmdPBCUnwrap, METH_VARARGS},
   {"pbc_wrap", CmdPBCWrap, METH_VARARGS},
   {"quit", CmdQuit, METH_VARARGS},
-  {"ray_trace_thread", CmdRayTraceThread, METH_VARARGS},
-  {"ray_hash_thread", CmdRayHashThread, METH_VARARGS},
-  {"ray_anti_thread", CmdRayAntiThread, METH_VARARGS},
   {"ramp_new", CmdRampNew, METH_VARARGS},
   {"ready", CmdReady, METH_VARARGS},
   {"rebuild", CmdRebuild, METH_VARARGS},
@@ -6475,6 +6425,7 @@ static PyMethodDef Cmd_methods[] = {
   {"sculpt_iterate", CmdSculptIterate, METH_VARARGS},
   {"sculpt_purge", CmdSculptPurge, METH_VARARGS},
   {"set_raw_alignment", CmdSetRawAlignment, METH_VARARGS},
+  {"set_atom_columns", CmdSetAtomColumns, METH_VARARGS},
   {"set_busy", CmdSetBusy, METH_VARARGS},
   {"set_colorection", CmdSetColorection, METH_VARARGS},
   {"set_dihe", CmdSetDihe, METH_VARARGS},
@@ -66,6 +66,7 @@
 #include "ButMode.h"
 #include "CGORenderer.h"
 #include "GFXManager.h"
+#include "TaskPool.h"
 
 #ifdef _PYMOL_OPENVR
 #include "OpenVRMode.h"
@@ -696,7 +697,7 @@ static OVstatus PyMOL_InitAPI(CPyMOL * I)
   LEX_ATOM_PROP(s, 35, cPType_settings, 0);
   LEX_ATOM_PROP(p, 36, cPType_properties, 0);
   LEX_ATOM_PROP(state, 37, cPType_state, 0);
-  LEX_ATOM_PROP(reps, 38, cPType_int, offsetof(AtomInfoType, visRep));
+  LEX_ATOM_PROP(reps, ATOM_PROP_REPS, cPType_int, offsetof(AtomInfoType, visRep));
   LEX_ATOM_PROP(protons, 39, cPType_schar, offsetof(AtomInfoType, protons));
   LEX_ATOM_PROP(oneletter, 40, 0, 0);
   LEX_ATOM_PROP(explicit_degree, ATOM_PROP_EXPLICIT_DEGREE, 0, 0);
@@ -1507,6 +1508,7 @@ struct {
   {"pdb",           cLoadTypePDBStr,    cLoadTypePDB},
   {"vdb",           cLoadTypeVDBStr,    cLoadTypeUnknown},
   {"cif",           cLoadTypeCIFStr,    cLoadTypeCIF},
+  {"bcif",          cLoadTypeBCIFStr,   cLoadTypeBCIF},
   {"mmtf",          cLoadTypeMMTFStr,   cLoadTypeMMTF},
   {"mae",           cLoadTypeMAEStr,    cLoadTypeMAE},
   {"sdf",           cLoadTypeSDF2Str,   cLoadTypeSDF2},
@@ -1930,6 +1932,7 @@ void PyMOL_Start(CPyMOL * I)
 #include "lex_constants.h"
 
   G->Feedback = new CFeedback(G, G->Option->quiet);
+  G->TaskPool = new pymol::TaskPool();
   WordInit(G);
   UtilInit(G);
   ColorInit(G);
@@ -2048,6 +2051,7 @@ void PyMOL_Stop(CPyMOL * I)
   ColorFree(G);
   UtilFree(G);
   WordFree(G);
+  DeleteP(G->TaskPool);
   DeleteP(G->Feedback);
 
   PyMOL_PurgeAPI(I);
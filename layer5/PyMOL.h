@@ -153,6 +153,7 @@ struct CPyMOL;
 #define ATOM_PROP_Z 32
 #define ATOM_PROP_SETTINGS 33
 #define ATOM_PROP_PROPERTIES 34
+#define ATOM_PROP_REPS 38
 #define ATOM_PROP_ONELETTER 40
 #define ATOM_PROP_EXPLICIT_DEGREE 41
 #define ATOM_PROP_EXPLICIT_VALENCE 42
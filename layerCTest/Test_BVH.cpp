@@ -0,0 +1,260 @@
+#include "Test.h"
+
+#include "BVH.h"
+
+#include <algorithm>
+#include <random>
+#include <set>
+
+namespace
+{
+bool rayHitsBox(const float* org, const float* dir, const float* box,
+    float t_min, float t_max)
+{
+  for (int a = 0; a < 3; ++a) {
+    if (dir[a] == 0.f) {
+      if (org[a] < box[a] || org[a] > box[a + 3])
+        return false;
+      continue;
+    }
+    float t0 = (box[a] - org[a]) / dir[a];
+    float t1 = (box[a + 3] - org[a]) / dir[a];
+    if (t0 > t1)
+      std::swap(t0, t1);
+    t_min = std::max(t_min, t0);
+    t_max = std::min(t_max, t1);
+  }
+  return t_min <= t_max;
+}
+} // namespace
+
+TEST_CASE("BVH empty", "[BVH]")
+{
+  pymol::BVH bvh;
+  bvh.build(nullptr, nullptr, 0);
+  REQUIRE(bvh.empty());
+
+  const float org[3] = {0.f, 0.f, 0.f}, dir[3] = {0.f, 0.f, -1.f};
+  pymol::BVHRay ray(bvh, org, dir, 0.f);
+  REQUIRE(ray.next(1e10f) == nullptr);
+}
+
+TEST_CASE("BVH ray finds all intersected items once", "[BVH]")
+{
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<float> pos(-50.f, 50.f);
+  std::uniform_real_distribution<float> size(0.1f, 3.f);
+
+  const int n = 2000;
+  std::vector<float> bounds(n * 6);
+  std::vector<int> ids(n);
+
+  for (int i = 0; i < n; ++i) {
+    ids[i] = i * 3; // arbitrary identifiers
+    for (int a = 0; a < 3; ++a) {
+      // some clustering, plus a few identical boxes
+      float c = (i % 7) ? pos(rng) * 0.2f : pos(rng);
+      float r = size(rng);
+      if (i % 100 == 0)
+        c = 1.f, r = 1.f;
+      bounds[i * 6 + a] = c - r;
+      bounds[i * 6 + a + 3] = c + r;
+    }
+  }
+
+  pymol::BVH bvh;
+  bvh.build(bounds.data(), ids.data(), n);
+  REQUIRE(bvh.itemCount() == n);
+
+  for (int trial = 0; trial < 200; ++trial) {
+    float org[3] = {pos(rng), pos(rng), 60.f};
+    float dir[3] = {0.f, 0.f, -1.f};
+    if (trial % 2) {
+      // perspective-like ray
+      dir[0] = pos(rng) * 0.01f;
+      dir[1] = pos(rng) * 0.01f;
+    } else if (trial % 4 == 0) {
+      org[0] = org[1] = 1.f;
+    }
+
+    std::set<int> expected;
+    for (int i = 0; i < n; ++i) {
+      if (rayHitsBox(org, dir, bounds.data() + i * 6, 0.f, 1e10f))
+        expected.insert(ids[i]);
+    }
+
+    std::multiset<int> found;
+    pymol::BVHRay ray(bvh, org, dir, 0.f);
+    while (const int* list = ray.next(1e10f)) {
+      for (; *list >= 0; ++list) {
+        found.insert(*list);
+      }
+    }
+
+    // leaves may contain extra items, but no item twice
+    for (int id : expected) {
+      REQUIRE(found.count(id) == 1);
+    }
+    REQUIRE(std::set<int>(found.begin(), found.end()).size() == found.size());
+  }
+}
+
+TEST_CASE("BVH ray visits leaves front to back", "[BVH]")
+{
+  // row of unit boxes along z
+  const int n = 64;
+  std::vector<float> bounds;
+  std::vector<int> ids;
+  for (int i = 0; i < n; ++i) {
+    float z = -2.f * i;
+    bounds.insert(bounds.end(), {-1.f, -1.f, z - 0.5f, 1.f, 1.f, z + 0.5f});
+    ids.push_back(i);
+  }
+
+  pymol::BVH bvh;
+  bvh.build(bounds.data(), ids.data(), n);
+
+  const float org[3] = {0.f, 0.f, 10.f}, dir[3] = {0.f, 0.f, -1.f};
+  pymol::BVHRay ray(bvh, org, dir, 0.f);
+
+  // nearest leaf comes first
+  const int* list = ray.next(1e10f);
+  REQUIRE(list != nullptr);
+  bool has_first = false;
+  for (; *list >= 0; ++list) {
+    has_first |= (*list == 0);
+  }
+  REQUIRE(has_first);
+
+  // nothing left within a distance that only covers box 0
+  REQUIRE(ray.next(10.5f) == nullptr);
+}
+
+TEST_CASE("BVH packet yields the same items as single rays", "[BVH]")
+{
+  std::mt19937 rng(7);
+  std::uniform_real_distribution<float> pos(-20.f, 20.f);
+  std::uniform_real_distribution<float> size(0.1f, 2.f);
+
+  const int n = 1000;
+  std::vector<float> bounds(n * 6);
+  std::vector<int> ids(n);
+
+  for (int i = 0; i < n; ++i) {
+    ids[i] = i;
+    for (int a = 0; a < 3; ++a) {
+      float c = pos(rng), r = size(rng);
+      bounds[i * 6 + a] = c - r;
+      bounds[i * 6 + a + 3] = c + r;
+    }
+  }
+
+  pymol::BVH bvh;
+  bvh.build(bounds.data(), ids.data(), n);
+
+  for (int m = 1; m <= pymol::BVHPacket::MaxSize; ++m) {
+    // row of adjacent perspective rays, plus one going elsewhere
+    float org[pymol::BVHPacket::MaxSize][3];
+    float dir[pymol::BVHPacket::MaxSize][3];
+    float t_max[pymol::BVHPacket::MaxSize];
+    for (int k = 0; k < m; ++k) {
+      org[k][0] = org[k][1] = 0.f;
+      org[k][2] = 30.f;
+      dir[k][0] = -0.3f + 0.05f * k;
+      dir[k][1] = (k == 3) ? 0.5f : 0.1f;
+      dir[k][2] = -1.f;
+      t_max[k] = (k == 2) ? -1.f : 1e10f; // ray 2 inactive
+    }
+
+    std::vector<std::multiset<int>> found(m);
+    pymol::BVHPacket packet(bvh, m, org, dir, 0.f);
+    unsigned mask;
+    while (const int* list = packet.next(t_max, mask)) {
+      REQUIRE(mask != 0);
+      REQUIRE((mask >> m) == 0);
+      for (int k = 0; k < m; ++k) {
+        if (!(mask & (1u << k)))
+          continue;
+        for (const int* ip = list; *ip >= 0; ++ip) {
+          found[k].insert(*ip);
+        }
+      }
+    }
+
+    for (int k = 0; k < m; ++k) {
+      std::multiset<int> expected;
+      if (k != 2) {
+        pymol::BVHRay ray(bvh, org[k], dir[k], 0.f);
+        while (const int* list = ray.next(1e10f)) {
+          for (; *list >= 0; ++list) {
+            expected.insert(*list);
+          }
+        }
+      }
+      REQUIRE(found[k] == expected);
+    }
+  }
+}
+
+TEST_CASE("BVH packet item boxes match single ray box tests", "[BVH]")
+{
+  std::mt19937 rng(11);
+  std::uniform_real_distribution<float> pos(-20.f, 20.f);
+  std::uniform_real_distribution<float> size(0.1f, 2.f);
+
+  const int n = 500;
+  std::vector<float> bounds(n * 6);
+  std::vector<int> ids(n);
+
+  for (int i = 0; i < n; ++i) {
+    ids[i] = i;
+    for (int a = 0; a < 3; ++a) {
+      float c = pos(rng), r = size(rng);
+      bounds[i * 6 + a] = c - r;
+      bounds[i * 6 + a + 3] = c + r;
+    }
+  }
+
+  pymol::BVH bvh;
+  bvh.build(bounds.data(), ids.data(), n);
+
+  const int lanes = pymol::BVHPacket::lanes();
+  REQUIRE((lanes == 4 || lanes == 8));
+
+  for (int m = 1; m <= pymol::BVHPacket::MaxSize; ++m) {
+    // parallel rays (orthoscopic or shadow)
+    float org[pymol::BVHPacket::MaxSize][3];
+    float dir[pymol::BVHPacket::MaxSize][3];
+    float t_max[pymol::BVHPacket::MaxSize];
+    for (int k = 0; k < m; ++k) {
+      org[k][0] = -4.f + 1.1f * k;
+      org[k][1] = 0.7f * k;
+      org[k][2] = 30.f;
+      dir[k][0] = dir[k][1] = 0.f;
+      dir[k][2] = -1.f;
+      t_max[k] = (k == 1) ? 35.f : 1e10f;
+    }
+
+    pymol::BVHPacket packet(bvh, m, org, dir, 0.f);
+    unsigned mask, item_mask[64];
+    while (const int* list = packet.next(t_max, mask)) {
+      int n_items = 0;
+      while (list[n_items] >= 0)
+        ++n_items;
+      REQUIRE(n_items <= 64);
+
+      packet.intersectItems(list, n_items, t_max, item_mask);
+      for (int j = 0; j < n_items; ++j) {
+        REQUIRE((item_mask[j] & ~mask) == 0);
+        const float* box = bounds.data() + list[j] * 6;
+        REQUIRE(std::equal(box, box + 6, bvh.itemBounds(list + j)));
+        for (int k = 0; k < m; ++k) {
+          if (!(mask & (1u << k)))
+            continue;
+          const bool hit = rayHitsBox(org[k], dir[k], box, 0.f, t_max[k]);
+          REQUIRE(bool(item_mask[j] & (1u << k)) == hit);
+        }
+      }
+    }
+  }
+}
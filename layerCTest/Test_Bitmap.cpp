@@ -0,0 +1,89 @@
+#include "Test.h"
+
+#include "Bitmap.h"
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+
+namespace
+{
+// mix of sparse and dense chunks
+std::set<std::uint32_t> randomKeys(unsigned seed)
+{
+  std::mt19937 gen(seed);
+  std::uniform_int_distribution<std::uint32_t> sparse(0, 300000);
+  std::uniform_int_distribution<std::uint32_t> dense(70000, 80000);
+  std::set<std::uint32_t> keys;
+  for (int i = 0; i < 500; ++i)
+    keys.insert(sparse(gen));
+  for (int i = 0; i < 8000; ++i)
+    keys.insert(dense(gen));
+  return keys;
+}
+
+pymol::Bitmap toBitmap(const std::set<std::uint32_t>& keys)
+{
+  pymol::Bitmap bits;
+  for (auto key : keys)
+    bits.add(key);
+  return bits;
+}
+
+std::vector<std::uint32_t> toVector(const std::set<std::uint32_t>& keys)
+{
+  return {keys.begin(), keys.end()};
+}
+} // namespace
+
+TEST_CASE("Bitmap add remove contains", "[Bitmap]")
+{
+  auto keys = randomKeys(1);
+  pymol::Bitmap bits;
+  // descending, exercises the sorted insert
+  for (auto it = keys.rbegin(); it != keys.rend(); ++it)
+    bits.add(*it);
+  REQUIRE(bits.count() == keys.size());
+  REQUIRE(bits.toVector() == toVector(keys));
+
+  for (std::uint32_t key = 0; key < 310000; key += 13)
+    REQUIRE(bits.contains(key) == (keys.count(key) != 0));
+
+  for (std::uint32_t key = 0; key < 310000; key += 3) {
+    bits.remove(key);
+    keys.erase(key);
+  }
+  REQUIRE(bits.count() == keys.size());
+  REQUIRE(bits.toVector() == toVector(keys));
+}
+
+TEST_CASE("Bitmap set operations", "[Bitmap]")
+{
+  auto keys1 = randomKeys(2);
+  auto keys2 = randomKeys(3);
+  auto bits1 = toBitmap(keys1);
+  auto bits2 = toBitmap(keys2);
+
+  std::set<std::uint32_t> expected;
+  std::set_union(keys1.begin(), keys1.end(), keys2.begin(), keys2.end(),
+      std::inserter(expected, expected.end()));
+  auto bits = bits1;
+  bits |= bits2;
+  REQUIRE(bits.toVector() == toVector(expected));
+
+  expected.clear();
+  std::set_intersection(keys1.begin(), keys1.end(), keys2.begin(),
+      keys2.end(), std::inserter(expected, expected.end()));
+  bits = bits1;
+  bits &= bits2;
+  REQUIRE(bits.toVector() == toVector(expected));
+
+  expected.clear();
+  std::set_difference(keys1.begin(), keys1.end(), keys2.begin(), keys2.end(),
+      std::inserter(expected, expected.end()));
+  bits = bits1;
+  bits -= bits2;
+  REQUIRE(bits.toVector() == toVector(expected));
+  REQUIRE(bits1.toVector() == toVector(keys1));
+}
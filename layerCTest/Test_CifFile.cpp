@@ -149,3 +149,234 @@ TEST_CASE("misc", "[CifFile]")
 }
 
 // vi:sw=2:expandtab
+
+TEST_CASE("typed columns", "[CifFile]")
+{
+  std::string str = "data_typed\nloop_\n_cat.x\n_cat.n\n";
+  for (int i = 0; i < 1000; ++i) {
+    str += std::to_string(i * 0.5) + (i % 10 ? " " : "(3) ") +
+           (i % 7 ? std::to_string(i) : "?") + "\n";
+  }
+
+  pymol::cif_file cf(nullptr, str.c_str());
+  auto* data = &cf.datablocks().front();
+  auto* arr_x = data->get_opt("_cat.x");
+  auto* arr_n = data->get_opt("_cat.n");
+
+  REQUIRE(arr_x->size() == 1000);
+
+  // converted in bulk on first access, same as single value conversion
+  for (unsigned i = 0; i < 1000; ++i) {
+    REQUIRE(arr_x->as_d(i) == arr_x->as<double>(i));
+    REQUIRE(arr_x->as_d(i) == i * 0.5);
+    REQUIRE(arr_n->as_i(i, -1) == (i % 7 ? int(i) : -1));
+  }
+
+  REQUIRE(arr_n->as_i(1000, -1) == -1);
+  REQUIRE(arr_n->as_d(999) == 999.);
+}
+
+namespace
+{
+/**
+ * Minimal MessagePack writer for BinaryCIF test data
+ */
+struct msgpack_writer {
+  std::string buf;
+
+  void header(unsigned char code, std::size_t n)
+  {
+    buf += char(code);
+    for (int shift = 24; shift >= 0; shift -= 8)
+      buf += char(n >> shift);
+  }
+
+  void map(std::size_t n) { header(0xdf, n); }
+  void array(std::size_t n) { header(0xdd, n); }
+  void integer(int i) { header(0xd2, unsigned(i)); }
+
+  void str(const std::string& s)
+  {
+    header(0xdb, s.size());
+    buf += s;
+  }
+
+  template <typename T> void bin(const std::vector<T>& v)
+  {
+    header(0xc6, v.size() * sizeof(T));
+    for (T value : v)
+      for (unsigned k = 0; k < sizeof(T); ++k)
+        buf += char((unsigned(value) >> (8 * k)) & 0xff);
+  }
+
+  // {"kind": "ByteArray", "type": type}
+  void byte_array(int type)
+  {
+    map(2);
+    str("kind");
+    str("ByteArray");
+    str("type");
+    integer(type);
+  }
+};
+} // namespace
+
+TEST_CASE("BinaryCIF", "[CifFile]")
+{
+  msgpack_writer w;
+  w.map(2);
+  w.str("encoder");
+  w.str("test");
+  w.str("dataBlocks");
+  w.array(1);
+  w.map(2);
+  w.str("header");
+  w.str("1ABC");
+  w.str("categories");
+  w.array(1);
+  w.map(3);
+  w.str("name");
+  w.str("_atom_site");
+  w.str("rowCount");
+  w.integer(5);
+  w.str("columns");
+  w.array(4);
+
+  // 10, 11, 12, 13, 300: Delta, IntegerPacking, ByteArray(Int8)
+  w.map(2);
+  w.str("name");
+  w.str("id");
+  w.str("data");
+  w.map(2);
+  w.str("data");
+  w.bin(std::vector<signed char>{10, 1, 1, 1, 127, 127, 33});
+  w.str("encoding");
+  w.array(3);
+  w.map(3);
+  w.str("kind");
+  w.str("Delta");
+  w.str("origin");
+  w.integer(0);
+  w.str("srcType");
+  w.integer(3);
+  w.map(4);
+  w.str("kind");
+  w.str("IntegerPacking");
+  w.str("byteCount");
+  w.integer(1);
+  w.str("isUnsigned");
+  w.buf += char(0xc2);
+  w.str("srcSize");
+  w.integer(5);
+  w.byte_array(1);
+
+  // 1.5 x 3, -0.25 x 2: FixedPoint, RunLength, ByteArray(Int32)
+  w.map(2);
+  w.str("name");
+  w.str("Cartn_X");
+  w.str("data");
+  w.map(2);
+  w.str("data");
+  w.bin(std::vector<int>{1500, 3, -250, 2});
+  w.str("encoding");
+  w.array(3);
+  w.map(3);
+  w.str("kind");
+  w.str("FixedPoint");
+  w.str("factor");
+  w.integer(1000);
+  w.str("srcType");
+  w.integer(33);
+  w.map(3);
+  w.str("kind");
+  w.str("RunLength");
+  w.str("srcType");
+  w.integer(3);
+  w.str("srcSize");
+  w.integer(5);
+  w.byte_array(3);
+
+  // StringArray with mask
+  w.map(3);
+  w.str("name");
+  w.str("label_atom_id");
+  w.str("data");
+  w.map(2);
+  w.str("data");
+  w.bin(std::vector<unsigned char>{0, 1, 1, 0, 0});
+  w.str("encoding");
+  w.array(1);
+  w.map(5);
+  w.str("kind");
+  w.str("StringArray");
+  w.str("dataEncoding");
+  w.array(1);
+  w.byte_array(4);
+  w.str("stringData");
+  w.str("NCA");
+  w.str("offsetEncoding");
+  w.array(1);
+  w.byte_array(4);
+  w.str("offsets");
+  w.bin(std::vector<unsigned char>{0, 1, 3});
+  w.str("mask");
+  w.map(2);
+  w.str("data");
+  w.bin(std::vector<unsigned char>{0, 0, 0, 0, 2});
+  w.str("encoding");
+  w.array(1);
+  w.byte_array(4);
+
+  // float32 values
+  w.map(2);
+  w.str("name");
+  w.str("occupancy");
+  w.str("data");
+  w.map(2);
+  w.str("data");
+  w.bin(std::vector<unsigned>{0x3f800000, 0x3f000000, 0, 0, 0x3f800000});
+  w.str("encoding");
+  w.array(1);
+  w.byte_array(32);
+
+  pymol::cif_file cf;
+  REQUIRE(cf.parse_bcif(w.buf.data(), w.buf.size()));
+  REQUIRE(cf.datablocks().size() == 1);
+
+  auto* data = &cf.datablocks().front();
+  REQUIRE(data->code() == std::string("1ABC"));
+
+  auto* arr_id = data->get_opt("_atom_site.id");
+  auto* arr_x = data->get_opt("_atom_site.cartn_x");
+  auto* arr_name = data->get_opt("_atom_site.label_atom_id");
+  auto* arr_occ = data->get_opt("_atom_site.occupancy");
+
+  REQUIRE(arr_id->size() == 5);
+  REQUIRE(arr_id->as_i(0) == 10);
+  REQUIRE(arr_id->as_i(3) == 13);
+  REQUIRE(arr_id->as_i(4) == 300);
+  REQUIRE(arr_id->as_d(4) == 300.);
+  REQUIRE(arr_id->as_s(4) == std::string("300"));
+  REQUIRE(arr_id->as_i(5, -1) == -1);
+
+  REQUIRE(arr_x->as_d(2) == 1.5);
+  REQUIRE(arr_x->as_d(3) == -0.25);
+  REQUIRE(arr_x->as<float>(4) == -0.25f);
+  REQUIRE(arr_x->as_s(0) == std::string("1.500"));
+
+  REQUIRE(arr_name->as_s(0) == std::string("N"));
+  REQUIRE(arr_name->as_s(1) == std::string("CA"));
+  REQUIRE(arr_name->is_missing(3) == false);
+  REQUIRE(arr_name->is_missing(4));
+  REQUIRE(arr_name->as_s(4, "x") == std::string("x"));
+  REQUIRE(arr_name->is_missing_all() == false);
+
+  REQUIRE(arr_occ->as_d(1) == 0.5);
+  REQUIRE(arr_occ->as_i(0) == 1);
+  REQUIRE(arr_occ->as_s(1) == std::string("0.5"));
+
+  // truncated buffer
+  pymol::cif_file cf2;
+  REQUIRE(!cf2.parse_bcif(w.buf.data(), w.buf.size() - 1));
+  REQUIRE(cf2.datablocks().empty());
+}
@@ -0,0 +1,88 @@
+#include "Test.h"
+
+#include "Map.h"
+#include "Vector.h"
+
+#include <random>
+#include <set>
+
+using namespace pymol;
+
+namespace
+{
+std::vector<float> randomPoints(int n, float lo, float hi, unsigned seed)
+{
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> dist(lo, hi);
+  std::vector<float> v(3 * n);
+  for (auto& x : v)
+    x = dist(gen);
+  return v;
+}
+} // namespace
+
+TEST_CASE("MapEIter matches the linked lists", "[Map]")
+{
+  PyMOLInstance pymol;
+  auto G = pymol.G();
+
+  auto v = randomPoints(2000, 0.f, 30.f, 1);
+  auto map = MapNew(G, 3.f, v.data(), 2000, nullptr);
+  REQUIRE(map);
+  REQUIRE(MapSetupExpress(map));
+
+  for (int q = 0; q < 2000; q += 7) {
+    const float* vq = v.data() + 3 * q;
+    int a, b, c;
+    MapLocus(map, vq, &a, &b, &c);
+
+    // reference: walk the Head/Link chains of the 27 cells
+    std::vector<int> expected;
+    for (int d = a - 1; d <= a + 1; ++d)
+      for (int e = b - 1; e <= b + 1; ++e)
+        for (int f = c - 1; f <= c + 1; ++f)
+          for (int i = *MapFirst(map, d, e, f); i >= 0; i = MapNext(map, i))
+            expected.push_back(i);
+
+    std::vector<int> found;
+    for (const auto j : MapEIter(*map, vq))
+      found.push_back(j);
+
+    REQUIRE(found == expected);
+  }
+
+  MapFree(map);
+}
+
+TEST_CASE("MapNeighborsWithin", "[Map]")
+{
+  PyMOLInstance pymol;
+  auto G = pymol.G();
+
+  const float cutoff = 2.5f;
+  auto v = randomPoints(3000, 0.f, 25.f, 2);
+  // stay inside the grid, outside query points have no neighbors
+  auto vq = randomPoints(1000, 2.f, 23.f, 3);
+  auto map = MapNew(G, cutoff, v.data(), 3000, nullptr);
+  REQUIRE(map);
+
+  MapNeighborList result;
+  MapNeighborsWithin(*map, v.data(), vq.data(), 1000, cutoff, result);
+  REQUIRE(result.size() == 1000);
+
+  for (int q = 0; q < 1000; ++q) {
+    const float* p = vq.data() + 3 * q;
+    std::set<int> expected;
+    for (int i = 0; i < 3000; ++i) {
+      if (within3f(v.data() + 3 * i, p, cutoff))
+        expected.insert(i);
+    }
+
+    std::set<int> found(result.begin(q), result.end(q));
+    REQUIRE(found.size() == std::size_t(result.end(q) - result.begin(q)));
+    REQUIRE(found == expected);
+    REQUIRE(MapAnyWithin(*map, v.data(), p, cutoff) == !expected.empty());
+  }
+
+  MapFree(map);
+}
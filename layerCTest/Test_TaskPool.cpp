@@ -0,0 +1,117 @@
+#include "Test.h"
+
+#include "TaskPool.h"
+
+#include <numeric>
+#include <thread>
+
+TEST_CASE("StealingRange hands out every item once", "[TaskPool]")
+{
+  for (unsigned n_workers : {1u, 3u, 8u}) {
+    pymol::StealingRange range(1000, n_workers);
+    std::vector<std::atomic<int>> seen(1000);
+    std::vector<std::thread> threads;
+    for (unsigned w = 0; w < n_workers; ++w) {
+      threads.emplace_back([&, w] {
+        std::uint32_t item;
+        while (range.next(w, item)) {
+          seen[item]++;
+          // slow worker, forces the others to steal
+          if (w == 0)
+            std::this_thread::yield();
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+    for (auto& count : seen) {
+      REQUIRE(count == 1);
+    }
+    REQUIRE(range.taken() == 1000);
+  }
+}
+
+TEST_CASE("TaskPool parallel_for", "[TaskPool]")
+{
+  pymol::TaskPool pool;
+  std::vector<int> data(12345, 0);
+  pool.parallel_for(data.size(), 7, 6,
+      [&](std::size_t begin, std::size_t end, unsigned) {
+        for (auto i = begin; i < end; ++i) {
+          data[i] += 1;
+        }
+      });
+  REQUIRE(std::accumulate(data.begin(), data.end(), 0) == 12345);
+  REQUIRE(pool.threads() == 5);
+}
+
+TEST_CASE("TaskPool nested groups", "[TaskPool]")
+{
+  pymol::TaskPool pool;
+  std::atomic<int> count{0};
+  pool.run(4, [&](unsigned) {
+    pymol::TaskGroup group;
+    for (int i = 0; i < 10; ++i) {
+      pool.submit(group, [&] { count++; });
+    }
+    pool.wait(group);
+  });
+  REQUIRE(count == 40);
+}
+
+TEST_CASE("TaskGraph respects dependencies", "[TaskPool]")
+{
+  pymol::TaskPool pool;
+  const auto caller = std::this_thread::get_id();
+
+  for (unsigned n_workers : {1u, 4u}) {
+    pymol::TaskGraph graph;
+    std::vector<std::atomic<int>> order(200);
+    std::atomic<int> clock{0};
+    std::atomic<int> main_thread_count{0};
+    std::vector<pymol::TaskGraph::Node> nodes;
+
+    for (int i = 0; i < 200; ++i) {
+      std::vector<pymol::TaskGraph::Node> deps;
+      // chains of 10 tasks, each chain starts after the previous one started
+      if (i % 10)
+        deps.push_back(nodes.back());
+      else if (i)
+        deps.push_back(nodes[i - 10]);
+      const bool main_thread = (i % 7 == 0);
+      nodes.push_back(graph.add(
+          [&, i, main_thread] {
+            if (main_thread && std::this_thread::get_id() == caller)
+              main_thread_count++;
+            order[i] = ++clock;
+          },
+          deps, main_thread));
+    }
+
+    graph.run(&pool, n_workers);
+
+    REQUIRE(clock == 200);
+    REQUIRE(main_thread_count == 29);
+    for (int i = 1; i < 200; ++i) {
+      REQUIRE(order[i] > order[i % 10 ? i - 1 : i - 10]);
+    }
+  }
+}
+
+TEST_CASE("TaskGraph runs independent tasks in parallel", "[TaskPool]")
+{
+  pymol::TaskPool pool;
+  pymol::TaskGraph graph;
+  std::atomic<int> count{0};
+  std::vector<pymol::TaskGraph::Node> builds;
+
+  for (int i = 0; i < 64; ++i) {
+    builds.push_back(graph.add([&] { count++; }));
+  }
+  graph.add([&] { REQUIRE(count == 64); }, builds, true);
+  graph.run(&pool, 4);
+
+  REQUIRE(count == 64);
+  REQUIRE(pool.threads() == 3);
+}
@@ -0,0 +1,65 @@
+#include "Test.h"
+
+#include "pymol/cow_vector.h"
+
+using namespace pymol::test;
+
+TEST_CASE("cow_vector empty", "[cow_vector]")
+{
+  pymol::cow_vector<int> v1;
+  REQUIRE(v1.empty());
+  REQUIRE(v1.size() == 0);
+  REQUIRE(v1.begin() == v1.end());
+
+  pymol::cow_vector<int> v2(v1);
+  REQUIRE(v2.empty());
+  REQUIRE(v1 == v2);
+
+  v2.resize(3, -1);
+  REQUIRE(v1.empty());
+  REQUIRE(v2.size() == 3);
+  REQUIRE(v2[2] == -1);
+}
+
+TEST_CASE("cow_vector copy shares", "[cow_vector]")
+{
+  pymol::cow_vector<int> v1(std::vector<int>{1, 2, 3});
+  auto v2 = v1;
+  REQUIRE(v2.shares(v1));
+  REQUIRE(v2.data() == v1.data());
+  REQUIRE(v2[1] == 2);
+}
+
+TEST_CASE("cow_vector write detaches", "[cow_vector]")
+{
+  pymol::cow_vector<int> v1(std::vector<int>{1, 2, 3});
+  auto v2 = v1;
+
+  v2.mut()[1] = 5;
+  REQUIRE(!v2.shares(v1));
+  REQUIRE(v1[1] == 2);
+  REQUIRE(v2[1] == 5);
+  REQUIRE(v1 != v2);
+
+  // unshared, no copy
+  auto data = v2.data();
+  v2.mut()[0] = 7;
+  REQUIRE(v2.data() == data);
+}
+
+TEST_CASE("cow_vector equal without sharing", "[cow_vector]")
+{
+  pymol::cow_vector<int> v1(std::vector<int>{1, 2, 3});
+  pymol::cow_vector<int> v2(std::vector<int>{1, 2, 3});
+  REQUIRE(!v2.shares(v1));
+  REQUIRE(v1 == v2);
+
+  // same size resize doesn't detach
+  auto v3 = v1;
+  v3.resize(3);
+  REQUIRE(v3.shares(v1));
+
+  v3.clear();
+  REQUIRE(v3.empty());
+  REQUIRE(v1.size() == 3);
+}
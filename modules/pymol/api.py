@@ -25,6 +25,7 @@ from .importing import \
       read_pdbstr,        \
       read_xplorstr,      \
       fetch,              \
+      get_psc_names,      \
       set_session,        \
       space
 
@@ -114,6 +115,7 @@ from .querying import \
       get_object_settings,\
       get_object_state,   \
       get_color_tuple,    \
+      get_atom_columns,   \
       get_atom_coords,    \
       get_coords,         \
       get_coordset,       \
@@ -133,6 +135,7 @@ from .querying import \
       get_unused_name,    \
       get_object_matrix,  \
       get_object_ttt,     \
+      get_selection_cache_stats, \
       get_mtl_obj,        \
       get_phipsi,         \
       get_position,       \
@@ -231,6 +234,7 @@ from .editing import \
       sculpt_deactivate,  \
       sculpt_activate,    \
       sculpt_iterate,     \
+      set_atom_columns,   \
       set_dihedral,       \
       set_name,           \
       set_geometry,       \
@@ -59,6 +59,8 @@ class _loadable:
     dxstr = 75    # DX file (APBS)
     mapstr = 76   # unspecified CCP4 or MRC map
     mrcstr = 77
+    bcif = 78     # BinaryCIF
+    bcifstr = 79
 
 class loadable(_loadable):
     @classmethod
@@ -71,6 +73,7 @@ class loadable(_loadable):
 _load2str = { loadable.pdb : loadable.pdbstr,
               loadable.vdb: loadable.vdbstr,
               loadable.cif : loadable.cifstr,
+              loadable.bcif : loadable.bcifstr,
               loadable.mmtf : loadable.mmtfstr,
               loadable.mae : loadable.maestr,
               loadable.mol : loadable.molstr,
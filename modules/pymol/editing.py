@@ -1607,6 +1607,42 @@ SEE ALSO
                                     int(state) - 1, selection, expression,
                                     True, int(quiet), dict(space))
 
+    def set_atom_columns(selection, columns, quiet=1, *, _self=cmd):
+        '''
+DESCRIPTION
+
+    API only. Set numeric atom properties from arrays, one value per
+    selected atom. Equivalent to "alter" with a per-atom assignment, but
+    without creating Python objects per atom.
+
+ARGUMENTS
+
+    selection = str: atom selection
+
+    columns = dict: property name (as in "alter") -> 1d array with one
+    value per atom, in the order returned by get_atom_columns
+
+EXAMPLE
+
+    cols = cmd.get_atom_columns('all', 'b q')
+    cmd.set_atom_columns('all', {'b': cols['b'] * 2, 'q': cols['q']})
+
+SEE ALSO
+
+    get_atom_columns, alter, load_coords
+        '''
+        names = list(columns)
+        selection = selector.process(selection)
+
+        with _self.lockcm:
+            r = _cmd.set_atom_columns(_self._COb, selection, names,
+                                      [columns[name] for name in names])
+
+        if not int(quiet):
+            print(" Set_atom_columns: modified %d atoms." % r)
+
+        return r
+
     def translate(vector=[0.0,0.0,0.0], selection="all", state=-1,
                   camera=1, object=None, object_mode=0, _self=cmd):
 
@@ -369,7 +369,7 @@ NOTES
 
     def get_session(names='', partial=0, quiet=1, compress=-1, cache=-1,
                     binary=-1, version=-1,
-                    *, _self=cmd):
+                    *, sink=None, _self=cmd):
         '''
         :param names: Names of objects to export, or the empty string to export all objects.
         :param partial: If true, do not store selections, settings, view, movie.
@@ -378,6 +378,8 @@ NOTES
         :param cache: ?
         :param binary: Use efficient binary format {default: pse_binary_dump}
         :param version: {default: pse_export_version}
+        :param sink: Callable which receives the named entries (objects and
+        selections) one at a time, instead of collecting them in "names"
         '''
         session = {}
         cache = int(cache)
@@ -422,7 +424,7 @@ NOTES
 
         with _self.lockcm:
             _cmd.get_session(_self._COb, session, str(names), int(partial),
-                             int(quiet), binary, pse_export_version)
+                             int(quiet), binary, pse_export_version, sink)
 
         if True:
                 try:
@@ -842,7 +844,7 @@ SEE ALSO
             format = format_guessed
 
         # PyMOL session
-        if format in ('pse', 'psw',):
+        if format in ('pse', 'psw', 'psc',):
             _self.set("session_file",
                     # always use unix-like path separators
                     filename.replace("\\", "/"), quiet=1)
@@ -997,6 +999,7 @@ SEE ALSO
 
         'pse': get_psestr,
         'psw': get_psestr,
+        'psc': 'pymol.psc:save_psc',
 
         'fasta': get_fastastr,
         'aln': get_alnstr,
@@ -652,7 +652,9 @@ ARGUMENTS
 
     filename = string: file path or URL
 
-    object = string: name of the object {default: filename prefix}
+    object = string: name of the object {default: filename prefix}. For
+    chunked sessions (.psc): space separated patterns of the objects to
+    restore {default: all objects}
 
     state = integer: number of the state into which
     the content should be loaded, or 0 for append {default:0}
@@ -746,6 +748,7 @@ SEE ALSO
 
             # object name
             object = str(object).strip()
+            names = object
             if not object:
                 object = noext if noext else _self.get_unused_name('obj')
                 if format in ['dcd', 'dtr']:
@@ -790,6 +793,7 @@ SEE ALSO
                 'mimic': mimic,
                 'object_props': object_props,
                 'atom_props': atom_props,
+                'names': names, # as given, for selective session restore
                 '_self': _self,
 
                 # for _load
@@ -828,7 +832,27 @@ SEE ALSO
             raise pymol.CmdException('PSE contains objects which cannot be unpickled (%s)' % str(e))
 
         r = _self.set_session(session, quiet=quiet, partial=partial, steal=1)
+        _session_loaded(filename, partial, format, _self)
+        return r
+
+    def get_psc_names(filename, *, _self=cmd):
+        '''
+DESCRIPTION
+
+    API only. Names of the objects in a chunked session file (.psc),
+    read from its index without loading the file.
+
+SEE ALSO
 
+    load
+        '''
+        from pymol import psc
+        return psc.get_psc_names(filename, _self=_self)
+
+    def _session_loaded(filename, partial, format, _self):
+        '''
+        Common steps after restoring a session file (pse, psw, psc)
+        '''
         if not partial:
             _self.set("session_file",
                     # always use unix-like path separators
@@ -845,8 +869,6 @@ SEE ALSO
             # go to first scene
             _self.scene("auto", "start", animate=0)
 
-        return r
-
     def load_embedded(key=None, name=None, state=0, finish=1, discrete=1,
                       quiet=1, zoom=-1, multiplex=-2, object_props=None,
                       atom_props=None, *, _self=cmd):
@@ -1121,6 +1143,7 @@ PYMOL API
 
     hostPaths = {
         "mmtf" : "https://mmtf.rcsb.org/v1.0/full/{code}.mmtf.gz",
+        "bcif" : "https://models.rcsb.org/{code}.bcif",
         "bio"  : [
             "https://files.rcsb.org/download/{code}.{type}.gz",
             "/data/biounit/coordinates/divided/{mid}/{code}.{type}.gz",
@@ -1182,7 +1205,7 @@ PYMOL API
             nameFmt = '{type}_{code}.sdf'
         elif type == 'cif':
             pass
-        elif type == 'mmtf':
+        elif type in ('mmtf', 'bcif'):
             pass
         elif type == 'cc':
             nameFmt = '{code}.cif'
@@ -1254,8 +1277,8 @@ PYMOL API
         elif contents and bioType in ('cif', 'cc'):
             r = _self.load_raw(contents, 'cif', name, state,
                     finish, discrete, quiet, multiplex, zoom)
-        elif contents and bioType in ('mmtf',):
-            r = _self.load_raw(contents, 'mmtf', name, state,
+        elif contents and bioType in ('mmtf', 'bcif'):
+            r = _self.load_raw(contents, bioType, name, state,
                     finish, discrete, quiet, multiplex, zoom)
 
         if not _self.is_error(r):
@@ -1300,7 +1323,7 @@ PYMOL API
                     obj_name = 'emd_' + obj_code
 
             chain = None
-            if (len(obj_code) > 4 and type in ('pdb', 'cif', 'mmtf') and
+            if (len(obj_code) > 4 and type in ('pdb', 'cif', 'bcif', 'mmtf') and
                     # "Extended PDB accession codes" have 8 characters,
                     # try to distinguish by leading non-zero digit
                     '1' <= obj_code[0] <= '9'):
@@ -1344,7 +1367,7 @@ ARGUMENTS
 
     state = the state number into which the file should loaded.
 
-    type = str: cif, pdb, pdb1, 2fofc, fofc, emd, cid, sid {default: cif
+    type = str: cif, bcif, pdb, pdb1, 2fofc, fofc, emd, cid, sid {default: cif
     (default was "pdb" up to 1.7.6)}
 
     async_ = 0/1: download in the background and do not block the PyMOL
@@ -1623,6 +1646,7 @@ DESCRIPTION
         'idx': load_idx,
         'pse': load_pse,
         'psw': load_pse,
+        'psc': 'pymol.psc:load_psc',
         'ply': load_ply,
         'r3d': load_r3d,
         'cc1': load_cc1,
@@ -2,7 +2,6 @@ import os
 import sys
 cmd = sys.modules["pymol.cmd"]
 from pymol import _cmd
-import threading
 import traceback
 
 import _thread as thread
@@ -126,111 +125,6 @@ def _cache_set(new_entry, max_size, _self=cmd):
             traceback.print_exc()
     return r
 
-# ray tracing threads
-
-def _ray_anti_spawn(thread_info,_self=cmd):
-    # WARNING: internal routine, subject to change
-    # internal routine to support multithreaded raytracing
-    thread_list = []
-    for a in thread_info[1:]:
-        t = threading.Thread(target=_cmd.ray_anti_thread,
-                                    args=(_self._COb,a))
-        t.setDaemon(1)
-        thread_list.append(t)
-    for t in thread_list:
-        t.start()
-    _cmd.ray_anti_thread(_self._COb,thread_info[0])
-    for t in thread_list:
-        t.join()
-
-def _ray_hash_spawn(thread_info,_self=cmd):
-    # WARNING: internal routine, subject to change
-    # internal routine to support multithreaded raytracing
-    thread_list = []
-    for a in thread_info[1:]:
-        if a is not None:
-            t = threading.Thread(target=_cmd.ray_hash_thread,
-                                 args=(_self._COb,a))
-            t.setDaemon(1)
-            thread_list.append(t)
-    for t in thread_list:
-        t.start()
-    if thread_info[0] is not None:
-        _cmd.ray_hash_thread(_self._COb,thread_info[0])
-    for t in thread_list:
-        t.join()
-
-def _ray_spawn(thread_info,_self=cmd):
-    # WARNING: internal routine, subject to change
-    # internal routine to support multithreaded raytracing
-    thread_list = []
-    for a in thread_info[1:]:
-        t = threading.Thread(target=_cmd.ray_trace_thread,
-                                    args=(_self._COb,a))
-        t.setDaemon(1)
-        thread_list.append(t)
-    for t in thread_list:
-        t.start()
-    _cmd.ray_trace_thread(_self._COb,thread_info[0])
-    for t in thread_list:
-        t.join()
-
-def _coordset_update_thread(list_lock,thread_info,_self=cmd):
-    # WARNING: internal routine, subject to change
-    while 1:
-        list_lock.acquire()
-        if not len(thread_info):
-            list_lock.release()
-            break
-        else:
-            info = thread_info.pop(0)
-            list_lock.release()
-        _cmd.coordset_update_thread(_self._COb,info)
-
-def _coordset_update_spawn(thread_info,n_thread,_self=cmd):
-    # WARNING: internal routine, subject to change
-    if len(thread_info):
-        list_lock = threading.Lock() # mutex for list
-        thread_list = []
-        for a in range(1,n_thread):
-            t = threading.Thread(target=_coordset_update_thread,
-                                        args=(list_lock,thread_info))
-            t.setDaemon(1)
-            thread_list.append(t)
-        for t in thread_list:
-            t.start()
-        _coordset_update_thread(list_lock,thread_info)
-        for t in thread_list:
-            t.join()
-
-def _object_update_thread(list_lock,thread_info,_self=cmd):
-    # WARNING: internal routine, subject to change
-    while 1:
-        list_lock.acquire()
-        if not len(thread_info):
-            list_lock.release()
-            break
-        else:
-            info = thread_info.pop(0)
-            list_lock.release()
-        _cmd.object_update_thread(_self._COb,info)
-
-def _object_update_spawn(thread_info,n_thread,_self=cmd):
-    # WARNING: internal routine, subject to change
-    if len(thread_info):
-        list_lock = threading.Lock() # mutex for list
-        thread_list = []
-        for a in range(1,n_thread):
-            t = threading.Thread(target=_object_update_thread,
-                                        args=(list_lock,thread_info))
-            t.setDaemon(1)
-            thread_list.append(t)
-        for t in thread_list:
-            t.start()
-        _object_update_thread(list_lock,thread_info)
-        for t in thread_list:
-            t.join()
-
 # status reporting
 
 # do command (while API already locked)
@@ -307,6 +201,23 @@ def file_read(finfo, _self=cmd):
 
     return contents
 
+# formats which the native loader memory maps when given a file name
+_load_by_name = (loadable.ccp4, loadable.map, loadable.mrc)
+
+def _is_plain_file(finfo):
+    '''
+    True if finfo is the name of a local and uncompressed file.
+    '''
+    if not is_string(finfo) or '://' in finfo:
+        return False
+    try:
+        with open(finfo, 'rb') as handle:
+            magic = handle.read(10)
+    except IOError:
+        return False
+    return not (magic[:2] == b'\x1f\x8b' or
+                (magic[:2] == b'BZ' and magic[4:10] == b'1AY&SY'))
+
 def download_chem_comp(resn, quiet=1, _self=cmd):
     '''
     WARNING: internal routine, subject to change
@@ -355,7 +266,9 @@ def _load(oname,finfo,state,ftype,finish,discrete,
     size = 0
     if ftype not in (loadable.model,loadable.brick):
         if True:
-            if ftype in _load2str:
+            if ftype in _load_by_name and _is_plain_file(finfo):
+                pass # read by the native loader
+            elif ftype in _load2str:
                 contents = _self.file_read(finfo)
                 ftype = _load2str[ftype]
         return _cmd.load(_self._COb, str(oname), str(finfo), contents,
@@ -109,6 +109,7 @@ def get_command_keywords(self_cmd=cmd):
         'get_sasa_relative' : [ self_cmd.get_sasa_relative , 0 , 0 , ''  , parsing.STRICT ],
         'get_symmetry'  : [ self_cmd.get_symmetry      , 0 , 0 , ''  , parsing.STRICT ],
         'get_renderer'  : [ self_cmd.get_renderer      , 0 , 0 , ''  , parsing.STRICT ],
+        'get_selection_cache_stats' : [ self_cmd.get_selection_cache_stats , 0 , 0 , ''  , parsing.STRICT ],
         'get_title'     : [ self_cmd.get_title         , 0 , 0 , ''  , parsing.STRICT ],
         'get_type'      : [ self_cmd.get_type          , 0 , 0 , ''  , parsing.STRICT ],
         'get_version'   : [ self_cmd.get_version       , 0 , 0 , ''  , parsing.STRICT ],
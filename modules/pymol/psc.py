@@ -0,0 +1,330 @@
+'''
+Chunked session files (.psc)
+
+A session which is split into independently compressed sections:
+
+    - one section with the session-wide state (settings, colors, view,
+      movie, scenes, ...)
+    - one section per named entry (object or selection)
+    - one section per binary array of an entry (atoms, bonds, coordinates
+      and map fields, see "pse_binary_dump")
+
+Sections are compressed and decompressed on several threads. Entries are
+written while the session is serialized and restored one at a time, so the
+session is never held in memory as a whole. An index at the end of the file
+lists all sections and entries, which allows to restore a subset of the
+objects without decoding the others ("load file.psc, name-patterns").
+Uncompressed arrays are passed to the restore as memoryviews of a memory
+map of the file.
+
+File layout:
+
+    magic           8 bytes     b'PyMOLPSC'
+    index offset    uint64 (little endian)
+    sections        ...
+    index           zlib compressed pickle
+
+Copyright (c) Schrodinger, LLC.
+'''
+
+import collections
+import fnmatch
+import mmap
+import os
+import pickle
+import struct
+import zlib
+from concurrent.futures import Future, ThreadPoolExecutor
+
+from pymol import cmd, CmdException
+from pymol.constants import DEFAULT_SUCCESS
+
+MAGIC = b'PyMOLPSC'
+FORMAT_VERSION = 1
+
+_header = struct.Struct('<8sQ')
+
+# cExecObject in layer3/Executive.h
+_EXEC_OBJECT = 0
+
+
+def _max_threads(_self):
+    return max(1, _self.get_setting_int('max_threads'))
+
+
+def _encode(data, level):
+    if level > 0:
+        packed = zlib.compress(data, level)
+        if len(packed) < len(data):
+            return packed, True
+    return data, False
+
+
+class _SectionWriter:
+    '''
+    Appends sections to a file. Compression runs on a thread pool (zlib
+    releases the GIL), sections are written in the order they were added.
+    '''
+
+    def __init__(self, handle, level, n_threads):
+        self.handle = handle
+        self.level = level
+        self.sections = []
+        self.pending = collections.deque()
+        self.executor = ThreadPoolExecutor(n_threads) if n_threads > 1 else None
+        # bounds the memory held by compressed but unwritten sections
+        self.window = n_threads * 2
+
+        handle.write(_header.pack(MAGIC, 0))
+
+    def add(self, data):
+        '''
+        Queue a section for writing and return its index
+        '''
+        if self.executor is not None:
+            future = self.executor.submit(_encode, data, self.level)
+        else:
+            future = Future()
+            future.set_result(_encode(data, self.level))
+
+        self.pending.append((len(data), future))
+
+        while len(self.pending) > self.window:
+            self._write_next()
+
+        return len(self.sections) + len(self.pending) - 1
+
+    def _write_next(self):
+        raw_size, future = self.pending.popleft()
+        data, compressed = future.result()
+        self.sections.append((self.handle.tell(), len(data), raw_size,
+            compressed))
+        self.handle.write(data)
+
+    def finish(self, index):
+        while self.pending:
+            self._write_next()
+
+        if self.executor is not None:
+            self.executor.shutdown()
+
+        index['sections'] = self.sections
+        offset = self.handle.tell()
+        self.handle.write(zlib.compress(pickle.dumps(index, protocol=5)))
+        self.handle.seek(0)
+        self.handle.write(_header.pack(MAGIC, offset))
+
+
+class _SectionReader:
+    '''
+    Random access to the sections of a chunked session file. Local files
+    are memory mapped, everything else (URLs, compressed files) goes
+    through cmd.file_read.
+    '''
+
+    def __init__(self, filename, _self):
+        self.handle = None
+
+        if os.path.isfile(filename):
+            self.handle = open(filename, 'rb')
+            self.buffer = mmap.mmap(self.handle.fileno(), 0,
+                    access=mmap.ACCESS_READ)
+        else:
+            self.buffer = _self.file_read(filename)
+
+        if len(self.buffer) < _header.size:
+            self.close()
+            raise CmdException('not a chunked session file: ' + filename)
+
+        magic, offset = _header.unpack_from(self.buffer)
+
+        if magic != MAGIC:
+            self.close()
+            raise CmdException('not a chunked session file: ' + filename)
+
+        with memoryview(self.buffer) as view, view[offset:] as data:
+            self.index = pickle.loads(zlib.decompress(data))
+
+        if self.index['version'] > FORMAT_VERSION:
+            self.close()
+            raise CmdException('chunked session file version %d not '
+                    'supported' % self.index['version'])
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *args):
+        self.close()
+
+    def close(self):
+        if self.handle is not None:
+            self.buffer.close()
+            self.handle.close()
+            self.handle = None
+
+    def section(self, i):
+        '''
+        Contents of section `i` as bytes, or as a memoryview of the file if
+        the section is not compressed. Views must be released before close.
+        '''
+        offset, size, raw_size, compressed = self.index['sections'][i]
+
+        with memoryview(self.buffer) as view:
+            data = view[offset:offset + size]
+
+        if not compressed:
+            return data
+
+        with data:
+            return zlib.decompress(data, bufsize=raw_size)
+
+    def entries(self, entries, n_threads):
+        '''
+        Generator which decodes `entries` one at a time. Sections of the
+        next entries are decompressed ahead on up to `n_threads` threads.
+        '''
+        entries = iter(entries)
+        pending = collections.deque()
+
+        with ThreadPoolExecutor(n_threads) as executor:
+            def submit():
+                entry = next(entries, None)
+                if entry is not None:
+                    pending.append([executor.submit(self.section, i)
+                        for i in [entry['section']] + entry['arrays']])
+
+            for _ in range(n_threads):
+                submit()
+
+            while pending:
+                futures = pending.popleft()
+                submit()
+                data, *arrays = [f.result() for f in futures]
+                del futures
+                entry = pickle.loads(data, buffers=arrays)
+                del data, arrays
+                yield entry
+                del entry
+
+
+def _out_of_band(obj):
+    '''
+    Wrap large bytes objects (binary dump arrays) for out-of-band pickling
+    '''
+    if isinstance(obj, bytes):
+        return pickle.PickleBuffer(obj) if len(obj) >= 4096 else obj
+    if isinstance(obj, list):
+        return [_out_of_band(v) for v in obj]
+    return obj
+
+
+def save_psc(filename, selection='', partial=0, quiet=1, _self=cmd):
+    '''
+DESCRIPTION
+
+    Save the session to a chunked session file. Always uses the binary
+    array format of "pse_binary_dump". Sections are compressed with
+    "psc_compression" on up to "max_threads" threads.
+
+    Use "save file.psc" instead of calling this function directly.
+    '''
+    if '(' in selection: # ignore selections
+        selection = ''
+
+    level = _self.get_setting_int('psc_compression')
+    entries = []
+
+    with open(filename, 'wb') as handle:
+        writer = _SectionWriter(handle, level, _max_threads(_self))
+
+        def add_entry(entry):
+            arrays = []
+            data = pickle.dumps(_out_of_band(entry), protocol=5,
+                    buffer_callback=arrays.append)
+
+            entries.append({
+                'name': entry[0],
+                'type': entry[1],
+                'section': writer.add(data),
+                'arrays': [writer.add(a.raw()) for a in arrays],
+            })
+
+        # entries are written as they are serialized, "names" stays empty.
+        # No backwards compatibility conversions, this format is new.
+        session = _self.get_session(selection, partial, quiet, compress=0,
+                binary=1, version=0, sink=add_entry)
+        del session['names']
+
+        writer.finish({
+            'version': FORMAT_VERSION,
+            'main': writer.add(pickle.dumps(session, protocol=5)),
+            'entries': entries,
+        })
+
+    if not int(quiet):
+        print(' Save: wrote %d entries to "%s".' % (len(entries), filename))
+
+    return DEFAULT_SUCCESS
+
+
+def get_psc_names(filename, _self=cmd):
+    '''
+DESCRIPTION
+
+    Names of the objects in a chunked session file, without loading it.
+    Available as cmd.get_psc_names.
+    '''
+    with _SectionReader(filename, _self) as reader:
+        return [e['name'] for e in reader.index['entries']
+                if e['type'] == _EXEC_OBJECT]
+
+
+def load_psc(filename, partial=0, quiet=1, names='', format='psc', _self=cmd):
+    '''
+DESCRIPTION
+
+    Load a chunked session file.
+
+ARGUMENTS
+
+    filename = str: file path or URL
+
+    partial = 0/1: if 1, merge the objects into the current session
+    instead of replacing it {default: 0}
+
+    names = str: space separated object name patterns. If not empty, only
+    restore the matching objects (other sections of the file are not
+    read) {default: all objects}
+
+    Use "load file.psc [, names]" instead of calling this function
+    directly.
+    '''
+    from pymol.importing import _session_loaded
+
+    patterns = names.split()
+
+    def wanted(entry):
+        if entry['type'] != _EXEC_OBJECT or not patterns:
+            return True
+        return any(fnmatch.fnmatchcase(entry['name'], p) for p in patterns)
+
+    with _SectionReader(filename, _self) as reader:
+        data = reader.section(reader.index['main'])
+        session = pickle.loads(data)
+        del data
+
+        entries = [e for e in reader.index['entries'] if wanted(e)]
+        n_threads = max(1, min(_max_threads(_self), len(entries)))
+
+        # restored one entry at a time, while the next ones are decoded
+        session['names'] = named = reader.entries(entries, n_threads)
+
+        try:
+            r = _self.set_session(session, quiet=quiet, partial=partial,
+                    steal=1)
+        finally:
+            named.close()
+            del session['names'], named
+
+    _session_loaded(filename, int(partial), format, _self)
+    return r
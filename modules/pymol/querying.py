@@ -870,6 +870,33 @@ DESCRIPTION
 
         return r
 
+    def get_selection_cache_stats(quiet=1, *, _self=cmd):
+        '''
+DESCRIPTION
+
+    "get_selection_cache_stats" returns the number of hits and misses of
+    the selection result cache and the number of cached results.
+
+USAGE
+
+    get_selection_cache_stats
+
+PYMOL API
+
+    cmd.get_selection_cache_stats(quiet=1)
+
+SEE ALSO
+
+    selection_cache_size setting
+        '''
+        with _self.lockcm:
+            r = _cmd.get_selection_cache_stats(_self._COb)
+
+        if not int(quiet):
+            print(" Selection cache: %d hits, %d misses, %d entries" % r)
+
+        return r
+
     def get_phipsi(selection="(name CA)", state=CURRENT_STATE, *, _self=cmd):
         # preprocess selections
         selection = selector.process(selection)
@@ -933,6 +960,42 @@ ARGUMENTS
             return r
 
 
+    def get_atom_columns(selection='all', properties='b q', *, _self=cmd):
+        '''
+DESCRIPTION
+
+    API only. Get numeric atom properties as numpy arrays, without
+    creating Python objects per atom.
+
+ARGUMENTS
+
+    selection = str: atom selection {default: all}
+
+    properties = str or list: property names as in "iterate", e.g.
+    b, q, vdw, partial_charge, formal_charge, resv, color, reps, flags
+    {default: b q}
+
+RETURNS
+
+    dict of property name -> 1d numpy array with one value per selected
+    atom, in the same order as get_coords
+
+SEE ALSO
+
+    set_atom_columns, iterate, get_coords
+        '''
+        if isinstance(properties, str):
+            properties = properties.replace(',', ' ').split()
+        else:
+            properties = list(properties)
+
+        selection = selector.process(selection)
+
+        with _self.lockcm:
+            r = _cmd.get_atom_columns(_self._COb, selection, properties)
+
+        return dict(zip(properties, r))
+
     def get_position(quiet=1, *, _self=cmd):
         '''
 DESCRIPTION
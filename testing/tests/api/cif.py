@@ -1,4 +1,4 @@
-from pymol import cmd, testing, stored
+from pymol import cmd, testing, stored, test_utils
 
 @testing.requires_version('1.7.1')
 class TestCIF(testing.PyMOLTestCase):
@@ -59,3 +59,44 @@ class TestCIF(testing.PyMOLTestCase):
         cmd.load(self.datafile('4m4b-minimal-w-assembly.cif'))
         self.assertEqual(cmd.count_states(), 2)
         self.assertEqual(cmd.get_chains(), ['B'])
+
+    def test_threads_same_as_serial(self):
+        # large files are tokenized and converted in parallel chunks
+        cmd.load(self.datafile('1aon.pdb.gz'), 'm1')
+
+        models = []
+        with testing.mktemp('.cif') as filename:
+            cmd.save(filename, 'm1')
+            cmd.delete('*')
+
+            for n_threads in (1, 4):
+                cmd.set('max_threads', n_threads)
+                cmd.load(filename, 'm1')
+                models.append((
+                    cmd.get_coords('m1'),
+                    cmd.get_fastastr('m1'),
+                    [(a.chain, a.resi, a.name, a.b, a.q)
+                     for a in cmd.get_model('m1').atom],
+                ))
+                cmd.delete('m1')
+
+        self.assertArrayEqual(models[0][0], models[1][0], delta=1e-4)
+        self.assertEqual(models[0][1:], models[1][1:])
+
+    def test_bcif_same_atoms(self):
+        cmd.load(self.datafile('1oky.pdb.gz'), 'm1')
+
+        with testing.mktemp('.bcif') as filename:
+            test_utils.save_bcif(cmd, filename, 'm1')
+            cmd.load(filename, 'm2')
+
+        self.assertEqual(cmd.count_atoms('m1'), cmd.count_atoms('m2'))
+        self.assertArrayEqual(cmd.get_coords('m1'), cmd.get_coords('m2'),
+                delta=1e-3)
+
+        atoms = [cmd.get_model(name).atom for name in ('m1', 'm2')]
+        self.assertEqual(
+            [(a.chain, a.segi, a.resn, a.resi_number, a.name, a.symbol, a.id,
+              a.hetatm, round(a.b, 2), round(a.q, 2)) for a in atoms[0]],
+            [(a.chain, a.segi, a.resn, a.resi_number, a.name, a.symbol, a.id,
+              a.hetatm, round(a.b, 2), round(a.q, 2)) for a in atoms[1]])
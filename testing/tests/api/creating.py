@@ -201,6 +201,48 @@ class TestCreating(testing.PyMOLTestCase):
         cmd.isolevel('dot', 10)
         self.assertImageHasNotColor(meshcolor)
 
+    def testIsolevelDataChanges(self):
+        # contouring skips bricks by their min/max index, which must follow
+        # changes of the map data
+        cmd.load(self.datafile('emd_1155.ccp4'), 'map1')
+        cmd.isomesh('mesh1', 'map1', 3.0)
+        geometry = cmd.get_povray()
+
+        # writes through a no-copy view may happen after any later contour
+        field = cmd.get_volume_field('map1', copy=0)
+        saved = field.copy()
+        cmd.isomesh('mesh1', 'map1', 3.0)
+        self.assertEqual(cmd.get_povray(), geometry)
+
+        # no contour left with all values below the level
+        field[:] = 0.0
+        cmd.isomesh('mesh1', 'map1', 3.0)
+        self.assertEqual(cmd.count_states('mesh1'), 1)
+        self.assertNotEqual(cmd.get_povray(), geometry)
+
+        field[:] = saved
+        cmd.isomesh('mesh1', 'map1', 3.0)
+        self.assertEqual(cmd.get_povray(), geometry)
+
+        # doubled map has a new index
+        cmd.map_double('map1')
+        cmd.isomesh('mesh2', 'map1', 3.0)
+        self.assertNotEqual(cmd.get_povray(), geometry)
+
+    @testing.foreach('isomesh', 'isodot')
+    def testIsomeshThreads(self, command):
+        cmd.load(self.datafile('emd_1155.ccp4'), 'map1')
+
+        # tiles are merged in order, so the result must not depend on
+        # the number of threads
+        geometry = []
+        for n_threads in (1, 4):
+            cmd.set('max_threads', n_threads)
+            getattr(cmd, command)('mesh1', 'map1', 3.0)
+            geometry.append(cmd.get_povray())
+
+        self.assertEqual(geometry[0], geometry[1])
+
     def testGradient(self):
         cmd.viewport(100,100)
 
@@ -157,6 +157,57 @@ class TestEditing(testing.PyMOLTestCase):
         with self.assertRaises(IndexError):
             cmd.iterate('all', 'name[100]')
 
+    def test_alter_native(self):
+        # simple expressions are evaluated without Python, results must
+        # not change
+        cmd.load(self.datafile('1oky.pdb.gz'), 'm1')
+        cmd.create('m2', 'm1')
+        space = {'k': 2, 'ca': 'CA'}
+
+        # native expression vs. equivalent one which needs the space dict
+        for native, python in [
+            ('b = b * 2 + q', 'b = b * k + q'),
+            ('resv += 2', 'resv += k'),
+            ('formal_charge = -1 if name == "CA" else 0',
+             'formal_charge = -1 if name == ca else 0'),
+            ('q = 1 if 10 < resv <= 20 or not b else q / 2',
+             'q = 1 if 10 < resv <= 20 or not b else q / k'),
+        ]:
+            cmd.alter('m1', native)
+            cmd.alter('m2', python, space=space)
+
+        cmd.alter_state(1, 'm1', 'x = x + 1.5; y *= -2')
+        cmd.alter_state(1, 'm2', 'x = x + 1.5; y *= -k', space=space)
+
+        props = 'stored.append((b, q, resv, formal_charge))'
+        values = []
+        for obj in ('m1', 'm2'):
+            space['stored'] = []
+            cmd.iterate(obj, props, space=space)
+            values.append(space['stored'])
+        self.assertEqual(values[0], values[1])
+        self.assertArrayEqual(cmd.get_coords('m1'), cmd.get_coords('m2'))
+
+        # errors still come from Python
+        self.assertRaises(Exception, cmd.alter, 'm1', 'resv = b')
+        self.assertRaises(Exception, cmd.alter, 'm1', 'b = b / 0')
+        self.assertRaises(Exception, cmd.alter, 'm1', 'x = 1.0')
+
+        # integers are not truncated, out of range values raise
+        resv = []
+        cmd.iterate('m2', 'resv_list.append(resv)', space={'resv_list': resv})
+        self.assertRaises(Exception, cmd.alter, 'm1', 'resv = 1099511627776')
+        self.assertRaises(Exception, cmd.alter, 'm1', 'formal_charge = 200')
+        self.assertRaises(Exception, cmd.alter, 'm2', 'resv = 1 << 40')
+        self.assertRaises(Exception, cmd.alter, 'm1',
+                          'resv = resv * 4611686018427387904')
+
+        # 64 bit overflow in between, exact in Python
+        cmd.alter('m2', 'resv = resv * 9223372036854775807 * 0 + resv')
+        space['stored'] = []
+        cmd.iterate('m2', 'stored.append(resv)', space=space)
+        self.assertEqual(space['stored'], resv)
+
     def test_attach(self):
         cmd.pseudoatom()
         cmd.edit('first all')
@@ -603,8 +654,34 @@ class TestEditing(testing.PyMOLTestCase):
         self.skipTest("TODO")
 
     def test_sculpt_iterate(self):
-        cmd.sculpt_iterate
-        self.skipTest("TODO")
+        # terms are evaluated in parallel chunks and summed in a fixed
+        # order, so the result must not depend on the number of threads
+        coords = []
+        for n_threads in (1, 4, 4):
+            cmd.delete('*')
+            cmd.set('max_threads', n_threads)
+            cmd.load(self.datafile('1oky.pdb.gz'), 'm1')
+            cmd.remove('solvent')
+            cmd.sculpt_activate('m1')
+            cmd.sculpt_iterate('m1', cycles=20)
+            coords.append(cmd.get_coords('m1'))
+
+        self.assertArrayEqual(coords[0], coords[1])
+        self.assertArrayEqual(coords[0], coords[2])
+
+    def test_sculpt_iterate_reference(self):
+        # 1oky-frag-sculpt.pdb was written by the serial nonbonded hash
+        # walk, the parallel one must visit the same pairs. Large radii
+        # give cutoffs beyond the hash cell size.
+        cmd.set('max_threads', 4)
+        cmd.load(self.datafile('1oky-frag.pdb'), 'm1')
+        cmd.load(self.datafile('1oky-frag-sculpt.pdb'), 'ref')
+        cmd.remove('solvent')
+        cmd.alter('m1', 'vdw = 2.5')
+        cmd.set('sculpt_field_mask', 0xFFF)
+        cmd.sculpt_activate('m1')
+        cmd.sculpt_iterate('m1', cycles=20)
+        self.assertArrayEqual(cmd.get_coords('m1'), cmd.get_coords('ref'), 1e-3)
 
     def test_sculpt_purge(self):
         cmd.sculpt_purge
@@ -915,3 +992,56 @@ class TestEditing(testing.PyMOLTestCase):
         self.assertEqual(0, cmd.count_discrete('*'))
         self.assertEqual(2, cmd.count_states())
         self.assertEqual(10, cmd.count_atoms())
+
+    def test_atom_columns_round_trip(self):
+        import numpy
+
+        cmd.fragment('ala', 'm1')
+        cmd.fragment('gly', 'm2')
+        n = cmd.count_atoms('all')
+
+        cols = cmd.get_atom_columns('all', ['b', 'q', 'resv', 'formal_charge',
+                                            'color', 'reps', 'flags'])
+        self.assertEqual(cols['b'].dtype, numpy.float32)
+        self.assertEqual(cols['resv'].dtype, numpy.int32)
+        self.assertEqual(cols['formal_charge'].dtype, numpy.int8)
+        self.assertEqual(cols['flags'].dtype, numpy.uint32)
+        self.assertEqual(len(cols['b']), n)
+
+        # same values and order as iterate
+        stored = []
+        cmd.iterate('all', 'stored.append((b, resv, color))',
+                    space={'stored': stored})
+        self.assertEqual([tuple(v) for v in zip(cols['b'].tolist(),
+                                                cols['resv'].tolist(),
+                                                cols['color'].tolist())],
+                         stored)
+
+        b = numpy.arange(n, dtype=float) * 0.5
+        r = cmd.set_atom_columns('all', {'b': b, 'formal_charge': [1] * n})
+        self.assertEqual(r, n)
+        self.assertArrayEqual(cmd.get_atom_columns('all', 'b')['b'], b)
+        self.assertEqual(cmd.count_atoms('formal_charge = 1'), n)
+
+        # selection subset
+        k = cmd.count_atoms('m2')
+        cmd.set_atom_columns('m2', {'q': numpy.zeros(k)})
+        self.assertEqual(cmd.count_atoms('q = 0'), k)
+
+        # errors leave atoms unmodified
+        self.assertRaises(Exception, cmd.set_atom_columns, 'all',
+                          {'b': numpy.zeros(n), 'q': numpy.zeros(n + 1)})
+        self.assertRaises(Exception, cmd.get_atom_columns, 'all', 'name')
+        self.assertRaises(Exception, cmd.get_atom_columns, 'all', 'nosuch')
+        self.assertArrayEqual(cmd.get_atom_columns('all', 'b')['b'], b)
+
+    def test_set_atom_columns_selection_cache(self):
+        cmd.set('selection_cache_size', 32)
+        cmd.load(self.datafile('1oky.pdb.gz'), 'm1')
+        n_resi = cmd.count_atoms('resi 100')
+        self.assertTrue(n_resi > 0)
+        self.assertEqual(cmd.count_atoms('resi 100'), n_resi)
+        cols = cmd.get_atom_columns('resi 100', 'resv')
+        cmd.set_atom_columns('resi 100', {'resv': cols['resv'] + 1000})
+        self.assertEqual(cmd.count_atoms('resi 100'), 0)
+        self.assertEqual(cmd.count_atoms('resi 1100'), n_resi)
@@ -348,6 +348,38 @@ class TestExporting(testing.PyMOLTestCase):
             m2 = cmd.get_model()
             self.assertModelsAreSame(m1, m2)
 
+    @testing.foreach(0, 1)
+    def testSavePsc(self, psc_compression):
+        cmd.set('psc_compression', psc_compression)
+        cmd.load(self.datafile('1oky.pdb.gz'), 'm1')
+        for i in range(2, 5):
+            cmd.create('m%d' % i, 'm1')
+        cmd.select('s1', 'm1 & chain A')
+        cmd.show_as('cartoon')
+        cmd.color('red', 'm2 & name CA')
+        cmd.turn('x', 30)
+        view = cmd.get_view()
+
+        with testing.mktemp('.psc') as filename:
+            cmd.save(filename)
+            cmd.delete('*')
+            cmd.load(filename)
+
+            self.assertEqual(cmd.get('session_file'), filename)
+            self.assertEqual(cmd.get_names('all'), ['m1', 'm2', 'm3', 'm4', 's1'])
+            self.assertEqual(cmd.count_atoms('s1'), cmd.count_atoms('m1 & chain A'))
+            self.assertEqual(cmd.count_atoms('m2 & color red'), cmd.count_atoms('m2 & name CA'))
+            self.assertArrayEqual(cmd.get_coords('m4'), cmd.get_coords('m1'))
+            self.assertArrayEqual(cmd.get_view(), view, delta=1e-4)
+
+            self.assertEqual(cmd.get_psc_names(filename), ['m1', 'm2', 'm3', 'm4'])
+
+            # selective restore
+            cmd.delete('*')
+            cmd.load(filename, 'm2 m4')
+            self.assertEqual(cmd.get_names(), ['m2', 'm4'])
+            self.assertEqual(cmd.count_atoms('m2'), cmd.count_atoms('m4'))
+
     @testing.requires_version('2.1')
     def testMMTF(self):
         '''Styled MMTF export/import'''
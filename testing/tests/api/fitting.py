@@ -47,6 +47,44 @@ class TestFitting(testing.PyMOLTestCase):
         rms_list = cmd.intra_rms_cur("m1")
         self.assertArrayEqual(rms_list, [-1.0, 0.0])
 
+    def testIntraFitStreamed(self):
+        # states of a streamed trajectory which are not resident get
+        # decoded, fitted states are kept
+        pdbfile = self.datafile('sampletrajectory.pdb')
+        trjfile = self.datafile('sampletrajectory.dcd')
+        for name, cache in [('m1', 0), ('m2', 2)]:
+            cmd.set('traj_stream_cache', cache)
+            cmd.load(pdbfile, name)
+            cmd.load_traj(trjfile, name, state=1, max=6)
+        self.assertEqual(cmd.count_states('m2'), 6)
+        self.assertArrayEqual(cmd.intra_rms('m2'), cmd.intra_rms('m1'),
+                              delta=1e-3)
+        self.assertArrayEqual(cmd.intra_fit('m2'), cmd.intra_fit('m1'),
+                              delta=1e-3)
+        for state in range(1, 7):
+            cmd.frame(state)
+            cmd.refresh()
+        for state in range(1, 7):
+            self.assertEqual(cmd.count_atoms('m2', state=state),
+                             cmd.count_atoms('m1', state=state))
+            self.assertArrayEqual(cmd.get_coords('m2', state),
+                                  cmd.get_coords('m1', state), delta=1e-3)
+
+    def testSmoothStreamed(self):
+        pdbfile = self.datafile('sampletrajectory.pdb')
+        trjfile = self.datafile('sampletrajectory.dcd')
+        for name, cache in [('m1', 0), ('m2', 2)]:
+            cmd.set('traj_stream_cache', cache)
+            cmd.load(pdbfile, name)
+            cmd.load_traj(trjfile, name, state=1, max=6)
+            cmd.smooth(name)
+        for state in range(1, 7):
+            cmd.frame(state)
+            cmd.refresh()
+        for state in range(1, 7):
+            self.assertArrayEqual(cmd.get_coords('m2', state),
+                                  cmd.get_coords('m1', state), delta=1e-3)
+
     def testIntraRms(self):
         # see intra_fit
         pass
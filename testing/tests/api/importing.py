@@ -234,6 +234,79 @@ class TestImporting(testing.PyMOLTestCase):
             extent = cmd.get_extent('map1')
             self.assertArrayEqual(extent, [[0.0, 0.0, 0.0], [2296.0, 1476.0, 4592.0]], delta=1e-2)
 
+    @testing.foreach(True, False)
+    @testing.requires_version('1.7.3.0')
+    def testLoad_ccp4_file_same_as_string(self, normalize):
+        import numpy
+        import shutil
+        with open(self.datafile('emd_1155.ccp4'), 'rb') as handle:
+            content = handle.read()
+        original = bytearray(content)
+
+        with testing.mktemp('.ccp4') as filename:
+            shutil.copyfile(self.datafile('emd_1155.ccp4'), filename)
+
+            cmd.set('normalize_ccp4_maps', normalize)
+            cmd.load(filename, 'map1') # mapped, decoded on demand
+            cmd.load_raw(content, 'ccp4', 'map2')
+
+            # contouring a region only decodes the bricks around it
+            center = numpy.mean(cmd.get_extent('map2'), axis=0).tolist()
+            cmd.pseudoatom('p1', pos=center)
+            mean, stdev = cmd.get_volume_histogram('map2', 0)[2:4]
+            level = mean + stdev
+            cmd.isomesh('mesh1', 'map1', level, 'p1', carve=40)
+            cmd.isomesh('mesh2', 'map2', level, 'p1', carve=40)
+            self.assertArrayEqual(cmd.get_extent('mesh1'),
+                                  cmd.get_extent('mesh2'), delta=1e-4)
+
+            # decoding the rest updates the bricks of the new blocks only
+            for l in [level, mean + 3 * stdev]:
+                cmd.isomesh('mesh3', 'map1', l)
+                cmd.isomesh('mesh4', 'map2', l)
+                self.assertArrayEqual(cmd.get_extent('mesh3'),
+                                      cmd.get_extent('mesh4'), delta=1e-4)
+
+            field1 = cmd.get_volume_field('map1')
+            field2 = cmd.get_volume_field('map2')
+            self.assertEqual(field1.shape, field2.shape)
+            self.assertTrue(numpy.allclose(field1, field2))
+            self.assertArrayEqual(cmd.get_extent('map1'),
+                                  cmd.get_extent('map2'), delta=1e-4)
+
+            cmd.delete('map1')
+
+        # the input buffer must not be modified (byte swapping)
+        self.assertEqual(bytes(original), content)
+
+        self.assertRaises(Exception, cmd.load, filename + '.nosuch', 'map3',
+                          format='ccp4')
+
+    @testing.foreach(0o644, 0o444)
+    @testing.requires_version('1.7.3.0')
+    def testLoad_ccp4_file_truncated(self, mode):
+        import numpy
+        import shutil
+        with testing.mktemp('.ccp4') as filename:
+            shutil.copyfile(self.datafile('emd_1155.ccp4'), filename)
+            os.chmod(filename, mode)
+            cmd.load(filename, 'map1')
+            cmd.load(self.datafile('emd_1155.ccp4'), 'map2')
+
+            # overwritten in place while loaded, e.g. by a refinement program
+            os.chmod(filename, 0o644)
+            with open(filename, 'r+b') as handle:
+                handle.truncate(2048)
+
+            # no SIGBUS, files are mapped regardless of permissions and the
+            # voxels which weren't decoded yet are NaN
+            cmd.isomesh('mesh1', 'map1', 1.0)
+            field1 = cmd.get_volume_field('map1')
+            field2 = cmd.get_volume_field('map2')
+            self.assertEqual(field1.shape, field2.shape)
+            self.assertTrue(numpy.isnan(field1).any())
+            cmd.delete('map1')
+
     @testing.requires_version('1.7.3.0')
     def testLoad_cube(self):
         cmd.load(self.datafile('h2o-elf.cube'))
@@ -374,6 +447,85 @@ class TestImporting(testing.PyMOLTestCase):
         cmd.load_traj(base + ".xtc", selection="backbone", state=0)
         self.assertEqual(55, cmd.count_atoms('state 10'))
 
+    @testing.foreach('.dcd', '.xtc')
+    def testLoadTraj_stream(self, trjext):
+        # states are decoded on demand, with traj_stream_cache
+        pdbfile = self.datafile('sampletrajectory.pdb')
+        trjfile = self.datafile('sampletrajectory' + trjext)
+
+        cmd.load(pdbfile, 'm1')
+        cmd.load_traj(trjfile, 'm1', state=1, interval=2, max=4)
+
+        cmd.set('traj_stream_cache', 2)
+        cmd.load(pdbfile, 'm2')
+        cmd.load_traj(trjfile, 'm2', state=1, interval=2, max=4)
+
+        self.assertEqual(cmd.count_states('m1'), cmd.count_states('m2'))
+
+        # random access, going backwards reopens the file
+        for state in [3, 1, 4, 2, 4, 1]:
+            self.assertArrayEqual(
+                cmd.get_coords('m1', state),
+                cmd.get_coords('m2', state), delta=1e-4)
+
+        # modified states are kept
+        cmd.alter_state(2, 'm2', 'x = 123.0')
+        for state in [1, 3, 4, 1, 3, 4]:
+            cmd.frame(state)
+            cmd.refresh()
+        self.assertEqual(cmd.get_coords('m2 and index 1', 2)[0][0], 123.0)
+
+    def testLoadTraj_stream_consumers(self):
+        # every state consumer must see the non-resident states
+        pdbfile = self.datafile('sampletrajectory.pdb')
+        trjfile = self.datafile('sampletrajectory.dcd')
+        for name, cache in [('m1', 0), ('m2', 2)]:
+            cmd.set('traj_stream_cache', cache)
+            cmd.load(pdbfile, name)
+            cmd.load_traj(trjfile, name, state=1)
+        n_states = cmd.count_states('m1')
+        self.assertEqual(n_states, 10)
+        self.assertEqual(cmd.count_states('m2'), n_states)
+
+        cmd.create('c1', 'm1', 0, 0)
+        cmd.create('c2', 'm2', 0, 0)
+        self.assertEqual(cmd.count_states('c2'), n_states)
+        for state in range(1, n_states + 1):
+            self.assertArrayEqual(cmd.get_coords('c2', state),
+                                  cmd.get_coords('c1', state), delta=1e-4)
+
+        self.assertArrayEqual(cmd.get_coords('m2', 0),
+                              cmd.get_coords('m1', 0), delta=1e-4)
+        self.assertArrayEqual(cmd.get_extent('m2', 0),
+                              cmd.get_extent('m1', 0), delta=1e-4)
+
+        xyz = {'m1': [], 'm2': []}
+        cmd.iterate_state(0, 'm1 or m2', 'xyz[model].append((x, y, z))',
+                          space={'xyz': xyz})
+        self.assertEqual(len(xyz['m2']), len(xyz['m1']))
+        self.assertArrayEqual(xyz['m2'], xyz['m1'], delta=1e-4)
+
+    def testLoadTraj_edit_shared_indices(self):
+        # states share their atom index maps until an edit splits them
+        cmd.load(self.datafile('sampletrajectory.pdb'), 'm1')
+        cmd.load_traj(self.datafile('sampletrajectory.dcd'), 'm1', state=1)
+        n_states = cmd.count_states('m1')
+        self.assertTrue(n_states > 1)
+
+        coords = [cmd.get_coords('m1 and not hydro', s)
+                  for s in range(1, n_states + 1)]
+
+        cmd.remove('hydro')
+        cmd.h_add('m1 and elem N')
+        cmd.alter('resi 2', 'resi = "200"')
+        cmd.sort('m1')
+        cmd.remove('hydro')
+
+        for s in range(1, n_states + 1):
+            self.assertArrayEqual(
+                sorted(map(tuple, cmd.get_coords('m1', s))),
+                sorted(map(tuple, coords[s - 1])), delta=1e-4)
+
     @testing.requires_version('1.8.5')
     def testLoadCharmmCor(self):
         # http://www.ks.uiuc.edu/Research/vmd/plugins/molfile/corplugin.html
@@ -434,6 +586,34 @@ class TestImporting(testing.PyMOLTestCase):
         cmd.read_molstr(molstr, 'm1')
         self.assertEqual(7, cmd.count_atoms())
 
+    def testLoad_pdb_threads(self):
+        # multi-MODEL file, records of all models are parsed up front
+        cmd.load(self.datafile('1aon.pdb.gz'), 'm1')
+        for state in (2, 3):
+            cmd.create('m1', 'm1', 1, state)
+            cmd.translate([state, 0, 0], 'm1', state=state, camera=0)
+
+        models = []
+        with testing.mktemp('.pdb') as filename:
+            cmd.save(filename, 'm1', state=0)
+            cmd.delete('*')
+
+            for n_threads in (1, 4):
+                cmd.set('max_threads', n_threads)
+                cmd.load(filename, 'm1')
+                self.assertEqual(cmd.count_states('m1'), 3)
+                models.append((
+                    [cmd.get_coords('m1', state) for state in (1, 2, 3)],
+                    [(a.chain, a.segi, a.resn, a.resi, a.name, a.alt,
+                      a.symbol, a.id, a.hetatm, a.b, a.q)
+                     for a in cmd.get_model('m1').atom],
+                ))
+                cmd.delete('m1')
+
+        for (coords0, coords1) in zip(models[0][0], models[1][0]):
+            self.assertArrayEqual(coords0, coords1, delta=1e-4)
+        self.assertEqual(models[0][1], models[1][1])
+
     def testReadPdbstr(self):
         cmd.read_pdbstr(pdbstr, 'm1')
         self.assertEqual(7, cmd.count_atoms())
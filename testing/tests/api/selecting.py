@@ -1,4 +1,5 @@
 
+import pymol
 from pymol import cmd, testing, stored
 
 class TestSelecting(testing.PyMOLTestCase):
@@ -13,6 +14,53 @@ class TestSelecting(testing.PyMOLTestCase):
             return
         self.fail("did not raise")
 
+    def test_errors_of_skipped_operands(self):
+        # operands which are not needed for the result must still be
+        # checked, "none and ..." skips the evaluation of the right side
+        cmd.fragment('ala', 'm1')
+        for sele in [
+                'none and no_such_name',
+                'none and model no_such_model',
+                'none and state 0',
+                'none and b > abc',
+                'none and x abc 1.0',
+                'none and (m1 within abc of m1)',
+                'none and (m1 extend abc)',
+                'none or (none and no_such_name)',
+        ]:
+            self.assertRaises(pymol.CmdException, cmd.count_atoms, sele)
+        self.assertEqual(cmd.count_atoms('none and ?no_such_name'), 0)
+        self.assertEqual(cmd.count_atoms('none and m1*'), 0)
+
+    def test_operand_order(self):
+        # compiled expressions reorder AND operands and may run in
+        # parallel, the result must not change
+        cmd.load(self.datafile('1aon.pdb.gz'), 'm1')
+        expressions = [
+            'polymer and not hydro',
+            'name CA and resn ALA+GLY and chain A',
+            '(resi 10-50 and byres (organic around 5)) or none',
+            'elem C and not (resn LYS or resn ARG) and b > 20',
+            'not (name N+C+O+CA) and segi ""',
+        ]
+        counts = {}
+        for n_threads in (1, 4):
+            cmd.set('max_threads', n_threads)
+            for expr in expressions:
+                counts.setdefault(expr, set()).add(cmd.count_atoms(expr))
+
+        for expr, values in counts.items():
+            self.assertEqual(len(values), 1, expr)
+
+        self.assertEqual(
+            cmd.count_atoms('(name CA around 3) and resn ALA and chain A'),
+            cmd.count_atoms('chain A and resn ALA and (name CA around 3)'))
+        self.assertEqual(cmd.count_atoms('none and (name CA around 3)'), 0)
+        self.assertEqual(cmd.count_atoms('chain B and not chain B'), 0)
+        self.assertEqual(cmd.count_atoms('resn HOH and none'), 0)
+        self.assertEqual(cmd.count_atoms('none or resn ALA or none'),
+                         cmd.count_atoms('resn ALA'))
+
     def testDeselect(self):
         cmd.load(self.datafile("1oky.pdb.gz"), "m1")
         cmd.select("all")
@@ -387,3 +435,123 @@ class TestSelecting(testing.PyMOLTestCase):
     @testing.requires_version('2.5')
     def _test_no_implicit_dummy_selection(self):
         self.assertEqual(cmd.count_atoms('(p1 around 1.5) around 1.5'), 0)
+
+    def test_selection_cache_hits(self):
+        cmd.fragment('gly', 'm1')
+        cmd.fragment('ala', 'm2')
+        cmd.select('s1', 'm1')
+        expr = 'elem C and not s1'
+
+        hits, misses, _ = cmd.get_selection_cache_stats()
+        self.assertEqual(cmd.iterate(expr, 'pass'), 3)
+        self.assertEqual(cmd.iterate(expr, 'pass'), 3)
+        hits2, misses2, size = cmd.get_selection_cache_stats()
+        self.assertEqual(hits2 - hits, 1)
+        self.assertEqual(misses2 - misses, 1)
+        self.assertTrue(size >= 1)
+
+        # atom properties
+        cmd.alter('m2 and name CB', 'elem = "N"')
+        self.assertEqual(cmd.iterate(expr, 'pass'), 2)
+
+        # read-only iteration keeps the entry
+        hits, _, _ = cmd.get_selection_cache_stats()
+        cmd.iterate('all', 'pass')
+        self.assertEqual(cmd.iterate(expr, 'pass'), 2)
+        self.assertEqual(cmd.get_selection_cache_stats()[0] - hits, 1)
+
+        # named selections
+        cmd.select('s1', 'none')
+        self.assertEqual(cmd.iterate(expr, 'pass'), 4)
+
+        # coordinates
+        expr = 'm1 within 3 of m2'
+        cmd.alter_state(1, 'm1', '(x, y, z) = (0.0, 0.0, 0.0)')
+        cmd.alter_state(1, 'm2', '(x, y, z) = (100.0, 0.0, 0.0)')
+        self.assertEqual(cmd.iterate(expr, 'pass'), 0)
+        cmd.alter_state(1, 'm2', '(x, y, z) = (1.0, 0.0, 0.0)')
+        self.assertEqual(cmd.iterate(expr, 'pass'), cmd.iterate('m1', 'pass'))
+
+        # disabled cache
+        cmd.set('selection_cache_size', 0)
+        self.assertEqual(cmd.iterate(expr, 'pass'), cmd.iterate('m1', 'pass'))
+        self.assertEqual(cmd.get_selection_cache_stats()[2], 0)
+
+    def test_selection_cache_dss(self):
+        # dss writes secondary structure and only invalidates the
+        # representations, the cached result must still be dropped
+        cmd.load(self.datafile('1oky.pdb.gz'), 'm1')
+        cmd.alter('all', 'ss = "L"')
+        self.assertEqual(cmd.iterate('ss H', 'pass'), 0)
+        self.assertEqual(cmd.iterate('ss H', 'pass'), 0)
+        cmd.dss()
+        n_helix = cmd.iterate('ss H', 'pass')
+        self.assertTrue(n_helix > 0)
+        self.assertEqual(cmd.iterate('ss H', 'pass'), n_helix)
+
+    def test_selection_cache_object_settings(self):
+        # atom_name_wildcard can be set per object
+        cmd.fragment('ala', 'm1')
+        cmd.alter('m1 and name CA', 'name = "C*"')
+        self.assertEqual(cmd.iterate('name C*', 'pass'), 3)
+        self.assertEqual(cmd.iterate('name C*', 'pass'), 3)
+        cmd.set('atom_name_wildcard', '#', 'm1')
+        self.assertEqual(cmd.iterate('name C*', 'pass'), 1)
+        cmd.unset('atom_name_wildcard', 'm1')
+        self.assertEqual(cmd.iterate('name C*', 'pass'), 3)
+
+    def test_keywords_follow_alter(self):
+        # cached hydro and fixed results must not outlive the atom changes
+        cmd.fragment('ala', 'm1')
+        n_hydro = cmd.iterate('hydro', 'pass')
+        self.assertEqual(n_hydro, 5)
+
+        cmd.alter('m1 and name H', 'elem = "C"')
+        self.assertEqual(cmd.iterate('hydro', 'pass'), n_hydro - 1)
+
+        self.assertEqual(cmd.iterate('fixed', 'pass'), 0)
+        cmd.flag('fix', 'name CA', 'set')
+        self.assertEqual(cmd.iterate('fixed', 'pass'), 1)
+        cmd.flag('fix', 'all', 'clear')
+        self.assertEqual(cmd.iterate('fixed', 'pass'), 0)
+
+    def test_keywords_follow_writes(self):
+        # same for writes that only invalidate the representations
+        cmd.fragment('ala', 'm1')
+        n_hydro = cmd.iterate('hydro', 'pass')
+        self.assertEqual(cmd.iterate('fixed', 'pass'), 0)
+        n_carbon = cmd.iterate('elem C', 'pass')
+        cmd.set_atom_columns('elem C', {'protons': [1] * n_carbon})
+        self.assertEqual(cmd.iterate('hydro', 'pass'), n_hydro + n_carbon)
+        cols = cmd.get_atom_columns('name CA', 'flags')
+        cmd.set_atom_columns('name CA', {'flags': cols['flags'] | 0x8})
+        self.assertEqual(cmd.iterate('fixed', 'pass'), 1)
+
+    def test_many_named_selections(self):
+        # with many selections, membership is answered from bitmaps, which
+        # must follow members inserted after they were built
+        cmd.set('selection_cache_size', 0)
+        cmd.load(self.datafile('1oky.pdb.gz'), 'm1')
+        ranges = [(100 + i * 5, 120 + i * 5) for i in range(20)]
+        for i, (first, last) in enumerate(ranges):
+            cmd.select('s%d' % i, 'resi %d-%d' % (first, last))
+            self.assertEqual(cmd.count_atoms('s0'),
+                             cmd.count_atoms('resi 100-120'))
+        for i, (first, last) in enumerate(ranges):
+            n = cmd.count_atoms('resi %d-%d' % (first, last))
+            self.assertEqual(cmd.count_atoms('s%d' % i), n)
+            self.assertEqual(cmd.iterate('s%d' % i, 'pass'), n)
+        self.assertEqual(cmd.count_atoms('s1 and s3 and s4'),
+                         cmd.count_atoms('resi 120-125'))
+        self.assertEqual(cmd.count_atoms('s1 or s8 or s9'),
+                         cmd.count_atoms('resi 105-125+140-165'))
+        self.assertEqual(cmd.count_atoms('s1*'),
+                         cmd.count_atoms('resi 105-125+150-215'))
+
+        # bitmaps must follow deletion and renaming
+        cmd.delete('s3')
+        cmd.set_name('s4', 's3')
+        self.assertEqual(cmd.count_atoms('s3'), cmd.count_atoms('resi 120-140'))
+        self.assertEqual(cmd.count_atoms('s3 and s2'),
+                         cmd.count_atoms('resi 120-130'))
+        self.assertEqual(cmd.count_atoms('s*'), cmd.count_atoms('resi 100-215'))
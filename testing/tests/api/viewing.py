@@ -168,6 +168,43 @@ class TestViewing(testing.PyMOLTestCase):
         # see testEnable
         pass
 
+    def testEnable_names_index(self):
+        # object names are indexed, wildcards, partial names, rename and
+        # delete must give the same matches as a linear scan
+        def enabled(pattern):
+            cmd.disable('all')
+            cmd.enable(pattern)
+            return cmd.get_names('objects', 1)
+
+        cmd.fragment('gly', 'pose_0')
+        for i in range(1, 20):
+            cmd.create('pose_%d' % i, 'pose_0')
+        cmd.fragment('ala', 'Lig')
+        cmd.set('ignore_case', 0)
+
+        self.assertEqual(enabled('pose_1*'),
+                ['pose_1'] + ['pose_%d' % i for i in range(10, 20)])
+        self.assertEqual(enabled('pose_3 pose_1,pose_2'),
+                ['pose_1', 'pose_2', 'pose_3'])
+
+        # unambiguous partial name
+        self.assertEqual(enabled('Li'), ['Lig'])
+        self.assertEqual(enabled('pose_1'), ['pose_1'])
+
+        # rename and delete keep the index consistent
+        cmd.set_name('Lig', 'ligand')
+        self.assertEqual(enabled('Lig*'), [])
+        self.assertEqual(enabled('lig*'), ['ligand'])
+        cmd.delete('pose_1*')
+        self.assertEqual(enabled('pose_1*'), [])
+        self.assertEqual(len(cmd.get_names('objects')), 10)
+
+        # case insensitive lookup
+        self.assertEqual(enabled('LIG*'), [])
+        cmd.set('ignore_case', 1)
+        self.assertEqual(enabled('LIG*'), ['ligand'])
+        self.assertEqual(enabled('LIGAND'), ['ligand'])
+
     def testToggle(self):
         if testing.PYMOL_VERSION[1] > 1.84:
             cmd.set('auto_show_classified', 0)
@@ -411,6 +448,99 @@ class TestViewing(testing.PyMOLTestCase):
         self.ambientOnly()
         self.assertImageEqual("viewing-ref/cartoon.png", delta=1)
 
+    @testing.foreach('automatic', 'putty', 'tube')
+    def testCartoonThreads(self, cartoon):
+        cmd.load(self.datafile('1aon.pdb.gz'), 'm1')
+        cmd.cartoon(cartoon)
+        cmd.set('cartoon_discrete_colors')
+        cmd.set('cartoon_transparency', 0.3, 'chain B')
+        cmd.hide('cartoon', 'chain C & resi 100-120')
+        cmd.color('0xff8000', 'chain D')
+        cmd.show_as('cartoon')
+
+        # one thread walks the whole path as a single chunk, more threads
+        # split it. Chunks are appended in order, so the result must not
+        # depend on the split.
+        geometry = []
+        for n_threads in (1, 2, 4):
+            cmd.set('max_threads', n_threads)
+            cmd.rebuild()
+            geometry.append(cmd.get_vrml())
+
+        self.assertEqual(geometry[0], geometry[1])
+        self.assertEqual(geometry[0], geometry[2])
+
+    @testing.requires('no_edu')
+    @testing.foreach.product([0, 2], [0, 1])
+    def testSurfaceThreads(self, surface_type, cavity_mode):
+        cmd.load(self.datafile('1rx1.pdb'), 'm1')
+        cmd.set('surface_type', surface_type)
+        cmd.set('surface_cavity_mode', cavity_mode)
+        cmd.show_as('surface')
+
+        # chunks are merged in order, so the result must not depend on
+        # the number of threads
+        geometry = []
+        for n_threads in (1, 4):
+            cmd.set('max_threads', n_threads)
+            cmd.rebuild()
+            geometry.append(cmd.get_vrml())
+
+        self.assertEqual(geometry[0], geometry[1])
+
+    @testing.requires('no_edu')
+    @testing.foreach.product([0, 2], [0, 1])
+    def testSurfaceIncremental(self, surface_type, cavity_mode):
+        cmd.set('auto_zoom', 0)
+        cmd.set('auto_color', 0)
+        cmd.set('surface_type', surface_type)
+        cmd.set('surface_cavity_mode', cavity_mode)
+
+        # a side chain moved after the first build only regenerates the
+        # points around it, and must give the surface built from scratch
+        # without surface_incremental, with the side chain already moved
+        vrml = []
+        for incremental in (1, 0):
+            cmd.delete('*')
+            cmd.set('surface_incremental', incremental)
+            cmd.load(self.datafile('1rx1.pdb'), 'm1')
+            cmd.zoom()
+            if not incremental:
+                cmd.alter_state(1, 'm1 & resi 40 & sidechain', 'x += 0.3')
+            cmd.show_as('surface')
+            cmd.draw()
+            if incremental:
+                cmd.alter_state(1, 'm1 & resi 40 & sidechain', 'x += 0.3')
+                cmd.rebuild()
+            vrml.append(cmd.get_vrml())
+
+        self.assertEqual(vrml[0], vrml[1])
+
+    @testing.requires('no_edu')
+    def testAsyncBuilds(self):
+        cmd.load(self.datafile('1oky.pdb.gz'), 'm1')
+        for state in (2, 3):
+            cmd.create('m1', 'm1', 1, state)
+            cmd.translate([state, 0, 0], 'm1', state=state, camera=0)
+        cmd.show_as('cartoon sticks spheres surface mesh dots labels', 'm1')
+        cmd.label('m1 and name CA', 'resn')
+        cmd.set('surface_incremental', 1)
+        cmd.set('mesh_carve_selection', 'm1 and resi 50-60')
+        cmd.set('max_threads', 4)
+
+        # serial builds and the task graph must give the same geometry
+        geometry = []
+        for async_builds in (0, 1):
+            cmd.set('async_builds', async_builds)
+            cmd.rebuild()
+            states = []
+            for state in (1, 2, 3):
+                cmd.frame(state)
+                states.append(cmd.get_povray())
+            geometry.append(states)
+
+        self.assertEqual(geometry[0], geometry[1])
+
     def testCapture(self):
         cmd.capture
         self.skipTest('TODO')
@@ -423,6 +553,29 @@ class TestViewing(testing.PyMOLTestCase):
         # tested in many other tests
         pass
 
+    @testing.requires('no_edu')
+    @testing.foreach.product([0, 1], [0, 1])
+    def testRayTraceAccel(self, orthoscopic, shadows):
+        # large assembly plus a distant copy of a few residues
+        cmd.load(self.datafile('1aon.pdb.gz'), 'm1')
+        cmd.create('m2', 'm1 & chain A & resi 1-20')
+        cmd.translate([400., 0., 0.], 'm2', camera=0)
+        cmd.show_as('cartoon', 'm1')
+        cmd.show_as('sticks', 'm2')
+        cmd.orient('m1')
+        cmd.set('ray_shadow', shadows)
+        cmd.set('ray_orthoscopic', orthoscopic)
+        cmd.viewport(200, 150)
+
+        cmd.set('ray_trace_accel', 0)
+        img_grid = self.get_imagearray(width=200, height=150, ray=1)
+
+        # intersection tests are the same, only the traversal differs
+        for accel in (1, 2):
+            cmd.set('ray_trace_accel', accel)
+            img_bvh = self.get_imagearray(width=200, height=150, ray=1)
+            self.assertImageEqual(img_grid, img_bvh, delta=1, count=20)
+
     def testRefresh(self):
         cmd.refresh
         self.skipTest('TODO')
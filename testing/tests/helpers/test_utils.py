@@ -1,3 +1,4 @@
+import struct
 import tempfile
 from PIL import Image
 import numpy
@@ -131,3 +132,92 @@ def requires_version(version, reason=None):
             reason=reason or f"Requires PyMOL {version}"
         )(test_func)
     return decorator
+
+
+def _msgpack_dumps(obj) -> bytes:
+    """
+    Minimal MessagePack encoder for dict, list, str, bytes, int, float.
+    """
+    if isinstance(obj, dict):
+        return b''.join([struct.pack('>BI', 0xdf, len(obj))] +
+                [_msgpack_dumps(k) + _msgpack_dumps(v) for (k, v) in obj.items()])
+    if isinstance(obj, list):
+        return b''.join([struct.pack('>BI', 0xdd, len(obj))] +
+                [_msgpack_dumps(v) for v in obj])
+    if isinstance(obj, str):
+        obj = obj.encode('utf-8')
+        return struct.pack('>BI', 0xdb, len(obj)) + obj
+    if isinstance(obj, bytes):
+        return struct.pack('>BI', 0xc6, len(obj)) + obj
+    if isinstance(obj, float):
+        return struct.pack('>Bd', 0xcb, obj)
+    return struct.pack('>Bq', 0xd3, obj)
+
+
+def _int32_array(values):
+    return {'kind': 'ByteArray', 'type': 3}, struct.pack('<%di' % len(values), *values)
+
+
+def _bcif_column(name, values) -> dict:
+    if isinstance(values[0], str):
+        strings = sorted(set(values))
+        index = {s: i for (i, s) in enumerate(strings)}
+        offsets = [0]
+        for s in strings:
+            offsets.append(offsets[-1] + len(s.encode('utf-8')))
+        offset_encoding, offset_data = _int32_array(offsets)
+        data_encoding, data = _int32_array([index[s] for s in values])
+        encoding = [{
+            'kind': 'StringArray',
+            'dataEncoding': [data_encoding],
+            'stringData': ''.join(strings),
+            'offsetEncoding': [offset_encoding],
+            'offsets': offset_data,
+        }]
+    elif isinstance(values[0], float):
+        byte_array, data = _int32_array([int(round(v * 1000)) for v in values])
+        encoding = [{'kind': 'FixedPoint', 'factor': 1000, 'srcType': 33},
+                    byte_array]
+    else:
+        deltas = [values[0]] + [b - a for (a, b) in zip(values, values[1:])]
+        byte_array, data = _int32_array(deltas)
+        encoding = [{'kind': 'Delta', 'origin': 0, 'srcType': 3}, byte_array]
+
+    return {'name': name, 'data': {'data': data, 'encoding': encoding}}
+
+
+def save_bcif(cmd, filename: str, selection: str) -> None:
+    """
+    Write the _atom_site category of state 1 as BinaryCIF.
+    :filename: output file
+    :selection: atoms to write
+    """
+    columns = {}
+    names = ['group_PDB', 'id', 'type_symbol', 'label_atom_id',
+             'label_comp_id', 'label_asym_id', 'label_seq_id',
+             'auth_seq_id', 'auth_asym_id', 'Cartn_x', 'Cartn_y', 'Cartn_z',
+             'occupancy', 'B_iso_or_equiv', 'pdbx_PDB_model_num']
+    for name in names:
+        columns[name] = []
+
+    def callback(type, ID, elem, name, resn, segi, resv, chain, x, y, z, q, b):
+        for key, value in zip(names, [type, ID,
+                elem, name, resn, segi, resv, resv, chain, x, y, z, q, b, 1]):
+            columns[key].append(value)
+
+    cmd.iterate_state(1, selection, 'callback(type, ID, elem, name, resn, '
+            'segi, resv, chain, x, y, z, q, b)', space={'callback': callback})
+
+    with open(filename, 'wb') as handle:
+        handle.write(_msgpack_dumps({
+            'version': '0.3.0',
+            'encoder': 'test_utils.py',
+            'dataBlocks': [{
+                'header': 'TEST',
+                'categories': [{
+                    'name': '_atom_site',
+                    'rowCount': len(columns['id']),
+                    'columns': [_bcif_column(name, columns[name]) for name in names],
+                }],
+            }],
+        }))
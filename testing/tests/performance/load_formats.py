@@ -0,0 +1,30 @@
+'''
+Loading a large structure from different file formats with one or several
+threads (max_threads)
+'''
+
+from pymol import cmd, testing, test_utils
+
+# session formats replace the session, they are loaded without a name
+SESSIONS = ('pse', 'psc')
+
+class TestLoadFormats(testing.PyMOLTestCase):
+
+    @testing.foreach.product(['pdb', 'cif', 'bcif', 'pse', 'psc'], [1, 4])
+    def testTiming(self, fmt, n_threads):
+        cmd.load(self.datafile('1aon.pdb.gz'), 'm1')
+
+        with testing.mktemp('.' + fmt) as filename:
+            if fmt == 'bcif':
+                test_utils.save_bcif(cmd, filename, 'm1')
+            else:
+                cmd.save(filename, 'm1')
+            cmd.delete('*')
+            cmd.set('max_threads', n_threads)
+
+            with self.timing('%s, %d threads' % (fmt, n_threads)):
+                for i in range(5):
+                    if fmt in SESSIONS:
+                        cmd.load(filename)
+                    else:
+                        cmd.load(filename, 'm%d' % i)
@@ -0,0 +1,18 @@
+'''
+Memory mapped CCP4/MRC map loading, decoded on demand
+'''
+
+from pymol import cmd, testing
+
+class TestMapCCP4(testing.PyMOLTestCase):
+
+    @testing.foreach(True, False)
+    def testTiming(self, normalize):
+        # normalizing needs a pass over the whole file for mean and stdev
+        cmd.set('normalize_ccp4_maps', normalize)
+        cmd.pseudoatom('p1', pos=[1148., 738., 2296.])
+
+        with self.timing('normalize %d' % normalize):
+            for i in range(5):
+                cmd.load(self.datafile('emd_1155.ccp4'), 'map%d' % i)
+                cmd.isomesh('mesh%d' % i, 'map%d' % i, 1.0, 'p1', carve=20)
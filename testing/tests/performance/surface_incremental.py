@@ -0,0 +1,24 @@
+'''
+Incremental surface updates after coordinate changes (surface_incremental)
+'''
+
+from pymol import cmd, testing
+
+@testing.requires('no_edu')
+class TestSurfaceIncremental(testing.PyMOLTestCase):
+
+    def _move_side_chain(self):
+        cmd.alter_state(1, 'm1 & chain A & resi 40 & sidechain', 'x += 0.3')
+        cmd.rebuild()
+        cmd.draw()
+
+    @testing.foreach(0, 1)
+    def testTiming(self, incremental):
+        cmd.load(self.datafile('1aon.pdb.gz'), 'm1')
+        cmd.set('surface_incremental', incremental)
+        cmd.show_as('surface')
+        cmd.draw()
+
+        with self.timing('incremental=%d' % incremental):
+            for _ in range(3):
+                self._move_side_chain()